@@ -185,6 +185,7 @@ void BasicCommands::ls(const std::vector<std::string>& params)
   std::set<std::string> hidden_signals;
   hidden_signals.insert("create_component");
   hidden_signals.insert("list_tree");
+  hidden_signals.insert("list_tree_since");
   hidden_signals.insert("list_properties");
   hidden_signals.insert("list_signals");
   hidden_signals.insert("configure");
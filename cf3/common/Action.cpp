@@ -14,6 +14,7 @@
 #include "common/FindComponents.hpp"
 
 #include "common/LibCommon.hpp"
+#include "common/Tracer.hpp"
 
 namespace cf3 {
 namespace common {
@@ -42,11 +43,20 @@ Action& Action::create_action(const std::string& action_provider,
 }
 
 
-void Action::signal_execute ( common::SignalArgs& node )
+void Action::traced_execute()
 {
+#ifndef CF3_ENABLE_COMPONENT_TIMING
+  TraceScope trace(*this, m_trace_name);
+#endif
   this->execute();
 }
 
+
+void Action::signal_execute ( common::SignalArgs& node )
+{
+  traced_execute();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 } // common
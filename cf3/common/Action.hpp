@@ -9,6 +9,7 @@
 
 #include "common/Component.hpp"
 #include "common/IAction.hpp"
+#include "common/Tracer.hpp"
 
 /////////////////////////////////////////////////////////////////////////////////////
 
@@ -36,6 +37,10 @@ public: // functions
   /// @deprecated should use create_component()
   virtual Action& create_action(const std::string& action_provider, const std::string& name);
 
+  /// Execute the action, recording it in the Tracer if tracing is enabled. Timed actions
+  /// already trace themselves, so this is the same as execute() if component timing is enabled
+  void traced_execute();
+
   /// @name SIGNALS
   //@{
 
@@ -44,6 +49,11 @@ public: // functions
 
   //@} END SIGNALS
 
+private:
+
+  /// Cached tracer name of the action
+  TraceName m_trace_name;
+
 };
 
 /////////////////////////////////////////////////////////////////////////////////////
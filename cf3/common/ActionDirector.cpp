@@ -48,7 +48,7 @@ void ActionDirector::execute()
     if(!disabled)
     {
       CFdebug << name() << ": Executing action " << action->uri().path() << CFendl;
-      action->execute();
+      action->traced_execute();
     }
     else
     {
@@ -4,6 +4,8 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/max.hpp>
 #include <boost/accumulators/statistics/mean.hpp>
@@ -13,8 +15,12 @@
 
 #include "common/AllocatedComponent.hpp"
 #include "common/Action.hpp"
+#include "common/MemoryComponent.hpp"
+#include "common/OSystem.hpp"
+#include "common/OSystemLayer.hpp"
 #include "common/PropertyList.hpp"
 #include "common/Timer.hpp"
+#include "common/Tracer.hpp"
 
 namespace cf3 {
 namespace common {
@@ -25,7 +31,13 @@ namespace common {
 
 struct TimedActionImpl::Implementation
 {
-  Implementation(Action& timed_action) : m_timed_component(timed_action)
+  Implementation(Action& timed_action) :
+    m_timed_component(timed_action),
+    m_traced(false),
+    m_sampled(false),
+    m_memory_before(0.),
+    m_memory_maximum(0.),
+    m_memory_increase(0.)
   {
     m_timed_component.properties().add("timer_count", Uint(0));
     m_timed_component.properties().add("timer_minimum", Real(0.));
@@ -50,6 +62,21 @@ struct TimedActionImpl::Implementation
   > m_timing_stats;
   
   Action& m_timed_component;
+
+  /// Cached tracer name of the action
+  TraceName m_trace_name;
+  /// True if the current execution is traced
+  bool m_traced;
+
+  /// True if the process memory is recorded for the current execution
+  bool m_sampled;
+  /// Process memory at the start of the current execution
+  Real m_memory_before;
+  /// Largest resident memory of the process sampled after an execution. This is not the peak of the process,
+  /// which may be reached and released during an execution
+  Real m_memory_maximum;
+  /// Largest increase of the resident memory between the start and the end of an execution
+  Real m_memory_increase;
 };
   
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -65,12 +92,29 @@ TimedActionImpl::~TimedActionImpl()
 
 void TimedActionImpl::start_timing()
 {
+  Tracer& tracer = Tracer::instance();
+  m_implementation->m_traced = tracer.enabled();
+  if(m_implementation->m_traced)
+  {
+    tracer.record(tracer.component_name(m_implementation->m_timed_component, m_implementation->m_trace_name), Tracer::BEGIN);
+  }
+  m_implementation->m_sampled = memory_sampling();
+  if(m_implementation->m_sampled)
+    m_implementation->m_memory_before = OSystem::instance().layer()->resident_memory();
   m_implementation->m_timer.restart();
 }
 
 void TimedActionImpl::stop_timing()
 {
   m_implementation->m_timing_stats(m_implementation->m_timer.elapsed());
+  if(m_implementation->m_traced)
+    Tracer::instance().record(m_implementation->m_trace_name.name - 1, Tracer::END);
+  if(m_implementation->m_sampled)
+  {
+    const Real memory_after = OSystem::instance().layer()->resident_memory();
+    m_implementation->m_memory_maximum = std::max(m_implementation->m_memory_maximum, memory_after);
+    m_implementation->m_memory_increase = std::max(m_implementation->m_memory_increase, memory_after - m_implementation->m_memory_before);
+  }
 }
 
 void TimedActionImpl::store_timings()
@@ -80,6 +124,11 @@ void TimedActionImpl::store_timings()
   m_implementation->m_timed_component.properties().set("timer_mean", boost::accumulators::mean(m_implementation->m_timing_stats));
   m_implementation->m_timed_component.properties().set("timer_maximum", boost::accumulators::max(m_implementation->m_timing_stats));
   m_implementation->m_timed_component.properties().set("timer_variance", boost::accumulators::lazy_variance(m_implementation->m_timing_stats));
+  if(m_implementation->m_memory_maximum > 0.)
+  {
+    m_implementation->m_timed_component.properties()["sampled_memory_maximum"] = m_implementation->m_memory_maximum;
+    m_implementation->m_timed_component.properties()["sampled_memory_increase"] = m_implementation->m_memory_increase;
+  }
 }
 
 #endif
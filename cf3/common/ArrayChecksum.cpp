@@ -0,0 +1,223 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#include "common/ArrayChecksum.hpp"
+#include "common/BasicExceptions.hpp"
+#include "common/ThreadPool.hpp"
+
+namespace cf3 {
+namespace common {
+
+namespace detail
+{
+
+// Primes used by the xxHash64 algorithm
+const ChecksumT prime1 = UINT64_C(0x9E3779B185EBCA87);
+const ChecksumT prime2 = UINT64_C(0xC2B2AE3D27D4EB4F);
+const ChecksumT prime3 = UINT64_C(0x165667B19E3779F9);
+const ChecksumT prime4 = UINT64_C(0x85EBCA77C2B2AE63);
+const ChecksumT prime5 = UINT64_C(0x27D4EB2F165667C5);
+
+inline ChecksumT rotate_left(const ChecksumT x, const int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+/// Add a 64 bit word to the hash state, using the xxHash64 mixing steps
+inline ChecksumT mix(const ChecksumT hash, ChecksumT word)
+{
+  word *= prime2;
+  word = rotate_left(word, 31);
+  word *= prime1;
+  return rotate_left(hash ^ word, 27) * prime1 + prime4;
+}
+
+/// Final avalanche, so every input bit affects all output bits
+inline ChecksumT finalize(ChecksumT hash)
+{
+  hash ^= hash >> 33;
+  hash *= prime2;
+  hash ^= hash >> 29;
+  hash *= prime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+/// Number of low order mantissa bits that can be dropped so quantised values are less than max_ulps apart
+inline Uint dropped_bits(const Uint max_ulps, const Uint mantissa_bits)
+{
+  Uint result = 0;
+  while(result < mantissa_bits && (static_cast<ChecksumT>(2) << result) <= max_ulps)
+    ++result;
+  return result;
+}
+
+/// Conversion of a value to the 64 bit word that is hashed
+template<typename T>
+struct ChecksumWord
+{
+  ChecksumWord(const Uint, const Real) {}
+
+  ChecksumT operator()(const T value) const
+  {
+    return static_cast<ChecksumT>(value);
+  }
+};
+
+template<>
+struct ChecksumWord<int>
+{
+  ChecksumWord(const Uint, const Real) {}
+
+  ChecksumT operator()(const int value) const
+  {
+    return static_cast<ChecksumT>(static_cast<boost::uint32_t>(value));
+  }
+};
+
+template<>
+struct ChecksumWord<bool>
+{
+  ChecksumWord(const Uint, const Real) {}
+
+  ChecksumT operator()(const bool value) const
+  {
+    return value ? 1 : 0;
+  }
+};
+
+/// Floating point values are rounded to a multiple of 2^dropped ulps, using the bit pattern as an integer
+template<typename T, typename BitsT, Uint MantissaBits>
+struct FloatChecksumWord
+{
+  FloatChecksumWord(const Uint max_ulps, const Real zero_threshold) :
+    m_dropped(dropped_bits(max_ulps, MantissaBits)),
+    m_half(m_dropped == 0 ? 0 : static_cast<BitsT>(1) << (m_dropped-1)),
+    m_zero_threshold(zero_threshold)
+  {
+  }
+
+  ChecksumT operator()(const T value) const
+  {
+    // Both signs of zero and all values below the threshold are the same
+    if(value == 0 || std::abs(value) < m_zero_threshold)
+      return 0;
+
+    BitsT bits;
+    std::memcpy(&bits, &value, sizeof(T));
+    return static_cast<ChecksumT>((bits + m_half) >> m_dropped);
+  }
+
+  const Uint m_dropped;
+  const BitsT m_half;
+  const Real m_zero_threshold;
+};
+
+template<>
+struct ChecksumWord<double> : FloatChecksumWord<double, boost::uint64_t, 52>
+{
+  ChecksumWord(const Uint max_ulps, const Real zero_threshold) : FloatChecksumWord<double, boost::uint64_t, 52>(max_ulps, zero_threshold) {}
+};
+
+template<>
+struct ChecksumWord<float> : FloatChecksumWord<float, boost::uint32_t, 23>
+{
+  ChecksumWord(const Uint max_ulps, const Real zero_threshold) : FloatChecksumWord<float, boost::uint32_t, 23>(max_ulps, zero_threshold) {}
+};
+
+/// Computes the checksums for a range of blocks
+template<typename T>
+struct BlockChecksums
+{
+  BlockChecksums(const T* data, const Uint nb_values, const Uint block_values, ChecksumT* checksums, const Uint max_ulps, const Real zero_threshold) :
+    m_data(data),
+    m_nb_values(nb_values),
+    m_block_values(block_values),
+    m_checksums(checksums),
+    m_to_word(max_ulps, zero_threshold)
+  {
+  }
+
+  void operator()(const Uint begin, const Uint end, const Uint) const
+  {
+    for(Uint block = begin; block != end; ++block)
+    {
+      const Uint values_begin = block*m_block_values;
+      const Uint values_end = std::min(values_begin + m_block_values, m_nb_values);
+      ChecksumT hash = prime5 + static_cast<ChecksumT>(values_end - values_begin);
+      for(Uint i = values_begin; i != values_end; ++i)
+        hash = mix(hash, m_to_word(m_data[i]));
+      m_checksums[block] = finalize(hash);
+    }
+  }
+
+  const T* m_data;
+  const Uint m_nb_values;
+  const Uint m_block_values;
+  ChecksumT* m_checksums;
+  const ChecksumWord<T> m_to_word;
+};
+
+}
+
+template<typename T>
+void block_checksums(const T* data, const Uint nb_rows, const Uint row_size, std::vector<ChecksumT>& checksums, const Uint block_rows, const Uint max_ulps, const Real zero_threshold)
+{
+  if(block_rows == 0)
+    throw BadValue(FromHere(), "Checksum block size must be larger than zero");
+
+  const Uint nb_blocks = (nb_rows + block_rows - 1) / block_rows;
+  checksums.resize(nb_blocks);
+  if(nb_blocks == 0)
+    return;
+
+  const detail::BlockChecksums<T> functor(data, nb_rows*row_size, block_rows*row_size, &checksums[0], max_ulps, zero_threshold);
+  ThreadPool& pool = ThreadPool::instance();
+  if(nb_blocks == 1 || pool.nb_threads() == 1)
+    functor(0, nb_blocks, 0);
+  else
+    pool.parallel_for(0, nb_blocks, ThreadPool::RangeFunctionT(functor));
+}
+
+template void block_checksums<int>(const int*, const Uint, const Uint, std::vector<ChecksumT>&, const Uint, const Uint, const Real);
+template void block_checksums<Uint>(const Uint*, const Uint, const Uint, std::vector<ChecksumT>&, const Uint, const Uint, const Real);
+template void block_checksums<float>(const float*, const Uint, const Uint, std::vector<ChecksumT>&, const Uint, const Uint, const Real);
+template void block_checksums<double>(const double*, const Uint, const Uint, std::vector<ChecksumT>&, const Uint, const Uint, const Real);
+template void block_checksums<bool>(const bool*, const Uint, const Uint, std::vector<ChecksumT>&, const Uint, const Uint, const Real);
+
+ChecksumT combine_checksums(const std::vector<ChecksumT>& checksums)
+{
+  ChecksumT hash = detail::prime5 + static_cast<ChecksumT>(checksums.size());
+  for(std::vector<ChecksumT>::const_iterator it = checksums.begin(); it != checksums.end(); ++it)
+    hash = detail::mix(hash, *it);
+  return detail::finalize(hash);
+}
+
+std::string checksum_to_str(const ChecksumT checksum)
+{
+  std::ostringstream result;
+  result << std::hex << std::setw(16) << std::setfill('0') << checksum;
+  return result.str();
+}
+
+ChecksumT checksum_from_str(const std::string& str)
+{
+  std::istringstream input(str);
+  ChecksumT result = 0;
+  input >> std::hex >> result;
+  if(input.fail())
+    throw ParsingFailed(FromHere(), "Invalid checksum: " + str);
+  return result;
+}
+
+} // common
+} // cf3
@@ -0,0 +1,68 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_ArrayChecksum_hpp
+#define cf3_common_ArrayChecksum_hpp
+
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include "common/List.hpp"
+#include "common/Table.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+/// Type of the checksums
+typedef boost::uint64_t ChecksumT;
+
+/// Default number of rows in each checksum block
+static const Uint default_checksum_block_rows = 4096;
+
+/// Compute a checksum for each block of block_rows rows in a contiguous, row-major array of nb_rows x row_size values.
+/// The blocks are distributed over the threads of the ThreadPool.
+/// Floating point values are quantised before hashing, so that equal checksums guarantee that all values are at most
+/// max_ulps apart. Values that differ less than max_ulps may still end up in different quantisation bins, so a checksum
+/// mismatch must be confirmed by an element-wise comparison. Values below zero_threshold in absolute value are hashed as zero.
+/// Supported value types are int, Uint, float, double and bool.
+template<typename T>
+Common_API void block_checksums(const T* data, const Uint nb_rows, const Uint row_size, std::vector<ChecksumT>& checksums, const Uint block_rows = default_checksum_block_rows, const Uint max_ulps = 0, const Real zero_threshold = 0.);
+
+/// Block checksums of a table
+template<typename T>
+void block_checksums(const Table<T>& table, std::vector<ChecksumT>& checksums, const Uint block_rows = default_checksum_block_rows, const Uint max_ulps = 0, const Real zero_threshold = 0.)
+{
+  block_checksums(table.array().data(), table.size(), table.row_size(), checksums, block_rows, max_ulps, zero_threshold);
+}
+
+/// Block checksums of a list
+template<typename T>
+void block_checksums(const List<T>& list, std::vector<ChecksumT>& checksums, const Uint block_rows = default_checksum_block_rows, const Uint max_ulps = 0, const Real zero_threshold = 0.)
+{
+  block_checksums(list.array().data(), list.size(), 1u, checksums, block_rows, max_ulps, zero_threshold);
+}
+
+/// Combine a sequence of block checksums into a single checksum
+Common_API ChecksumT combine_checksums(const std::vector<ChecksumT>& checksums);
+
+/// Hexadecimal representation of a checksum
+Common_API std::string checksum_to_str(const ChecksumT checksum);
+
+/// Parse a checksum written by checksum_to_str
+Common_API ChecksumT checksum_from_str(const std::string& str);
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+#endif // cf3_common_ArrayChecksum_hpp
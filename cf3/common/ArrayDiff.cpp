@@ -4,10 +4,13 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+
 #include <boost/mpl/vector.hpp>
 #include <boost/mpl/for_each.hpp>
 #include <boost/math/special_functions/next.hpp>
 
+#include "common/ArrayChecksum.hpp"
 #include "common/ArrayDiff.hpp"
 #include "common/Builder.hpp"
 #include "common/List.hpp"
@@ -35,11 +38,12 @@ namespace detail
   // MPL functor that does the actual difference
   struct DoArrayDiff
   {
-    DoArrayDiff(const Handle<Component const>& left, const Handle<Component const>& right, const Uint max_ulps, const Real zero_threshold, bool& found_type, bool& arrays_equal) :
+    DoArrayDiff(const Handle<Component const>& left, const Handle<Component const>& right, const Uint max_ulps, const Real zero_threshold, const Uint block_rows, bool& found_type, bool& arrays_equal) :
       m_left(left),
       m_right(right),
       m_max_ulps(max_ulps),
       m_zero_threshold(zero_threshold),
+      m_block_rows(block_rows),
       m_found_type(found_type),
       m_arrays_equal(arrays_equal)
     {
@@ -63,7 +67,7 @@ namespace detail
           m_arrays_equal = false;
           return;
         }
-        compare_lists(boost::is_floating_point<NumberT>(), *left_list, *right_list);
+        compare_blocks(*left_list, *right_list);
       }
       else
       {
@@ -78,19 +82,60 @@ namespace detail
             m_arrays_equal = false;
             return;
           }
-          compare_tables(boost::is_floating_point<NumberT>(), *left_table, *right_table);
+          compare_blocks(*left_table, *right_table);
         }
       }
       
     }
     
-    // Floating point comparison
-    template<typename NumberT>
-    void compare_lists(boost::true_type, const List<NumberT>& left, const List<NumberT>& right)
+    // Compare the checksums of blocks of rows, and compare the individual values only for the blocks that differ
+    template<typename ArrayT>
+    void compare_blocks(const ArrayT& left, const ArrayT& right)
     {
       m_arrays_equal = true;
       const Uint nb_rows = left.size();
-      for(Uint i = 0; i != nb_rows; ++i)
+      if(m_block_rows == 0)
+      {
+        compare_rows(left, right, 0, nb_rows);
+        return;
+      }
+
+      std::vector<ChecksumT> left_checksums, right_checksums;
+      block_checksums(left, left_checksums, m_block_rows, m_max_ulps, m_zero_threshold);
+      block_checksums(right, right_checksums, m_block_rows, m_max_ulps, m_zero_threshold);
+      const Uint nb_blocks = left_checksums.size();
+      Uint nb_mismatches = 0;
+      for(Uint block = 0; block != nb_blocks; ++block)
+      {
+        if(left_checksums[block] == right_checksums[block])
+          continue;
+
+        ++nb_mismatches;
+        const Uint rows_begin = block*m_block_rows;
+        compare_rows(left, right, rows_begin, std::min(rows_begin + m_block_rows, nb_rows));
+      }
+
+      if(nb_mismatches != 0)
+        CFdebug << m_prefix << nb_mismatches << " out of " << nb_blocks << " blocks have different checksums" << CFendl;
+    }
+
+    template<typename NumberT>
+    void compare_rows(const List<NumberT>& left, const List<NumberT>& right, const Uint rows_begin, const Uint rows_end)
+    {
+      compare_lists(boost::is_floating_point<NumberT>(), left, right, rows_begin, rows_end);
+    }
+
+    template<typename NumberT>
+    void compare_rows(const Table<NumberT>& left, const Table<NumberT>& right, const Uint rows_begin, const Uint rows_end)
+    {
+      compare_tables(boost::is_floating_point<NumberT>(), left, right, rows_begin, rows_end);
+    }
+
+    // Floating point comparison
+    template<typename NumberT>
+    void compare_lists(boost::true_type, const List<NumberT>& left, const List<NumberT>& right, const Uint rows_begin, const Uint rows_end)
+    {
+      for(Uint i = rows_begin; i != rows_end; ++i)
       {
         const Real diff = compare_numbers(left[i], right[i]);
         if(diff > m_max_ulps)
@@ -103,11 +148,9 @@ namespace detail
 
     // Integer number comparison
     template<typename NumberT>
-    void compare_lists(boost::false_type, const List<NumberT>& left, const List<NumberT>& right)
+    void compare_lists(boost::false_type, const List<NumberT>& left, const List<NumberT>& right, const Uint rows_begin, const Uint rows_end)
     {
-      m_arrays_equal = true;
-      const Uint nb_rows = left.size();
-      for(Uint i = 0; i != nb_rows; ++i)
+      for(Uint i = rows_begin; i != rows_end; ++i)
       {
         if(left[i] != right[i])
         {
@@ -119,12 +162,10 @@ namespace detail
 
     // Floating point comparison
     template<typename NumberT>
-    void compare_tables(boost::true_type, const Table<NumberT>& left, const Table<NumberT>& right)
+    void compare_tables(boost::true_type, const Table<NumberT>& left, const Table<NumberT>& right, const Uint rows_begin, const Uint rows_end)
     {
-      m_arrays_equal = true;
-      const Uint nb_rows = left.size();
       const Uint row_size = left.row_size();
-      for(Uint i = 0; i != nb_rows; ++i)
+      for(Uint i = rows_begin; i != rows_end; ++i)
       {
         const typename Table<NumberT>::ConstRow left_row = left[i];
         const typename Table<NumberT>::ConstRow right_row = right[i];
@@ -142,12 +183,10 @@ namespace detail
 
     // Integer number comparison
     template<typename NumberT>
-    void compare_tables(boost::false_type, const Table<NumberT>& left, const Table<NumberT>& right)
+    void compare_tables(boost::false_type, const Table<NumberT>& left, const Table<NumberT>& right, const Uint rows_begin, const Uint rows_end)
     {
-      m_arrays_equal = true;
-      const Uint nb_rows = left.size();
       const Uint row_size = left.row_size();
-      for(Uint i = 0; i != nb_rows; ++i)
+      for(Uint i = rows_begin; i != rows_end; ++i)
       {
         const typename Table<NumberT>::ConstRow left_row = left[i];
         const typename Table<NumberT>::ConstRow right_row = right[i];
@@ -179,6 +218,7 @@ namespace detail
     Handle<Component const> m_right;
     const Uint m_max_ulps;
     const Real m_zero_threshold;
+    const Uint m_block_rows;
     
     bool& m_found_type;
     bool& m_arrays_equal;
@@ -211,6 +251,11 @@ ArrayDiff::ArrayDiff(const std::string& name): Action(name)
     .description("Floating point numbers smaller than this are considered to be zero")
     .mark_basic();
 
+  options().add("checksum_block_rows", default_checksum_block_rows)
+    .pretty_name("Checksum Block Rows")
+    .description("Number of rows in each block for which a checksum is compared first. Values are only compared one by one for blocks with a different checksum. Set to zero to compare all values")
+    .mark_basic();
+
   properties().add("arrays_equal", false);
 }
 
@@ -232,9 +277,10 @@ void ArrayDiff::execute()
   
   const Uint max_ulps = options().value<Uint>("max_ulps");
   const Real zero_threshold = options().value<Real>("zero_threshold");
+  const Uint block_rows = options().value<Uint>("checksum_block_rows");
   bool found_type = false;
   bool arrays_equal = false;
-  boost::mpl::for_each<allowed_types>(detail::DoArrayDiff(left, right, max_ulps, zero_threshold, found_type, arrays_equal));
+  boost::mpl::for_each<allowed_types>(detail::DoArrayDiff(left, right, max_ulps, zero_threshold, block_rows, found_type, arrays_equal));
   if(!found_type)
     throw common::NotImplemented(FromHere(), "ArrayDiff does not support diff for type " + left->derived_type_name());
 
@@ -171,6 +171,28 @@ std::string BinaryDataReader::block_type_name ( const Uint block_idx )
 }
 
 
+bool BinaryDataReader::has_checksum ( const Uint block_idx )
+{
+  return !m_implementation->get_block_node(block_idx).attribute_value("checksum").empty();
+}
+
+ChecksumT BinaryDataReader::block_checksum ( const Uint block_idx )
+{
+  if(!has_checksum(block_idx))
+    throw SetupError(FromHere(), "No checksum was stored for block " + to_str(block_idx));
+  return checksum_from_str(m_implementation->get_block_node(block_idx).attribute_value("checksum"));
+}
+
+Uint BinaryDataReader::checksum_block_rows ( const Uint block_idx )
+{
+  return from_str<Uint>(m_implementation->get_block_node(block_idx).attribute_value("checksum_block_rows"));
+}
+
+Uint BinaryDataReader::checksum_max_ulps ( const Uint block_idx )
+{
+  return from_str<Uint>(m_implementation->get_block_node(block_idx).attribute_value("checksum_max_ulps"));
+}
+
 void BinaryDataReader::read_data_block(char *data, const Uint count, const Uint block_idx)
 {
   if(is_null(m_implementation.get()))
@@ -9,6 +9,7 @@
 
 #include <boost/scoped_ptr.hpp>
 
+#include "common/ArrayChecksum.hpp"
 #include "common/Component.hpp"
 #include "common/List.hpp"
 #include "common/Table.hpp"
@@ -60,6 +61,35 @@ public: // functions
     read_data_block(reinterpret_cast<char*>(list.array().data()), sizeof(T)*rows, block_idx);
   }
 
+  /// Check the given table against the checksum that was stored for the given block on this rank,
+  /// without reading the data from the file. Blocks without checksum only have their size checked.
+  template<typename T>
+  bool verify_table(const Table<T>& table, const Uint block_idx)
+  {
+    if(table.size() != block_rows(block_idx) || table.row_size() != block_cols(block_idx))
+      return false;
+    if(!has_checksum(block_idx))
+      return true;
+
+    std::vector<ChecksumT> checksums;
+    block_checksums(table, checksums, checksum_block_rows(block_idx), checksum_max_ulps(block_idx));
+    return combine_checksums(checksums) == block_checksum(block_idx);
+  }
+
+  /// Check the given list against the checksum that was stored for the given block
+  template<typename T>
+  bool verify_list(const List<T>& list, const Uint block_idx)
+  {
+    if(list.size() != block_rows(block_idx))
+      return false;
+    if(!has_checksum(block_idx))
+      return true;
+
+    std::vector<ChecksumT> checksums;
+    block_checksums(list, checksums, checksum_block_rows(block_idx), checksum_max_ulps(block_idx));
+    return combine_checksums(checksums) == block_checksum(block_idx);
+  }
+
   /// Close the current file
   void close();
 
@@ -75,6 +105,18 @@ public: // functions
   /// Type name of the data stored in the given block
   std::string block_type_name(const Uint block_idx);
 
+  /// True if a checksum was stored for the given block
+  bool has_checksum(const Uint block_idx);
+
+  /// Checksum of the given block
+  ChecksumT block_checksum(const Uint block_idx);
+
+  /// Number of rows in each of the checksum blocks that make up the block checksum
+  Uint checksum_block_rows(const Uint block_idx);
+
+  /// ULP tolerance that was used to compute the checksum of the given block
+  Uint checksum_max_ulps(const Uint block_idx);
+
 private:
   // Read aata block from the binary file
   void read_data_block(char* data, const Uint count, const Uint block_idx);
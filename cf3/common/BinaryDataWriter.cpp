@@ -70,7 +70,7 @@ struct BinaryDataWriter::Implementation
     PE::Comm::instance().barrier();
   }
 
-  Uint write_data_block(const char* data, const std::streamsize count, const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name)
+  Uint write_data_block(const char* data, const std::streamsize count, const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name, const ChecksumT checksum, const bool write_checksum, const Uint checksum_max_ulps)
   {
     cf3_assert(out_file.is_open());
     PE::Comm& comm = PE::Comm::instance();
@@ -97,7 +97,9 @@ struct BinaryDataWriter::Implementation
     const Uint block_end = out_file.tellp();
 
     // Data describing the block on the current CPU
-    const std::vector<Uint> my_block_info = boost::assign::list_of(nb_rows)(nb_cols)(block_begin)(block_end);
+    const Uint checksum_high = static_cast<Uint>(checksum >> 32);
+    const Uint checksum_low = static_cast<Uint>(checksum & 0xFFFFFFFFu);
+    const std::vector<Uint> my_block_info = boost::assign::list_of(nb_rows)(nb_cols)(block_begin)(block_end)(checksum_high)(checksum_low);
     const Uint block_info_size = my_block_info.size();
     std::vector<Uint> global_block_info;
     const Uint root = 0;
@@ -125,6 +127,13 @@ struct BinaryDataWriter::Implementation
         block_xml.set_attribute("nb_cols", to_str(global_block_info[j+1]));
         block_xml.set_attribute("begin", to_str(global_block_info[j+2]));
         block_xml.set_attribute("end", to_str(global_block_info[j+3]));
+        if(write_checksum)
+        {
+          const ChecksumT block_checksum = (static_cast<ChecksumT>(global_block_info[j+4]) << 32) | static_cast<ChecksumT>(global_block_info[j+5]);
+          block_xml.set_attribute("checksum", checksum_to_str(block_checksum));
+          block_xml.set_attribute("checksum_block_rows", to_str(default_checksum_block_rows));
+          block_xml.set_attribute("checksum_max_ulps", to_str(checksum_max_ulps));
+        }
       }
     }
 
@@ -164,12 +173,24 @@ struct BinaryDataWriter::Implementation
   
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-BinaryDataWriter::BinaryDataWriter ( const std::string& name ) : Component(name)
+BinaryDataWriter::BinaryDataWriter ( const std::string& name ) : Component(name),
+  m_write_checksums(true),
+  m_checksum_max_ulps(0)
 {
   options().add("file", URI())
     .pretty_name("File")
     .description("File name for the output file")
     .attach_trigger(boost::bind(&BinaryDataWriter::trigger_file, this));
+
+  options().add("write_checksums", true)
+    .pretty_name("Write Checksums")
+    .description("Store a checksum of each data block in the XML index, so results can be verified without a copy of the data")
+    .link_to(&m_write_checksums);
+
+  options().add("checksum_max_ulps", 0u)
+    .pretty_name("Checksum Max ULPs")
+    .description("Floating point values are rounded before computing the checksum, so values that are at most this number of ULPs apart may result in the same checksum")
+    .link_to(&m_checksum_max_ulps);
 }
 
 BinaryDataWriter::~BinaryDataWriter()
@@ -182,14 +203,14 @@ void BinaryDataWriter::close()
   m_implementation.reset();
 }
 
-Uint BinaryDataWriter::write_data_block(const char* data, const std::streamsize count, const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name)
+Uint BinaryDataWriter::write_data_block(const char* data, const std::streamsize count, const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name, const ChecksumT checksum)
 {
   if(is_null(m_implementation.get()))
   {
     m_implementation.reset(new Implementation(options().value<URI>("file")));
   }
 
-  return m_implementation->write_data_block(data, count, list_name, nb_rows, nb_cols, type_name);
+  return m_implementation->write_data_block(data, count, list_name, nb_rows, nb_cols, type_name, checksum, m_write_checksums, m_checksum_max_ulps);
 }
 
 void BinaryDataWriter::trigger_file()
@@ -9,6 +9,7 @@
 
 #include <boost/scoped_ptr.hpp>
 
+#include "common/ArrayChecksum.hpp"
 #include "common/Component.hpp"
 #include "common/List.hpp"
 #include "common/Table.hpp"
@@ -38,14 +39,14 @@ public: // functions
   template<typename T>
   Uint append_data(const Table<T>& table)
   {
-    return write_data_block(reinterpret_cast<const char*>(table.array().data()), sizeof(T)*table.row_size()*table.size(), table.name(), table.size(), table.row_size(), class_name<T>());
+    return write_data_block(reinterpret_cast<const char*>(table.array().data()), sizeof(T)*table.row_size()*table.size(), table.name(), table.size(), table.row_size(), class_name<T>(), checksum(table));
   }
   
   /// Append a new data block, returning the block index number for the current file
   template<typename T>
   Uint append_data(const List<T>& list)
   {
-    return write_data_block(reinterpret_cast<const char*>(list.array().data()), sizeof(T)*list.size(), list.name(), list.size(), 1, class_name<T>());
+    return write_data_block(reinterpret_cast<const char*>(list.array().data()), sizeof(T)*list.size(), list.name(), list.size(), 1, class_name<T>(), checksum(list));
   }
 
   /// Close the current file
@@ -53,7 +54,22 @@ public: // functions
 
 private:
   // Write a data block to the binary file
-  Uint write_data_block(const char* data, const std::streamsize count, const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name);
+  Uint write_data_block(const char* data, const std::streamsize count, const std::string& list_name, const Uint nb_rows, const Uint nb_cols, const std::string& type_name, const ChecksumT checksum);
+
+  // Checksum stored with the data, allowing to verify results without a copy of the data
+  template<typename ArrayT>
+  ChecksumT checksum(const ArrayT& array) const
+  {
+    if(!m_write_checksums)
+      return 0;
+
+    std::vector<ChecksumT> checksums;
+    block_checksums(array, checksums, default_checksum_block_rows, m_checksum_max_ulps);
+    return combine_checksums(checksums);
+  }
+
+  bool m_write_checksums;
+  Uint m_checksum_max_ulps;
 
   // Trigger on output file change
   void trigger_file();
@@ -8,6 +8,8 @@
 #include <boost/cast.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "rapidxml/rapidxml.hpp"
 
@@ -31,6 +33,7 @@
 #include "common/LibLoader.hpp"
 #include "common/PropertyList.hpp"
 #include "common/ComponentIterator.hpp"
+#include "common/MemoryComponent.hpp"
 #include "common/TimedComponent.hpp"
 #include "common/UUCount.hpp"
 
@@ -52,11 +55,65 @@ ComponentBuilder < Component, Component, LibCommon > Component_Builder;
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+
+/// Version of the component tree, see Component::tree_version()
+Uint& tree_version_counter()
+{
+  static Uint counter = 0;
+  return counter;
+}
+
+/// Version of the component paths, see Component::path_version()
+Uint& path_version_counter()
+{
+  static Uint counter = 0;
+  return counter;
+}
+
+/// Last child of an xml node, or null if it has no children
+rapidxml::xml_node<>* last_child( const XmlNode& node )
+{
+  return is_null( node.content->first_node() ) ? nullptr : node.content->last_node();
+}
+
+/// Number of removals kept per component for list_tree_since. Clients that are further behind
+/// get the subtree of the component again
+const Uint max_logged_removals = 128;
+
+/// Tag IDs used by Component, resolved only once since every lookup by name locks the tag registry
+Uint static_component_tag()
+{
+  static const Uint id = TaggedObject::tag_id(Tags::static_component());
+  return id;
+}
+
+Uint basic_tag()
+{
+  static const Uint id = TaggedObject::tag_id("basic");
+  return id;
+}
+
+Uint norecurse_tag()
+{
+  static const Uint id = TaggedObject::tag_id("norecurse");
+  return id;
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 Component::Component ( const std::string& name ) :
     m_name (),
     m_properties(new PropertyList()),
     m_options(new OptionList()),
-    m_parent(0)
+    m_parent(0),
+    m_tree_version(0),
+    m_removed_log_start(0),
+    m_structure_generation(0),
+    m_query_cache_mutex(new boost::mutex())
 {
   // accept name
 
@@ -79,6 +136,14 @@ Component::Component ( const std::string& name ) :
       .description("list the tree of subcomponents")
       .pretty_name("List tree");
 
+  regist_signal( "list_tree_since" )
+      .connect( boost::bind( &Component::signal_list_tree_since, this, _1 ) )
+      .hidden(true)
+      .read_only(true)
+      .description("list the changes to the tree of subcomponents since a given tree version")
+      .pretty_name("List tree changes")
+      .signature( boost::bind(&Component::signature_list_tree_since, this, _1) );
+
   regist_signal( "list_tree_recursive" )
       .connect( boost::bind( &Component::signal_list_tree_recursive, this, _1 ) )
       .hidden(true)
@@ -177,6 +242,12 @@ Component::Component ( const std::string& name ) :
       .pretty_name("Store Timings")
       .description("Store calculated timing information into properties timer_mean, timer_minimum and timer_maximum for the tree starting at this component");
 
+  regist_signal( "print_memory_tree" )
+      .connect( boost::bind(&Component::signal_print_memory_tree, this, _1))
+      .hidden(true)
+      .pretty_name("Print Memory Tree")
+      .description("Print the memory held by the tree starting at this component, reduced over all CPUs. Must be called on all CPUs");
+
   regist_signal( "clear" )
       .connect( boost::bind( &Component::signal_clear, this, _1 ) )
       .description("remove all non-static subcomponents")
@@ -206,6 +277,9 @@ Component::Component ( const std::string& name ) :
 
 Component::~Component()
 {
+  // Children that are destroyed after this component, or outlive it, must not invalidate the query cache of a deleted parent
+  for(CompStorageT::iterator it = m_components.begin(); it != m_components.end(); ++it)
+    (*it)->m_parent = 0;
 }
 
 
@@ -238,9 +312,15 @@ void Component::rename ( const std::string& name )
     const Uint idx = lookup->second;
     m_parent->m_component_lookup.erase(lookup);
     m_parent->m_component_lookup[name] = idx;
+
+    // for clients, a renamed component was removed and added again
+    m_parent->log_removed_component(m_name);
+    m_tree_version = next_tree_version();
   }
 
   m_name = name;
+  ++path_version_counter();
+  structure_changed();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -307,6 +387,18 @@ Component& Component::add_component ( const boost::shared_ptr<Component>& subcom
 
   subcomp->m_parent = this;
 
+  // a component added under a previously removed name replaces it entirely, so the removal need not be kept
+  std::vector< std::pair<Uint, std::string> >::iterator removed_it = m_removed_components.begin();
+  while(removed_it != m_removed_components.end())
+  {
+    if(removed_it->second == unique_name)
+      removed_it = m_removed_components.erase(removed_it);
+    else
+      ++removed_it;
+  }
+  subcomp->m_tree_version = next_tree_version();
+  structure_changed();
+
   raise_tree_updated_event();
 
   return *subcomp;
@@ -354,6 +446,18 @@ std::string Component::ensure_unique_name ( Component& subcomp )
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+void Component::log_removed_component ( const std::string& name )
+{
+  if(m_removed_components.size() == max_logged_removals)
+  {
+    m_removed_log_start = m_removed_components.front().first;
+    m_removed_components.erase(m_removed_components.begin());
+  }
+  m_removed_components.push_back(std::make_pair(next_tree_version(), name));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 boost::shared_ptr<Component> Component::remove_component ( const std::string& name )
 {
   // find the component exists
@@ -363,7 +467,7 @@ boost::shared_ptr<Component> Component::remove_component ( const std::string& na
   {
     const Uint comp_idx = itr->second;
     boost::shared_ptr<Component> comp = m_components[comp_idx];             // get the component
-    if(comp->has_tag(Tags::static_component()))
+    if(comp->has_tag(static_component_tag()))
       throw BadValue(FromHere(), "Error removing component " + comp->uri().string() + ", it is static!");
 
     m_component_lookup.erase(itr);               // remove it from the lookup
@@ -384,6 +488,9 @@ boost::shared_ptr<Component> Component::remove_component ( const std::string& na
     }
     m_components = new_storage;
 
+    log_removed_component(name);
+    structure_changed();
+
     raise_tree_updated_event();
 
     return comp;                                   // return it to client
@@ -411,7 +518,7 @@ void Component::clear()
   std::vector<std::string> child_names;
   BOOST_FOREACH(const Component& child, *this)
   {
-    if(!child.has_tag(Tags::static_component()))
+    if(!child.has_tag(static_component_tag()))
       child_names.push_back(child.name());
   }
 
@@ -474,11 +581,76 @@ void Component::change_parent(Handle<Component> to_parent)
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+void Component::structure_changed()
+{
+  {
+    boost::lock_guard<boost::mutex> lock(*m_query_cache_mutex);
+    ++m_structure_generation;
+    m_query_cache.clear();
+  }
+
+  // the lists of direct children of the parents are still valid and move on to the new generation,
+  // their recursive lists are dropped so they don't keep removed components alive
+  for(Component* comp = m_parent; comp != 0; comp = comp->m_parent)
+  {
+    boost::lock_guard<boost::mutex> lock(*comp->m_query_cache_mutex);
+    const Uint old_generation = comp->m_structure_generation++;
+    std::map< QueryKey, std::pair< Uint, boost::shared_ptr<void> > >::iterator it = comp->m_query_cache.begin();
+    while(it != comp->m_query_cache.end())
+    {
+      if(it->first.recurse)
+      {
+        comp->m_query_cache.erase(it++);
+      }
+      else
+      {
+        if(it->second.first == old_generation)
+          it->second.first = comp->m_structure_generation;
+        ++it;
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::shared_ptr<void> Component::find_cached_query(const QueryKey& key) const
+{
+  boost::lock_guard<boost::mutex> lock(*m_query_cache_mutex);
+  std::map< QueryKey, std::pair< Uint, boost::shared_ptr<void> > >::const_iterator it = m_query_cache.find(key);
+  if(it == m_query_cache.end() || it->second.first != m_structure_generation)
+    return boost::shared_ptr<void>();
+  return it->second.second;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+boost::shared_ptr<void> Component::store_cached_query(const QueryKey& key, const Uint generation, const boost::shared_ptr<void>& children) const
+{
+  boost::lock_guard<boost::mutex> lock(*m_query_cache_mutex);
+  std::pair< Uint, boost::shared_ptr<void> >& cached = m_query_cache[key];
+  // keep the list of another thread that got there first
+  if(cached.second && cached.first == m_structure_generation)
+    return cached.second;
+  cached = std::make_pair(generation, children);
+  return children;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void Component::tags_changed()
+{
+  structure_changed();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 void Component::move_to ( Component& new_parent )
 {
   cf3_assert(m_parent);
   boost::shared_ptr<Component> this_ptr = m_parent->remove_component( *this );
   new_parent.add_component( this_ptr );
+  ++path_version_counter();
   raise_tree_updated_event();
 }
 
@@ -647,7 +819,7 @@ std::string Component::info ( const std::string& what  ) const
       ss << "SUBCOMPONENTS" << std::endl;
       boost_foreach( const Component& c, *this )
       {
-        if (c.has_tag(Tags::static_component()))
+        if (c.has_tag(static_component_tag()))
           ss << "     + [static]  ";
         else
           ss << "     + [dynamic] ";
@@ -714,7 +886,7 @@ void Component::signal_print_info ( SignalArgs& args  ) const
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-void Component::write_xml_tree( XmlNode& node, bool put_all_content ) const
+void Component::write_xml_tree( XmlNode& node, bool put_all_content, const Uint depth ) const
 {
   cf3_assert( node.is_valid() );
 
@@ -731,7 +903,7 @@ void Component::write_xml_tree( XmlNode& node, bool put_all_content ) const
 
     this_node.set_attribute( "name", name() );
     this_node.set_attribute( "atype", type_name );
-    this_node.set_attribute( "mode", has_tag("basic") ? "basic" : "adv");
+    this_node.set_attribute( "mode", has_tag(basic_tag()) ? "basic" : "adv");
     this_node.set_attribute( "uuid", properties().value_str("uuid") );
 
     const Link* lnk = dynamic_cast<const Link*>(this);
@@ -752,12 +924,70 @@ void Component::write_xml_tree( XmlNode& node, bool put_all_content ) const
         signal_list_options( sf );
       }
 
-      boost_foreach( const Component& c, *this )
+      if( depth == 1 && !m_components.empty() )
       {
-        c.write_xml_tree( this_node, put_all_content );
+        this_node.set_attribute( "truncated", "true" );
       }
+      else
+      {
+        boost_foreach( const Component& c, *this )
+        {
+          c.write_xml_tree( this_node, put_all_content, depth == 0 ? 0 : depth - 1 );
+        }
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void Component::write_xml_tree_since( XmlNode& added, XmlNode& changed, std::vector<std::string>& removed,
+                                      const Uint version, const Uint depth ) const
+{
+  typedef std::pair<Uint, std::string> RemovedT;
+  boost_foreach( const RemovedT& removed_component, m_removed_components )
+  {
+    if( removed_component.first > version )
+      removed.push_back( (uri() / URI(removed_component.second, URI::Scheme::CPATH)).path() );
+  }
+
+  boost_foreach( const Component& c, *this )
+  {
+    if( c.m_tree_version > version || !c.removals_logged_since( version ) )
+    {
+      // the whole subtree is new to the caller, or its removals are no longer known and the caller replaces it
+      rapidxml::xml_node<>* last_written = last_child( added );
+      c.write_xml_tree( added, false, depth );
+      if( last_child( added ) != last_written )
+        XmlNode( last_child( added ) ).set_attribute( "parent", uri().path() );
     }
+    else
+    {
+      c.write_changed_options( changed, version );
+      c.write_xml_tree_since( added, changed, removed, version, depth );
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void Component::write_changed_options( XmlNode& changed, const Uint version ) const
+{
+  OptionList changed_options;
+  for( OptionList::const_iterator it = options().begin(); it != options().end(); ++it )
+  {
+    if( it->second->version() > version )
+      changed_options.add( it->second );
   }
+
+  if( changed_options.store.empty() )
+    return;
+
+  XmlNode this_node = changed.add_node( "node" );
+  this_node.set_attribute( "path", uri().path() );
+
+  SignalFrame sf(this_node);
+  SignalOptions::add_to_map( sf.map( Protocol::Tags::key_properties() ).main_map, changed_options );
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -766,11 +996,73 @@ void Component::signal_list_tree( SignalArgs& args ) const
 {
   SignalFrame reply = args.create_reply( uri() );
 
+  reply.main_map.content.set_attribute( "tree_version", to_str( tree_version() ) );
   write_xml_tree(reply.main_map.content, false);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+void Component::signal_list_tree_since( SignalArgs& args ) const
+{
+  SignalOptions options( args );
+  const Uint version = options.value<Uint>("version");
+  const Uint depth = options.check("depth") ? options.value<Uint>("depth") : 0u;
+
+  SignalFrame reply = args.create_reply( uri() );
+
+  XmlNode added = reply.map( "added" ).main_map.content;
+  XmlNode changed = reply.map( "changed" ).main_map.content;
+  std::vector<std::string> removed;
+
+  // if removals made after the version were dropped from the log, the caller replaces all subcomponents
+  const bool reset = !removals_logged_since( version );
+
+  write_changed_options( changed, version );
+  write_xml_tree_since( added, changed, removed, reset ? 0u : version, depth );
+
+  SignalOptions reply_options( reply );
+  reply_options.add( "version", tree_version() );
+  reply_options.add( "path", uri() );
+  reply_options.add( "removed", removed );
+  reply_options.add( "reset", reset );
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void Component::signature_list_tree_since( SignalArgs& args ) const
+{
+  SignalOptions options( args );
+
+  options.add( "version", 0u )
+      .description( "Tree version known by the caller. Changes made after this version are listed, "
+                     "all subcomponents if zero" );
+  options.add( "depth", 0u )
+      .description( "Number of levels listed for each added component, 0 to list all levels" );
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Uint Component::tree_version()
+{
+  return tree_version_counter();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Uint Component::next_tree_version()
+{
+  return ++tree_version_counter();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+Uint Component::path_version()
+{
+  return path_version_counter();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 void Component::signal_list_tree_recursive( SignalArgs& args) const
 {
   CFinfo << uri().path() << " [" << derived_type_name() << "]" << CFendl;
@@ -787,7 +1079,7 @@ std::string Component::tree(bool basic_mode, Uint depth, Uint recursion_level) c
   std::string tree;
   if (recursion_level<=depth || depth==0)
   {
-    if ( !basic_mode || has_tag("basic") )
+    if ( !basic_mode || has_tag(basic_tag()) )
     {
       for (Uint i=0; i<recursion_level; i++)
         tree += "  ";
@@ -1124,6 +1416,13 @@ void Component::signal_store_timings ( SignalArgs& args )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void Component::signal_print_memory_tree ( SignalArgs& args )
+{
+  print_memory_tree(*this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void Component::signal_clear ( SignalArgs& args )
 {
   clear();
@@ -1159,14 +1458,16 @@ void Component::configure_option_recursively(const std::string& opt_name, const
 
 //  CFinfo << "+++ recurse config option [" << opt_name << "] from [" << uri().string() << "]" << CFendl;
 
-  if (m_options->check(opt_name) && !(*m_options)[opt_name].has_tag("norecurse"))
+  const Uint opt_tag = tag_id(opt_name);
+
+  if (m_options->check(opt_name) && !(*m_options)[opt_name].has_tag(norecurse_tag()))
   {
     options().set(opt_name,val);
   }
 
   foreach_container((std::string name) (boost::shared_ptr<Option> opt), options())
   {
-    if (opt->has_tag(opt_name) && !opt->has_tag("norecurse"))
+    if (opt->has_tag(opt_tag) && !opt->has_tag(norecurse_tag()))
       options().set(name,val);
   }
 
@@ -1179,7 +1480,7 @@ void Component::configure_option_recursively(const std::string& opt_name, const
 
     // configure the option that matches the name
 
-    if (component.options().check(opt_name) && !component.options().option(opt_name).has_tag("norecurse"))
+    if (component.options().check(opt_name) && !component.options().option(opt_name).has_tag(norecurse_tag()))
     {
       component.options().set(opt_name,val);
     }
@@ -1188,7 +1489,7 @@ void Component::configure_option_recursively(const std::string& opt_name, const
 
     foreach_container((std::string name) (boost::shared_ptr<Option> opt), component.options())
     {
-      if (opt->has_tag(opt_name) && !opt->has_tag("norecurse"))
+      if (opt->has_tag(opt_tag) && !opt->has_tag(norecurse_tag()))
         component.options().set(name,val);
     }
 
@@ -1317,72 +1618,60 @@ void Component::on_ping_event(SignalArgs& args)
 
 Component::iterator Component::begin()
 {
-  std::vector<boost::shared_ptr<Component> > vec;
-  put_components<Component>(vec, false); // not recursive
-  return Component::iterator(vec, 0);    // begin
+  return Component::iterator(cached_components<Component>(false), 0); // begin
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 Component::iterator Component::end()
 {
-  std::vector<boost::shared_ptr<Component> > vec;
-  put_components<Component>(vec, false);        // not recursive
-  return Component::iterator(vec, vec.size());  // end
+  const boost::shared_ptr< const std::vector< boost::shared_ptr<Component> > > vec = cached_components<Component>(false);
+  return Component::iterator(vec, vec->size()); // end
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 Component::const_iterator Component::begin() const
 {
-  std::vector<boost::shared_ptr<Component const> > vec;
-  put_components<Component>(vec, false); // not recursive
-  return Component::const_iterator(vec, 0);    // begin
+  return Component::const_iterator(cached_components<Component>(false), 0); // begin
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 Component::const_iterator Component::end() const
 {
-  std::vector<boost::shared_ptr<Component const> > vec;
-  put_components<Component>(vec, false);        // not recursive
-  return Component::const_iterator(vec, vec.size());  // end
+  const boost::shared_ptr< const std::vector< boost::shared_ptr<Component const> > > vec = cached_components<Component>(false);
+  return Component::const_iterator(vec, vec->size()); // end
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 Component::iterator Component::recursive_begin()
 {
-  std::vector<boost::shared_ptr<Component> > vec;
-  put_components<Component>(vec, true);  // recursive
-  return Component::iterator(vec, 0);    // begin
+  return Component::iterator(cached_components<Component>(true), 0); // begin
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 Component::iterator Component::recursive_end()
 {
-  std::vector<boost::shared_ptr<Component> > vec;
-  put_components<Component>(vec, true);         // recursive
-  return Component::iterator(vec, vec.size());  // end
+  const boost::shared_ptr< const std::vector< boost::shared_ptr<Component> > > vec = cached_components<Component>(true);
+  return Component::iterator(vec, vec->size()); // end
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 Component::const_iterator Component::recursive_begin() const
 {
-  std::vector<boost::shared_ptr<Component const> > vec;
-  put_components<Component>(vec, true);  // recursive
-  return Component::const_iterator(vec, 0);    // begin
+  return Component::const_iterator(cached_components<Component>(true), 0); // begin
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 Component::const_iterator Component::recursive_end() const
 {
-  std::vector<boost::shared_ptr<Component const> > vec;
-  put_components<Component>(vec, true);         // recursive
-  return Component::const_iterator(vec, vec.size());  // end
+  const boost::shared_ptr< const std::vector< boost::shared_ptr<Component const> > > vec = cached_components<Component>(true);
+  return Component::const_iterator(vec, vec->size()); // end
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
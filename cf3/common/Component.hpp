@@ -13,8 +13,12 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <map>
+#include <typeinfo>
+
 #include <boost/version.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include "common/AllocatedComponent.hpp"
 #include "common/Assertions.hpp"
@@ -31,6 +35,7 @@ namespace boost
   template<typename T>
   class iterator_range;
   class any;
+  class mutex;
 }
 
 namespace cf3 {
@@ -317,6 +322,14 @@ public: // functions
   ///  prints tree recursively
   void signal_list_tree_recursive ( SignalArgs& args) const;
 
+  /// lists the sub components that were added, removed or that have changed options
+  /// since the tree version given in the "version" option. Only the most recent removals are kept,
+  /// if older ones are needed the "reset" option of the reply is true and all sub components are listed as added
+  void signal_list_tree_since( SignalArgs& args ) const;
+
+  /// Defines the signature of "list_tree_since" signal.
+  void signature_list_tree_since( SignalArgs& args ) const;
+
   /// lists the properties of this component
   void signal_list_properties ( SignalArgs& args ) const;
 
@@ -367,6 +380,9 @@ public: // functions
   
   /// Signal to store the timings (if enabled) into properties, i.e. for readout from python or the GUI
   void signal_store_timings( SignalArgs& args );
+
+  /// Signal to print the memory used by this component and its children, reduced over all CPUs
+  void signal_print_memory_tree( SignalArgs& args );
   
   /// Signal to remove all sub-components
   void signal_clear( SignalArgs& args );
@@ -383,6 +399,46 @@ public: // functions
   /// marks this component as basic.
   Component& mark_basic();
 
+  /// @name TREE VERSIONING
+  //@{
+
+  /// Current version of the component tree. The version is shared by all components of the process,
+  /// and increases each time a component is added, removed or renamed, or an option is changed.
+  static Uint tree_version();
+
+  /// Increment the tree version
+  /// @return the new version
+  static Uint next_tree_version();
+
+  /// Version of the component paths, shared by all components of the process. It increases each time a component
+  /// is renamed or moved, i.e. whenever the path of existing components may have changed
+  static Uint path_version();
+
+  //@} END TREE VERSIONING
+
+  /// @name QUERY CACHE
+  //@{
+
+  /// Number of structural changes in the subtree below this component, i.e. components that were added,
+  /// removed or renamed, or tags that were added or removed. Can be used to invalidate cached query results.
+  Uint structure_generation() const { return m_structure_generation; }
+
+  /// Subcomponents of the given type, optionally recursive. The list is stored together with the
+  /// structure_generation() it was built for, and returned again as long as the subtree does not change.
+  /// A structural change below a component drops its stored recursive lists, so removed components are
+  /// released right away. Only the types that are actually queried are stored. May be called from several
+  /// threads at once, as long as the tree is not modified at the same time.
+  /// @param [in] recurse If true, recurse through all subcomponents.
+  ///             If false, returns only direct children
+  template<typename ComponentT>
+  boost::shared_ptr< const std::vector< boost::shared_ptr<ComponentT> > > cached_components(const bool recurse);
+
+  /// Subcomponents of the given type, optionally recursive (const version)
+  template<typename ComponentT>
+  boost::shared_ptr< const std::vector< boost::shared_ptr<ComponentT const> > > cached_components(const bool recurse) const;
+
+  //@} END QUERY CACHE
+
   /// Put all subcomponents in a given vector, optionally recursive
   /// @param [out] vec  A vector of all (recursive) subcomponents
   /// @param [in] recurse If true, recurse through all subcomponents.
@@ -403,19 +459,57 @@ protected: // functions
   /// Add a static (sub)component of this component
   Component& add_static_component ( const boost::shared_ptr<Component>& subcomp );
 
+  /// Increments the structure generation of this component and its parents
+  virtual void tags_changed();
+
 private: // helper functions
 
   /// Modify the parent of this component
   void change_parent(Handle<Component> to_parent);
 
+  /// Increment the structure generation of this component and all of its parents, clear the query cache
+  /// of this component and the recursive queries of its parents
+  void structure_changed();
+
+  /// Key for the query cache, consisting of the type of the result vector and the recursion flag
+  struct QueryKey;
+
+  /// Stored list of children for the given key, or a null pointer if there is none for the current structure generation
+  boost::shared_ptr<void> find_cached_query(const QueryKey& key) const;
+
+  /// Store a list of children built for the given structure generation, unless another thread stored one first
+  /// @return the stored list
+  boost::shared_ptr<void> store_cached_query(const QueryKey& key, const Uint generation, const boost::shared_ptr<void>& children) const;
+
   /// insures the sub component has a unique name within this component
   std::string ensure_unique_name ( Component& subcomp );
 
+  /// records the removal of a sub-component, dropping the oldest removal if the log is full
+  void log_removed_component( const std::string& name );
+
+  /// true if all removals of sub-components after the given tree version are still logged
+  bool removals_logged_since( const Uint version ) const { return version >= m_removed_log_start; }
+
   /// writes the underlying component tree to the xml node
   /// @param node            xml node to write
   /// @param put_all_content If @c false, options and properties are not put
   /// in the node.
-  void write_xml_tree( XML::XmlNode& node, bool put_all_content ) const;
+  /// @param depth           Number of levels to write, 0 for all. Nodes with children
+  /// that are not written get the attribute "truncated".
+  void write_xml_tree( XML::XmlNode& node, bool put_all_content, const Uint depth = 0 ) const;
+
+  /// writes the changes to the subcomponents since the given tree version. Subcomponents that
+  /// dropped removals made after that version are written again completely, as if they were added
+  /// @param added    node under which the added subtrees are written, with the path of their parent
+  /// @param changed  node under which the changed options are written, per component
+  /// @param removed  paths of the removed components
+  /// @param version  tree version known by the caller
+  /// @param depth    number of levels written for each added subtree, 0 for all
+  void write_xml_tree_since( XML::XmlNode& added, XML::XmlNode& changed, std::vector<std::string>& removed,
+                             const Uint version, const Uint depth ) const;
+
+  /// writes the options of this component that changed since the given tree version, if any
+  void write_changed_options( XML::XmlNode& changed, const Uint version ) const;
 
   /// Triggered when the "ping" event is raised. Useful to find out what components still exist
   void on_ping_event( SignalArgs& args );
@@ -434,6 +528,31 @@ private: // data
   CompLookupT m_component_lookup;
   /// pointer to parent, naked pointer because of static components
   Component* m_parent;
+  /// tree version at which this component was added to its parent or renamed
+  Uint m_tree_version;
+  /// tree version and name of the removed sub-components, limited to the most recent removals
+  std::vector< std::pair<Uint, std::string> > m_removed_components;
+  /// tree version of the last removal that was dropped from m_removed_components
+  Uint m_removed_log_start;
+  /// see structure_generation()
+  Uint m_structure_generation;
+
+  struct QueryKey
+  {
+    QueryKey(const std::type_info& a_type, const bool a_recurse) : type(&a_type), recurse(a_recurse) {}
+    bool operator<(const QueryKey& other) const
+    {
+      if(recurse != other.recurse)
+        return recurse < other.recurse;
+      return type->before(*other.type);
+    }
+    const std::type_info* type;
+    bool recurse;
+  };
+  /// Cached lists of subcomponents, holding the structure generation they were built for and a std::vector of shared pointers
+  mutable std::map< QueryKey, std::pair< Uint, boost::shared_ptr<void> > > m_query_cache;
+  /// Protects m_query_cache against concurrent queries from threaded loops
+  boost::scoped_ptr<boost::mutex> m_query_cache_mutex;
 
 protected: // functions
 
@@ -487,6 +606,42 @@ void Component::put_components(std::vector< boost::shared_ptr< const ComponentT
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+template<typename ComponentT>
+inline boost::shared_ptr< const std::vector< boost::shared_ptr<ComponentT> > > Component::cached_components(const bool recurse)
+{
+  typedef std::vector< boost::shared_ptr<ComponentT> > VectorT;
+  const QueryKey key(typeid(VectorT), recurse);
+  boost::shared_ptr<void> cached = find_cached_query(key);
+  if(!cached)
+  {
+    const Uint generation = m_structure_generation;
+    boost::shared_ptr<VectorT> vec(new VectorT());
+    put_components<ComponentT>(*vec, recurse);
+    cached = store_cached_query(key, generation, vec);
+  }
+  return boost::static_pointer_cast<const VectorT>(cached);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+template<typename ComponentT>
+inline boost::shared_ptr< const std::vector< boost::shared_ptr<ComponentT const> > > Component::cached_components(const bool recurse) const
+{
+  typedef std::vector< boost::shared_ptr<ComponentT const> > VectorT;
+  const QueryKey key(typeid(VectorT), recurse);
+  boost::shared_ptr<void> cached = find_cached_query(key);
+  if(!cached)
+  {
+    const Uint generation = m_structure_generation;
+    boost::shared_ptr<VectorT> vec(new VectorT());
+    put_components<ComponentT>(*vec, recurse);
+    cached = store_cached_query(key, generation, vec);
+  }
+  return boost::static_pointer_cast<const VectorT>(cached);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 // specialization avoiding the dynamic cast
 template<>
 inline void Component::put_components<Component>(std::vector< boost::shared_ptr<Component> >& vec, const bool recurse)
@@ -12,7 +12,10 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <vector>
+
 #include <boost/iterator/iterator_facade.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <common/Handle.hpp>
 
@@ -50,6 +53,12 @@ public:
   /// at the end of the range, otherwise at the beginning.
   explicit ComponentIterator(const std::vector<boost::shared_ptr<T> >& vec,
                              const Uint startPosition)
+          : m_vec(new std::vector<boost::shared_ptr<T> >(vec)), m_position(startPosition) {}
+
+  /// Construct an iterator over a shared set of components, which must not be modified afterwards.
+  /// Copying the iterator does not copy the set.
+  explicit ComponentIterator(const boost::shared_ptr< const std::vector<boost::shared_ptr<T> > >& vec,
+                             const Uint startPosition)
           : m_vec(vec), m_position(startPosition) {}
 
 private:
@@ -61,7 +70,7 @@ private:
 
   void increment()
   {
-    cf3_assert(m_position != m_vec.size());
+    cf3_assert(m_position != m_vec->size());
     ++m_position;
   }
 
@@ -82,9 +91,9 @@ private:
 public:
 
   /// dereferencing
-  T& dereference() const { return *m_vec[m_position]; }
+  T& dereference() const { return *(*m_vec)[m_position]; }
   /// Get a handle to the referenced object
-  Handle<T> get() const { return Handle<T>(m_vec[m_position]); }
+  Handle<T> get() const { return Handle<T>((*m_vec)[m_position]); }
   /// Compatibility with boost filtered_iterator interface,
   /// so base() can be used transparently on all ranges
   ComponentIterator<T>& base() { return *this; }
@@ -92,7 +101,7 @@ public:
   const ComponentIterator<T>& base() const { return *this; }
 
 private:
-  std::vector<boost::shared_ptr<T> > m_vec;
+  boost::shared_ptr< const std::vector<boost::shared_ptr<T> > > m_vec;
   Uint m_position;
 };
 
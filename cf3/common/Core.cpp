@@ -24,6 +24,7 @@
 
 #include "common/BuildInfo.hpp"
 #include "common/CodeProfiler.hpp"
+#include "common/Timer.hpp"
 #include "common/LibLoader.hpp"
 #include "common/Core.hpp"
 
@@ -106,8 +107,12 @@ void Core::initiate ( int argc, char** argv )
   // initiate the logging facility
   Logger::instance().initiate();
 
+  // map library names to files, so libraries are loaded on first use without searching
+  libraries().read_manifest();
+
   // load libraries listed in the COOLFLUID_PLUGINS environment variable
 
+  Timer timer;
   char* env_var = std::getenv("COOLFLUID_PLUGINS");
   if (env_var != NULL)
   {
@@ -120,10 +125,16 @@ void Core::initiate ( int argc, char** argv )
         OSystem::instance().lib_loader()->load_library(*tok_iter);
   }
 
+  const Real plugins_time = timer.elapsed();
+
   // initiate here all the libraries which the kernel was linked to
 
+  timer.restart();
   libraries().initiate_all_libraries();
 
+  CFdebug << "Startup times: manifest " << libraries().properties().value<Real>("manifest_time")
+          << " s, plugins " << plugins_time << " s, library initiation " << timer.elapsed() << " s" << CFendl;
+
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -12,6 +12,7 @@
 #include <deque>
 #include "common/BasicExceptions.hpp"
 #include "common/Component.hpp"
+#include "common/MemoryComponent.hpp"
 #include "common/StringConversion.hpp"
 #include "common/Foreach.hpp"
 
@@ -28,7 +29,7 @@ class DynArrayBufferT;
 /// Component holding a connectivity table with variable row-size per row
 /// @author Willem Deconinck
 template<typename T>
-class DynTable : public common::Component {
+class DynTable : public common::Component, public common::MemoryComponent {
 
 public:
 
@@ -106,6 +107,15 @@ public:
   /// @return A const reference to the array data
   const ArrayT& array() const { return m_array; }
 
+  /// Bytes allocated for the rows
+  std::size_t memory_footprint() const
+  {
+    std::size_t result = m_array.capacity() * sizeof(std::vector<T>);
+    boost_foreach(const std::vector<T>& row, m_array)
+      result += row.capacity() * sizeof(T);
+    return result;
+  }
+
 private: // data
 
   ArrayT m_array;
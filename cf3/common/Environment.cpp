@@ -9,9 +9,12 @@
 #include "common/Builder.hpp"
 #include "common/LibCommon.hpp"
 #include "common/LogLevel.hpp"
+#include "common/MemoryComponent.hpp"
 #include "common/Log.hpp"
 #include "common/Environment.hpp"
 #include "common/PropertyList.hpp"
+#include "common/ThreadPool.hpp"
+#include "common/Tracer.hpp"
 
 namespace cf3 {
 namespace common {
@@ -102,6 +105,27 @@ Environment::Environment ( const std::string& name) : Component ( name )
       .mark_basic()
       .attach_trigger(boost::bind(&Environment::trigger_log_level,this));
 
+  options().add("nb_threads", 1u)
+      .pretty_name("Number of Threads")
+      .description("Number of threads used by the shared-memory loops of each process")
+      .mark_basic()
+      .attach_trigger(boost::bind(&Environment::trigger_nb_threads,this));
+
+  options().add("trace", false)
+      .pretty_name("Trace")
+      .description("Record a timeline of action executions and communication, to be written by a WriteTrace action")
+      .attach_trigger(boost::bind(&Environment::trigger_trace,this));
+
+  options().add("memory_sampling", false)
+      .pretty_name("Memory Sampling")
+      .description("Record the process memory after each timed action execution, to be printed with print_memory_tree")
+      .attach_trigger(boost::bind(&Environment::trigger_memory_sampling,this));
+
+  options().add("trace_buffer_size", 65536u)
+      .pretty_name("Trace Buffer Size")
+      .description("Number of trace events kept per thread. Older events are overwritten")
+      .attach_trigger(boost::bind(&Environment::trigger_trace_buffer_size,this));
+
   trigger_log_level();
 
   // signals
@@ -180,5 +204,33 @@ void Environment::trigger_log_level()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void Environment::trigger_nb_threads()
+{
+  ThreadPool::instance().set_nb_threads(options().value<Uint>("nb_threads"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Environment::trigger_trace()
+{
+  Tracer::instance().set_enabled(options().value<bool>("trace"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Environment::trigger_memory_sampling()
+{
+  set_memory_sampling(options().value<bool>("memory_sampling"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Environment::trigger_trace_buffer_size()
+{
+  Tracer::instance().set_buffer_size(options().value<Uint>("trace_buffer_size"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // common
 } // cf3
@@ -51,6 +51,14 @@ private: // functions
 
   void trigger_log_level();
 
+  void trigger_nb_threads();
+
+  void trigger_trace();
+
+  void trigger_trace_buffer_size();
+
+  void trigger_memory_sampling();
+
 }; // Environment
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -77,33 +77,27 @@ struct ComponentIteratorSelector {
 template<typename ComponentT, typename ParentT>
 inline typename ComponentIteratorSelector<ParentT,ComponentT>::type component_begin(ParentT& component)
 {
-  std::vector< typename ComponentPtr<ParentT,ComponentT>::type > vec;
-  component.template put_components<ComponentT>(vec, false); // not recursive
-  return typename ComponentIteratorSelector<ParentT,ComponentT>::type(vec, 0); // begin
+  return typename ComponentIteratorSelector<ParentT,ComponentT>::type(component.template cached_components<ComponentT>(false), 0); // begin
 }
 
 template<typename ComponentT, typename ParentT>
 inline typename ComponentIteratorSelector<ParentT,ComponentT>::type component_end(ParentT& component)
 {
-  std::vector< typename ComponentPtr<ParentT,ComponentT>::type > vec;
-  component.template put_components<ComponentT>(vec, false);  // not recursive
-  return typename ComponentIteratorSelector<ParentT,ComponentT>::type(vec, vec.size()); // end
+  const boost::shared_ptr< const std::vector< typename ComponentPtr<ParentT,ComponentT>::type > > vec = component.template cached_components<ComponentT>(false);
+  return typename ComponentIteratorSelector<ParentT,ComponentT>::type(vec, vec->size()); // end
 }
 
 template<typename ComponentT, typename ParentT>
 inline typename ComponentIteratorSelector<ParentT,ComponentT>::type component_recursive_begin(ParentT& component)
 {
-  std::vector< typename ComponentPtr<ParentT,ComponentT>::type > vec;
-  component.template put_components<ComponentT>(vec, true); // recursive
-  return typename ComponentIteratorSelector<ParentT,ComponentT>::type(vec, 0); // begin
+  return typename ComponentIteratorSelector<ParentT,ComponentT>::type(component.template cached_components<ComponentT>(true), 0); // begin
 }
 
 template<typename ComponentT, typename ParentT>
 inline typename ComponentIteratorSelector<ParentT,ComponentT>::type component_recursive_end(ParentT& component)
 {
-  std::vector< typename ComponentPtr<ParentT,ComponentT>::type > vec;
-  component.template put_components<ComponentT>(vec, true); // recursive
-  return typename ComponentIteratorSelector<ParentT,ComponentT>::type(vec, vec.size()); // end
+  const boost::shared_ptr< const std::vector< typename ComponentPtr<ParentT,ComponentT>::type > > vec = component.template cached_components<ComponentT>(true);
+  return typename ComponentIteratorSelector<ParentT,ComponentT>::type(vec, vec->size()); // end
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -141,16 +135,16 @@ public:
 class IsComponentTag
 {
 private:
-  std::string m_tag;
+  Uint m_tag_id;
 public:
-  IsComponentTag () : m_tag("Component") {}
-  IsComponentTag (StringConverter tag) : m_tag(tag) {}
+  IsComponentTag () : m_tag_id(TaggedObject::tag_id("Component")) {}
+  IsComponentTag (StringConverter tag) : m_tag_id(TaggedObject::tag_id(tag.str())) {}
 
   bool operator()(const Handle<Component const>& component) const
-  { return boost::bind( &Component::has_tag , _1 , m_tag )(component.get()); }
+  { return component->has_tag(m_tag_id); }
 
   bool operator()(const Component& component) const
-  { return boost::bind( &Component::has_tag , _1 , m_tag )(component); }
+  { return component.has_tag(m_tag_id); }
 
 };
 
@@ -435,6 +429,17 @@ make_filtered_range(const ComponentIterator<T>& from, const ComponentIterator<T>
   return ComponentIteratorRange<T,IsComponentTrue>(from,to,IsComponentTrue());
 }
 
+/// Range over all subcomponents of type ComponentT, recursively. The begin and end
+/// iterators share a single list, so the tree is walked only once
+template <typename ComponentT, typename ParentT, typename Predicate>
+inline typename ComponentIteratorRangeSelector<ParentT, ComponentT, Predicate>::type
+make_recursive_range(ParentT& parent, const Predicate& pred)
+{
+  typedef typename ComponentIteratorSelector<ParentT,ComponentT>::type IteratorT;
+  const boost::shared_ptr< const std::vector< typename ComponentPtr<ParentT,ComponentT>::type > > vec = parent.template cached_components<ComponentT>(true);
+  return make_filtered_range(IteratorT(vec, 0), IteratorT(vec, vec->size()), pred);
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
 
@@ -529,21 +534,21 @@ find_components_with_tag(ParentT& parent, StringConverter tag)
 inline ComponentIteratorRangeSelector<Component, Component>::type
 find_components_recursively(Component& parent)
 {
-  return make_filtered_range(parent.recursive_begin(),parent.recursive_end());
+  return make_recursive_range<Component>(parent, IsComponentTrue());
   // return boost::make_iterator_range(component_recursive_begin(parent),component_recursive_end(parent));
 }
 
 inline ComponentIteratorRangeSelector<Component const, Component>::type
 find_components_recursively(const Component& parent)
 {
-  return make_filtered_range(parent.recursive_begin(),parent.recursive_end());
+  return make_recursive_range<Component>(parent, IsComponentTrue());
 }
 
 template <typename ComponentT, typename ParentT>
 inline typename ComponentIteratorRangeSelector<ParentT, ComponentT>::type
 find_components_recursively(ParentT& parent)
 {
-  return make_filtered_range(component_recursive_begin<ComponentT>(parent),component_recursive_end<ComponentT>(parent));
+  return make_recursive_range<ComponentT>(parent, IsComponentTrue());
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -552,28 +557,28 @@ template <typename Predicate>
 inline typename ComponentIteratorRangeSelector<Component, Component, Predicate>::type
 find_components_recursively_with_filter(Component& parent, const Predicate& pred)
 {
-  return make_filtered_range(parent.recursive_begin(),parent.recursive_end(),pred);
+  return make_recursive_range<Component>(parent, pred);
 }
 
 template <typename Predicate>
 inline typename ComponentIteratorRangeSelector<Component const, Component, Predicate>::type
 find_components_recursively_with_filter(const Component& parent, const Predicate& pred)
 {
-  return make_filtered_range(parent.recursive_begin(),parent.recursive_end(),pred);
+  return make_recursive_range<Component>(parent, pred);
 }
 
 template <typename ComponentT, typename Predicate>
 inline typename ComponentIteratorRangeSelector<Component, ComponentT, Predicate>::type
 find_components_recursively_with_filter(Component& parent, const Predicate& pred)
 {
-  return make_filtered_range(component_recursive_begin<ComponentT>(parent),component_recursive_end<ComponentT>(parent),pred);
+  return make_recursive_range<ComponentT>(parent, pred);
 }
 
 template <typename ComponentT, typename Predicate>
 inline typename ComponentIteratorRangeSelector<Component const, ComponentT, Predicate>::type
 find_components_recursively_with_filter(const Component& parent, const Predicate& pred)
 {
-  return make_filtered_range(component_recursive_begin<ComponentT>(parent),component_recursive_end<ComponentT>(parent),pred);
+  return make_recursive_range<ComponentT>(parent, pred);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -52,6 +52,13 @@ void LibLoader::unload_library( Library& lib )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+std::string LibLoader::common_library_dir() const
+{
+  return std::string();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // common
 } // cf3
 
@@ -62,6 +62,9 @@ public: // methods
   ///
   virtual void set_search_paths(const std::vector< URI >& paths) = 0;
 
+  /// Directory of the loaded coolfluid_common library, or an empty string if the system can't tell
+  virtual std::string common_library_dir() const;
+
   /// Gets the Class name
   static std::string type_name() { return "LibLoader"; }
 
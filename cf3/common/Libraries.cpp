@@ -4,9 +4,16 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <coolfluid-paths.hpp>
 
 #include "common/Log.hpp"
 #include "common/Signal.hpp"
@@ -19,6 +26,9 @@
 #include "common/Foreach.hpp"
 #include "common/FindComponents.hpp"
 #include "common/PropertyList.hpp"
+#include "common/Timer.hpp"
+
+#include "common/PE/Comm.hpp"
 
 #include "common/XML/SignalOptions.hpp"
 #include "common/XML/SignalFrame.hpp"
@@ -52,6 +62,12 @@ Libraries::Libraries ( const std::string& name) : Component ( name )
     .description("Autoload library given namespace")
     .pretty_name("Load");
 
+  // Manifest that was looked up last, and startup timings, in seconds
+  properties().add("manifest", std::string());
+  properties().add("manifest_time", Real(0.));
+  properties().add("autoload_time", Real(0.));
+  properties().add("nb_autoloaded", Uint(0));
+
   signal("create_component")->hidden(true);
   signal("rename_component")->hidden(true);
   signal("move_component")->hidden(true);
@@ -109,10 +125,16 @@ Handle<Library> Libraries::autoload_library_with_namespace( const std::string& l
 
   const std::string lib_name = namespace_to_libname( libnamespace );
 
+  // A library in the manifest is loaded using its full path, avoiding the search over all paths
+  const std::string lib_path = manifest_path( lib_name );
+
   try // to auto-load in case builder not there
   {
-    CFdebug << "Auto-loading plugin " << lib_name << CFendl;
-    OSystem::instance().lib_loader()->load_library(lib_name);
+    CFdebug << "Auto-loading plugin " << lib_name << (lib_path.empty() ? "" : " from " + lib_path) << CFendl;
+    Timer timer;
+    OSystem::instance().lib_loader()->load_library(lib_path.empty() ? lib_name : lib_path);
+    properties()["autoload_time"] = properties().value<Real>("autoload_time") + timer.elapsed();
+    properties()["nb_autoloaded"] = properties().value<Uint>("nb_autoloaded") + 1u;
     Handle<Library> lib(get_child( libnamespace ));
     cf3_assert( is_not_null(lib) );
     return lib;
@@ -126,6 +148,117 @@ Handle<Library> Libraries::autoload_library_with_namespace( const std::string& l
 
 ////////////////////////////////////////////////////////////////////////////////
 
+bool Libraries::read_manifest( const URI& file )
+{
+  Timer timer;
+
+  // Read the file on rank 0 only, to avoid all ranks accessing the file system. The buffer holds the path of the manifest
+  // on the first line, followed by its contents, which are empty if no manifest was found
+  PE::Comm& comm = PE::Comm::instance();
+  const bool broadcast = comm.is_active() && comm.size() > 1;
+  std::vector<char> buffer;
+  if( !broadcast || comm.rank() == 0 )
+  {
+    // An explicit file or environment variable is used as given. Otherwise the manifest is looked up next to the loaded
+    // coolfluid_common library, which is right for the build tree as well as for an installation. If the system can't tell
+    // where that library is, the build tree is tried before the install prefix, since an installation doesn't
+    // remove the build tree but running from the build tree must not pick up an older installation
+    std::vector<boost::filesystem::path> candidates;
+    const char* env_var = std::getenv("COOLFLUID_LIBRARY_MANIFEST");
+    if( !file.empty() )
+    {
+      candidates.push_back( file.path() );
+    }
+    else if( env_var != NULL )
+    {
+      candidates.push_back( env_var );
+    }
+    else
+    {
+      const std::string common_library_dir = OSystem::instance().lib_loader()->common_library_dir();
+      if( !common_library_dir.empty() )
+        candidates.push_back( boost::filesystem::path(common_library_dir) / manifest_filename() );
+      candidates.push_back( boost::filesystem::path(CF3_BUILD_DIR) / "dso" / manifest_filename() );
+      candidates.push_back( boost::filesystem::path(CF3_INSTALL_LIB_PATH) / manifest_filename() );
+    }
+
+    boost::filesystem::path manifest_file = candidates.back();
+    boost_foreach( const boost::filesystem::path& candidate, candidates )
+    {
+      if( boost::filesystem::exists( candidate ) )
+      {
+        manifest_file = candidate;
+        break;
+      }
+    }
+
+    const std::string path_line = manifest_file.string() + "\n";
+    buffer.assign( path_line.begin(), path_line.end() );
+    std::ifstream input( manifest_file.string().c_str() );
+    if( input.is_open() )
+    {
+      buffer.insert( buffer.end(), std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() );
+      buffer.push_back('\n');
+    }
+  }
+
+  if( broadcast )
+  {
+    std::vector<char> received;
+    comm.broadcast( buffer, received, 0 );
+    buffer.swap( received );
+  }
+
+  // All ranks resolve relative library paths against the directory of the manifest that rank 0 read
+  const std::vector<char>::iterator path_end = std::find( buffer.begin(), buffer.end(), '\n' );
+  const boost::filesystem::path manifest_file( std::string( buffer.begin(), path_end ) );
+  const std::string contents( path_end == buffer.end() ? path_end : path_end + 1, buffer.end() );
+
+  properties()["manifest"] = manifest_file.string();
+  if( contents.empty() )
+  {
+    CFdebug << "No library manifest found at " << manifest_file.string() << CFendl;
+    properties()["manifest_time"] = timer.elapsed();
+    return false;
+  }
+
+  // Each line holds a library name and its file, relative to the directory of the manifest
+  const boost::filesystem::path manifest_dir = manifest_file.parent_path();
+  std::istringstream lines( contents );
+  std::string line;
+  while( std::getline( lines, line ) )
+  {
+    boost::trim( line );
+    if( line.empty() || line[0] == '#' )
+      continue;
+
+    std::istringstream fields( line );
+    std::string lib_name, lib_file;
+    fields >> lib_name >> lib_file;
+    if( lib_file.empty() )
+      throw ParsingFailed( FromHere(), "Invalid line in library manifest " + manifest_file.string() + ": " + line );
+
+    boost::filesystem::path lib_path( lib_file );
+    if( !lib_path.is_absolute() )
+      lib_path = manifest_dir / lib_path;
+    m_manifest[lib_name] = lib_path.string();
+  }
+
+  properties()["manifest_time"] = timer.elapsed();
+  CFdebug << "Read " << m_manifest.size() << " libraries from manifest " << manifest_file.string() << CFendl;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::string Libraries::manifest_path( const std::string& lib_name ) const
+{
+  const std::map<std::string, std::string>::const_iterator it = m_manifest.find( lib_name );
+  return it == m_manifest.end() ? std::string() : it->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 Handle<Library> Libraries::autoload_library_with_builder( const std::string& builder_name )
 {
   return autoload_library_with_namespace(Builder::extract_namespace( builder_name ));
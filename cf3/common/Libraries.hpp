@@ -9,6 +9,8 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+#include <map>
+
 #include "common/BasicExceptions.hpp"
 #include "common/Component.hpp"
 
@@ -91,6 +93,21 @@ public: // functions
   /// @throws ValueNotFound in case of library not able to be loaded
   Handle<Library> autoload_library_with_namespace( const std::string& libnamespace );
 
+  /// Name of the manifest file that is written to the library directory when configuring the build
+  static std::string manifest_filename() { return "coolfluid-libraries.manifest"; }
+
+  /// Reads the manifest that maps library names to library files, so autoloading a library takes a single dlopen
+  /// instead of a search over all paths. If the parallel environment is active, only rank 0 reads the file and broadcasts
+  /// its path and contents, so in that case this must be called on all ranks and the file argument only matters on rank 0.
+  /// @param [in] file The manifest to read. If empty, the file given by the COOLFLUID_LIBRARY_MANIFEST environment variable
+  ///                  is used, or else the manifest next to the loaded coolfluid_common library, falling back to the one in
+  ///                  the build directory and then the installed library directory. The path that was used is stored in the "manifest" property
+  /// @return true if a manifest was read
+  bool read_manifest( const URI& file = URI() );
+
+  /// Full path of the file for the given library name (e.g. coolfluid_mesh), or an empty string if it is not in the manifest
+  std::string manifest_path( const std::string& lib_name ) const;
+
   /// @name SIGNALS
   //@{
 
@@ -106,6 +123,11 @@ public: // functions
 
   //@} END SIGNALS
 
+private:
+
+  /// Maps library names to the full path of the library file
+  std::map<std::string, std::string> m_manifest;
+
 }; // Libraries
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -8,9 +8,11 @@
 #include <cstdlib>       // for free() and abort()
 #include <csignal>       // POSIX signal(), SIGFPE and SIGSEGV
 #include <fenv.h>        // floating Common access
+#include <algorithm>     // for std::max
 #include <sstream>       // streamstring
 #include <execinfo.h>    // for backtrace() from glibc
 #include <sys/types.h>   // for getting the PID of the process
+#include <sys/resource.h> // for getrusage()
 #include <malloc.h>      //  for mallinfo
 
 
@@ -209,6 +211,35 @@ double OSystemLayer::memory_usage() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+double OSystemLayer::resident_memory() const
+{
+  // The counters of mallinfo are int and overflow above 2GB, the page counts in statm do not
+  double result = 0.;
+  FILE* pf = fopen("/proc/self/statm", "r");
+  if (pf)
+  {
+    unsigned long size;
+    unsigned long resident;
+    if (fscanf(pf, "%lu %lu", &size, &resident) == 2)
+      result = static_cast<double>(resident) * static_cast<double>(sysconf(_SC_PAGESIZE));
+    fclose(pf);
+  }
+  return result > 0. ? result : memory_usage();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+double OSystemLayer::peak_resident_memory() const
+{
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0.;
+  // ru_maxrss is in kilobytes on Linux. The kernel updates it lazily, so it may lag behind the current usage
+  return std::max(static_cast<double>(usage.ru_maxrss) * 1024., resident_memory());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void OSystemLayer::regist_os_signal_handlers()
 {
   // register handler functions for the signals
@@ -52,6 +52,12 @@ public:
   /// @return a double with the memory usage
   virtual double memory_usage() const;
 
+  /// Resident set size, read from /proc/self/statm
+  virtual double resident_memory() const;
+
+  /// Peak resident set size, as reported by getrusage
+  virtual double peak_resident_memory() const;
+
   /// Regists the signal handlers that will be handled by this class
   virtual void regist_os_signal_handlers();
 
@@ -10,6 +10,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "common/Component.hpp"
+#include "common/MemoryComponent.hpp"
 #include "common/ListBufferT.hpp"
 
 //////////////////////////////////////////////////////////////////////////////
@@ -37,7 +38,7 @@ namespace common {
 /// @author Tiago Quintino
 
 template <typename ValueT>
-class List : public common::Component
+class List : public common::Component, public common::MemoryComponent
 {
 public: // typedefs
 
@@ -110,6 +111,12 @@ public: // functions
   /// @return The number of local rows in the array
   Uint size() const { return m_array.size(); }
 
+  /// Bytes used by the array
+  std::size_t memory_footprint() const
+  {
+    return m_array.num_elements() * sizeof(ValueT);
+  }
+
 private: // data
 
   /// storage of the array
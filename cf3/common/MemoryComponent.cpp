@@ -0,0 +1,239 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+
+#include "common/Component.hpp"
+#include "common/ComponentIterator.hpp"
+#include "common/Foreach.hpp"
+#include "common/Log.hpp"
+#include "common/MemoryComponent.hpp"
+#include "common/OSystem.hpp"
+#include "common/OSystemLayer.hpp"
+#include "common/PropertyList.hpp"
+#include "common/TimedComponent.hpp"
+
+#include "common/PE/Comm.hpp"
+#include "common/PE/operations.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+
+bool& memory_sampling_flag()
+{
+  static bool enabled = false;
+  return enabled;
+}
+
+/// Memory statistics of one component, over all CPUs
+struct MemoryStatistics
+{
+  Real total;
+  Real min;
+  Real max;
+  Real sampled_maximum;
+  Real sampled_increase;
+};
+
+typedef std::map<const Component*, MemoryStatistics> MemoryStatisticsMap;
+
+/// Depth-first list of all components, with the footprint of the subtree starting at each of them.
+/// Returns the footprint of root
+std::size_t collect_footprints(const Component& root, std::vector<const Component*>& components, std::vector<Real>& footprints)
+{
+  const Uint idx = components.size();
+  components.push_back(&root);
+  footprints.push_back(0.);
+
+  const MemoryComponent* memory_comp = dynamic_cast<const MemoryComponent*>(&root);
+  std::size_t result = is_null(memory_comp) ? 0 : memory_comp->memory_footprint();
+  BOOST_FOREACH(const Component& component, root)
+  {
+    result += collect_footprints(component, components, footprints);
+  }
+  footprints[idx] = static_cast<Real>(result);
+  return result;
+}
+
+/// Reduce the memory statistics of all components over all CPUs at once, gathering them on rank 0.
+/// Returns false if the component paths differ between the CPUs, in which case only local statistics are computed
+bool reduce_memory(Component& root, MemoryStatisticsMap& statistics)
+{
+  std::vector<const Component*> components;
+  std::vector<Real> footprints;
+  collect_footprints(root, components, footprints);
+  const Uint nb_components = components.size();
+
+  const Uint stride = 3;
+  std::vector<Real> local_stats(nb_components*stride);
+  for(Uint i = 0; i != nb_components; ++i)
+  {
+    const PropertyList& props = components[i]->properties();
+    local_stats[i*stride+0] = footprints[i];
+    local_stats[i*stride+1] = props.check("sampled_memory_maximum") ? props.value<Real>("sampled_memory_maximum") : 0.;
+    local_stats[i*stride+2] = props.check("sampled_memory_increase") ? props.value<Real>("sampled_memory_increase") : 0.;
+  }
+
+  bool parallel = PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1;
+  bool same_trees = true;
+  if(parallel)
+  {
+    // The statistics are matched by position, so the trees must have the same components in the same order
+    std::size_t tree_hash = 0;
+    boost::hash_combine(tree_hash, nb_components);
+    for(Uint i = 0; i != nb_components; ++i)
+      boost::hash_combine(tree_hash, components[i]->uri().path());
+
+    std::size_t min_hash = 0;
+    std::size_t max_hash = 0;
+    PE::Comm::instance().all_reduce(PE::min(), &tree_hash, 1, &min_hash);
+    PE::Comm::instance().all_reduce(PE::max(), &tree_hash, 1, &max_hash);
+    same_trees = min_hash == max_hash;
+    parallel = same_trees;
+  }
+
+  const Uint nb_procs = parallel ? PE::Comm::instance().size() : 1;
+  std::vector<Real> all_stats;
+  if(parallel)
+    PE::Comm::instance().gather(local_stats, all_stats, 0);
+  else
+    all_stats = local_stats;
+
+  if(parallel && PE::Comm::instance().rank() != 0)
+    return same_trees;
+
+  for(Uint i = 0; i != nb_components; ++i)
+  {
+    MemoryStatistics& result = statistics[components[i]];
+    result.total = 0.;
+    result.min = all_stats[i*stride];
+    result.max = all_stats[i*stride];
+    result.sampled_maximum = 0.;
+    result.sampled_increase = 0.;
+    for(Uint proc = 0; proc != nb_procs; ++proc)
+    {
+      const Real* proc_stats = &all_stats[(proc*nb_components + i)*stride];
+      result.total += proc_stats[0];
+      result.min = std::min(result.min, proc_stats[0]);
+      result.max = std::max(result.max, proc_stats[0]);
+      result.sampled_maximum = std::max(result.sampled_maximum, proc_stats[1]);
+      result.sampled_increase = std::max(result.sampled_increase, proc_stats[2]);
+    }
+  }
+
+  return same_trees;
+}
+
+void print_memory_tree(const Component& root, const std::string& prefix, const bool parallel, const Uint nb_procs, const MemoryStatisticsMap& statistics)
+{
+  const MemoryStatisticsMap::const_iterator found = statistics.find(&root);
+  if(found == statistics.end())
+    return;
+
+  const MemoryStatistics& stats = found->second;
+  if(stats.total == 0. && stats.sampled_maximum == 0.)
+    return;
+
+  const Real megabyte = 1024.*1024.;
+  std::cout << prefix << root.name() << ": ";
+  if(parallel)
+  {
+    // The imbalance is the ratio between the largest CPU and the average over all CPUs
+    const Real mean = stats.total / static_cast<Real>(nb_procs);
+    std::cout << "total: " << stats.total / megabyte
+      << ", min: " << stats.min / megabyte
+      << ", max: " << stats.max / megabyte
+      << ", imbalance: " << (mean > 0. ? stats.max / mean : 1.);
+  }
+  else
+  {
+    std::cout << stats.total / megabyte;
+  }
+  if(stats.sampled_maximum > 0.)
+    std::cout << ", sampled process maximum: " << stats.sampled_maximum / megabyte << ", sampled increase: " << stats.sampled_increase / megabyte;
+  std::cout << "\n";
+
+  BOOST_FOREACH(const Component& component, root)
+  {
+    print_memory_tree(component, prefix + "  ", parallel, nb_procs, statistics);
+  }
+}
+
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+std::size_t memory_footprint(const Component& root)
+{
+  std::vector<const Component*> components;
+  std::vector<Real> footprints;
+  return detail::collect_footprints(root, components, footprints);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void print_memory_tree(Component& root, const std::string& prefix)
+{
+  if(memory_sampling())
+    store_timings(root);
+
+  // All statistics are reduced in a single collective operation, and only printed by rank 0
+  detail::MemoryStatisticsMap statistics;
+  const bool same_trees = detail::reduce_memory(root, statistics);
+
+  // The peak reported by the operating system also covers memory that was allocated and released between samples
+  const Real local_peak = OSystem::instance().layer()->peak_resident_memory();
+  Real peak = local_peak;
+  const bool reduce_peak = PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1;
+  if(reduce_peak)
+    PE::Comm::instance().all_reduce(PE::max(), &local_peak, 1, &peak);
+
+  const bool parallel = PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1 && same_trees;
+  if(!same_trees)
+    CFwarn << "Component tree below " << root.uri().path() << " differs between CPUs, printing the memory of each CPU separately" << CFendl;
+  else if(parallel && PE::Comm::instance().rank() != 0)
+    return;
+
+  std::cout << "<DartMeasurement name=\"Memory\" type=\"text/plain\"><![CDATA[<html><body><pre>\n";
+  if(parallel)
+    std::cout << "Memory in MB, with [total, min, max] over CPUs\n";
+  else
+    std::cout << "Memory in MB\n";
+  detail::print_memory_tree(root, prefix, parallel, parallel ? PE::Comm::instance().size() : 1, statistics);
+  if(peak > 0.)
+    std::cout << "Peak resident memory of the process" << (reduce_peak ? " (max over CPUs)" : "") << ": " << peak / (1024.*1024.) << "\n";
+  std::cout << "</pre></body></html>]]></DartMeasurement>" << std::endl;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void set_memory_sampling(const bool enabled)
+{
+  detail::memory_sampling_flag() = enabled;
+}
+
+bool memory_sampling()
+{
+  return detail::memory_sampling_flag();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+/////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,53 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_MemoryComponent_hpp
+#define cf3_common_MemoryComponent_hpp
+
+#include <cstddef>
+#include <string>
+
+#include "common/CommonAPI.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+class Component;
+
+/// Pure virtual interface for components that hold a significant amount of data
+class Common_API MemoryComponent
+{
+public:
+  virtual ~MemoryComponent() {}
+
+  /// Number of bytes of data owned by this component, excluding its children.
+  /// Implementations may estimate the size of data held by external libraries
+  virtual std::size_t memory_footprint() const = 0;
+};
+
+/// Number of bytes owned by the given component and all of its children
+Common_API std::size_t memory_footprint(const Component& root);
+
+/// Print the memory held by each component, summed over its children. Components without data are skipped.
+/// If memory sampling is enabled, the resident memory of the process sampled after each timed action is printed as well.
+/// The true peak of the process, as reported by the operating system, is printed at the end.
+/// In parallel, the statistics of all components are gathered on rank 0 in a single collective operation
+Common_API void print_memory_tree(Component& root, const std::string& prefix="");
+
+/// Turn recording of the resident memory of the process before and after each timed action execution on or off.
+/// The largest sampled value and the largest increase during an execution are stored in the properties
+/// sampled_memory_maximum and sampled_memory_increase by store_timings
+Common_API void set_memory_sampling(const bool enabled);
+
+/// True if the process memory is recorded for each timed action
+Common_API bool memory_sampling();
+
+}
+}
+
+#endif // cf3_common_MemoryComponent_hpp
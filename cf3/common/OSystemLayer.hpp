@@ -60,6 +60,14 @@ public: // functions
   /// @return a double with the memory usage in bytes
   virtual cf3::Real memory_usage () const = 0;
 
+  /// Gets the physical memory used by the process (the resident set size)
+  /// @return the resident memory in bytes. Platforms that do not report it return memory_usage()
+  virtual cf3::Real resident_memory () const { return memory_usage(); }
+
+  /// Gets the largest physical memory used by the process since it started
+  /// @return the peak resident memory in bytes, or zero if the platform does not report it
+  virtual cf3::Real peak_resident_memory () const { return 0.; }
+
   /// @returns a string with the memory usage
   /// @post adds the unit of memory (B, KB, MB or GB)
   /// @post  no end of line added
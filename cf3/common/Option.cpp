@@ -7,6 +7,7 @@
 
 #include <boost/function.hpp>
 #include "common/BasicExceptions.hpp"
+#include "common/Component.hpp"
 #include "common/Foreach.hpp"
 #include "common/Option.hpp"
 #include "common/XML/XmlNode.hpp"
@@ -23,8 +24,12 @@ Option::Option(const std::string & name, boost::any def)
     m_pretty_name(),
     m_description(),
     m_separator(","),
-    m_current_connection_id(0)
+    m_current_connection_id(0),
+    m_version(Component::tree_version() + 1)
 {
+  // Creating an option does not change the tree, so temporary options (e.g. in signal frames) keep the
+  // version unchanged. An option added to an existing component is newer than the current version,
+  // so it is listed until the next change to the tree
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -79,8 +84,7 @@ Option& Option::operator =( const boost::any & new_value )
 
 Option& Option::mark_basic()
 {
-  if(!has_tag("basic"))
-    add_tag("basic");
+  add_tag("basic"); // does nothing if the tag is already there
   return *this;
 }
 
@@ -89,6 +93,7 @@ Option& Option::mark_basic()
 void Option::change_value ( const boost::any& value )
 {
   change_value_impl(value);
+  m_version = Component::next_tree_version();
   copy_to_linked_params(m_linked_params);
   // call all trigger functors
   trigger();
@@ -97,6 +102,14 @@ void Option::change_value ( const boost::any& value )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void Option::restore_default()
+{
+  m_value = m_default;
+  m_version = Component::next_tree_version();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 Option& Option::link_option ( const boost::shared_ptr<common::Option>& linked )
 {
   m_linked_opts.push_back( Handle<Option>(linked) );
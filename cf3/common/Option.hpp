@@ -232,7 +232,10 @@ namespace XML { class XmlNode; }
     void trigger() const;
 
     /// restore the default value of the option
-    void restore_default() { m_value = m_default; }
+    void restore_default();
+
+    /// Tree version at which the value of this option last changed, see Component::tree_version()
+    Uint version() const { return m_version; }
 
   protected:
     /// storage of the value of the option
@@ -261,6 +264,9 @@ namespace XML { class XmlNode; }
     /// Current connection ID for the triggers
     Uint m_current_connection_id;
 
+    /// Tree version at which the option was created or last changed
+    Uint m_version;
+
   private: // function
 
     /// copy the configured update value to all linked parameters
@@ -7,6 +7,7 @@
 #include "common/Log.hpp"
 
 #include "common/BasicExceptions.hpp"
+#include "common/Tracer.hpp"
 #include "common/PE/Comm.hpp"
 
 //#include "common/PE/debug.hpp"
@@ -20,6 +21,8 @@ namespace PE {
 Comm::Comm(int argc, char** args)
 {
   m_comm = nullptr;
+  m_world_comm = nullptr;
+  m_color = 0;
   init(argc,args);
   m_current_status=WorkerStatus::NOT_RUNNING;
 }
@@ -29,6 +32,8 @@ Comm::Comm(int argc, char** args)
 Comm::Comm()
 {
   m_comm = nullptr;
+  m_world_comm = nullptr;
+  m_color = 0;
   m_current_status = WorkerStatus::NOT_RUNNING;
 }
 
@@ -88,7 +93,10 @@ void Comm::init(int argc, char** args)
     //  CFinfo << "MPI (version " <<  version() << ") -- initiated" << CFendl;
   }
 
-  m_comm = MPI_COMM_WORLD;
+  // Keep the group communicator if init is called again after a split
+  if( !is_split() )
+    m_comm = MPI_COMM_WORLD;
+  m_world_comm = MPI_COMM_WORLD;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -97,11 +105,13 @@ void Comm::finalize()
 {
   if( is_initialized() && !is_finalized() ) // then finalized
   {
+    merge();
     MPI_CHECK_RESULT(MPI_Finalize,());
     //  CFinfo << "MPI (version " <<  version() << ") -- finalized" << CFendl;
   }
 
   m_comm = nullptr;
+  m_world_comm = nullptr;
 
 //    boost::this_thread::sleep(boost::posix_time::milliseconds(100));
 //    int is_mpi_finalized;
@@ -117,7 +127,7 @@ void Comm::finalize()
 
 void Comm::barrier()
 {
-  if ( is_active() ) MPI_CHECK_RESULT(MPI_Barrier,(m_comm));
+  if ( is_active() ) barrier(m_comm);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -126,7 +136,12 @@ void Comm::barrier( Communicator comm )
 {
   cf3_assert( comm != MPI_COMM_NULL );
 
-  if ( is_active() ) MPI_CHECK_RESULT(MPI_Barrier,(comm));
+  if ( is_active() )
+  {
+    static const Uint wait_trace_name = Tracer::instance().register_name("MPI wait: barrier");
+    TraceScope wait_trace(wait_trace_name);
+    MPI_CHECK_RESULT(MPI_Barrier,(comm));
+  }
 
 }
 
@@ -208,6 +223,89 @@ Communicator Comm::get_parent() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void Comm::split(const int color)
+{
+  if( !is_active() )
+    throw SetupError( FromHere(), "Comm::split() requires an initialized parallel environment" );
+  if( color < 0 )
+    throw BadValue( FromHere(), "Color for Comm::split() must be positive or zero, got " + to_str(color) );
+
+  merge();
+
+  int world_rank, world_size;
+  MPI_CHECK_RESULT(MPI_Comm_rank,(m_world_comm,&world_rank));
+  MPI_CHECK_RESULT(MPI_Comm_size,(m_world_comm,&world_size));
+
+  std::vector<int> colors(world_size);
+  int my_color = color;
+  MPI_CHECK_RESULT(MPI_Allgather,(&my_color, 1, MPI_INT, &colors[0], 1, MPI_INT, m_world_comm));
+  for(int i = 0; i != world_size; ++i)
+    m_groups[colors[i]].push_back(i);
+
+  // Ranks within each group keep the order of the world ranks
+  Communicator group_comm;
+  MPI_CHECK_RESULT(MPI_Comm_split,(m_world_comm, color, world_rank, &group_comm));
+  m_comm = group_comm;
+  m_color = color;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Comm::merge()
+{
+  if( !is_split() )
+    return;
+
+  if( is_initialized() && !is_finalized() )
+    MPI_CHECK_RESULT(MPI_Comm_free,(&m_comm));
+
+  m_comm = m_world_comm;
+  m_color = 0;
+  m_groups.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint Comm::world_rank() const
+{
+  if ( !is_active() ) return 0;
+  int irank;
+  MPI_CHECK_RESULT(MPI_Comm_rank,(m_world_comm,&irank));
+  return static_cast<Uint>(irank);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint Comm::world_size() const
+{
+  if ( !is_active() ) return 1;
+  int nproc;
+  MPI_CHECK_RESULT(MPI_Comm_size,(m_world_comm,&nproc));
+  return static_cast<Uint>(nproc);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::vector<int> Comm::group_world_ranks(const int color) const
+{
+  if( !is_split() )
+  {
+    if( color != 0 )
+      throw ValueNotFound( FromHere(), "No process group with color " + to_str(color) + ", the processes were not split" );
+    std::vector<int> result(world_size());
+    for(Uint i = 0; i != result.size(); ++i)
+      result[i] = static_cast<int>(i);
+    return result;
+  }
+
+  std::map< int, std::vector<int> >::const_iterator group = m_groups.find(color);
+  if( group == m_groups.end() )
+    throw ValueNotFound( FromHere(), "No process group with color " + to_str(color) );
+  return group->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // namespace PE
 } // namespace common
 } // namespace cf3
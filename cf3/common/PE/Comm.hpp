@@ -10,6 +10,9 @@
 
 #include <mpi.h>
 
+#include <map>
+#include <vector>
+
 #include "common/StringConversion.hpp"
 #include "common/WorkerStatus.hpp"
 
@@ -122,6 +125,33 @@ public:
   /// Gets the parent COMM_WORLD of the process
   Communicator get_parent() const;
 
+  /// Split the processes into disjoint groups, so coupled solvers can run concurrently on their own processes.
+  /// Afterwards, communicator(), rank() and size() refer to the group of processes with the same color, so
+  /// all code using the default communicator runs independently in each group. Collective over all processes.
+  /// @param color Processes with the same color end up in the same group. Must be positive or zero.
+  void split(const int color);
+
+  /// Undo a split, so the default communicator spans all processes again. Collective over all processes.
+  void merge();
+
+  /// True if split was called
+  bool is_split() const { return m_comm != m_world_comm; }
+
+  /// Color of the group of this process, 0 if not split
+  int color() const { return m_color; }
+
+  /// @returns the communicator spanning all processes, regardless of any split
+  Communicator world_communicator() { cf3_assert( is_active() ); return m_world_comm; }
+
+  /// Rank in the world communicator, 0 if not active
+  Uint world_rank() const;
+
+  /// Number of processes in the world communicator, 1 if not active
+  Uint world_size() const;
+
+  /// World ranks of the processes in the group with the given color
+  std::vector<int> group_world_ranks(const int color) const;
+
   /// @name Collective all_to_all operations
   //@{
 
@@ -324,7 +354,13 @@ private:
 
   Comm(); ///< private constructor
 
-  Communicator m_comm; ///< comm_world
+  Communicator m_comm; ///< comm_world, or the communicator of the group after a split
+
+  Communicator m_world_comm; ///< comm_world, also after a split
+
+  int m_color; ///< Color passed to split
+
+  std::map< int, std::vector<int> > m_groups; ///< World ranks for each color
 
   WorkerStatus::Type m_current_status; ///< Current status, default value is @c #NOT_RUNNING.
 
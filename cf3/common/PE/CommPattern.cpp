@@ -13,6 +13,7 @@
 #include "common/FindComponents.hpp"
 #include "common/Builder.hpp"
 #include "common/Log.hpp"
+#include "common/Tracer.hpp"
 
 #include "common/PE/Comm.hpp"
 #include "common/PE/CommPattern.hpp"
@@ -56,6 +57,8 @@ CommPattern::CommPattern(const std::string& name): Component(name), m_gid(alloca
   //self->regist_signal ( "update" , "Executes communication patterns on all the registered data.", "" ).connect ( boost::bind ( &CommPattern2::update, self, _1 ) );
   m_isUpToDate=false;
   m_isFreeze=false;
+  m_wrappers_generation=0;
+  m_rankMapsChanged=true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -467,6 +470,7 @@ void CommPattern::setup()
 
   // clear stuff and reset other things
   m_isUpToDate=true;
+  m_rankMapsChanged=true;
   m_add_buffer.clear();
   m_rem_buffer.clear();
   m_mov_buffer.clear();
@@ -566,12 +570,7 @@ void CommPattern::setup()
 
 void CommPattern::synchronize_all()
 {
-  std::vector<unsigned char> sndbuf(1);
-  std::vector<unsigned char> rcvbuf(1);
-  BOOST_FOREACH( CommWrapper& pobj, find_components_recursively<CommWrapper>(*this) )
-  {
-    synchronize_this(pobj,sndbuf,rcvbuf);
-  }
+  synchronize_fused(wrappers());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -586,6 +585,21 @@ void CommPattern::synchronize( const std::string& name )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void CommPattern::synchronize( const std::vector<std::string>& names )
+{
+  std::vector< Handle<CommWrapper> > pobjs;
+  pobjs.reserve(names.size());
+  BOOST_FOREACH( const std::string& name, names )
+  {
+    Handle<CommWrapper> pobj(get_child(name));
+    if (is_null(pobj)) throw ValueNotFound(FromHere(),"No data named '" + name + "' is registered in commpattern " + uri().path());
+    pobjs.push_back(pobj);
+  }
+  synchronize_fused(pobjs);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void CommPattern::synchronize( const CommWrapper& pobj )
 {
   std::vector<unsigned char> sndbuf(1);
@@ -602,15 +616,141 @@ void CommPattern::synchronize_this( const CommWrapper& pobj, std::vector<unsigne
 //  std::cout << PERank << pobj.needs_update() << "\n" << std::flush;
   if ( pobj.needs_update() )
   {
+    TraceScope trace(pobj, pobj.m_trace_name);
     pobj.pack(sndbuf,m_sendMap);
     rcvbuf.resize(m_recvMap.size()*pobj.size_of()*pobj.stride());
-    PE::Comm::instance().all_to_all(sndbuf,m_sendCount,rcvbuf,m_recvCount,pobj.size_of()*pobj.stride());
+    {
+      static const Uint wait_trace_name = Tracer::instance().register_name("MPI wait: all_to_all");
+      TraceScope wait_trace(wait_trace_name);
+      PE::Comm::instance().all_to_all(sndbuf,m_sendCount,rcvbuf,m_recvCount,pobj.size_of()*pobj.stride());
+    }
     pobj.unpack(rcvbuf,m_recvMap);
   }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void CommPattern::synchronize_fused( const std::vector< Handle<CommWrapper> >& pobjs )
+{
+  // collect the objects to update and the number of bytes per item, identical on all ranks
+  std::vector< Handle<CommWrapper> > updated;
+  updated.reserve(pobjs.size());
+  int item_size=0;
+  BOOST_FOREACH( const Handle<CommWrapper>& pobj, pobjs )
+  {
+    if (pobj->needs_update())
+    {
+      updated.push_back(pobj);
+      item_size+=pobj->size_of()*pobj->stride();
+    }
+  }
+  if (updated.empty()) return;
+
+  // a single object is exchanged directly from its packed data
+  if (updated.size()==1)
+  {
+    synchronize_this(*updated.front(),m_sndbuf,m_rcvbuf);
+    return;
+  }
+
+  static const Uint trace_name = Tracer::instance().register_name("CommPattern::synchronize_fused");
+  TraceScope trace(trace_name);
+
+  build_rank_maps();
+  const int nproc=m_sendRankMaps.size();
+
+  // pack: for each rank, the items of the first object, then the items of the second object, ...
+  m_sndbuf.resize(m_sendMap.size()*item_size+1);
+  m_rcvbuf.resize(m_recvMap.size()*item_size+1);
+  Uint offset=0;
+  for (int r=0; r<nproc; ++r)
+  {
+    std::vector<int>& map=m_sendRankMaps[r];
+    if (map.empty()) continue;
+    BOOST_FOREACH( const Handle<CommWrapper>& pobj, updated )
+    {
+      pobj->pack(map,&m_sndbuf[offset]);
+      offset+=map.size()*pobj->size_of()*pobj->stride();
+    }
+  }
+
+  {
+    static const Uint wait_trace_name = Tracer::instance().register_name("MPI wait: all_to_all");
+    TraceScope wait_trace(wait_trace_name);
+    PE::Comm::instance().all_to_all(&m_sndbuf[0],&m_sendCount[0],&m_rcvbuf[0],&m_recvCount[0],item_size);
+  }
+
+  // unpack in the same layout
+  offset=0;
+  for (int r=0; r<nproc; ++r)
+  {
+    std::vector<int>& map=m_recvRankMaps[r];
+    if (map.empty()) continue;
+    BOOST_FOREACH( const Handle<CommWrapper>& pobj, updated )
+    {
+      pobj->unpack(&m_rcvbuf[offset],map);
+      offset+=map.size()*pobj->size_of()*pobj->stride();
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::size_t CommPattern::memory_footprint() const
+{
+  std::size_t result = (m_add_buffer.capacity() + m_mov_buffer.capacity() + m_rem_buffer.capacity()) * sizeof(temp_buffer_item);
+  result += m_free_lids.capacity() * sizeof(Uint);
+  result += m_isUpdatable.capacity() / 8;
+  result += (m_sendCount.capacity() + m_sendMap.capacity() + m_recvCount.capacity() + m_recvMap.capacity()) * sizeof(CPint);
+  result += m_ranks.capacity() * sizeof(int);
+  for(Uint i = 0; i != m_sendRankMaps.size(); ++i)
+    result += m_sendRankMaps[i].capacity() * sizeof(int);
+  for(Uint i = 0; i != m_recvRankMaps.size(); ++i)
+    result += m_recvRankMaps[i].capacity() * sizeof(int);
+  result += m_sndbuf.capacity() + m_rcvbuf.capacity();
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const std::vector< Handle<CommWrapper> >& CommPattern::wrappers()
+{
+  // the generation also changes if data is added or removed without going through insert and clear
+  if (m_wrappers_generation == structure_generation())
+    return m_wrappers;
+
+  m_wrappers.clear();
+  BOOST_FOREACH( CommWrapper& pobj, find_components_recursively<CommWrapper>(*this) )
+  {
+    m_wrappers.push_back(pobj.handle<CommWrapper>());
+  }
+  m_wrappers_generation=structure_generation();
+  return m_wrappers;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CommPattern::build_rank_maps()
+{
+  if (!m_rankMapsChanged) return;
+
+  const int nproc=m_sendCount.size();
+  m_sendRankMaps.assign(nproc,std::vector<int>());
+  m_recvRankMaps.assign(nproc,std::vector<int>());
+  int send_start=0;
+  int recv_start=0;
+  for (int r=0; r<nproc; ++r)
+  {
+    m_sendRankMaps[r].assign(m_sendMap.begin()+send_start,m_sendMap.begin()+send_start+m_sendCount[r]);
+    m_recvRankMaps[r].assign(m_recvMap.begin()+recv_start,m_recvMap.begin()+recv_start+m_recvCount[r]);
+    send_start+=m_sendCount[r];
+    recv_start+=m_recvCount[r];
+  }
+  m_rankMapsChanged=false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void CommPattern::add_global(Uint gid, Uint rank)
 {
   // later a mechanism could be implemented when commpattern can give gids by calling a "reserve(int num)" beforehand, to optimize performance
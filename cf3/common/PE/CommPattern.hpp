@@ -8,6 +8,7 @@
 #define cf3_common_PE_CommPattern_hpp
 
 #include "common/Component.hpp"
+#include "common/MemoryComponent.hpp"
 #include "common/BoostArray.hpp"
 #include "common/PE/Comm.hpp"
 #include "common/PE/CommWrapper.hpp"
@@ -38,7 +39,7 @@ namespace PE {
   @todo introduce allocate_component
 **/
 
-class Common_API CommPattern: public Component {
+class Common_API CommPattern: public Component, public MemoryComponent {
 
 public:
 
@@ -219,8 +220,14 @@ public:
   void setup();
 
   /// synchronize the all parallel objects
+  /// all objects that need updating are packed together and exchanged in a single all_to_all
   void synchronize_all();
 
+  /// synchronize the parallel objects designated by their names, in a single all_to_all
+  /// the names must be given in the same order on all ranks
+  /// @param names the names of the parallel objects
+  void synchronize( const std::vector<std::string>& names );
+
   /// synchronize the parallel object designated by its name
   /// @param name the name of the parallel object
   void synchronize( const std::string& name );
@@ -284,6 +291,9 @@ public:
   /// Return the rank associated with the given local ID
   int rank(const Uint lid) const { return m_ranks[lid]; }
 
+  /// Bytes used by the communication maps and buffers. The registered data itself is not included.
+  std::size_t memory_footprint() const;
+
   //@} END ACCESSORS
 
 protected: // helper function
@@ -295,8 +305,20 @@ protected: // helper function
   /// @param rcvbuf vector for intermediate buffer for recieve
   void synchronize_this( const CommWrapper& pobj, std::vector<unsigned char>& sndbuf, std::vector<unsigned char>& rcvbuf );
 
+  /// function to synchronize several objects in one exchange
+  /// for each rank, the data of all objects is packed one object after the other, so only one message per rank is sent
+  /// @param pobjs the objects to synchronize, in the same order on all ranks. Objects that don't need update are skipped.
+  void synchronize_fused( const std::vector< Handle<CommWrapper> >& pobjs );
+
 private:
 
+  /// the registered commwrappers, rebuilt only if the structure_generation() changed, i.e. if wrappers were
+  /// added, removed, renamed or moved in any way
+  const std::vector< Handle<CommWrapper> >& wrappers();
+
+  /// split the send and receive maps per rank, for packing the fused buffers
+  void build_rank_maps();
+
   /// @name PROPERTIES
   //@{
 
@@ -349,6 +371,24 @@ private:
   /// Rank for all the gids in local index space
   std::vector<int> m_ranks;
 
+  /// cached list of registered commwrappers
+  std::vector< Handle<CommWrapper> > m_wrappers;
+
+  /// structure_generation() for which m_wrappers was built. The initial empty list is valid for generation 0,
+  /// since there are no children at that point
+  Uint m_wrappers_generation;
+
+  /// m_sendMap and m_recvMap split per rank
+  std::vector< std::vector<int> > m_sendRankMaps;
+  std::vector< std::vector<int> > m_recvRankMaps;
+
+  /// true if setup changed the maps since build_rank_maps was last called
+  bool m_rankMapsChanged;
+
+  /// buffers kept between fused synchronizations, so they are only resized when the data grows
+  std::vector<unsigned char> m_sndbuf;
+  std::vector<unsigned char> m_rcvbuf;
+
 }; // CommPattern
 
 ////////////////////////////////////////////////////////////////////////////////////////////
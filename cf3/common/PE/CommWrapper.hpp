@@ -16,6 +16,7 @@
 #include "common/LibCommon.hpp"
 #include "common/CF.hpp"
 #include "common/Component.hpp"
+#include "common/Tracer.hpp"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -44,6 +45,9 @@ class Common_API CommWrapper : public Component {
     /// making CommWrapperView as friend in order to access create_view and destroy_view
     template <typename T> friend class CommWrapperView;
 
+    /// CommPattern traces the synchronization of each wrapper, using its cached tracer name
+    friend class CommPattern;
+
   public:
 
     /// constructor
@@ -164,6 +168,11 @@ class Common_API CommWrapper : public Component {
     /// bool holding the info if data to be synchronized & kept up-to-date with commpattern or only keep up-to-date
     bool m_needs_update;
 
+  private:
+
+    /// Cached tracer name of the wrapper
+    mutable TraceName m_trace_name;
+
 };
 
 ////////////////////////////////////////////////////////////////////////////////
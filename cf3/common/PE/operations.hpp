@@ -76,7 +76,7 @@ template<typename T, typename Op, typename selector = void > class get_mpi_op
   {                                                                                              \
     public:                                                                                      \
       static const bool is_commutative=commutative;                                              \
-      template<typename T> static void func(void* in_, void* out_, int* len, Datatype* type) \
+      template<typename T> static void func(void* in_, void* out_, int* len, cf3::common::PE::Datatype* type) \
       {                                                                                          \
         T *in=(T*)in_;                                                                           \
         T *out=(T*)out_;                                                                         \
@@ -140,6 +140,25 @@ void PosixDlopenLibLoader::system_load_library(const std::string& lib)
   throw LibLoadingError ("Library " + lib + " failed to load with dlopen error: " + std::string(msg));
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+/// Object whose address identifies the library holding this code
+static const char common_library_marker = 0;
+
+std::string PosixDlopenLibLoader::common_library_dir() const
+{
+  Dl_info info;
+  if( dladdr( &common_library_marker, &info ) == 0 || is_null(info.dli_fname) )
+    return std::string();
+
+  // dli_fname is the path the library was loaded from, the directory is everything before the last separator
+  const std::string library_file( info.dli_fname );
+  const std::string::size_type n = library_file.rfind('/');
+  if( n == std::string::npos )
+    return std::string();
+  return library_file.substr(0,n);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
   } // common
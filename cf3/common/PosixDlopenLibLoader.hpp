@@ -37,6 +37,9 @@ public: // functions
   ///
   virtual void set_search_paths(const std::vector< URI >& paths);
 
+  /// Directory of the loaded coolfluid_common library, as reported by dladdr
+  virtual std::string common_library_dir() const;
+
   protected:
 
   void* call_dlopen(const URI& fpath);
@@ -12,6 +12,7 @@
 #include <iosfwd>
 
 #include "common/Component.hpp"
+#include "common/MemoryComponent.hpp"
 
 #include "common/Table_fwd.hpp"
 #include "common/ArrayBufferT.hpp"
@@ -42,7 +43,7 @@ namespace common {
 /// @author Tiago Quintino
 
 template<typename ValueT>
-class Table : public common::Component
+class Table : public common::Component, public common::MemoryComponent
 {
 public: // typedefs
 
@@ -159,6 +160,12 @@ public: // functions
     return m_pos;
   }
 
+  /// Bytes used by the array
+  std::size_t memory_footprint() const
+  {
+    return m_array.num_elements() * sizeof(ValueT);
+  }
+
 private: // data
 
   /// storage of the array
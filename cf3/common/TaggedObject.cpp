@@ -4,14 +4,80 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
-#include <boost/tokenizer.hpp>
+#include <algorithm>
+#include <map>
 
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/StringConversion.hpp"
 #include "common/TaggedObject.hpp"
 
 using namespace cf3::common;
 
-TaggedObject::TaggedObject() :
-    m_tags(":") // empty tags
+namespace
+{
+
+/// Process-wide mapping between tags and their ID
+struct TagRegistry
+{
+  static TagRegistry& instance()
+  {
+    static TagRegistry registry;
+    return registry;
+  }
+
+  /// Get the ID of the tag, registering it if needed
+  cf3::Uint id(const std::string& tag)
+  {
+    boost::lock_guard<boost::mutex> lock(mutex);
+    const std::map<std::string, cf3::Uint>::iterator found = ids.find(tag);
+    if(found != ids.end())
+      return found->second;
+
+    const cf3::Uint new_id = names.size();
+    ids.insert(std::make_pair(tag, new_id));
+    names.push_back(tag);
+    return new_id;
+  }
+
+  /// Get the ID of the tag, returning false if it was never registered
+  bool find(const std::string& tag, cf3::Uint& result)
+  {
+    boost::lock_guard<boost::mutex> lock(mutex);
+    const std::map<std::string, cf3::Uint>::iterator found = ids.find(tag);
+    if(found == ids.end())
+      return false;
+
+    result = found->second;
+    return true;
+  }
+
+  std::string name(const cf3::Uint id)
+  {
+    boost::lock_guard<boost::mutex> lock(mutex);
+    if(id >= names.size())
+      throw ValueNotFound(FromHere(), "No tag with ID " + to_str(id));
+    return names[id];
+  }
+
+  boost::mutex mutex;
+  std::map<std::string, cf3::Uint> ids;
+  std::vector<std::string> names;
+};
+
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+TaggedObject::TaggedObject()
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+TaggedObject::~TaggedObject()
 {
 }
 
@@ -19,8 +85,12 @@ TaggedObject::TaggedObject() :
 
 void TaggedObject::add_tag(const std::string& tag)
 {
-  if (!has_tag(tag))
-    m_tags += tag + ":";
+  const cf3::Uint id = tag_id(tag);
+  if (!has_tag(id))
+  {
+    m_tags.push_back(id);
+    tags_changed();
+  }
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -28,13 +98,10 @@ void TaggedObject::add_tag(const std::string& tag)
 std::vector<std::string> TaggedObject::get_tags() const
 {
   std::vector<std::string> vec;
+  vec.reserve(m_tags.size());
 
-  typedef boost::tokenizer<boost::char_separator<char> > Tokenizer;
-  boost::char_separator<char> sep(":");
-  Tokenizer tokens(m_tags, sep);
-
-  for (Tokenizer::iterator tok_iter = tokens.begin(); tok_iter != tokens.end(); ++tok_iter)
-    vec.push_back(*tok_iter);
+  for (std::vector<cf3::Uint>::const_iterator it = m_tags.begin(); it != m_tags.end(); ++it)
+    vec.push_back(tag_name(*it));
 
   return vec;
 }
@@ -43,32 +110,52 @@ std::vector<std::string> TaggedObject::get_tags() const
 
 bool TaggedObject::has_tag(const std::string& tag) const
 {
-  typedef boost::tokenizer<boost::char_separator<char> > Tokenizer;
-  boost::char_separator<char> sep(":");
-  Tokenizer tokens(m_tags, sep);
+  cf3::Uint id;
+  if (!TagRegistry::instance().find(tag, id))
+    return false;
 
-  for (Tokenizer::iterator tok_iter = tokens.begin(); tok_iter != tokens.end(); ++tok_iter)
-    if (*tok_iter == tag)
-      return true;
+  return has_tag(id);
+}
 
-  return false;
+/////////////////////////////////////////////////////////////////////////////////////
+
+bool TaggedObject::has_tag(const cf3::Uint tag_id) const
+{
+  return std::find(m_tags.begin(), m_tags.end(), tag_id) != m_tags.end();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
 
 void TaggedObject::remove_tag(const std::string& tag)
 {
-  if (has_tag(tag))
+  cf3::Uint id;
+  if (!TagRegistry::instance().find(tag, id))
+    return;
+
+  const std::vector<cf3::Uint>::iterator found = std::find(m_tags.begin(), m_tags.end(), id);
+  if (found != m_tags.end())
   {
-    std::string tags;
+    m_tags.erase(found);
+    tags_changed();
+  }
+}
 
-    typedef boost::tokenizer<boost::char_separator<char> > Tokenizer;
-    boost::char_separator<char> sep(":");
-    Tokenizer tokens(m_tags, sep);
+/////////////////////////////////////////////////////////////////////////////////////
 
-    for (Tokenizer::iterator tok_iter = tokens.begin(); tok_iter != tokens.end(); ++tok_iter)
-      if (*tok_iter!=tag)
-        tags += *tok_iter + ":";
-    m_tags=tags;
-  }
+cf3::Uint TaggedObject::tag_id(const std::string& tag)
+{
+  return TagRegistry::instance().id(tag);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+std::string TaggedObject::tag_name(const cf3::Uint tag_id)
+{
+  return TagRegistry::instance().name(tag_id);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void TaggedObject::tags_changed()
+{
 }
@@ -7,6 +7,8 @@
 #ifndef cf3_common_TaggedObject_hpp
 #define cf3_common_TaggedObject_hpp
 
+#include <string>
+#include <vector>
 
 #include "common/CommonAPI.hpp"
 
@@ -15,18 +17,27 @@ namespace common {
 
 //////////////////////////////////////////////////////////////////////////
 
-/// Manages tags
+/// Object that can be marked with tags. Tags are interned into integer IDs, so
+/// checking for a tag of which the ID is known comes down to a few integer comparisons.
 class Common_API TaggedObject {
 public:
 
   /// Constructor
   TaggedObject();
 
-  /// Check if this component has a given tag assigned
+  /// Virtual destructor
+  virtual ~TaggedObject();
+
+  /// Check if this component has a given tag assigned. The lookup of the tag ID locks the
+  /// process-wide registry, so in loops resolve the ID once with tag_id() instead
   /// @param tag to check
   /// @return if has it or not
   bool has_tag(const std::string& tag) const;
 
+  /// Check if this component has a given tag assigned
+  /// @param tag_id ID of the tag to check, as returned by tag_id()
+  bool has_tag(const Uint tag_id) const;
+
   /// add tag to this component
   /// @param tag to add
   void add_tag(const std::string& tag);
@@ -38,9 +49,21 @@ public:
   /// @param tag to remove
   void remove_tag(const std::string& tag);
 
+  /// Unique ID of the given tag. IDs are assigned on first use and remain valid during the lifetime of the process.
+  static Uint tag_id(const std::string& tag);
+
+  /// Tag corresponding to the given ID
+  static std::string tag_name(const Uint tag_id);
+
+protected:
+
+  /// Called after a tag was added or removed
+  virtual void tags_changed();
+
 private:
 
-  std::string m_tags;
+  /// IDs of the tags, in the order they were added
+  std::vector<Uint> m_tags;
 
 }; // class TaggedObject
 
@@ -0,0 +1,258 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/ThreadPool.hpp"
+
+namespace cf3 {
+namespace common {
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct ThreadPool::Implementation
+{
+  Implementation() :
+    nb_threads(1),
+    generation(0),
+    nb_busy(0),
+    stop(false),
+    begin(0),
+    end(0),
+    next(0),
+    grain(1),
+    function(nullptr)
+  {
+  }
+
+  ~Implementation()
+  {
+    stop_workers();
+  }
+
+  void start_workers(const Uint nb_workers)
+  {
+    for(Uint i = 0; i != nb_workers; ++i)
+      workers.push_back(boost::shared_ptr<boost::thread>(new boost::thread(boost::bind(&Implementation::worker_loop, this, i+1, generation))));
+  }
+
+  void stop_workers()
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(mutex);
+      stop = true;
+    }
+    work_available.notify_all();
+    for(Uint i = 0; i != workers.size(); ++i)
+      workers[i]->join();
+    workers.clear();
+    stop = false;
+  }
+
+  void worker_loop(const Uint thread_idx, Uint seen_generation)
+  {
+    loop_thread_index.reset(new Uint(thread_idx));
+    while(true)
+    {
+      {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while(!stop && generation == seen_generation)
+          work_available.wait(lock);
+        if(stop)
+          return;
+        seen_generation = generation;
+      }
+
+      run_chunks(thread_idx);
+
+      {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        if(--nb_busy == 0)
+          work_done.notify_all();
+      }
+    }
+  }
+
+  /// Grab chunks of the current loop until none are left
+  void run_chunks(const Uint thread_idx)
+  {
+    while(true)
+    {
+      Uint chunk_begin, chunk_end;
+      {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        if(next == end || !error.empty())
+          return;
+        chunk_begin = next;
+        chunk_end = std::min(end, next + grain);
+        next = chunk_end;
+      }
+
+      try
+      {
+        (*function)(chunk_begin, chunk_end, thread_idx);
+      }
+      catch(std::exception& e)
+      {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        if(error.empty())
+          error = e.what();
+      }
+      catch(...)
+      {
+        boost::lock_guard<boost::mutex> lock(mutex);
+        if(error.empty())
+          error = "unknown exception";
+      }
+    }
+  }
+
+  Uint nb_threads;
+
+  /// Serializes loops started from different threads
+  boost::mutex dispatch_mutex;
+
+  /// Protects the loop state below
+  boost::mutex mutex;
+  boost::condition_variable work_available;
+  boost::condition_variable work_done;
+
+  std::vector< boost::shared_ptr<boost::thread> > workers;
+
+  /// Incremented each time a new loop is started
+  Uint generation;
+  /// Number of workers still busy with the current loop
+  Uint nb_busy;
+  bool stop;
+
+  Uint begin;
+  Uint end;
+  Uint next;
+  Uint grain;
+  const RangeFunctionT* function;
+  std::string error;
+
+  /// Index of the calling thread, only set while it executes a loop body
+  boost::thread_specific_ptr<Uint> loop_thread_index;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+ThreadPool& ThreadPool::instance()
+{
+  static ThreadPool thread_pool;
+  return thread_pool;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ThreadPool::ThreadPool() : m_implementation(new Implementation())
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ThreadPool::~ThreadPool()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint ThreadPool::nb_threads() const
+{
+  return m_implementation->nb_threads;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::set_nb_threads(const Uint nb_threads)
+{
+  Implementation& impl = *m_implementation;
+  if(is_not_null(impl.loop_thread_index.get()))
+    throw IllegalCall(FromHere(), "Can't change the number of threads from within a threaded loop");
+
+  const Uint new_nb_threads = std::max(nb_threads, 1u);
+  if(new_nb_threads == impl.nb_threads)
+    return;
+
+  boost::lock_guard<boost::mutex> dispatch_lock(impl.dispatch_mutex);
+  impl.stop_workers();
+  impl.nb_threads = new_nb_threads;
+  impl.start_workers(new_nb_threads - 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::parallel_for(const Uint begin, const Uint end, const ThreadPool::RangeFunctionT& f)
+{
+  const Uint nb_threads = m_implementation->nb_threads;
+  const Uint size = end > begin ? end - begin : 0;
+  parallel_for(begin, end, (size + nb_threads - 1) / nb_threads, f);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ThreadPool::parallel_for(const Uint begin, const Uint end, const Uint grain_size, const ThreadPool::RangeFunctionT& f)
+{
+  if(end <= begin)
+    return;
+
+  Implementation& impl = *m_implementation;
+
+  // Serial execution if there is only one thread or if we are already in a loop
+  const Uint* current_index = impl.loop_thread_index.get();
+  if(impl.nb_threads == 1 || is_not_null(current_index))
+  {
+    f(begin, end, is_null(current_index) ? 0u : *current_index);
+    return;
+  }
+
+  boost::lock_guard<boost::mutex> dispatch_lock(impl.dispatch_mutex);
+
+  {
+    boost::lock_guard<boost::mutex> lock(impl.mutex);
+    impl.begin = begin;
+    impl.end = end;
+    impl.next = begin;
+    impl.grain = std::max(grain_size, 1u);
+    impl.function = &f;
+    impl.error.clear();
+    impl.nb_busy = impl.workers.size();
+    ++impl.generation;
+  }
+  impl.work_available.notify_all();
+
+  impl.loop_thread_index.reset(new Uint(0));
+  impl.run_chunks(0);
+  impl.loop_thread_index.reset();
+
+  std::string error;
+  {
+    boost::unique_lock<boost::mutex> lock(impl.mutex);
+    while(impl.nb_busy != 0)
+      impl.work_done.wait(lock);
+    impl.function = nullptr;
+    error = impl.error;
+  }
+
+  if(!error.empty())
+    throw ParallelError(FromHere(), "Exception in threaded loop: " + error);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
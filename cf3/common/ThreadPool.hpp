@@ -0,0 +1,77 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_ThreadPool_hpp
+#define cf3_common_ThreadPool_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include "common/CommonAPI.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Persistent pool of worker threads for shared-memory loops
+///
+/// The pool is a singleton, configured through the "nb_threads" option of the
+/// Environment component. Work is handed out as contiguous index ranges of a
+/// fixed grain size, which each thread claims from a shared counter as soon as
+/// it is done with its previous range. parallel_for() only returns once all
+/// ranges are processed.
+/// The calling thread takes part in the work as thread 0, so a pool of size 1
+/// executes everything serially without any synchronization.
+class Common_API ThreadPool : public boost::noncopyable
+{
+public:
+
+  /// Functor type executed on a range [begin, end) by thread with given index
+  typedef boost::function< void (const Uint, const Uint, const Uint) > RangeFunctionT;
+
+  /// Gets the instance of the pool
+  static ThreadPool& instance();
+
+  /// Number of threads, including the calling thread
+  Uint nb_threads() const;
+
+  /// Change the number of threads. Existing workers are stopped and new ones started.
+  /// Must not be called from within parallel_for()
+  void set_nb_threads(const Uint nb_threads);
+
+  /// Split [begin, end) into contiguous ranges of at most ceil((end-begin)/nb_threads()) entries and execute f on each.
+  /// The ranges are claimed dynamically, so a thread may process more than one range and another none at all.
+  /// Exceptions raised in a worker are rethrown in the calling thread as a ParallelError.
+  /// Nested calls from inside a running loop are executed serially.
+  void parallel_for(const Uint begin, const Uint end, const RangeFunctionT& f);
+
+  /// Split [begin, end) into chunks of at most grain_size entries that are distributed
+  /// dynamically over the threads. Useful when the cost per index varies
+  void parallel_for(const Uint begin, const Uint end, const Uint grain_size, const RangeFunctionT& f);
+
+private:
+
+  ThreadPool();
+  ~ThreadPool();
+
+  struct Implementation;
+  boost::scoped_ptr<Implementation> m_implementation;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_ThreadPool_hpp
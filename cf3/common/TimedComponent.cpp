@@ -4,15 +4,20 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
 #include <iostream>
+#include <map>
+#include <vector>
 
 #include "common/Component.hpp"
 #include "common/FindComponents.hpp"
 #include "common/Foreach.hpp"
+#include "common/Log.hpp"
 #include "common/PropertyList.hpp"
 #include "common/TimedComponent.hpp"
 
 #include "common/PE/Comm.hpp"
+#include "common/PE/operations.hpp"
 
 /////////////////////////////////////////////////////////////////////////////////////
 
@@ -35,78 +40,161 @@ void store_timings(Component& root)
 
 /////////////////////////////////////////////////////////////////////////////////////
 
-void print_timing_tree(cf3::common::Component& root, const bool print_untimed, const std::string& prefix)
+namespace detail
+{
+
+/// Statistics of one timed component, over all CPUs
+struct TimingStatistics
+{
+  Real mean;
+  Real min;
+  Real max;
+  Real max_mean;
+  Uint count;
+};
+
+typedef std::map<const Component*, TimingStatistics> TimingStatisticsMap;
+
+/// Combine the statistics of two CPUs. The means are summed, and divided by the number of CPUs after the reduction
+inline void combine_timings(const TimingStatistics& in, TimingStatistics& out)
 {
-  if(prefix.empty()) // Top-level recursion
+  out.mean += in.mean;
+  out.min = std::min(out.min, in.min);
+  out.max = std::max(out.max, in.max);
+  out.max_mean = std::max(out.max_mean, in.max_mean);
+  out.count = std::max(out.count, in.count);
+}
+
+MPI_CUSTOM_OPERATION(combine_timings_op, true, combine_timings(*in, *out));
+
+/// Depth-first list of the components that have timing info
+void collect_timed_components(Component& root, std::vector<const Component*>& timed_components)
+{
+  if(root.properties().check("timer_mean"))
+    timed_components.push_back(&root);
+  BOOST_FOREACH(Component& component, root)
   {
-    store_timings(root);
-    if(PE::Comm::instance().rank() == 0)
-      std::cout << "<DartMeasurement name=\"Timings\" type=\"text/plain\"><![CDATA[<html><body><pre>\n";
+    collect_timed_components(component, timed_components);
   }
+}
+
+/// Reduce the timings of all components over all CPUs onto rank 0. The statistics of all components are packed
+/// in one buffer and reduced in a single operation, after a check that all ranks have the same timed components
+void reduce_timings(Component& root, TimingStatisticsMap& statistics)
+{
+  std::vector<const Component*> timed_components;
+  collect_timed_components(root, timed_components);
+  const Uint nb_timed = timed_components.size();
 
-  if(!root.properties().check("timer_mean") && print_untimed && PE::Comm::instance().rank() == 0)
+  std::vector<TimingStatistics> local_stats(nb_timed);
+  for(Uint i = 0; i != nb_timed; ++i)
   {
-    std::cout << prefix << root.name() << ": no timing info\n";
+    const PropertyList& props = timed_components[i]->properties();
+    TimingStatistics& stats = local_stats[i];
+    stats.mean = props.value<Real>("timer_mean");
+    stats.min = props.value<Real>("timer_minimum");
+    stats.max = props.value<Real>("timer_maximum");
+    stats.max_mean = stats.mean;
+    stats.count = props.value<Uint>("timer_count");
   }
 
+  Uint nb_procs = 1;
+  std::vector<TimingStatistics> global_stats;
+  if(PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1)
+  {
+    // All ranks agree on the number of timed components before reducing, so every rank reaches the same collectives
+    const int local_counts[2] = { static_cast<int>(nb_timed), -static_cast<int>(nb_timed) };
+    int max_counts[2];
+    PE::Comm::instance().all_reduce(PE::max(), local_counts, 2, max_counts);
+    if(max_counts[0] == -max_counts[1])
+    {
+      if(nb_timed == 0)
+        return;
+      nb_procs = PE::Comm::instance().size();
+      global_stats.resize(nb_timed);
+      PE::Comm::instance().reduce(combine_timings_op(), &local_stats[0], nb_timed, &global_stats[0], 0);
+    }
+    else if(PE::Comm::instance().rank() == 0)
+    {
+      CFwarn << "The timed components differ between CPUs, only the timings of rank 0 are reported" << CFendl;
+    }
 
-  if(root.properties().check("timer_mean"))
+    if(PE::Comm::instance().rank() != 0)
+      return;
+  }
+
+  if(nb_procs == 1)
+    global_stats = local_stats;
+
+  for(Uint i = 0; i != nb_timed; ++i)
   {
-    const Real local_mean = root.properties().value<Real>("timer_mean");
-    const Real local_min = root.properties().value<Real>("timer_minimum");
-    const Real local_max = root.properties().value<Real>("timer_maximum");
-    const Uint local_count = root.properties().value<Uint>("timer_count");
+    TimingStatistics& result = statistics[timed_components[i]];
+    result = global_stats[i];
+    result.mean /= static_cast<Real>(nb_procs);
+  }
+}
 
-    // Only bother with global averages if we have more than 1 process
-    if(PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1)
+void print_timing_tree(const Component& root, const bool print_untimed, const std::string& prefix, const bool parallel, const TimingStatisticsMap& statistics)
+{
+  const TimingStatisticsMap::const_iterator found = statistics.find(&root);
+  if(found == statistics.end())
+  {
+    if(print_untimed)
+      std::cout << prefix << root.name() << ": no timing info\n";
+  }
+  else
+  {
+    const TimingStatistics& stats = found->second;
+    if(parallel)
     {
-      // Average, minimum and maximum of each statistic over all CPUs
-      Real mean_mean, mean_min, mean_max, max_mean, max_min, max_max, min_mean, min_min, min_max;
-      Uint min_count, max_count;
-      PE::Comm::instance().all_reduce(PE::plus(), &local_mean, 1, &mean_mean);
-      PE::Comm::instance().all_reduce(PE::min(), &local_mean, 1, &mean_min);
-      PE::Comm::instance().all_reduce(PE::max(), &local_mean, 1, &mean_max);
-
-      PE::Comm::instance().all_reduce(PE::plus(), &local_min, 1, &min_mean);
-      PE::Comm::instance().all_reduce(PE::min(), &local_min, 1, &min_min);
-      PE::Comm::instance().all_reduce(PE::max(), &local_min, 1, &min_max);
-
-      PE::Comm::instance().all_reduce(PE::plus(), &local_max, 1, &max_mean);
-      PE::Comm::instance().all_reduce(PE::min(), &local_max, 1, &max_min);
-      PE::Comm::instance().all_reduce(PE::max(), &local_max, 1, &max_max);
-      
-      PE::Comm::instance().all_reduce(PE::min(), &local_count, 1, &min_count);
-      PE::Comm::instance().all_reduce(PE::max(), &local_count, 1, &max_count);
-      cf3_assert(min_count == max_count);
-
-      const Real nb_procs = static_cast<Real>(PE::Comm::instance().size());
-      mean_mean /= nb_procs; min_mean /= nb_procs; max_mean /= nb_procs;
-
-      if(PE::Comm::instance().rank() == 0)
-      {
-        if(prefix.empty()) std::cout << "Timings in seconds, with [min, mean, max] over CPUs\n";
-        std::cout << prefix << root.name()
-          << ": mean: "  << mean_mean
-          << ", min: " << min_min
-          << ", max: " << max_max
-          << ", count: " << min_count << "\n";
-      }
+      // The imbalance is the ratio between the slowest CPU and the average over all CPUs
+      std::cout << prefix << root.name()
+        << ": mean: "  << stats.mean
+        << ", min: " << stats.min
+        << ", max: " << stats.max
+        << ", imbalance: " << (stats.mean > 0. ? stats.max_mean / stats.mean : 1.)
+        << ", count: " << stats.count << "\n";
     }
     else
     {
-      std::cout << prefix << root.name() << ": mean: " << local_mean << ", max: " << local_max << ", min: " << local_min << ", count: " << local_count << "\n";
+      std::cout << prefix << root.name() << ": mean: " << stats.mean << ", max: " << stats.max << ", min: " << stats.min << ", count: " << stats.count << "\n";
     }
   }
 
-  BOOST_FOREACH(Component& component, root)
+  BOOST_FOREACH(const Component& component, root)
   {
-    print_timing_tree(component, print_untimed, prefix + "  ");
+    print_timing_tree(component, print_untimed, prefix + "  ", parallel, statistics);
   }
+}
 
-  if(prefix.empty() && PE::Comm::instance().rank() == 0)
-    std::cout << "</pre></body></html>]]></DartMeasurement>" << std::endl;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+
+void print_timing_tree(cf3::common::Component& root, const bool print_untimed, const std::string& prefix)
+{
+  store_timings(root);
+
+  // The statistics of all components are reduced at once, and only printed by rank 0
+  detail::TimingStatisticsMap statistics;
+  detail::reduce_timings(root, statistics);
+
+  const bool parallel = PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1;
+  if(parallel && PE::Comm::instance().rank() != 0)
+    return;
+
+  // A prefix means the tree is printed as part of other output, so the Dart measurement is only written at the top level
+  const bool top_level = prefix.empty();
+  if(top_level)
+  {
+    std::cout << "<DartMeasurement name=\"Timings\" type=\"text/plain\"><![CDATA[<html><body><pre>\n";
+    if(parallel)
+      std::cout << "Timings in seconds, with [min, mean, max] over CPUs\n";
+  }
+  detail::print_timing_tree(root, print_untimed, prefix, parallel, statistics);
+  if(top_level)
+    std::cout << "</pre></body></html>]]></DartMeasurement>" << std::endl;
+}
 
 /////////////////////////////////////////////////////////////////////////////////////
 
@@ -30,7 +30,8 @@ public:
 /// Store accumulated timings in properties for readout
 void store_timings(Component& root);
 
-/// Print timing tree based on the existing properties
+/// Print timing tree based on the existing properties.
+/// In parallel, the statistics of all components are gathered on rank 0 in a single collective operation
 void print_timing_tree(Component& root, const bool print_untimed = false, const std::string& prefix="");
 
 }
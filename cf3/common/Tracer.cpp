@@ -0,0 +1,291 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <iomanip>
+#include <map>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/Component.hpp"
+#include "common/StringConversion.hpp"
+#include "common/Tracer.hpp"
+#include "common/URI.hpp"
+
+#include "common/PE/Comm.hpp"
+
+namespace cf3 {
+namespace common {
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/// Default number of events kept per thread
+const Uint default_buffer_size = 65536;
+
+/// Escape a string for use in JSON
+std::string json_escape(const std::string& str)
+{
+  std::string result;
+  result.reserve(str.size());
+  for(std::string::const_iterator c = str.begin(); c != str.end(); ++c)
+  {
+    if(*c == '"' || *c == '\\')
+      result.push_back('\\');
+    if(static_cast<unsigned char>(*c) < 0x20)
+      continue;
+    result.push_back(*c);
+  }
+  return result;
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct Tracer::Implementation
+{
+  struct Event
+  {
+    /// Microseconds since the creation of the tracer
+    Real timestamp;
+    Uint name;
+    Uint id;
+    char phase;
+  };
+
+  /// Ring buffer written only by the thread that owns it
+  struct ThreadBuffer
+  {
+    Uint thread_idx;
+    std::vector<Event> events;
+    /// Total number of events recorded since the last clear
+    Uint nb_recorded;
+  };
+
+  /// Buffers are owned by the tracer, so they outlive their threads and can be written out later
+  static void no_cleanup(ThreadBuffer*)
+  {
+  }
+
+  Implementation() :
+    buffer_size(default_buffer_size),
+    start_time(boost::posix_time::microsec_clock::universal_time()),
+    current_buffer(&Implementation::no_cleanup)
+  {
+  }
+
+  ThreadBuffer& thread_buffer()
+  {
+    ThreadBuffer* buffer = current_buffer.get();
+    if(is_null(buffer))
+    {
+      boost::lock_guard<boost::mutex> lock(mutex);
+      boost::shared_ptr<ThreadBuffer> new_buffer(new ThreadBuffer());
+      new_buffer->thread_idx = buffers.size();
+      new_buffer->events.resize(buffer_size);
+      new_buffer->nb_recorded = 0;
+      buffers.push_back(new_buffer);
+      buffer = new_buffer.get();
+      current_buffer.reset(buffer);
+    }
+    return *buffer;
+  }
+
+  Real now() const
+  {
+    return static_cast<Real>((boost::posix_time::microsec_clock::universal_time() - start_time).total_microseconds());
+  }
+
+  /// Protects the buffer list and the names
+  boost::mutex mutex;
+
+  Uint buffer_size;
+  std::vector< boost::shared_ptr<ThreadBuffer> > buffers;
+  std::vector<std::string> names;
+  std::map<std::string, Uint> name_indices;
+
+  const boost::posix_time::ptime start_time;
+  boost::thread_specific_ptr<ThreadBuffer> current_buffer;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+Tracer& Tracer::instance()
+{
+  static Tracer tracer;
+  return tracer;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Tracer::Tracer() : m_enabled(false), m_implementation(new Implementation())
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Tracer::~Tracer()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Tracer::set_enabled(const bool enabled)
+{
+  m_enabled = enabled;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Tracer::set_buffer_size(const Uint nb_events)
+{
+  Implementation& impl = *m_implementation;
+  boost::lock_guard<boost::mutex> lock(impl.mutex);
+  impl.buffer_size = std::max(nb_events, 1u);
+  for(Uint i = 0; i != impl.buffers.size(); ++i)
+  {
+    impl.buffers[i]->events.resize(impl.buffer_size);
+    impl.buffers[i]->nb_recorded = 0;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint Tracer::register_name(const std::string& name)
+{
+  Implementation& impl = *m_implementation;
+  boost::lock_guard<boost::mutex> lock(impl.mutex);
+  std::map<std::string, Uint>::const_iterator found = impl.name_indices.find(name);
+  if(found != impl.name_indices.end())
+    return found->second;
+
+  const Uint idx = impl.names.size();
+  impl.names.push_back(name);
+  impl.name_indices[name] = idx;
+  return idx;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint Tracer::component_name(const Component& component, TraceName& cached_name)
+{
+  const Uint path_version = Component::path_version();
+  if(cached_name.name == 0 || cached_name.path_version != path_version)
+  {
+    cached_name.name = register_name(component.uri().path()) + 1;
+    cached_name.path_version = path_version;
+  }
+  return cached_name.name - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Tracer::record(const Uint name, const Tracer::Phase phase, const Uint id)
+{
+  if(!m_enabled)
+    return;
+
+  Implementation::ThreadBuffer& buffer = m_implementation->thread_buffer();
+  Implementation::Event& event = buffer.events[buffer.nb_recorded % buffer.events.size()];
+  event.timestamp = m_implementation->now();
+  event.name = name;
+  event.id = id;
+  event.phase = static_cast<char>(phase);
+  ++buffer.nb_recorded;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Tracer::clear()
+{
+  Implementation& impl = *m_implementation;
+  boost::lock_guard<boost::mutex> lock(impl.mutex);
+  for(Uint i = 0; i != impl.buffers.size(); ++i)
+    impl.buffers[i]->nb_recorded = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Uint Tracer::nb_dropped() const
+{
+  Implementation& impl = *m_implementation;
+  boost::lock_guard<boost::mutex> lock(impl.mutex);
+  Uint result = 0;
+  for(Uint i = 0; i != impl.buffers.size(); ++i)
+  {
+    const Implementation::ThreadBuffer& buffer = *impl.buffers[i];
+    if(buffer.nb_recorded > buffer.events.size())
+      result += buffer.nb_recorded - buffer.events.size();
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Tracer::write_chrome_trace(const URI& file) const
+{
+  Implementation& impl = *m_implementation;
+  boost::lock_guard<boost::mutex> lock(impl.mutex);
+
+  const Uint rank = PE::Comm::instance().is_active() ? PE::Comm::instance().rank() : 0;
+  URI path = file;
+  if(PE::Comm::instance().is_active() && PE::Comm::instance().size() > 1)
+    path = file.base_path() / (file.base_name() + "_P" + to_str(rank) + file.extension());
+
+  boost::filesystem::fstream out(path.path(), std::ios_base::out);
+  if(!out)
+    throw FileSystemError(FromHere(), "Could not open trace file " + path.path());
+
+  out << std::fixed << std::setprecision(0);
+  out << "{\"traceEvents\":[\n";
+  out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank << ",\"tid\":0,\"args\":{\"name\":\"rank " << rank << "\"}}";
+  for(Uint b = 0; b != impl.buffers.size(); ++b)
+  {
+    const Implementation::ThreadBuffer& buffer = *impl.buffers[b];
+    out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << rank << ",\"tid\":" << buffer.thread_idx
+        << ",\"args\":{\"name\":\"thread " << buffer.thread_idx << "\"}}";
+
+    // Oldest event first
+    const Uint capacity = buffer.events.size();
+    const Uint nb_events = std::min(buffer.nb_recorded, capacity);
+    const Uint first = buffer.nb_recorded > capacity ? buffer.nb_recorded % capacity : 0;
+    for(Uint i = 0; i != nb_events; ++i)
+    {
+      const Implementation::Event& event = buffer.events[(first + i) % capacity];
+      out << ",\n{\"name\":\"" << json_escape(impl.names[event.name]) << "\",\"ph\":\"" << event.phase
+          << "\",\"ts\":" << event.timestamp << ",\"pid\":" << rank << ",\"tid\":" << buffer.thread_idx;
+      if(event.phase == ASYNC_BEGIN || event.phase == ASYNC_END)
+        out << ",\"cat\":\"async\",\"id\":" << event.id;
+      out << "}";
+    }
+  }
+  out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TraceScope::TraceScope(const Component& component, TraceName& cached_name) : m_name(0), m_active(Tracer::instance().enabled())
+{
+  if(m_active)
+  {
+    m_name = Tracer::instance().component_name(component, cached_name);
+    Tracer::instance().record(m_name, Tracer::BEGIN);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
@@ -0,0 +1,138 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_Tracer_hpp
+#define cf3_common_Tracer_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include "common/CommonAPI.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+class Component;
+class URI;
+struct TraceName;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Records a timeline of begin and end events, for viewing in chrome://tracing or Perfetto
+///
+/// The tracer is a singleton, enabled through the "trace" option of the Environment component.
+/// Every thread records into its own fixed-size ring buffer, so recording takes no locks and
+/// does not allocate. When a buffer is full the oldest events are overwritten.
+/// Event names are interned once through register_name(), and events refer to them by index.
+///
+/// The buffers are read by write_chrome_trace(), which must not run concurrently with
+/// threads that record events.
+class Common_API Tracer : public boost::noncopyable
+{
+public:
+
+  /// Event types, using the Chrome trace event phase characters
+  enum Phase { BEGIN = 'B', END = 'E', ASYNC_BEGIN = 'b', ASYNC_END = 'e' };
+
+  /// Gets the instance of the tracer
+  static Tracer& instance();
+
+  /// True if events are recorded
+  bool enabled() const { return m_enabled; }
+
+  /// Start or stop recording events
+  void set_enabled(const bool enabled);
+
+  /// Number of events kept per thread. Clears the recorded events
+  void set_buffer_size(const Uint nb_events);
+
+  /// Index of the given event name, adding it if it is new. Thread-safe
+  Uint register_name(const std::string& name);
+
+  /// Index of the event name for a component, which is its path. The index is stored in cached_name, so the name
+  /// is only registered again after a component was renamed or moved
+  Uint component_name(const Component& component, TraceName& cached_name);
+
+  /// Record an event for the calling thread. Async events are matched by id
+  /// instead of nesting, and may begin and end in different scopes.
+  void record(const Uint name, const Phase phase, const Uint id = 0);
+
+  /// Drop all recorded events
+  void clear();
+
+  /// Number of events that were overwritten because a buffer was full
+  Uint nb_dropped() const;
+
+  /// Write the events of this process in the Chrome trace JSON format. If more than one process
+  /// is running, the rank is appended to the file name as "_P<rank>"
+  void write_chrome_trace(const URI& file) const;
+
+private:
+
+  Tracer();
+  ~Tracer();
+
+  bool m_enabled;
+
+  struct Implementation;
+  boost::scoped_ptr<Implementation> m_implementation;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Tracer name of a component, cached until the component paths change
+struct TraceName
+{
+  TraceName() : name(0), path_version(0) {}
+
+  /// Name index plus one, or zero if the name was not registered yet
+  Uint name;
+  /// Component::path_version() at the time the name was registered
+  Uint path_version;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Records a begin event on construction and the matching end event on destruction,
+/// if the tracer is enabled
+class Common_API TraceScope : public boost::noncopyable
+{
+public:
+  explicit TraceScope(const Uint name) : m_name(name), m_active(Tracer::instance().enabled())
+  {
+    if(m_active)
+      Tracer::instance().record(m_name, Tracer::BEGIN);
+  }
+
+  /// Trace a scope named after the path of the given component, caching its name index
+  /// in cached_name as in Tracer::component_name(). The name is only registered if the tracer is enabled
+  TraceScope(const Component& component, TraceName& cached_name);
+
+  ~TraceScope()
+  {
+    if(m_active)
+      Tracer::instance().record(m_name, Tracer::END);
+  }
+
+private:
+  Uint m_name;
+  const bool m_active;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_Tracer_hpp
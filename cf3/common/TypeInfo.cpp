@@ -53,6 +53,7 @@ TypeInfo::TypeInfo()
   regist<std::string>("string");
   regist<bool>("bool");
   regist<cf3::Real>("real");
+  regist<float>("float");
   regist<common::URI>("uri");
   regist<common::UUCount>("uucount");
   regist<std::vector<int> >("array[integer]");
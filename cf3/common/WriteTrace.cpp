@@ -0,0 +1,50 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/Tracer.hpp"
+
+#include "WriteTrace.hpp"
+
+namespace cf3 {
+namespace common {
+
+ComponentBuilder < WriteTrace, Action, LibCommon > WriteTrace_Builder;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+WriteTrace::WriteTrace(const std::string& name): Action(name), m_file("trace.json"), m_clear(true)
+{
+  options().add("file", m_file)
+    .description("Trace file, in Chrome trace JSON format. The rank is appended when running in parallel")
+    .pretty_name("File")
+    .link_to(&m_file)
+    .mark_basic();
+
+  options().add("clear", m_clear)
+    .description("Drop the recorded events after writing them")
+    .pretty_name("Clear")
+    .link_to(&m_clear);
+}
+
+void WriteTrace::execute()
+{
+  Tracer& tracer = Tracer::instance();
+  const Uint nb_dropped = tracer.nb_dropped();
+  if(nb_dropped != 0)
+    CFwarn << "Trace buffers overflowed, " << nb_dropped << " oldest events were dropped. Increase the trace_buffer_size option of the environment." << CFendl;
+
+  tracer.write_chrome_trace(m_file);
+  if(m_clear)
+    tracer.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
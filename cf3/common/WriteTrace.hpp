@@ -0,0 +1,50 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_common_WriteTrace_hpp
+#define cf3_common_WriteTrace_hpp
+
+#include "common/Action.hpp"
+#include "common/URI.hpp"
+
+#include "LibCommon.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace common {
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+/// Write the events recorded by the Tracer to a Chrome trace file, one per rank.
+/// Tracing is enabled through the "trace" option of the Environment.
+class Common_API WriteTrace : public Action
+{
+public: // functions
+
+  /// Contructor
+  /// @param name of the component
+  WriteTrace ( const std::string& name );
+
+  /// Get the class name
+  static std::string type_name () { return "WriteTrace"; }
+
+  virtual void execute();
+private:
+  /// File to write to
+  URI m_file;
+  /// True if the recorded events are dropped after writing
+  bool m_clear;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+} // common
+} // cf3
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_common_WriteTrace_hpp
@@ -0,0 +1,681 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+
+#include "common/BasicExceptions.hpp"
+
+#include "math/CompiledFunction.hpp"
+#include "math/Consts.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/// Epsilon used in the comparisons, as in the FunctionParser
+const Real comparison_epsilon = 1e-14;
+
+enum OpCode
+{
+  OP_COPY, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD, OP_POW, OP_NEG, OP_SQR, OP_CUBE,
+  OP_NOT, OP_AND, OP_OR, OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE, OP_IF,
+  OP_ABS, OP_ACOS, OP_ACOSH, OP_ASIN, OP_ASINH, OP_ATAN, OP_ATAN2, OP_ATANH, OP_CBRT, OP_CEIL,
+  OP_COS, OP_COSH, OP_COT, OP_CSC, OP_EXP, OP_EXP2, OP_FLOOR, OP_HYPOT, OP_INT, OP_LOG,
+  OP_LOG2, OP_LOG10, OP_MAX, OP_MIN, OP_SEC, OP_SIN, OP_SINH, OP_SQRT, OP_TAN, OP_TANH,
+  OP_TRUNC
+};
+
+/// Scalar semantics of each operation, matching the FunctionParser
+inline Real truth(const Real a) { return std::abs(a) >= 0.5; }
+inline Real cbrt(const Real a) { return a > 0. ? std::exp(std::log(a) / 3.) : (a < 0. ? -std::exp(std::log(-a) / 3.) : 0.); }
+inline Real trunc(const Real a) { return a < 0. ? std::ceil(a) : std::floor(a); }
+inline Real round(const Real a) { return a < 0. ? std::ceil(a - 0.5) : std::floor(a + 0.5); }
+
+/// Power function, allowing roots of negative numbers with odd denominators as the FunctionParser does
+inline Real power(const Real x, const Real y)
+{
+  if(x == 1. || y == std::floor(y) || x == 0.)
+    return std::pow(x, y);
+  if(x > 0.)
+    return std::exp(std::log(x) * y);
+  if(y*16. != std::floor(y*16.))
+    return -std::exp(std::log(-x) * y);
+  return std::pow(x, y);
+}
+
+/// Apply a unary function to a range of values
+template<typename FunctorT>
+inline void unary_loop(const FunctorT& f, Real* result, const Real* a, const Uint n)
+{
+  for(Uint i = 0; i != n; ++i)
+    result[i] = f(a[i]);
+}
+
+/// Apply a binary function to a range of values
+template<typename FunctorT>
+inline void binary_loop(const FunctorT& f, Real* result, const Real* a, const Real* b, const Uint n)
+{
+  for(Uint i = 0; i != n; ++i)
+    result[i] = f(a[i], b[i]);
+}
+
+#define CF3_UNARY_FUNCTOR(name, expr) struct name { Real operator()(const Real a) const { return expr; } };
+#define CF3_BINARY_FUNCTOR(name, expr) struct name { Real operator()(const Real a, const Real b) const { return expr; } };
+
+CF3_UNARY_FUNCTOR(AcosF, std::acos(a))
+CF3_UNARY_FUNCTOR(AcoshF, std::log(a + std::sqrt(a*a - 1.)))
+CF3_UNARY_FUNCTOR(AsinF, std::asin(a))
+CF3_UNARY_FUNCTOR(AsinhF, std::log(a + std::sqrt(a*a + 1.)))
+CF3_UNARY_FUNCTOR(AtanF, std::atan(a))
+CF3_UNARY_FUNCTOR(AtanhF, std::log((1. + a) / (1. - a)) * 0.5)
+CF3_UNARY_FUNCTOR(CbrtF, cbrt(a))
+CF3_UNARY_FUNCTOR(CeilF, std::ceil(a))
+CF3_UNARY_FUNCTOR(CosF, std::cos(a))
+CF3_UNARY_FUNCTOR(CoshF, std::cosh(a))
+CF3_UNARY_FUNCTOR(CotF, 1. / std::tan(a))
+CF3_UNARY_FUNCTOR(CscF, 1. / std::sin(a))
+CF3_UNARY_FUNCTOR(ExpF, std::exp(a))
+CF3_UNARY_FUNCTOR(Exp2F, power(2., a))
+CF3_UNARY_FUNCTOR(FloorF, std::floor(a))
+CF3_UNARY_FUNCTOR(IntF, round(a))
+CF3_UNARY_FUNCTOR(LogF, std::log(a))
+CF3_UNARY_FUNCTOR(Log2F, std::log(a) * 1.4426950408889634074)
+CF3_UNARY_FUNCTOR(Log10F, std::log10(a))
+CF3_UNARY_FUNCTOR(SecF, 1. / std::cos(a))
+CF3_UNARY_FUNCTOR(SinF, std::sin(a))
+CF3_UNARY_FUNCTOR(SinhF, std::sinh(a))
+CF3_UNARY_FUNCTOR(SqrtF, std::sqrt(a))
+CF3_UNARY_FUNCTOR(TanF, std::tan(a))
+CF3_UNARY_FUNCTOR(TanhF, std::tanh(a))
+CF3_UNARY_FUNCTOR(TruncF, trunc(a))
+CF3_BINARY_FUNCTOR(ModF, std::fmod(a, b))
+CF3_BINARY_FUNCTOR(PowF, power(a, b))
+CF3_BINARY_FUNCTOR(Atan2F, std::atan2(a, b))
+CF3_BINARY_FUNCTOR(HypotF, std::sqrt(a*a + b*b))
+
+#undef CF3_UNARY_FUNCTOR
+#undef CF3_BINARY_FUNCTOR
+
+/// Execute an instruction on the first n values of each register, with the given distance between registers
+void execute(const CompiledFunction::Instruction& instruction, Real* registers, const Uint stride, const Uint n)
+{
+  Real* r = registers + instruction.result*stride;
+  const Real* a = registers + instruction.arguments[0]*stride;
+  const Real* b = registers + instruction.arguments[1]*stride;
+  const Real* c = registers + instruction.arguments[2]*stride;
+
+  // The simple operations are written out, so they vectorise
+  switch(instruction.opcode)
+  {
+  case OP_COPY:  for(Uint i = 0; i != n; ++i) r[i] = a[i]; break;
+  case OP_ADD:   for(Uint i = 0; i != n; ++i) r[i] = a[i] + b[i]; break;
+  case OP_SUB:   for(Uint i = 0; i != n; ++i) r[i] = a[i] - b[i]; break;
+  case OP_MUL:   for(Uint i = 0; i != n; ++i) r[i] = a[i] * b[i]; break;
+  case OP_DIV:   for(Uint i = 0; i != n; ++i) r[i] = a[i] / b[i]; break;
+  case OP_NEG:   for(Uint i = 0; i != n; ++i) r[i] = -a[i]; break;
+  case OP_SQR:   for(Uint i = 0; i != n; ++i) r[i] = a[i] * a[i]; break;
+  case OP_CUBE:  for(Uint i = 0; i != n; ++i) r[i] = a[i] * a[i] * a[i]; break;
+  case OP_ABS:   for(Uint i = 0; i != n; ++i) r[i] = std::abs(a[i]); break;
+  case OP_MIN:   for(Uint i = 0; i != n; ++i) r[i] = a[i] < b[i] ? a[i] : b[i]; break;
+  case OP_MAX:   for(Uint i = 0; i != n; ++i) r[i] = a[i] > b[i] ? a[i] : b[i]; break;
+  case OP_NOT:   for(Uint i = 0; i != n; ++i) r[i] = 1. - truth(a[i]); break;
+  case OP_AND:   for(Uint i = 0; i != n; ++i) r[i] = truth(a[i]) * truth(b[i]); break;
+  case OP_OR:    for(Uint i = 0; i != n; ++i) r[i] = std::max(truth(a[i]), truth(b[i])); break;
+  case OP_EQ:    for(Uint i = 0; i != n; ++i) r[i] = std::abs(a[i] - b[i]) <= comparison_epsilon; break;
+  case OP_NE:    for(Uint i = 0; i != n; ++i) r[i] = std::abs(a[i] - b[i]) > comparison_epsilon; break;
+  case OP_LT:    for(Uint i = 0; i != n; ++i) r[i] = a[i] < b[i] - comparison_epsilon; break;
+  case OP_LE:    for(Uint i = 0; i != n; ++i) r[i] = a[i] <= b[i] + comparison_epsilon; break;
+  case OP_GT:    for(Uint i = 0; i != n; ++i) r[i] = b[i] < a[i] - comparison_epsilon; break;
+  case OP_GE:    for(Uint i = 0; i != n; ++i) r[i] = b[i] <= a[i] + comparison_epsilon; break;
+  case OP_IF:    for(Uint i = 0; i != n; ++i) r[i] = truth(a[i]) != 0. ? b[i] : c[i]; break;
+  case OP_MOD:   binary_loop(ModF(), r, a, b, n); break;
+  case OP_POW:   binary_loop(PowF(), r, a, b, n); break;
+  case OP_ATAN2: binary_loop(Atan2F(), r, a, b, n); break;
+  case OP_HYPOT: binary_loop(HypotF(), r, a, b, n); break;
+  case OP_ACOS:  unary_loop(AcosF(), r, a, n); break;
+  case OP_ACOSH: unary_loop(AcoshF(), r, a, n); break;
+  case OP_ASIN:  unary_loop(AsinF(), r, a, n); break;
+  case OP_ASINH: unary_loop(AsinhF(), r, a, n); break;
+  case OP_ATAN:  unary_loop(AtanF(), r, a, n); break;
+  case OP_ATANH: unary_loop(AtanhF(), r, a, n); break;
+  case OP_CBRT:  unary_loop(CbrtF(), r, a, n); break;
+  case OP_CEIL:  unary_loop(CeilF(), r, a, n); break;
+  case OP_COS:   unary_loop(CosF(), r, a, n); break;
+  case OP_COSH:  unary_loop(CoshF(), r, a, n); break;
+  case OP_COT:   unary_loop(CotF(), r, a, n); break;
+  case OP_CSC:   unary_loop(CscF(), r, a, n); break;
+  case OP_EXP:   unary_loop(ExpF(), r, a, n); break;
+  case OP_EXP2:  unary_loop(Exp2F(), r, a, n); break;
+  case OP_FLOOR: unary_loop(FloorF(), r, a, n); break;
+  case OP_INT:   unary_loop(IntF(), r, a, n); break;
+  case OP_LOG:   unary_loop(LogF(), r, a, n); break;
+  case OP_LOG2:  unary_loop(Log2F(), r, a, n); break;
+  case OP_LOG10: unary_loop(Log10F(), r, a, n); break;
+  case OP_SEC:   unary_loop(SecF(), r, a, n); break;
+  case OP_SIN:   unary_loop(SinF(), r, a, n); break;
+  case OP_SINH:  unary_loop(SinhF(), r, a, n); break;
+  case OP_SQRT:  unary_loop(SqrtF(), r, a, n); break;
+  case OP_TAN:   unary_loop(TanF(), r, a, n); break;
+  case OP_TANH:  unary_loop(TanhF(), r, a, n); break;
+  case OP_TRUNC: unary_loop(TruncF(), r, a, n); break;
+  default:
+    cf3_assert(false);
+  }
+}
+
+/// Functions known to the compiler
+struct FunctionInfo
+{
+  FunctionInfo(const Uint op = OP_COPY, const Uint nargs = 1, const bool is_safe = false) : opcode(op), nb_args(nargs), safe(is_safe) {}
+  Uint opcode;
+  Uint nb_args;
+  /// True if the function can not raise a floating point exception
+  bool safe;
+};
+
+const std::map<std::string, FunctionInfo>& function_table()
+{
+  static std::map<std::string, FunctionInfo> table;
+  if(table.empty())
+  {
+    table["abs"] = FunctionInfo(OP_ABS, 1, true);
+    table["acos"] = FunctionInfo(OP_ACOS);
+    table["acosh"] = FunctionInfo(OP_ACOSH);
+    table["asin"] = FunctionInfo(OP_ASIN);
+    table["asinh"] = FunctionInfo(OP_ASINH);
+    table["atan"] = FunctionInfo(OP_ATAN, 1, true);
+    table["atan2"] = FunctionInfo(OP_ATAN2, 2);
+    table["atanh"] = FunctionInfo(OP_ATANH);
+    table["cbrt"] = FunctionInfo(OP_CBRT);
+    table["ceil"] = FunctionInfo(OP_CEIL, 1, true);
+    table["cos"] = FunctionInfo(OP_COS, 1, true);
+    table["cosh"] = FunctionInfo(OP_COSH);
+    table["cot"] = FunctionInfo(OP_COT);
+    table["csc"] = FunctionInfo(OP_CSC);
+    table["exp"] = FunctionInfo(OP_EXP);
+    table["exp2"] = FunctionInfo(OP_EXP2);
+    table["floor"] = FunctionInfo(OP_FLOOR, 1, true);
+    table["hypot"] = FunctionInfo(OP_HYPOT, 2);
+    table["if"] = FunctionInfo(OP_IF, 3, true);
+    table["int"] = FunctionInfo(OP_INT, 1, true);
+    table["log"] = FunctionInfo(OP_LOG);
+    table["log2"] = FunctionInfo(OP_LOG2);
+    table["log10"] = FunctionInfo(OP_LOG10);
+    table["max"] = FunctionInfo(OP_MAX, 2, true);
+    table["min"] = FunctionInfo(OP_MIN, 2, true);
+    table["pow"] = FunctionInfo(OP_POW, 2);
+    table["sec"] = FunctionInfo(OP_SEC);
+    table["sin"] = FunctionInfo(OP_SIN, 1, true);
+    table["sinh"] = FunctionInfo(OP_SINH);
+    table["sqrt"] = FunctionInfo(OP_SQRT);
+    table["tan"] = FunctionInfo(OP_TAN);
+    table["tanh"] = FunctionInfo(OP_TANH, 1, true);
+    table["trunc"] = FunctionInfo(OP_TRUNC, 1, true);
+  }
+  return table;
+}
+
+/// Thrown when an expression can't be compiled
+struct Unsupported {};
+
+/// Result of a subexpression: either a compile-time constant or a register
+struct Value
+{
+  Value() : is_constant(false), constant(0.), reg(0), safe(true) {}
+  explicit Value(const Real c) : is_constant(true), constant(c), reg(0), safe(true) {}
+
+  bool is_constant;
+  Real constant;
+  Uint reg;
+  /// True if the computation of the value can not raise a floating point exception
+  bool safe;
+};
+
+/// Recursive descent parser for the FunctionParser syntax, emitting bytecode. During compilation,
+/// registers are numbered separately for variables, constants and temporaries, and renumbered at the end
+class Compiler
+{
+public:
+  static const Uint constant_base = 1u << 20;
+  static const Uint temporary_base = 1u << 21;
+
+  Compiler(const std::vector<std::string>& variables, std::vector<CompiledFunction::Instruction>& program) :
+    m_program(program),
+    m_nb_temporaries(0)
+  {
+    for(Uint i = 0; i != variables.size(); ++i)
+      m_variables[variables[i]] = i;
+  }
+
+  /// Compile a function, returning the register holding the result
+  Uint compile(const std::string& function)
+  {
+    m_str = function;
+    m_pos = 0;
+    Value result = parse_or();
+    skip_whitespace();
+    if(m_pos != m_str.size())
+      throw Unsupported();
+    return register_of(result);
+  }
+
+  /// Renumber registers, so variables come first, followed by constants and temporaries
+  Uint renumber(const Uint reg, const Uint nbvars) const
+  {
+    if(reg >= temporary_base)
+      return reg - temporary_base + nbvars + m_constants.size();
+    if(reg >= constant_base)
+      return reg - constant_base + nbvars;
+    return reg;
+  }
+
+  const std::vector<Real>& constants() const { return m_constants; }
+  Uint nb_temporaries() const { return m_nb_temporaries; }
+
+private:
+  void skip_whitespace()
+  {
+    while(m_pos < m_str.size() && std::isspace(static_cast<unsigned char>(m_str[m_pos])))
+      ++m_pos;
+  }
+
+  /// Consume the given token, if present
+  bool accept(const char* token)
+  {
+    skip_whitespace();
+    const std::string tok(token);
+    if(m_str.compare(m_pos, tok.size(), tok) != 0)
+      return false;
+    m_pos += tok.size();
+    return true;
+  }
+
+  void expect(const char* token)
+  {
+    if(!accept(token))
+      throw Unsupported();
+  }
+
+  Uint register_of(const Value& v)
+  {
+    if(!v.is_constant)
+      return v.reg;
+    m_constants.push_back(v.constant);
+    return constant_base + m_constants.size() - 1;
+  }
+
+  void release(const Value& v)
+  {
+    if(!v.is_constant && v.reg >= temporary_base)
+      m_free_temporaries.push_back(v.reg);
+  }
+
+  Uint allocate()
+  {
+    if(m_free_temporaries.empty())
+      return temporary_base + m_nb_temporaries++;
+    const Uint result = m_free_temporaries.back();
+    m_free_temporaries.pop_back();
+    return result;
+  }
+
+  /// Emit an instruction, or fold it if all arguments are constant
+  Value emit(const Uint opcode, const std::vector<Value>& args, const bool safe)
+  {
+    bool all_constant = true;
+    bool all_safe = safe;
+    for(Uint i = 0; i != args.size(); ++i)
+    {
+      all_constant = all_constant && args[i].is_constant;
+      all_safe = all_safe && args[i].safe;
+    }
+
+    CompiledFunction::Instruction instruction;
+    instruction.opcode = opcode;
+    if(all_constant)
+    {
+      Real registers[4] = {0., 0., 0., 0.};
+      for(Uint i = 0; i != args.size(); ++i)
+      {
+        registers[i] = args[i].constant;
+        instruction.arguments[i] = i;
+      }
+      for(Uint i = args.size(); i != 3; ++i)
+        instruction.arguments[i] = 0;
+      instruction.result = 3;
+      execute(instruction, registers, 1, 1);
+      return Value(registers[3]);
+    }
+
+    for(Uint i = 0; i != 3; ++i)
+      instruction.arguments[i] = i < args.size() ? register_of(args[i]) : instruction.arguments[0];
+    for(Uint i = args.size(); i != 0; --i)
+      release(args[i-1]);
+
+    Value result;
+    result.reg = allocate();
+    result.safe = all_safe;
+    instruction.result = result.reg;
+    m_program.push_back(instruction);
+    return result;
+  }
+
+  Value emit(const Uint opcode, const Value& a, const bool safe)
+  {
+    return emit(opcode, std::vector<Value>(1, a), safe);
+  }
+
+  Value emit(const Uint opcode, const Value& a, const Value& b, const bool safe)
+  {
+    std::vector<Value> args(1, a);
+    args.push_back(b);
+    return emit(opcode, args, safe);
+  }
+
+  /// Logical operators and the second and third arguments of if are only evaluated when needed by the FunctionParser.
+  /// Since the compiled code evaluates them always, they must not raise floating point exceptions
+  void check_conditional(const Value& v)
+  {
+    if(!v.safe)
+      throw Unsupported();
+  }
+
+  Value parse_or()
+  {
+    Value result = parse_and();
+    while(accept("|"))
+    {
+      const Value rhs = parse_and();
+      check_conditional(rhs);
+      result = emit(OP_OR, result, rhs, true);
+    }
+    return result;
+  }
+
+  Value parse_and()
+  {
+    Value result = parse_comparison();
+    while(accept("&"))
+    {
+      const Value rhs = parse_comparison();
+      check_conditional(rhs);
+      result = emit(OP_AND, result, rhs, true);
+    }
+    return result;
+  }
+
+  Value parse_comparison()
+  {
+    Value result = parse_additive();
+    while(true)
+    {
+      Uint opcode;
+      if(accept("!=")) opcode = OP_NE;
+      else if(accept("<=")) opcode = OP_LE;
+      else if(accept(">=")) opcode = OP_GE;
+      else if(accept("=")) opcode = OP_EQ;
+      else if(accept("<")) opcode = OP_LT;
+      else if(accept(">")) opcode = OP_GT;
+      else break;
+      const Value rhs = parse_additive();
+      result = emit(opcode, result, rhs, true);
+    }
+    return result;
+  }
+
+  Value parse_additive()
+  {
+    Value result = parse_multiplicative();
+    while(true)
+    {
+      Uint opcode;
+      if(accept("+")) opcode = OP_ADD;
+      else if(accept("-")) opcode = OP_SUB;
+      else break;
+      const Value rhs = parse_multiplicative();
+      result = emit(opcode, result, rhs, true);
+    }
+    return result;
+  }
+
+  Value parse_multiplicative()
+  {
+    Value result = parse_unary();
+    while(true)
+    {
+      Uint opcode;
+      if(accept("*")) opcode = OP_MUL;
+      else if(accept("/")) opcode = OP_DIV;
+      else if(accept("%")) opcode = OP_MOD;
+      else break;
+      const Value rhs = parse_unary();
+      result = emit(opcode, result, rhs, opcode == OP_MUL);
+    }
+    return result;
+  }
+
+  Value parse_unary()
+  {
+    if(accept("-"))
+      return emit(OP_NEG, parse_unary(), true);
+    if(accept("!"))
+      return emit(OP_NOT, parse_unary(), true);
+    return parse_power();
+  }
+
+  /// Exponentiation binds stronger than unary minus, but the exponent may have a sign
+  Value parse_power()
+  {
+    const Value base = parse_primary();
+    if(!accept("^"))
+      return base;
+    const Value exponent = parse_unary();
+    if(exponent.is_constant && !base.is_constant)
+    {
+      if(exponent.constant == 1.)
+        return base;
+      if(exponent.constant == 2.)
+        return emit(OP_SQR, base, true);
+      if(exponent.constant == 3.)
+        return emit(OP_CUBE, base, true);
+      if(exponent.constant == 0.5)
+        return emit(OP_SQRT, base, false);
+    }
+    return emit(OP_POW, base, exponent, false);
+  }
+
+  Value parse_primary()
+  {
+    skip_whitespace();
+    if(m_pos == m_str.size())
+      throw Unsupported();
+
+    if(accept("("))
+    {
+      const Value result = parse_or();
+      expect(")");
+      return result;
+    }
+
+    const unsigned char c = m_str[m_pos];
+    if(std::isdigit(c) || c == '.')
+    {
+      const char* begin = m_str.c_str() + m_pos;
+      char* end = 0;
+      const Real result = std::strtod(begin, &end);
+      if(end == begin)
+        throw Unsupported();
+      m_pos += end - begin;
+      return Value(result);
+    }
+
+    if(!std::isalpha(c) && c != '_')
+      throw Unsupported();
+
+    const std::string::size_type start = m_pos;
+    while(m_pos < m_str.size() && (std::isalnum(static_cast<unsigned char>(m_str[m_pos])) || m_str[m_pos] == '_'))
+      ++m_pos;
+    const std::string identifier = m_str.substr(start, m_pos - start);
+
+    const std::map<std::string, Uint>::const_iterator var = m_variables.find(identifier);
+    if(var != m_variables.end())
+    {
+      Value result;
+      result.reg = var->second;
+      return result;
+    }
+
+    if(identifier == "pi")
+      return Value(Consts::pi());
+
+    const std::map<std::string, FunctionInfo>::const_iterator func = function_table().find(identifier);
+    if(func == function_table().end())
+      throw Unsupported();
+
+    expect("(");
+    std::vector<Value> args;
+    args.push_back(parse_or());
+    while(accept(","))
+      args.push_back(parse_or());
+    expect(")");
+    if(args.size() != func->second.nb_args)
+      throw Unsupported();
+
+    if(func->second.opcode == OP_IF)
+    {
+      if(args[0].is_constant)
+      {
+        const bool condition = truth(args[0].constant) != 0.;
+        release(condition ? args[2] : args[1]);
+        return condition ? args[1] : args[2];
+      }
+      check_conditional(args[1]);
+      check_conditional(args[2]);
+    }
+
+    return emit(func->second.opcode, args, func->second.safe);
+  }
+
+  std::vector<CompiledFunction::Instruction>& m_program;
+  std::map<std::string, Uint> m_variables;
+  std::vector<Real> m_constants;
+  std::vector<Uint> m_free_temporaries;
+  Uint m_nb_temporaries;
+  std::string m_str;
+  std::string::size_type m_pos;
+};
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+CompiledFunction::CompiledFunction() :
+  m_is_compiled(false),
+  m_nbvars(0),
+  m_nb_registers(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool CompiledFunction::compile(const std::vector<std::string>& functions, const std::vector<std::string>& variables)
+{
+  m_is_compiled = false;
+  m_program.clear();
+  m_outputs.clear();
+  m_nbvars = variables.size();
+
+  std::vector<Instruction> program;
+  Compiler compiler(variables, program);
+  try
+  {
+    for(Uint i = 0; i != functions.size(); ++i)
+    {
+      // The result registers are never released, so they are not overwritten by the next functions
+      m_outputs.push_back(compiler.compile(functions[i]));
+    }
+  }
+  catch(Unsupported&)
+  {
+    m_outputs.clear();
+    return false;
+  }
+
+  // Renumber the registers
+  for(std::vector<Instruction>::iterator it = program.begin(); it != program.end(); ++it)
+  {
+    it->result = compiler.renumber(it->result, m_nbvars);
+    for(Uint i = 0; i != 3; ++i)
+      it->arguments[i] = compiler.renumber(it->arguments[i], m_nbvars);
+  }
+  for(Uint i = 0; i != m_outputs.size(); ++i)
+    m_outputs[i] = compiler.renumber(m_outputs[i], m_nbvars);
+  m_program.swap(program);
+
+  const std::vector<Real>& constants = compiler.constants();
+  m_nb_registers = m_nbvars + constants.size() + compiler.nb_temporaries();
+  m_registers.assign(m_nb_registers*block_size, 0.);
+
+  // Constants are stored once, and never overwritten
+  for(Uint i = 0; i != constants.size(); ++i)
+    std::fill_n(&m_registers[(m_nbvars + i)*block_size], static_cast<Uint>(block_size), constants[i]);
+
+  m_is_compiled = true;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CompiledFunction::evaluate(const Real* variables, const Uint nb_points, Real* results) const
+{
+  cf3_assert(m_is_compiled);
+  const Uint nbfuncs = m_outputs.size();
+  if(nbfuncs == 0)
+    return;
+  Real* registers = &m_registers[0];
+  for(Uint block_begin = 0; block_begin < nb_points; block_begin += block_size)
+  {
+    const Uint n = std::min(static_cast<Uint>(block_size), nb_points - block_begin);
+
+    // Transpose the variables, so each register holds the values of one variable for all points in the block
+    const Real* block_vars = variables + block_begin*m_nbvars;
+    for(Uint var = 0; var != m_nbvars; ++var)
+    {
+      Real* reg = registers + var*block_size;
+      for(Uint i = 0; i != n; ++i)
+        reg[i] = block_vars[i*m_nbvars + var];
+    }
+
+    const std::vector<Instruction>::const_iterator end = m_program.end();
+    for(std::vector<Instruction>::const_iterator it = m_program.begin(); it != end; ++it)
+      execute(*it, registers, block_size, n);
+
+    Real* block_results = results + block_begin*nbfuncs;
+    for(Uint f = 0; f != nbfuncs; ++f)
+    {
+      const Real* reg = registers + m_outputs[f]*block_size;
+      for(Uint i = 0; i != n; ++i)
+        block_results[i*nbfuncs + f] = reg[i];
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // math
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
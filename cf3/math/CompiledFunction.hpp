@@ -0,0 +1,101 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_CompiledFunction_hpp
+#define cf3_Math_CompiledFunction_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+
+#include "math/LibMath.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+
+  namespace math {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Compiles a set of functions, written in the function parser syntax, into a register-based bytecode
+/// that is evaluated over arrays of points. Each instruction is applied to a block of points at once,
+/// so the inner loops are simple array operations that the compiler can vectorise.
+/// Constant subexpressions are folded and integer powers are replaced by multiplications.
+/// Evaluation uses internal scratch storage, so a single instance may not be evaluated from multiple threads
+/// at the same time (just like the FunctionParser).
+class Math_API CompiledFunction {
+
+public: // functions
+
+  /// Number of points processed by each instruction
+  static const Uint block_size = 64;
+
+  /// Empty constructor
+  CompiledFunction();
+
+  /// Compile the given functions of the given variables. The constant pi is predefined.
+  /// @return false if a function uses syntax that is not supported by the compiler, in which case the
+  /// caller should fall back to the FunctionParser. Syntax errors are to be detected by the FunctionParser.
+  bool compile(const std::vector<std::string>& functions, const std::vector<std::string>& variables);
+
+  /// True if compile succeeded
+  bool is_compiled() const { return m_is_compiled; }
+
+  /// Number of variables
+  Uint nbvars() const { return m_nbvars; }
+
+  /// Number of functions
+  Uint nbfuncs() const { return m_outputs.size(); }
+
+  /// Number of bytecode instructions, after optimization
+  Uint nb_instructions() const { return m_program.size(); }
+
+  /// Evaluate all functions for nb_points points.
+  /// @param variables Values of the variables, stored per point (nb_points rows of nbvars() values)
+  /// @param nb_points Number of points to evaluate
+  /// @param results Function values, stored per point (nb_points rows of nbfuncs() values)
+  void evaluate(const Real* variables, const Uint nb_points, Real* results) const;
+
+  /// Bytecode instruction, applied element-wise to registers
+  struct Instruction
+  {
+    Uint opcode;
+    Uint result;
+    Uint arguments[3];
+  };
+
+private:
+
+  /// flag to indicate if the functions have been compiled
+  bool m_is_compiled;
+
+  /// number of variables
+  Uint m_nbvars;
+
+  /// Total number of registers. The first registers hold the variables, followed by the constants and the temporaries
+  Uint m_nb_registers;
+
+  /// The instructions
+  std::vector<Instruction> m_program;
+
+  /// Register holding the result of each function
+  std::vector<Uint> m_outputs;
+
+  /// Register storage, block_size values per register. The constants are stored at compile time
+  mutable std::vector<Real> m_registers;
+
+}; // CompiledFunction
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // math
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_Math_CompiledFunction_hpp
@@ -0,0 +1,1133 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "common/Builder.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+#include "common/ThreadPool.hpp"
+
+#include "common/PE/Comm.hpp"
+#include "common/PE/operations.hpp"
+
+#include "AMGStrategy.hpp"
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+common::ComponentBuilder<AMGStrategy, SolutionStrategy, LibLSS> AMGStrategy_builder;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+const Uint invalid_index = std::numeric_limits<Uint>::max();
+
+/// Local sparse matrix in compressed row storage, used for all operators in the hierarchy
+template<typename ValueT>
+struct CrsDataT
+{
+  CrsDataT() : nb_rows(0), nb_cols(0) {}
+
+  Uint nnz() const { return columns.size(); }
+
+  /// Copy, converting the values to a different type
+  template<typename OtherT>
+  void assign(const CrsDataT<OtherT>& other)
+  {
+    nb_rows = other.nb_rows;
+    nb_cols = other.nb_cols;
+    starts = other.starts;
+    columns = other.columns;
+    values.assign(other.values.begin(), other.values.end());
+  }
+
+  std::size_t memory_footprint() const
+  {
+    return starts.capacity()*sizeof(Uint) + columns.capacity()*sizeof(Uint) + values.capacity()*sizeof(ValueT);
+  }
+
+  Uint nb_rows;
+  Uint nb_cols;
+  std::vector<Uint> starts;
+  std::vector<Uint> columns;
+  std::vector<ValueT> values;
+};
+
+typedef CrsDataT<Real> CrsData;
+
+/// Run f over the range [0, n) using the thread pool, unless the range is too small for threading to pay off
+template<typename FunctorT>
+void parallel_rows(const Uint n, const FunctorT& f)
+{
+  common::ThreadPool& pool = common::ThreadPool::instance();
+  if(n < 4096 || pool.nb_threads() == 1)
+    f(0, n, 0);
+  else
+    pool.parallel_for(0, n, common::ThreadPool::RangeFunctionT(f));
+}
+
+/// y = A*x
+template<typename ValueT>
+struct MatVec
+{
+  MatVec(const CrsDataT<ValueT>& a, const ValueT* x, ValueT* y) : m_a(a), m_x(x), m_y(y) {}
+
+  void operator()(const Uint begin, const Uint end, const Uint) const
+  {
+    const Uint* starts = &m_a.starts[0];
+    const Uint* columns = m_a.columns.empty() ? 0 : &m_a.columns[0];
+    const ValueT* values = m_a.values.empty() ? 0 : &m_a.values[0];
+    for(Uint i = begin; i != end; ++i)
+    {
+      ValueT sum = 0.;
+      for(Uint j = starts[i]; j != starts[i+1]; ++j)
+        sum += values[j] * m_x[columns[j]];
+      m_y[i] = sum;
+    }
+  }
+
+  const CrsDataT<ValueT>& m_a;
+  const ValueT* m_x;
+  ValueT* m_y;
+};
+
+/// r = b - A*x
+template<typename ValueT>
+struct Residual
+{
+  Residual(const CrsDataT<ValueT>& a, const ValueT* b, const ValueT* x, ValueT* r) : m_a(a), m_b(b), m_x(x), m_r(r) {}
+
+  void operator()(const Uint begin, const Uint end, const Uint) const
+  {
+    const Uint* starts = &m_a.starts[0];
+    const Uint* columns = m_a.columns.empty() ? 0 : &m_a.columns[0];
+    const ValueT* values = m_a.values.empty() ? 0 : &m_a.values[0];
+    for(Uint i = begin; i != end; ++i)
+    {
+      ValueT sum = m_b[i];
+      for(Uint j = starts[i]; j != starts[i+1]; ++j)
+        sum -= values[j] * m_x[columns[j]];
+      m_r[i] = sum;
+    }
+  }
+
+  const CrsDataT<ValueT>& m_a;
+  const ValueT* m_b;
+  const ValueT* m_x;
+  ValueT* m_r;
+};
+
+/// d = alpha*d + beta*D^-1*r, followed by x += d. Covers both the Jacobi and the Chebyshev update
+template<typename ValueT>
+struct SmootherUpdate
+{
+  SmootherUpdate(const ValueT* inv_diag, const ValueT* r, ValueT* d, ValueT* x, const Real alpha, const Real beta) :
+    m_inv_diag(inv_diag), m_r(r), m_d(d), m_x(x), m_alpha(alpha), m_beta(beta)
+  {
+  }
+
+  void operator()(const Uint begin, const Uint end, const Uint) const
+  {
+    for(Uint i = begin; i != end; ++i)
+    {
+      m_d[i] = m_alpha*m_d[i] + m_beta*m_inv_diag[i]*m_r[i];
+      m_x[i] += m_d[i];
+    }
+  }
+
+  const ValueT* m_inv_diag;
+  const ValueT* m_r;
+  ValueT* m_d;
+  ValueT* m_x;
+  const ValueT m_alpha;
+  const ValueT m_beta;
+};
+
+/// C = A*B, using Gustavson's row-by-row algorithm
+void multiply(const CrsData& a, const CrsData& b, CrsData& c)
+{
+  cf3_assert(a.nb_cols == b.nb_rows);
+  c.nb_rows = a.nb_rows;
+  c.nb_cols = b.nb_cols;
+  c.starts.assign(a.nb_rows+1, 0);
+  c.columns.clear();
+  c.values.clear();
+  std::vector<Uint> position(b.nb_cols, invalid_index);
+  for(Uint i = 0; i != a.nb_rows; ++i)
+  {
+    const Uint row_begin = c.columns.size();
+    for(Uint ja = a.starts[i]; ja != a.starts[i+1]; ++ja)
+    {
+      const Uint k = a.columns[ja];
+      const Real a_ik = a.values[ja];
+      for(Uint jb = b.starts[k]; jb != b.starts[k+1]; ++jb)
+      {
+        const Uint j = b.columns[jb];
+        if(position[j] == invalid_index || position[j] < row_begin)
+        {
+          position[j] = c.columns.size();
+          c.columns.push_back(j);
+          c.values.push_back(a_ik*b.values[jb]);
+        }
+        else
+        {
+          c.values[position[j]] += a_ik*b.values[jb];
+        }
+      }
+    }
+    c.starts[i+1] = c.columns.size();
+  }
+}
+
+/// T = A^T
+void transpose(const CrsData& a, CrsData& t)
+{
+  t.nb_rows = a.nb_cols;
+  t.nb_cols = a.nb_rows;
+  t.starts.assign(t.nb_rows+1, 0);
+  t.columns.resize(a.nnz());
+  t.values.resize(a.nnz());
+  for(Uint j = 0; j != a.nnz(); ++j)
+    ++t.starts[a.columns[j]+1];
+  for(Uint i = 0; i != t.nb_rows; ++i)
+    t.starts[i+1] += t.starts[i];
+  std::vector<Uint> fill(t.starts.begin(), t.starts.end()-1);
+  for(Uint i = 0; i != a.nb_rows; ++i)
+  {
+    for(Uint j = a.starts[i]; j != a.starts[i+1]; ++j)
+    {
+      const Uint pos = fill[a.columns[j]]++;
+      t.columns[pos] = i;
+      t.values[pos] = a.values[j];
+    }
+  }
+}
+
+/// Inverse of the diagonal, 0 for rows without a diagonal entry so the smoothers leave them alone
+void inverse_diagonal(const CrsData& a, std::vector<Real>& inv_diag)
+{
+  inv_diag.assign(a.nb_rows, 0.);
+  for(Uint i = 0; i != a.nb_rows; ++i)
+  {
+    for(Uint j = a.starts[i]; j != a.starts[i+1]; ++j)
+    {
+      if(a.columns[j] == i && a.values[j] != 0.)
+        inv_diag[i] = 1. / a.values[j];
+    }
+  }
+}
+
+/// Upper bound for the eigenvalues of D^-1*A from the Gershgorin discs. Power iterations converge too slowly
+/// on the clustered high end of the spectrum, and an underestimate makes the Chebyshev smoother amplify those modes
+Real spectral_radius_bound(const CrsData& a, const std::vector<Real>& inv_diag)
+{
+  Real bound = 0.;
+  for(Uint i = 0; i != a.nb_rows; ++i)
+  {
+    Real row_sum = 0.;
+    for(Uint j = a.starts[i]; j != a.starts[i+1]; ++j)
+      row_sum += std::abs(a.values[j]);
+    bound = std::max(bound, row_sum*std::abs(inv_diag[i]));
+  }
+  return bound > 0. ? bound : 1.;
+}
+
+/// Greedy aggregation based on the strength of connection |a_ij| >= theta*sqrt(|a_ii*a_jj|).
+/// Nodes without strong connections (e.g. Dirichlet rows) are not aggregated and get invalid_index.
+/// Returns the number of aggregates
+Uint aggregate(const CrsData& a, const Real theta, std::vector<Uint>& aggregates)
+{
+  const Uint n = a.nb_rows;
+
+  std::vector<Real> diag(n, 0.);
+  for(Uint i = 0; i != n; ++i)
+    for(Uint j = a.starts[i]; j != a.starts[i+1]; ++j)
+      if(a.columns[j] == i)
+        diag[i] = std::abs(a.values[j]);
+
+  // Strong connections, stored as a mask over the matrix entries
+  std::vector<bool> strong(a.nnz(), false);
+  std::vector<bool> isolated(n, true);
+  for(Uint i = 0; i != n; ++i)
+  {
+    for(Uint j = a.starts[i]; j != a.starts[i+1]; ++j)
+    {
+      const Uint col = a.columns[j];
+      if(col != i && std::abs(a.values[j]) >= theta*std::sqrt(diag[i]*diag[col]) && a.values[j] != 0.)
+      {
+        strong[j] = true;
+        isolated[i] = false;
+      }
+    }
+  }
+
+  aggregates.assign(n, invalid_index);
+  Uint nb_aggregates = 0;
+
+  // Phase 1: a node with only unaggregated strong neighbours starts a new aggregate together with them
+  for(Uint i = 0; i != n; ++i)
+  {
+    if(isolated[i] || aggregates[i] != invalid_index)
+      continue;
+    bool free_neighbourhood = true;
+    for(Uint j = a.starts[i]; j != a.starts[i+1] && free_neighbourhood; ++j)
+      if(strong[j] && aggregates[a.columns[j]] != invalid_index)
+        free_neighbourhood = false;
+    if(!free_neighbourhood)
+      continue;
+    aggregates[i] = nb_aggregates;
+    for(Uint j = a.starts[i]; j != a.starts[i+1]; ++j)
+      if(strong[j])
+        aggregates[a.columns[j]] = nb_aggregates;
+    ++nb_aggregates;
+  }
+
+  // Phase 2: attach the remaining nodes to the aggregate they are most strongly connected to
+  std::vector<Uint> phase1_aggregates(aggregates);
+  for(Uint i = 0; i != n; ++i)
+  {
+    if(isolated[i] || aggregates[i] != invalid_index)
+      continue;
+    Real strongest = 0.;
+    for(Uint j = a.starts[i]; j != a.starts[i+1]; ++j)
+    {
+      const Uint agg = phase1_aggregates[a.columns[j]];
+      if(strong[j] && agg != invalid_index && std::abs(a.values[j]) > strongest)
+      {
+        strongest = std::abs(a.values[j]);
+        aggregates[i] = agg;
+      }
+    }
+  }
+
+  // Phase 3: whatever is left forms new aggregates with its unaggregated strong neighbours
+  for(Uint i = 0; i != n; ++i)
+  {
+    if(isolated[i] || aggregates[i] != invalid_index)
+      continue;
+    aggregates[i] = nb_aggregates;
+    for(Uint j = a.starts[i]; j != a.starts[i+1]; ++j)
+      if(strong[j] && aggregates[a.columns[j]] == invalid_index)
+        aggregates[a.columns[j]] = nb_aggregates;
+    ++nb_aggregates;
+  }
+
+  return nb_aggregates;
+}
+
+/// Dense LU factorization with partial pivoting, used on the coarsest level.
+/// Zero pivots, as they occur for singular systems such as a pure Neumann pressure problem, are skipped
+struct DenseLU
+{
+  void factorize(const CrsData& a)
+  {
+    n = a.nb_rows;
+    lu.assign(n*n, 0.);
+    pivots.resize(n);
+    for(Uint i = 0; i != n; ++i)
+      for(Uint j = a.starts[i]; j != a.starts[i+1]; ++j)
+        lu[i*n + a.columns[j]] += a.values[j];
+
+    Real max_entry = 0.;
+    for(Uint i = 0; i != n*n; ++i)
+      max_entry = std::max(max_entry, std::abs(lu[i]));
+    const Real tolerance = 1e-12 * max_entry;
+
+    for(Uint k = 0; k != n; ++k)
+    {
+      Uint pivot = k;
+      for(Uint i = k+1; i < n; ++i)
+        if(std::abs(lu[i*n+k]) > std::abs(lu[pivot*n+k]))
+          pivot = i;
+      pivots[k] = pivot;
+      if(pivot != k)
+        std::swap_ranges(lu.begin() + k*n, lu.begin() + (k+1)*n, lu.begin() + pivot*n);
+      if(std::abs(lu[k*n+k]) <= tolerance)
+      {
+        lu[k*n+k] = 0.;
+        continue;
+      }
+      const Real inv_pivot = 1. / lu[k*n+k];
+      for(Uint i = k+1; i < n; ++i)
+      {
+        Real& l_ik = lu[i*n+k];
+        if(l_ik == 0.)
+          continue;
+        l_ik *= inv_pivot;
+        for(Uint j = k+1; j < n; ++j)
+          lu[i*n+j] -= l_ik*lu[k*n+j];
+      }
+    }
+  }
+
+  void solve(const std::vector<Real>& b, std::vector<Real>& x) const
+  {
+    x = b;
+    for(Uint k = 0; k != n; ++k)
+      if(pivots[k] != k)
+        std::swap(x[k], x[pivots[k]]);
+    for(Uint i = 0; i != n; ++i)
+      for(Uint j = 0; j != i; ++j)
+        x[i] -= lu[i*n+j]*x[j];
+    for(Uint i = n; i-- != 0;)
+    {
+      if(lu[i*n+i] == 0.)
+      {
+        x[i] = 0.;
+        continue;
+      }
+      for(Uint j = i+1; j < n; ++j)
+        x[i] -= lu[i*n+j]*x[j];
+      x[i] /= lu[i*n+i];
+    }
+  }
+
+  Uint n;
+  std::vector<Real> lu;
+  std::vector<Uint> pivots;
+};
+
+/// One level of the hierarchy
+template<typename ValueT>
+struct LevelT
+{
+  LevelT() : lambda_max(1.) {}
+
+  /// Copy, converting the values to a different type
+  template<typename OtherT>
+  void assign(const LevelT<OtherT>& other)
+  {
+    A.assign(other.A);
+    P.assign(other.P);
+    R.assign(other.R);
+    inv_diag.assign(other.inv_diag.begin(), other.inv_diag.end());
+    lambda_max = other.lambda_max;
+    b.assign(other.b.size(), 0.);
+    x.assign(other.x.size(), 0.);
+    r.assign(other.r.size(), 0.);
+    d.assign(other.d.size(), 0.);
+  }
+
+  std::size_t memory_footprint() const
+  {
+    return A.memory_footprint() + P.memory_footprint() + R.memory_footprint()
+      + (inv_diag.capacity() + b.capacity() + x.capacity() + r.capacity() + d.capacity())*sizeof(ValueT);
+  }
+
+  CrsDataT<ValueT> A;
+  /// Prolongation to this level from the next coarser level
+  CrsDataT<ValueT> P;
+  /// Restriction from this level to the next coarser level
+  CrsDataT<ValueT> R;
+  std::vector<ValueT> inv_diag;
+  /// Upper bound for the eigenvalues of D^-1*A
+  Real lambda_max;
+  /// Work vectors
+  std::vector<ValueT> b, x, r, d;
+};
+
+typedef LevelT<Real> Level;
+
+Real elapsed_seconds(const boost::posix_time::ptime& start)
+{
+  return static_cast<Real>((boost::posix_time::microsec_clock::local_time() - start).total_microseconds()) * 1e-6;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+struct AMGStrategy::Implementation
+{
+  Implementation(common::Component& self) :
+    m_self(self),
+    m_coarse_direct(false),
+    m_local_operator_exact(true),
+    m_single_precision(false),
+    m_matrix_generation(0)
+  {
+    m_self.options().add("max_iterations", 500u)
+      .pretty_name("Max Iterations")
+      .description("Maximum number of conjugate gradient iterations")
+      .mark_basic();
+
+    m_self.options().add("tolerance", 1e-8)
+      .pretty_name("Tolerance")
+      .description("Convergence criterion on the residual norm, relative to the norm of the right hand side")
+      .mark_basic();
+
+    m_self.options().add("smoother", std::string("Chebyshev"))
+      .pretty_name("Smoother")
+      .description("Smoother used on all levels but the coarsest: Jacobi or Chebyshev")
+      .mark_basic();
+    m_self.options().option("smoother").restricted_list().push_back(std::string("Jacobi"));
+    m_self.options().option("smoother").restricted_list().push_back(std::string("Chebyshev"));
+
+    m_self.options().add("sweeps", 2u)
+      .pretty_name("Sweeps")
+      .description("Number of Jacobi sweeps or the degree of the Chebyshev polynomial, for both pre- and post-smoothing");
+
+    m_self.options().add("chebyshev_ratio", 30.)
+      .pretty_name("Chebyshev Ratio")
+      .description("Ratio between the largest eigenvalue of D^-1*A and the lower bound of the interval smoothed by the Chebyshev polynomial");
+
+    m_self.options().add("strength_threshold", 0.08)
+      .pretty_name("Strength Threshold")
+      .description("Connections with |a_ij| >= threshold*sqrt(|a_ii*a_jj|) are strong and used for aggregation");
+
+    m_self.options().add("max_levels", 10u)
+      .pretty_name("Max Levels")
+      .description("Maximum number of levels in the hierarchy");
+
+    m_self.options().add("coarse_size", 500u)
+      .pretty_name("Coarse Size")
+      .description("Coarsening stops when a level has at most this number of rows, and that level is solved directly");
+
+    m_self.options().add("reuse_setup", true)
+      .pretty_name("Reuse Setup")
+      .description("Keep the hierarchy for as long as the matrix is not modified. If false, the hierarchy is rebuilt for every solve");
+
+    m_self.options().add("single_precision_preconditioner", false)
+      .pretty_name("Single Precision Preconditioner")
+      .description("Store the hierarchy in single precision and apply the V-cycle in single precision, halving its memory traffic. "
+                   "The conjugate gradient iterations remain in double precision");
+
+    m_self.options().add("compute_residual", false)
+      .pretty_name("Compute Residual")
+      .description("Print the residual after each solve");
+
+    m_self.properties().add("iterations", 0u);
+    m_self.properties().add("residual", 0.);
+    m_self.properties().add("setup_time", 0.);
+    m_self.properties().add("solve_time", 0.);
+    m_self.properties().add("nb_setups", 0u);
+  }
+
+  void reset_hierarchy()
+  {
+    m_levels.clear();
+    m_single_levels.clear();
+  }
+
+  Uint nb_levels() const
+  {
+    return m_single_precision ? m_single_levels.size() : m_levels.size();
+  }
+
+  std::size_t memory_footprint() const
+  {
+    std::size_t result = m_coarse_lu.lu.capacity()*sizeof(Real);
+    for(Uint l = 0; l != m_levels.size(); ++l)
+      result += m_levels[l].memory_footprint();
+    for(Uint l = 0; l != m_single_levels.size(); ++l)
+      result += m_single_levels[l].memory_footprint();
+    return result;
+  }
+
+  /// Extract the owned part of the matrix, as a local matrix over the owned rows
+  void extract_matrix(CrsData& a)
+  {
+    std::vector<Uint> rows, cols;
+    std::vector<Real> values;
+    m_matrix->debug_data(rows, cols, values);
+
+    const Uint nb_process_rows = m_rhs->blockrow_size() * m_rhs->neq();
+    m_process_to_local.assign(nb_process_rows, invalid_index);
+    for(Uint i = 0; i != rows.size(); ++i)
+      m_process_to_local[rows[i]] = 0;
+    m_owned_rows.clear();
+    for(Uint i = 0; i != nb_process_rows; ++i)
+    {
+      if(m_process_to_local[i] != invalid_index)
+      {
+        m_process_to_local[i] = m_owned_rows.size();
+        m_owned_rows.push_back(i);
+      }
+    }
+
+    const Uint n = m_owned_rows.size();
+    a.nb_rows = n;
+    a.nb_cols = n;
+    a.starts.assign(n+1, 0);
+    Uint nb_dropped = 0;
+    for(Uint i = 0; i != rows.size(); ++i)
+    {
+      if(m_process_to_local[cols[i]] != invalid_index)
+        ++a.starts[m_process_to_local[rows[i]]+1];
+      else
+        ++nb_dropped;
+    }
+    for(Uint i = 0; i != n; ++i)
+      a.starts[i+1] += a.starts[i];
+    a.columns.resize(a.starts[n]);
+    a.values.resize(a.starts[n]);
+    std::vector<Uint> fill(a.starts.begin(), a.starts.end()-1);
+    for(Uint i = 0; i != rows.size(); ++i)
+    {
+      const Uint col = m_process_to_local[cols[i]];
+      if(col == invalid_index)
+        continue;
+      const Uint pos = fill[m_process_to_local[rows[i]]]++;
+      a.columns[pos] = col;
+      a.values[pos] = values[i];
+    }
+
+    // The local matrix can replace the distributed one only if no rank dropped any entries
+    Uint global_dropped = nb_dropped;
+    if(common::PE::Comm::instance().is_active())
+      common::PE::Comm::instance().all_reduce(common::PE::plus(), &nb_dropped, 1, &global_dropped);
+    m_local_operator_exact = global_dropped == 0;
+  }
+
+  /// Build the hierarchy, starting from the given fine level matrix
+  void setup(CrsData& fine_matrix)
+  {
+    const boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+
+    const Real theta = m_self.options().value<Real>("strength_threshold");
+    const Uint max_levels = std::max(1u, m_self.options().value<Uint>("max_levels"));
+    const Uint coarse_size = m_self.options().value<Uint>("coarse_size");
+
+    m_levels.clear();
+    m_levels.push_back(Level());
+    m_levels.back().A.starts.swap(fine_matrix.starts);
+    m_levels.back().A.columns.swap(fine_matrix.columns);
+    m_levels.back().A.values.swap(fine_matrix.values);
+    m_levels.back().A.nb_rows = fine_matrix.nb_rows;
+    m_levels.back().A.nb_cols = fine_matrix.nb_cols;
+
+    m_coarse_direct = false;
+    while(true)
+    {
+      Level& fine = m_levels.back();
+      const Uint n = fine.A.nb_rows;
+      inverse_diagonal(fine.A, fine.inv_diag);
+      fine.lambda_max = spectral_radius_bound(fine.A, fine.inv_diag);
+      fine.b.assign(n, 0.);
+      fine.x.assign(n, 0.);
+      fine.r.assign(n, 0.);
+      fine.d.assign(n, 0.);
+
+      if(n <= coarse_size)
+      {
+        m_coarse_direct = true;
+        break;
+      }
+      if(m_levels.size() == max_levels)
+        break;
+
+      std::vector<Uint> aggregates;
+      const Uint nb_aggregates = aggregate(fine.A, theta, aggregates);
+      // Stop if coarsening stalls, the coarsest level is then only smoothed
+      if(nb_aggregates == 0 || nb_aggregates > n*9/10)
+        break;
+
+      // Tentative prolongation, preserving the constant vector
+      std::vector<Uint> aggregate_sizes(nb_aggregates, 0);
+      for(Uint i = 0; i != n; ++i)
+        if(aggregates[i] != invalid_index)
+          ++aggregate_sizes[aggregates[i]];
+
+      CrsData tentative;
+      tentative.nb_rows = n;
+      tentative.nb_cols = nb_aggregates;
+      tentative.starts.assign(n+1, 0);
+      for(Uint i = 0; i != n; ++i)
+      {
+        tentative.starts[i+1] = tentative.starts[i];
+        if(aggregates[i] != invalid_index)
+        {
+          tentative.columns.push_back(aggregates[i]);
+          tentative.values.push_back(1. / std::sqrt(static_cast<Real>(aggregate_sizes[aggregates[i]])));
+          ++tentative.starts[i+1];
+        }
+      }
+
+      // Smoothed prolongation P = (I - omega*D^-1*A)*P_tentative
+      const Real omega = 4. / (3. * fine.lambda_max);
+      CrsData ap;
+      multiply(fine.A, tentative, ap);
+      CrsData& p = fine.P;
+      p.nb_rows = n;
+      p.nb_cols = nb_aggregates;
+      p.starts.assign(n+1, 0);
+      p.columns.clear();
+      p.values.clear();
+      p.columns.reserve(ap.nnz()+n);
+      p.values.reserve(ap.nnz()+n);
+      for(Uint i = 0; i != n; ++i)
+      {
+        const Uint row_begin = p.columns.size();
+        const Real scale = -omega*fine.inv_diag[i];
+        for(Uint j = ap.starts[i]; j != ap.starts[i+1]; ++j)
+        {
+          p.columns.push_back(ap.columns[j]);
+          p.values.push_back(scale*ap.values[j]);
+        }
+        if(aggregates[i] != invalid_index)
+        {
+          const Real tentative_value = tentative.values[tentative.starts[i]];
+          bool found = false;
+          for(Uint j = row_begin; j != p.columns.size(); ++j)
+          {
+            if(p.columns[j] == aggregates[i])
+            {
+              p.values[j] += tentative_value;
+              found = true;
+              break;
+            }
+          }
+          if(!found)
+          {
+            p.columns.push_back(aggregates[i]);
+            p.values.push_back(tentative_value);
+          }
+        }
+        p.starts[i+1] = p.columns.size();
+      }
+
+      transpose(fine.P, fine.R);
+
+      // Galerkin coarse operator R*A*P
+      Level coarse;
+      multiply(fine.A, fine.P, ap);
+      multiply(fine.R, ap, coarse.A);
+      m_levels.push_back(coarse);
+    }
+
+    if(m_coarse_direct)
+      m_coarse_lu.factorize(m_levels.back().A);
+    else
+      m_coarse_lu.lu.clear();
+
+    const Real setup_time = elapsed_seconds(start);
+    m_self.properties()["setup_time"] = setup_time;
+    m_self.properties()["nb_setups"] = m_self.properties().value<Uint>("nb_setups") + 1u;
+
+    Real operator_nnz = 0.;
+    for(Uint l = 0; l != m_levels.size(); ++l)
+      operator_nnz += static_cast<Real>(m_levels[l].A.nnz());
+    CFdebug << "AMG hierarchy for " << m_self.uri().path() << ": " << m_levels.size() << " levels, rows ";
+    for(Uint l = 0; l != m_levels.size(); ++l)
+      CFdebug << m_levels[l].A.nb_rows << " ";
+    CFdebug << "operator complexity " << operator_nnz / std::max(1., static_cast<Real>(m_levels.front().A.nnz()))
+            << ", setup time " << setup_time << " s" << CFendl;
+
+    // In single precision, only the fine level matrix is kept in double precision, to apply the operator
+    // in the CG iterations
+    m_single_precision = m_self.options().value<bool>("single_precision_preconditioner");
+    m_single_levels.clear();
+    if(m_single_precision)
+    {
+      m_single_levels.resize(m_levels.size());
+      for(Uint l = 0; l != m_levels.size(); ++l)
+        m_single_levels[l].assign(m_levels[l]);
+      Level fine;
+      fine.A.starts.swap(m_levels.front().A.starts);
+      fine.A.columns.swap(m_levels.front().A.columns);
+      fine.A.values.swap(m_levels.front().A.values);
+      fine.A.nb_rows = m_levels.front().A.nb_rows;
+      fine.A.nb_cols = m_levels.front().A.nb_cols;
+      m_levels.clear();
+      m_levels.push_back(fine);
+    }
+  }
+
+  /// Smooth the given level, starting from the current level.x
+  template<typename ValueT>
+  void smooth(LevelT<ValueT>& level)
+  {
+    const Uint n = level.A.nb_rows;
+    if(n == 0)
+      return;
+    const Uint sweeps = m_self.options().value<Uint>("sweeps");
+    const bool chebyshev = m_self.options().value<std::string>("smoother") == "Chebyshev";
+
+    if(!chebyshev)
+    {
+      const Real omega = 4. / (3. * level.lambda_max);
+      for(Uint s = 0; s != sweeps; ++s)
+      {
+        parallel_rows(n, Residual<ValueT>(level.A, &level.b[0], &level.x[0], &level.r[0]));
+        parallel_rows(n, SmootherUpdate<ValueT>(&level.inv_diag[0], &level.r[0], &level.d[0], &level.x[0], 0., omega));
+      }
+      return;
+    }
+
+    // Chebyshev polynomial in D^-1*A on [lambda_max/ratio, lambda_max]
+    const Real upper = level.lambda_max;
+    const Real lower = upper / m_self.options().value<Real>("chebyshev_ratio");
+    const Real theta = 0.5 * (upper + lower);
+    const Real delta = 0.5 * (upper - lower);
+    const Real sigma = theta / delta;
+    Real rho = 1. / sigma;
+
+    parallel_rows(n, Residual<ValueT>(level.A, &level.b[0], &level.x[0], &level.r[0]));
+    parallel_rows(n, SmootherUpdate<ValueT>(&level.inv_diag[0], &level.r[0], &level.d[0], &level.x[0], 0., 1. / theta));
+    for(Uint k = 1; k < sweeps; ++k)
+    {
+      parallel_rows(n, Residual<ValueT>(level.A, &level.b[0], &level.x[0], &level.r[0]));
+      const Real rho_new = 1. / (2.*sigma - rho);
+      parallel_rows(n, SmootherUpdate<ValueT>(&level.inv_diag[0], &level.r[0], &level.d[0], &level.x[0], rho_new*rho, 2.*rho_new/delta));
+      rho = rho_new;
+    }
+  }
+
+  /// Solve the coarsest level directly, in double precision
+  template<typename ValueT>
+  void coarse_solve(LevelT<ValueT>& level)
+  {
+    m_coarse_b.assign(level.b.begin(), level.b.end());
+    m_coarse_lu.solve(m_coarse_b, m_coarse_x);
+    std::copy(m_coarse_x.begin(), m_coarse_x.end(), level.x.begin());
+  }
+
+  /// Apply one V-cycle to levels[l].b, starting from a zero guess. The result is in levels[l].x
+  template<typename ValueT>
+  void vcycle(std::vector< LevelT<ValueT> >& levels, const Uint l)
+  {
+    LevelT<ValueT>& level = levels[l];
+    const Uint n = level.A.nb_rows;
+    std::fill(level.x.begin(), level.x.end(), 0.);
+
+    if(l == levels.size()-1)
+    {
+      if(m_coarse_direct)
+        coarse_solve(level);
+      else
+      {
+        smooth(level);
+        smooth(level);
+      }
+      return;
+    }
+
+    smooth(level);
+
+    LevelT<ValueT>& coarse = levels[l+1];
+    parallel_rows(n, Residual<ValueT>(level.A, &level.b[0], &level.x[0], &level.r[0]));
+    if(coarse.A.nb_rows != 0)
+    {
+      parallel_rows(coarse.A.nb_rows, MatVec<ValueT>(level.R, &level.r[0], &coarse.b[0]));
+      vcycle(levels, l+1);
+      parallel_rows(n, MatVec<ValueT>(level.P, &coarse.x[0], &level.r[0]));
+      for(Uint i = 0; i != n; ++i)
+        level.x[i] += level.r[i];
+    }
+
+    smooth(level);
+  }
+
+  /// Apply the preconditioner: z = M^-1 r
+  void precondition(const std::vector<Real>& r, std::vector<Real>& z)
+  {
+    if(m_single_precision)
+    {
+      LevelT<float>& fine = m_single_levels.front();
+      std::copy(r.begin(), r.end(), fine.b.begin());
+      vcycle(m_single_levels, 0);
+      z.assign(fine.x.begin(), fine.x.end());
+      return;
+    }
+
+    Level& fine = m_levels.front();
+    fine.b = r;
+    vcycle(m_levels, 0);
+    z = fine.x;
+  }
+
+  /// y = A*x using the complete matrix
+  void apply_operator(const std::vector<Real>& x, std::vector<Real>& y)
+  {
+    const Uint n = x.size();
+    y.resize(n);
+    if(m_local_operator_exact)
+    {
+      if(n != 0)
+        parallel_rows(n, MatVec<Real>(m_levels.front().A, &x[0], &y[0]));
+      return;
+    }
+
+    for(Uint i = 0; i != n; ++i)
+      m_x_work->set_value(m_owned_rows[i], x[i]);
+    m_x_work->sync();
+    m_matrix->apply(m_y_work, Handle<LSS::Vector const>(m_x_work));
+    m_y_work->debug_data(m_process_values);
+    for(Uint i = 0; i != n; ++i)
+      y[i] = m_process_values[m_owned_rows[i]];
+  }
+
+  Real dot(const std::vector<Real>& a, const std::vector<Real>& b) const
+  {
+    Real local_result = 0.;
+    const Uint n = a.size();
+    for(Uint i = 0; i != n; ++i)
+      local_result += a[i]*b[i];
+    Real result = local_result;
+    if(common::PE::Comm::instance().is_active())
+      common::PE::Comm::instance().all_reduce(common::PE::plus(), &local_result, 1, &result);
+    return result;
+  }
+
+  /// Work vector with the layout of the solution, created on first use and shared by solve() and compute_residual()
+  Handle<LSS::Vector> work_vector(const std::string& name)
+  {
+    Handle<LSS::Vector> result(m_self.get_child(name));
+    if(is_null(result))
+    {
+      result = m_self.create_component<LSS::Vector>(name, m_solution->derived_type_name());
+      m_solution->clone_to(*result);
+    }
+    return result;
+  }
+
+  /// Copy the owned rows of an LSS vector
+  void get_owned(LSS::Vector& v, std::vector<Real>& result)
+  {
+    v.debug_data(m_process_values);
+    const Uint n = m_owned_rows.size();
+    result.resize(n);
+    for(Uint i = 0; i != n; ++i)
+      result[i] = m_process_values[m_owned_rows[i]];
+  }
+
+  void solve()
+  {
+    if(is_null(m_matrix))
+      throw common::SetupError(FromHere(), "Null matrix for " + m_self.uri().path());
+    if(is_null(m_rhs))
+      throw common::SetupError(FromHere(), "Null RHS for " + m_self.uri().path());
+    if(is_null(m_solution))
+      throw common::SetupError(FromHere(), "Null solution vector for " + m_self.uri().path());
+
+    // Rebuild the hierarchy only if the matrix changed. A matrix that does not count its modifications stays at
+    // generation 0, and is rebuilt every time
+    const Uint rebuild = m_levels.empty() || !m_self.options().value<bool>("reuse_setup")
+       || m_matrix->generation() == 0 || m_matrix->generation() != m_matrix_generation
+       || m_single_precision != m_self.options().value<bool>("single_precision_preconditioner");
+
+    // The setup uses collectives, so all ranks must agree, also when only some of them modified their rows
+    Uint global_rebuild = rebuild;
+    if(common::PE::Comm::instance().is_active())
+      common::PE::Comm::instance().all_reduce(common::PE::logical_or(), &rebuild, 1, &global_rebuild);
+
+    if(global_rebuild != 0)
+    {
+      m_matrix_generation = m_matrix->generation();
+      CrsData fine_matrix;
+      extract_matrix(fine_matrix);
+      setup(fine_matrix);
+    }
+
+    if(!m_local_operator_exact)
+    {
+      m_x_work = work_vector("XWork");
+      m_y_work = work_vector("YWork");
+    }
+
+    const boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+
+    const Uint max_iterations = m_self.options().value<Uint>("max_iterations");
+    const Real tolerance = m_self.options().value<Real>("tolerance");
+
+    std::vector<Real> b, x, r, z, p, q;
+    get_owned(*m_rhs, b);
+    get_owned(*m_solution, x);
+
+    const Real b_norm = std::sqrt(dot(b, b));
+    Uint iteration = 0;
+    Real r_norm = 0.;
+    if(b_norm == 0.)
+    {
+      std::fill(x.begin(), x.end(), 0.);
+    }
+    else
+    {
+      apply_operator(x, q);
+      r.resize(b.size());
+      for(Uint i = 0; i != b.size(); ++i)
+        r[i] = b[i] - q[i];
+      r_norm = std::sqrt(dot(r, r));
+
+      precondition(r, z);
+      p = z;
+      Real rz = dot(r, z);
+      while(r_norm > tolerance*b_norm && iteration < max_iterations)
+      {
+        apply_operator(p, q);
+        const Real pq = dot(p, q);
+        if(pq == 0.)
+          break;
+        const Real alpha = rz / pq;
+        for(Uint i = 0; i != x.size(); ++i)
+        {
+          x[i] += alpha*p[i];
+          r[i] -= alpha*q[i];
+        }
+        ++iteration;
+        r_norm = std::sqrt(dot(r, r));
+        if(r_norm <= tolerance*b_norm)
+          break;
+
+        precondition(r, z);
+        const Real rz_new = dot(r, z);
+        const Real beta = rz_new / rz;
+        rz = rz_new;
+        for(Uint i = 0; i != p.size(); ++i)
+          p[i] = z[i] + beta*p[i];
+      }
+    }
+
+    for(Uint i = 0; i != x.size(); ++i)
+      m_solution->set_value(m_owned_rows[i], x[i]);
+    m_solution->sync();
+
+    const Real relative_residual = b_norm == 0. ? 0. : r_norm / b_norm;
+    m_self.properties()["iterations"] = iteration;
+    m_self.properties()["residual"] = relative_residual;
+    m_self.properties()["solve_time"] = elapsed_seconds(start);
+
+    if(iteration == max_iterations && relative_residual > tolerance)
+      CFwarn << "AMG preconditioned CG for " << m_self.uri().path() << " did not converge in " << max_iterations << " iterations, relative residual is " << relative_residual << CFendl;
+    else
+      CFdebug << "AMG preconditioned CG for " << m_self.uri().path() << " converged in " << iteration << " iterations" << CFendl;
+
+    if(m_self.options().value<bool>("compute_residual"))
+      CFinfo << "Solver residual: " << compute_residual() << CFendl;
+  }
+
+  Real compute_residual()
+  {
+    if(is_null(m_matrix) || is_null(m_rhs) || is_null(m_solution))
+      throw common::SetupError(FromHere(), "Incomplete system for " + m_self.uri().path());
+
+    if(m_owned_rows.empty() && m_levels.empty())
+    {
+      CrsData fine_matrix;
+      extract_matrix(fine_matrix);
+    }
+
+    std::vector<Real> b, x, ax;
+    get_owned(*m_rhs, b);
+    get_owned(*m_solution, x);
+
+    m_y_work = work_vector("YWork");
+    m_matrix->apply(m_y_work, Handle<LSS::Vector const>(m_solution));
+    get_owned(*m_y_work, ax);
+    for(Uint i = 0; i != b.size(); ++i)
+      ax[i] -= b[i];
+    return std::sqrt(dot(ax, ax));
+  }
+
+  common::Component& m_self;
+  Handle<LSS::Matrix> m_matrix;
+  Handle<LSS::Vector> m_rhs;
+  Handle<LSS::Vector> m_solution;
+
+  /// Work vectors for the matrix application in parallel
+  Handle<LSS::Vector> m_x_work;
+  Handle<LSS::Vector> m_y_work;
+  std::vector<Real> m_process_values;
+
+  /// Process-local indices of the owned rows, in the order of the local matrix
+  std::vector<Uint> m_owned_rows;
+  /// Local row for each process-local index, invalid_index for ghosts
+  std::vector<Uint> m_process_to_local;
+
+  std::vector<Level> m_levels;
+  /// Single precision copy of the hierarchy
+  std::vector< LevelT<float> > m_single_levels;
+  DenseLU m_coarse_lu;
+  std::vector<Real> m_coarse_b, m_coarse_x;
+  bool m_coarse_direct;
+  /// True if the local matrix is the complete matrix, i.e. there is no coupling between ranks
+  bool m_local_operator_exact;
+  /// True if the current hierarchy is in single precision
+  bool m_single_precision;
+  /// Generation of the matrix the hierarchy was built from
+  Uint m_matrix_generation;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+AMGStrategy::AMGStrategy(const std::string& name) :
+  SolutionStrategy(name),
+  m_implementation(new Implementation(*this))
+{
+}
+
+AMGStrategy::~AMGStrategy()
+{
+}
+
+void AMGStrategy::set_matrix(const Handle< Matrix >& matrix)
+{
+  if(matrix != m_implementation->m_matrix)
+    m_implementation->reset_hierarchy();
+  m_implementation->m_matrix = matrix;
+}
+
+void AMGStrategy::set_rhs(const Handle< Vector >& rhs)
+{
+  m_implementation->m_rhs = rhs;
+}
+
+void AMGStrategy::set_solution(const Handle< Vector >& solution)
+{
+  if(solution != m_implementation->m_solution)
+  {
+    // The work vectors follow the layout of the solution
+    if(is_not_null(m_implementation->m_x_work))
+      remove_component(*m_implementation->m_x_work);
+    if(is_not_null(m_implementation->m_y_work))
+      remove_component(*m_implementation->m_y_work);
+    m_implementation->m_x_work.reset();
+    m_implementation->m_y_work.reset();
+  }
+  m_implementation->m_solution = solution;
+}
+
+void AMGStrategy::solve()
+{
+  m_implementation->solve();
+}
+
+Real AMGStrategy::compute_residual()
+{
+  return m_implementation->compute_residual();
+}
+
+void AMGStrategy::set_coordinates(common::PE::CommPattern& cp, const common::Table< Real >& coords, const common::List< Uint >& used_nodes, const std::vector< bool >& periodic_links_active)
+{
+  // Aggregation is purely algebraic, coordinates are not needed
+}
+
+Uint AMGStrategy::nb_levels() const
+{
+  return m_implementation->nb_levels();
+}
+
+std::size_t AMGStrategy::memory_footprint() const
+{
+  return m_implementation->memory_footprint();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
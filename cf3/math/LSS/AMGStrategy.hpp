@@ -0,0 +1,78 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_AMGStrategy_hpp
+#define cf3_Math_LSS_AMGStrategy_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <boost/scoped_ptr.hpp>
+
+#include "common/MemoryComponent.hpp"
+
+#include "math/LSS/SolutionStrategy.hpp"
+#include "math/LSS/LibLSS.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ *  @file AMGStrategy.hpp Conjugate gradient solver with a built-in smoothed aggregation multigrid preconditioner
+ **/
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Solves symmetric positive (semi-)definite systems, such as the pressure Poisson system, using the conjugate gradient method
+/// preconditioned with one smoothed aggregation AMG V-cycle.
+/// The hierarchy is built from the locally owned rows of any LSS::Matrix, extracted through Matrix::debug_data,
+/// so it works without Trilinos. Couplings to rows owned by other ranks are left out of the hierarchy,
+/// making the preconditioner block-Jacobi over the ranks, while the outer iterations use the complete matrix.
+/// The hierarchy is kept for as long as the matrix is not modified, as tracked by Matrix::generation(), and rebuilt on every solve
+/// for matrices that leave the generation at 0. The smoothers are threaded
+/// using the common::ThreadPool. Optionally, the hierarchy is stored and applied in single precision,
+/// while the outer iterations remain in double precision.
+class LSS_API AMGStrategy : public SolutionStrategy, public common::MemoryComponent
+{
+public:
+
+  /// Default constructor
+  AMGStrategy(const std::string& name);
+
+  ~AMGStrategy();
+
+  /// name of the type
+  static std::string type_name () { return "AMGStrategy"; }
+
+  void set_matrix(const Handle<LSS::Matrix>& matrix);
+  void set_rhs(const Handle<LSS::Vector>& rhs);
+  void set_solution(const Handle<LSS::Vector>& solution);
+  void solve();
+  Real compute_residual();
+  virtual void set_coordinates(common::PE::CommPattern& cp, const common::Table< Real >& coords, const common::List< Uint >& used_nodes, const std::vector< bool >& periodic_links_active);
+
+  /// Number of levels in the current hierarchy, 0 if it was not built yet
+  Uint nb_levels() const;
+
+  /// Bytes used by the hierarchy
+  std::size_t memory_footprint() const;
+
+private:
+  /// Hide the hierarchy data structures
+  struct Implementation;
+  boost::scoped_ptr<Implementation> m_implementation;
+}; // end of class AMGStrategy
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_AMGStrategy_hpp
@@ -14,6 +14,8 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <boost/array.hpp>
+
 #include "math/MatrixTypes.hpp"
 #include "math/LSS/LibLSS.hpp"
 
@@ -79,6 +81,66 @@ public:
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+/// Block accumulator with the number of nodes and equations known at compile time.
+/// All storage is fixed-size, so no heap allocation takes place and Eigen can unroll operations on the block.
+/// It is passed to the LSS using the templated set_values/add_values overloads of Matrix and Vector.
+template<Uint NbNodes, Uint NbEqs>
+class BlockAccumulatorT {
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  /// Number of nodes in the block
+  static const Uint nb_nodes = NbNodes;
+
+  /// Number of equations per node
+  static const Uint nb_eqs = NbEqs;
+
+  /// Number of rows and columns in the block
+  static const Uint matrix_size = NbNodes*NbEqs;
+
+  /// Type of the block matrix, stored row-major as required by the LSS
+  typedef Eigen::Matrix<Real, matrix_size, matrix_size, Eigen::RowMajor> MatrixT;
+
+  /// Type of the solution and RHS blocks
+  typedef Eigen::Matrix<Real, matrix_size, 1> VectorT;
+
+  /// reset the values to the value of reset_to
+  void reset(Real reset_to=0.)
+  {
+    mat.setConstant(reset_to);
+    sol.setConstant(reset_to);
+    rhs.setConstant(reset_to);
+  }
+
+  /// entering the indices where the local matrix is lying
+  template<typename T> void neighbour_indices(const T& idx_vector )
+  {
+    cf3_assert(idx_vector.size() == NbNodes);
+    for (Uint i=0; i<NbNodes; i++)
+      indices[i]=idx_vector[i];
+  }
+
+  /// how many rows/columns
+  Uint size() const { return matrix_size; }
+
+  /// how many rows/columns
+  Uint block_size() const { return NbNodes; }
+
+  /// accessor to blockaccumulator's matrix
+  MatrixT mat;
+
+  /// accessor to blockaccumulator's solution vector
+  VectorT sol;
+
+  /// accessor to blockaccumulator's right hand side vector
+  VectorT rhs;
+
+  /// local numbering of the unknowns
+  boost::array<Uint, NbNodes> indices;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace LSS
 } // namespace math
 } // namespace cf3
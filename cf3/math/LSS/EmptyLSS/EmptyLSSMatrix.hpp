@@ -111,6 +111,12 @@ public:
   /// Add a list of values
   void get_values(BlockAccumulator& values) { cf3_assert(m_is_created); values.mat.setConstant(0.); }
 
+  /// Set a dense block of values
+  void set_block_values(const Uint* indices, const Uint nb_nodes, const Real* values) { cf3_assert(m_is_created); }
+
+  /// Add a dense block of values
+  void add_block_values(const Uint* indices, const Uint nb_nodes, const Real* values) { cf3_assert(m_is_created); }
+
   /// Set a row, diagonal and off-diagonals values separately (dirichlet-type boundaries)
   void set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval) { cf3_assert(m_is_created); }
 
@@ -129,6 +129,15 @@ public:
   /// Get a list of values from sol
   void get_sol_values(BlockAccumulator& values) { cf3_assert(m_is_created); values.sol.setConstant(0.); }
 
+  /// Set the values for a list of block rows
+  void set_block_values(const Uint* indices, const Uint nb_nodes, const Real* values) { cf3_assert(m_is_created); }
+
+  /// Add the values for a list of block rows
+  void add_block_values(const Uint* indices, const Uint nb_nodes, const Real* values) { cf3_assert(m_is_created); }
+
+  /// Get the values for a list of block rows
+  void get_block_values(const Uint* indices, const Uint nb_nodes, Real* values) { cf3_assert(m_is_created); std::fill(values, values + nb_nodes*m_neq, 0.); }
+
   /// Reset Vector
   void reset(Real reset_to=0.) { cf3_assert(m_is_created); }
 
@@ -9,6 +9,8 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+
 #include <boost/utility.hpp>
 
 #include "math/LSS/LibLSS.hpp"
@@ -48,7 +50,13 @@ public:
   virtual const bool is_swappable(const LSS::Vector& solution, const LSS::Vector& rhs) = 0;
 
   /// Default constructor
-  Matrix(const std::string& name) : Component(name) { }
+  Matrix(const std::string& name) : Component(name), m_generation(0) { }
+
+  /// Counter that changes whenever the entries may have changed, so solution strategies can keep work that only
+  /// depends on the matrix, such as a preconditioner, without comparing the entries.
+  /// Implementations must call increment_generation() from every function that can modify the entries, starting with create().
+  /// A matrix that never does so stays at 0, which solution strategies must treat as unknown, i.e. always changed.
+  Uint generation() const { return m_generation; }
 
   /// Setup sparsity structure
   /// should only work with local numbering (parallel computations, plus rcm could be a totally internal matter of the matrix)
@@ -94,6 +102,40 @@ public:
   /// Add a list of values
   virtual void get_values(BlockAccumulator& values) = 0;
 
+  /// Set a list of values from a fixed-size block accumulator
+  template<Uint NbNodes, Uint NbEqs>
+  void set_values(const BlockAccumulatorT<NbNodes, NbEqs>& values)
+  {
+    cf3_assert(NbEqs == neq());
+    set_block_values(values.indices.data(), NbNodes, values.mat.data());
+  }
+
+  /// Add a list of values from a fixed-size block accumulator
+  template<Uint NbNodes, Uint NbEqs>
+  void add_values(const BlockAccumulatorT<NbNodes, NbEqs>& values)
+  {
+    cf3_assert(NbEqs == neq());
+    add_block_values(values.indices.data(), NbNodes, values.mat.data());
+  }
+
+  /// Set a dense block of values. The block connects the nb_nodes local block rows given in indices,
+  /// and values holds the (nb_nodes*neq())^2 entries in row-major order.
+  /// The default implementation copies the data into a BlockAccumulator, backends should override it to avoid the copy.
+  virtual void set_block_values(const Uint* indices, const Uint nb_nodes, const Real* values)
+  {
+    BlockAccumulator block;
+    copy_block(indices, nb_nodes, values, block);
+    set_values(block);
+  }
+
+  /// Add a dense block of values, with the same layout as set_block_values
+  virtual void add_block_values(const Uint* indices, const Uint nb_nodes, const Real* values)
+  {
+    BlockAccumulator block;
+    copy_block(indices, nb_nodes, values, block);
+    add_values(block);
+  }
+
   /// Set a row, diagonal and off-diagonals values separately (dirichlet-type boundaries)
   virtual void set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval) = 0;
 
@@ -107,6 +149,21 @@ public:
   /// @warning Structural symmetry is not checked, incorrect results will appear if you use this on a non structurally symmetric matrix
   virtual void symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, LSS::Vector& rhs) = 0;
 
+  /// Apply symmetric dirichlet boundary conditions on a set of rows at once
+  /// Matrices that support it precompute the affected matrix entries once per set of rows, so applying the
+  /// same set again after a reset only takes a single pass over these entries. The default applies the rows one by one.
+  /// @param rows Rows to constrain, numbered as blockrow*neq+eq, sorted and without duplicates
+  /// @param values Value for each row
+  /// @pre The matrix must be structurally symmetric
+  virtual void symmetric_dirichlet_rows(const std::vector<Uint>& rows, const std::vector<Real>& values, LSS::Vector& rhs)
+  {
+    cf3_assert(rows.size() == values.size());
+    const Uint nb_eqs = neq();
+    const Uint nb_rows = rows.size();
+    for(Uint i = 0; i != nb_rows; ++i)
+      symmetric_dirichlet(rows[i] / nb_eqs, rows[i] % nb_eqs, values[i], rhs);
+  }
+
   /// Add one line to another and tie to it via dirichlet-style (applying periodicity)
   virtual void tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from) = 0;
 
@@ -177,6 +234,20 @@ public:
 
   //@} END TEST ONLY
 
+protected:
+  /// To be called by the implementations from every function that can modify the entries
+  void increment_generation() { ++m_generation; }
+
+private:
+  /// Copy a raw block into a dynamic block accumulator
+  void copy_block(const Uint* indices, const Uint nb_nodes, const Real* values, BlockAccumulator& block)
+  {
+    block.resize(nb_nodes, neq());
+    block.indices.assign(indices, indices + nb_nodes);
+    std::copy(values, values + block.mat.size(), block.mat.data());
+  }
+
+  Uint m_generation;
 
 }; // end of class Matrix
 
@@ -8,6 +8,7 @@
 #include "common/PropertyList.hpp"
 #include "common/Builder.hpp"
 
+#include "math/LSS/SolutionStrategy.hpp"
 #include "math/LSS/System.hpp"
 
 #include "SolveLSS.hpp"
@@ -37,6 +38,12 @@ SolveLSS::SolveLSS( const std::string& name  ) :
       .pretty_name("LSS")
       .mark_basic()
       .link_to(&m_lss);
+
+  options().add("solution_strategy", std::string())
+      .description("Builder name of the solution strategy to use for this solve, e.g. cf3.math.LSS.AMGStrategy. "
+                   "If empty, the strategy configured in the LSS is used")
+      .pretty_name("Solution Strategy")
+      .mark_basic();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -51,6 +58,27 @@ void SolveLSS::execute ()
   if(!lss.is_created())
     throw SetupError(FromHere(), "LSS at " + lss.uri().string() + " is not created!");
 
+  const std::string strategy_builder = options().value<std::string>("solution_strategy");
+  if(!strategy_builder.empty())
+  {
+    if(is_null(m_solution_strategy) || m_solution_strategy->derived_type_name() != strategy_builder)
+    {
+      if(is_not_null(m_solution_strategy))
+        remove_component(*m_solution_strategy);
+      m_solution_strategy = create_component<SolutionStrategy>("SolutionStrategy", strategy_builder);
+      m_solution_strategy->mark_basic();
+    }
+
+    // The LSS creates a new strategy each time it is created, so check if ours is still in use
+    if(lss.solution_strategy() != m_solution_strategy)
+    {
+      m_solution_strategy->set_matrix(lss.matrix());
+      m_solution_strategy->set_solution(lss.solution());
+      m_solution_strategy->set_rhs(lss.rhs());
+      lss.options().set("solution_strategy_component", m_solution_strategy);
+    }
+  }
+
   lss.solve();
 }
 
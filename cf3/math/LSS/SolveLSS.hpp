@@ -17,6 +17,7 @@ namespace cf3 {
 namespace math {
 namespace LSS {
 
+class SolutionStrategy;
 class System;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -39,6 +40,8 @@ public: // functions
 
 private:
   Handle<math::LSS::System> m_lss;
+  /// Strategy built from the "solution_strategy" option, replacing the one of the LSS
+  Handle<SolutionStrategy> m_solution_strategy;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -4,6 +4,8 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+#include <exception>
 #include <fstream>
 
 #include <boost/utility.hpp>
@@ -16,6 +18,7 @@
 #include "common/OptionT.hpp"
 #include "common/PE/CommPattern.hpp"
 #include "common/Signal.hpp"
+#include "common/Tracer.hpp"
 
 #include "common/XML/Protocol.hpp"
 #include "common/XML/SignalOptions.hpp"
@@ -48,7 +51,10 @@ using namespace cf3::math;
 common::ComponentBuilder < LSS::System, LSS::System, LSS::LibLSS > System_Builder;
 
 LSS::System::System(const std::string& name) :
-  Component(name)
+  Component(name),
+  m_assembly_trace_id(0),
+  m_assembly_trace_name(0),
+  m_dirichlet_batch_depth(0)
 {
   options().add( "matrix_builder" , "cf3.math.LSS.TrilinosFEVbrMatrix")
     .pretty_name("Matrix Builder")
@@ -81,6 +87,8 @@ LSS::System::System(const std::string& name) :
 
 void LSS::System::create(cf3::common::PE::CommPattern& cp, Uint neq, std::vector<Uint>& node_connectivity, std::vector<Uint>& starting_indices, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
 {
+  static const Uint create_trace_name = common::Tracer::instance().register_name("LSS create");
+  common::TraceScope trace(create_trace_name);
   if (is_created())
     destroy();
 
@@ -113,6 +121,8 @@ void LSS::System::create(cf3::common::PE::CommPattern& cp, Uint neq, std::vector
 
 void LSS::System::create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, std::vector< Uint >& node_connectivity, std::vector< Uint >& starting_indices, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
 {
+  static const Uint create_trace_name = common::Tracer::instance().register_name("LSS create");
+  common::TraceScope trace(create_trace_name);
   if (is_created())
     destroy();
 
@@ -202,6 +212,14 @@ void LSS::System::destroy()
 void LSS::System::solve()
 {
   cf3_assert(is_created());
+  common::Tracer& tracer = common::Tracer::instance();
+  if(m_assembly_trace_id != 0)
+  {
+    tracer.record(m_assembly_trace_name - 1, common::Tracer::ASYNC_END, m_assembly_trace_id);
+    m_assembly_trace_id = 0;
+  }
+  static const Uint solve_trace_name = tracer.register_name("LSS solve");
+  common::TraceScope trace(solve_trace_name);
   m_solution_strategy->solve();
 }
 
@@ -241,7 +259,11 @@ void LSS::System::dirichlet(const Uint iblockrow, const Uint ieq, const Real val
 {
   cf3_assert(is_created());
 
-  if (preserve_symmetry)
+  if (preserve_symmetry && m_dirichlet_batch_depth != 0)
+  {
+    m_dirichlet_batch.push_back(std::make_pair(iblockrow*m_mat->neq()+ieq, value));
+  }
+  else if (preserve_symmetry)
   {
     m_mat->symmetric_dirichlet(iblockrow, ieq, value, *m_rhs);
   }
@@ -256,6 +278,86 @@ void LSS::System::dirichlet(const Uint iblockrow, const Uint ieq, const Real val
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+void LSS::System::symmetric_dirichlet(const std::vector<Uint>& rows, const std::vector<Real>& values)
+{
+  cf3_assert(is_created());
+  cf3_assert(rows.size() == values.size());
+  m_mat->symmetric_dirichlet_rows(rows, values, *m_rhs);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void LSS::System::begin_dirichlet_batch()
+{
+  ++m_dirichlet_batch_depth;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+  /// Order batched dirichlet conditions by row only, so a stable sort keeps the order in which they were given
+  bool dirichlet_row_less(const std::pair<Uint, Real>& a, const std::pair<Uint, Real>& b)
+  {
+    return a.first < b.first;
+  }
+}
+
+void LSS::System::end_dirichlet_batch()
+{
+  cf3_assert(m_dirichlet_batch_depth != 0);
+  if(--m_dirichlet_batch_depth != 0 || m_dirichlet_batch.empty())
+    return;
+
+  std::stable_sort(m_dirichlet_batch.begin(), m_dirichlet_batch.end(), dirichlet_row_less);
+
+  std::vector<Uint> rows;
+  std::vector<Real> values;
+  rows.reserve(m_dirichlet_batch.size());
+  values.reserve(m_dirichlet_batch.size());
+  for(std::vector< std::pair<Uint, Real> >::const_iterator it = m_dirichlet_batch.begin(); it != m_dirichlet_batch.end(); ++it)
+  {
+    if(!rows.empty() && rows.back() == it->first)
+    {
+      values.back() = it->second;
+      continue;
+    }
+    rows.push_back(it->first);
+    values.push_back(it->second);
+  }
+  m_dirichlet_batch.clear();
+
+  symmetric_dirichlet(rows, values);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+LSS::DirichletBatch::DirichletBatch(System& system) :
+  m_system(system)
+{
+  m_system.begin_dirichlet_batch();
+}
+
+LSS::DirichletBatch::~DirichletBatch()
+{
+  if(!std::uncaught_exception())
+  {
+    m_system.end_dirichlet_batch();
+    return;
+  }
+
+  // Already unwinding: still close the batch, but a second exception would terminate the program
+  try
+  {
+    m_system.end_dirichlet_batch();
+  }
+  catch(...)
+  {
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 void LSS::System::periodicity (const Uint iblockrow_to, const Uint iblockrow_from)
 {
   cf3_assert(is_created());
@@ -310,6 +412,18 @@ void LSS::System::get_diagonal(std::vector<Real>& diag)
 void LSS::System::reset(Real reset_to)
 {
   cf3_assert(is_created());
+
+  // Assembly is traced from here until the next solve
+  common::Tracer& tracer = common::Tracer::instance();
+  if(tracer.enabled() && m_assembly_trace_id == 0)
+  {
+    static Uint nb_traced_assemblies = 0;
+    m_assembly_trace_id = ++nb_traced_assemblies;
+    if(m_assembly_trace_name == 0)
+      m_assembly_trace_name = tracer.register_name(uri().path() + " assembly") + 1;
+    tracer.record(m_assembly_trace_name - 1, common::Tracer::ASYNC_BEGIN, m_assembly_trace_id);
+  }
+
   m_mat->reset(reset_to);
   m_sol->reset(reset_to);
   m_rhs->reset(reset_to);
@@ -9,7 +9,7 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-//#include <boost/utility.hpp>
+#include <boost/noncopyable.hpp>
 
 #include "math/LSS/LibLSS.hpp"
 #include "common/Component.hpp"
@@ -108,8 +108,22 @@ public:
 
   /// Apply dirichlet-type boundary conditions.
   /// When preserve_symmetry is true than blockrow*numequations+eq column is is zeroed by moving it to the right hand side (however this usually results in performance penalties).
+  /// Between begin_dirichlet_batch() and end_dirichlet_batch(), the symmetric conditions are collected and applied together.
   void dirichlet(const Uint iblockrow, const Uint ieq, const Real value, const bool preserve_symmetry=false);
 
+  /// Apply symmetric dirichlet conditions on a set of rows in one pass. The matrix locates the affected entries once per set
+  /// of rows, so applying the same set at every time step is cheap.
+  /// @param rows Rows to constrain, numbered as blockrow*neq+eq, sorted and without duplicates
+  /// @param values Value for each row
+  void symmetric_dirichlet(const std::vector<Uint>& rows, const std::vector<Real>& values);
+
+  /// Start collecting the symmetric dirichlet conditions passed to dirichlet(). Batches can be nested.
+  void begin_dirichlet_batch();
+
+  /// Apply the symmetric dirichlet conditions collected since the outermost begin_dirichlet_batch().
+  /// If a row was constrained more than once, the last value is used.
+  void end_dirichlet_batch();
+
   /// Applying periodicity by adding one line to another and dirichlet-style fixing it to
   /// Note that prerequisite for this is to work that the matrix sparsity should be compatible (same nonzero pattern for the two block rows).
   /// Note that only structural symmetry can be preserved (again, if sparsity input was symmetric).
@@ -188,10 +202,35 @@ private:
   /// Strategy for the solution
   Handle<LSS::SolutionStrategy> m_solution_strategy;
 
+  /// Id of the traced assembly, from reset() until solve(), or zero if no assembly is being traced
+  Uint m_assembly_trace_id;
+  /// Tracer name index of the assembly plus one, or zero until the first traced assembly
+  Uint m_assembly_trace_name;
+
+  /// Nesting depth of the dirichlet batches
+  Uint m_dirichlet_batch_depth;
+
+  /// Symmetric dirichlet conditions collected in the current batch, as (blockrow*neq+eq, value)
+  std::vector< std::pair<Uint, Real> > m_dirichlet_batch;
+
 }; // end of class System
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+/// Scoped dirichlet batch: begin_dirichlet_batch() on construction and end_dirichlet_batch() on destruction,
+/// so the batch is closed even if the code collecting the conditions throws.
+class LSS_API DirichletBatch : boost::noncopyable
+{
+public:
+  DirichletBatch(System& system);
+  ~DirichletBatch();
+
+private:
+  System& m_system;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace LSS
 } // namespace math
 } // namespace cf3
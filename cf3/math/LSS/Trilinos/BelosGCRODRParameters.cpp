@@ -0,0 +1,43 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Teuchos_ParameterList.hpp"
+
+#include "common/Builder.hpp"
+
+#include "BelosGCRODRParameters.hpp"
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+common::ComponentBuilder<BelosGCRODRParameters, ParameterListDefaults, LibLSS> BelosGCRODRParameters_builder;
+
+BelosGCRODRParameters::BelosGCRODRParameters(const std::string& name) : ParameterListDefaults(name)
+{
+}
+
+void BelosGCRODRParameters::set_parameters(Teuchos::ParameterList& parameters) const
+{
+  parameters.set("Linear Solver Type", "Belos");
+  Teuchos::ParameterList& belos = parameters.sublist("Linear Solver Types").sublist("Belos");
+  belos.set("Solver Type", "GCRODR");
+  Teuchos::ParameterList& gcrodr = belos.sublist("Solver Types").sublist("GCRODR");
+  gcrodr.set("Maximum Iterations", 200);
+  gcrodr.set("Convergence Tolerance", 1e-10);
+  gcrodr.set("Num Blocks", 20);
+  gcrodr.set("Num Recycled Blocks", 5);
+  gcrodr.set("Verbosity", 0);
+
+  parameters.set("Preconditioner Type", "Ifpack");
+  parameters.sublist("Preconditioner Types").sublist("Ifpack").set("Prec Type", "ILU");
+}
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
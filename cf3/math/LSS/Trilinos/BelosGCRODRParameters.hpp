@@ -0,0 +1,55 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_Math_LSS_BelosGCRODRParameters_hpp
+#define cf3_Math_LSS_BelosGCRODRParameters_hpp
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "common/Component.hpp"
+
+#include "math/LSS/LibLSS.hpp"
+#include "ParameterListDefaults.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ *  @file BelosGCRODRParameters.hpp Set defaults for a Belos GCRO-DR solve, which recycles a Krylov subspace between solves
+ **/
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace Teuchos { class ParameterList; }
+
+namespace cf3 {
+namespace math {
+namespace LSS {
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Defaults for the GCRO-DR solver of Belos. The recycled subspace is kept between successive solves
+/// with the same solution strategy, which pays off for the slowly varying systems of unsteady simulations.
+class LSS_API BelosGCRODRParameters : public ParameterListDefaults
+{
+public:
+
+  /// Default constructor
+  BelosGCRODRParameters(const std::string& name);
+
+  /// name of the type
+  static std::string type_name () { return "BelosGCRODRParameters"; }
+
+  /// Set the values of the passed parameterlist to the defualt values that are generated by the concrete implementation
+  void set_parameters(Teuchos::ParameterList& parameters) const;
+
+}; // end of class BelosGCRODRParameters
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace LSS
+} // namespace math
+} // namespace cf3
+
+#endif // cf3_Math_LSS_BelosGCRODRParameters_hpp
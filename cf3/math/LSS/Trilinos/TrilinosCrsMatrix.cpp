@@ -9,6 +9,7 @@
 #include <iostream>
 #include <set>
 
+#include <boost/functional/hash.hpp>
 #include <boost/pointer_cast.hpp>
 
 #include "Teuchos_ConfigDefs.hpp"
@@ -79,6 +80,7 @@ TrilinosCrsMatrix::TrilinosCrsMatrix(const std::string& name) :
 
 void TrilinosCrsMatrix::create(cf3::common::PE::CommPattern& cp, const Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
 {
+  increment_generation();
   boost::shared_ptr<VariablesDescriptor> single_var_descriptor = common::allocate_component<VariablesDescriptor>("SingleVariableDescriptor");
   single_var_descriptor->options().set(common::Tags::dimension(), neq);
   single_var_descriptor->push_back("LSSvars", VariablesDescriptor::Dimensionalities::VECTOR);
@@ -89,6 +91,7 @@ void TrilinosCrsMatrix::create(cf3::common::PE::CommPattern& cp, const Uint neq,
 
 void TrilinosCrsMatrix::create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector< Uint >& node_connectivity, const std::vector< Uint >& starting_indices, Vector& solution, Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
 {
+  increment_generation();
   // if already created
   if (m_is_created) destroy();
 
@@ -150,12 +153,14 @@ void TrilinosCrsMatrix::create_blocked(common::PE::CommPattern& cp, const Variab
 
 void TrilinosCrsMatrix::destroy()
 {
+  increment_generation();
   if (m_is_created)
   {
     m_mat.reset();
   }
   m_p2m.resize(0);
   m_p2m.reserve(0);
+  m_dirichlet_row_sets.clear();
   m_neq=0;
   m_num_my_elements=0;
   m_is_created=false;
@@ -165,6 +170,7 @@ void TrilinosCrsMatrix::destroy()
 
 void TrilinosCrsMatrix::set_value(const Uint icol, const Uint irow, const Real value)
 {
+  increment_generation();
   cf3_assert(m_is_created);
   TRILINOS_THROW(m_mat->ReplaceMyValues(m_p2m[irow], 1, &value, &m_p2m[icol]));
 }
@@ -173,6 +179,7 @@ void TrilinosCrsMatrix::set_value(const Uint icol, const Uint irow, const Real v
 
 void TrilinosCrsMatrix::add_value(const Uint icol, const Uint irow, const Real value)
 {
+  increment_generation();
   cf3_assert(m_is_created);
   TRILINOS_THROW(m_mat->SumIntoMyValues(m_p2m[irow], 1, &value, &m_p2m[icol]));
 }
@@ -201,14 +208,24 @@ void TrilinosCrsMatrix::get_value(const Uint icol, const Uint irow, Real& value)
 
 void TrilinosCrsMatrix::set_values(const BlockAccumulator& values)
 {
+  increment_generation();
+  cf3_assert(values.mat.rows() == static_cast<int>(values.indices.size()*m_neq));
+  if(values.indices.empty())
+    return;
+  set_block_values(&values.indices[0], values.indices.size(), values.mat.data());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosCrsMatrix::set_block_values(const Uint* indices, const Uint nb_nodes, const Real* values)
+{
+  increment_generation();
   cf3_assert(m_is_created);
-  const Uint nb_nodes = values.indices.size();
   const int num_entries = nb_nodes*m_neq;
-  cf3_assert(values.mat.rows() == num_entries);
   // Convert the index vector
   for(Uint i = 0; i != nb_nodes; ++i)
   {
-    const Uint local_start_idx = values.indices[i]*m_neq;
+    const Uint local_start_idx = indices[i]*m_neq;
     for(int j = 0; j != m_neq; ++j)
       m_converted_indices[i*m_neq+j] = m_p2m[local_start_idx+j];
   }
@@ -218,7 +235,7 @@ void TrilinosCrsMatrix::set_values(const BlockAccumulator& values)
     for(int j = 0; j != m_neq; ++j)
     {
       if(m_converted_indices[i*m_neq+j] < m_num_my_elements)
-        TRILINOS_THROW(m_mat->ReplaceMyValues(m_converted_indices[i*m_neq+j], num_entries, values.mat.data()+(num_entries*(i*m_neq+j)),&m_converted_indices[0]));
+        TRILINOS_THROW(m_mat->ReplaceMyValues(m_converted_indices[i*m_neq+j], num_entries, values+(num_entries*(i*m_neq+j)),&m_converted_indices[0]));
     }
   }
 }
@@ -227,14 +244,24 @@ void TrilinosCrsMatrix::set_values(const BlockAccumulator& values)
 
 void TrilinosCrsMatrix::add_values(const BlockAccumulator& values)
 {
+  increment_generation();
+  cf3_assert(values.mat.rows() == static_cast<int>(values.indices.size()*m_neq));
+  if(values.indices.empty())
+    return;
+  add_block_values(&values.indices[0], values.indices.size(), values.mat.data());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosCrsMatrix::add_block_values(const Uint* indices, const Uint nb_nodes, const Real* values)
+{
+  increment_generation();
   cf3_assert(m_is_created);
-  const Uint nb_nodes = values.indices.size();
   const int num_entries = nb_nodes*m_neq;
-  cf3_assert(values.mat.rows() == num_entries);
   // Convert the index vector
   for(Uint i = 0; i != nb_nodes; ++i)
   {
-    const Uint local_start_idx = values.indices[i]*m_neq;
+    const Uint local_start_idx = indices[i]*m_neq;
     for(int j = 0; j != m_neq; ++j)
       m_converted_indices[i*m_neq+j] = m_p2m[local_start_idx+j];
   }
@@ -244,7 +271,7 @@ void TrilinosCrsMatrix::add_values(const BlockAccumulator& values)
     for(int j = 0; j != m_neq; ++j)
     {
       if(m_converted_indices[i*m_neq+j] < m_num_my_elements)
-        TRILINOS_THROW(m_mat->SumIntoMyValues(m_converted_indices[i*m_neq+j], num_entries, values.mat.data()+(num_entries*(i*m_neq+j)),&m_converted_indices[0]));
+        TRILINOS_THROW(m_mat->SumIntoMyValues(m_converted_indices[i*m_neq+j], num_entries, values+(num_entries*(i*m_neq+j)),&m_converted_indices[0]));
     }
   }
 }
@@ -294,6 +321,7 @@ void TrilinosCrsMatrix::get_values(BlockAccumulator& values)
 
 void TrilinosCrsMatrix::set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval)
 {
+  increment_generation();
   cf3_assert(m_is_created);
   int num_entries;
   Real* extracted_values;
@@ -317,6 +345,7 @@ void TrilinosCrsMatrix::set_row(const Uint iblockrow, const Uint ieq, Real diagv
 
 void TrilinosCrsMatrix::get_column_and_replace_to_zero(const Uint iblockcol, Uint ieq, std::vector<Real>& values)
 {
+  increment_generation();
   throw common::NotImplemented(FromHere(), "get_column_and_replace_to_zero is not implemented for TrilinosCrsMatrix");
 }
 
@@ -324,6 +353,7 @@ void TrilinosCrsMatrix::get_column_and_replace_to_zero(const Uint iblockcol, Uin
 
 void TrilinosCrsMatrix::symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, Vector& rhs)
 {
+  increment_generation();
   // We assume that we have an epetra RHS with the same storage structure as the matrix!
   Epetra_Vector& epetra_rhs = *dynamic_cast<TrilinosVector&>(rhs).epetra_vector();
 
@@ -403,6 +433,129 @@ void TrilinosCrsMatrix::symmetric_dirichlet(const Uint blockrow, const Uint ieq,
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+TrilinosCrsMatrix::DirichletRowSet& TrilinosCrsMatrix::dirichlet_row_set(const std::vector<Uint>& rows)
+{
+  const std::size_t hash = boost::hash_range(rows.begin(), rows.end());
+  const std::pair<DirichletRowSetsT::iterator, DirichletRowSetsT::iterator> candidates = m_dirichlet_row_sets.equal_range(hash);
+  for(DirichletRowSetsT::iterator it = candidates.first; it != candidates.second; ++it)
+  {
+    if(it->second.rows == rows)
+      return it->second;
+  }
+
+  int* index_offset;
+  int* indices;
+  Real* values;
+  TRILINOS_THROW(m_mat->ExtractCrsDataPointers(index_offset, indices, values));
+
+  DirichletRowSet& row_set = m_dirichlet_row_sets.insert(std::make_pair(hash, DirichletRowSet()))->second;
+  row_set.rows = rows;
+  row_set.values_cached = false;
+
+  const Uint nb_rows = rows.size();
+  std::vector<bool> is_constrained(m_num_my_elements, false);
+  for(Uint i = 0; i != nb_rows; ++i)
+  {
+    const int mat_row = m_p2m[rows[i]];
+    if(mat_row < m_num_my_elements)
+      is_constrained[mat_row] = true;
+  }
+
+  // The matrix is structurally symmetric, so the entries of a column are found in the rows of the connected nodes
+  row_set.column_start.reserve(nb_rows+1);
+  for(Uint i = 0; i != nb_rows; ++i)
+  {
+    row_set.column_start.push_back(row_set.entry_rows.size());
+    const int bc_col = m_p2m[rows[i]];
+    const Uint blockrow = rows[i] / m_neq;
+    const Uint conn_end = m_starting_indices[blockrow+1];
+    for(Uint conn = m_starting_indices[blockrow]; conn != conn_end; ++conn)
+    {
+      for(Uint j = 0; j != m_neq; ++j)
+      {
+        const int other_row = m_p2m[m_node_connectivity[conn]*m_neq+j];
+        if(other_row >= m_num_my_elements || is_constrained[other_row])
+          continue;
+        for(int k = index_offset[other_row]; k != index_offset[other_row+1]; ++k)
+        {
+          if(indices[k] == bc_col)
+          {
+            row_set.entry_rows.push_back(other_row);
+            row_set.entry_offsets.push_back(k);
+            break;
+          }
+        }
+      }
+    }
+  }
+  row_set.column_start.push_back(row_set.entry_rows.size());
+  row_set.entry_values.resize(row_set.entry_rows.size());
+
+  return row_set;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosCrsMatrix::symmetric_dirichlet_rows(const std::vector<Uint>& rows, const std::vector<Real>& values, Vector& rhs)
+{
+  cf3_assert(m_is_created);
+  cf3_assert(rows.size() == values.size());
+
+  // We assume that we have an epetra RHS with the same storage structure as the matrix!
+  Epetra_Vector& epetra_rhs = *dynamic_cast<TrilinosVector&>(rhs).epetra_vector();
+
+  if(!m_mat->StorageOptimized())
+    TRILINOS_THROW(m_mat->OptimizeStorage());
+
+  DirichletRowSet& row_set = dirichlet_row_set(rows);
+  const Uint nb_rows = rows.size();
+
+  // Only the RHS changes once the matrix values for this set of rows are cached
+  if(!row_set.values_cached)
+  {
+    increment_generation();
+    int* index_offset;
+    int* indices;
+    Real* mat_values;
+    TRILINOS_THROW(m_mat->ExtractCrsDataPointers(index_offset, indices, mat_values));
+
+    // Constrained rows become identity rows
+    for(Uint i = 0; i != nb_rows; ++i)
+    {
+      const int bc_row = m_p2m[rows[i]];
+      if(bc_row >= m_num_my_elements)
+        continue;
+      for(int k = index_offset[bc_row]; k != index_offset[bc_row+1]; ++k)
+        mat_values[k] = indices[k] == bc_row ? 1. : 0.;
+    }
+
+    // Move the constrained columns out of the matrix
+    const Uint nb_entries = row_set.entry_offsets.size();
+    for(Uint e = 0; e != nb_entries; ++e)
+    {
+      row_set.entry_values[e] = mat_values[row_set.entry_offsets[e]];
+      mat_values[row_set.entry_offsets[e]] = 0.;
+    }
+    row_set.values_cached = true;
+  }
+
+  for(Uint i = 0; i != nb_rows; ++i)
+  {
+    const Real value = values[i];
+    const int entries_end = row_set.column_start[i+1];
+    for(int e = row_set.column_start[i]; e != entries_end; ++e)
+      epetra_rhs[row_set.entry_rows[e]] -= row_set.entry_values[e] * value;
+  }
+
+  for(Uint i = 0; i != nb_rows; ++i)
+  {
+    rhs.set_value(rows[i], values[i]);
+    m_dirichlet_nodes.push_back(std::make_pair(rows[i] / m_neq, rows[i] % m_neq));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 const std::vector<std::pair<Uint, Uint> >& TrilinosCrsMatrix::get_dirichlet_nodes() const
 {
   return m_dirichlet_nodes;
@@ -412,6 +565,7 @@ const std::vector<std::pair<Uint, Uint> >& TrilinosCrsMatrix::get_dirichlet_node
 
 void TrilinosCrsMatrix::tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from)
 {
+  increment_generation();
   cf3_assert(m_is_created);
   int num_entries_from;
   Real* extracted_values_from;
@@ -465,6 +619,7 @@ void TrilinosCrsMatrix::tie_blockrow_pairs (const Uint iblockrow_to, const Uint
 
 void TrilinosCrsMatrix::set_diagonal(const std::vector<Real>& diag)
 {
+  increment_generation();
   cf3_assert(m_is_created);
   cf3_assert(diag.size() == m_p2m.size());
   Epetra_Vector new_diag(m_mat->RowMap());
@@ -476,6 +631,7 @@ void TrilinosCrsMatrix::set_diagonal(const std::vector<Real>& diag)
 
 void TrilinosCrsMatrix::add_diagonal(const std::vector<Real>& diag)
 {
+  increment_generation();
   cf3_assert(m_is_created);
   cf3_assert(diag.size() == m_p2m.size());
   Epetra_Vector new_diag(m_mat->RowMap());
@@ -505,12 +661,24 @@ void TrilinosCrsMatrix::get_diagonal(std::vector<Real>& diag)
 
 void TrilinosCrsMatrix::reset(Real reset_to)
 {
+  increment_generation();
   cf3_assert(m_is_created);
   CFdebug << "Resetting CrsMatrix to " << reset_to << CFendl;
   TRILINOS_THROW(m_mat->PutScalar(reset_to));
 
   m_symmetric_dirichlet_values.clear();
   m_dirichlet_nodes.clear();
+  // Sets that were not applied since the previous reset belong to boundary conditions that are no longer used
+  for(DirichletRowSetsT::iterator it = m_dirichlet_row_sets.begin(); it != m_dirichlet_row_sets.end();)
+  {
+    if(!it->second.values_cached)
+    {
+      m_dirichlet_row_sets.erase(it++);
+      continue;
+    }
+    it->second.values_cached = false;
+    ++it;
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -533,12 +701,15 @@ void TrilinosCrsMatrix::clone_to(Matrix &other)
   other_ptr->m_node_connectivity = m_node_connectivity;
   other_ptr->m_starting_indices = m_starting_indices;
   other_ptr->m_symmetric_dirichlet_values = m_symmetric_dirichlet_values;
+  other_ptr->m_dirichlet_row_sets = m_dirichlet_row_sets;
+  other_ptr->increment_generation();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 void TrilinosCrsMatrix::read_native(const common::URI& file)
 {  
+  increment_generation();
   EpetraExt::readEpetraLinearSystem(file.path(), m_comm, &m_mat);
   
   m_is_created = true;
@@ -683,6 +854,27 @@ void TrilinosCrsMatrix::blocked_var_gids ( const VariablesDescriptor& var_descri
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+std::size_t TrilinosCrsMatrix::memory_footprint() const
+{
+  std::size_t result = (m_p2m.capacity() + m_converted_indices.capacity() + m_node_connectivity.capacity() + m_starting_indices.capacity()) * sizeof(int);
+  if(m_is_created)
+  {
+    // Values and column indices of the entries, row offsets and the column map
+    result += static_cast<std::size_t>(m_mat->NumMyNonzeros()) * (sizeof(Real) + sizeof(int));
+    result += static_cast<std::size_t>(m_mat->NumMyRows() + 1 + m_mat->NumMyCols()) * sizeof(int);
+  }
+  for(DirichletRowSetsT::const_iterator it = m_dirichlet_row_sets.begin(); it != m_dirichlet_row_sets.end(); ++it)
+  {
+    const DirichletRowSet& set = it->second;
+    result += set.rows.capacity() * sizeof(Uint) + (set.column_start.capacity() + set.entry_rows.capacity() + set.entry_offsets.capacity()) * sizeof(int);
+    result += set.entry_values.capacity() * sizeof(Real);
+  }
+  result += m_dirichlet_nodes.capacity() * sizeof(std::pair<Uint,Uint>);
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 void TrilinosCrsMatrix::debug_data(std::vector<Uint>& row_indices, std::vector<Uint>& col_indices, std::vector<Real>& values)
 {
   row_indices.clear(); col_indices.clear(); values.clear();
@@ -721,6 +913,8 @@ Teuchos::RCP< const Thyra::LinearOpBase< Real > > TrilinosCrsMatrix::thyra_opera
 
 Teuchos::RCP< Thyra::LinearOpBase< Real > > TrilinosCrsMatrix::thyra_operator()
 {
+  // The operator gives write access to the entries
+  increment_generation();
   return Thyra::nonconstEpetraLinearOp(m_mat);
 }
 
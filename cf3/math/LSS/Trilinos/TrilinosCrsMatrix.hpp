@@ -9,10 +9,14 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <map>
+
 #include <Epetra_MpiComm.h>
 #include <Epetra_CrsMatrix.h>
 #include <Teuchos_RCP.hpp>
 
+#include "common/MemoryComponent.hpp"
+
 #include "math/LSS/LibLSS.hpp"
 #include "math/LSS/BlockAccumulator.hpp"
 #include "math/LSS/Vector.hpp"
@@ -37,7 +41,7 @@ namespace LSS {
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-class LSS_API TrilinosCrsMatrix : public LSS::Matrix, public ThyraOperator {
+class LSS_API TrilinosCrsMatrix : public LSS::Matrix, public ThyraOperator, public common::MemoryComponent {
 public:
 
   /// @name CREATION, DESTRUCTION AND COMPONENT SYSTEM
@@ -92,6 +96,12 @@ public:
   /// Add a list of values
   void get_values(BlockAccumulator& values);
 
+  /// Set a dense block of values
+  void set_block_values(const Uint* indices, const Uint nb_nodes, const Real* values);
+
+  /// Add a dense block of values
+  void add_block_values(const Uint* indices, const Uint nb_nodes, const Real* values);
+
   /// Set a row, diagonal and off-diagonals values separately (dirichlet-type boundaries)
   void set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval);
 
@@ -101,6 +111,10 @@ public:
 
   virtual void symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, Vector& rhs);
 
+  /// Apply symmetric dirichlet conditions on a set of rows in a single pass over the affected column entries.
+  /// The entries are located once per set of rows, and their values are cached until the next reset.
+  virtual void symmetric_dirichlet_rows(const std::vector<Uint>& rows, const std::vector<Real>& values, Vector& rhs);
+
   /// Get the nodes and equations for all dirichlet boundary conditions that have been applied so far
   const std::vector< std::pair< Uint, Uint > >& get_dirichlet_nodes( ) const;
 
@@ -147,9 +161,10 @@ public:
   /// Accessor to the number of block columns
   const Uint blockcol_size() {  cf3_assert(m_is_created); return m_p2m.size()/neq(); }
 
-  /// Get the matrix in native format
+  /// Get the matrix in native format. The entries may be modified through the result, so this counts as a modification
   Teuchos::RCP<Epetra_CrsMatrix> epetra_matrix()
   {
+    increment_generation();
     return m_mat;
   }
 
@@ -162,6 +177,7 @@ public:
   /// Replace the internal matrix with the supplied one
   void replace_epetra_matrix(const Teuchos::RCP<Epetra_CrsMatrix>& mat)
   {
+    increment_generation();
     m_mat = mat;
   }
   
@@ -176,6 +192,9 @@ public:
     return m_p2m[inode*m_neq+ieq];
   }
 
+  /// Estimate of the bytes used by the Epetra storage and the index maps
+  std::size_t memory_footprint() const;
+
   //@} END MISCELLANEOUS
 
   /// @name LINEAR ALGEBRA
@@ -233,6 +252,30 @@ private:
   typedef std::map<int, DirichletEntryT> DirichletMapT;
   DirichletMapT m_symmetric_dirichlet_values;
 
+  /// Matrix entries affected by a set of symmetric dirichlet rows, stored per constrained column in compressed form
+  struct DirichletRowSet
+  {
+    /// Constrained rows, in the numbering of the interface (blockrow*neq+eq)
+    std::vector<Uint> rows;
+    /// Start of the entries of each constrained column, with one extra element at the end
+    std::vector<int> column_start;
+    /// Matrix row of each entry. Rows that are constrained themselves are left out
+    std::vector<int> entry_rows;
+    /// Offset of each entry in the values array of the matrix
+    std::vector<int> entry_offsets;
+    /// Values of the entries, moved out of the matrix the first time the set is applied after a reset
+    std::vector<Real> entry_values;
+    bool values_cached;
+  };
+
+  /// Find or build the entries for the given set of rows
+  DirichletRowSet& dirichlet_row_set(const std::vector<Uint>& rows);
+
+  /// Row sets, keyed by the hash of their rows. reset() drops the sets that were not applied since the previous reset,
+  /// so only the sets of the current boundary conditions are kept.
+  typedef std::multimap<std::size_t, DirichletRowSet> DirichletRowSetsT;
+  DirichletRowSetsT m_dirichlet_row_sets;
+
   std::vector< std::pair<Uint,Uint> > m_dirichlet_nodes;
 }; // end of class Matrix
 
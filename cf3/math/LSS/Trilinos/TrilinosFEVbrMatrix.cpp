@@ -70,6 +70,7 @@ TrilinosFEVbrMatrix::TrilinosFEVbrMatrix(const std::string& name) :
 
 void TrilinosFEVbrMatrix::create(cf3::common::PE::CommPattern& cp, const Uint neq, const std::vector<Uint>& node_connectivity, const std::vector<Uint>& starting_indices, LSS::Vector& solution, LSS::Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
 {
+  increment_generation();
   /// @todo structurally symmetricize the matrix
   /// @todo ensure main diagonal blocks always existent
 
@@ -135,6 +136,7 @@ void TrilinosFEVbrMatrix::create(cf3::common::PE::CommPattern& cp, const Uint ne
 
 void TrilinosFEVbrMatrix::create_blocked(common::PE::CommPattern& cp, const VariablesDescriptor& vars, const std::vector< Uint >& node_connectivity, const std::vector< Uint >& starting_indices, Vector& solution, Vector& rhs, const std::vector<Uint>& periodic_links_nodes, const std::vector<bool>& periodic_links_active)
 {
+  increment_generation();
   throw common::NotImplemented(FromHere(), "create_blocked is not implemented for TrilinosFEVbrMatrix");
 }
 
@@ -143,6 +145,7 @@ void TrilinosFEVbrMatrix::create_blocked(common::PE::CommPattern& cp, const Vari
 
 void TrilinosFEVbrMatrix::destroy()
 {
+  increment_generation();
   if (m_is_created) m_mat.reset();
   m_p2m.resize(0);
   m_p2m.reserve(0);
@@ -156,6 +159,7 @@ void TrilinosFEVbrMatrix::destroy()
 
 void TrilinosFEVbrMatrix::set_value(const Uint icol, const Uint irow, const Real value)
 {
+  increment_generation();
   cf3_assert(m_is_created);
   const int colblock=(int)m_p2m[icol/m_neq];
   const int colsub=(int)(icol%m_neq);
@@ -179,6 +183,7 @@ void TrilinosFEVbrMatrix::set_value(const Uint icol, const Uint irow, const Real
 
 void TrilinosFEVbrMatrix::add_value(const Uint icol, const Uint irow, const Real value)
 {
+  increment_generation();
   cf3_assert(m_is_created);
   const int colblock=(int)m_p2m[icol/m_neq];
   const int colsub=(int)(icol%m_neq);
@@ -225,17 +230,29 @@ void TrilinosFEVbrMatrix::get_value(const Uint icol, const Uint irow, Real& valu
 
 void TrilinosFEVbrMatrix::set_values(const BlockAccumulator& values)
 {
+  increment_generation();
+  cf3_assert(values.mat.rows() == static_cast<int>(values.indices.size()*m_neq));
+  if(values.indices.empty())
+    return;
+  set_block_values(&values.indices[0], values.indices.size(), values.mat.data());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosFEVbrMatrix::set_block_values(const Uint* indices, const Uint nb_nodes, const Real* values)
+{
+  increment_generation();
   cf3_assert(m_is_created);
   Epetra_SerialDenseMatrix **val;
   int* colindices;
   int blockrowsize;
   int dummyneq;
   int hits=0;
-  const int numblocks=values.indices.size();
-  const int rowoffset=(numblocks-1)*m_neq;
+  const int numblocks=nb_nodes;
+  const int rowstride=numblocks*m_neq;
   const int neqneq=m_neq*m_neq;
   if (m_converted_indices.size()<numblocks) m_converted_indices.resize(numblocks);
-  for (int i=0; i<(const int)numblocks; i++) m_converted_indices[i]=m_p2m[values.indices[i]];
+  for (int i=0; i<(const int)numblocks; i++) m_converted_indices[i]=m_p2m[indices[i]];
   int* idxs=(int*)&m_converted_indices[0];
   for (int irow=0; irow<(const int)numblocks; irow++)
   {
@@ -248,13 +265,14 @@ void TrilinosFEVbrMatrix::set_values(const BlockAccumulator& values)
         for (int icol=0; icol<(const int)numblocks; icol++)
           if (colindices[j]==idxs[icol])
           {
+            // epetra blocks are column-major, the values are row-major
             double *emv=val[j][0].A();
-            int col_idx = icol*m_neq;
-            for (double* l=emv; emv<(const double*)(l+neqneq); ++col_idx)
+            const Real* col_start = values + irow*m_neq*rowstride + icol*m_neq;
+            for (double* l=emv; emv<(const double*)(l+neqneq); ++col_start)
             {
-              int row_idx = irow*m_neq;
-              for (double* m=emv; emv<(const double*)(m+m_neq);)
-                *emv++ = values.mat(row_idx++, col_idx);
+              const Real* v = col_start;
+              for (double* m=emv; emv<(const double*)(m+m_neq); v+=rowstride)
+                *emv++ = *v;
             }
 
             hits++;
@@ -270,60 +288,29 @@ void TrilinosFEVbrMatrix::set_values(const BlockAccumulator& values)
 
 void TrilinosFEVbrMatrix::add_values(const BlockAccumulator& values)
 {
-/* TRILINOS-ADVICED
-  cf3_assert(m_is_created);
-  const int numblocks=values.indices.size();
-  if (m_converted_indices.size()<numblocks) m_converted_indices.resize(numblocks);
-  for (int i=0; i<(const int)numblocks; i++) m_converted_indices[i]=m_p2m[values.indices[i]];
-  int* idxs=(int*)&m_converted_indices[0];
-  for (int irow=0; irow<(const int)numblocks; irow++)
-    if (idxs[irow]<m_blockrow_size)
-    {
-      TRILINOS_ASSERT(m_mat->BeginSumIntoMyValues(idxs[irow],numblocks,idxs));
-      for (int icol=0; icol<numblocks; icol++)
-        TRILINOS_ASSERT(m_mat->SubmitBlockEntry((double*)values.mat.data()+irow*m_neq+icol*m_neq*m_neq*numblocks,numblocks*m_neq,m_neq,m_neq));
-      TRILINOS_ASSERT(m_mat->EndSubmitEntries());
-    }
-*/
-/* MANUAL FILL
-  cf3_assert(m_is_created);
-  Epetra_SerialDenseMatrix **val;
-  int* colindices;
-  int blockrowsize;
-  int dummyneq;
-  int hits=0;
-  const int numblocks=values.indices.size();
-  if (m_converted_indices.size()<numblocks) m_converted_indices.resize(numblocks);
-  for (int i=0; i<(const int)numblocks; i++) m_converted_indices[i]=m_p2m[values.indices[i]];
-  int* idxs=(int*)&m_converted_indices[0];
-  for (int irow=0; irow<(const int)numblocks; irow++)
-  {
-    if (idxs[irow]<m_blockrow_size)
-    {
-      TRILINOS_ASSERT(m_mat->ExtractMyBlockRowView(idxs[irow],dummyneq,blockrowsize,colindices,val));
-      for (int j=0; j<(const int)blockrowsize; j++)
-        for (int k=0; k<(const int)numblocks; k++)
-          if (colindices[j]==idxs[k])
-            for (int l=0; l<(const int)m_neq; l++)
-              for (int m=0; m<(const int)m_neq; m++)
-                val[j][0](l,m)+=values.mat(irow*m_neq+l,k*m_neq+m);
-      hits++;
-      if (hits==numblocks) break;
-    }
-  }
-*/
-/* FINAL OPTIMIZED */
+  increment_generation();
+  cf3_assert(values.mat.rows() == static_cast<int>(values.indices.size()*m_neq));
+  if(values.indices.empty())
+    return;
+  add_block_values(&values.indices[0], values.indices.size(), values.mat.data());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosFEVbrMatrix::add_block_values(const Uint* indices, const Uint nb_nodes, const Real* values)
+{
+  increment_generation();
   cf3_assert(m_is_created);
   Epetra_SerialDenseMatrix **val;
   int* colindices;
   int blockrowsize;
   int dummyneq;
   int hits=0;
-  const int numblocks=values.indices.size();
-  const int rowoffset=(numblocks-1)*m_neq;
+  const int numblocks=nb_nodes;
+  const int rowstride=numblocks*m_neq;
   const int neqneq=m_neq*m_neq;
   if (m_converted_indices.size()<numblocks) m_converted_indices.resize(numblocks);
-  for (int i=0; i<(const int)numblocks; i++) m_converted_indices[i]=m_p2m[values.indices[i]];
+  for (int i=0; i<(const int)numblocks; i++) m_converted_indices[i]=m_p2m[indices[i]];
   int* idxs=(int*)&m_converted_indices[0];
   for (int irow=0; irow<(const int)numblocks; irow++)
   {
@@ -336,13 +323,14 @@ void TrilinosFEVbrMatrix::add_values(const BlockAccumulator& values)
         for (int icol=0; icol<(const int)numblocks; icol++)
           if (colindices[j]==idxs[icol])
           {
+            // epetra blocks are column-major, the values are row-major
             double *emv=val[j][0].A();
-            int col_idx = icol*m_neq;
-            for (double* l=emv; emv<(const double*)(l+neqneq); ++col_idx)
+            const Real* col_start = values + irow*m_neq*rowstride + icol*m_neq;
+            for (double* l=emv; emv<(const double*)(l+neqneq); ++col_start)
             {
-              int row_idx = irow*m_neq;
-              for (double* m=emv; emv<(const double*)(m+m_neq);)
-                *emv++ += values.mat(row_idx++, col_idx);
+              const Real* v = col_start;
+              for (double* m=emv; emv<(const double*)(m+m_neq); v+=rowstride)
+                *emv++ += *v;
             }
 
             hits++;
@@ -404,6 +392,7 @@ void TrilinosFEVbrMatrix::get_values(BlockAccumulator& values)
 
 void TrilinosFEVbrMatrix::set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval)
 {
+  increment_generation();
 /* TRILINOS ADVICED
   cf3_assert(m_is_created);
   Epetra_SerialDenseMatrix **val;
@@ -451,6 +440,7 @@ void TrilinosFEVbrMatrix::set_row(const Uint iblockrow, const Uint ieq, Real dia
 
 void TrilinosFEVbrMatrix::get_column_and_replace_to_zero(const Uint iblockcol, Uint ieq, std::vector<Real>& values)
 {
+  increment_generation();
   /// @note this could be made faster if structural symmetry is ensured during create, because then involved rows could be determined by indices in the ibloccol-th row
   /// @attention COMPUTATIONALLY VERY EXPENSIVE!
   cf3_assert(m_is_created);
@@ -481,6 +471,7 @@ void TrilinosFEVbrMatrix::get_column_and_replace_to_zero(const Uint iblockcol, U
 
 void TrilinosFEVbrMatrix::symmetric_dirichlet(const Uint blockrow, const Uint ieq, const Real value, Vector& rhs)
 {
+  increment_generation();
   const int columns_begin = m_starting_indices[blockrow];
   const int columns_end = m_starting_indices[blockrow+1];
 
@@ -557,6 +548,7 @@ void TrilinosFEVbrMatrix::symmetric_dirichlet(const Uint blockrow, const Uint ie
 
 void TrilinosFEVbrMatrix::tie_blockrow_pairs (const Uint iblockrow_to, const Uint iblockrow_from)
 {
+  increment_generation();
   cf3_assert(m_is_created);
   Epetra_SerialDenseMatrix **val_to,**val_from;
   int* colindices_to, *colindices_from;
@@ -593,6 +585,7 @@ void TrilinosFEVbrMatrix::tie_blockrow_pairs (const Uint iblockrow_to, const Uin
 
 void TrilinosFEVbrMatrix::set_diagonal(const std::vector<Real>& diag)
 {
+  increment_generation();
   cf3_assert(m_is_created);
   int *dummy_rowcoldim;
   double *entryvals;
@@ -615,6 +608,7 @@ void TrilinosFEVbrMatrix::set_diagonal(const std::vector<Real>& diag)
 
 void TrilinosFEVbrMatrix::add_diagonal(const std::vector<Real>& diag)
 {
+  increment_generation();
   cf3_assert(m_is_created);
   int *dummy_rowcoldim;
   double *entryvals;
@@ -660,6 +654,7 @@ void TrilinosFEVbrMatrix::get_diagonal(std::vector<Real>& diag)
 
 void TrilinosFEVbrMatrix::reset(Real reset_to)
 {
+  increment_generation();
   cf3_assert(m_is_created);
   m_mat->PutScalar(reset_to);
 }
@@ -754,6 +749,20 @@ void TrilinosFEVbrMatrix::print_native(ostream& stream)
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+std::size_t TrilinosFEVbrMatrix::memory_footprint() const
+{
+  std::size_t result = (m_p2m.capacity() + m_converted_indices.capacity()) * sizeof(int);
+  if(m_is_created)
+  {
+    // Values of the blocks, block column indices, block row offsets and the column map
+    result += static_cast<std::size_t>(m_mat->NumMyNonzeros()) * sizeof(Real);
+    result += static_cast<std::size_t>(m_mat->NumMyBlockEntries() + m_mat->NumMyBlockRows() + 1 + m_mat->NumMyBlockCols()) * sizeof(int);
+  }
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 void TrilinosFEVbrMatrix::debug_data(std::vector<Uint>& row_indices, std::vector<Uint>& col_indices, std::vector<Real>& values)
 {
   cf3_assert(m_is_created);
@@ -790,6 +799,8 @@ Teuchos::RCP< const Thyra::LinearOpBase< Real > > TrilinosFEVbrMatrix::thyra_ope
 
 Teuchos::RCP< Thyra::LinearOpBase< Real > > TrilinosFEVbrMatrix::thyra_operator()
 {
+  // The operator gives write access to the entries
+  increment_generation();
   return Thyra::nonconstEpetraLinearOp(m_mat);
 }
 
@@ -804,6 +815,7 @@ void TrilinosFEVbrMatrix::clone_to(Matrix &other)
 
 void TrilinosFEVbrMatrix::read_native(const common::URI& file)
 {
+  increment_generation();
   throw common::NotImplemented(FromHere(), "read_native method is not impmemented for " + derived_type_name());
 }
 
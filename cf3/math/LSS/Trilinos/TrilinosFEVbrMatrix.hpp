@@ -13,6 +13,8 @@
 #include <Epetra_FEVbrMatrix.h>
 #include <Teuchos_RCP.hpp>
 
+#include "common/MemoryComponent.hpp"
+
 #include "math/LSS/LibLSS.hpp"
 #include "math/LSS/BlockAccumulator.hpp"
 #include "math/LSS/Vector.hpp"
@@ -37,7 +39,7 @@ namespace LSS {
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-class LSS_API TrilinosFEVbrMatrix : public LSS::Matrix, public ThyraOperator {
+class LSS_API TrilinosFEVbrMatrix : public LSS::Matrix, public ThyraOperator, public common::MemoryComponent {
 public:
 
   /// @name CREATION, DESTRUCTION AND COMPONENT SYSTEM
@@ -93,6 +95,12 @@ public:
   /// Add a list of values
   void get_values(BlockAccumulator& values);
 
+  /// Set a dense block of values, writing directly into the epetra blocks
+  void set_block_values(const Uint* indices, const Uint nb_nodes, const Real* values);
+
+  /// Add a dense block of values, writing directly into the epetra blocks
+  void add_block_values(const Uint* indices, const Uint nb_nodes, const Real* values);
+
   /// Set a row, diagonal and off-diagonals values separately (dirichlet-type boundaries)
   void set_row(const Uint iblockrow, const Uint ieq, Real diagval, Real offdiagval);
 
@@ -149,6 +157,9 @@ public:
   
   virtual void read_native(const common::URI& file);
 
+  /// Estimate of the bytes used by the Epetra storage and the index maps
+  std::size_t memory_footprint() const;
+
   //@} END MISCELLANEOUS
 
   /// @name LINEAR ALGEBRA
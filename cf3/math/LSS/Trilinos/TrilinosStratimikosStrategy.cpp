@@ -6,6 +6,9 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <cmath>
+#include <deque>
+
 #include <boost/mpl/vector.hpp>
 #include <boost/mpl/for_each.hpp>
 #include <boost/bind.hpp>
@@ -27,6 +30,9 @@
 #include "common/Builder.hpp"
 #include "common/EventHandler.hpp"
 #include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+
+#include "math/MatrixTypes.hpp"
 
 #include "ParameterList.hpp"
 #include "ThyraVector.hpp"
@@ -56,6 +62,10 @@ struct TrilinosStratimikosStrategy::Implementation
     m_parameter_list(Teuchos::createParameterList()),
     m_preconditioner_reset(1),
     m_iteration_count(0),
+    m_nb_previous_solutions(3),
+    m_preconditioner_growth(0.),
+    m_reference_iterations(0.),
+    m_rebuild_preconditioner(false),
     m_xcoords(0)
   {
     Teko::addTekoToStratimikosBuilder(m_linear_solver_builder);
@@ -83,6 +93,33 @@ struct TrilinosStratimikosStrategy::Implementation
       .mark_basic()
       .link_to(&m_preconditioner_reset);
 
+    m_self.options().add("preconditioner_growth", m_preconditioner_growth)
+      .pretty_name("Preconditioner Growth")
+      .description("If larger than zero, the preconditioner is also rebuilt when the number of iterations exceeds this factor "
+                   "times the number of iterations of the first solve after the last rebuild")
+      .link_to(&m_preconditioner_growth);
+
+    m_self.options().add("initial_guess", std::string("Previous"))
+      .pretty_name("Initial Guess")
+      .description("Initial guess for the iterative solver. Previous: the solution vector as it is. Zero: start from zero. "
+                   "Extrapolation: polynomial extrapolation from the previous solutions. "
+                   "POD: least-squares projection of the system onto the span of the previous solutions")
+      .mark_basic();
+    m_self.options().option("initial_guess").restricted_list().push_back(std::string("Previous"));
+    m_self.options().option("initial_guess").restricted_list().push_back(std::string("Zero"));
+    m_self.options().option("initial_guess").restricted_list().push_back(std::string("Extrapolation"));
+    m_self.options().option("initial_guess").restricted_list().push_back(std::string("POD"));
+
+    m_self.options().add("nb_previous_solutions", m_nb_previous_solutions)
+      .pretty_name("Number of Previous Solutions")
+      .description("Number of previous solutions kept for the Extrapolation and POD initial guesses. "
+                   "Extrapolation uses at most three of them, for a quadratic extrapolation")
+      .link_to(&m_nb_previous_solutions)
+      .attach_trigger(boost::bind(&Implementation::trigger_nb_previous_solutions, this));
+
+    m_self.properties().add("iterations", 0);
+    m_self.properties().add("iterations_saved", 0.);
+
     m_self.options().add("settings_file", common::URI("", cf3::common::URI::Scheme::FILE))
       .supported_protocol(cf3::common::URI::Scheme::FILE)
       .pretty_name("Settings File")
@@ -119,6 +156,12 @@ struct TrilinosStratimikosStrategy::Implementation
     setup_solver();
   }
 
+  void trigger_nb_previous_solutions()
+  {
+    while(m_previous_solutions.size() > m_nb_previous_solutions)
+      m_previous_solutions.pop_back();
+  }
+
   void setup_solver()
   {
     m_lows_factory = Thyra::createLinearSolveStrategy(m_linear_solver_builder);
@@ -126,6 +169,11 @@ struct TrilinosStratimikosStrategy::Implementation
     m_lows_factory->setVerbLevel(static_cast<Teuchos::EVerbosityLevel>(verb));
     m_lows.reset();
     m_residual_vec.reset();
+    m_initial_vec.reset();
+    m_work_vec.reset();
+    m_previous_solutions.clear();
+    m_projected_solutions.clear();
+    m_rebuild_preconditioner = false;
 
     // Update the component tree that represents the parameters. This automatically exposes available options
     update_parameters();
@@ -151,10 +199,11 @@ struct TrilinosStratimikosStrategy::Implementation
       m_lows = m_lows_factory->createOp();
     }
 
-    
-    if(m_iteration_count % m_preconditioner_reset == 0)
+    const bool rebuild_preconditioner = m_rebuild_preconditioner || m_iteration_count % m_preconditioner_reset == 0;
+    if(rebuild_preconditioner)
     {
       Thyra::initializeOp(*m_lows_factory, m_matrix->thyra_operator(), m_lows.ptr());
+      m_rebuild_preconditioner = false;
     }
     else
     {
@@ -163,16 +212,22 @@ struct TrilinosStratimikosStrategy::Implementation
 
     Teuchos::RCP< Thyra::VectorBase<Real> const > b = m_rhs->thyra_vector();
     Teuchos::RCP< Thyra::VectorBase<Real> > x = m_solution->thyra_vector();
-    
+
+    const Real guess_reduction = set_initial_guess(*b, *x);
+
+    Thyra::SolveStatus<double> status;
     try
     {
-      Thyra::SolveStatus<double> status = Thyra::solve<double>(*m_lows, Thyra::NOTRANS, *b, x.ptr());
+      status = Thyra::solve<double>(*m_lows, Thyra::NOTRANS, *b, x.ptr());
       CFinfo << "Thyra::solve finished with status " << status.message << CFendl;
     }
     catch(std::exception& e)
     {
       std::cout << e.what() << std::endl;
     }
+
+    update_statistics(status, rebuild_preconditioner, guess_reduction);
+    store_solution(*x);
     
     if(m_self.options().option("compute_residual").value<bool>())
       CFinfo << "Solver residual: " << compute_residual() << CFendl;
@@ -180,6 +235,158 @@ struct TrilinosStratimikosStrategy::Implementation
     ++m_iteration_count;
   }
 
+  /// Norm of the residual b - Ax, computed in m_work_vec
+  Real residual_norm(const Thyra::VectorBase<Real>& b, const Thyra::VectorBase<Real>& x)
+  {
+    if(m_work_vec.is_null())
+      m_work_vec = b.clone_v();
+
+    Thyra::assign(m_work_vec.ptr(), b);
+    m_matrix->thyra_operator()->apply(Thyra::NOTRANS, x, m_work_vec.ptr(), -1., 1.);
+    return Thyra::norm_2(*m_work_vec);
+  }
+
+  /// Set the initial guess according to the "initial_guess" option
+  /// @return Logarithm of the ratio between the residual of the solution vector as it was and the residual of the guess,
+  /// i.e. the residual reduction obtained by the guess
+  Real set_initial_guess(const Thyra::VectorBase<Real>& b, Thyra::VectorBase<Real>& x)
+  {
+    const std::string method = m_self.options().option("initial_guess").value<std::string>();
+    if(method == "Zero")
+    {
+      Thyra::assign(Teuchos::ptrFromRef(x), 0.);
+      return 0.;
+    }
+
+    if(method == "Previous" || m_previous_solutions.empty())
+      return 0.;
+
+    // Keep the solution vector as it is, in case the guess turns out to be worse
+    if(m_initial_vec.is_null())
+      m_initial_vec = x.clone_v();
+    else
+      Thyra::assign(m_initial_vec.ptr(), x);
+    const Real initial_residual = residual_norm(b, x);
+
+    if(method == "Extrapolation")
+    {
+      // Polynomial extrapolation, assuming a constant time step
+      const Uint nb_points = std::min(static_cast<Uint>(m_previous_solutions.size()), 3u);
+      if(nb_points == 1)
+      {
+        Thyra::assign(Teuchos::ptrFromRef(x), *m_previous_solutions[0]);
+      }
+      else if(nb_points == 2)
+      {
+        Thyra::V_StV(Teuchos::ptrFromRef(x), 2., *m_previous_solutions[0]);
+        Thyra::Vp_StV(Teuchos::ptrFromRef(x), -1., *m_previous_solutions[1]);
+      }
+      else
+      {
+        Thyra::V_StV(Teuchos::ptrFromRef(x), 3., *m_previous_solutions[0]);
+        Thyra::Vp_StV(Teuchos::ptrFromRef(x), -3., *m_previous_solutions[1]);
+        Thyra::Vp_StV(Teuchos::ptrFromRef(x), 1., *m_previous_solutions[2]);
+      }
+    }
+    else if(method == "POD")
+    {
+      // Minimize |b - A Q y| over the span Q of the previous solutions, through the normal equations
+      const Uint nb_vectors = m_previous_solutions.size();
+      while(m_projected_solutions.size() < nb_vectors)
+        m_projected_solutions.push_back(b.clone_v());
+
+      for(Uint i = 0; i != nb_vectors; ++i)
+        m_matrix->thyra_operator()->apply(Thyra::NOTRANS, *m_previous_solutions[i], m_projected_solutions[i].ptr(), 1., 0.);
+
+      RealMatrix gram(nb_vectors, nb_vectors);
+      RealVector projected_rhs(nb_vectors);
+      for(Uint i = 0; i != nb_vectors; ++i)
+      {
+        projected_rhs[i] = Thyra::dot(*m_projected_solutions[i], b);
+        for(Uint j = 0; j <= i; ++j)
+        {
+          gram(i, j) = Thyra::dot(*m_projected_solutions[i], *m_projected_solutions[j]);
+          gram(j, i) = gram(i, j);
+        }
+      }
+
+      // Previous solutions are often nearly linearly dependent, so regularize slightly
+      const Real regularization = 1e-12 * gram.trace() / static_cast<Real>(nb_vectors);
+      for(Uint i = 0; i != nb_vectors; ++i)
+        gram(i, i) += regularization;
+
+      const RealVector coefficients = gram.ldlt().solve(projected_rhs);
+      Thyra::assign(Teuchos::ptrFromRef(x), 0.);
+      for(Uint i = 0; i != nb_vectors; ++i)
+        Thyra::Vp_StV(Teuchos::ptrFromRef(x), coefficients[i], *m_previous_solutions[i]);
+    }
+
+    const Real guess_residual = residual_norm(b, x);
+    if(!(guess_residual < initial_residual))
+    {
+      Thyra::assign(Teuchos::ptrFromRef(x), *m_initial_vec);
+      return 0.;
+    }
+
+    return guess_residual > 0. ? std::log(initial_residual / guess_residual) : 0.;
+  }
+
+  /// Keep a copy of the solution, recycling the storage of the oldest one
+  void store_solution(const Thyra::VectorBase<Real>& x)
+  {
+    const std::string method = m_self.options().option("initial_guess").value<std::string>();
+    if(m_nb_previous_solutions == 0 || method == "Previous" || method == "Zero")
+    {
+      m_previous_solutions.clear();
+      return;
+    }
+
+    Teuchos::RCP< Thyra::VectorBase<Real> > stored;
+    if(m_previous_solutions.size() == m_nb_previous_solutions)
+    {
+      stored = m_previous_solutions.back();
+      m_previous_solutions.pop_back();
+      Thyra::assign(stored.ptr(), x);
+    }
+    else
+    {
+      stored = x.clone_v();
+    }
+    m_previous_solutions.push_front(stored);
+  }
+
+  /// Store the iteration counts as properties, and decide on rebuilding the preconditioner
+  void update_statistics(const Thyra::SolveStatus<double>& status, const bool preconditioner_rebuilt, const Real guess_reduction)
+  {
+    int nb_iterations = -1;
+    if(!status.extraParameters.is_null())
+    {
+      if(status.extraParameters->isParameter("Belos/Iteration Count"))
+        nb_iterations = status.extraParameters->get<int>("Belos/Iteration Count");
+      else if(status.extraParameters->isParameter("Iteration Count"))
+        nb_iterations = status.extraParameters->get<int>("Iteration Count");
+    }
+
+    if(nb_iterations < 0)
+      return;
+
+    // Estimate the iterations saved by the initial guess from the average residual reduction per iteration
+    Real iterations_saved = 0.;
+    if(nb_iterations > 0 && status.achievedTol > 0. && status.achievedTol < 1.)
+      iterations_saved = guess_reduction * static_cast<Real>(nb_iterations) / -std::log(status.achievedTol);
+
+    m_self.properties()["iterations"] = nb_iterations;
+    m_self.properties()["iterations_saved"] = iterations_saved;
+
+    if(m_preconditioner_growth > 0.)
+    {
+      if(preconditioner_rebuilt)
+        m_reference_iterations = std::max(static_cast<Real>(nb_iterations), 1.);
+      else if(static_cast<Real>(nb_iterations) > m_preconditioner_growth * m_reference_iterations)
+        m_rebuild_preconditioner = true;
+    }
+  }
+
   Real compute_residual()
   {
     if(is_null(m_matrix))
@@ -249,6 +456,22 @@ struct TrilinosStratimikosStrategy::Implementation
   
   Uint m_preconditioner_reset;
   Uint m_iteration_count;
+
+  /// Previous solutions, most recent first
+  std::deque< Teuchos::RCP< Thyra::VectorBase<Real> > > m_previous_solutions;
+  /// Previous solutions multiplied with the matrix, for the POD initial guess
+  std::vector< Teuchos::RCP< Thyra::VectorBase<Real> > > m_projected_solutions;
+  /// Copy of the solution vector before the initial guess was set
+  Teuchos::RCP< Thyra::VectorBase<Real> > m_initial_vec;
+  /// Work vector for the residual of the initial guess
+  Teuchos::RCP< Thyra::VectorBase<Real> > m_work_vec;
+  Uint m_nb_previous_solutions;
+
+  Real m_preconditioner_growth;
+  /// Iterations of the first solve after the last preconditioner rebuild
+  Real m_reference_iterations;
+  /// True if the iteration count grew enough to rebuild the preconditioner at the next solve
+  bool m_rebuild_preconditioner;
   
   Real* m_xcoords;
   Real* m_ycoords;
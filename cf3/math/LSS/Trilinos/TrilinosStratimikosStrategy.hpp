@@ -27,6 +27,14 @@ namespace LSS {
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+/// Solve using the Trilinos Stratimikos interface, which gives access to the Belos iterative solvers.
+///
+/// For sequences of slowly varying systems, as in unsteady simulations, the "initial_guess" option
+/// selects how the solution of the previous systems is used to start the iterations. The "iterations"
+/// and "iterations_saved" properties give the iteration count of the last solve and an estimate of the
+/// iterations saved by the initial guess. The preconditioner can be rebuilt when the iteration count
+/// grows (option "preconditioner_growth"), and the Krylov subspace can be recycled between solves
+/// by using the GCRODR solver (default parameters cf3.math.LSS.BelosGCRODRParameters).
 class LSS_API TrilinosStratimikosStrategy : public CoordinatesStrategy
 {
 public:
@@ -281,6 +281,48 @@ void TrilinosVector::get_sol_values(BlockAccumulator& values)
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+void TrilinosVector::set_block_values(const Uint* indices, const Uint nb_nodes, const Real* values)
+{
+  cf3_assert(m_is_created);
+  for (Uint i=0; i<nb_nodes; i++)
+  {
+    cf3_assert(indices[i] < m_blockrow_size);
+    const int* p2m = &m_p2m[indices[i]*m_neq];
+    for (int j=0; j<(const int)m_neq; j++)
+      m_data[p2m[j]]=*values++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosVector::add_block_values(const Uint* indices, const Uint nb_nodes, const Real* values)
+{
+  cf3_assert(m_is_created);
+  for (Uint i=0; i<nb_nodes; i++)
+  {
+    cf3_assert(indices[i] < m_blockrow_size);
+    const int* p2m = &m_p2m[indices[i]*m_neq];
+    for (int j=0; j<(const int)m_neq; j++)
+      m_data[p2m[j]]+=*values++;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void TrilinosVector::get_block_values(const Uint* indices, const Uint nb_nodes, Real* values)
+{
+  cf3_assert(m_is_created);
+  for (Uint i=0; i<nb_nodes; i++)
+  {
+    cf3_assert(indices[i] < m_blockrow_size);
+    const int* p2m = &m_p2m[indices[i]*m_neq];
+    for (int j=0; j<(const int)m_neq; j++)
+      *values++=m_data[p2m[j]];
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 void TrilinosVector::reset(Real reset_to)
 {
   cf3_assert(m_is_created);
@@ -371,6 +413,14 @@ void TrilinosVector::print_native(ostream& stream)
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+std::size_t TrilinosVector::memory_footprint() const
+{
+  // The Epetra vector is a view on m_data
+  return m_data.capacity() * sizeof(Real) + (m_p2m.capacity() + m_converted_indices.capacity()) * sizeof(int);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
 void TrilinosVector::debug_data(std::vector<Real>& values)
 {
   cf3_assert(m_is_created);
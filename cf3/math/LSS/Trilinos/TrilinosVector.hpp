@@ -15,6 +15,8 @@
 #include <Epetra_Vector.h>
 #include <Teuchos_RCP.hpp>
 
+#include "common/MemoryComponent.hpp"
+
 #include "math/LSS/LibLSS.hpp"
 #include "math/LSS/BlockAccumulator.hpp"
 #include "math/LSS/Vector.hpp"
@@ -47,7 +49,7 @@ namespace LSS {
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-class LSS_API TrilinosVector : public LSS::Vector, public ThyraVector {
+class LSS_API TrilinosVector : public LSS::Vector, public ThyraVector, public common::MemoryComponent {
 public:
 
   /// @name CREATION, DESTRUCTION AND COMPONENT SYSTEM
@@ -116,6 +118,15 @@ public:
   /// Get a list of values from sol
   void get_sol_values(BlockAccumulator& values);
 
+  /// Set the values for a list of block rows
+  void set_block_values(const Uint* indices, const Uint nb_nodes, const Real* values);
+
+  /// Add the values for a list of block rows
+  void add_block_values(const Uint* indices, const Uint nb_nodes, const Real* values);
+
+  /// Get the values for a list of block rows
+  void get_block_values(const Uint* indices, const Uint nb_nodes, Real* values);
+
   /// Reset Vector
   void reset(Real reset_to=0.);
 
@@ -167,6 +178,9 @@ public:
   
   virtual void read_native(const common::URI& filename, const string type = "");
   
+  /// Estimate of the bytes used by the Epetra storage and the index maps
+  std::size_t memory_footprint() const;
+
   //@} END MISCELLANEOUS
 
   /// @name TEST ONLY
@@ -9,6 +9,8 @@
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+
 #include <boost/utility.hpp>
 
 #include "math/LSS/LibLSS.hpp"
@@ -104,6 +106,80 @@ public:
   /// Get a list of values from sol
   virtual void get_sol_values(BlockAccumulator& values) = 0;
 
+  /// Set a list of values to rhs from a fixed-size block accumulator
+  template<Uint NbNodes, Uint NbEqs>
+  void set_rhs_values(const BlockAccumulatorT<NbNodes, NbEqs>& values)
+  {
+    cf3_assert(NbEqs == neq());
+    set_block_values(values.indices.data(), NbNodes, values.rhs.data());
+  }
+
+  /// Add a list of values to rhs from a fixed-size block accumulator
+  template<Uint NbNodes, Uint NbEqs>
+  void add_rhs_values(const BlockAccumulatorT<NbNodes, NbEqs>& values)
+  {
+    cf3_assert(NbEqs == neq());
+    add_block_values(values.indices.data(), NbNodes, values.rhs.data());
+  }
+
+  /// Get a list of values from rhs into a fixed-size block accumulator
+  template<Uint NbNodes, Uint NbEqs>
+  void get_rhs_values(BlockAccumulatorT<NbNodes, NbEqs>& values)
+  {
+    cf3_assert(NbEqs == neq());
+    get_block_values(values.indices.data(), NbNodes, values.rhs.data());
+  }
+
+  /// Set a list of values to sol from a fixed-size block accumulator
+  template<Uint NbNodes, Uint NbEqs>
+  void set_sol_values(const BlockAccumulatorT<NbNodes, NbEqs>& values)
+  {
+    cf3_assert(NbEqs == neq());
+    set_block_values(values.indices.data(), NbNodes, values.sol.data());
+  }
+
+  /// Add a list of values to sol from a fixed-size block accumulator
+  template<Uint NbNodes, Uint NbEqs>
+  void add_sol_values(const BlockAccumulatorT<NbNodes, NbEqs>& values)
+  {
+    cf3_assert(NbEqs == neq());
+    add_block_values(values.indices.data(), NbNodes, values.sol.data());
+  }
+
+  /// Get a list of values from sol into a fixed-size block accumulator
+  template<Uint NbNodes, Uint NbEqs>
+  void get_sol_values(BlockAccumulatorT<NbNodes, NbEqs>& values)
+  {
+    cf3_assert(NbEqs == neq());
+    get_block_values(values.indices.data(), NbNodes, values.sol.data());
+  }
+
+  /// Set the values for the nb_nodes block rows given in indices, with neq() values per block row.
+  /// The default implementation copies the data into a BlockAccumulator, backends should override it to avoid the copy.
+  virtual void set_block_values(const Uint* indices, const Uint nb_nodes, const Real* values)
+  {
+    BlockAccumulator block;
+    copy_block(indices, nb_nodes, values, block);
+    set_rhs_values(block);
+  }
+
+  /// Add the values for the given block rows, with the same layout as set_block_values
+  virtual void add_block_values(const Uint* indices, const Uint nb_nodes, const Real* values)
+  {
+    BlockAccumulator block;
+    copy_block(indices, nb_nodes, values, block);
+    add_rhs_values(block);
+  }
+
+  /// Get the values for the given block rows, with the same layout as set_block_values
+  virtual void get_block_values(const Uint* indices, const Uint nb_nodes, Real* values)
+  {
+    BlockAccumulator block;
+    copy_block(indices, nb_nodes, values, block);
+    get_rhs_values(block);
+    std::copy(block.rhs.data(), block.rhs.data() + block.rhs.size(), values);
+  }
+
   /// Reset Vector
   virtual void reset(Real reset_to=0.) = 0;
 
@@ -170,6 +246,15 @@ public:
 
   //@} END TEST ONLY
 
+private:
+  /// Copy a raw block into the RHS of a dynamic block accumulator
+  void copy_block(const Uint* indices, const Uint nb_nodes, const Real* values, BlockAccumulator& block)
+  {
+    block.resize(nb_nodes, neq());
+    block.indices.assign(indices, indices + nb_nodes);
+    std::copy(values, values + block.rhs.size(), block.rhs.data());
+  }
+
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////
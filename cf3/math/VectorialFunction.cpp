@@ -4,6 +4,7 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <boost/algorithm/string/trim.hpp>
 #include <boost/tokenizer.hpp>
 
 #include "common/Log.hpp"
@@ -173,6 +174,15 @@ void VectorialFunction::parse()
     }
   }
 
+  // The FunctionParser checked the syntax, so compilation only fails for constructs the compiler does not support
+  std::vector<std::string> var_names;
+  boost::char_separator<char> sep(",");
+  typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
+  tokenizer tok (m_vars,sep);
+  for (tokenizer::iterator el=tok.begin(); el!=tok.end(); ++el)
+    var_names.push_back(boost::algorithm::trim_copy(*el));
+  m_compiled.compile(m_functions, var_names);
+
   m_result.resize(m_functions.size());
   m_is_parsed = true;
 }
@@ -196,6 +206,26 @@ RealVector& VectorialFunction::operator()( const VariablesT& var_values)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void VectorialFunction::evaluate_points(const Real* var_values, const Uint nb_points, Real* ret_values) const
+{
+  cf3_assert(m_is_parsed);
+
+  if(m_compiled.is_compiled())
+  {
+    m_compiled.evaluate(var_values, nb_points, ret_values);
+    return;
+  }
+
+  const Uint nbfuncs = m_parsers.size();
+  for(Uint pt = 0; pt != nb_points; ++pt)
+  {
+    for(Uint i = 0; i != nbfuncs; ++i)
+      ret_values[pt*nbfuncs + i] = m_parsers[i]->Eval(var_values + pt*m_nbvars);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 RealVector& VectorialFunction::operator()( const RealVector& var_values)
 {
   cf3_assert(m_is_parsed);
@@ -13,6 +13,7 @@
 
 #include "common/BasicExceptions.hpp"
 
+#include "math/CompiledFunction.hpp"
 #include "math/LibMath.hpp"
 #include "math/MatrixTypes.hpp"
 
@@ -65,6 +66,17 @@ public: // functions
   /// @param var_values values of the variables to substitute in the function.
   RealVector& operator()(const VariablesT& var_values);
 
+  /// Evaluate the Vectorial Function for a range of points at once, using the compiled version of the functions
+  /// if possible. This is much faster than evaluating point by point when there are many points.
+  /// For points outside the domain of a function, the compiled version returns NaN.
+  /// @param var_values values of the variables, stored per point (nb_points rows of nbvars() values)
+  /// @param nb_points number of points
+  /// @param ret_values the placeholder for the results, stored per point (nb_points rows of nbfuncs() values)
+  void evaluate_points(const Real* var_values, const Uint nb_points, Real* ret_values) const;
+
+  /// True if the functions could be compiled for evaluation over a range of points
+  bool is_compiled() const { return m_compiled.is_compiled(); }
+
   /// Evaluate the Vectorial Function given the values of the variables
   /// and return it in the stored result. This function allows this class to work
   /// as a functor.
@@ -122,6 +134,9 @@ private: // data
   /// vector holding the parsers, one for each entry in the vector
   std::vector<FunctionParser*> m_parsers;
 
+  /// compiled version of all functions, used to evaluate ranges of points
+  CompiledFunction m_compiled;
+
   /// storage of the result for using the class as functor
   RealVector m_result;
 
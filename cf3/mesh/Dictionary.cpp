@@ -217,7 +217,7 @@ Field& Dictionary::create_field(const std::string &name, const VarType var_type)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-Field& Dictionary::create_field(const std::string &name, const std::string& description)
+Field& Dictionary::create_field(const std::string &name, const std::string& description, const bool single_precision)
 {
   Handle<Field> field = create_component<Field>(name);
   field->set_dict(*this);
@@ -226,6 +226,7 @@ Field& Dictionary::create_field(const std::string &name, const std::string& desc
   field->create_descriptor(description,m_dim);
 
   field->set_row_size(field->descriptor().size());
+  field->options().set("single_precision", single_precision);
   field->resize(size());
 
   update_structures();
@@ -236,7 +237,7 @@ Field& Dictionary::create_field(const std::string &name, const std::string& desc
 
 ////////////////////////////////////////////////////////////////////////////////
 
-Field& Dictionary::create_field(const std::string &name, math::VariablesDescriptor& variables_descriptor)
+Field& Dictionary::create_field(const std::string &name, math::VariablesDescriptor& variables_descriptor, const bool single_precision)
 {
   CFinfo << "Creating field " << uri()/name << CFendl;
   if (m_dim == 0) throw SetupError(FromHere(), "dimension not configured");
@@ -248,6 +249,7 @@ Field& Dictionary::create_field(const std::string &name, math::VariablesDescript
     field->descriptor().options().set(common::Tags::dimension(),m_dim);
   }
   field->set_row_size(field->descriptor().size());
+  field->options().set("single_precision", single_precision);
   field->resize(size());
 
   update_structures();
@@ -299,8 +301,8 @@ bool Dictionary::check_sanity(std::vector<std::string>& messages) const
 
   boost_foreach(const Field& field, find_components_recursively<Field>(*this))
   {
-    if (field.size() != size())
-      messages.push_back(uri().string()+": size() ["+to_str(size())+"] != "+field.uri().string()+".size() ["+to_str(field.size())+"]");
+    if (field.nb_rows() != size())
+      messages.push_back(uri().string()+": size() ["+to_str(size())+"] != "+field.uri().string()+".nb_rows() ["+to_str(field.nb_rows())+"]");
   }
   // Sane if number of messages did not grow in size
   return messages.size() == nb_messages_init;
@@ -537,6 +539,9 @@ void Dictionary::signature_create_field( SignalArgs& node )
   options.add("size",Uint(1u))
       .description("Variable length" );
 
+  options.add("single_precision",false)
+      .description("Store the values as float instead of double" );
+
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -548,6 +553,7 @@ void Dictionary::signal_create_field( SignalArgs& node )
   std::string name = options.value<std::string>("name");
   std::string variables = options.value<std::string>("variables");
   Uint cols = options.value<Uint>("size");
+  const bool single_precision = options.check("single_precision") ? options.value<bool>("single_precision") : false;
 
   Handle<Field> field;
   if ( variables.empty() && !name.empty() )
@@ -557,6 +563,9 @@ void Dictionary::signal_create_field( SignalArgs& node )
   else
     throw SetupError(FromHere(), "name and variables/size must be specified");
 
+  if (single_precision)
+    field->options().set("single_precision", true);
+
   SignalFrame reply = node.create_reply(uri());
   SignalOptions reply_options(reply);
   reply_options.add("created_component", field->uri());
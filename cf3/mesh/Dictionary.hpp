@@ -59,11 +59,11 @@ public: // functions
   /// Create a new field in this group
   Field& create_field( const std::string& name, const VarType var_type = SCALAR );
 
-  /// Create a new field in this group
-  Field& create_field( const std::string& name, const std::string& variables_description );
+  /// Create a new field in this group, storing its values as float if single_precision is true
+  Field& create_field( const std::string& name, const std::string& variables_description, const bool single_precision = false );
 
-  /// Create a new field in this group
-  Field& create_field( const std::string& name, math::VariablesDescriptor& variables_descriptor );
+  /// Create a new field in this group, storing its values as float if single_precision is true
+  Field& create_field( const std::string& name, math::VariablesDescriptor& variables_descriptor, const bool single_precision = false );
 
   /// Number of rows of contained fields
   Uint size() const;
@@ -0,0 +1,91 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+
+#include "common/Foreach.hpp"
+
+#include "common/PE/Comm.hpp"
+#include "common/PE/operations.hpp"
+
+#include "mesh/ElementCost.hpp"
+#include "mesh/Entities.hpp"
+#include "mesh/Mesh.hpp"
+
+namespace cf3 {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+
+const std::string& element_cost_name()
+{
+  static const std::string name("element_cost");
+  return name;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void reset_element_cost(Mesh& mesh)
+{
+  boost_foreach(const Handle<Entities>& entities, mesh.elements())
+  {
+    Handle< common::List<Real> > cost(entities->get_child(element_cost_name()));
+    if(is_null(cost))
+      cost = entities->create_component< common::List<Real> >(element_cost_name());
+    cost->resize(entities->size());
+    std::fill(cost->array().data(), cost->array().data() + cost->size(), 0.);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Handle< common::List<Real> > element_cost(const Entities& entities)
+{
+  // The cost is bookkeeping, not part of the state of the elements, so it is writable from const entities
+  Handle< common::List<Real> > cost(const_cast<Entities&>(entities).get_child(element_cost_name()));
+  if(is_null(cost) || cost->size() != entities.size())
+    return Handle< common::List<Real> >();
+  return cost;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Real element_cost_imbalance(const Mesh& mesh)
+{
+  Real local_cost = 0.;
+  boost_foreach(const Handle<Entities>& entities, mesh.elements())
+  {
+    Handle< common::List<Real> > cost = element_cost(*entities);
+    if(is_null(cost))
+      continue;
+    const Uint nb_elems = cost->size();
+    for(Uint i = 0; i != nb_elems; ++i)
+    {
+      if(!entities->is_ghost(i))
+        local_cost += (*cost)[i];
+    }
+  }
+
+  Real max_cost = local_cost;
+  Real total_cost = local_cost;
+  Real nb_ranks = 1.;
+  if(common::PE::Comm::instance().is_active())
+  {
+    common::PE::Comm::instance().all_reduce(common::PE::max(), &local_cost, 1, &max_cost);
+    common::PE::Comm::instance().all_reduce(common::PE::plus(), &local_cost, 1, &total_cost);
+    nb_ranks = static_cast<Real>(common::PE::Comm::instance().size());
+  }
+
+  if(total_cost <= 0.)
+    return 1.;
+
+  return max_cost * nb_ranks / total_cost;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
@@ -0,0 +1,76 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_ElementCost_hpp
+#define cf3_mesh_ElementCost_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include "common/List.hpp"
+
+#include "mesh/LibMesh.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @file
+/// @brief Measured computational cost per element, used to weight the elements when partitioning
+///
+/// The cost is stored in a common::List<Real> named "element_cost" below each Entities.
+/// Element loops that support it (ComputeRHS, the Proto element loops) measure the time spent on
+/// each element and add it to the list, but only if the list exists, so recording is off by default.
+/// The lists are not migrated with the elements: after repartitioning they must be reset.
+
+namespace cf3 {
+namespace mesh {
+
+class Entities;
+class Mesh;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Name of the list holding the element cost
+Mesh_API const std::string& element_cost_name();
+
+/// Create or reset the cost lists of all entities in the mesh, which starts recording the cost
+Mesh_API void reset_element_cost(Mesh& mesh);
+
+/// Cost list of the given entities, or a null handle if the cost is not recorded
+/// or the list is out of date because the number of elements changed
+Mesh_API Handle< common::List<Real> > element_cost(const Entities& entities);
+
+/// Divide the given time equally over the elements in the range. Elements in different calls
+/// may be updated concurrently, as long as the ranges are disjoint.
+inline void add_element_cost(common::List<Real>& cost, const Uint* elems_begin, const Uint* elems_end, const Real time)
+{
+  if(elems_begin == elems_end)
+    return;
+  const Real time_per_elem = time / static_cast<Real>(elems_end - elems_begin);
+  for(const Uint* elem = elems_begin; elem != elems_end; ++elem)
+    cost[*elem] += time_per_elem;
+}
+
+/// Divide the given time equally over the contiguous elements [begin, end)
+inline void add_element_cost(common::List<Real>& cost, const Uint begin, const Uint end, const Real time)
+{
+  if(begin == end)
+    return;
+  const Real time_per_elem = time / static_cast<Real>(end - begin);
+  for(Uint elem = begin; elem != end; ++elem)
+    cost[elem] += time_per_elem;
+}
+
+/// Total recorded cost on each rank divided by the average over the ranks. Must be called on all ranks.
+/// Returns 1 if nothing was recorded.
+Mesh_API Real element_cost_imbalance(const Mesh& mesh);
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_ElementCost_hpp
@@ -50,6 +50,18 @@ void fill(Eigen::Matrix<Real, NbRows, NbCols>& to_fill, const common::Table<Real
   }
 }
 
+/// Fill static sized matrices from single precision storage
+template<typename RowT, int NbRows, int NbCols>
+void fill(Eigen::Matrix<Real, NbRows, NbCols>& to_fill, const common::TableArray<float>::type& data_array, const RowT& element_row, const Uint start=0)
+{
+  for(int node = 0; node != NbRows; ++node)
+  {
+    const common::TableConstRow<float>::type data_row = data_array[element_row[node]];
+    for(Uint j = 0; j != NbCols; ++j)
+      to_fill(node, j) = data_row[j+start];
+  }
+}
+
 /// Fill dynamic matrices
 template<typename RowT>
 void fill(RealMatrix& to_fill, const common::Table<Real>& data_array, const RowT& element_row, const Uint start=0)
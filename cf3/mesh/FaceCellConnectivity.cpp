@@ -119,6 +119,10 @@ void FaceCellConnectivity::build_connectivity()
 
   // declartions
   m_connectivity->resize(0);
+  m_face_nb_in_elem->resize(0);
+  m_is_bdry_face->resize(0);
+  m_cell_rotation->resize(0);
+  m_cell_orientation->resize(0);
   common::Table<Entity>::Buffer f2c = m_connectivity->create_buffer();
   common::Table<Uint>::Buffer face_number = m_face_nb_in_elem->create_buffer();
   common::List<bool>::Buffer is_bdry_face = m_is_bdry_face->create_buffer();
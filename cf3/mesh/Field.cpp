@@ -4,6 +4,7 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <boost/bind.hpp>
 #include <boost/date_time/gregorian/gregorian.hpp>
 
 #include "common/Signal.hpp"
@@ -38,12 +39,17 @@ common::ComponentBuilder < Field, Component, LibMesh >  Field_Builder;
 ////////////////////////////////////////////////////////////////////////////////////////////
 
 Field::Field ( const std::string& name  ) :
-  common::Table<Real> ( name ), m_var_type(ARRAY)
+  common::Table<Real> ( name ), m_var_type(ARRAY), m_single_precision(false)
 {
   mark_basic();
   properties()["date"] = boost::gregorian::to_iso_extended_string(boost::gregorian::day_clock::local_day());
   properties()["time"] = 0.;
   properties()["step"] = 0u;
+
+  options().add("single_precision", m_single_precision)
+    .pretty_name("Single Precision")
+    .description("Store the values as float instead of double. The Table<Real> interface is empty while this is set")
+    .attach_trigger(boost::bind(&Field::trigger_single_precision, this));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -140,7 +146,10 @@ const std::vector< Handle<Space> >& Field::spaces() const
 CommPattern& Field::parallelize_with(CommPattern& comm_pattern)
 {
   m_comm_pattern = Handle<CommPattern>(comm_pattern.handle<Component>());
-  comm_pattern.insert(name(), array(), true);
+  if(m_single_precision)
+    comm_pattern.insert(name(), m_single_array, true);
+  else
+    comm_pattern.insert(name(), Table<Real>::array(), true);
   return comm_pattern;
 }
 
@@ -152,18 +161,18 @@ CommPattern& Field::parallelize()
 
   // Do nothing if parallel already
   if(is_not_null(comm_pattern.get_child(name())))
+  {
+    m_comm_pattern = Handle<CommPattern>(comm_pattern.handle<Component>());
     return comm_pattern;
+  }
 
   return parallelize_with( comm_pattern );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void Field::synchronize()
+CommPattern& Field::comm_pattern()
 {
-  if(!common::PE::Comm::instance().is_active())
-    return;
-
   if(is_null(m_comm_pattern))
   {
     CFdebug << "Applying default parallelization from dict for field " << uri().path() << CFendl;
@@ -171,9 +180,18 @@ void Field::synchronize()
   }
 
   cf3_assert(is_not_null(m_comm_pattern));
+  return *m_comm_pattern;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Field::synchronize()
+{
+  if(!common::PE::Comm::instance().is_active())
+    return;
 
   CFdebug << "Synchronizing field " << uri().path() << CFendl;
-  m_comm_pattern->synchronize( name() );
+  comm_pattern().synchronize( name() );
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -322,5 +340,124 @@ VarType Field::var_type() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void Field::resize(const Uint nb_rows)
+{
+  if(m_single_precision)
+    m_single_array.resize(boost::extents[nb_rows][row_size()]);
+  else
+    Table<Real>::resize(nb_rows);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::size_t Field::memory_footprint() const
+{
+  return Table<Real>::memory_footprint() + m_single_array.num_elements() * sizeof(float);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Field::trigger_single_precision()
+{
+  const bool single_precision = options().value<bool>("single_precision");
+  if(single_precision == m_single_precision)
+    return;
+
+  if(single_precision)
+    store_single(true);
+  else
+    store_double(false);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Field::store_single(const bool copy_values)
+{
+  cf3_assert(!m_single_precision);
+  // The double precision array keeps its number of columns, so row_size() stays valid in both cases
+  const Uint nb_cols = row_size();
+  const Uint nb_rows = Table<Real>::size();
+  if(copy_values)
+  {
+    m_single_array.resize(boost::extents[nb_rows][nb_cols]);
+    const ArrayT& values = Table<Real>::array();
+    for(Uint i = 0; i != nb_rows; ++i)
+      for(Uint j = 0; j != nb_cols; ++j)
+        m_single_array[i][j] = static_cast<float>(values[i][j]);
+  }
+  cf3_assert(m_single_array.size() == nb_rows);
+  Table<Real>::resize(0);
+  m_single_precision = true;
+  update_comm_pattern();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Field::store_double(const bool keep_single)
+{
+  cf3_assert(m_single_precision);
+  const Uint nb_cols = row_size();
+  const Uint nb_rows = m_single_array.size();
+  Table<Real>::resize(nb_rows);
+  ArrayT& values = Table<Real>::array();
+  for(Uint i = 0; i != nb_rows; ++i)
+    for(Uint j = 0; j != nb_cols; ++j)
+      values[i][j] = m_single_array[i][j];
+  if(!keep_single)
+    m_single_array.resize(boost::extents[0][0]);
+  m_single_precision = false;
+  update_comm_pattern();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Field::update_comm_pattern()
+{
+  // Synchronization must use the array that now holds the values
+  if(is_not_null(m_comm_pattern))
+  {
+    m_comm_pattern->clear(name());
+    parallelize_with(*m_comm_pattern);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+DoublePrecisionScope::~DoublePrecisionScope()
+{
+  boost_foreach(const Handle<Field>& field, m_fields)
+  {
+    if(is_null(field))
+      continue;
+    // A read-only scope kept the single precision values, so they are restored without copying
+    field->store_single(m_writable);
+    field->options().set("single_precision", true);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void DoublePrecisionScope::add(Field& field)
+{
+  if(!field.single_precision())
+    return;
+  field.store_double(!m_writable);
+  field.options().set("single_precision", false);
+  m_fields.push_back(field.handle<Field>());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void DoublePrecisionScope::add(Dictionary& dict)
+{
+  boost_foreach(const Handle<Field>& field, dict.fields())
+  {
+    if(is_not_null(field))
+      add(*field);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // mesh
 } // cf3
@@ -30,6 +30,14 @@ namespace mesh {
 /// Field component class
 /// This class stores fields which can be applied
 /// to fields (Field)
+///
+/// The values are stored in double precision by default. Setting the option "single_precision"
+/// moves them to a float array, halving the memory used by fields that are mostly stored, such as
+/// statistics. The Table<Real> part of the field then has no rows, and only row_size() keeps its value.
+/// The values are accessed through value() and set_value(), which work for both storages, through single_array(),
+/// or after switching the field back to double precision with a DoublePrecisionScope.
+/// Proto expressions, InitFieldFunction and the time averaging read and write single precision fields directly.
+/// Writers, restart files and the MeshAdaptor open a DoublePrecisionScope.
 /// @author Willem Deconinck, Tiago Quintino
 class Mesh_API Field : public common::Table<Real> {
 
@@ -43,6 +51,9 @@ public: // typedefs
 
   typedef Eigen::Block<Ref, Eigen::Dynamic, 1> RefCol;
 
+  /// Storage used when the field is in single precision
+  typedef common::TableArray<float>::type SingleArrayT;
+
   typedef Eigen::Array<Real,1,Eigen::Dynamic,Eigen::RowMajor> RowArrayStorage ;
   typedef Eigen::Map< RowArrayStorage , Eigen::Unaligned > RowArrayRef ;
 
@@ -122,6 +133,9 @@ public: // functions
 
   common::PE::CommPattern& parallelize();
 
+  /// Comm pattern used to synchronize this field, applying the default parallelization from the dictionary if needed
+  common::PE::CommPattern& comm_pattern();
+
   void synchronize();
 
   math::VariablesDescriptor& descriptor() const { return *m_descriptor; }
@@ -146,6 +160,39 @@ public: // functions
 
   VarType var_type() const ;
 
+  /// Resize the storage that is in use to the given number of rows
+  virtual void resize(const Uint nb_rows);
+
+  /// Bytes used by the double and single precision arrays
+  virtual std::size_t memory_footprint() const;
+
+  /// True if the values are stored in single precision
+  bool single_precision() const { return m_single_precision; }
+
+  /// Single precision storage, only sized when single_precision() is true
+  SingleArrayT& single_array() { return m_single_array; }
+
+  /// Single precision storage, only sized when single_precision() is true
+  const SingleArrayT& single_array() const { return m_single_array; }
+
+  /// Value at the given row and column, regardless of the storage precision
+  Real value(const Uint row, const Uint col) const
+  {
+    return m_single_precision ? static_cast<Real>(m_single_array[row][col]) : Table<Real>::operator[](row)[col];
+  }
+
+  /// Set the value at the given row and column, rounding it if the storage is in single precision
+  void set_value(const Uint row, const Uint col, const Real value)
+  {
+    if(m_single_precision)
+      m_single_array[row][col] = static_cast<float>(value);
+    else
+      Table<Real>::operator[](row)[col] = value;
+  }
+
+  /// Number of rows in the storage that is in use. Only one of the two arrays has rows, so this needs no branch
+  Uint nb_rows() const { return Table<Real>::size() + m_single_array.size(); }
+
   ////////////////////////////////////////////////////////////////////////////////
 
     // Index operator.
@@ -319,6 +366,21 @@ public: // functions
 
 private:
 
+  friend class DoublePrecisionScope;
+
+  /// Move the values to the storage selected by the single_precision option
+  void trigger_single_precision();
+
+  /// Move the values to the float array. If copy_values is false, the float array must still hold the values
+  /// kept by store_double(true), and the double precision values are dropped
+  void store_single(const bool copy_values);
+
+  /// Move the values to the double array. If keep_single is true, the float array is kept for store_single(false)
+  void store_double(const bool keep_single);
+
+  /// Register the array that holds the values with the comm pattern
+  void update_comm_pattern();
+
   Handle<Dictionary> m_dict;
 
   Handle< common::PE::CommPattern > m_comm_pattern;
@@ -326,6 +388,46 @@ private:
   Handle< math::VariablesDescriptor > m_descriptor;
 
   VarType m_var_type;
+
+  /// True if m_single_array holds the values
+  bool m_single_precision;
+
+  SingleArrayT m_single_array;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Switches fields that are stored in single precision to double precision for the lifetime of the scope,
+/// and back to single precision when it ends. Fields that are already in double precision are left alone,
+/// so scopes on the same field can be nested.
+/// A scope that is not writable keeps the single precision values and drops the double precision copy at the end,
+/// so changes made inside the scope are lost. A writable scope rounds the double precision values back.
+class Mesh_API DoublePrecisionScope : public boost::noncopyable
+{
+public:
+  /// Empty scope, fields are added with add()
+  explicit DoublePrecisionScope(const bool writable) : m_writable(writable) {}
+
+  /// Scope on a single field
+  DoublePrecisionScope(Field& field, const bool writable) : m_writable(writable) { add(field); }
+
+  /// Scope on all fields of a dictionary
+  DoublePrecisionScope(Dictionary& dict, const bool writable) : m_writable(writable) { add(dict); }
+
+  /// Restores single precision for the fields that were switched
+  ~DoublePrecisionScope();
+
+  /// Switch the field to double precision if it is stored in single precision
+  void add(Field& field);
+
+  /// Switch all fields of the dictionary to double precision
+  void add(Dictionary& dict);
+
+private:
+  /// True if the values are copied back to single precision at the end
+  const bool m_writable;
+  /// Fields that were switched by this scope
+  std::vector< Handle<Field> > m_fields;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -6,6 +6,9 @@
 
 #include "common/FindComponents.hpp"
 #include "common/List.hpp"
+#include "common/Table.hpp"
+
+#include "math/Consts.hpp"
 
 #include "mesh/Connectivity.hpp"
 #include "mesh/Dictionary.hpp"
@@ -128,5 +131,57 @@ boost::shared_ptr< common::List< Uint > > build_used_nodes_list( const Component
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void build_element_colors( const Table<Uint>& connectivity, const Uint nb_nodes, std::vector< std::vector<Uint> >& colors )
+{
+  colors.clear();
+
+  const Uint nb_elems = connectivity.size();
+  const Uint nb_nodes_per_elem = connectivity.row_size();
+
+  // Elements that still need a color
+  std::vector<Uint> uncolored(nb_elems);
+  for(Uint e = 0; e != nb_elems; ++e)
+    uncolored[e] = e;
+
+  // Last color in which each node was touched
+  std::vector<Uint> node_color(nb_nodes, math::Consts::uint_max());
+
+  std::vector<Uint> remaining;
+  remaining.reserve(nb_elems);
+  while(!uncolored.empty())
+  {
+    const Uint color = colors.size();
+    colors.push_back(std::vector<Uint>());
+    std::vector<Uint>& color_elems = colors.back();
+    remaining.clear();
+    boost_foreach(const Uint e, uncolored)
+    {
+      Table<Uint>::ConstRow nodes = connectivity[e];
+      bool free = true;
+      for(Uint i = 0; i != nb_nodes_per_elem; ++i)
+      {
+        if(node_color[nodes[i]] == color)
+        {
+          free = false;
+          break;
+        }
+      }
+      if(free)
+      {
+        for(Uint i = 0; i != nb_nodes_per_elem; ++i)
+          node_color[nodes[i]] = color;
+        color_elems.push_back(e);
+      }
+      else
+      {
+        remaining.push_back(e);
+      }
+    }
+    uncolored.swap(remaining);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 } // mesh
 } // cf3
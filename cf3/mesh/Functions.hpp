@@ -15,6 +15,7 @@ namespace cf3 {
 namespace common {
 class Component;
 template <typename T> class List;
+template <typename T> class Table;
 }
 namespace mesh {
 
@@ -39,6 +40,16 @@ boost::shared_ptr< common::List< Uint > > build_used_nodes_list( const std::vect
 /// @return used_nodes  List of used nodes
 boost::shared_ptr< common::List< Uint > > build_used_nodes_list( const common::Component& node_user, const Dictionary& dictionary, const bool include_ghost_elems, const bool follow_periodic_links = true);
 
+/// build_element_colors
+/// @brief Group elements in colors, so that no two elements of the same color share a node
+///
+/// All elements of one color can then scatter to their nodes concurrently. Colors are filled
+/// greedily, so the first colors are the largest ones.
+/// @param [in]  connectivity  element to node connectivity table
+/// @param [in]  nb_nodes      number of nodes the connectivity table refers to
+/// @param [out] colors        element indices for each color, sorted within each color
+void build_element_colors( const common::Table<Uint>& connectivity, const Uint nb_nodes, std::vector< std::vector<Uint> >& colors );
+
 ////////////////////////////////////////////////////////////////////////////////
 
 } // mesh
@@ -0,0 +1,452 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+
+#include <boost/cstdint.hpp>
+
+#include "common/Builder.hpp"
+#include "common/Foreach.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+
+#include "common/PE/Comm.hpp"
+#include "common/PE/operations.hpp"
+
+#include "math/BoundingBox.hpp"
+#include "math/Consts.hpp"
+#include "math/Hilbert.hpp"
+
+#include "mesh/GeometricPartitioner.hpp"
+
+namespace cf3 {
+namespace mesh {
+
+using namespace common;
+
+////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < GeometricPartitioner, MeshTransformer, LibMesh > GeometricPartitioner_Builder;
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/// Maximum number of bisection steps when searching a cut
+const Uint max_cut_iterations = 64;
+
+/// Sorted local keys with their cumulative weight, to evaluate the weight below a cut
+template<typename KeyT>
+struct WeightedKeys
+{
+  /// Sorts the given keys and weights
+  void build(std::vector< std::pair<KeyT,Real> >& key_weights)
+  {
+    std::sort(key_weights.begin(), key_weights.end());
+    const Uint nb_keys = key_weights.size();
+    keys.resize(nb_keys);
+    cumulative_weight.resize(nb_keys);
+    Real sum = 0.;
+    for(Uint i = 0; i != nb_keys; ++i)
+    {
+      keys[i] = key_weights[i].first;
+      sum += key_weights[i].second;
+      cumulative_weight[i] = sum;
+    }
+  }
+
+  /// Local weight of the keys smaller than or equal to cut
+  Real weight_up_to(const KeyT cut) const
+  {
+    const Uint idx = std::upper_bound(keys.begin(), keys.end(), cut) - keys.begin();
+    return idx == 0 ? 0. : cumulative_weight[idx-1];
+  }
+
+  std::vector<KeyT> keys;
+  std::vector<Real> cumulative_weight;
+};
+
+inline boost::uint64_t midpoint(const boost::uint64_t lo, const boost::uint64_t hi)
+{
+  return lo + (hi - lo) / 2;
+}
+
+inline Real midpoint(const Real lo, const Real hi)
+{
+  return 0.5*(lo + hi);
+}
+
+/// Sum over all ranks, in place
+void sum_over_ranks(std::vector<Real>& values)
+{
+  if(PE::Comm::instance().is_active() && !values.empty())
+    PE::Comm::instance().all_reduce(PE::plus(), values, values);
+}
+
+/// Find the cuts in parallel: cut i is the smallest key (up to the bisection resolution) for which the
+/// global weight of the keys in key_sets[set_of_cut[i]] that are smaller than or equal to the cut reaches target[i].
+/// lo and hi must bracket the keys of each set, and are identical on all ranks. All cuts are bisected
+/// together, so every iteration takes a single reduction. On return, lo[i] is the last trial below the cut,
+/// so the keys in (lo[i], hi[i]] are the ones on the cut.
+template<typename KeyT>
+void find_cuts(const std::vector< const WeightedKeys<KeyT>* >& key_sets, const std::vector<Uint>& set_of_cut,
+               const std::vector<Real>& target, std::vector<KeyT>& lo, std::vector<KeyT>& hi)
+{
+  const Uint nb_cuts = target.size();
+  std::vector<KeyT> mid(nb_cuts);
+  std::vector<Real> weight(nb_cuts);
+  for(Uint iter = 0; iter != max_cut_iterations; ++iter)
+  {
+    bool converged = true;
+    for(Uint i = 0; i != nb_cuts; ++i)
+    {
+      mid[i] = midpoint(lo[i], hi[i]);
+      if(mid[i] != lo[i] && mid[i] != hi[i])
+        converged = false;
+      weight[i] = key_sets[set_of_cut[i]]->weight_up_to(mid[i]);
+    }
+    // lo and hi are the same on all ranks, so all ranks stop together
+    if(converged)
+      return;
+
+    sum_over_ranks(weight);
+    for(Uint i = 0; i != nb_cuts; ++i)
+    {
+      if(weight[i] >= target[i])
+        hi[i] = mid[i];
+      else
+        lo[i] = mid[i];
+    }
+  }
+}
+
+/// Set of elements in the recursive coordinate bisection, to be divided over nb_parts parts
+struct RCBBox
+{
+  Uint first_part;
+  Uint nb_parts;
+  std::vector<Uint> elements;
+};
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+GeometricPartitioner::GeometricPartitioner ( const std::string& name ) :
+    MeshPartitioner(name),
+    m_dim(0)
+{
+  options().add("method", std::string("Hilbert"))
+      .description("Hilbert: cut a Hilbert space filling curve through the element centroids in pieces of equal weight. "
+                   "RCB: recursive coordinate bisection of the element centroids.")
+      .pretty_name("Method")
+      .mark_basic();
+  options().option("method").restricted_list().push_back(std::string("Hilbert"));
+  options().option("method").restricted_list().push_back(std::string("RCB"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+GeometricPartitioner::~GeometricPartitioner ( )
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GeometricPartitioner::partition_graph()
+{
+  compute_centroids();
+
+  std::vector<Uint> parts;
+  if(options().value<std::string>("method") == "RCB")
+    partition_rcb(parts);
+  else
+    partition_hilbert(parts);
+
+  const Uint rank = PE::Comm::instance().is_active() ? PE::Comm::instance().rank() : 0;
+  const Uint nb_elems = m_element_location.size();
+  for(Uint i = 0; i != nb_elems; ++i)
+  {
+    if(parts[i] != rank)
+      m_elements_to_export[parts[i]][m_element_location[i].first].push_back(m_element_location[i].second);
+  }
+
+  // cleanup
+  m_centroids.clear();
+  m_weights.clear();
+  m_element_location.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GeometricPartitioner::compute_centroids()
+{
+  Mesh& mesh = *m_mesh;
+  m_dim = mesh.dimension();
+  const common::Table<Real>& coordinates = mesh.geometry_fields().coordinates();
+
+  Uint nb_elems = 0;
+  boost_foreach(const Handle<Entities>& entities, mesh.elements())
+    nb_elems += entities->size();
+
+  m_centroids.assign(nb_elems*m_dim, 0.);
+  m_weights.resize(nb_elems);
+  m_element_location.resize(nb_elems);
+
+  Uint idx = 0;
+  for(Uint entities_idx = 0; entities_idx != mesh.elements().size(); ++entities_idx)
+  {
+    const Entities& entities = *mesh.elements()[entities_idx];
+    const Connectivity& connectivity = entities.geometry_space().connectivity();
+    const Uint nb_entities_elems = entities.size();
+    for(Uint elem = 0; elem != nb_entities_elems; ++elem, ++idx)
+    {
+      Real* centroid = &m_centroids[idx*m_dim];
+      const Connectivity::ConstRow nodes = connectivity[elem];
+      boost_foreach(const Uint node, nodes)
+      {
+        for(Uint d = 0; d != m_dim; ++d)
+          centroid[d] += coordinates[node][d];
+      }
+      for(Uint d = 0; d != m_dim; ++d)
+        centroid[d] /= static_cast<Real>(nodes.size());
+
+      m_weights[idx] = element_weight(entities, elem);
+      m_element_location[idx] = std::make_pair(entities_idx, elem);
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GeometricPartitioner::partition_hilbert(std::vector<Uint>& parts) const
+{
+  const Uint nb_elems = m_weights.size();
+  const Uint nb_parts = options().value<Uint>("nb_parts");
+
+  // Bounding box of all centroids
+  std::vector<Real> box_min(m_dim, math::Consts::real_max());
+  std::vector<Real> box_max(m_dim, -math::Consts::real_max());
+  for(Uint i = 0; i != nb_elems; ++i)
+  {
+    for(Uint d = 0; d != m_dim; ++d)
+    {
+      box_min[d] = std::min(box_min[d], m_centroids[i*m_dim+d]);
+      box_max[d] = std::max(box_max[d], m_centroids[i*m_dim+d]);
+    }
+  }
+  if(PE::Comm::instance().is_active())
+  {
+    PE::Comm::instance().all_reduce(PE::min(), box_min, box_min);
+    PE::Comm::instance().all_reduce(PE::max(), box_max, box_max);
+  }
+  const math::BoundingBox bounding_box(box_min, box_max);
+  math::Hilbert compute_hilbert_idx(bounding_box, 20);
+
+  std::vector< std::pair<boost::uint64_t,Real> > key_weights(nb_elems);
+  std::vector<boost::uint64_t> element_keys(nb_elems);
+  RealVector centroid(m_dim);
+  Real total_weight = 0.;
+  for(Uint i = 0; i != nb_elems; ++i)
+  {
+    for(Uint d = 0; d != m_dim; ++d)
+      centroid[d] = m_centroids[i*m_dim+d];
+    element_keys[i] = compute_hilbert_idx(centroid);
+    key_weights[i] = std::make_pair(element_keys[i], m_weights[i]);
+    total_weight += m_weights[i];
+  }
+  WeightedKeys<boost::uint64_t> keys;
+  keys.build(key_weights);
+
+  std::vector<Real> global_weight(1, total_weight);
+  sum_over_ranks(global_weight);
+
+  // Cut the curve at equal fractions of the total weight
+  const Uint nb_cuts = nb_parts - 1;
+  std::vector< const WeightedKeys<boost::uint64_t>* > key_sets(1, &keys);
+  std::vector<Uint> set_of_cut(nb_cuts, 0);
+  std::vector<Real> target(nb_cuts);
+  for(Uint i = 0; i != nb_cuts; ++i)
+    target[i] = global_weight[0] * static_cast<Real>(i+1) / static_cast<Real>(nb_parts);
+  std::vector<boost::uint64_t> lo(nb_cuts, 0);
+  std::vector<boost::uint64_t> hi(nb_cuts, compute_hilbert_idx.max_key());
+  find_cuts(key_sets, set_of_cut, target, lo, hi);
+
+  // Element goes to the first part whose cut is not below its key
+  parts.resize(nb_elems);
+  for(Uint i = 0; i != nb_elems; ++i)
+    parts[i] = std::lower_bound(hi.begin(), hi.end(), element_keys[i]) - hi.begin();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GeometricPartitioner::partition_rcb(std::vector<Uint>& parts) const
+{
+  const Uint nb_elems = m_weights.size();
+
+  std::vector<RCBBox> boxes(1);
+  boxes[0].first_part = 0;
+  boxes[0].nb_parts = options().value<Uint>("nb_parts");
+  boxes[0].elements.resize(nb_elems);
+  for(Uint i = 0; i != nb_elems; ++i)
+    boxes[0].elements[i] = i;
+
+  // Every iteration bisects all boxes that still hold more than one part. The number of parts
+  // per box is the same on all ranks, so all ranks take part in the same reductions.
+  while(true)
+  {
+    std::vector<Uint> active;
+    for(Uint b = 0; b != boxes.size(); ++b)
+    {
+      if(boxes[b].nb_parts > 1)
+        active.push_back(b);
+    }
+    if(active.empty())
+      break;
+
+    const Uint nb_active = active.size();
+
+    // Global extent and weight of each box
+    std::vector<Real> box_min(nb_active*m_dim, math::Consts::real_max());
+    std::vector<Real> box_max(nb_active*m_dim, -math::Consts::real_max());
+    std::vector<Real> box_weight(nb_active, 0.);
+    for(Uint a = 0; a != nb_active; ++a)
+    {
+      boost_foreach(const Uint elem, boxes[active[a]].elements)
+      {
+        for(Uint d = 0; d != m_dim; ++d)
+        {
+          box_min[a*m_dim+d] = std::min(box_min[a*m_dim+d], m_centroids[elem*m_dim+d]);
+          box_max[a*m_dim+d] = std::max(box_max[a*m_dim+d], m_centroids[elem*m_dim+d]);
+        }
+        box_weight[a] += m_weights[elem];
+      }
+    }
+    if(PE::Comm::instance().is_active())
+    {
+      PE::Comm::instance().all_reduce(PE::min(), box_min, box_min);
+      PE::Comm::instance().all_reduce(PE::max(), box_max, box_max);
+    }
+    sum_over_ranks(box_weight);
+
+    // Cut each box along its longest direction
+    std::vector<Uint> cut_dim(nb_active, 0);
+    std::vector< WeightedKeys<Real> > coordinates(nb_active);
+    std::vector< const WeightedKeys<Real>* > key_sets(nb_active);
+    std::vector<Uint> set_of_cut(nb_active);
+    std::vector<Real> target(nb_active);
+    std::vector<Real> lo(nb_active);
+    std::vector<Real> hi(nb_active);
+    for(Uint a = 0; a != nb_active; ++a)
+    {
+      const RCBBox& box = boxes[active[a]];
+      for(Uint d = 1; d != m_dim; ++d)
+      {
+        if(box_max[a*m_dim+d] - box_min[a*m_dim+d] > box_max[a*m_dim+cut_dim[a]] - box_min[a*m_dim+cut_dim[a]])
+          cut_dim[a] = d;
+      }
+
+      std::vector< std::pair<Real,Real> > coordinate_weights(box.elements.size());
+      for(Uint i = 0; i != box.elements.size(); ++i)
+        coordinate_weights[i] = std::make_pair(m_centroids[box.elements[i]*m_dim+cut_dim[a]], m_weights[box.elements[i]]);
+      coordinates[a].build(coordinate_weights);
+
+      key_sets[a] = &coordinates[a];
+      set_of_cut[a] = a;
+      target[a] = box_weight[a] * static_cast<Real>(box.nb_parts/2) / static_cast<Real>(box.nb_parts);
+      lo[a] = box_min[a*m_dim+cut_dim[a]];
+      hi[a] = box_max[a*m_dim+cut_dim[a]];
+    }
+    find_cuts(key_sets, set_of_cut, target, lo, hi);
+
+    // Elements with their centroid on the cut make up a column (in 2D) or a layer (in 3D), which can hold much
+    // more than the weight still missing below the cut, e.g. when the weights are measured. Such ties are split
+    // by a second cut along the longest other direction of the box.
+    std::vector<Real> weight_below(2*nb_active);
+    for(Uint a = 0; a != nb_active; ++a)
+    {
+      weight_below[2*a] = coordinates[a].weight_up_to(lo[a]);
+      weight_below[2*a+1] = coordinates[a].weight_up_to(hi[a]);
+    }
+    sum_over_ranks(weight_below);
+
+    std::vector<bool> split_ties(nb_active, false);
+    std::vector<Uint> tie_dim(nb_active, 0);
+    std::vector< WeightedKeys<Real> > ties(nb_active);
+    std::vector< const WeightedKeys<Real>* > tie_sets(nb_active);
+    std::vector<Real> tie_target(nb_active);
+    std::vector<Real> tie_lo(nb_active);
+    std::vector<Real> tie_hi(nb_active);
+    for(Uint a = 0; a != nb_active; ++a)
+    {
+      tie_sets[a] = &ties[a];
+      tie_target[a] = target[a] - weight_below[2*a];
+      tie_dim[a] = cut_dim[a] == 0 ? 1 : 0;
+      for(Uint d = 0; d != m_dim; ++d)
+      {
+        if(d != cut_dim[a] && box_max[a*m_dim+d] - box_min[a*m_dim+d] > box_max[a*m_dim+tie_dim[a]] - box_min[a*m_dim+tie_dim[a]])
+          tie_dim[a] = d;
+      }
+      // The same decision on all ranks, as it only depends on reduced values
+      split_ties[a] = m_dim > 1 && weight_below[2*a] < target[a] && weight_below[2*a+1] > target[a];
+      if(!split_ties[a])
+      {
+        // Nothing to bisect: lo and hi are equal, so find_cuts returns at once
+        tie_lo[a] = tie_hi[a] = 0.;
+        continue;
+      }
+
+      const RCBBox& box = boxes[active[a]];
+      std::vector< std::pair<Real,Real> > tie_weights;
+      boost_foreach(const Uint elem, box.elements)
+      {
+        const Real x = m_centroids[elem*m_dim+cut_dim[a]];
+        if(x > lo[a] && x <= hi[a])
+          tie_weights.push_back(std::make_pair(m_centroids[elem*m_dim+tie_dim[a]], m_weights[elem]));
+      }
+      ties[a].build(tie_weights);
+      tie_lo[a] = box_min[a*m_dim+tie_dim[a]];
+      tie_hi[a] = box_max[a*m_dim+tie_dim[a]];
+    }
+    find_cuts(tie_sets, set_of_cut, tie_target, tie_lo, tie_hi);
+
+    // Split the boxes, the lower half stays in place
+    for(Uint a = 0; a != nb_active; ++a)
+    {
+      RCBBox& box = boxes[active[a]];
+      RCBBox upper;
+      const Uint nb_lower_parts = box.nb_parts/2;
+      upper.first_part = box.first_part + nb_lower_parts;
+      upper.nb_parts = box.nb_parts - nb_lower_parts;
+      std::vector<Uint> lower_elements;
+      boost_foreach(const Uint elem, box.elements)
+      {
+        const Real x = m_centroids[elem*m_dim+cut_dim[a]];
+        const bool lower = x <= lo[a] || (x <= hi[a] && (!split_ties[a] || m_centroids[elem*m_dim+tie_dim[a]] <= tie_hi[a]));
+        if(lower)
+          lower_elements.push_back(elem);
+        else
+          upper.elements.push_back(elem);
+      }
+      box.elements.swap(lower_elements);
+      box.nb_parts = nb_lower_parts;
+      boxes.push_back(upper);
+    }
+  }
+
+  parts.resize(nb_elems);
+  boost_foreach(const RCBBox& box, boxes)
+  {
+    boost_foreach(const Uint elem, box.elements)
+      parts[elem] = box.first_part;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
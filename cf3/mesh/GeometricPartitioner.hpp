@@ -0,0 +1,86 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_GeometricPartitioner_hpp
+#define cf3_mesh_GeometricPartitioner_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include "mesh/MeshPartitioner.hpp"
+
+namespace cf3 {
+namespace mesh {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Partitions the elements by the position of their centroid, without external libraries
+///
+/// Two methods are available through the option "method":
+/// - Hilbert: the centroids are ordered along a Hilbert space filling curve (see math::Hilbert),
+///   and the curve is cut in pieces of equal weight.
+/// - RCB: recursive coordinate bisection. The elements are split in two along the longest direction
+///   of their bounding box, with the weights on both sides proportional to the number of parts on
+///   that side, until every part has its own set of elements. Elements with their centroid on a cut
+///   are divided by a second cut along another direction, so heavy columns of elements do not spoil the balance.
+///
+/// The cuts are found by a parallel weighted selection: only the weight below trial cuts is
+/// reduced over the ranks, the elements themselves are only moved by migrate().
+/// Element weights follow the "object_weights" option of the MeshPartitioner.
+/// Geometric partitions are not as good as graph partitions for the communication volume, but
+/// they are cheap, so they are a good default and a good starting point for a graph partitioner.
+class Mesh_API GeometricPartitioner : public MeshPartitioner {
+
+public: // functions
+
+  /// Contructor
+  /// @param name of the component
+  GeometricPartitioner ( const std::string& name );
+
+  /// Virtual destructor
+  virtual ~GeometricPartitioner();
+
+  /// Get the class name
+  static std::string type_name () { return "GeometricPartitioner"; }
+
+  /// Partitioning functions
+
+  virtual void build_graph() { /* Does nothing, as only the element coordinates are needed */ }
+
+  virtual void partition_graph();
+
+private: // functions
+
+  /// Centroids and weights of all local elements, with the index of their entities and the local element index
+  void compute_centroids();
+
+  /// Assign a part to every element by cutting the Hilbert curve through the centroids
+  void partition_hilbert(std::vector<Uint>& parts) const;
+
+  /// Assign a part to every element by recursive coordinate bisection of the centroids
+  void partition_rcb(std::vector<Uint>& parts) const;
+
+private: // data
+
+  /// Centroid of each local element, dimension entries per element
+  std::vector<Real> m_centroids;
+
+  /// Weight of each local element
+  std::vector<Real> m_weights;
+
+  /// Entities index and local index of each local element
+  std::vector< std::pair<Uint,Uint> > m_element_location;
+
+  Uint m_dim;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_GeometricPartitioner_hpp
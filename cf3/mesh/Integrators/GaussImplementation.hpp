@@ -463,7 +463,7 @@ struct GaussMappedCoordsImpl<2, GeoShape::PRISM>
   static CoordsT coords()
   {
     CoordsT result;
-    result.resize(DIM_2D, nb_points);
+    result.resize(DIM_3D, nb_points);
     result(KSI,0) = 0.5;
     result(ETA,0) = 0.0;
     result(ZTA,0) = GaussPoints<2>::x()[0];
@@ -27,7 +27,7 @@ void Line::compute_value(const MappedCoordsT& mapped_coord, ValueT& result)
 
   result[0] = -onesixteenth*(1.0 - mapped_coord[KSI])*(1.0 - 9.0*mapped_coord[KSI]*mapped_coord[KSI]);
   result[1] = -onesixteenth*(1.0 + mapped_coord[KSI])*(1.0 - 9.0*mapped_coord[KSI]*mapped_coord[KSI]);
-  result[2] = -9.0*onesixteenth*(1.0 - mapped_coord[KSI]*mapped_coord[KSI])*(1.0 - 3.0*mapped_coord[KSI]);
+  result[2] =  9.0*onesixteenth*(1.0 - mapped_coord[KSI]*mapped_coord[KSI])*(1.0 - 3.0*mapped_coord[KSI]);
   result[3] =  9.0*onesixteenth*(1.0 - mapped_coord[KSI]*mapped_coord[KSI])*(1.0 + 3.0*mapped_coord[KSI]);
 }
 
@@ -194,6 +194,15 @@ void MeshAdaptor::prepare()
 //  std::cout << PERank << "preparing mesh_adaptor" << std::endl;
 //  make_element_node_connectivity_global();
 //  std::cout << PERank << "  - node_connectivity_global" << std::endl;
+
+  // Node values are moved through the Table<Real> buffers, so single precision fields are expanded until finish()
+  m_double_precision.reset(new DoublePrecisionScope(true));
+  boost_foreach(const Handle<Dictionary>& dict, m_mesh->dictionaries())
+  {
+    if (is_not_null(dict))
+      m_double_precision->add(*dict);
+  }
+
   create_element_buffers();
 //  std::cout << PERank << "  - create_element_buffers" << std::endl;
   create_node_buffers();
@@ -215,6 +224,8 @@ void MeshAdaptor::finish()
   // Change following flags as "raise_mesh_changed" took care of this
   node_glb_to_loc_needs_rebuild=false;
   node_elem_connectivity_needs_rebuild=false;
+
+  m_double_precision.reset();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -546,6 +557,62 @@ void MeshAdaptor::remove_ghost_nodes()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void MeshAdaptor::remove_unused_nodes()
+{
+  cf3_assert(is_node_connectivity_global);
+
+  for (Uint dict_idx=0; dict_idx<m_mesh->dictionaries().size(); ++dict_idx)
+  {
+    //std::cout << PERank << "removing unused nodes " << std::endl;
+
+    Dictionary& dict = *m_mesh->dictionaries()[dict_idx];
+
+    // Assemble set of used nodes, that will be checked for later
+    std::set<boost::uint64_t> used_nodes;
+
+    // check in dict.entities_range(), in case perhaps other meshes use the same dictionary (future?)
+    cf3_assert(dict.entities_range().size() != 0);
+    boost_foreach (const Handle<Entities>& entities, dict.entities_range())
+    {
+      //std::cout << entities->uri() << std::endl;
+      Space& space = entities->space(dict);
+      for (Uint elem=0; elem<space.size(); ++elem)
+      {
+        // Element-node connectivity tables must be GLOBAL
+        boost_foreach( Uint glb_node, space.connectivity()[elem] )
+        {
+          used_nodes.insert(glb_node);
+        }
+      }
+    }
+
+    // Remove unused nodes
+    for (Uint node_idx=0; node_idx<dict.size(); ++node_idx)
+    {
+      if ( used_nodes.count(dict.glb_idx()[node_idx]) == 0 )
+      {
+        remove_node(dict_idx,node_idx);
+      }
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MeshAdaptor::remove_overlap()
+{
+  // Removing nodes changes the local node indices, so elements refer to their nodes by global index
+  make_element_node_connectivity_global();
+
+  remove_ghost_elements();
+  flush_elements();
+
+  remove_unused_nodes();
+  flush_nodes();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void MeshAdaptor::find_nodes_to_export(const std::vector< std::vector< std::vector<Uint> > >& exported_elements_loc_id,
                                        std::vector< std::vector< std::vector<Uint> > >& exported_nodes_loc_id)
 {
@@ -935,41 +1002,7 @@ void MeshAdaptor::move_elements(const std::vector< std::vector< std::vector<Uint
 
   // 6) Remove unused nodes
   ////PECheckArrivePoint(100,"removing unused nodes");
-
-  for (Uint dict_idx=0; dict_idx<nb_dicts; ++dict_idx)
-  {
-    //std::cout << PERank << "removing unused nodes " << std::endl;
-
-    Dictionary& dict = *m_mesh->dictionaries()[dict_idx];
-
-    // Assemble set of used nodes, that will be checked for later
-    std::set<boost::uint64_t> used_nodes;
-
-    // check in dict.entities_range(), in case perhaps other meshes use the same dictionary (future?)
-    cf3_assert(dict.entities_range().size() != 0);
-    boost_foreach (const Handle<Entities>& entities, dict.entities_range())
-    {
-      //std::cout << entities->uri() << std::endl;
-      Space& space = entities->space(dict);
-      for (Uint elem=0; elem<space.size(); ++elem)
-      {
-        // Element-node connectivity tables must be GLOBAL
-        boost_foreach( Uint glb_node, space.connectivity()[elem] )
-        {
-          used_nodes.insert(glb_node);
-        }
-      }
-    }
-
-    // Remove unused nodes
-    for (Uint node_idx=0; node_idx<dict.size(); ++node_idx)
-    {
-      if ( used_nodes.count(dict.glb_idx()[node_idx]) == 0 )
-      {
-        remove_node(dict_idx,node_idx);
-      }
-    }
-  }
+  remove_unused_nodes();
 
   // 7) Flush nodes and rebuild glb_to_loc map
 //  CFdebug << "Flush nodes and rebuild glb_to_loc map" << CFendl;
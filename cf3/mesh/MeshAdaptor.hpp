@@ -11,6 +11,7 @@
 
 #include <set>
 #include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include "common/PE/Buffer.hpp"
 
@@ -22,6 +23,7 @@ namespace cf3 {
 namespace mesh {
 
   class Dictionary;
+  class DoublePrecisionScope;
   class Entities;
   class Mesh;
   class MeshAdaptor;
@@ -163,6 +165,12 @@ public:
   ///       Call finish() to notify the mesh of updates.
   void grow_overlap();
 
+  /// @brief Remove the overlap created by grow_overlap(): the ghost elements and the nodes only they use
+  ///
+  /// The nodes on the partition boundaries keep their rank, as after move_elements()
+  /// @post nodes and elements are flushed. Call finish() to notify the mesh of updates.
+  void remove_overlap();
+
   /// @brief Add another mesh to this mesh
   void combine_mesh(const Mesh& other_mesh);
 
@@ -180,6 +188,11 @@ public:
   void find_nodes_to_export(const std::vector< std::vector< std::vector<Uint> > >& exported_elements_loc_id,
                             std::vector< std::vector< std::vector<Uint> > >&       exported_nodes_loc_id);
 
+  /// @brief Remove the nodes that are not used by any element
+  /// @pre Element-node connectivity is global, and elements are flushed
+  /// @post Nodes are not flushed yet, so additional operations can be performed
+  void remove_unused_nodes();
+
   /// @brief Send/Receive elements according to an elements-changeset
   /// @param [in]  exported_elements_loc_id  A set with 3 indices: send_element[to_pid][from_entities_idx][local_elem_idx]
   /// @param [out] imported_elements_glb_id  A set with 3 indices: received_element[from_pid][from_entities_idx][glb_elem_idx]
@@ -262,6 +275,9 @@ private:
 
   bool has_node_buffers;
 
+  /// @brief keeps the fields that were stored in single precision in double precision from prepare() to finish()
+  boost::scoped_ptr<DoublePrecisionScope> m_double_precision;
+
 #if 0
   void fix_node_ranks(const std::vector< std::vector<boost::uint64_t> >& nodes);
 #endif
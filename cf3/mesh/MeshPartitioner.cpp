@@ -23,6 +23,8 @@
 #include "common/XML/Protocol.hpp"
 #include "common/XML/SignalOptions.hpp"
 
+#include "mesh/ElementCost.hpp"
+#include "mesh/ElementType.hpp"
 #include "mesh/Mesh.hpp"
 #include "mesh/MeshPartitioner.hpp"
 #include "mesh/Dictionary.hpp"
@@ -51,6 +53,24 @@ MeshPartitioner::MeshPartitioner ( const std::string& name ) :
       .link_to(&m_nb_parts)
       .mark_basic();
 
+  options().add("object_weights", std::string("None"))
+      .description("Weights of the elements in the partitioning graph. None: all elements and nodes have the same weight. "
+                   "ElementType: weights given per element type in element_type_weights. "
+                   "Measured: the element cost measured in the element loops, falling back to ElementType if nothing was measured.")
+      .pretty_name("Object Weights");
+  options().option("object_weights").restricted_list().push_back(std::string("None"));
+  options().option("object_weights").restricted_list().push_back(std::string("ElementType"));
+  options().option("object_weights").restricted_list().push_back(std::string("Measured"));
+
+  options().add("element_type_weights", std::vector<std::string>())
+      .description("Weights per element type, as type=weight, where type is the end of the element type name, "
+                   "e.g. LagrangeP2.Hexa3D=8 or Prism3D=2. Unlisted types have weight 1.")
+      .pretty_name("Element Type Weights");
+
+  options().add("node_weight", 1.)
+      .description("Weight of the nodes in the partitioning graph, if object_weights is not None")
+      .pretty_name("Node Weight");
+
   m_global_to_local = create_static_component<common::Map<Uint,Uint> >("global_to_local");
   m_lookup = create_static_component<UnifiedData >("lookup");
 
@@ -184,10 +204,12 @@ void MeshPartitioner::initialize(Mesh& mesh)
     start_id += nb_obj_per_proc[p];
   }
 
-  m_nodes_to_export.resize(m_nb_parts);
-  m_elements_to_export.resize(m_nb_parts,std::vector< std::vector<Uint> >(mesh.elements().size()));
+  // Start from scratch, so the partitioner can be executed again on a changed mesh
+  m_nodes_to_export.assign(m_nb_parts, std::vector<Uint>());
+  m_elements_to_export.assign(m_nb_parts,std::vector< std::vector<Uint> >(mesh.elements().size()));
 
   build_global_to_local_index(mesh);
+  compute_object_weights();
   build_graph();
 
 //  mesh.update_statistics();
@@ -205,6 +227,8 @@ void MeshPartitioner::build_global_to_local_index(Mesh& mesh)
 {
   Dictionary& nodes = mesh.geometry_fields();
 
+  m_lookup->reset();
+  m_global_to_local->clear();
   m_lookup->add(nodes);
   boost_foreach ( const Handle<Entities>& elements, mesh.elements() )
     m_lookup->add(*elements);
@@ -270,6 +294,82 @@ void MeshPartitioner::build_global_to_local_index(Mesh& mesh)
 
 //////////////////////////////////////////////////////////////////////////////
 
+void MeshPartitioner::compute_object_weights()
+{
+  m_object_weights.clear();
+  const std::string weights_type = options().value<std::string>("object_weights");
+  if(weights_type == "None")
+    return;
+
+  const Uint nb_objects = m_lookup->size();
+  m_object_weights.assign(nb_objects, options().value<Real>("node_weight"));
+
+  // Weight per element type
+  const std::vector<std::string> type_weights = options().value< std::vector<std::string> >("element_type_weights");
+  std::vector<Real> entities_weight(m_lookup->components().size(), 1.);
+  for(Uint comp = 1; comp < m_lookup->components().size(); ++comp)
+  {
+    Handle<Entities const> entities(m_lookup->components()[comp]);
+    cf3_assert(is_not_null(entities));
+    const std::string type_name = entities->element_type().derived_type_name();
+    boost_foreach(const std::string& type_weight, type_weights)
+    {
+      const std::size_t separator = type_weight.find('=');
+      if(separator == std::string::npos)
+        throw BadValue(FromHere(), "Element type weight " + type_weight + " is not of the form type=weight");
+      const std::string type = type_weight.substr(0, separator);
+      if(type_name.size() >= type.size() && type_name.compare(type_name.size() - type.size(), type.size(), type) == 0)
+        entities_weight[comp] = from_str<Real>(type_weight.substr(separator+1));
+    }
+  }
+
+  // Measured cost, normalized with the average over all elements
+  bool use_measured = false;
+  Real cost_scale = 0.;
+  if(weights_type == "Measured")
+  {
+    Real local_cost[2] = {0., 0.}; // total cost, number of elements
+    for(Uint comp = 1; comp < m_lookup->components().size(); ++comp)
+    {
+      Handle<Entities const> entities(m_lookup->components()[comp]);
+      Handle< common::List<Real> > cost = element_cost(*entities);
+      if(is_null(cost))
+        continue;
+      for(Uint i = 0; i != cost->size(); ++i)
+        local_cost[0] += (*cost)[i];
+      local_cost[1] += static_cast<Real>(cost->size());
+    }
+    Real global_cost[2] = {local_cost[0], local_cost[1]};
+    if(PE::Comm::instance().is_active())
+      PE::Comm::instance().all_reduce(PE::plus(), local_cost, 2, global_cost);
+
+    use_measured = global_cost[0] > 0.;
+    if(use_measured)
+      cost_scale = global_cost[1] / global_cost[0];
+    else
+      CFwarn << "No element cost was measured, using the element type weights for partitioning" << CFendl;
+  }
+
+  for(Uint loc_obj = 0; loc_obj != nb_objects; ++loc_obj)
+  {
+    const boost::tuple<Uint,Uint> location = m_lookup->location_idx(loc_obj);
+    const Uint comp = location.get<0>();
+    if(comp == 0)
+      continue;
+
+    Real weight = entities_weight[comp];
+    if(use_measured)
+    {
+      Handle< common::List<Real> > cost = element_cost(*Handle<Entities const>(m_lookup->components()[comp]));
+      if(is_not_null(cost))
+        weight = cost_scale * (*cost)[location.get<1>()];
+    }
+    m_object_weights[loc_obj] = weight;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void MeshPartitioner::show_changes()
 {
   Uint nb_changes(0);
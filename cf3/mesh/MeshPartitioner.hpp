@@ -40,6 +40,11 @@ namespace mesh {
 
 /// MeshPartitioner component class
 /// This class serves as a component that that will partition the mesh
+///
+/// By default every node and element of the graph has the same weight. The option "object_weights"
+/// selects per-element weights instead: either configured per element type ("element_type_weights"),
+/// or taken from the element cost measured in the element loops (see ElementCost.hpp), normalized
+/// so that the average element has weight 1.
 /// @author Willem Deconinck
 class Mesh_API MeshPartitioner : public MeshTransformer {
 
@@ -92,6 +97,13 @@ public: // functions
   template <typename VectorT>
   void list_of_objects_owned_by_part(const Uint part, VectorT& obj_list) const;
 
+  /// True if the objects have different weights, as configured by the "object_weights" option
+  bool has_object_weights() const { return !m_object_weights.empty(); }
+
+  /// Weights of the objects, in the same order as list_of_objects_owned_by_part()
+  template <typename VectorT>
+  void list_of_object_weights_in_part(const Uint part, VectorT& weights) const;
+
   template <typename VectorT>
   Uint nb_connected_objects_in_part(const Uint part, VectorT& nb_connections_per_obj) const;
 
@@ -139,6 +151,15 @@ protected: // functions
   
   Uint periodic_target_node(Uint node) const;
 
+  /// Fill m_object_weights according to the "object_weights" option
+  void compute_object_weights();
+
+  /// Weight of a local element, 1 if the objects have no weights
+  Real element_weight(const Entities& entities, const Uint elem) const
+  {
+    return has_object_weights() ? m_object_weights[m_lookup->unified_idx(entities, elem)] : 1.;
+  }
+
 protected: // data
 
   /// nodes_to_export[part][loc_node_idx]
@@ -169,6 +190,9 @@ private: // data
 
   std::vector< std::pair<bool, Uint > > m_periodic_links;
   std::vector< std::vector<Uint> > m_inverse_periodic_links;
+
+  /// Weight of each object, indexed as in m_lookup. Empty if all weights are equal
+  std::vector<Real> m_object_weights;
 };
 
 //////////////////////////////////////////////////////////////////////////////
@@ -196,6 +220,23 @@ void MeshPartitioner::list_of_objects_owned_by_part(const Uint part, VectorT& ob
 
 //////////////////////////////////////////////////////////////////////////////
 
+template <typename VectorT>
+void MeshPartitioner::list_of_object_weights_in_part(const Uint part, VectorT& weights) const
+{
+  cf3_assert(has_object_weights());
+  Uint idx=0;
+  foreach_container((const Uint glb_obj)(const Uint loc_obj),*m_global_to_local)
+  {
+    if (part_of_obj(glb_obj) == part)
+    {
+      if(!(glb_obj < m_end_node_per_part[part] && m_periodic_links[m_lookup->location(loc_obj).get<1>()].first))
+        weights[idx++] = m_object_weights[loc_obj];
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 template <typename VectorT>
 Uint MeshPartitioner::nb_connected_objects_in_part(const Uint part, VectorT& nb_connections_per_obj) const
 {
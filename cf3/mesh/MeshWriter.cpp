@@ -167,6 +167,11 @@ void MeshWriter::execute()
     boost_foreach(const Entities& entities, find_components_recursively_with_filter<Entities>(*region,m_entities_filter))
       m_filtered_entities.push_back(entities.handle<Entities>());
 
+  // Writers read the values through the Table<Real> interface, so single precision fields are expanded while writing
+  DoublePrecisionScope double_precision(false);
+  boost_foreach(const Handle<Field const>& field, m_fields)
+    double_precision.add(const_cast<Field&>(*field));
+
   // Call implementation
   write();
 }
@@ -119,7 +119,8 @@ void Octtree::create_octtree()
   }
   CFdebug << "V = " << V << CFendl;
 
-  // initialize the octtree
+  // initialize the octtree, dropping the elements of a previous mesh
+  m_octtree.resize(boost::extents[0][0][0]);
   m_octtree.resize(boost::extents[std::max(Uint(1),m_N[XX])][std::max(Uint(1),m_N[YY])][std::max(Uint(1),m_N[ZZ])]);
 
   RealVector centroid(m_dim);
@@ -0,0 +1,1126 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+#include "common/Assertions.hpp"
+#include "common/BasicExceptions.hpp"
+#include "common/Builder.hpp"
+#include "common/DynTable.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Foreach.hpp"
+#include "common/List.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+#include "common/StringConversion.hpp"
+
+#include "common/PE/Comm.hpp"
+#include "common/PE/operations.hpp"
+
+#include "mesh/actions/AdaptiveRefinement.hpp"
+#include "mesh/actions/LoadBalance.hpp"
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/ElementType.hpp"
+#include "mesh/Entities.hpp"
+#include "mesh/FaceCellConnectivity.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/ShapeFunction.hpp"
+#include "mesh/Space.hpp"
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+namespace actions {
+
+using namespace common;
+using namespace common::PE;
+
+////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < AdaptiveRefinement, MeshTransformer, mesh::actions::LibActions> AdaptiveRefinement_Builder;
+
+//////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/// An edge, as the global indices of its nodes, smallest first
+typedef std::pair<Uint, Uint> EdgeT;
+
+inline EdgeT make_edge(const Uint a, const Uint b)
+{
+  return a < b ? EdgeT(a, b) : EdgeT(b, a);
+}
+
+inline Uint bit(const Uint i)
+{
+  return 1u << i;
+}
+
+/// Local edges of the P1 shapes that can be split. The edge patterns used below are bit masks over these tables.
+const Uint line_edges[1][2] = { {0,1} };
+const Uint triag_edges[3][2] = { {0,1}, {1,2}, {2,0} };
+const Uint quad_edges[4][2] = { {0,1}, {1,2}, {2,3}, {3,0} };
+const Uint tetra_edges[6][2] = { {0,1}, {1,2}, {2,0}, {0,3}, {1,3}, {2,3} };
+/// Grouped per direction of the reference element: 4 edges along xi, 4 along eta and 4 along zeta
+const Uint hexa_edges[12][2] = { {0,1}, {3,2}, {4,5}, {7,6}, {0,3}, {1,2}, {4,7}, {5,6}, {0,4}, {1,5}, {2,6}, {3,7} };
+
+/// Edge patterns of the faces of a tetrahedron, for the faces opposite nodes 0, 1, 2 and 3
+const Uint tetra_face_patterns[4] = { 50, 44, 25, 7 };
+
+struct EdgeTable
+{
+  EdgeTable() : edges(0), nb_edges(0) {}
+  EdgeTable(const Uint (*e)[2], const Uint n) : edges(e), nb_edges(n) {}
+  const Uint (*edges)[2];
+  Uint nb_edges;
+};
+
+/// Edges of the given element type, or an empty table if the element type can't be split
+EdgeTable edge_table(const ElementType& etype)
+{
+  if(etype.order() != 1)
+    return EdgeTable();
+
+  switch(etype.shape())
+  {
+    case GeoShape::LINE:  return EdgeTable(line_edges, 1);
+    case GeoShape::TRIAG: return EdgeTable(triag_edges, 3);
+    case GeoShape::QUAD:  return EdgeTable(quad_edges, 4);
+    case GeoShape::TETRA: return EdgeTable(tetra_edges, 6);
+    case GeoShape::HEXA:  return EdgeTable(hexa_edges, 12);
+    default:              return EdgeTable();
+  }
+}
+
+/// Pattern of the marked edges of an element
+Uint edge_pattern(const std::set<EdgeT>& marked, const EdgeTable& table, const Connectivity::ConstRow& nodes, const common::List<Uint>& glb_idx)
+{
+  Uint pattern = 0;
+  for(Uint i = 0; i != table.nb_edges; ++i)
+  {
+    if(marked.count(make_edge(glb_idx[nodes[table.edges[i][0]]], glb_idx[nodes[table.edges[i][1]]])))
+      pattern |= bit(i);
+  }
+  return pattern;
+}
+
+/// True if any pair of nodes of an element that can't be split is a marked edge
+bool has_marked_edge(const std::set<EdgeT>& marked, const Connectivity::ConstRow& nodes, const common::List<Uint>& glb_idx)
+{
+  const Uint nb_nodes = nodes.size();
+  for(Uint i = 0; i != nb_nodes; ++i)
+    for(Uint j = i+1; j != nb_nodes; ++j)
+      if(marked.count(make_edge(glb_idx[nodes[i]], glb_idx[nodes[j]])))
+        return true;
+  return false;
+}
+
+/// Complete a pattern of marked edges so the element can be split without hanging nodes
+Uint close_pattern(const GeoShape::Type shape, const Uint pattern)
+{
+  const bool single = (pattern & (pattern-1)) == 0;
+  switch(shape)
+  {
+    case GeoShape::TRIAG:
+      return single ? pattern : 7;
+    case GeoShape::TETRA:
+    {
+      if(single)
+        return pattern;
+      for(Uint f = 0; f != 4; ++f)
+      {
+        if((pattern & ~tetra_face_patterns[f]) == 0)
+          return tetra_face_patterns[f];
+      }
+      return 63;
+    }
+    case GeoShape::HEXA:
+    {
+      Uint result = 0;
+      for(Uint d = 0; d != 3; ++d)
+      {
+        if(pattern & (0xFu << 4*d))
+          result |= 0xFu << 4*d;
+      }
+      return result;
+    }
+    default:
+      return pattern;
+  }
+}
+
+/// True if a quadrilateral with the given pattern is split by bisection. Other patterns need a fan of triangles.
+inline bool is_tensor_pattern(const Uint pattern)
+{
+  return pattern == 0 || pattern == 5 || pattern == 10 || pattern == 15;
+}
+
+/// Children of an element. Each child node is the bit mask of the parent nodes it is the centre of.
+struct Children
+{
+  Children() : fan(false) {}
+
+  /// True if the children are triangles in a quadrilateral
+  bool fan;
+  std::vector< std::vector<Uint> > nodes;
+};
+
+/// Mapped coordinates of the centre of the parent nodes given by mask
+RealVector mask_coordinates(const RealMatrix& local_coords, const Uint mask)
+{
+  RealVector result(local_coords.cols());
+  result.setZero();
+  Uint count = 0;
+  for(Uint n = 0; n != local_coords.rows(); ++n)
+  {
+    if(mask & bit(n))
+    {
+      result += local_coords.row(n).transpose();
+      ++count;
+    }
+  }
+  return result / static_cast<Real>(count);
+}
+
+/// Bisect a quadrilateral or hexahedron in each direction d for which split[d] is true
+void tensor_children(const RealMatrix& local_coords, const bool* split, Children& result)
+{
+  const Uint nb_nodes = local_coords.rows();
+  const Uint dim = local_coords.cols();
+
+  Uint nb_children = 1;
+  for(Uint d = 0; d != dim; ++d)
+    if(split[d])
+      nb_children *= 2;
+
+  for(Uint c = 0; c != nb_children; ++c)
+  {
+    // Half of the parent occupied by the child in each split direction: 0 for the lower half, 1 for the upper half
+    Uint half[3] = {0, 0, 0};
+    Uint rest = c;
+    for(Uint d = 0; d != dim; ++d)
+    {
+      if(split[d])
+      {
+        half[d] = rest % 2;
+        rest /= 2;
+      }
+    }
+
+    std::vector<Uint> child(nb_nodes);
+    for(Uint k = 0; k != nb_nodes; ++k)
+    {
+      // Mapped coordinates of the child node, each -1, 0 or 1
+      int target[3] = {0, 0, 0};
+      for(Uint d = 0; d != dim; ++d)
+      {
+        const int corner = local_coords(k, d) > 0. ? 1 : -1;
+        if(!split[d])
+          target[d] = corner;
+        else if(half[d] == 0)
+          target[d] = corner < 0 ? -1 : 0;
+        else
+          target[d] = corner < 0 ? 0 : 1;
+      }
+
+      // The node is the centre of the parent nodes that match the non-zero coordinates
+      Uint mask = 0;
+      for(Uint n = 0; n != nb_nodes; ++n)
+      {
+        bool match = true;
+        for(Uint d = 0; d != dim; ++d)
+        {
+          if(target[d] != 0 && (local_coords(n, d) > 0. ? 1 : -1) != target[d])
+            match = false;
+        }
+        if(match)
+          mask |= bit(n);
+      }
+      child[k] = mask;
+    }
+    result.nodes.push_back(child);
+  }
+}
+
+/// Swap the first two nodes of a child tetrahedron if its orientation differs from the parent
+void orient_tetra(const RealMatrix& local_coords, std::vector<Uint>& child)
+{
+  const RealVector origin = mask_coordinates(local_coords, child[0]);
+  RealMatrix jacobian(3, 3);
+  for(Uint i = 0; i != 3; ++i)
+    jacobian.col(i) = mask_coordinates(local_coords, child[i+1]) - origin;
+  if(jacobian.determinant() < 0.)
+    std::swap(child[0], child[1]);
+}
+
+/// Compute the children of an element, given the closed pattern of its marked edges.
+/// @param nodes Coordinates of the element nodes, used to choose the diagonal of the octahedron in a tetrahedron
+void split_element(const ElementType& etype, const Uint pattern, const bool allow_fan, const RealMatrix& nodes, Children& result)
+{
+  const RealMatrix& local_coords = etype.shape_function().local_coordinates();
+  const EdgeTable table = edge_table(etype);
+
+  switch(etype.shape())
+  {
+    case GeoShape::LINE:
+    {
+      std::vector<Uint> child(2);
+      child[0] = bit(0); child[1] = bit(0) | bit(1);
+      result.nodes.push_back(child);
+      child[0] = bit(0) | bit(1); child[1] = bit(1);
+      result.nodes.push_back(child);
+      return;
+    }
+    case GeoShape::TRIAG:
+    {
+      const Uint m01 = bit(0) | bit(1), m12 = bit(1) | bit(2), m20 = bit(2) | bit(0);
+      std::vector<Uint> child(3);
+      if(pattern == 7)
+      {
+        child[0] = bit(0); child[1] = m01; child[2] = m20; result.nodes.push_back(child);
+        child[0] = m01; child[1] = bit(1); child[2] = m12; result.nodes.push_back(child);
+        child[0] = m20; child[1] = m12; child[2] = bit(2); result.nodes.push_back(child);
+        child[0] = m01; child[1] = m12; child[2] = m20; result.nodes.push_back(child);
+        return;
+      }
+      for(Uint k = 0; k != 3; ++k)
+      {
+        if(pattern != bit(k))
+          continue;
+        const Uint i = table.edges[k][0], j = table.edges[k][1], l = 3 - i - j;
+        child[0] = bit(i); child[1] = bit(i) | bit(j); child[2] = bit(l); result.nodes.push_back(child);
+        child[0] = bit(i) | bit(j); child[1] = bit(j); child[2] = bit(l); result.nodes.push_back(child);
+      }
+      return;
+    }
+    case GeoShape::QUAD:
+    {
+      if(is_tensor_pattern(pattern))
+      {
+        const bool split[2] = { (pattern & 5) != 0, (pattern & 10) != 0 };
+        tensor_children(local_coords, split, result);
+        return;
+      }
+      if(!allow_fan)
+        throw NotSupported(FromHere(), "Quadrilateral faces can only be split in 2 or 4, got edge pattern " + to_str(pattern));
+
+      // Fan of triangles around the centre, with the marked edges split
+      result.fan = true;
+      const Uint centre = 15;
+      std::vector<Uint> child(3);
+      child[2] = centre;
+      for(Uint k = 0; k != 4; ++k)
+      {
+        const Uint i = table.edges[k][0], j = table.edges[k][1];
+        if(pattern & bit(k))
+        {
+          child[0] = bit(i); child[1] = bit(i) | bit(j); result.nodes.push_back(child);
+          child[0] = bit(i) | bit(j); child[1] = bit(j); result.nodes.push_back(child);
+        }
+        else
+        {
+          child[0] = bit(i); child[1] = bit(j); result.nodes.push_back(child);
+        }
+      }
+      return;
+    }
+    case GeoShape::TETRA:
+    {
+      std::vector<Uint> child(4);
+      if((pattern & (pattern-1)) == 0)
+      {
+        // Bisection of a single edge
+        for(Uint k = 0; k != 6; ++k)
+        {
+          if(pattern != bit(k))
+            continue;
+          const Uint i = table.edges[k][0], j = table.edges[k][1];
+          for(Uint n = 0; n != 4; ++n)
+            child[n] = bit(n);
+          child[j] = bit(i) | bit(j);
+          result.nodes.push_back(child);
+          child[j] = bit(j);
+          child[i] = bit(i) | bit(j);
+          result.nodes.push_back(child);
+        }
+        return;
+      }
+
+      for(Uint f = 0; f != 4; ++f)
+      {
+        if(pattern != tetra_face_patterns[f])
+          continue;
+        // Split of one face in 4 triangles, each connected to the opposite node
+        Uint face[3];
+        Uint nb_face_nodes = 0;
+        for(Uint n = 0; n != 4; ++n)
+          if(n != f)
+            face[nb_face_nodes++] = bit(n);
+        const Uint m01 = face[0] | face[1], m12 = face[1] | face[2], m20 = face[2] | face[0];
+        const Uint triangles[4][3] = { {face[0], m01, m20}, {m01, face[1], m12}, {m20, m12, face[2]}, {m01, m12, m20} };
+        for(Uint t = 0; t != 4; ++t)
+        {
+          child[0] = triangles[t][0]; child[1] = triangles[t][1]; child[2] = triangles[t][2]; child[3] = bit(f);
+          orient_tetra(local_coords, child);
+          result.nodes.push_back(child);
+        }
+        return;
+      }
+
+      // Red refinement: 4 corner tetrahedra and an octahedron, split along its shortest diagonal
+      for(Uint v = 0; v != 4; ++v)
+      {
+        child[0] = bit(v);
+        Uint nb_child_nodes = 1;
+        for(Uint w = 0; w != 4; ++w)
+          if(w != v)
+            child[nb_child_nodes++] = bit(v) | bit(w);
+        orient_tetra(local_coords, child);
+        result.nodes.push_back(child);
+      }
+
+      // Pairs of opposite edges
+      const Uint opposite[3][2] = { {0, 5}, {1, 3}, {2, 4} };
+      Uint diagonal = 0;
+      Real shortest = 0.;
+      for(Uint p = 0; p != 3; ++p)
+      {
+        const RealVector a = 0.5*(nodes.row(table.edges[opposite[p][0]][0]) + nodes.row(table.edges[opposite[p][0]][1])).transpose();
+        const RealVector b = 0.5*(nodes.row(table.edges[opposite[p][1]][0]) + nodes.row(table.edges[opposite[p][1]][1])).transpose();
+        const Real length = (b - a).squaredNorm();
+        if(p == 0 || length < shortest)
+        {
+          shortest = length;
+          diagonal = p;
+        }
+      }
+
+      // The midpoints of the other 4 edges form a ring around the diagonal, in which consecutive edges share a node
+      std::vector<Uint> ring;
+      std::vector<bool> used(6, false);
+      used[opposite[diagonal][0]] = true;
+      used[opposite[diagonal][1]] = true;
+      for(Uint k = 0; k != 6 && ring.empty(); ++k)
+        if(!used[k])
+        {
+          ring.push_back(k);
+          used[k] = true;
+        }
+      while(ring.size() != 4)
+      {
+        const Uint last = ring.back();
+        for(Uint k = 0; k != 6; ++k)
+        {
+          if(used[k])
+            continue;
+          const bool shares_node = table.edges[k][0] == table.edges[last][0] || table.edges[k][0] == table.edges[last][1]
+                                || table.edges[k][1] == table.edges[last][0] || table.edges[k][1] == table.edges[last][1];
+          if(shares_node)
+          {
+            ring.push_back(k);
+            used[k] = true;
+            break;
+          }
+        }
+      }
+
+      const Uint d0 = bit(table.edges[opposite[diagonal][0]][0]) | bit(table.edges[opposite[diagonal][0]][1]);
+      const Uint d1 = bit(table.edges[opposite[diagonal][1]][0]) | bit(table.edges[opposite[diagonal][1]][1]);
+      for(Uint r = 0; r != 4; ++r)
+      {
+        const Uint e0 = ring[r], e1 = ring[(r+1)%4];
+        child[0] = d0;
+        child[1] = d1;
+        child[2] = bit(table.edges[e0][0]) | bit(table.edges[e0][1]);
+        child[3] = bit(table.edges[e1][0]) | bit(table.edges[e1][1]);
+        orient_tetra(local_coords, child);
+        result.nodes.push_back(child);
+      }
+      return;
+    }
+    case GeoShape::HEXA:
+    {
+      const bool split[3] = { (pattern & 0xF) != 0, (pattern & 0xF0) != 0, (pattern & 0xF00) != 0 };
+      tensor_children(local_coords, split, result);
+      return;
+    }
+    default:
+      throw NotSupported(FromHere(), "Can't split elements of type " + etype.derived_type_name());
+  }
+}
+
+/// Nodes of the refined mesh, each identified by the global indices of the old nodes it is the centre of
+class NewNodes
+{
+public:
+  NewNodes(const common::List<Uint>& glb_idx) : m_glb_idx(glb_idx) {}
+
+  /// Index of the node at the centre of the given old nodes, which are sorted on global index
+  Uint add(std::vector<Uint>& old_nodes)
+  {
+    std::sort(old_nodes.begin(), old_nodes.end(), GlobalLess(m_glb_idx));
+    std::vector<Uint> key(old_nodes.size());
+    for(Uint i = 0; i != old_nodes.size(); ++i)
+      key[i] = m_glb_idx[old_nodes[i]];
+    std::pair<std::map<std::vector<Uint>, Uint>::iterator, bool> inserted = m_nodes.insert(std::make_pair(key, m_sources.size()));
+    if(inserted.second)
+      m_sources.push_back(old_nodes);
+    return inserted.first->second;
+  }
+
+  Uint size() const { return m_sources.size(); }
+
+  /// Old nodes for each new node, sorted on global index
+  const std::vector< std::vector<Uint> >& sources() const { return m_sources; }
+
+private:
+  struct GlobalLess
+  {
+    GlobalLess(const common::List<Uint>& glb_idx) : m_glb_idx(glb_idx) {}
+    bool operator()(const Uint a, const Uint b) const { return m_glb_idx[a] < m_glb_idx[b]; }
+    const common::List<Uint>& m_glb_idx;
+  };
+
+  const common::List<Uint>& m_glb_idx;
+  std::map<std::vector<Uint>, Uint> m_nodes;
+  std::vector< std::vector<Uint> > m_sources;
+};
+
+/// Elements to write in one Entities after the refinement
+struct Bucket
+{
+  Bucket() : nb_nodes(0) {}
+
+  Handle<Entities> target;
+  Uint nb_nodes;
+  /// Nodes of each child, as new node indices
+  std::vector<Uint> connectivity;
+  /// Parent of each child, as index in the original list of entities and element index
+  std::vector<Uint> parent_entities;
+  std::vector<Uint> parent_element;
+  /// Child nodes as masks of the parent nodes, empty for elements that are copied unchanged
+  std::vector< std::vector<Uint> > masks;
+
+  Uint size() const { return parent_element.size(); }
+};
+
+/// True if the rows of the connectivity contain all the given nodes
+bool contains_all(const Connectivity::ConstRow& row, const std::vector<Uint>& nodes)
+{
+  boost_foreach(const Uint node, nodes)
+  {
+    if(std::find(row.begin(), row.end(), node) == row.end())
+      return false;
+  }
+  return true;
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+AdaptiveRefinement::AdaptiveRefinement( const std::string& name ) :
+  MeshTransformer(name)
+{
+  properties()["brief"] = std::string("Refine the elements where an error indicator is large, keeping the mesh conforming");
+  std::string desc;
+  desc =
+    "  Usage: AdaptiveRefinement indicator:uri=field threshold:real=0.5\n\n"
+    "Cells where the indicator exceeds the threshold are split, and neighbouring elements are split as needed to avoid hanging nodes.\n"
+    "Supported elements are the LagrangeP1 lines, triangles, quadrilaterals, tetrahedra and hexahedra.";
+  properties()["description"] = desc;
+
+  options().add("indicator", m_indicator).link_to(&m_indicator)
+    .pretty_name("Indicator")
+    .description("Error indicator field. The indicator of a cell is the largest norm of the field rows in the cell")
+    .mark_basic();
+
+  options().add("threshold", 0.5)
+    .pretty_name("Threshold")
+    .description("Cells with an indicator larger than this value are refined")
+    .mark_basic();
+
+  options().add("relative_threshold", true)
+    .pretty_name("Relative Threshold")
+    .description("Interpret the threshold as a fraction of the largest indicator over the mesh");
+
+  properties().add("nb_flagged", 0u);
+  properties().add("nb_refined", 0u);
+
+  m_load_balance = Handle<MeshTransformer>(create_component<LoadBalance>("load_balance"));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void AdaptiveRefinement::execute()
+{
+  if(is_null(m_indicator))
+    throw SetupError(FromHere(), "Option indicator not set in " + uri().string());
+
+  Mesh& mesh = *m_mesh;
+  Dictionary& geometry = mesh.geometry_fields();
+  Comm& comm = Comm::instance();
+  const bool parallel = comm.is_active() && comm.size() > 1;
+  const Uint my_rank = comm.rank();
+  const Uint nb_procs = parallel ? comm.size() : 1;
+  const Uint dimensionality = mesh.dimensionality();
+
+  // Values can be transferred for the nodes of the geometry and for element based dictionaries
+  std::vector< Handle<Dictionary> > discontinuous_dicts;
+  boost_foreach(const Handle<Dictionary>& dict, mesh.dictionaries())
+  {
+    if(dict.get() == &geometry)
+      continue;
+    if(dict->continuous())
+      throw NotSupported(FromHere(), "Can't refine continuous dictionary " + dict->uri().string() + ", only the geometry and discontinuous dictionaries are supported");
+    discontinuous_dicts.push_back(dict);
+  }
+
+  const std::vector< Handle<Entities> > elements = mesh.elements();
+  const Uint nb_entities = elements.size();
+  std::vector<bool> is_cell(nb_entities);
+  for(Uint i = 0; i != nb_entities; ++i)
+    is_cell[i] = elements[i]->element_type().dimensionality() == dimensionality;
+
+  const common::List<Uint>& nodes_glb_idx = geometry.glb_idx();
+  const Field& coordinates = geometry.coordinates();
+  std::map<Uint, Uint> node_glb_to_loc;
+  for(Uint i = 0; i != geometry.size(); ++i)
+    node_glb_to_loc[nodes_glb_idx[i]] = i;
+  geometry.rebuild_node_to_element_connectivity();
+  const common::DynTable<SpaceElem>& node_to_elements = geometry.connectivity();
+
+  // Indicator of the owned cells
+  const Field& indicator = *m_indicator;
+  const Dictionary& indicator_dict = indicator.dict();
+  std::vector< std::vector<Real> > cell_indicator(nb_entities);
+  Real max_indicator = 0.;
+  for(Uint i = 0; i != nb_entities; ++i)
+  {
+    const Entities& entities = *elements[i];
+    if(!is_cell[i] || !indicator_dict.defined_for_entities(elements[i]))
+      continue;
+    const Connectivity& rows = indicator_dict.space(entities).connectivity();
+    cell_indicator[i].resize(entities.size(), 0.);
+    for(Uint e = 0; e != entities.size(); ++e)
+    {
+      if(entities.is_ghost(e))
+        continue;
+      boost_foreach(const Uint row, rows[e])
+      {
+        Real norm2 = 0.;
+        for(Uint j = 0; j != indicator.row_size(); ++j)
+          norm2 += indicator[row][j]*indicator[row][j];
+        cell_indicator[i][e] = std::max(cell_indicator[i][e], std::sqrt(norm2));
+      }
+      max_indicator = std::max(max_indicator, cell_indicator[i][e]);
+    }
+  }
+  if(parallel)
+  {
+    const Real local_max = max_indicator;
+    comm.all_reduce(PE::max(), &local_max, 1, &max_indicator);
+  }
+  const Real threshold = options().value<bool>("relative_threshold") ? options().value<Real>("threshold")*max_indicator : options().value<Real>("threshold");
+
+  // Mark all edges of the flagged cells
+  std::set<EdgeT> marked;
+  std::vector<EdgeT> fresh;
+  std::vector<EdgeT> to_send;
+  Uint nb_flagged = 0;
+  for(Uint i = 0; i != nb_entities; ++i)
+  {
+    if(cell_indicator[i].empty())
+      continue;
+    const Entities& entities = *elements[i];
+    const EdgeTable table = edge_table(entities.element_type());
+    const Connectivity& connectivity = entities.geometry_space().connectivity();
+    for(Uint e = 0; e != entities.size(); ++e)
+    {
+      if(entities.is_ghost(e) || cell_indicator[i][e] <= threshold)
+        continue;
+      if(table.nb_edges == 0)
+        throw NotSupported(FromHere(), "Can't refine elements of type " + entities.element_type().derived_type_name() + " in " + entities.uri().string());
+      ++nb_flagged;
+      for(Uint k = 0; k != table.nb_edges; ++k)
+      {
+        const EdgeT edge = make_edge(nodes_glb_idx[connectivity[e][table.edges[k][0]]], nodes_glb_idx[connectivity[e][table.edges[k][1]]]);
+        if(marked.insert(edge).second)
+        {
+          fresh.push_back(edge);
+          to_send.push_back(edge);
+        }
+      }
+    }
+  }
+
+  // Closure: mark extra edges in the owned cells around each new mark until all cells have a conforming pattern.
+  // Marks are sent to the processes that own a cell or face containing the edge.
+  std::vector<Uint> edge_nodes(2);
+  while(true)
+  {
+    while(!fresh.empty())
+    {
+      const EdgeT edge = fresh.back();
+      fresh.pop_back();
+      const std::map<Uint, Uint>::const_iterator a = node_glb_to_loc.find(edge.first);
+      const std::map<Uint, Uint>::const_iterator b = node_glb_to_loc.find(edge.second);
+      if(a == node_glb_to_loc.end() || b == node_glb_to_loc.end())
+        continue;
+      edge_nodes[0] = a->second;
+      edge_nodes[1] = b->second;
+      boost_foreach(const SpaceElem& space_elem, node_to_elements[a->second])
+      {
+        const Entities& entities = space_elem.comp->support();
+        const Connectivity::ConstRow nodes = space_elem.comp->connectivity()[space_elem.idx];
+        if(entities.is_ghost(space_elem.idx) || entities.element_type().dimensionality() != dimensionality || !contains_all(nodes, edge_nodes))
+          continue;
+        const EdgeTable table = edge_table(entities.element_type());
+        if(table.nb_edges == 0)
+          throw NotSupported(FromHere(), "Can't refine elements of type " + entities.element_type().derived_type_name() + " in " + entities.uri().string());
+        const Uint pattern = edge_pattern(marked, table, nodes, nodes_glb_idx);
+        const Uint closed = close_pattern(entities.element_type().shape(), pattern);
+        for(Uint k = 0; k != table.nb_edges; ++k)
+        {
+          if(!(closed & ~pattern & bit(k)))
+            continue;
+          const EdgeT new_edge = make_edge(nodes_glb_idx[nodes[table.edges[k][0]]], nodes_glb_idx[nodes[table.edges[k][1]]]);
+          if(marked.insert(new_edge).second)
+          {
+            fresh.push_back(new_edge);
+            to_send.push_back(new_edge);
+          }
+        }
+      }
+    }
+
+    if(!parallel)
+      break;
+
+    std::vector< std::vector<Uint> > send(nb_procs), receive(nb_procs);
+    boost_foreach(const EdgeT& edge, to_send)
+    {
+      edge_nodes[0] = node_glb_to_loc[edge.first];
+      edge_nodes[1] = node_glb_to_loc[edge.second];
+      std::set<Uint> ranks;
+      boost_foreach(const SpaceElem& space_elem, node_to_elements[edge_nodes[0]])
+      {
+        if(space_elem.is_ghost() && contains_all(space_elem.comp->connectivity()[space_elem.idx], edge_nodes))
+          ranks.insert(space_elem.rank());
+      }
+      boost_foreach(const Uint rank, ranks)
+      {
+        send[rank].push_back(edge.first);
+        send[rank].push_back(edge.second);
+      }
+    }
+    to_send.clear();
+    comm.all_to_all(send, receive);
+
+    Uint nb_received = 0;
+    for(Uint rank = 0; rank != nb_procs; ++rank)
+    {
+      for(Uint i = 0; i+1 < receive[rank].size(); i += 2)
+      {
+        const EdgeT edge(receive[rank][i], receive[rank][i+1]);
+        if(marked.insert(edge).second)
+        {
+          fresh.push_back(edge);
+          ++nb_received;
+        }
+      }
+    }
+    Uint total_received = 0;
+    comm.all_reduce(PE::plus(), &nb_received, 1, &total_received);
+    if(total_received == 0)
+      break;
+  }
+
+  // Patterns of the owned elements. Elements that are split into triangles need a triangle Entities in the same region,
+  // which must be created on all processes to keep the list of entities identical everywhere.
+  std::vector< std::vector<Uint> > patterns(nb_entities);
+  std::vector<int> needs_fan(nb_entities, 0);
+  for(Uint i = 0; i != nb_entities; ++i)
+  {
+    const Entities& entities = *elements[i];
+    const ElementType& etype = entities.element_type();
+    const EdgeTable table = edge_table(etype);
+    const Connectivity& connectivity = entities.geometry_space().connectivity();
+    patterns[i].resize(entities.size(), 0);
+    for(Uint e = 0; e != entities.size(); ++e)
+    {
+      if(entities.is_ghost(e))
+        continue;
+      if(table.nb_edges == 0)
+      {
+        if(etype.shape() != GeoShape::POINT && has_marked_edge(marked, connectivity[e], nodes_glb_idx))
+          throw NotSupported(FromHere(), "Can't refine elements of type " + etype.derived_type_name() + " in " + entities.uri().string());
+        continue;
+      }
+      const Uint pattern = edge_pattern(marked, table, connectivity[e], nodes_glb_idx);
+      if(close_pattern(etype.shape(), pattern) != pattern)
+        throw NotSupported(FromHere(), "Element " + to_str(e) + " of " + entities.uri().string() + " has a non-conforming edge pattern " + to_str(pattern));
+      patterns[i][e] = pattern;
+      if(etype.shape() == GeoShape::QUAD && is_cell[i] && !is_tensor_pattern(pattern))
+        needs_fan[i] = 1;
+    }
+  }
+  if(parallel)
+  {
+    const std::vector<int> local_needs_fan = needs_fan;
+    comm.all_reduce(PE::max(), &local_needs_fan[0], nb_entities, &needs_fan[0]);
+  }
+
+  std::vector< Handle<Entities> > fan_target(nb_entities);
+  std::vector<bool> created(nb_entities, false);
+  std::map<const Entities*, Uint> bucket_idx;
+  std::vector<Bucket> buckets;
+  for(Uint i = 0; i != nb_entities; ++i)
+  {
+    bucket_idx[elements[i].get()] = buckets.size();
+    buckets.push_back(Bucket());
+    buckets.back().target = elements[i];
+    buckets.back().nb_nodes = elements[i]->element_type().nb_nodes();
+  }
+  for(Uint i = 0; i != nb_entities; ++i)
+  {
+    if(!needs_fan[i])
+      continue;
+    Region& region = find_parent_component<Region>(*elements[i]);
+    const std::string triag_type = "cf3.mesh.LagrangeP1.Triag" + to_str(elements[i]->element_type().dimension()) + "D";
+    const Uint nb_region_entities = region.count_children();
+    fan_target[i] = region.create_elements(triag_type, geometry).handle<Entities>();
+    created[i] = region.count_children() != nb_region_entities;
+    if(!bucket_idx.count(fan_target[i].get()))
+    {
+      bucket_idx[fan_target[i].get()] = buckets.size();
+      buckets.push_back(Bucket());
+      buckets.back().target = fan_target[i];
+      buckets.back().nb_nodes = 3;
+    }
+  }
+
+  // Children of the owned elements, and the nodes of the refined mesh
+  NewNodes new_nodes(nodes_glb_idx);
+  Uint nb_refined = 0;
+  std::vector<Uint> old_nodes;
+  RealMatrix parent_coords;
+  for(Uint i = 0; i != nb_entities; ++i)
+  {
+    const Entities& entities = *elements[i];
+    const ElementType& etype = entities.element_type();
+    const Connectivity& connectivity = entities.geometry_space().connectivity();
+    Bucket& same_bucket = buckets[bucket_idx[&entities]];
+    for(Uint e = 0; e != entities.size(); ++e)
+    {
+      if(entities.is_ghost(e))
+        continue;
+      const Connectivity::ConstRow parent_nodes = connectivity[e];
+      if(patterns[i][e] == 0)
+      {
+        for(Uint n = 0; n != parent_nodes.size(); ++n)
+        {
+          old_nodes.assign(1, parent_nodes[n]);
+          same_bucket.connectivity.push_back(new_nodes.add(old_nodes));
+        }
+        same_bucket.parent_entities.push_back(i);
+        same_bucket.parent_element.push_back(e);
+        same_bucket.masks.push_back(std::vector<Uint>());
+        continue;
+      }
+
+      parent_coords.resize(parent_nodes.size(), coordinates.row_size());
+      for(Uint n = 0; n != parent_nodes.size(); ++n)
+        for(Uint d = 0; d != coordinates.row_size(); ++d)
+          parent_coords(n, d) = coordinates[parent_nodes[n]][d];
+
+      Children children;
+      split_element(etype, patterns[i][e], is_cell[i], parent_coords, children);
+      if(is_cell[i])
+        ++nb_refined;
+
+      Bucket& bucket = children.fan ? buckets[bucket_idx[fan_target[i].get()]] : same_bucket;
+      boost_foreach(const std::vector<Uint>& child, children.nodes)
+      {
+        boost_foreach(const Uint mask, child)
+        {
+          old_nodes.clear();
+          for(Uint n = 0; n != parent_nodes.size(); ++n)
+            if(mask & bit(n))
+              old_nodes.push_back(parent_nodes[n]);
+          bucket.connectivity.push_back(new_nodes.add(old_nodes));
+        }
+        bucket.parent_entities.push_back(i);
+        bucket.parent_element.push_back(e);
+        bucket.masks.push_back(child);
+      }
+    }
+  }
+
+  // Values of the geometry fields at the new nodes, as the average of the old nodes they are the centre of.
+  // For P1 elements this is the interpolation with the shape functions, and it sums in the same order on all processes.
+  const std::vector< std::vector<Uint> >& sources = new_nodes.sources();
+  const Uint nb_new_nodes = new_nodes.size();
+  std::vector< Handle<Field> > geometry_fields;
+  boost_foreach(Field& field, find_components<Field>(geometry))
+    geometry_fields.push_back(field.handle<Field>());
+  std::vector< std::vector<Real> > new_node_values(geometry_fields.size());
+  for(Uint f = 0; f != geometry_fields.size(); ++f)
+  {
+    const Field& field = *geometry_fields[f];
+    const Uint row_size = field.row_size();
+    new_node_values[f].assign(nb_new_nodes*row_size, 0.);
+    for(Uint n = 0; n != nb_new_nodes; ++n)
+    {
+      boost_foreach(const Uint old_node, sources[n])
+        for(Uint j = 0; j != row_size; ++j)
+          new_node_values[f][n*row_size + j] += field.value(old_node, j);
+      for(Uint j = 0; j != row_size; ++j)
+        new_node_values[f][n*row_size + j] /= static_cast<Real>(sources[n].size());
+    }
+  }
+
+  // Each node belongs to the lowest rank that creates it. The ranks creating a node are collected on a rendezvous process,
+  // chosen from the smallest global index of its old nodes, so the result doesn't depend on the extent of the overlap.
+  std::vector<Uint> new_node_rank(nb_new_nodes, my_rank);
+  if(parallel)
+  {
+    std::vector< std::vector<Uint> > send(nb_procs), receive(nb_procs);
+    std::vector< std::vector<Uint> > sent_nodes(nb_procs);
+    for(Uint n = 0; n != nb_new_nodes; ++n)
+    {
+      const Uint rendezvous = nodes_glb_idx[sources[n].front()] % nb_procs;
+      send[rendezvous].push_back(sources[n].size());
+      boost_foreach(const Uint old_node, sources[n])
+        send[rendezvous].push_back(nodes_glb_idx[old_node]);
+      sent_nodes[rendezvous].push_back(n);
+    }
+    comm.all_to_all(send, receive);
+
+    // Ranks are visited in increasing order, so the first rank to insert a key is the lowest
+    std::map<std::vector<Uint>, Uint> lowest_rank;
+    std::vector<Uint> key;
+    for(Uint rank = 0; rank != nb_procs; ++rank)
+    {
+      for(Uint i = 0; i < receive[rank].size(); i += receive[rank][i] + 1)
+      {
+        key.assign(receive[rank].begin() + i + 1, receive[rank].begin() + i + 1 + receive[rank][i]);
+        lowest_rank.insert(std::make_pair(key, rank));
+      }
+    }
+
+    std::vector< std::vector<Uint> > reply(nb_procs), answer(nb_procs);
+    for(Uint rank = 0; rank != nb_procs; ++rank)
+    {
+      for(Uint i = 0; i < receive[rank].size(); i += receive[rank][i] + 1)
+      {
+        key.assign(receive[rank].begin() + i + 1, receive[rank].begin() + i + 1 + receive[rank][i]);
+        reply[rank].push_back(lowest_rank[key]);
+      }
+    }
+    comm.all_to_all(reply, answer);
+
+    for(Uint rank = 0; rank != nb_procs; ++rank)
+    {
+      cf3_assert(answer[rank].size() == sent_nodes[rank].size());
+      for(Uint i = 0; i != sent_nodes[rank].size(); ++i)
+        new_node_rank[sent_nodes[rank][i]] = answer[rank][i];
+    }
+  }
+
+  // Spaces for the new triangles in the discontinuous dictionaries, using the same space library as the quads
+  boost_foreach(const Handle<Dictionary>& dict, discontinuous_dicts)
+  {
+    for(Uint i = 0; i != nb_entities; ++i)
+    {
+      if(!created[i] || !dict->defined_for_entities(elements[i]) || dict->defined_for_entities(fan_target[i]))
+        continue;
+      const std::string sf_name = dict->space(*elements[i]).shape_function().derived_type_name();
+      fan_target[i]->create_space(sf_name.substr(0, sf_name.rfind('.')+1) + fan_target[i]->element_type().shape_name(), *dict);
+    }
+    dict->update_structures();
+  }
+
+  // Values of the discontinuous fields in the children, interpolated with the shape functions of the parent space
+  // Indexed as [dictionary][bucket][field], with the values for each child and each node of the child space
+  std::vector< std::vector< Handle<Field> > > discontinuous_fields(discontinuous_dicts.size());
+  std::vector< std::vector< std::vector< std::vector<Real> > > > element_values(discontinuous_dicts.size());
+  for(Uint d = 0; d != discontinuous_dicts.size(); ++d)
+  {
+    const Dictionary& dict = *discontinuous_dicts[d];
+    discontinuous_fields[d] = dict.fields();
+    const std::vector<Handle<Field> >& fields = discontinuous_fields[d];
+    element_values[d].resize(buckets.size());
+    for(Uint b = 0; b != buckets.size(); ++b)
+    {
+      const Bucket& bucket = buckets[b];
+      element_values[d][b].resize(fields.size());
+      if(bucket.size() == 0)
+        continue;
+      const bool target_defined = dict.defined_for_entities(bucket.target);
+      for(Uint c = 0; c != bucket.size(); ++c)
+      {
+        const Entities& parent = *elements[bucket.parent_entities[c]];
+        if(dict.defined_for_entities(parent.handle<Entities>()) != target_defined)
+          throw NotSupported(FromHere(), "Dictionary " + dict.uri().string() + " must be defined for both " + parent.uri().string() + " and " + bucket.target->uri().string());
+      }
+      if(!target_defined)
+        continue;
+
+      const ShapeFunction& child_sf = bucket.target->space(dict).shape_function();
+      const ShapeFunction& child_geometry_sf = bucket.target->element_type().shape_function();
+      const Uint nb_child_rows = child_sf.nb_nodes();
+      for(Uint f = 0; f != fields.size(); ++f)
+        element_values[d][b][f].reserve(bucket.size()*nb_child_rows*fields[f]->row_size());
+
+      for(Uint c = 0; c != bucket.size(); ++c)
+      {
+        const Entities& parent = *elements[bucket.parent_entities[c]];
+        const Space& parent_space = dict.space(parent);
+        const Connectivity::ConstRow parent_rows = parent_space.connectivity()[bucket.parent_element[c]];
+        if(bucket.masks[c].empty())
+        {
+          // Unchanged element
+          for(Uint f = 0; f != fields.size(); ++f)
+            boost_foreach(const Uint row, parent_rows)
+              for(Uint j = 0; j != fields[f]->row_size(); ++j)
+                element_values[d][b][f].push_back((*fields[f])[row][j]);
+          continue;
+        }
+
+        const RealMatrix& parent_local_coords = parent.element_type().shape_function().local_coordinates();
+        for(Uint r = 0; r != nb_child_rows; ++r)
+        {
+          const RealRowVector child_geometry_values = child_geometry_sf.value(child_sf.local_coordinates().row(r).transpose());
+          RealVector mapped_coords(parent_local_coords.cols());
+          mapped_coords.setZero();
+          for(Uint k = 0; k != bucket.masks[c].size(); ++k)
+            mapped_coords += child_geometry_values[k] * mask_coordinates(parent_local_coords, bucket.masks[c][k]);
+          const RealRowVector parent_values = parent_space.shape_function().value(mapped_coords);
+          for(Uint f = 0; f != fields.size(); ++f)
+          {
+            const Field& field = *fields[f];
+            for(Uint j = 0; j != field.row_size(); ++j)
+            {
+              Real value = 0.;
+              for(Uint p = 0; p != parent_rows.size(); ++p)
+                value += parent_values[p] * field.value(parent_rows[p], j);
+              element_values[d][b][f].push_back(value);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Rewrite the geometry. The ghost elements are dropped, and their nodes with them.
+  geometry.resize(nb_new_nodes);
+  for(Uint f = 0; f != geometry_fields.size(); ++f)
+  {
+    Field& field = *geometry_fields[f];
+    const Uint row_size = field.row_size();
+    for(Uint n = 0; n != nb_new_nodes; ++n)
+      for(Uint j = 0; j != row_size; ++j)
+        field.set_value(n, j, new_node_values[f][n*row_size + j]);
+  }
+  // The node glb_idx is temporarily the local index, so it is not unique over the ranks and nodes shared between ranks
+  // get different values. This only works because LoadBalance runs right after, and its GlobalNumbering renumbers all
+  // nodes and elements from a hash of their coordinates before anything compares global indices between ranks.
+  for(Uint n = 0; n != nb_new_nodes; ++n)
+  {
+    geometry.glb_idx()[n] = n;
+    geometry.rank()[n] = new_node_rank[n];
+  }
+
+  // Temporary element numbering, LoadBalance creates the final one
+  Uint elem_glb_idx = 0;
+  boost_foreach(const Bucket& bucket, buckets)
+  {
+    Entities& entities = *bucket.target;
+    entities.resize(bucket.size());
+    Connectivity& connectivity = entities.geometry_space().connectivity();
+    for(Uint c = 0; c != bucket.size(); ++c)
+    {
+      for(Uint n = 0; n != bucket.nb_nodes; ++n)
+        connectivity[c][n] = bucket.connectivity[c*bucket.nb_nodes + n];
+      entities.rank()[c] = my_rank;
+      entities.glb_idx()[c] = elem_glb_idx++;
+    }
+  }
+  mesh.update_structures();
+
+  for(Uint d = 0; d != discontinuous_dicts.size(); ++d)
+  {
+    Dictionary& dict = *discontinuous_dicts[d];
+    dict.build();
+    const std::vector<Handle<Field> >& fields = discontinuous_fields[d];
+    for(Uint b = 0; b != buckets.size(); ++b)
+    {
+      if(buckets[b].size() == 0 || !dict.defined_for_entities(buckets[b].target))
+        continue;
+      const Connectivity& rows = dict.space(*buckets[b].target).connectivity();
+      for(Uint f = 0; f != fields.size(); ++f)
+      {
+        Field& field = *fields[f];
+        const std::vector<Real>& values = element_values[d][b][f];
+        Uint idx = 0;
+        for(Uint c = 0; c != buckets[b].size(); ++c)
+          boost_foreach(const Uint row, rows[c])
+            for(Uint j = 0; j != field.row_size(); ++j)
+              field.set_value(row, j, values[idx++]);
+      }
+    }
+  }
+
+  mesh.block_mesh_changed(true);
+  mesh.raise_mesh_changed();
+  mesh.block_mesh_changed(false);
+
+  Uint total_flagged = nb_flagged, total_refined = nb_refined;
+  if(parallel)
+  {
+    comm.all_reduce(PE::plus(), &nb_flagged, 1, &total_flagged);
+    comm.all_reduce(PE::plus(), &nb_refined, 1, &total_refined);
+  }
+  properties()["nb_flagged"] = total_flagged;
+  properties()["nb_refined"] = total_refined;
+  CFinfo << "adaptive refinement: flagged " << total_flagged << " cells, refined " << total_refined << " cells" << CFendl;
+
+  m_load_balance->transform(mesh);
+
+  // Rebuild the face to cell connectivities, including the cells that were added next to the ones already used.
+  // The connectivities belonging to face entities are built by BuildFaces, which needs to run again.
+  boost_foreach(FaceCellConnectivity& face_cell_connectivity, find_components_recursively<FaceCellConnectivity>(mesh))
+  {
+    if(is_not_null(Handle<Entities>(face_cell_connectivity.parent())))
+      continue;
+    const std::vector< Handle<Component> > used = face_cell_connectivity.used();
+    if(used.empty())
+      continue;
+    boost_foreach(const Handle<Component>& used_comp, used)
+    {
+      boost_foreach(Entities& cells, find_components_with_filter<Entities>(*used_comp->parent(), IsElementsVolume()))
+        face_cell_connectivity.add_used(cells);
+    }
+    face_cell_connectivity.build_connectivity();
+  }
+
+  mesh.raise_mesh_changed();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // mesh
+} // cf3
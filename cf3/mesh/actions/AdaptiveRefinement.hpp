@@ -0,0 +1,77 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_actions_AdaptiveRefinement_hpp
+#define cf3_mesh_actions_AdaptiveRefinement_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include "mesh/MeshTransformer.hpp"
+
+#include "mesh/actions/LibActions.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace mesh {
+
+  class Field;
+
+namespace actions {
+
+//////////////////////////////////////////////////////////////////////////////
+
+/// @brief Adaptive h-refinement of a P1 mesh, driven by an error indicator field
+///
+/// Cells where the indicator exceeds the threshold are flagged, and all their edges are marked for splitting.
+/// A closure then marks additional edges until every cell can be split without hanging nodes:
+///  - lines are split in 2
+///  - triangles are split in 2 (1 marked edge) or 4 (3 marked edges)
+///  - tetrahedra are split in 2 (1 marked edge), 4 (the 3 edges of a face) or 8 (all edges)
+///  - quadrilaterals are split in 4 (all edges) or 2 (two opposite edges), and otherwise
+///    replaced by a fan of triangles around their centre
+///  - hexahedra are split in two along each direction that has a marked edge. LagrangeP1 has no pyramids to
+///    make a conforming transition to unrefined hexahedra, so the refinement extends along sheets of hexahedra.
+///
+/// Boundary elements are split following the marks on their edges. Each new node is the centre of an edge, face or cell
+/// of its parent, and the fields of the geometry dictionary are interpolated there using the parent shape functions.
+/// Fields in discontinuous dictionaries are interpolated in the same way at the nodes of the child elements.
+///
+/// In parallel, the marks on edges shared with other processes are exchanged until the closure converges, using the
+/// ghost elements of the overlap layer. The ghost elements are dropped when the mesh is rebuilt, and LoadBalance is
+/// executed afterwards to renumber, rebalance and grow the overlap again. FaceCellConnectivity components inside
+/// the mesh are rebuilt at the end.
+class mesh_actions_API AdaptiveRefinement : public MeshTransformer
+{
+public: // functions
+
+  /// constructor
+  AdaptiveRefinement( const std::string& name );
+
+  /// Gets the Class name
+  static std::string type_name() { return "AdaptiveRefinement"; }
+
+  virtual void execute();
+
+private: // data
+
+  /// Error indicator. The indicator of a cell is the largest norm of the rows of this field in the cell
+  Handle<Field const> m_indicator;
+
+  /// Renumbers, rebalances and restores the overlap after the refinement
+  Handle<MeshTransformer> m_load_balance;
+
+}; // end AdaptiveRefinement
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // mesh
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_mesh_actions_AdaptiveRefinement_hpp
@@ -4,6 +4,8 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <algorithm>
+
 #include <boost/function.hpp>
 #include <boost/bind.hpp>
 
@@ -17,7 +19,7 @@
 #include "common/PropertyList.hpp"
 #include "common/Signal.hpp"
 #include "common/XML/SignalOptions.hpp"
-#include "math/AnalyticalFunction.hpp"
+#include "math/VectorialFunction.hpp"
 
 #include "mesh/actions/InitFieldFunction.hpp"
 #include "mesh/Elements.hpp"
@@ -185,37 +187,54 @@ void InitFieldFunction::execute()
     }
   }
 
-  // create the functions
-  std::vector<math::AnalyticalFunction> functions(option_functions.size());
-  for (Uint f=0; f<functions.size(); ++f)
+  // check: columns must be of index smaller than index of field
+  for (Uint f=0; f<option_functions.size(); ++f)
   {
-    // check: columns must be of index smaller than index of field
     if (cols[f] >= m_field->row_size()) throw SetupError(FromHere(), "Specified column ["+to_str(cols[f])+"] doesn't exist. (field has only "+to_str(m_field->row_size())+" cols)");
-    functions[f].parse(option_functions[f],variable_names);
   }
 
+  // create the functions, compiled together so they are evaluated for a block of points at once
+  math::VectorialFunction functions;
+  functions.variables(variable_names);
+  functions.functions(option_functions);
+  functions.parse();
+
   std::vector<Real> constants;
   constants.push_back( options().value<Real>("time") );
 
-  std::vector<Real> variables(variable_names.size());
+  const Uint nb_vars = variable_names.size();
+  const Uint nb_funcs = option_functions.size();
+  const Uint block_size = math::CompiledFunction::block_size;
+  std::vector<Real> variables(block_size*nb_vars);
+  std::vector<Real> values(block_size*nb_funcs);
 
-  for (Uint pt=0; pt<dict.size(); ++pt)
+  for (Uint block_begin=0; block_begin<dict.size(); block_begin+=block_size)
   {
+    const Uint block_end = std::min(block_begin+block_size, dict.size());
+
     // Assemble variables per point
-    Uint c=0;
-    for (Uint j=0; j<field_comps.size(); ++j, ++c)
-    {
-      variables[c] = field_comps[j]->array()[pt][field_cols[j]];
-    }
-    for (Uint j=0; j<constants.size(); ++j, ++c)
+    for (Uint pt=block_begin; pt<block_end; ++pt)
     {
-      variables[c] = constants[j];
+      Real* pt_variables = &variables[(pt-block_begin)*nb_vars];
+      Uint c=0;
+      for (Uint j=0; j<field_comps.size(); ++j, ++c)
+      {
+        pt_variables[c] = field_comps[j]->value(pt, field_cols[j]);
+      }
+      for (Uint j=0; j<constants.size(); ++j, ++c)
+      {
+        pt_variables[c] = constants[j];
+      }
     }
 
     // Evaluate functions
-    for (Uint f=0; f<cols.size(); ++f)
+    functions.evaluate_points(&variables[0], block_end-block_begin, &values[0]);
+    for (Uint pt=block_begin; pt<block_end; ++pt)
     {
-      m_field->array()[pt][f] = functions[f](variables);
+      for (Uint f=0; f<nb_funcs; ++f)
+      {
+        m_field->set_value(pt, f, values[(pt-block_begin)*nb_funcs+f]);
+      }
     }
   }
 }
@@ -6,15 +6,25 @@
 
 #include "coolfluid-packages.hpp"
 
+#include <map>
+
+#include <boost/bind.hpp>
+
 #include "common/Builder.hpp"
+#include "common/List.hpp"
 #include "common/Log.hpp"
 #include "common/OptionList.hpp"
 #include "common/PropertyList.hpp"
 
 #include "common/PE/Comm.hpp"
+#include "common/PE/operations.hpp"
 
 #include "mesh/actions/LoadBalance.hpp"
+#include "mesh/ElementCost.hpp"
+#include "mesh/Entities.hpp"
+#include "mesh/GeometricPartitioner.hpp"
 #include "mesh/Mesh.hpp"
+#include "mesh/MeshAdaptor.hpp"
 #include "mesh/Region.hpp"
 
 //////////////////////////////////////////////////////////////////////////////
@@ -38,11 +48,8 @@ LoadBalance::LoadBalance( const std::string& name ) :
   ,m_partitioner(create_component("partitioner", "cf3.mesh.ptscotch.Partitioner"))
 #elif (defined CF3_HAVE_ZOLTAN)
   ,m_partitioner(create_component("partitioner", "cf3.mesh.zoltan.Partitioner"))
-#endif
-
-#if ( !defined CF3_HAVE_PTSCOTCH ) && ( !defined CF3_HAVE_ZOLTAN )
-#warning "There is no partitioner available (Zoltan or PT-Scotch). Load-balancing will not be possible."
-#define CF3_MESH_LOADBALANCE_PARTITIONER_UNAVAILABLE
+#else
+  ,m_partitioner(create_component("partitioner", "cf3.mesh.GeometricPartitioner"))
 #endif
 {
 
@@ -52,6 +59,30 @@ LoadBalance::LoadBalance( const std::string& name ) :
     "  Usage: LoadBalance Regions:array[uri]=region1,region2\n\n";
   properties()["description"] = desc;
 
+  options().add("mode", std::string("Initial"))
+    .pretty_name("Mode")
+    .description("Initial: partition with equal element weights. "
+                 "Dynamic: measure the element cost and repartition when the imbalance exceeds imbalance_threshold");
+  options().option("mode").restricted_list().push_back(std::string("Initial"));
+  options().option("mode").restricted_list().push_back(std::string("Dynamic"));
+
+  options().add("imbalance_threshold", 1.1)
+    .pretty_name("Imbalance Threshold")
+    .description("In Dynamic mode, repartition when the cost of the most loaded rank divided by the average cost exceeds this value");
+
+  properties().add("imbalance", 1.);
+
+  options().add("partitioner", m_partitioner->derived_type_name())
+    .pretty_name("Partitioner")
+    .description("Builder name of the partitioner: cf3.mesh.GeometricPartitioner, which is always available, "
+                 "or cf3.mesh.ptscotch.Partitioner and cf3.mesh.zoltan.Partitioner, if they were built")
+    .attach_trigger(boost::bind(&LoadBalance::trigger_partitioner, this));
+
+  options().add("initial_partition", false)
+    .pretty_name("Initial Partition")
+    .description("Partition the mesh with the GeometricPartitioner before running a graph partitioner, "
+                 "so the graph partitioner starts from partitions with good locality");
+
 #if (defined CF3_HAVE_PTSCOTCH)
   // no configuration necessary
 #elif (defined CF3_HAVE_ZOLTAN)
@@ -61,49 +92,78 @@ LoadBalance::LoadBalance( const std::string& name ) :
 
 /////////////////////////////////////////////////////////////////////////////
 
+void LoadBalance::trigger_partitioner()
+{
+  const std::string builder_name = options().value<std::string>("partitioner");
+  if( m_partitioner->derived_type_name() == builder_name )
+    return;
+
+  remove_component("partitioner");
+  m_partitioner = Handle<MeshTransformer>(create_component("partitioner", builder_name));
+  if( builder_name == "cf3.mesh.zoltan.Partitioner" )
+    m_partitioner->options().set("graph_package", std::string("PHG"));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 void LoadBalance::execute()
 {
 
   Mesh& mesh = *m_mesh;
 
+  if( options().value<std::string>("mode") == "Dynamic" )
+  {
+    // The first execution only starts measuring. Decided on all ranks together, since the imbalance is collective
+    int not_measured = ( mesh.elements().empty() || is_null(element_cost(*mesh.elements().front())) ) ? 1 : 0;
+    if( Comm::instance().is_active() )
+    {
+      const int local_not_measured = not_measured;
+      Comm::instance().all_reduce(PE::max(), &local_not_measured, 1, &not_measured);
+    }
+    if( not_measured )
+    {
+      CFinfo << "loadbalancing mesh: start measuring the element cost" << CFendl;
+      reset_element_cost(mesh);
+      return;
+    }
+
+    const Real imbalance = element_cost_imbalance(mesh);
+    properties()["imbalance"] = imbalance;
+    CFinfo << "loadbalancing mesh: measured imbalance " << imbalance << CFendl;
+    if( imbalance <= options().value<Real>("imbalance_threshold") || !Comm::instance().is_active() || Comm::instance().size() == 1 )
+    {
+      reset_element_cost(mesh);
+      return;
+    }
+
+    // The partitioner expects every element and node to be owned by the rank that holds it, except for the
+    // nodes on the partition boundaries, so the overlap of the previous partitioning is removed first.
+    // partition() renumbers the remaining nodes and elements before partitioning them.
+    remove_overlap(mesh);
+
+    // Only this repartition uses the measured weights, so the configured weights are restored afterwards, even if it fails
+    const std::string object_weights = m_partitioner->options().value<std::string>("object_weights");
+    m_partitioner->options().set("object_weights", std::string("Measured"));
+    try
+    {
+      partition(mesh);
+    }
+    catch(...)
+    {
+      m_partitioner->options().set("object_weights", object_weights);
+      throw;
+    }
+    m_partitioner->options().set("object_weights", object_weights);
+
+    // The cost lists are not migrated with the elements, so measure again on the new partitions
+    reset_element_cost(mesh);
+    return;
+  }
+
   // balance if parallel run with multiple processors
   if( Comm::instance().is_active() && Comm::instance().size() > 1 )
   {
-
-    CFinfo << "loadbalancing mesh:" << CFendl;
-
-    Comm::instance().barrier();
-    CFinfo << "  + building joint node & element global numbering ... " << CFendl;
-
-    // build global numbering and connectivity of nodes and elements (necessary for partitioning)
-    build_component_abstract_type<MeshTransformer>("cf3.mesh.actions.GlobalNumbering","glb_numbering")->transform(mesh);
-
-    CFinfo << "  + building joint node & element global numbering ... done" << CFendl;
-    Comm::instance().barrier();
-
-    CFinfo << "  + building global node-element connectivity ... " << CFendl;
-
-    build_component_abstract_type<MeshTransformer>("cf3.mesh.actions.GlobalConnectivity","glb_connectivity")->transform(mesh);
-
-    CFinfo << "  + building global node-element connectivity ... done" << CFendl;
-    Comm::instance().barrier();
-
-#ifdef CF3_MESH_LOADBALANCE_PARTITIONER_UNAVAILABLE
-    CFwarn << "  Skipping mesh partitioning. (No partitioner available)" << CFendl;
-#else
-    CFinfo << "  + partitioning and migrating ..." << CFendl;
-    m_partitioner->transform(mesh);
-    CFinfo << "  + partitioning and migrating ... done" << CFendl;
-#endif
-    Comm::instance().barrier();
-    CFinfo << "  + growing overlap layer ..." << CFendl;
-    build_component_abstract_type<MeshTransformer>("cf3.mesh.actions.GrowOverlap","grow_overlap")->transform(mesh);
-    CFinfo << "  + growing overlap layer ... done" << CFendl;
-    Comm::instance().barrier();
-    CFinfo << "  + deallocating unused connectivity ..." << CFendl;
-    /// @todo check that this actually frees the memory
-    //mesh.geometry_fields().glb_elem_connectivity().resize(0);
-    CFinfo << "  + deallocating unused connectivity ... done" << CFendl;
+    partition(mesh);
   }
   else
   {
@@ -131,6 +191,97 @@ void LoadBalance::execute()
 
 //////////////////////////////////////////////////////////////////////////////
 
+void LoadBalance::remove_overlap(Mesh& mesh)
+{
+  CFinfo << "  + removing overlap layer ..." << CFendl;
+
+  // The measured cost of the owned elements is kept, by global element index
+  const Uint nb_entities = mesh.elements().size();
+  std::vector< Handle< common::List<Real> > > cost_lists(nb_entities);
+  std::vector< std::map<Uint,Real> > owned_cost(nb_entities);
+  for(Uint entities_idx = 0; entities_idx != nb_entities; ++entities_idx)
+  {
+    const Entities& entities = *mesh.elements()[entities_idx];
+    cost_lists[entities_idx] = element_cost(entities);
+    if(is_null(cost_lists[entities_idx]))
+      continue;
+    for(Uint elem = 0; elem != entities.size(); ++elem)
+    {
+      if(!entities.is_ghost(elem))
+        owned_cost[entities_idx][entities.glb_idx()[elem]] = (*cost_lists[entities_idx])[elem];
+    }
+  }
+
+  MeshAdaptor adaptor(mesh);
+  adaptor.prepare();
+  adaptor.remove_overlap();
+  adaptor.finish();
+
+  for(Uint entities_idx = 0; entities_idx != nb_entities; ++entities_idx)
+  {
+    if(is_null(cost_lists[entities_idx]))
+      continue;
+    const Entities& entities = *mesh.elements()[entities_idx];
+    common::List<Real>& cost = *cost_lists[entities_idx];
+    cost.resize(entities.size());
+    for(Uint elem = 0; elem != entities.size(); ++elem)
+      cost[elem] = owned_cost[entities_idx][entities.glb_idx()[elem]];
+  }
+
+  CFinfo << "  + removing overlap layer ... done" << CFendl;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void LoadBalance::partition(Mesh& mesh)
+{
+  CFinfo << "loadbalancing mesh:" << CFendl;
+
+  if( options().value<bool>("initial_partition") && is_null(Handle<GeometricPartitioner>(m_partitioner)) )
+  {
+    Comm::instance().barrier();
+    CFinfo << "  + geometric initial partitioning ... " << CFendl;
+    build_component_abstract_type<MeshTransformer>("cf3.mesh.actions.GlobalNumbering","glb_numbering")->transform(mesh);
+    Handle<MeshTransformer> initial_partitioner(get_child("initial_partitioner"));
+    if( is_null(initial_partitioner) )
+      initial_partitioner = Handle<MeshTransformer>(create_component<GeometricPartitioner>("initial_partitioner"));
+    initial_partitioner->options().set("object_weights", m_partitioner->options().value<std::string>("object_weights"));
+    initial_partitioner->transform(mesh);
+    CFinfo << "  + geometric initial partitioning ... done" << CFendl;
+  }
+
+  Comm::instance().barrier();
+  CFinfo << "  + building joint node & element global numbering ... " << CFendl;
+
+  // build global numbering and connectivity of nodes and elements (necessary for partitioning)
+  build_component_abstract_type<MeshTransformer>("cf3.mesh.actions.GlobalNumbering","glb_numbering")->transform(mesh);
+
+  CFinfo << "  + building joint node & element global numbering ... done" << CFendl;
+  Comm::instance().barrier();
+
+  CFinfo << "  + building global node-element connectivity ... " << CFendl;
+
+  build_component_abstract_type<MeshTransformer>("cf3.mesh.actions.GlobalConnectivity","glb_connectivity")->transform(mesh);
+
+  CFinfo << "  + building global node-element connectivity ... done" << CFendl;
+  Comm::instance().barrier();
+
+  CFinfo << "  + partitioning and migrating ..." << CFendl;
+  m_partitioner->transform(mesh);
+  CFinfo << "  + partitioning and migrating ... done" << CFendl;
+  Comm::instance().barrier();
+  CFinfo << "  + growing overlap layer ..." << CFendl;
+  build_component_abstract_type<MeshTransformer>("cf3.mesh.actions.GrowOverlap","grow_overlap")->transform(mesh);
+  CFinfo << "  + growing overlap layer ... done" << CFendl;
+  Comm::instance().barrier();
+  CFinfo << "  + deallocating unused connectivity ..." << CFendl;
+  /// @todo check that this actually frees the memory
+  //mesh.geometry_fields().glb_elem_connectivity().resize(0);
+  CFinfo << "  + deallocating unused connectivity ... done" << CFendl;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 
 } // actions
 } // mesh
@@ -23,6 +23,14 @@ namespace actions {
 
 /// @brief Load Balance the mesh
 ///
+/// In the default "Initial" mode the mesh is partitioned with equal weights for all elements.
+/// In "Dynamic" mode the transformer can be executed repeatedly during a simulation: the first
+/// execution starts measuring the element cost (see ElementCost.hpp), and subsequent executions
+/// repartition the mesh using the measured cost as element weights when the imbalance, i.e. the
+/// cost of the most loaded rank divided by the average, exceeds "imbalance_threshold".
+/// The fields are migrated with the mesh by the MeshAdaptor.
+/// The partitioner is PT-Scotch or Zoltan if available, and the GeometricPartitioner otherwise.
+/// A graph partitioner can start from a geometric partition with the option "initial_partition".
 /// @post After this, the mesh is ready to be parallellized
 /// @author Willem Deconinck
 class mesh_actions_API LoadBalance : public MeshTransformer
@@ -39,6 +47,15 @@ public: // functions
 
 private:
 
+  /// Remove the ghost elements and the nodes only they use, keeping the measured cost of the remaining elements
+  void remove_overlap(Mesh& mesh);
+
+  /// Partition and migrate the mesh, growing the overlap again afterwards
+  void partition(Mesh& mesh);
+
+  /// Replace the partitioner with the one configured in the option "partitioner"
+  void trigger_partitioner();
+
   Handle<MeshTransformer> m_partitioner;
 
 }; // end LoadBalance
@@ -147,6 +147,8 @@ namespace detail
     common::XML::XmlNode field_node = node.add_node("field");
     field_node.set_attribute("name", field.name());
     field_node.set_attribute("description", field.descriptor().description());
+    // Single precision fields are written in double precision
+    DoublePrecisionScope double_precision(const_cast<Field&>(field), false);
     field_node.set_attribute("table_idx", common::to_str(writer.append_data(field)));
     BOOST_FOREACH(const std::string& tag, field.get_tags())
     {
@@ -0,0 +1,367 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_mesh_gausslegendre_TensorProduct_hpp
+#define cf3_mesh_gausslegendre_TensorProduct_hpp
+
+#include <cmath>
+#include <vector>
+
+#include <boost/static_assert.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/StringConversion.hpp"
+
+#include "math/MatrixTypes.hpp"
+
+#include "mesh/gausslegendre/Line.hpp"
+
+namespace cf3 {
+namespace mesh {
+namespace gausslegendre {
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail
+{
+
+/// Compile-time integer power
+template<Uint Base, Uint Exponent>
+struct IntPow
+{
+  enum { value = Base * IntPow<Base, Exponent-1>::value };
+};
+
+template<Uint Base>
+struct IntPow<Base, 0>
+{
+  enum { value = 1 };
+};
+
+/// Apply a 1D matrix along one axis of a tensor stored with the first axis varying slowest.
+/// in has shape [before][cols][after], out gets shape [before][rows][after]
+template<typename MatrixT>
+inline void apply_1d(const MatrixT& mat, const Real* in, Real* out, const Uint before, const Uint after)
+{
+  const Uint rows = mat.rows();
+  const Uint cols = mat.cols();
+  for(Uint b = 0; b != before; ++b)
+  {
+    const Real* in_b = in + b*cols*after;
+    Real* out_b = out + b*rows*after;
+    for(Uint r = 0; r != rows; ++r)
+    {
+      Real* out_r = out_b + r*after;
+      for(Uint a = 0; a != after; ++a)
+        out_r[a] = 0.;
+      for(Uint c = 0; c != cols; ++c)
+      {
+        const Real m = mat(r, c);
+        const Real* in_c = in_b + c*after;
+        for(Uint a = 0; a != after; ++a)
+          out_r[a] += m * in_c[a];
+      }
+    }
+  }
+}
+
+/// Apply the transpose of a 1D matrix along one axis of a tensor.
+/// in has shape [before][rows][after], out gets shape [before][cols][after]
+template<typename MatrixT>
+inline void apply_1d_transposed(const MatrixT& mat, const Real* in, Real* out, const Uint before, const Uint after)
+{
+  const Uint rows = mat.rows();
+  const Uint cols = mat.cols();
+  for(Uint b = 0; b != before; ++b)
+  {
+    const Real* in_b = in + b*rows*after;
+    Real* out_b = out + b*cols*after;
+    for(Uint c = 0; c != cols; ++c)
+    {
+      Real* out_c = out_b + c*after;
+      for(Uint a = 0; a != after; ++a)
+        out_c[a] = 0.;
+      for(Uint r = 0; r != rows; ++r)
+      {
+        const Real m = mat(r, c);
+        const Real* in_r = in_b + r*after;
+        for(Uint a = 0; a != after; ++a)
+          out_c[a] += m * in_r[a];
+      }
+    }
+  }
+}
+
+} // detail
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @class TensorProduct
+/// Sum factorisation for tensor-product elements (Quad and Hexa shape functions of any order), integrated
+/// with a tensor-product Gauss-Legendre rule of Q points per direction.
+/// Values and gradients at the Gauss points are obtained by applying the 1D basis and derivative matrices one
+/// dimension at a time, so the cost per element is O(p^(d+1)) instead of O(p^(2d)) for the dense shape function
+/// matrices. The transposed operations test a quantity at the Gauss points against the shape functions, and together
+/// they allow element operators to be applied without forming the element matrix.
+/// Gauss points are numbered as in gausslegendre::Quad and gausslegendre::Hexa, nodal values follow the node numbering of ElementSF.
+/// @tparam ElementSF The tensor-product shape function, e.g. LagrangeP2::Quad
+/// @tparam LineSF The 1D shape function that ElementSF is the tensor product of, e.g. LagrangeP2::Line
+/// @tparam Q Number of Gauss points in each direction
+template <typename ElementSF, typename LineSF, Uint Q>
+class TensorProduct
+{
+public:
+  enum { dimension    = ElementSF::dimensionality };
+  enum { nb_nodes_1d  = LineSF::nb_nodes };
+  enum { nb_points_1d = Q };
+  enum { nb_nodes     = ElementSF::nb_nodes };
+  enum { nb_points    = detail::IntPow<Q, dimension>::value };
+
+  BOOST_STATIC_ASSERT(static_cast<Uint>(nb_nodes) == static_cast<Uint>(detail::IntPow<nb_nodes_1d, dimension>::value));
+
+  /// 1D matrices, with a row per Gauss point and a column per 1D node
+  typedef Eigen::Matrix<Real, Q, nb_nodes_1d> Matrix1DT;
+  typedef Eigen::Matrix<Real, nb_nodes, 1> NodalValuesT;
+  typedef Eigen::Matrix<Real, nb_nodes, dimension> NodesT;
+  typedef Eigen::Matrix<Real, nb_points, 1> PointValuesT;
+  typedef Eigen::Matrix<Real, dimension, nb_points> PointGradientsT;
+  typedef Eigen::Matrix<Real, dimension, dimension> JacobianT;
+
+  /// Geometric factors of an element at the Gauss points, to be computed once per element using compute_geometry
+  struct Geometry
+  {
+    /// Gauss weight multiplied by the Jacobian determinant
+    PointValuesT weighted_determinant;
+    /// Inverse Jacobian at each point, stored as consecutive blocks of dimension columns
+    Eigen::Matrix<Real, dimension, dimension*nb_points> inverse_jacobians;
+  };
+
+  static const TensorProduct& instance()
+  {
+    static const TensorProduct inst;
+    return inst;
+  }
+
+  /// Values of the 1D shape functions at the 1D Gauss points
+  const Matrix1DT& basis() const { return m_basis; }
+
+  /// Derivatives of the 1D shape functions at the 1D Gauss points
+  const Matrix1DT& derivative() const { return m_derivative; }
+
+  /// Weights of the tensor-product Gauss rule
+  const PointValuesT& weights() const { return m_weights; }
+
+  /// Element node corresponding to the given tensor (lexicographic) node index
+  Uint element_node(const Uint tensor_node) const { return m_element_node[tensor_node]; }
+
+  /// Interpolate nodal values to the Gauss points
+  void interpolate(const NodalValuesT& nodal, PointValuesT& values) const
+  {
+    Real tensor[buffer_size];
+    gather(nodal, tensor);
+    contract(tensor, values.data(), dimension);
+  }
+
+  /// Gradient in mapped coordinates at the Gauss points
+  void gradient(const NodalValuesT& nodal, PointGradientsT& gradients) const
+  {
+    Real tensor[buffer_size];
+    Real result[buffer_size];
+    gather(nodal, tensor);
+    for(Uint d = 0; d != dimension; ++d)
+    {
+      contract(tensor, result, d);
+      for(Uint q = 0; q != nb_points; ++q)
+        gradients(d, q) = result[q];
+    }
+  }
+
+  /// Gradient in physical coordinates at the Gauss points
+  void physical_gradient(const Geometry& geometry, const NodalValuesT& nodal, PointGradientsT& gradients) const
+  {
+    PointGradientsT mapped_gradients;
+    gradient(nodal, mapped_gradients);
+    for(Uint q = 0; q != nb_points; ++q)
+      gradients.col(q).noalias() = geometry.inverse_jacobians.template block<dimension, dimension>(0, dimension*q) * mapped_gradients.col(q);
+  }
+
+  /// Test the values at the Gauss points against each shape function and add the result to nodal, i.e. nodal_i += sum_q N_i(q) values_q
+  void integrate(const PointValuesT& values, NodalValuesT& nodal) const
+  {
+    Real result[buffer_size];
+    contract_transposed(values.data(), result, dimension);
+    scatter(result, nodal);
+  }
+
+  /// Test the vectors at the Gauss points against the mapped gradient of each shape function and add the result to nodal,
+  /// i.e. nodal_i += sum_q grad(N_i)(q) . gradients_q
+  void integrate_gradient(const PointGradientsT& gradients, NodalValuesT& nodal) const
+  {
+    Real component[buffer_size];
+    Real result[buffer_size];
+    for(Uint d = 0; d != dimension; ++d)
+    {
+      for(Uint q = 0; q != nb_points; ++q)
+        component[q] = gradients(d, q);
+      contract_transposed(component, result, d);
+      scatter(result, nodal);
+    }
+  }
+
+  /// Compute the Jacobian related factors for the element with the given node coordinates
+  void compute_geometry(const NodesT& nodes, Geometry& geometry) const
+  {
+    PointGradientsT coordinate_gradients[dimension];
+    for(Uint j = 0; j != dimension; ++j)
+      gradient(nodes.col(j), coordinate_gradients[j]);
+
+    for(Uint q = 0; q != nb_points; ++q)
+    {
+      JacobianT jacobian;
+      for(Uint j = 0; j != dimension; ++j)
+        jacobian.col(j) = coordinate_gradients[j].col(q);
+      geometry.weighted_determinant[q] = m_weights[q] * jacobian.determinant();
+      geometry.inverse_jacobians.template block<dimension, dimension>(0, dimension*q) = jacobian.inverse();
+    }
+  }
+
+  /// Add the product of the element mass matrix with x to y, without building the matrix
+  void apply_mass(const Geometry& geometry, const NodalValuesT& x, NodalValuesT& y) const
+  {
+    PointValuesT values;
+    interpolate(x, values);
+    values.array() *= geometry.weighted_determinant.array();
+    integrate(values, y);
+  }
+
+  /// Add the product of the element Laplacian (stiffness) matrix with x to y, without building the matrix
+  void apply_laplacian(const Geometry& geometry, const NodalValuesT& x, NodalValuesT& y) const
+  {
+    PointGradientsT mapped_gradients;
+    gradient(x, mapped_gradients);
+    for(Uint q = 0; q != nb_points; ++q)
+    {
+      const JacobianT inverse_jacobian = geometry.inverse_jacobians.template block<dimension, dimension>(0, dimension*q);
+      mapped_gradients.col(q) = geometry.weighted_determinant[q] * (inverse_jacobian.transpose() * (inverse_jacobian * mapped_gradients.col(q)));
+    }
+    integrate_gradient(mapped_gradients, y);
+  }
+
+private:
+  enum { buffer_size = detail::IntPow<(Q > nb_nodes_1d ? Q : nb_nodes_1d), dimension>::value };
+
+  TensorProduct()
+  {
+    const typename Line<Q>::LocalCoordsT& roots = Line<Q>::local_coordinates();
+    const typename Line<Q>::WeightsT& weights_1d = Line<Q>::weights();
+
+    for(Uint q = 0; q != Q; ++q)
+    {
+      typename LineSF::MappedCoordsT mapped_coord;
+      mapped_coord[0] = roots[q];
+      typename LineSF::ValueT value;
+      typename LineSF::GradientT grad;
+      LineSF::compute_value(mapped_coord, value);
+      LineSF::compute_gradient(mapped_coord, grad);
+      m_basis.row(q) = value;
+      m_derivative.row(q) = grad;
+    }
+
+    for(Uint q = 0; q != nb_points; ++q)
+    {
+      m_weights[q] = 1.;
+      Uint remainder = q;
+      for(Uint d = 0; d != dimension; ++d)
+      {
+        m_weights[q] *= weights_1d[remainder % Q];
+        remainder /= Q;
+      }
+    }
+
+    // Find the position of each element node in the tensor of 1D nodes
+    const RealMatrix& line_coords = LineSF::local_coordinates();
+    const RealMatrix& element_coords = ElementSF::local_coordinates();
+    std::vector<bool> found(nb_nodes, false);
+    for(Uint n = 0; n != nb_nodes; ++n)
+    {
+      Uint tensor_node = 0;
+      for(Uint d = 0; d != dimension; ++d)
+      {
+        Uint i = 0;
+        while(i != nb_nodes_1d && std::abs(line_coords(i, 0) - element_coords(n, d)) > 1e-10)
+          ++i;
+        if(i == nb_nodes_1d)
+          throw common::SetupError(FromHere(), "Node " + common::to_str(n) + " of " + ElementSF::type_name() + " is not a tensor product of the nodes of " + LineSF::type_name());
+        tensor_node = tensor_node*nb_nodes_1d + i;
+      }
+      if(found[tensor_node])
+        throw common::SetupError(FromHere(), "Duplicate tensor product node for node " + common::to_str(n) + " of " + ElementSF::type_name());
+      found[tensor_node] = true;
+      m_element_node[tensor_node] = n;
+    }
+  }
+
+  /// Nodal values in tensor order
+  void gather(const NodalValuesT& nodal, Real* tensor) const
+  {
+    for(Uint l = 0; l != nb_nodes; ++l)
+      tensor[l] = nodal[m_element_node[l]];
+  }
+
+  /// Add tensor ordered values to the nodal values
+  void scatter(const Real* tensor, NodalValuesT& nodal) const
+  {
+    for(Uint l = 0; l != nb_nodes; ++l)
+      nodal[m_element_node[l]] += tensor[l];
+  }
+
+  /// Evaluate at the Gauss points, using the derivative in the given direction (no derivative if direction == dimension)
+  void contract(const Real* tensor, Real* result, const Uint direction) const
+  {
+    Real buffers[2][buffer_size];
+    const Real* in = tensor;
+    Uint before = 1;
+    Uint after = nb_nodes / nb_nodes_1d;
+    for(Uint d = 0; d != dimension; ++d)
+    {
+      Real* out = d == dimension-1 ? result : buffers[d % 2];
+      detail::apply_1d(d == direction ? m_derivative : m_basis, in, out, before, after);
+      in = out;
+      before *= Q;
+      after /= nb_nodes_1d;
+    }
+  }
+
+  /// Transpose of contract
+  void contract_transposed(const Real* values, Real* result, const Uint direction) const
+  {
+    Real buffers[2][buffer_size];
+    const Real* in = values;
+    Uint before = 1;
+    Uint after = nb_points / Q;
+    for(Uint d = 0; d != dimension; ++d)
+    {
+      Real* out = d == dimension-1 ? result : buffers[d % 2];
+      detail::apply_1d_transposed(d == direction ? m_derivative : m_basis, in, out, before, after);
+      in = out;
+      before *= nb_nodes_1d;
+      after /= Q;
+    }
+  }
+
+  Matrix1DT m_basis;
+  Matrix1DT m_derivative;
+  PointValuesT m_weights;
+  Uint m_element_node[nb_nodes];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // gausslegendre
+} // mesh
+} // cf3
+
+#endif // cf3_mesh_gausslegendre_TensorProduct_hpp
@@ -66,6 +66,7 @@ private: // functions
   SCOTCH_Num vertlocmax;
   SCOTCH_Num edgelocsiz;
   std::vector<SCOTCH_Num> vertloctab;
+  std::vector<SCOTCH_Num> veloloctab; // vertex loads, empty if all vertices have the same weight
   std::vector<SCOTCH_Num> edgeloctab;
   std::vector<SCOTCH_Num> edgegsttab;
   std::vector<SCOTCH_Num> partloctab;
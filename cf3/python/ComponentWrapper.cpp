@@ -18,6 +18,7 @@
 #include "common/OptionT.hpp"
 #include "common/OptionURI.hpp"
 #include "common/OptionList.hpp"
+#include "common/MemoryComponent.hpp"
 #include "common/PropertyList.hpp"
 #include "common/TimedComponent.hpp"
 #include "common/TypeInfo.hpp"
@@ -383,6 +384,16 @@ void print_timing_tree(ComponentWrapper& self)
   cf3::common::print_timing_tree(self.component());
 }
 
+void print_memory_tree(ComponentWrapper& self)
+{
+  cf3::common::print_memory_tree(self.component());
+}
+
+Real memory_footprint(ComponentWrapper& self)
+{
+  return static_cast<Real>(cf3::common::memory_footprint(self.component()));
+}
+
 void store_timings(ComponentWrapper& self)
 {
   cf3::common::store_timings(self.component());
@@ -713,6 +724,8 @@ void def_component()
     .def("access_component", access_component_uri)
     .def("access_component", access_component_str)
     .def("print_timing_tree", print_timing_tree)
+    .def("print_memory_tree", print_memory_tree)
+    .def("memory_footprint", memory_footprint)
     .def("store_timings", store_timings)
     .add_property("options", component_options)
     .add_property("properties", component_properties)
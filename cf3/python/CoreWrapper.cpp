@@ -55,8 +55,9 @@ struct CoreWrapper
         arg_i.copy(argv[i], arg_i.size());
       }
 
-      common::Core::instance().initiate(argc, argv);
+      // Initialize MPI first, so the library manifest is read by rank 0 only
       common::PE::Comm::instance().init(argc, argv);
+      common::Core::instance().initiate(argc, argv);
     }
   }
 
@@ -75,6 +76,26 @@ struct CoreWrapper
     common::PE::Comm::instance().barrier();
   }
 
+  static void split(const int color)
+  {
+    common::PE::Comm::instance().split(color);
+  }
+
+  static int color()
+  {
+    return common::PE::Comm::instance().color();
+  }
+
+  static Uint world_rank()
+  {
+    return common::PE::Comm::instance().world_rank();
+  }
+
+  static Uint world_nb_procs()
+  {
+    return common::PE::Comm::instance().world_size();
+  }
+
   static void terminate()
   {
     common::Core::instance().terminate();
@@ -107,6 +128,14 @@ void def_core()
     .staticmethod("nb_procs")
     .def("barrier", CoreWrapper::barrier)
     .staticmethod("barrier")
+    .def("split", CoreWrapper::split, "Split the processes into groups with the same color, that each run their own model")
+    .staticmethod("split")
+    .def("color", CoreWrapper::color)
+    .staticmethod("color")
+    .def("world_rank", CoreWrapper::world_rank)
+    .staticmethod("world_rank")
+    .def("world_nb_procs", CoreWrapper::world_nb_procs)
+    .staticmethod("world_nb_procs")
     .def("wait_for_debugger", CoreWrapper::wait_for_debugger)
     .staticmethod("wait_for_debugger");
 }
@@ -11,6 +11,7 @@
 #include <boost/weak_ptr.hpp>
 
 #include "common/Log.hpp"
+#include "common/OptionList.hpp"
 #include "common/StreamHelpers.hpp"
 
 #include "common/Table.hpp"
@@ -75,11 +76,13 @@ struct TableList : PythonListInterface
 
   virtual Uint len() const
   {
+    check_precision();
     return m_table.size();
   }
 
   virtual object get_item(const Uint i) const
   {
+    check_precision();
     if(i >= m_table.size())
     {
       PyErr_SetString(PyExc_IndexError, ("Index " + boost::lexical_cast<std::string>(i) + " is out of range for Table with number of rows: " + boost::lexical_cast<std::string>(m_table.size())).c_str());
@@ -93,6 +96,7 @@ struct TableList : PythonListInterface
     list& values = static_cast<list&>(value);
     const Uint nb_values = boost::python::len(values);
 
+    check_precision();
     if(i >= m_table.size())
       throw common::BadValue(FromHere(), "Index " + boost::lexical_cast<std::string>(i) + " is out of range for Table with number of rows: " + boost::lexical_cast<std::string>(m_table.size()));
     if(nb_values != m_table.row_size())
@@ -105,11 +109,19 @@ struct TableList : PythonListInterface
 
   virtual std::string to_str() const
   {
+    check_precision();
     std::stringstream out_stream;
     out_stream << m_table;
     return out_stream.str();
   }
 
+  /// Fields that are stored in single precision have no rows in the Table interface
+  void check_precision() const
+  {
+    if(m_table.options().check("single_precision") && m_table.options().template value<bool>("single_precision"))
+      throw common::NotSupported(FromHere(), "Table " + m_table.uri().path() + " is stored in single precision, set its single_precision option to False to access the values");
+  }
+
   TableT& m_table;
 };
 
@@ -4,6 +4,8 @@
 // GNU Lesser General Public License version 3 (LGPLv3).
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
 #include "common/Builder.hpp"
 #include "common/FindComponents.hpp"
 #include "common/OptionList.hpp"
@@ -14,6 +16,7 @@
 #include "mesh/Connectivity.hpp"
 #include "mesh/ShapeFunction.hpp"
 #include "mesh/Dictionary.hpp"
+#include "mesh/ElementCost.hpp"
 
 #include "solver/ComputeRHS.hpp"
 #include "solver/Term.hpp"
@@ -31,6 +34,9 @@ namespace solver {
 
 common::ComponentBuilder < ComputeRHS, common::Action, solver::LibSolver > ComputeRHS_Builder;
 
+/// Number of elements between two reads of the clock when measuring the element cost
+static const Uint cost_batch_size = 64;
+
 ////////////////////////////////////////////////////////////////////////////////
 
 ComputeRHS::ComputeRHS ( const std::string& name ) : common::Action(name)
@@ -105,10 +111,17 @@ void ComputeRHS::compute_rhs(const Uint elem_idx, std::vector<RealVector>& rhs,
 ////////////////////////////////////////////////////////////////////////////////
 
 void ComputeRHS::compute_rhs(mesh::Field& rhs, mesh::Field& wave_speed)
+{
+  compute_rhs(rhs, wave_speed, rhs.dict().entities_range());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ComputeRHS::compute_rhs(mesh::Field& rhs, mesh::Field& wave_speed, const std::vector< Handle<mesh::Entities> >& entities)
 {
   const Uint nb_eqs = rhs.row_size();
   mesh::Dictionary& dict = rhs.dict();
-  boost_foreach(const Handle<mesh::Entities>& cells, dict.entities_range() )
+  boost_foreach(const Handle<mesh::Entities>& cells, entities )
   {
     if ( loop_cells(cells) )
     {
@@ -121,9 +134,26 @@ void ComputeRHS::compute_rhs(mesh::Field& rhs, mesh::Field& wave_speed)
       std::vector<RealVector> elem_rhs(nb_sol_pts,RealVector(nb_eqs));
       std::vector<Real> elem_wave_speed(nb_sol_pts);
 
-      for (Uint elem_idx=0; elem_idx<nb_elems; ++elem_idx)
+      // Measure the time per element, if requested for load balancing
+      const Handle< common::List<Real> > cost = element_cost(*cells);
+      boost::posix_time::ptime batch_start;
+
+      for (Uint batch_begin=0; batch_begin<nb_elems; batch_begin+=cost_batch_size)
       {
-        if (cells->is_ghost(elem_idx)==false)
+        const Uint batch_end = std::min(nb_elems, batch_begin+cost_batch_size);
+        m_batch_elems.clear();
+        for (Uint elem_idx=batch_begin; elem_idx<batch_end; ++elem_idx)
+        {
+          if (cells->is_ghost(elem_idx)==false)
+            m_batch_elems.push_back(elem_idx);
+        }
+        if (m_batch_elems.empty())
+          continue;
+
+        if (is_not_null(cost))
+          batch_start = boost::posix_time::microsec_clock::universal_time();
+
+        boost_foreach(const Uint elem_idx, m_batch_elems)
         {
           compute_rhs(elem_idx,elem_rhs,elem_wave_speed);
 
@@ -137,6 +167,12 @@ void ComputeRHS::compute_rhs(mesh::Field& rhs, mesh::Field& wave_speed)
             wave_speed[nodes[sol_pt]][0] = elem_wave_speed[sol_pt];
           }
         }
+
+        if (is_not_null(cost))
+        {
+          const Real batch_time = 1e-6*static_cast<Real>((boost::posix_time::microsec_clock::universal_time() - batch_start).total_microseconds());
+          add_element_cost(*cost, &m_batch_elems[0], &m_batch_elems[0]+m_batch_elems.size(), batch_time);
+        }
       }
     }
   }
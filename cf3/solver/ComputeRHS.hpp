@@ -33,6 +33,9 @@ namespace solver {
 ////////////////////////////////////////////////////////////////////////////////
 
 /// @brief Compute Right-Hand-Side of a PDE
+///
+/// The element loop calls the virtual per-element compute_rhs(), so derived classes can
+/// change the rhs of an element and still use the loop over the fields.
 /// @author Willem Deconinck
 class solver_API ComputeRHS : public common::Action
 {
@@ -61,6 +64,11 @@ public:
   /// @brief Compute the complete rhs in a field, as well as wave speeds
   virtual void compute_rhs(mesh::Field& rhs, mesh::Field& wave_speed);
 
+  /// @brief Compute the rhs and wave speeds for the given entities only
+  ///
+  /// Values at nodes not used by these entities are left untouched
+  void compute_rhs(mesh::Field& rhs, mesh::Field& wave_speed, const std::vector< Handle<mesh::Entities> >& entities);
+
 private:
 
   Handle< mesh::Field > m_rhs;  ///! Right hand side field
@@ -71,6 +79,9 @@ private:
 
   std::vector< RealVector > m_tmp_term;
   std::vector< Real > m_tmp_ws;
+
+  /// Non-ghost elements of the batch that is being timed
+  std::vector< Uint > m_batch_elems;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
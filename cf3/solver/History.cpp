@@ -40,6 +40,12 @@ History::History ( const std::string& name ) :
       .link_to(&m_logging)
       .mark_basic();
 
+  m_flush_interval = 1;
+  m_nb_unflushed = 0;
+  options().add("flush_interval",m_flush_interval)
+      .description("Number of entries between flushes of the log file")
+      .link_to(&m_flush_interval);
+
   // Extension TSV for "Tab Separated Values"
   options().add("file",URI("history.tsv"))
       .description("Log file for history")
@@ -148,7 +154,11 @@ void History::save_entry()
       else
       {
         m_file << this_entry << "\n";
-        m_file.flush();
+        if (++m_nb_unflushed >= m_flush_interval)
+        {
+          m_file.flush();
+          m_nb_unflushed = 0;
+        }
       }
     }
   }
@@ -32,7 +32,7 @@ class HistoryEntry;
 ///
 /// History is stored internally using a common::Table<Real> .
 /// An optional (default=ON) logging facility is provided to log the history to
-/// file at every new entry.
+/// file at every new entry. The file is flushed every flush_interval entries.
 /// The file format is Tab Separated Values (extension tsv)
 ///
 /// Any number of variables can be added after logging started. This will cause
@@ -148,6 +148,10 @@ private: // data
   /// Log file handle
   boost::filesystem::fstream m_file;
 
+  /// Number of entries between flushes of the log file, and the number of entries written since the last flush
+  Uint m_flush_interval;
+  Uint m_nb_unflushed;
+
   /// Handle to the table
   Handle< common::Table<Real> > m_table;
 
@@ -0,0 +1,405 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include "common/Builder.hpp"
+#include "common/OptionList.hpp"
+#include "common/OptionComponent.hpp"
+#include "common/ActionDirector.hpp"
+#include "common/FindComponents.hpp"
+#include "common/List.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Entities.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Functions.hpp"
+
+#include "solver/LowStorageRungeKutta.hpp"
+#include "solver/ComputeRHS.hpp"
+#include "solver/PDE.hpp"
+#include "solver/Time.hpp"
+#include "solver/TimeStepComputer.hpp"
+
+using namespace cf3::common;
+using namespace cf3::mesh;
+
+namespace cf3 {
+namespace solver {
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+common::ComponentBuilder < LowStorageRungeKutta, common::Action, LibSolver > LowStorageRungeKutta_Builder;
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+LowStorageRungeKutta::LowStorageRungeKutta( const std::string& name ) :
+  PDESolver(name),
+  m_shu_osher(false),
+  m_nb_subcycles(1u),
+  m_setup_needed(true)
+{
+  Option& scheme = options().add( "scheme", std::string("SSPRK33") )
+      .description("Runge-Kutta scheme")
+      .pretty_name("Scheme")
+      .attach_trigger( boost::bind( &LowStorageRungeKutta::config_scheme, this) )
+      .mark_basic();
+  scheme.restricted_list().push_back(std::string("ForwardEuler"));
+  scheme.restricted_list().push_back(std::string("SSPRK22"));
+  scheme.restricted_list().push_back(std::string("SSPRK33"));
+  scheme.restricted_list().push_back(std::string("RK3Williamson"));
+  scheme.restricted_list().push_back(std::string("RK4CarpenterKennedy"));
+
+  options().add( "subcycle_regions", m_subcycle_regions )
+      .description("Regions that take several smaller time steps for every time step of the rest of the domain")
+      .link_to(&m_subcycle_regions)
+      .attach_trigger( boost::bind( &LowStorageRungeKutta::config_subcycling, this) );
+
+  options().add( "nb_subcycles", m_nb_subcycles )
+      .description("Number of time steps taken in the subcycle_regions per time step")
+      .link_to(&m_nb_subcycles)
+      .attach_trigger( boost::bind( &LowStorageRungeKutta::config_subcycling, this) );
+
+  options().option("pde").attach_trigger( boost::bind( &LowStorageRungeKutta::config_subcycling, this) );
+
+  config_scheme();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+void LowStorageRungeKutta::config_scheme()
+{
+  const std::string scheme = options().value<std::string>("scheme");
+  m_shu_osher = false;
+  if (scheme == "ForwardEuler")
+  {
+    m_a.assign(1, 0.);
+    m_b.assign(1, 1.);
+    m_c.assign(1, 0.);
+  }
+  else if (scheme == "SSPRK22")
+  {
+    const Real a[] = { 0., -1. };
+    const Real b[] = { 1., 0.5 };
+    const Real c[] = { 0., 1. };
+    m_a.assign(a, a+2);
+    m_b.assign(b, b+2);
+    m_c.assign(c, c+2);
+  }
+  else if (scheme == "SSPRK33")
+  {
+    // Shu-Osher form: alpha in m_a, beta in m_b
+    m_shu_osher = true;
+    const Real alpha[] = { 1., 1./4., 2./3. };
+    const Real beta[]  = { 1., 1./4., 2./3. };
+    const Real c[]     = { 0., 1., 1./2. };
+    m_a.assign(alpha, alpha+3);
+    m_b.assign(beta, beta+3);
+    m_c.assign(c, c+3);
+  }
+  else if (scheme == "RK3Williamson")
+  {
+    const Real a[] = { 0., -5./9., -153./128. };
+    const Real b[] = { 1./3., 15./16., 8./15. };
+    const Real c[] = { 0., 1./3., 3./4. };
+    m_a.assign(a, a+3);
+    m_b.assign(b, b+3);
+    m_c.assign(c, c+3);
+  }
+  else if (scheme == "RK4CarpenterKennedy")
+  {
+    const Real a[] = { 0.,
+                       -567301805773./1357537059087.,
+                       -2404267990393./2016746695238.,
+                       -3550918686646./2091501179385.,
+                       -1275806237668./842570457699. };
+    const Real b[] = { 1432997174477./9575080441755.,
+                       5161836677717./13612068292357.,
+                       1720146321549./2090206949498.,
+                       3134564353537./4481467310338.,
+                       2277821191437./14882151754819. };
+    const Real c[] = { 0.,
+                       1432997174477./9575080441755.,
+                       2526269341429./6820363962896.,
+                       2006345519317./3224310063776.,
+                       2802321613138./2924317926251. };
+    m_a.assign(a, a+5);
+    m_b.assign(b, b+5);
+    m_c.assign(c, c+5);
+  }
+  else
+  {
+    throw BadValue(FromHere(), "Runge-Kutta scheme \""+scheme+"\" is not available in "+uri().string());
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+void LowStorageRungeKutta::config_subcycling()
+{
+  m_setup_needed = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+void LowStorageRungeKutta::setup()
+{
+  if ( is_null(m_pde) ) throw SetupError(FromHere(), "PDE is not configured in "+uri().string());
+  if ( is_null(m_pde->fields()) || is_null(m_pde->solution()) || is_null(m_pde->rhs()) )
+    throw SetupError(FromHere(), "Fields of PDE "+m_pde->uri().string()+" are not created");
+  if ( is_null(m_pde->time()) ) throw InvalidStructure(FromHere(), "PDE does not have time term");
+
+  Dictionary& dict = *m_pde->fields();
+
+  if ( is_null(m_register) || &m_register->dict() != &dict )
+  {
+    if ( Handle<Component> found = dict.get_child("rk_register") )
+      m_register = found->handle<Field>();
+    else
+      m_register = dict.create_field("rk_register",m_pde->nb_eqs()).handle<Field>();
+  }
+
+  if ( is_null(m_time_step) || &m_time_step->dict() != &dict )
+  {
+    if ( Handle<Component> found = dict.get_child("time_step") )
+      m_time_step = found->handle<Field>();
+    else
+      m_time_step = dict.create_field("time_step",1u).handle<Field>();
+  }
+
+  m_time_step_computer->options().set("time_step",m_time_step);
+  m_time_step_computer->options().set("wave_speed",m_pde->wave_speed());
+  m_time_step_computer->options().set("time",m_pde->time());
+
+  if ( !m_setup_needed && m_coarse_nodes.size() + m_fine_nodes.size() == dict.size() )
+    return;
+
+  m_all_entities = dict.entities_range();
+  m_fine_entities.clear();
+  m_coarse_nodes.clear();
+  m_fine_nodes.clear();
+  m_interface_nodes.clear();
+
+  // Find the sub-cycled entities
+  if (m_nb_subcycles > 1)
+  {
+    boost_foreach( const Handle<Component>& region, m_subcycle_regions )
+    {
+      if ( is_null(region) ) throw SetupError(FromHere(), "Invalid subcycle region in "+uri().string());
+      std::vector< Handle<Entities> > region_entities;
+      if ( Handle<Entities> entities = Handle<Entities>(region) )
+        region_entities.push_back(entities);
+      boost_foreach( Entities& entities, find_components_recursively<Entities>(*region) )
+        region_entities.push_back(entities.handle<Entities>());
+
+      boost_foreach( const Handle<Entities>& entities, region_entities )
+      {
+        if ( dict.defined_for_entities(entities)
+             && std::find(m_fine_entities.begin(), m_fine_entities.end(), entities) == m_fine_entities.end() )
+          m_fine_entities.push_back(entities);
+      }
+    }
+  }
+
+  if (m_fine_entities.empty())
+  {
+    m_coarse_nodes.resize(dict.size());
+    for (Uint n=0; n<dict.size(); ++n)
+      m_coarse_nodes[n] = n;
+  }
+  else
+  {
+    std::vector< Handle<Entities const> > fine_entities, coarse_entities;
+    boost_foreach( const Handle<Entities>& entities, m_all_entities )
+    {
+      if ( std::find(m_fine_entities.begin(), m_fine_entities.end(), entities) == m_fine_entities.end() )
+        coarse_entities.push_back(Handle<Entities const>(entities));
+      else
+        fine_entities.push_back(Handle<Entities const>(entities));
+    }
+
+    std::vector<bool> used_by_fine(dict.size(), false);
+    std::vector<bool> used_by_coarse(dict.size(), false);
+    const boost::shared_ptr< List<Uint> > fine_used = build_used_nodes_list(fine_entities, dict, true, false);
+    for (Uint i=0; i<fine_used->size(); ++i)
+      used_by_fine[(*fine_used)[i]] = true;
+    const boost::shared_ptr< List<Uint> > coarse_used = build_used_nodes_list(coarse_entities, dict, true, false);
+    for (Uint i=0; i<coarse_used->size(); ++i)
+      used_by_coarse[(*coarse_used)[i]] = true;
+
+    for (Uint n=0; n<dict.size(); ++n)
+    {
+      if (used_by_fine[n] && !used_by_coarse[n])
+        m_fine_nodes.push_back(n);
+      else
+        m_coarse_nodes.push_back(n);
+      if (used_by_fine[n] && used_by_coarse[n])
+        m_interface_nodes.push_back(n);
+    }
+  }
+
+  m_setup_needed = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+void LowStorageRungeKutta::step()
+{
+  Time& time = *m_pde->time();
+  Field& solution = *m_pde->solution();
+  const Uint nb_eqs = solution.row_size();
+  const Real t0 = time.current_time();
+
+  if (m_fine_nodes.empty())
+  {
+    rk_step(m_all_entities, m_coarse_nodes, 1., t0, true);
+  }
+  else
+  {
+    // Coarse step, leaving the nodes interior to the sub-cycled regions untouched
+    m_interface_begin.resize(m_interface_nodes.size()*nb_eqs);
+    m_interface_end.resize(m_interface_nodes.size()*nb_eqs);
+    for (Uint i=0; i<m_interface_nodes.size(); ++i)
+      for (Uint eq=0; eq<nb_eqs; ++eq)
+        m_interface_begin[i*nb_eqs+eq] = solution[m_interface_nodes[i]][eq];
+
+    rk_step(m_all_entities, m_coarse_nodes, 1., t0, true);
+
+    for (Uint i=0; i<m_interface_nodes.size(); ++i)
+      for (Uint eq=0; eq<nb_eqs; ++eq)
+        m_interface_end[i*nb_eqs+eq] = solution[m_interface_nodes[i]][eq];
+
+    // Sub-cycles, computing the rhs only in the sub-cycled regions
+    const Real fraction = 1./static_cast<Real>(m_nb_subcycles);
+    const Real dt = time.dt();
+    for (Uint subcycle=0; subcycle<m_nb_subcycles; ++subcycle)
+    {
+      const Real theta0 = subcycle*fraction;
+      rk_step(m_fine_entities, m_fine_nodes, fraction, t0 + theta0*dt, false, theta0, fraction);
+    }
+    interpolate_interface(1.);
+  }
+
+  time.current_time() = t0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+void LowStorageRungeKutta::rk_step(const std::vector< Handle<mesh::Entities> >& entities,
+                                   const std::vector<Uint>& nodes,
+                                   const Real factor,
+                                   const Real t0,
+                                   const bool compute_time_step,
+                                   const Real theta0,
+                                   const Real dtheta)
+{
+  Time& time = *m_pde->time();
+  Field& U = *m_pde->solution();
+  Field& R = *m_pde->rhs();
+  Field& wave_speed = *m_pde->wave_speed();
+  Field& reg = *m_register;
+  Field& time_step = *m_time_step;
+  const Uint nb_eqs = U.row_size();
+  const Uint nb_nodes = nodes.size();
+
+  if (m_shu_osher)
+  {
+    for (Uint i=0; i<nb_nodes; ++i)
+    {
+      const Uint n = nodes[i];
+      for (Uint eq=0; eq<nb_eqs; ++eq)
+        reg[n][eq] = U[n][eq];
+    }
+  }
+
+  for (Uint stage=0; stage<m_c.size(); ++stage)
+  {
+    time.current_time() = t0 + m_c[stage]*factor*time.dt();
+    if (dtheta != 0.)
+      interpolate_interface(theta0 + m_c[stage]*dtheta);
+
+    if (m_pre_update) m_pre_update->execute();
+
+    m_pde->rhs_computer()->compute_rhs(R, wave_speed, entities);
+
+    if (stage == 0 && compute_time_step)
+    {
+      // Nodes in sub-cycled regions don't limit the time step of the rest of the domain
+      const Real fraction = 1./static_cast<Real>(m_nb_subcycles);
+      for (Uint i=0; i<m_fine_nodes.size(); ++i)
+        wave_speed[m_fine_nodes[i]][0] *= fraction;
+      m_time_step_computer->execute();
+      for (Uint i=0; i<m_fine_nodes.size(); ++i)
+        wave_speed[m_fine_nodes[i]][0] *= m_nb_subcycles;
+    }
+
+    const Real a = m_a[stage];
+    const Real b = m_b[stage];
+    if (m_shu_osher)
+    {
+      // U = a U + (1-a) U0 + b dt R
+      for (Uint i=0; i<nb_nodes; ++i)
+      {
+        const Uint n = nodes[i];
+        const Real dt = b*factor*time_step[n][0];
+        for (Uint eq=0; eq<nb_eqs; ++eq)
+          U[n][eq] = a*U[n][eq] + (1.-a)*reg[n][eq] + dt*R[n][eq];
+      }
+    }
+    else if (a == 0.)
+    {
+      // dU = dt R,  U = U + b dU
+      for (Uint i=0; i<nb_nodes; ++i)
+      {
+        const Uint n = nodes[i];
+        const Real dt = factor*time_step[n][0];
+        for (Uint eq=0; eq<nb_eqs; ++eq)
+        {
+          reg[n][eq] = dt*R[n][eq];
+          U[n][eq] += b*reg[n][eq];
+        }
+      }
+    }
+    else
+    {
+      // dU = a dU + dt R,  U = U + b dU
+      for (Uint i=0; i<nb_nodes; ++i)
+      {
+        const Uint n = nodes[i];
+        const Real dt = factor*time_step[n][0];
+        for (Uint eq=0; eq<nb_eqs; ++eq)
+        {
+          reg[n][eq] = a*reg[n][eq] + dt*R[n][eq];
+          U[n][eq] += b*reg[n][eq];
+        }
+      }
+    }
+
+    U.synchronize();
+
+    if (m_post_update) m_post_update->execute();
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+void LowStorageRungeKutta::interpolate_interface(const Real theta)
+{
+  Field& solution = *m_pde->solution();
+  const Uint nb_eqs = solution.row_size();
+  for (Uint i=0; i<m_interface_nodes.size(); ++i)
+  {
+    const Uint n = m_interface_nodes[i];
+    for (Uint eq=0; eq<nb_eqs; ++eq)
+    {
+      const Uint idx = i*nb_eqs+eq;
+      solution[n][eq] = (1.-theta)*m_interface_begin[idx] + theta*m_interface_end[idx];
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+} // solver
+} // cf3
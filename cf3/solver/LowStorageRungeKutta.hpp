@@ -0,0 +1,137 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_LowStorageRungeKutta_hpp
+#define cf3_solver_LowStorageRungeKutta_hpp
+
+#include "solver/PDESolver.hpp"
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+// Forward declarations
+namespace cf3 {
+  namespace mesh {
+    class Entities;
+    class Field;
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace solver {
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Explicit low-storage Runge-Kutta time integration of a PDE
+///
+/// Schemes in Williamson 2N form only need one register besides the solution and the rhs:
+/// @f[ dU = a_k\ dU + \Delta t\ R(U), \qquad U = U + b_k\ dU @f]
+/// The three-stage SSP scheme has no 2N form and is written in the two-register Shu-Osher form
+/// @f[ U = \alpha_k\ U + (1-\alpha_k)\ U^n + \beta_k\ \Delta t\ R(U) @f]
+/// where the register holds @f$ U^n @f$. Available schemes (option "scheme"):
+/// - ForwardEuler
+/// - SSPRK22 : 2nd order, SSP, 2N
+/// - SSPRK33 : 3rd order, SSP, Shu-Osher form
+/// - RK3Williamson : 3rd order, 2N
+/// - RK4CarpenterKennedy : 4th order with 5 stages, 2N
+///
+/// The time step is taken per node from the "time_step" field computed by the time step computer,
+/// so that with "time_accurate" set to false in the time step computer each node advances with
+/// its own time step given by the local wave speed (local time-stepping).
+///
+/// Regions listed in "subcycle_regions" are sub-cycled (multi-rate stepping): the rest of the
+/// domain takes one step, after which the nodes only used by the sub-cycled regions take
+/// "nb_subcycles" steps of a fraction of the time step. The rhs is then only computed for the
+/// sub-cycled elements, and nodes shared with the rest of the domain are interpolated linearly in
+/// time. The time step computer sees the wave speed of the sub-cycled nodes divided by "nb_subcycles",
+/// so that the global time step is not restricted by them.
+class solver_API LowStorageRungeKutta : public PDESolver {
+
+public: // functions
+
+  /// Contructor
+  /// @param name of the component
+  LowStorageRungeKutta ( const std::string& name );
+
+  /// Virtual destructor
+  virtual ~LowStorageRungeKutta() {}
+
+  /// Get the class name
+  static std::string type_name () { return "LowStorageRungeKutta"; }
+
+  virtual void setup();
+
+  virtual void step();
+
+  /// Number of stages of the configured scheme
+  Uint nb_stages() const { return m_c.size(); }
+
+private: // functions
+
+  void config_scheme();
+
+  void config_subcycling();
+
+  /// One step of the scheme for the given nodes, with the nodal time step scaled by factor
+  /// @param entities  elements for which the rhs is computed
+  /// @param nodes     nodes that are updated
+  /// @param factor    fraction of the nodal time step
+  /// @param t0        time at the start of the step
+  /// @param compute_time_step  run the time step computer after the first rhs evaluation
+  /// @param theta0    interface interpolation parameter at the start of the step
+  /// @param dtheta    increase of the interface interpolation parameter over the step,
+  ///                  zero if the interface nodes are not interpolated
+  void rk_step(const std::vector< Handle<mesh::Entities> >& entities,
+               const std::vector<Uint>& nodes,
+               const Real factor,
+               const Real t0,
+               const bool compute_time_step,
+               const Real theta0 = 0.,
+               const Real dtheta = 0.);
+
+  /// Set the interface nodes to the linear interpolation between the start and end state
+  void interpolate_interface(const Real theta);
+
+private: // data
+
+  /// Williamson coefficients, or Shu-Osher alpha in m_a and beta in m_b
+  std::vector<Real> m_a;
+  std::vector<Real> m_b;
+  /// Stage times, as fraction of the time step
+  std::vector<Real> m_c;
+  /// True if the scheme is in Shu-Osher form
+  bool m_shu_osher;
+
+  Handle<mesh::Field> m_register;
+  Handle<mesh::Field> m_time_step;
+
+  Uint m_nb_subcycles;
+  std::vector< Handle<common::Component> > m_subcycle_regions;
+
+  /// All entities of the pde fields, and the sub-cycled ones
+  std::vector< Handle<mesh::Entities> > m_all_entities;
+  std::vector< Handle<mesh::Entities> > m_fine_entities;
+
+  /// Nodes updated in the coarse step, in the sub-cycles, and nodes shared between both
+  std::vector<Uint> m_coarse_nodes;
+  std::vector<Uint> m_fine_nodes;
+  std::vector<Uint> m_interface_nodes;
+
+  /// Interface solution at the start and end of the coarse step, stored interface node by interface node
+  std::vector<Real> m_interface_begin;
+  std::vector<Real> m_interface_end;
+
+  /// True if setup() must rebuild the node lists
+  bool m_setup_needed;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+} // solver
+} // cf3
+
+#endif // cf3_solver_LowStorageRungeKutta_hpp
@@ -6,21 +6,143 @@
 
 #include "common/Builder.hpp"
 #include "common/OptionList.hpp"
+#include "common/ThreadPool.hpp"
 #include "mesh/Entities.hpp"
 #include "mesh/Field.hpp"
+#include "mesh/Functions.hpp"
 #include "mesh/Space.hpp"
 #include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
 #include "solver/TermComputer.hpp"
 
 /////////////////////////////////////////////////////////////////////////////////////
 
 namespace cf3 {
 namespace solver {
-  
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/// Number of elements computed in one call to compute_terms()
+const Uint batch_size = 64;
+
+/// Computes the terms for a range of elements from one group and scatters them to the nodes
+struct ScatterTerms
+{
+  ScatterTerms(TermComputer& a_computer,
+               const std::vector<Uint>& a_elems,
+               const mesh::Connectivity& a_connectivity,
+               mesh::Field& a_term,
+               mesh::Field& a_wave_speed,
+               std::vector<TermBatch>& a_batches) :
+    computer(a_computer),
+    elems(a_elems),
+    connectivity(a_connectivity),
+    term(a_term),
+    wave_speed(a_wave_speed),
+    batches(a_batches)
+  {
+  }
+
+  void operator()(const Uint begin, const Uint end, const Uint thread) const
+  {
+    TermBatch& batch = batches[thread];
+    const Uint nb_nodes = connectivity.row_size();
+    const Uint nb_eqs = term.row_size();
+    for(Uint batch_begin = begin; batch_begin < end; batch_begin += batch_size)
+    {
+      const Uint batch_end = std::min(end, batch_begin + batch_size);
+      batch.resize(batch_end - batch_begin, nb_nodes, nb_eqs);
+      computer.compute_terms(&elems[batch_begin], &elems[0] + batch_end, batch);
+      for(Uint i = 0; i != batch.nb_elems(); ++i)
+      {
+        mesh::Connectivity::ConstRow nodes = connectivity[elems[batch_begin+i]];
+        const Real* elem_term = batch.term(i);
+        const Real* elem_ws = batch.wave_speed(i);
+        for(Uint s = 0; s != nb_nodes; ++s)
+        {
+          const Uint p = nodes[s];
+          for(Uint eq = 0; eq != nb_eqs; ++eq)
+            term[p][eq] += elem_term[s*nb_eqs+eq];
+          wave_speed[p][0] = std::max(wave_speed[p][0], elem_ws[s]);
+        }
+      }
+    }
+  }
+
+  TermComputer& computer;
+  const std::vector<Uint>& elems;
+  const mesh::Connectivity& connectivity;
+  mesh::Field& term;
+  mesh::Field& wave_speed;
+  std::vector<TermBatch>& batches;
+};
+
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void TermBatch::resize(const Uint nb_elems, const Uint nb_nodes, const Uint nb_eqs)
+{
+  m_nb_elems = nb_elems;
+  m_nb_nodes = nb_nodes;
+  m_nb_eqs = nb_eqs;
+  if(m_terms.size() < nb_elems*nb_nodes*nb_eqs)
+    m_terms.resize(nb_elems*nb_nodes*nb_eqs);
+  if(m_wave_speeds.size() < nb_elems*nb_nodes)
+    m_wave_speeds.resize(nb_elems*nb_nodes);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+const std::vector< std::vector<Uint> >& ElementGroupCache::groups(const mesh::Space& space, const bool colored)
+{
+  const mesh::Connectivity& connectivity = space.connectivity();
+  const Uint nb_elems = connectivity.size();
+
+  Entry* entry = nullptr;
+  for(Uint i = 0; i != m_entries.size(); ++i)
+  {
+    if(m_entries[i].connectivity.get() == &connectivity)
+    {
+      entry = &m_entries[i];
+      break;
+    }
+  }
+
+  if(is_null(entry))
+  {
+    m_entries.push_back(Entry());
+    entry = &m_entries.back();
+    entry->connectivity = connectivity.handle<mesh::Connectivity>();
+  }
+  else if(entry->nb_elems == nb_elems && entry->colored == colored)
+  {
+    return entry->groups;
+  }
+
+  entry->nb_elems = nb_elems;
+  entry->colored = colored;
+  if(colored)
+  {
+    mesh::build_element_colors(connectivity, space.dict().size(), entry->groups);
+  }
+  else
+  {
+    entry->groups.assign(1, std::vector<Uint>(nb_elems));
+    for(Uint e = 0; e != nb_elems; ++e)
+      entry->groups[0][e] = e;
+  }
+
+  return entry->groups;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////
 
-TermComputer::TermComputer ( const std::string& name ) 
-  : common::Action(name) 
+TermComputer::TermComputer ( const std::string& name )
+  : common::Action(name)
 {
   options().add("field",m_term_field).link_to(&m_term_field)
     .description("Term that will be computed")
@@ -36,7 +158,7 @@ void TermComputer::execute()
 {
   if ( is_null(m_term_field) )  throw common::SetupError( FromHere(), "term not configured" );
   if ( is_null(m_term_ws) )     throw common::SetupError( FromHere(), "term_wave_speed not configured" );
-  
+
   compute_term(*m_term_field,*m_term_ws);
 }
 
@@ -45,30 +167,50 @@ void TermComputer::execute()
 void TermComputer::compute_term(mesh::Field& term, mesh::Field& wave_speed)
 {
   term = 0.;
+  wave_speed = 0.;
+
+  common::ThreadPool& thread_pool = common::ThreadPool::instance();
+  const bool threaded = thread_safe() && thread_pool.nb_threads() > 1;
+  m_batches.resize(threaded ? thread_pool.nb_threads() : 1);
+
   boost_foreach( const Handle<mesh::Entities const>& cells, term.entities_range() )
   {
     if (loop_cells(cells))
     {
       const mesh::Space& space = term.space(*cells);
-      const Uint nb_elems = space.size();
-      const Uint nb_nodes_per_elem = space.shape_function().nb_nodes();
-      for (Uint e=0; e<nb_elems; ++e)
+      boost_foreach( const std::vector<Uint>& group, m_groups.groups(space, threaded) )
       {
-        compute_term(e,m_tmp_term,m_tmp_ws);
-        for (Uint s=0; s<nb_nodes_per_elem; ++s)
-        {
-          const Uint p=space.connectivity()[e][s];
-          for (Uint eq=0; eq<m_tmp_term[s].size(); ++eq)
-          {
-            term[p][eq] += m_tmp_term[s][eq];
-          }
-          wave_speed[p][0] = m_tmp_ws[s]; 
-        }
+        ScatterTerms scatter(*this, group, space.connectivity(), term, wave_speed, m_batches);
+        if(threaded)
+          thread_pool.parallel_for(0, group.size(), batch_size, scatter);
+        else
+          scatter(0, group.size(), 0);
       }
     }
   }
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+
+void TermComputer::compute_terms(const Uint* first, const Uint* last, TermBatch& batch)
+{
+  const Uint nb_nodes = batch.nb_nodes();
+  const Uint nb_eqs = batch.nb_eqs();
+  Uint i = 0;
+  for(const Uint* elem = first; elem != last; ++elem, ++i)
+  {
+    compute_term(*elem,m_tmp_term,m_tmp_ws);
+    Real* elem_term = batch.term(i);
+    Real* elem_ws = batch.wave_speed(i);
+    for(Uint s = 0; s != nb_nodes; ++s)
+    {
+      for(Uint eq = 0; eq != nb_eqs; ++eq)
+        elem_term[s*nb_eqs+eq] = m_tmp_term[s][eq];
+      elem_ws[s] = m_tmp_ws[s];
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 } // solver
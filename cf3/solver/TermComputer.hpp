@@ -12,13 +12,15 @@
 #include "solver/LibSolver.hpp"
 
 // Forward declares
-namespace cf3 
-{ 
-  namespace mesh 
-  { 
-    class Entities; 
-    class Field; 
-  } 
+namespace cf3
+{
+  namespace mesh
+  {
+    class Connectivity;
+    class Entities;
+    class Field;
+    class Space;
+  }
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -28,12 +30,75 @@ namespace solver {
 
 /////////////////////////////////////////////////////////////////////////////////////
 
+/// @brief Contiguous scratch storage for the terms of a batch of elements
+///
+/// Values are stored element by element, then node by node, then equation by equation.
+/// Resizing never releases memory, so a batch reused across loops does not touch the heap.
+class solver_API TermBatch
+{
+public:
+  TermBatch() : m_nb_elems(0), m_nb_nodes(0), m_nb_eqs(0) {}
+
+  /// Resize for the given number of elements, nodes per element and equations
+  void resize(const Uint nb_elems, const Uint nb_nodes, const Uint nb_eqs);
+
+  Uint nb_elems() const { return m_nb_elems; }
+  Uint nb_nodes() const { return m_nb_nodes; }
+  Uint nb_eqs() const { return m_nb_eqs; }
+
+  /// Term values of the element at position i in the batch (nb_nodes x nb_eqs, row major)
+  Real* term(const Uint i) { return &m_terms[i*m_nb_nodes*m_nb_eqs]; }
+  const Real* term(const Uint i) const { return &m_terms[i*m_nb_nodes*m_nb_eqs]; }
+
+  /// Wave speeds of the element at position i in the batch (nb_nodes)
+  Real* wave_speed(const Uint i) { return &m_wave_speeds[i*m_nb_nodes]; }
+  const Real* wave_speed(const Uint i) const { return &m_wave_speeds[i*m_nb_nodes]; }
+
+private:
+  Uint m_nb_elems;
+  Uint m_nb_nodes;
+  Uint m_nb_eqs;
+  std::vector<Real> m_terms;
+  std::vector<Real> m_wave_speeds;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Caches the element groups a loop over the elements of a space goes through
+///
+/// When coloring is requested, no two elements within a group share a node, so each group
+/// can be scattered to the nodes by multiple threads. Otherwise all elements are in a single group.
+/// Entries are rebuilt when the connectivity table is replaced or resized.
+class solver_API ElementGroupCache
+{
+public:
+  /// Element groups for the given space
+  const std::vector< std::vector<Uint> >& groups(const mesh::Space& space, const bool colored);
+
+private:
+  struct Entry
+  {
+    Handle<mesh::Connectivity const> connectivity;
+    Uint nb_elems;
+    bool colored;
+    std::vector< std::vector<Uint> > groups;
+  };
+  std::vector<Entry> m_entries;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////
+
 /// @brief Computes a term of a system of equations by looping over elements
+///
+/// Terms are computed in batches of elements through compute_terms(). The default implementation
+/// calls the per-element virtual compute_term(). Term computers that override compute_terms() with
+/// a kernel that doesn't modify shared state can report thread_safe(), and are then executed
+/// over colored element groups using the common::ThreadPool.
 /// @author Willem Deconinck
 class solver_API TermComputer : public common::Action
 {
 public:
-  
+
   /// @brief Constructor
   TermComputer ( const std::string& name );
 
@@ -55,13 +120,25 @@ public:
   /// @brief Compute the term for given element in given vectors
   virtual void compute_term(const Uint elem_idx, std::vector<RealVector>& term, std::vector<Real>& wave_speed) = 0;
 
+  /// @brief Compute the terms for the elements [first, last) of the cells passed to loop_cells()
+  ///
+  /// The batch is sized by the caller. The default implementation calls the per-element compute_term()
+  virtual void compute_terms(const Uint* first, const Uint* last, TermBatch& batch);
+
+  /// @brief True if compute_terms() may be called concurrently for distinct batches
+  virtual bool thread_safe() const { return false; }
+
  private:
 
   Handle<mesh::Field> m_term_field;
   Handle<mesh::Field> m_term_ws;
-  
+
   std::vector<RealVector> m_tmp_term;
   std::vector<Real>       m_tmp_ws;
+
+  /// Scratch storage, one per thread
+  std::vector<TermBatch>  m_batches;
+  ElementGroupCache       m_groups;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -71,12 +71,30 @@ void ComputeArea::trigger_elements()
 /////////////////////////////////////////////////////////////////////////////////////
 
 void ComputeArea::execute()
+{
+  compute(idx(), m_coordinates);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ComputeArea::execute_range(const Uint begin, const Uint end)
+{
+  // Local coordinates, so ranges can be computed concurrently
+  RealMatrix coordinates;
+  elements().geometry_space().allocate_coordinates(coordinates);
+  for(Uint elem = begin; elem != end; ++elem)
+    compute(elem, coordinates);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ComputeArea::compute(const Uint elem, RealMatrix& coordinates)
 {
   const Space& space = *m_area_field_space;
   Field& area = *m_area;
 
-  elements().geometry_space().put_coordinates(m_coordinates,idx());
-  area[space.connectivity()[idx()][0]][0] = elements().element_type().area( m_coordinates );
+  elements().geometry_space().put_coordinates(coordinates,elem);
+  area[space.connectivity()[elem][0]][0] = elements().element_type().area( coordinates );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
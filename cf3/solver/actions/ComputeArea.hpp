@@ -40,8 +40,17 @@ public: // functions
   /// execute the action
   virtual void execute ();
 
+  /// execute the action for a range of elements
+  virtual void execute_range ( const Uint begin, const Uint end );
+
+  /// Each element only writes its own value
+  virtual bool thread_safe() const { return true; }
+
 private: // helper functions
 
+  /// Compute the area of a single element
+  void compute ( const Uint elem, RealMatrix& coordinates );
+
   void config_field();
 
   void trigger_elements();
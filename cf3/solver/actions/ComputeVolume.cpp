@@ -72,12 +72,30 @@ void ComputeVolume::trigger_elements()
 /////////////////////////////////////////////////////////////////////////////////////
 
 void ComputeVolume::execute()
+{
+  compute(idx(), m_coordinates);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ComputeVolume::execute_range(const Uint begin, const Uint end)
+{
+  // Local coordinates, so ranges can be computed concurrently
+  RealMatrix coordinates;
+  elements().geometry_space().allocate_coordinates(coordinates);
+  for(Uint elem = begin; elem != end; ++elem)
+    compute(elem, coordinates);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ComputeVolume::compute(const Uint elem, RealMatrix& coordinates)
 {
   const Space& space = *m_volume_field_space;
   Field& volume = *m_volume;
 
-  elements().geometry_space().put_coordinates(m_coordinates,idx());
-  volume[space.connectivity()[idx()][0]][0] = elements().element_type().volume( m_coordinates );
+  elements().geometry_space().put_coordinates(coordinates,elem);
+  volume[space.connectivity()[elem][0]][0] = elements().element_type().volume( coordinates );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
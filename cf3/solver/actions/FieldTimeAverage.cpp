@@ -34,6 +34,34 @@ common::ComponentBuilder < FieldTimeAverage, common::Action, LibActions > FieldT
 
 ///////////////////////////////////////////////////////////////////////////////////////
 
+namespace detail
+{
+  /// Add one sample to the running average, for any combination of double and single precision storage
+  template<typename SourceArrayT, typename AverageArrayT>
+  void update_average(const SourceArrayT& source_array, AverageArrayT& avg_array, const Uint count)
+  {
+    typedef typename AverageArrayT::element AverageT;
+    const Uint nb_rows = source_array.size();
+    const Uint row_size = source_array.shape()[1];
+    for(Uint i = 0; i != nb_rows; ++i)
+    {
+      for(Uint j = 0; j != row_size; ++j)
+        avg_array[i][j] = static_cast<AverageT>((avg_array[i][j]*static_cast<Real>(count) + source_array[i][j]) / static_cast<Real>(count +1));
+    }
+  }
+
+  template<typename SourceArrayT>
+  void update_average(const SourceArrayT& source_array, mesh::Field& average, const Uint count)
+  {
+    if(average.single_precision())
+      update_average(source_array, average.single_array(), count);
+    else
+      update_average(source_array, average.array(), count);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
 FieldTimeAverage::FieldTimeAverage ( const std::string& name ) :
   common::Action(name),
   m_count(0)
@@ -49,6 +77,11 @@ FieldTimeAverage::FieldTimeAverage ( const std::string& name ) :
     .pretty_name("count")
     .description("Numer of samples that were averaged so far")
     .link_to(&m_count);
+
+  options().add("single_precision", false)
+    .pretty_name("Single Precision")
+    .description("Store the average in single precision")
+    .attach_trigger(boost::bind(&FieldTimeAverage::trigger_field, this));
 }
 
 void FieldTimeAverage::execute()
@@ -56,17 +89,10 @@ void FieldTimeAverage::execute()
   if(is_null(m_source_field))
     throw common::SetupError(FromHere(), "No field configured for " + uri().path());
 
-  const mesh::Field::ArrayT& source_array = m_source_field->array();
-  mesh::Field::ArrayT& avg_array = m_statistics_field->array();
-  const Uint nb_rows = m_source_field->size();
-  const Uint row_size = m_source_field->row_size();
-
-  for(Uint i = 0; i != nb_rows; ++i)
-  {
-    const Eigen::Map<RealVector const> source_row(&source_array[i][0], row_size);
-    Eigen::Map<RealVector> avg_row(&avg_array[i][0], row_size);
-    avg_row = (avg_row*static_cast<Real>(m_count) + source_row) / static_cast<Real>(m_count +1);
-  }
+  if(m_source_field->single_precision())
+    detail::update_average(m_source_field->single_array(), *m_statistics_field, m_count);
+  else
+    detail::update_average(m_source_field->array(), *m_statistics_field, m_count);
 
   options().set("count", m_count+1u);
 }
@@ -83,6 +109,7 @@ void FieldTimeAverage::trigger_field()
     m_statistics_field = dict.create_field(new_field_name, m_source_field->descriptor().description()).handle<mesh::Field>();
     m_statistics_field->descriptor().prefix_variable_names("avg_");
   }
+  m_statistics_field->options().set("single_precision", options().value<bool>("single_precision"));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -45,6 +45,9 @@ class solver_actions_API ForAllElementsT : public Loop
   {
     private: // data
 
+      /// Loop that executes the operation
+      Loop& loop;
+
       /// Region to loop on
       mesh::Region& region;
 
@@ -54,8 +57,8 @@ class solver_actions_API ForAllElementsT : public Loop
     public: // functions
 
       /// Constructor
-      ElementLooper(ActionT& operation, mesh::Region& region_in )
-        : region(region_in) , op(operation)
+      ElementLooper(Loop& loop_in, ActionT& operation, mesh::Region& region_in )
+        : loop(loop_in), region(region_in) , op(operation)
       {}
 
       /// Operator
@@ -66,14 +69,7 @@ class solver_actions_API ForAllElementsT : public Loop
         {
           op.set_elements(elements);
           if (op.can_start_loop())
-          {
-            const Uint nb_elem = elements.size();
-            for ( Uint elem = 0; elem != nb_elem; ++elem )
-            {
-              op.select_loop_idx(elem);
-              op.execute();
-            }
-          }
+            loop.execute_elements(op, elements);
         }
       }
 
@@ -120,7 +116,7 @@ public: // functions
     {
       CFinfo << region->uri().string() << CFendl;
 
-      ElementLooper loop_elements(*m_action,*region);
+      ElementLooper loop_elements(*this,*m_action,*region);
       boost::mpl::for_each< mesh::ElementTypes >(loop_elements);
     }
   }
@@ -37,10 +37,17 @@ void ForAllNodes2::execute()
   {
     boost_foreach(LoopOperation& op, find_components<LoopOperation>(*this))
     {
-      boost_foreach(const Uint node, Elements::used_nodes(*region).array())
+      // Runs of consecutive node indices are executed as a single range
+      const List<Uint>& nodes = Elements::used_nodes(*region);
+      const Uint nb_nodes = nodes.size();
+      Uint range_begin = 0;
+      while(range_begin != nb_nodes)
       {
-        op.select_loop_idx(node);
-        op.execute();
+        Uint range_end = range_begin + 1;
+        while(range_end != nb_nodes && nodes[range_end] == nodes[range_end-1] + 1)
+          ++range_end;
+        execute_range(op, nodes[range_begin], nodes[range_end-1] + 1);
+        range_begin = range_end;
       }
     }
   }
@@ -7,11 +7,17 @@
 #include "common/URI.hpp"
  
 
+#include "common/Foreach.hpp"
 #include "common/OptionArray.hpp"
+#include "common/OptionList.hpp"
+#include "common/ThreadPool.hpp"
 
+#include "solver/TermComputer.hpp"
 #include "solver/actions/Loop.hpp"
 
+#include "mesh/Elements.hpp"
 #include "mesh/Region.hpp"
+#include "mesh/Space.hpp"
 
 /////////////////////////////////////////////////////////////////////////////////////
 
@@ -24,10 +30,104 @@ namespace actions {
 
 /////////////////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+
+/// Executes a contiguous range of loop indices
+struct ExecuteRange
+{
+  ExecuteRange(LoopOperation& a_op) : op(a_op) {}
+
+  void operator()(const Uint begin, const Uint end, const Uint) const
+  {
+    op.execute_range(begin, end);
+  }
+
+  LoopOperation& op;
+};
+
+/// Executes a part of a group of loop indices
+struct ExecuteIndices
+{
+  ExecuteIndices(LoopOperation& a_op, const std::vector<Uint>& a_indices) : op(a_op), indices(a_indices) {}
+
+  void operator()(const Uint begin, const Uint end, const Uint) const
+  {
+    op.execute_indices(&indices[0] + begin, &indices[0] + end);
+  }
+
+  LoopOperation& op;
+  const std::vector<Uint>& indices;
+};
+
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
 Loop::Loop ( const std::string& name ) :
-  solver::Action(name)
+  solver::Action(name),
+  m_threaded(true),
+  m_chunk_size(256),
+  m_coloring(true),
+  m_element_groups(new ElementGroupCache())
 {
   mark_basic();
+
+  options().add("threaded", m_threaded)
+    .pretty_name("Threaded")
+    .description("Distribute the loop over the threads of the ThreadPool, for operations that are thread-safe")
+    .link_to(&m_threaded);
+
+  options().add("chunk_size", m_chunk_size)
+    .pretty_name("Chunk Size")
+    .description("Number of loop indices that are handed to a thread at once")
+    .link_to(&m_chunk_size);
+
+  options().add("coloring", m_coloring)
+    .pretty_name("Coloring")
+    .description("Color the elements so operations that scatter to nodes can be threaded. If false, these operations are executed serially")
+    .link_to(&m_coloring);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+bool Loop::use_threads(const LoopOperation& op) const
+{
+  return m_threaded && op.thread_safe() && ThreadPool::instance().nb_threads() > 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void Loop::execute_range(LoopOperation& op, const Uint begin, const Uint end)
+{
+  if(use_threads(op) && end - begin > m_chunk_size)
+    ThreadPool::instance().parallel_for(begin, end, std::max(m_chunk_size, 1u), ExecuteRange(op));
+  else
+    op.execute_range(begin, end);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+
+void Loop::execute_elements(LoopOperation& op, Entities& elements)
+{
+  const Uint nb_elems = elements.size();
+  if(!op.scatters_to_nodes())
+  {
+    execute_range(op, 0, nb_elems);
+    return;
+  }
+
+  if(!m_coloring || !use_threads(op))
+  {
+    op.execute_range(0, nb_elems);
+    return;
+  }
+
+  ThreadPool& thread_pool = ThreadPool::instance();
+  boost_foreach(const std::vector<Uint>& group, m_element_groups->groups(elements.geometry_space(), true))
+  {
+    thread_pool.parallel_for(0, group.size(), std::max(m_chunk_size, 1u), ExecuteIndices(op, group));
+  }
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
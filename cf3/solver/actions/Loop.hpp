@@ -17,10 +17,14 @@ namespace cf3 {
 
   namespace mesh
   {
+    class Entities;
     class Region;
   }
 
 namespace solver {
+
+class ElementGroupCache;
+
 namespace actions {
 
 
@@ -51,6 +55,25 @@ public: // functions
   virtual LoopOperation& action(const std::string& name);
 
   virtual void execute() = 0;
+
+  /// Execute the operation for the loop indices in [begin, end). If the operation is thread-safe and the loop is threaded,
+  /// the range is split in chunks of "chunk_size" indices that are distributed over the common::ThreadPool.
+  void execute_range(LoopOperation& op, const Uint begin, const Uint end);
+
+  /// Execute the operation for all elements of the given entities, which must have been set on the operation.
+  /// Thread-safe operations that scatter to nodes are executed per color, so that no two threads write to the same node.
+  void execute_elements(LoopOperation& op, mesh::Entities& elements);
+
+private:
+  /// True if the operation can be executed on multiple threads
+  bool use_threads(const LoopOperation& op) const;
+
+  bool m_threaded;
+  Uint m_chunk_size;
+  bool m_coloring;
+
+  /// Colored element groups, for operations that scatter to nodes
+  boost::shared_ptr<ElementGroupCache> m_element_groups;
 };
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -82,6 +82,25 @@ void LoopOperation::set_elements(Entities& elements)
 
 ////////////////////////////////////////////////////////////////////////////////////
 
+void LoopOperation::execute_range(const Uint begin, const Uint end)
+{
+  for(Uint i = begin; i != end; ++i)
+  {
+    select_loop_idx(i);
+    execute();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+
+void LoopOperation::execute_indices(const Uint* first, const Uint* last)
+{
+  for(const Uint* it = first; it != last; ++it)
+    execute_range(*it, *it + 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+
 } // actions
 } // solver
 } // cf3
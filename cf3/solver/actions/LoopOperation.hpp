@@ -47,6 +47,22 @@ public: // functions
 
   void select_loop_idx ( const Uint idx ) { m_idx = idx; }
 
+  /// Execute the operation for all loop indices in [begin, end).
+  /// The default implementation selects each index and calls execute(). Operations that override this
+  /// should not depend on the selected loop index, so they can be made thread-safe.
+  virtual void execute_range ( const Uint begin, const Uint end );
+
+  /// Execute the operation for the loop indices in the sequence [first, last), as used for colored loops.
+  /// The default implementation calls execute_range() for each index
+  virtual void execute_indices ( const Uint* first, const Uint* last );
+
+  /// True if execute_range() and execute_indices() may be called concurrently for distinct indices
+  virtual bool thread_safe() const { return false; }
+
+  /// True if the operation writes to the nodes of the elements, so elements sharing a node
+  /// must not be executed concurrently
+  virtual bool scatters_to_nodes() const { return false; }
+
   /// Called before looping to prepare a helper object that caches entries
   /// needed by this operation to perform the loop efficiently.
   /// Typically accesses components and stores their address, since they are not expected to change over looping.
@@ -0,0 +1,473 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+
+#include "common/Builder.hpp"
+#include "common/Core.hpp"
+#include "common/EventHandler.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+#include "common/Signal.hpp"
+#include "common/XML/SignalOptions.hpp"
+
+#include "common/PE/Comm.hpp"
+#include "common/PE/operations.hpp"
+
+#include "math/VariablesDescriptor.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Octtree.hpp"
+#include "mesh/PointInterpolator.hpp"
+#include "mesh/Space.hpp"
+#include "mesh/Tags.hpp"
+
+#include "solver/History.hpp"
+#include "solver/Tags.hpp"
+#include "solver/Time.hpp"
+#include "solver/actions/ProbeSet.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+
+using namespace common;
+using namespace common::XML;
+using namespace mesh;
+
+common::ComponentBuilder < ProbeSet, common::Action, LibActions > ProbeSet_Builder;
+
+////////////////////////////////////////////////////////////////////////////////
+
+ProbeSet::ProbeSet( const std::string& name ) :
+  common::Action(name),
+  m_located(false),
+  m_mesh_changed(false),
+  m_row_size(0),
+  m_nb_buffered(0),
+  m_flush_interval(10),
+  m_nb_executions(0)
+{
+  properties()["brief"] = std::string("Interpolate field values to a set of points at every execution");
+  properties()["description"] = std::string("The points are located once, and the values of all points are gathered on rank 0 in a single message");
+
+  options().add("coordinates", std::vector<Real>())
+    .pretty_name("Coordinates")
+    .description("Coordinates of the points, one after the other")
+    .attach_trigger(boost::bind(&ProbeSet::trigger_setup, this))
+    .mark_basic();
+
+  options().add("dict", m_dict)
+    .pretty_name("Dictionary")
+    .description("Dictionary that will be probed")
+    .link_to(&m_dict)
+    .attach_trigger(boost::bind(&ProbeSet::trigger_setup, this))
+    .mark_basic();
+
+  options().add("fields", std::vector<std::string>())
+    .pretty_name("Fields")
+    .description("Names of the fields to probe in the dictionary. All fields except the coordinates are probed if this is empty")
+    .attach_trigger(boost::bind(&ProbeSet::trigger_setup, this))
+    .mark_basic();
+
+  options().add("history", m_history)
+    .pretty_name("History")
+    .description("History component to log the values to")
+    .link_to(&m_history);
+
+  options().add(Tags::time(), m_time)
+    .pretty_name("Time")
+    .description("Time component providing the time of each record in the binary file. The execution count is used if not set")
+    .link_to(&m_time);
+
+  options().add("file", URI())
+    .pretty_name("File")
+    .description("Binary file to append the values to")
+    .attach_trigger(boost::bind(&ProbeSet::trigger_file, this))
+    .mark_basic();
+
+  options().add("flush_interval", m_flush_interval)
+    .pretty_name("Flush Interval")
+    .description("Number of executions between writes to the binary file")
+    .link_to(&m_flush_interval);
+
+  regist_signal( "add_line" )
+    .description( "Add equally spaced points on a line" )
+    .pretty_name("Add Line" )
+    .connect( boost::bind( &ProbeSet::signal_add_line, this, _1 ) )
+    .signature( boost::bind( &ProbeSet::signature_add_line, this, _1 ) );
+
+  m_point_interpolator = create_static_component<PointInterpolator>("point_interpolator");
+  m_point_interpolator->options().set("function", std::string("cf3.mesh.ShapeFunctionInterpolation"));
+
+  m_values = create_static_component< Table<Real> >("values");
+
+  Core::instance().event_handler().connect_to_event(mesh::Tags::event_mesh_changed(), this, &ProbeSet::on_mesh_changed_event);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ProbeSet::~ProbeSet()
+{
+  try
+  {
+    close_file();
+  }
+  catch(std::exception& e)
+  {
+    CFerror << "Failed to write the remaining probe values of " << uri().path() << ": " << e.what() << CFendl;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ProbeSet::trigger_setup()
+{
+  m_located = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ProbeSet::trigger_file()
+{
+  // The buffered records belong to the previous file
+  close_file();
+  m_file_path = options().value<URI>("file").path();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ProbeSet::close_file()
+{
+  flush();
+  if(m_file.is_open())
+    m_file.close();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ProbeSet::on_mesh_changed_event(SignalArgs& args)
+{
+  if(is_null(m_dict))
+    return;
+
+  SignalOptions options(args);
+  Handle<Mesh> mesh = find_parent_component_ptr<Mesh>(*m_dict);
+  if(is_not_null(mesh) && options.value<URI>("mesh_uri") == mesh->uri())
+  {
+    m_located = false;
+    m_mesh_changed = true;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ProbeSet::add_line(const std::vector<Real>& start, const std::vector<Real>& end, const Uint nb_points)
+{
+  if(start.size() != end.size())
+    throw BadValue(FromHere(), "Start and end of the line added to " + uri().string() + " have a different dimension");
+  if(nb_points < 2)
+    throw BadValue(FromHere(), "A line needs at least 2 points in " + uri().string());
+
+  std::vector<Real> coordinates = options().value< std::vector<Real> >("coordinates");
+  for(Uint i = 0; i != nb_points; ++i)
+  {
+    const Real s = static_cast<Real>(i) / static_cast<Real>(nb_points-1);
+    for(Uint d = 0; d != start.size(); ++d)
+      coordinates.push_back((1.-s)*start[d] + s*end[d]);
+  }
+  options().set("coordinates", coordinates);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ProbeSet::setup()
+{
+  if(m_located)
+    return;
+
+  // The number of values per record may change, so the records with the current layout are written first.
+  // The file is opened again on the next flush, which writes a new header
+  close_file();
+
+  if(is_null(m_dict))
+    throw SetupError(FromHere(), "Option \"dict\" was not configured in " + uri().string());
+
+  Handle<Mesh> mesh = find_parent_component_ptr<Mesh>(*m_dict);
+  if(is_null(mesh))
+    throw SetupError(FromHere(), "Dictionary " + m_dict->uri().string() + " is not part of a mesh");
+
+  PE::Comm& comm = PE::Comm::instance();
+  const bool parallel = comm.is_active();
+  const Uint nb_procs = parallel ? comm.size() : 1;
+  const Uint my_rank = parallel ? comm.rank() : 0;
+
+  const Uint dim = mesh->dimension();
+  const std::vector<Real> coordinates = options().value< std::vector<Real> >("coordinates");
+  if(coordinates.size() % dim != 0)
+    throw BadValue(FromHere(), "Number of coordinates for " + uri().string() + " is not a multiple of the dimension " + to_str(dim));
+  const Uint nb_points = coordinates.size() / dim;
+
+  // Fields and column names
+  m_fields.clear();
+  const std::vector<std::string> field_names = options().value< std::vector<std::string> >("fields");
+  if(field_names.empty())
+  {
+    boost_foreach(const Handle<Field>& field, m_dict->fields())
+    {
+      if(field->name() != mesh::Tags::coordinates())
+        m_fields.push_back(Handle<Field const>(field));
+    }
+  }
+  else
+  {
+    boost_foreach(const std::string& field_name, field_names)
+    {
+      Handle<Field const> field(m_dict->get_child(field_name));
+      if(is_null(field))
+        throw ValueNotFound(FromHere(), "Field " + field_name + " not found in " + m_dict->uri().string());
+      m_fields.push_back(field);
+    }
+  }
+
+  m_row_size = 0;
+  m_column_names.clear();
+  boost_foreach(const Handle<Field const>& field, m_fields)
+  {
+    m_row_size += field->row_size();
+    for(Uint var_idx = 0; var_idx != field->nb_vars(); ++var_idx)
+    {
+      const std::string var_name = field->descriptor().user_variable_name(var_idx);
+      const Uint var_length = field->descriptor().var_length(var_idx);
+      if(var_length == 1)
+      {
+        m_column_names.push_back(var_name);
+      }
+      else
+      {
+        for(Uint i = 0; i != var_length; ++i)
+          m_column_names.push_back(var_name + "[" + to_str(i) + "]");
+      }
+    }
+  }
+
+  m_history_names.clear();
+  m_history_names.reserve(nb_points*m_row_size);
+  for(Uint i = 0; i != nb_points; ++i)
+    boost_foreach(const std::string& column_name, m_column_names)
+      m_history_names.push_back(name() + "_" + to_str(i) + "_" + column_name);
+
+  // A changed mesh invalidates the octtree used by the element finder
+  if(m_mesh_changed)
+  {
+    if(Handle<Octtree> octtree = Handle<Octtree>(mesh->get_child("octtree")))
+      octtree->create_octtree();
+    m_mesh_changed = false;
+  }
+  m_point_interpolator->options().set("dict", m_dict);
+
+  // Locate the points. The status of a point is 0 if it is in an owned element, 1 if it is in a ghost element
+  // and 2 if it wasn't found. Encoding the rank in it lets a single reduction find the lowest rank with the best status.
+  std::vector<Uint> status(nb_points);
+  std::vector< std::vector<Uint> > found_nodes(nb_points);
+  std::vector< std::vector<Real> > found_weights(nb_points);
+  RealVector coordinate(dim);
+  SpaceElem element;
+  std::vector<SpaceElem> stencil;
+  for(Uint i = 0; i != nb_points; ++i)
+  {
+    for(Uint d = 0; d != dim; ++d)
+      coordinate[d] = coordinates[i*dim + d];
+    Uint code = 2;
+    if(m_point_interpolator->compute_storage(coordinate, element, stencil, found_nodes[i], found_weights[i]))
+      code = element.is_ghost() ? 1 : 0;
+    status[i] = code*nb_procs + my_rank;
+  }
+
+  std::vector<Uint> best_status = status;
+  if(parallel && nb_points != 0)
+    comm.all_reduce(PE::min(), status, best_status);
+
+  m_offsets.assign(1, 0);
+  m_nodes.clear();
+  m_weights.clear();
+  m_gather_counts.assign(nb_procs, 0);
+  std::vector< std::vector<int> > points_per_rank(nb_procs);
+  for(Uint i = 0; i != nb_points; ++i)
+  {
+    if(best_status[i] / nb_procs == 2)
+    {
+      std::vector<Real> point(coordinates.begin() + i*dim, coordinates.begin() + (i+1)*dim);
+      throw SetupError(FromHere(), "Cannot probe: coordinate (" + to_str(point) + ") lies outside the domain");
+    }
+
+    const Uint owner = best_status[i] % nb_procs;
+    ++m_gather_counts[owner];
+    points_per_rank[owner].push_back(i);
+    if(owner == my_rank)
+    {
+      m_nodes.insert(m_nodes.end(), found_nodes[i].begin(), found_nodes[i].end());
+      m_weights.insert(m_weights.end(), found_weights[i].begin(), found_weights[i].end());
+      m_offsets.push_back(m_nodes.size());
+    }
+  }
+
+  m_gather_map.clear();
+  m_gather_map.reserve(nb_points);
+  for(Uint rank = 0; rank != nb_procs; ++rank)
+    m_gather_map.insert(m_gather_map.end(), points_per_rank[rank].begin(), points_per_rank[rank].end());
+
+  // Keep the local buffer non-empty, since the gather needs a valid pointer to the data
+  m_local_values.resize(std::max(Uint(1), static_cast<Uint>((m_offsets.size()-1)*m_row_size)));
+  m_gathered_values.resize(nb_points*m_row_size);
+
+  m_values->set_row_size(m_row_size);
+  m_values->resize(nb_points);
+
+  CFdebug << "ProbeSet " << uri().path() << ": located " << m_offsets.size()-1 << " of " << nb_points << " points on rank " << my_rank << CFendl;
+
+  m_located = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ProbeSet::execute()
+{
+  setup();
+
+  PE::Comm& comm = PE::Comm::instance();
+  const bool parallel = comm.is_active();
+  const bool is_root = !parallel || comm.rank() == 0;
+  const Uint nb_points = m_gathered_values.size() / std::max(Uint(1), m_row_size);
+  const Uint nb_local_points = m_offsets.size()-1;
+
+  ++m_nb_executions;
+
+  // Interpolate the local points from the cached weights
+  std::fill(m_local_values.begin(), m_local_values.end(), 0.);
+  for(Uint i = 0; i != nb_local_points; ++i)
+  {
+    Real* point_values = &m_local_values[i*m_row_size];
+    boost_foreach(const Handle<Field const>& field, m_fields)
+    {
+      const Uint row_size = field->row_size();
+      for(Uint n = m_offsets[i]; n != m_offsets[i+1]; ++n)
+      {
+        const Real weight = m_weights[n];
+        for(Uint j = 0; j != row_size; ++j)
+          point_values[j] += field->value(m_nodes[n], j) * weight;
+      }
+      point_values += row_size;
+    }
+  }
+
+  // Gather all points on rank 0, placing them in the order of the coordinates
+  if(nb_points != 0)
+  {
+    if(parallel)
+    {
+      comm.gather(&m_local_values[0], static_cast<int>(nb_local_points), (int*)0, &m_gathered_values[0], &m_gather_counts[0], &m_gather_map[0], 0, static_cast<int>(m_row_size));
+    }
+    else
+    {
+      for(Uint i = 0; i != nb_local_points; ++i)
+        std::copy(m_local_values.begin() + i*m_row_size, m_local_values.begin() + (i+1)*m_row_size, m_gathered_values.begin() + m_gather_map[i]*m_row_size);
+    }
+  }
+
+  if(!is_root)
+    return;
+
+  Table<Real>::ArrayT& values = m_values->array();
+  for(Uint i = 0; i != nb_points; ++i)
+    std::copy(m_gathered_values.begin() + i*m_row_size, m_gathered_values.begin() + (i+1)*m_row_size, values[i].begin());
+
+  if(is_not_null(m_history))
+  {
+    const Uint nb_values = m_gathered_values.size();
+    for(Uint i = 0; i != nb_values; ++i)
+      m_history->set(m_history_names[i], m_gathered_values[i]);
+    m_history->save_entry();
+  }
+
+  if(!m_file_path.empty())
+  {
+    m_file_buffer.push_back(is_not_null(m_time) ? m_time->current_time() : static_cast<Real>(m_nb_executions));
+    m_file_buffer.insert(m_file_buffer.end(), m_gathered_values.begin(), m_gathered_values.end());
+    if(++m_nb_buffered >= m_flush_interval)
+      flush();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ProbeSet::flush()
+{
+  if(m_file_buffer.empty())
+    return;
+
+  if(!m_file.is_open())
+  {
+    const boost::filesystem::path path(m_file_path);
+    m_file.open(path, std::ios_base::out | std::ios_base::app | std::ios_base::binary);
+    if(!m_file)
+      throw boost::filesystem::filesystem_error(path.string() + " failed to open", boost::system::error_code());
+
+    const Uint nb_points = m_gathered_values.size() / std::max(Uint(1), m_row_size);
+    m_file << "# time";
+    for(Uint i = 0; i != nb_points; ++i)
+      for(Uint j = 0; j != m_column_names.size(); ++j)
+        m_file << " " << i << "_" << m_column_names[j];
+    m_file << "\n";
+  }
+
+  m_file.write(reinterpret_cast<const char*>(&m_file_buffer[0]), m_file_buffer.size()*sizeof(Real));
+  m_file.flush();
+  m_file_buffer.clear();
+  m_nb_buffered = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ProbeSet::signal_add_line(SignalArgs& args)
+{
+  SignalOptions options(args);
+  add_line(options.value< std::vector<Real> >("start"), options.value< std::vector<Real> >("end"), options.value<Uint>("nb_points"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ProbeSet::signature_add_line(SignalArgs& args)
+{
+  SignalOptions options(args);
+
+  options.add("start", std::vector<Real>())
+    .pretty_name("Start")
+    .description("Coordinates of the first point");
+
+  options.add("end", std::vector<Real>())
+    .pretty_name("End")
+    .description("Coordinates of the last point");
+
+  options.add("nb_points", 2u)
+    .pretty_name("Number of Points")
+    .description("Number of equally spaced points on the line");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // solver
+} // cf3
@@ -0,0 +1,140 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_ProbeSet_hpp
+#define cf3_solver_actions_ProbeSet_hpp
+
+////////////////////////////////////////////////////////////////////////////////
+
+#include "common/BoostFilesystem.hpp"
+
+#include "common/Action.hpp"
+#include "common/Table.hpp"
+
+#include "solver/actions/LibActions.hpp"
+
+namespace cf3 {
+namespace mesh { class Dictionary; class Field; class PointInterpolator; }
+namespace solver {
+
+class History;
+class Time;
+
+namespace actions {
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Interpolate the fields of a dictionary to a set of points, and log them as a time series
+///
+/// The points are located the first time the probe set executes, and again after the points, the dictionary or the
+/// mesh changed. Each point is assigned to one process that has an owned element containing it, or a ghost
+/// element if no process owns one. That process stores the nodes of the element and their shape function values.
+/// Each execution then only interpolates the cached points, and gathers the values of all points on rank 0
+/// in a single message, instead of searching the element and communicating for every point like Probe does.
+///
+/// On rank 0, the latest values are stored in the "values" table, with a row for each point. They are also
+/// logged to the History component if the "history" option is set, and appended to a binary file if the "file"
+/// option is set. Each time the file is opened, a text line naming the columns is appended. After it come the
+/// records, one per execution, each holding the time followed by the values of all points as doubles. Records are
+/// buffered and written every flush_interval executions. When the points are located again, the buffered records
+/// are written and the file is closed, so the records after a new header line may have a different size.
+class solver_actions_API ProbeSet : public common::Action
+{
+public: // functions
+
+  /// Contructor
+  /// @param name of the component
+  ProbeSet ( const std::string& name );
+
+  /// Virtual destructor
+  virtual ~ProbeSet();
+
+  /// Get the class name
+  static std::string type_name () { return "ProbeSet"; }
+
+  virtual void execute();
+
+  /// Append nb_points equally spaced points to the probe set, from start to end, including both ends
+  void add_line(const std::vector<Real>& start, const std::vector<Real>& end, const Uint nb_points);
+
+  /// Write the buffered records to the binary file
+  void flush();
+
+  /// @name SIGNALS
+  //@{
+  void signal_add_line(common::SignalArgs& args);
+  void signature_add_line(common::SignalArgs& args);
+  //@}
+
+private: // functions
+
+  /// Mark the points for relocation
+  void trigger_setup();
+  /// Write the buffered records to the previous file and switch to the new one
+  void trigger_file();
+  /// Write the buffered records and close the binary file
+  void close_file();
+
+  /// Relocate the points if the mesh of the dictionary changed
+  void on_mesh_changed_event(common::SignalArgs& args);
+
+  /// Locate the points and compute their interpolation weights, if needed
+  void setup();
+
+private: // data
+
+  Handle<mesh::Dictionary> m_dict;
+  Handle<mesh::PointInterpolator> m_point_interpolator;
+  Handle<History> m_history;
+  Handle<Time> m_time;
+
+  /// Latest values, on rank 0
+  Handle< common::Table<Real> > m_values;
+
+  /// False if the points need to be located again
+  bool m_located;
+  /// True if the mesh changed since the points were located
+  bool m_mesh_changed;
+
+  /// Probed fields, and the total number of values for each point
+  std::vector< Handle<mesh::Field const> > m_fields;
+  Uint m_row_size;
+
+  /// Names of the columns, used in the binary file header, and the corresponding history variables for all points
+  std::vector<std::string> m_column_names;
+  std::vector<std::string> m_history_names;
+
+  /// Points interpolated on this process. The weights of point i are stored from m_offsets[i] to m_offsets[i+1]
+  std::vector<Uint> m_offsets;
+  std::vector<Uint> m_nodes;
+  std::vector<Real> m_weights;
+
+  /// Number of points interpolated on each process, and their indices ordered by process, for the gather on rank 0
+  std::vector<int> m_gather_counts;
+  std::vector<int> m_gather_map;
+
+  /// Values of the points interpolated on this process, and the gathered values of all points
+  std::vector<Real> m_local_values;
+  std::vector<Real> m_gathered_values;
+
+  /// Binary time series file, and the records that still need to be written to it
+  std::string m_file_path;
+  boost::filesystem::fstream m_file;
+  std::vector<Real> m_file_buffer;
+  Uint m_nb_buffered;
+  Uint m_flush_interval;
+  Uint m_nb_executions;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+} // actions
+} // solver
+} // cf3
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_solver_actions_ProbeSet_hpp
@@ -92,32 +92,36 @@ struct MatrixAssignOpsCases
 };
 
 /// Translate tag to operator
-inline void do_assign_op_matrix(boost::proto::tag::assign, math::LSS::Matrix& lss_matrix, const math::LSS::BlockAccumulator& block_accumulator)
+template<typename BlockAccumulatorT>
+inline void do_assign_op_matrix(boost::proto::tag::assign, math::LSS::Matrix& lss_matrix, const BlockAccumulatorT& block_accumulator)
 {
   lss_matrix.set_values(block_accumulator);
 }
 
 /// Translate tag to operator
-inline void do_assign_op_matrix(boost::proto::tag::plus_assign, math::LSS::Matrix& lss_matrix, const math::LSS::BlockAccumulator& block_accumulator)
+template<typename BlockAccumulatorT>
+inline void do_assign_op_matrix(boost::proto::tag::plus_assign, math::LSS::Matrix& lss_matrix, const BlockAccumulatorT& block_accumulator)
 {
   lss_matrix.add_values(block_accumulator);
 }
 
 /// Translate tag to operator
-inline void do_assign_op_rhs(boost::proto::tag::assign, math::LSS::Vector& lss_rhs, const math::LSS::BlockAccumulator& block_accumulator)
+template<typename BlockAccumulatorT>
+inline void do_assign_op_rhs(boost::proto::tag::assign, math::LSS::Vector& lss_rhs, const BlockAccumulatorT& block_accumulator)
 {
   lss_rhs.set_rhs_values(block_accumulator);
 }
 
 /// Translate tag to operator
-inline void do_assign_op_rhs(boost::proto::tag::plus_assign, math::LSS::Vector& lss_rhs, const math::LSS::BlockAccumulator& block_accumulator)
+template<typename BlockAccumulatorT>
+inline void do_assign_op_rhs(boost::proto::tag::plus_assign, math::LSS::Vector& lss_rhs, const BlockAccumulatorT& block_accumulator)
 {
   lss_rhs.add_rhs_values(block_accumulator);
 }
 
 /// Translate tag to operator
-template<typename TagT, typename TargetT>
-inline void do_assign_op(TagT, Real& lhs, TargetT& lss_matrix, const math::LSS::BlockAccumulator& block_accumulator)
+template<typename TagT, typename TargetT, typename BlockAccumulatorT>
+inline void do_assign_op(TagT, Real& lhs, TargetT& lss_matrix, const BlockAccumulatorT& block_accumulator)
 {
   BOOST_MPL_ASSERT_MSG(
     false
@@ -141,7 +145,7 @@ struct BlockAssignmentOp<SystemMatrixTag, OpTagT>
     detail::assert_nb_nodes<DataT::nb_lss_nodes>();
     static const Uint nb_nodes = detail::SafeNbNodes<DataT::nb_lss_nodes>::value;
     static const Uint nb_dofs = mat_size / nb_nodes;
-    math::LSS::BlockAccumulator& block_accumulator = data.block_accumulator;
+    typename DataT::BlockAccumulatorT& block_accumulator = data.block_accumulator;
     lss.convert_to_lss(data);
 
     for(Uint row = 0; row != mat_size; ++row)
@@ -169,7 +173,7 @@ struct BlockAssignmentOp<SystemRHSTag, OpTagT>
     detail::assert_nb_nodes<DataT::nb_lss_nodes>();
     static const Uint nb_nodes = detail::SafeNbNodes<DataT::nb_lss_nodes>::value;
     static const Uint nb_dofs = mat_size / nb_nodes;
-    math::LSS::BlockAccumulator& block_accumulator = data.block_accumulator;
+    typename DataT::BlockAccumulatorT& block_accumulator = data.block_accumulator;
     lss.convert_to_lss(data);
 
     for(Uint i = 0; i != mat_size; ++i)
@@ -236,7 +240,7 @@ boost::proto::transform< RHSAccumulator >
       detail::assert_nb_nodes<DataUnrefT::nb_lss_nodes>();
       static const Uint nb_nodes = detail::SafeNbNodes<DataUnrefT::nb_lss_nodes>::value;
       static const Uint nb_dofs = mat_size / nb_nodes;
-      math::LSS::BlockAccumulator& block_accumulator = data.block_accumulator;
+      typename DataUnrefT::BlockAccumulatorT& block_accumulator = data.block_accumulator;
       lss_term.convert_to_lss(data);
       
       for(Uint i = 0; i != var_offset; ++i)
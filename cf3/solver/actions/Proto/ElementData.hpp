@@ -41,6 +41,7 @@
 #include "ElementOperations.hpp"
 #include "ElementTransforms.hpp"
 #include "FieldSync.hpp"
+#include "GaussTensorProduct.hpp"
 #include "Terminals.hpp"
 
 namespace cf3 {
@@ -291,6 +292,39 @@ public:
     return m_connectivity;
   }
 
+  /// Compute the coordinates and the jacobian at all Gauss points of GaussTensorProductT at once, using sum factorisation
+  template<typename GaussTensorProductT>
+  void compute_tensor_product_geometry(const GaussTensorProductT& gauss_tp) const
+  {
+    typedef typename GaussTensorProductT::TensorProductT TensorProductT;
+    m_tp_coordinates.resize(TensorProductT::nb_points, EtypeT::dimension);
+    m_tp_jacobians.resize(EtypeT::dimensionality, EtypeT::dimension*TensorProductT::nb_points);
+    typename TensorProductT::PointValuesT values;
+    typename TensorProductT::PointGradientsT gradients;
+    for(Uint j = 0; j != EtypeT::dimension; ++j)
+    {
+      const typename TensorProductT::NodalValuesT nodal = m_nodes.col(j);
+      gauss_tp.tensor_product().interpolate(nodal, values);
+      gauss_tp.tensor_product().gradient(nodal, gradients);
+      m_tp_coordinates.col(j) = values;
+      for(Uint q = 0; q != TensorProductT::nb_points; ++q)
+        m_tp_jacobians.col(EtypeT::dimension*q + j) = gradients.col(q);
+    }
+  }
+
+  /// Set the shape functions, coordinates and jacobian for the given Gauss point, from the values computed by compute_tensor_product_geometry
+  template<typename GaussTensorProductT>
+  void set_tensor_product_point(const GaussTensorProductT& gauss_tp, const Uint gauss_idx) const
+  {
+    const Uint q = gauss_tp.tensor_point(gauss_idx);
+    gauss_tp.shape_function(gauss_idx, m_sf);
+    m_eval_result = m_tp_coordinates.row(q);
+    m_jacobian_matrix = m_tp_jacobians.template block<EtypeT::dimensionality, EtypeT::dimension>(0, EtypeT::dimension*q);
+    bool is_invertible;
+    m_jacobian_matrix.computeInverseAndDetWithCheck(m_jacobian_inverse, m_jacobian_determinant, is_invertible);
+    cf3_assert(is_invertible);
+  }
+
 private:
   void compute_normal_dispatch(boost::mpl::false_, const typename EtypeT::MappedCoordsT&) const
   {
@@ -336,6 +370,9 @@ private:
   mutable typename EtypeT::JacobianT m_jacobian_inverse;
   mutable Real m_jacobian_determinant;
   mutable typename EtypeT::CoordsT m_normal_vector;
+  /// Coordinates and jacobians at the Gauss points in tensor-product numbering, for sum factorisation
+  mutable RealMatrix m_tp_coordinates;
+  mutable RealMatrix m_tp_jacobians;
 };
 
 /// Helper function to find a field starting from a region
@@ -370,6 +407,13 @@ private:
       return stored_result;
     }
 
+    /// Set a previously interpolated value
+    template<typename RowT>
+    void set(const RowT& row) const
+    {
+      stored_result = row;
+    }
+
     mutable MatrixT stored_result;
   };
 
@@ -386,6 +430,13 @@ private:
       return stored_result;
     }
 
+    /// Set a previously interpolated value
+    template<typename RowT>
+    void set(const RowT& row) const
+    {
+      stored_result = row[0];
+    }
+
     mutable Real stored_result;
   };
 
@@ -462,10 +513,14 @@ public:
   void set_element(const Uint element_idx)
   {
     m_element_idx = element_idx;
-    mesh::fill(m_element_values, m_field, m_connectivity_array[element_idx], offset);
+    if(m_field.single_precision())
+      mesh::fill(m_element_values, m_field.single_array(), m_connectivity_array[element_idx], offset);
+    else
+      mesh::fill(m_element_values, m_field, m_connectivity_array[element_idx], offset);
   }
   
-  void update_block_connectivity(math::LSS::BlockAccumulator& block_accumulator)
+  template<typename BlockAccumulatorT>
+  void update_block_connectivity(BlockAccumulatorT& block_accumulator)
   {
     block_accumulator.neighbour_indices(m_connectivity_array[m_element_idx]);
   }
@@ -498,8 +553,7 @@ public:
     for(Uint i = 0; i != dimension; ++i)
     {
       m_element_values.col(i) += vals.template block<EtypeT::nb_nodes, 1>(i*EtypeT::nb_nodes, 0);
-      for(Uint j = 0; j != EtypeT::nb_nodes; ++j)
-        m_field[row[j]][offset+i] = m_element_values(j,i);
+      write_nodal_values(row, i);
     }
     
     m_need_sync = true;
@@ -510,10 +564,8 @@ public:
   {
     const mesh::Connectivity::ConstRow row = m_connectivity_array[m_element_idx];
     for(Uint i = 0; i != EtypeT::nb_nodes; ++i)
-    {
       m_element_values(i, component_idx) += vals[i];
-      m_field[row[i]][offset+component_idx] = m_element_values(i, component_idx);
-    }
+    write_nodal_values(row, component_idx);
     
     m_need_sync = true;
   }
@@ -564,7 +616,50 @@ public:
     return m_gradient;
   }
 
+  /// Interpolate the values at all Gauss points of GaussTensorProductT at once, using sum factorisation
+  template<typename GaussTensorProductT>
+  void compute_tensor_product_values(const GaussTensorProductT& gauss_tp) const
+  {
+    typedef typename GaussTensorProductT::TensorProductT TensorProductT;
+    m_tp_values.resize(TensorProductT::nb_points, Dim);
+    typename TensorProductT::PointValuesT values;
+    for(Uint i = 0; i != Dim; ++i)
+    {
+      const typename TensorProductT::NodalValuesT nodal = m_element_values.col(i);
+      gauss_tp.tensor_product().interpolate(nodal, values);
+      m_tp_values.col(i) = values;
+    }
+  }
+
+  /// Set the cached values for the given Gauss point, from the values computed by compute_tensor_product_values.
+  /// The jacobian of the support must be set for the same point.
+  template<typename GaussTensorProductT>
+  void set_tensor_product_point(const GaussTensorProductT& gauss_tp, const Uint gauss_idx) const
+  {
+    gauss_tp.shape_function(gauss_idx, m_sf);
+    m_eval.set(m_tp_values.row(gauss_tp.tensor_point(gauss_idx)));
+    gauss_tp.mapped_gradient(gauss_idx, m_mapped_gradient_matrix);
+    m_gradient.noalias() = m_support.jacobian_inverse() * m_mapped_gradient_matrix;
+  }
+
 private:
+  /// Write the element values of the given component back to the field, rounding them for single precision storage
+  void write_nodal_values(const mesh::Connectivity::ConstRow row, const Uint component_idx)
+  {
+    if(m_field.single_precision())
+      write_nodal_values(m_field.single_array(), row, component_idx);
+    else
+      write_nodal_values(m_field.array(), row, component_idx);
+  }
+
+  template<typename ArrayT>
+  void write_nodal_values(ArrayT& values, const mesh::Connectivity::ConstRow row, const Uint component_idx)
+  {
+    typedef typename ArrayT::element ValueT;
+    for(Uint j = 0; j != EtypeT::nb_nodes; ++j)
+      values[row[j]][offset+component_idx] = static_cast<ValueT>(m_element_values(j, component_idx));
+  }
+
   /// Precompute for non-volume EtypeT
   void compute_values_dispatch(boost::mpl::false_, const MappedCoordsT& mapped_coords) const
   {
@@ -600,6 +695,8 @@ private:
   mutable typename EtypeT::SF::ValueT m_sf;
   mutable typename EtypeT::SF::GradientT m_mapped_gradient_matrix;
   mutable GradientT m_gradient;
+  /// Values at the Gauss points in tensor-product numbering, for sum factorisation
+  mutable RealMatrix m_tp_values;
 
   InterpolationImpl<Dim> m_eval;
   
@@ -636,6 +733,9 @@ public:
     m_elements_begin(m_field.dict().space(elements).size() ? m_field.dict().space(elements).connectivity()[0][0] : 0),
     offset(m_field.descriptor().offset(placeholder.name()))
   {
+    // Values are returned by reference into the double precision storage
+    if(m_field.single_precision())
+      throw common::NotSupported(FromHere(), "Element-based field " + m_field.uri().path() + " must be stored in double precision");
   }
 
   /// Update nodes for the current element
@@ -713,6 +813,9 @@ public:
     m_elements_begin(m_field.dict().space(elements).size() ? m_field.dict().space(elements).connectivity()[0][0] : 0),
     offset(m_field.descriptor().offset(placeholder.name()))
   {
+    // Values are returned by reference into the double precision storage
+    if(m_field.single_precision())
+      throw common::NotSupported(FromHere(), "Element-based field " + m_field.uri().path() + " must be stored in double precision");
   }
 
   /// Update nodes for the current element
@@ -916,6 +1019,12 @@ public:
   
   static const Uint nb_lss_nodes = detail::GetNbNodes<EquationDataT>::value;
 
+  /// Number of nodes in the LSS blocks, with a single dummy node if no LSS is used
+  static const Uint nb_block_nodes = nb_lss_nodes == 0 ? 1 : nb_lss_nodes;
+
+  /// Fixed-size block accumulator. The storage order in the block is i.e. uvp, uvp, ...
+  typedef math::LSS::BlockAccumulatorT<nb_block_nodes, EMatrixSizeT::value / nb_block_nodes> BlockAccumulatorT;
+
   ElementData(VariablesT& variables, mesh::Elements& elements) :
     m_variables(variables),
     m_elements(elements),
@@ -928,25 +1037,7 @@ public:
       m_element_matrices[i].setZero();
       m_element_vectors[i].setZero();
     }
-    
-    init_block_accumulator(typename boost::fusion::result_of::empty<EquationDataT>::type());
-  }
-  
-  // Init LSS block accumulator
-  void init_block_accumulator(boost::mpl::false_)
-  {
-    typedef typename boost::mpl::transform
-    <
-      typename boost::mpl::copy<VariablesT, boost::mpl::back_inserter< boost::mpl::vector0<> > >::type,
-      FieldWidth<boost::mpl::_1, SupportEtypeT>
-    >::type NbEqsPerVarT;
-    
-    block_accumulator.resize(nb_lss_nodes, ElementMatrixSize<NbEqsPerVarT, EquationVariablesT>::type::value);
-  }
-  
-  // No LSS, so nothing to be done
-  void init_block_accumulator(boost::mpl::true_)
-  {
+    block_accumulator.reset();
   }
 
   ~ElementData()
@@ -987,6 +1078,15 @@ public:
     boost::mpl::for_each< boost::mpl::range_c<int, 0, NbVarsT::value> >(PrecomputeData<ExprT>(m_variables_data, mapped_coords));
   }
 
+  /// Precompute element matrices at the given point of the Gauss rule of the given order, for the variables found in expr.
+  /// For tensor-product element types the values at all points are computed using sum factorisation when gauss_idx is 0,
+  /// so the points of an element must be visited starting from 0.
+  template<Uint Order, typename ExprT>
+  void precompute_gauss_point(const Uint gauss_idx, const ExprT& e)
+  {
+    precompute_gauss_point_dispatch<Order>(typename IsTensorProduct<SupportEtypeT>::type(), gauss_idx, e);
+  }
+
   /// Return the type of the data stored for variable I (I being an Integral Constant in the boost::mpl sense)
   template<typename I>
   struct DataType
@@ -1064,8 +1164,8 @@ public:
     return m_element_rhs;
   };
 
-  /// Stores a mutable block accululator, always up-to-date with index mapping and correct size
-  mutable math::LSS::BlockAccumulator block_accumulator;
+  /// Stores a mutable block accululator, always up-to-date with index mapping
+  mutable BlockAccumulatorT block_accumulator;
   mutable bool indices_converted; // Indicate if the indices in the block accumulator have been converted to LSS indices
 
 private:
@@ -1092,6 +1192,24 @@ private:
 
   ///////////// helper functions and structs /////////////
 
+  /// Precompute at a Gauss point for element types that are not a tensor product
+  template<Uint Order, typename ExprT>
+  void precompute_gauss_point_dispatch(boost::mpl::false_, const Uint gauss_idx, const ExprT& e)
+  {
+    precompute_element_matrices(mesh::Integrators::GaussMappedCoords<Order, SupportEtypeT::shape>::instance().coords.col(gauss_idx), e);
+  }
+
+  /// Precompute at a Gauss point using sum factorisation
+  template<Uint Order, typename ExprT>
+  void precompute_gauss_point_dispatch(boost::mpl::true_, const Uint gauss_idx, const ExprT& e)
+  {
+    const GaussTensorProduct<SupportEtypeT, Order>& gauss_tp = GaussTensorProduct<SupportEtypeT, Order>::instance();
+    if(gauss_idx == 0)
+      m_support.compute_tensor_product_geometry(gauss_tp);
+    m_support.set_tensor_product_point(gauss_tp, gauss_idx);
+    boost::mpl::for_each< boost::mpl::range_c<int, 0, NbVarsT::value> >(PrecomputeGaussPointData<ExprT, Order>(m_variables_data, gauss_idx));
+  }
+
   /// Initializes the pointers in a VariablesDataT fusion sequence
   struct InitVariablesData
   {
@@ -1224,6 +1342,54 @@ private:
     const typename SupportEtypeT::MappedCoordsT& m_mapped_coords;
   };
 
+  /// Precompute variables data at a Gauss point, using sum factorisation for the variables that have a tensor-product element type
+  template<typename ExprT, Uint Order>
+  struct PrecomputeGaussPointData
+  {
+    PrecomputeGaussPointData(VariablesDataT& vars_data, const Uint gauss_idx) :
+      m_variables_data(vars_data),
+      m_gauss_idx(gauss_idx)
+    {
+    }
+
+    template<typename I>
+    void operator()(const I&)
+    {
+      apply(typename boost::result_of<detail::UsesVar<I::value>(ExprT)>::type(), boost::fusion::at<I>(m_variables_data));
+    }
+
+    // Variable is not used - do nothing
+    template<typename T>
+    void apply(boost::mpl::false_, T)
+    {
+    }
+
+    template<typename T>
+    void apply(boost::mpl::true_, T* d)
+    {
+      compute(typename IsTensorProduct<typename T::EtypeT>::type(), d);
+    }
+
+    template<typename T>
+    void compute(boost::mpl::false_, T* d)
+    {
+      d->compute_values(mesh::Integrators::GaussMappedCoords<Order, SupportEtypeT::shape>::instance().coords.col(m_gauss_idx));
+    }
+
+    template<typename T>
+    void compute(boost::mpl::true_, T* d)
+    {
+      const GaussTensorProduct<typename T::EtypeT, Order>& gauss_tp = GaussTensorProduct<typename T::EtypeT, Order>::instance();
+      if(m_gauss_idx == 0)
+        d->compute_tensor_product_values(gauss_tp);
+      d->set_tensor_product_point(gauss_tp, m_gauss_idx);
+    }
+
+  private:
+    VariablesDataT& m_variables_data;
+    const Uint m_gauss_idx;
+  };
+
   /// Set the element on each stored data item
   struct FillRhs
   {
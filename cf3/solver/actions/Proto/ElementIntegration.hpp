@@ -167,11 +167,11 @@ public:
     {
       typedef mesh::Integrators::GaussMappedCoords<order, ShapeFunctionT::shape> GaussT;
       ChildT e = boost::proto::child_c<1>(expr); // expression to integrate
-      data.precompute_element_matrices(GaussT::instance().coords.col(0), expr);
+      data.template precompute_gauss_point<order>(0, expr);
       expr.value = GaussT::instance().weights[0] * ElementMathImplicit()(e, state, data);
       for(Uint i = 1; i != GaussT::nb_points; ++i)
       {
-        data.precompute_element_matrices(GaussT::instance().coords.col(i), expr);
+        data.template precompute_gauss_point<order>(i, expr);
         expr.value += GaussT::instance().weights[i] * ElementMathImplicit()(e, state, data);
       }
       return expr.value;
@@ -244,12 +244,13 @@ struct ElementQuadratureEval :
       typedef typename SupportShapeFunctionT::MappedCoordsT MappedCoordsT;
       
       static const Uint max_order = MaxOrder<ExprT, UnrefDataT>::type::value;
-      typedef mesh::Integrators::GaussMappedCoords<IntegrationOrder<max_order>::value, SupportShapeFunctionT::shape> GaussT;
+      static const Uint gauss_order = IntegrationOrder<max_order>::value;
+      typedef mesh::Integrators::GaussMappedCoords<gauss_order, SupportShapeFunctionT::shape> GaussT;
 
       for(Uint i = 0; i != GaussT::nb_points; ++i)
       {
         // Precompute the primitive element matrices (shape function values, gradients, ...) for the current Gauss point
-        data.precompute_element_matrices(GaussT::instance().coords.col(i), expr);
+        data.template precompute_gauss_point<gauss_order>(i, expr);
         boost::mpl::for_each< boost::mpl::range_c<int, 1, boost::proto::arity_of<ExprT>::value> >
         (
           evaluate_expr(expr, state, data, GaussT::instance().weights[i])
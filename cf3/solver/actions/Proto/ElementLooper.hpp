@@ -7,6 +7,8 @@
 #ifndef cf3_solver_actions_Proto_ElementLooper_hpp
 #define cf3_solver_actions_Proto_ElementLooper_hpp
 
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
 #include <boost/fusion/algorithm/iteration/for_each.hpp>
 #include <boost/fusion/adapted/mpl.hpp>
 #include <boost/fusion/mpl.hpp>
@@ -20,6 +22,7 @@
 #include "ElementExpressionWrapper.hpp"
 #include "ElementGrammar.hpp"
 
+#include "mesh/ElementCost.hpp"
 #include "mesh/Mesh.hpp"
 #include "mesh/Space.hpp"
 #include "mesh/ElementTypePredicates.hpp"
@@ -159,18 +162,22 @@ template<typename DataT>
 struct ElementLooperImpl
 {
   template<typename ExprT>
-  void operator()(const ExprT& expr, DataT& data, const Uint nb_elems) const
+  void operator()(const ExprT& expr, DataT& data, const mesh::Elements& elements) const
   {
     const typename DataT::SupportShapeFunction::MappedCoordsT mapped_coords; // needed to deduce proper return type when wrapping
-    run(WrapExpression()(expr, mapped_coords, data), data, nb_elems);
+    const Handle< common::List<Real> > cost = mesh::element_cost(elements);
+    if(is_null(cost))
+      run(WrapExpression()(expr, mapped_coords, data), data, 0, elements.size());
+    else
+      run_measured(WrapExpression()(expr, mapped_coords, data), data, elements.size(), *cost);
   }
 
 private:
   template<typename FilteredExprT>
-  void run(const FilteredExprT& expr, DataT& data, const Uint nb_elems) const
+  void run(const FilteredExprT& expr, DataT& data, const Uint begin, const Uint end) const
   {
     ElementGrammar grammar;
-    for(Uint elem = 0; elem != nb_elems; ++elem)
+    for(Uint elem = begin; elem != end; ++elem)
     {
       // Update the data for the element
       data.set_element(elem);
@@ -178,6 +185,21 @@ private:
       grammar(expr, elem, data);
     }
   }
+
+  /// Run the expression, adding the time spent on each element to the element cost. The clock is read every few elements.
+  template<typename FilteredExprT>
+  void run_measured(const FilteredExprT& expr, DataT& data, const Uint nb_elems, common::List<Real>& cost) const
+  {
+    static const Uint block_size = 64;
+    for(Uint block_begin = 0; block_begin < nb_elems; block_begin += block_size)
+    {
+      const Uint block_end = std::min(nb_elems, block_begin + block_size);
+      const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+      run(expr, data, block_begin, block_end);
+      const Real time = 1e-6*static_cast<Real>((boost::posix_time::microsec_clock::universal_time() - start).total_microseconds());
+      mesh::add_element_cost(cost, block_begin, block_end, time);
+    }
+  }
 };
 
 /// When we recursed to the last variable, actually run the expression
@@ -198,7 +220,7 @@ struct ExpressionRunner<ElementTypesT, ExprT, SupportETYPE, VariablesT, Variable
 
     DataT data(variables, elements);
 
-    ElementLooperImpl<DataT>()(expression, data, elements.size());
+    ElementLooperImpl<DataT>()(expression, data, elements);
   }
 
 private:
@@ -254,7 +276,7 @@ struct ElementLooper
 
     DataT data(m_variables, m_elements);
 
-    ElementLooperImpl<DataT>()(m_expr, data, m_elements.size());
+    ElementLooperImpl<DataT>()(m_expr, data, m_elements);
   }
 
   /// Static dispatch in case different ETYPE are possible
@@ -5,6 +5,7 @@
 // See doc/lgpl.txt and doc/gpl.txt for the license text.
 
 #include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
 #include "common/List.hpp"
 
 #include "FieldSync.hpp"
@@ -14,6 +15,37 @@ namespace solver {
 namespace actions {
 namespace Proto {
 
+namespace detail
+{
+  /// Sum the rows of each periodic target node with the rows linked to it, and copy the sum back to the linked rows.
+  /// ArrayT is the double or single precision storage of the field
+  template<typename ArrayT>
+  void update_periodic_rows(ArrayT& values, const std::vector< std::vector<Uint> >& inverse_periodic_links)
+  {
+    typedef typename ArrayT::element ValueT;
+    typedef Eigen::Map< Eigen::Matrix<ValueT, Eigen::Dynamic, 1> > RowT;
+    const Uint row_size = values.shape()[1];
+    const Uint nb_nodes = inverse_periodic_links.size();
+    for(Uint i = 0; i != nb_nodes; ++i)
+    {
+      const std::vector<Uint>& my_links = inverse_periodic_links[i];
+      const Uint nb_links = my_links.size();
+      if(nb_links == 0)
+        continue;
+      RowT my_row(&values[i][0], row_size);
+      for(Uint j = 0; j != nb_links; ++j)
+      {
+        my_row += RowT(&values[my_links[j]][0], row_size);
+      }
+      for(Uint j = 0; j != nb_links; ++j)
+      {
+        RowT other_row(&values[my_links[j]][0], row_size);
+        other_row = my_row;
+      }
+    }
+  }
+}
+
 FieldSynchronizer::FieldSynchronizer()
 {
 }
@@ -62,33 +94,31 @@ void FieldSynchronizer::synchronize()
         }
       }
 
-      const Uint row_size = field.row_size();
-
-      for(Uint i = 0; i != nb_nodes; ++i)
-      {
-        const std::vector<Uint>& my_links = inverse_periodic_links[i];
-        const Uint nb_links = my_links.size();
-        if(nb_links == 0)
-          continue;
-        Eigen::Map<RealVector> my_row(&field[i][0], row_size);
-        for(Uint j = 0; j != nb_links; ++j)
-        {
-          my_row += Eigen::Map<RealVector>(&field[my_links[j]][0], row_size);
-        }
-        for(Uint j = 0; j != nb_links; ++j)
-        {
-          Eigen::Map<RealVector> other_row(&field[my_links[j]][0], row_size);
-          other_row = my_row;
-        }
-      }
+      if(field.single_precision())
+        detail::update_periodic_rows(field.single_array(), inverse_periodic_links);
+      else
+        detail::update_periodic_rows(field.array(), inverse_periodic_links);
     }
   }
   
   if(common::PE::Comm::instance().is_active())
   {
+    // Fields sharing a comm pattern are exchanged together. The map is keyed on the path of the comm pattern,
+    // so the order is the same on each cpu
+    typedef std::map< std::string, std::pair<common::PE::CommPattern*, std::vector<std::string> > > GroupsT;
+    GroupsT groups;
     for(FieldsT::iterator field_it = m_fields.begin(); field_it != m_fields.end(); ++field_it)
     {
-      field_it->second.first->synchronize();
+      mesh::Field& field = *field_it->second.first;
+      common::PE::CommPattern& comm_pattern = field.comm_pattern();
+      std::pair<common::PE::CommPattern*, std::vector<std::string> >& group = groups[comm_pattern.uri().path()];
+      group.first = &comm_pattern;
+      group.second.push_back(field.name());
+    }
+
+    for(GroupsT::iterator group_it = groups.begin(); group_it != groups.end(); ++group_it)
+    {
+      group_it->second.first->synchronize(group_it->second.second);
     }
   }
 
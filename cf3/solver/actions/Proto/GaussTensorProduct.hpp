@@ -0,0 +1,151 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_solver_actions_Proto_GaussTensorProduct_hpp
+#define cf3_solver_actions_Proto_GaussTensorProduct_hpp
+
+#include <cmath>
+
+#include <boost/mpl/bool.hpp>
+#include <boost/mpl/void.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_same.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/StringConversion.hpp"
+
+#include "mesh/Integrators/Gauss.hpp"
+#include "mesh/gausslegendre/TensorProduct.hpp"
+#include "mesh/LagrangeP1/Line.hpp"
+#include "mesh/LagrangeP1/Quad2D.hpp"
+#include "mesh/LagrangeP1/Hexa3D.hpp"
+#include "mesh/LagrangeP2/Line.hpp"
+#include "mesh/LagrangeP2/Quad2D.hpp"
+
+/// @file
+/// Sum factorisation of the values at the Gauss points for tensor-product element types
+
+namespace cf3 {
+namespace solver {
+namespace actions {
+namespace Proto {
+
+/// The 1D shape function that the shape function of EtypeT is the tensor product of, or void_ if EtypeT is not a tensor-product element
+template<typename EtypeT>
+struct TensorProductLine
+{
+  typedef boost::mpl::void_ type;
+};
+
+template<>
+struct TensorProductLine<mesh::LagrangeP1::Quad2D>
+{
+  typedef mesh::LagrangeP1::Line type;
+};
+
+template<>
+struct TensorProductLine<mesh::LagrangeP1::Hexa3D>
+{
+  typedef mesh::LagrangeP1::Line type;
+};
+
+template<>
+struct TensorProductLine<mesh::LagrangeP2::Quad2D>
+{
+  typedef mesh::LagrangeP2::Line type;
+};
+
+/// True if the values at the Gauss points of EtypeT can be computed using sum factorisation
+template<typename EtypeT>
+struct IsTensorProduct : boost::mpl::bool_<!boost::is_same<typename TensorProductLine<EtypeT>::type, boost::mpl::void_>::value>
+{
+};
+
+/// Sum factorisation kernels for the Gauss rule of the given order on element type EtypeT, with the data that does not depend on the element:
+/// the position of each Gauss point in the tensor-product numbering and the shape function values and mapped gradients at each point.
+/// Gauss points are numbered as in mesh::Integrators::GaussMappedCoords
+template<typename EtypeT, Uint Order>
+class GaussTensorProduct
+{
+public:
+  typedef mesh::Integrators::GaussMappedCoords<Order, EtypeT::shape> GaussT;
+  typedef mesh::gausslegendre::TensorProduct<typename EtypeT::SF, typename TensorProductLine<EtypeT>::type, Order> TensorProductT;
+
+  static const Uint nb_points = GaussT::nb_points;
+  static const Uint dimension = EtypeT::dimensionality;
+  static const Uint nb_nodes = EtypeT::nb_nodes;
+
+  BOOST_STATIC_ASSERT(nb_points == static_cast<Uint>(TensorProductT::nb_points));
+
+  static const GaussTensorProduct& instance()
+  {
+    static const GaussTensorProduct inst;
+    return inst;
+  }
+
+  const TensorProductT& tensor_product() const
+  {
+    return TensorProductT::instance();
+  }
+
+  /// Index in the tensor-product numbering of the given Gauss point
+  Uint tensor_point(const Uint gauss_idx) const
+  {
+    return m_tensor_points[gauss_idx];
+  }
+
+  /// Shape function values at the given Gauss point
+  void shape_function(const Uint gauss_idx, typename EtypeT::SF::ValueT& result) const
+  {
+    result = m_values.row(gauss_idx);
+  }
+
+  /// Shape function gradient in mapped coordinates at the given Gauss point
+  void mapped_gradient(const Uint gauss_idx, typename EtypeT::SF::GradientT& result) const
+  {
+    result = m_gradients.template block<dimension, nb_nodes>(0, nb_nodes*gauss_idx);
+  }
+
+private:
+  GaussTensorProduct()
+  {
+    const typename mesh::gausslegendre::Line<Order>::LocalCoordsT& roots = mesh::gausslegendre::Line<Order>::local_coordinates();
+    const typename GaussT::CoordsT& coords = GaussT::instance().coords;
+    for(Uint i = 0; i != nb_points; ++i)
+    {
+      Uint tensor_point = 0;
+      for(Uint d = 0; d != dimension; ++d)
+      {
+        Uint j = 0;
+        while(j != Order && std::abs(roots[j] - coords(d, i)) > 1e-10)
+          ++j;
+        if(j == Order)
+          throw common::SetupError(FromHere(), "Gauss point " + common::to_str(i) + " for " + EtypeT::type_name() + " is not a point of the tensor-product Gauss-Legendre rule");
+        tensor_point = tensor_point*Order + j;
+      }
+      m_tensor_points[i] = tensor_point;
+
+      const typename EtypeT::MappedCoordsT mapped_coords = coords.col(i);
+      typename EtypeT::SF::ValueT value;
+      typename EtypeT::SF::GradientT gradient;
+      EtypeT::SF::compute_value(mapped_coords, value);
+      EtypeT::SF::compute_gradient(mapped_coords, gradient);
+      m_values.row(i) = value;
+      m_gradients.template block<dimension, nb_nodes>(0, nb_nodes*i) = gradient;
+    }
+  }
+
+  Uint m_tensor_points[nb_points];
+  Eigen::Matrix<Real, nb_points, nb_nodes> m_values;
+  Eigen::Matrix<Real, dimension, nb_nodes*nb_points> m_gradients;
+};
+
+} // namespace Proto
+} // namespace actions
+} // namespace solver
+} // namespace cf3
+
+#endif // cf3_solver_actions_Proto_GaussTensorProduct_hpp
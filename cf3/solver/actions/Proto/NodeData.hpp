@@ -128,7 +128,7 @@ struct NodeVarData< ScalarField >
   void set_node(const Uint idx)
   {
     m_idx = idx;
-    m_value = m_field[idx][m_var_begin];
+    m_value = m_field.value(idx, m_var_begin);
   }
 
   typedef Real ValueT;
@@ -145,21 +145,21 @@ struct NodeVarData< ScalarField >
   {
     m_need_synchronization = true;
     m_value = v;
-    m_field[m_idx][m_var_begin] = m_value;
+    m_field.set_value(m_idx, m_var_begin, m_value);
   }
 
   void set_value(boost::proto::tag::plus_assign, const Real v)
   {
     m_need_synchronization = true;
     m_value += v;
-    m_field[m_idx][m_var_begin] = m_value;
+    m_field.set_value(m_idx, m_var_begin, m_value);
   }
 
   void set_value(boost::proto::tag::minus_assign, const Real v)
   {
     m_need_synchronization = true;
     m_value -= v;
-    m_field[m_idx][m_var_begin] = m_value;
+    m_field.set_value(m_idx, m_var_begin, m_value);
   }
 
   /// Offset for the variable in the field
@@ -216,7 +216,7 @@ struct NodeVarData<VectorField, Dim>
   {
     m_idx = idx;
     for(Uint i = 0; i != Dim; ++i)
-      m_value[i] = m_field[idx][m_var_begin + i];
+      m_value[i] = m_field.value(idx, m_var_begin + i);
   }
 
   /// Return a reference to the stored value
@@ -232,7 +232,7 @@ struct NodeVarData<VectorField, Dim>
     m_need_synchronization = true;
     m_value = v;
     for(Uint i = 0; i != Dim; ++i)
-      m_field[m_idx][m_var_begin + i] = v[i];
+      m_field.set_value(m_idx, m_var_begin + i, v[i]);
   }
 
   template<typename VectorT>
@@ -241,7 +241,7 @@ struct NodeVarData<VectorField, Dim>
     m_need_synchronization = true;
     m_value += v;
     for(Uint i = 0; i != Dim; ++i)
-      m_field[m_idx][m_var_begin + i] += v[i];
+      m_field.set_value(m_idx, m_var_begin + i, m_value[i]);
   }
 
   template<typename VectorT>
@@ -250,28 +250,28 @@ struct NodeVarData<VectorField, Dim>
     m_need_synchronization = true;
     m_value -= v;
     for(Uint i = 0; i != Dim; ++i)
-      m_field[m_idx][m_var_begin + i] -= v[i];
+      m_field.set_value(m_idx, m_var_begin + i, m_value[i]);
   }
 
   void set_value_component(boost::proto::tag::assign, const Real& v, const Uint i)
   {
     m_need_synchronization = true;
     m_value[i] = v;
-    m_field[m_idx][m_var_begin + i] = v;
+    m_field.set_value(m_idx, m_var_begin + i, v);
   }
 
   void set_value_component(boost::proto::tag::plus_assign, const Real& v, const Uint i)
   {
     m_need_synchronization = true;
     m_value[i] += v;
-    m_field[m_idx][m_var_begin + i] += v;
+    m_field.set_value(m_idx, m_var_begin + i, m_value[i]);
   }
 
   void set_value_component(boost::proto::tag::minus_assign, const Real& v, const Uint i)
   {
     m_need_synchronization = true;
     m_value[i] -= v;
-    m_field[m_idx][m_var_begin + i] -= v;
+    m_field.set_value(m_idx, m_var_begin + i, m_value[i]);
   }
 
   /// Offset for the variable in the field
@@ -105,6 +105,8 @@ void ReadRestartFile::execute()
     if(is_null(field))
       throw common::SetupError(FromHere(), "Field " + field_node.attribute_value("path") + " was not found in mesh " + mesh->uri().path());
 
+    // Single precision fields are read in double precision and rounded afterwards
+    mesh::DoublePrecisionScope double_precision(*field, true);
     data_reader->read_table(*field, common::from_str<Uint>(field_node.attribute_value("index")));
   }
 }
@@ -97,6 +97,11 @@ void WriteRestartFile::execute()
   restart_node.set_attribute("iteration", common::to_str(time->iter()));
   
   const std::string base_path = mesh->uri().path() + "/";
+
+  // The data writer reads the values through the Table<Real> interface
+  mesh::DoublePrecisionScope double_precision(false);
+  BOOST_FOREACH(const Handle<mesh::Field>& field, fields)
+    double_precision.add(*field);
   
   BOOST_FOREACH(const Handle<mesh::Field>& field, fields)
   {
@@ -198,6 +198,13 @@ namespace core {
     /// @param node Node containing the options
     void set_properties( const common::SignalArgs & node );
 
+    /// Indicates whether the children of this node were received from the server.
+    /// If not, they are requested when the node is expanded in the tree view.
+    bool children_listed() const { return m_children_listed; }
+
+    /// Sets whether the children of this node were received from the server.
+    void set_children_listed( bool listed ) { m_children_listed = listed; }
+
     /// Sets node signals
     /// Those are considered as non-local ones, meaning that asking the node
     /// to execute them will result to the sendng of a request to the remote
@@ -375,6 +382,9 @@ namespace core {
     /// If @c true, this component is a NRoot object.
     bool m_is_root;
 
+    /// @c false if the server did not send the children of this node yet.
+    bool m_children_listed;
+
   private: // data
 
     /// Component type name.
@@ -10,6 +10,13 @@
 
 #include "common/Signal.hpp"
 #include "common/FindComponents.hpp"
+#include "common/OptionArray.hpp"
+#include "common/OptionList.hpp"
+#include "common/OptionT.hpp"
+#include "common/OptionURI.hpp"
+#include "common/StringConversion.hpp"
+
+#include "common/XML/SignalOptions.hpp"
 
 #include "ui/core/TreeThread.hpp"
 #include "ui/core/NetworkQueue.hpp"
@@ -33,10 +40,22 @@ namespace core {
 
 /////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+
+/// Number of levels listed at once for new nodes. Deeper levels are listed
+/// when the user expands the nodes
+const Uint tree_listing_depth = 2;
+
+}
+
+/////////////////////////////////////////////////////////////////////////
+
 NTree::NTree(Handle< NRoot > rootNode)
   : CNode(CLIENT_TREE, "NTree", CNode::DEBUG_NODE),
     m_advanced_mode(false),
-    m_debug_mode_enabled(false)
+    m_debug_mode_enabled(false),
+    m_tree_version(0)
 {
 
   m_root_node = new TreeNode(rootNode, nullptr, 0);
@@ -50,6 +69,12 @@ NTree::NTree(Handle< NRoot > rootNode)
   regist_signal( "list_tree" )
     .description("New tree")
     .pretty_name("").connect(boost::bind(&NTree::list_tree_reply, this, _1));
+
+  unregist_signal("list_tree_since"); // unregister base class signal
+
+  regist_signal( "list_tree_since" )
+    .description("Tree changes")
+    .pretty_name("").connect(boost::bind(&NTree::list_tree_since_reply, this, _1));
 }
 
 ////////////////////////////////////////////////////////////////////////////
@@ -565,6 +590,45 @@ int NTree::rowCount(const QModelIndex & parent) const
 
 ////////////////////////////////////////////////////////////////////////////
 
+bool NTree::hasChildren(const QModelIndex & parent) const
+{
+  TreeNode* tree_node = this->index_to_tree_node(parent);
+  if(is_not_null(tree_node) && is_not_null(tree_node->node()) && !tree_node->node()->children_listed())
+    return true;
+
+  return QAbstractItemModel::hasChildren(parent);
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+bool NTree::canFetchMore(const QModelIndex & parent) const
+{
+  TreeNode* tree_node = this->index_to_tree_node(parent);
+  return is_not_null(tree_node) && is_not_null(tree_node->node()) && !tree_node->node()->children_listed();
+}
+
+////////////////////////////////////////////////////////////////////////////
+
+void NTree::fetchMore(const QModelIndex & parent)
+{
+  TreeNode* tree_node = this->index_to_tree_node(parent);
+  if(is_null(tree_node) || is_null(tree_node->node()) || tree_node->node()->children_listed())
+    return;
+
+  Handle< CNode > node = tree_node->node();
+
+  // set now, to avoid requesting the children again before the reply arrives
+  node->set_children_listed(true);
+
+  SignalOptions options;
+  options.add("version", 0u);
+  options.add("depth", tree_listing_depth);
+  SignalFrame frame = options.create_frame("list_tree_since", CLIENT_TREE_PATH, node->uri());
+  NetworkQueue::global()->send( frame );
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 int NTree::columnCount(const QModelIndex & parent) const
 {
 
@@ -598,6 +662,9 @@ void NTree::list_tree_reply(SignalArgs & args)
   {
     Handle< NRoot > tree_root = m_root_node->node()->castTo<NRoot>();
     boost::shared_ptr< CNode > root_node = CNode::create_from_xml(args.main_map.content.content->first_node());
+
+    const std::string tree_version = args.main_map.content.attribute_value("tree_version");
+    m_tree_version = tree_version.empty() ? 0u : from_str<Uint>(tree_version);
     ComponentIterator<CNode> it = component_begin<CNode>(*root_node->root());
     ComponentIterator<CNode> root_end = component_end<CNode>(*root_node->root());
     URI currentIndexPath;
@@ -673,10 +740,156 @@ void NTree::list_tree_reply(SignalArgs & args)
 
 ////////////////////////////////////////////////////////////////////////////
 
+void NTree::list_tree_since_reply(SignalArgs & args)
+{
+  SignalOptions options(args);
+  const Uint version = options.value<Uint>("version");
+  const URI path = options.value<URI>("path");
+  const bool whole_tree = path.path() == SERVER_ROOT_PATH;
+
+  // the server was restarted, the changes are relative to another tree
+  if(whole_tree && version < m_tree_version)
+  {
+    m_tree_version = 0;
+    update_tree();
+    return;
+  }
+
+  emit begin_update_tree();
+  beginResetModel();
+
+  try
+  {
+    Handle< NRoot > tree_root = m_root_node->node()->castTo<NRoot>();
+    URI currentIndexPath;
+
+    if(m_current_index.isValid())
+    {
+      currentIndexPath = index_to_tree_node(m_current_index)->node()->uri();
+    }
+
+    //
+    // first listing: remove the nodes of a previous connection
+    //
+    if(whole_tree && m_tree_version == 0)
+    {
+      std::vector<std::string> list_to_remove;
+      for(ComponentIterator<CNode> it = component_begin<CNode>(*tree_root); it != component_end<CNode>(*tree_root); ++it)
+      {
+        if(!it->is_local_component())
+          list_to_remove.push_back(it->name());
+      }
+
+      BOOST_FOREACH(const std::string& name, list_to_remove)
+      {
+        tree_root->access_component_checked(name)->handle<CNode>()->about_to_be_removed();
+        tree_root->remove_node(name.c_str());
+      }
+    }
+
+    //
+    // the server no longer knows all removed nodes: the listed node gets all its children again
+    //
+    if(options.check("reset") && options.value<bool>("reset"))
+    {
+      Handle< CNode > node(tree_root->access_component(URI(path.path(), URI::Scheme::CPATH)));
+      if(is_not_null(node))
+      {
+        std::vector<std::string> list_to_remove;
+        for(ComponentIterator<CNode> it = component_begin<CNode>(*node); it != component_end<CNode>(*node); ++it)
+        {
+          if(!it->is_local_component())
+            list_to_remove.push_back(it->name());
+        }
+
+        BOOST_FOREACH(const std::string& name, list_to_remove)
+        {
+          node->access_component_checked(name)->handle<CNode>()->about_to_be_removed();
+          node->remove_node(name.c_str());
+        }
+      }
+    }
+
+    //
+    // remove old nodes
+    //
+    BOOST_FOREACH(const std::string& removed_path, options.value< std::vector<std::string> >("removed"))
+    {
+      Handle< CNode > node(tree_root->access_component(URI(removed_path, URI::Scheme::CPATH)));
+      if(is_null(node) || node->is_local_component() || node->is_root())
+        continue;
+
+      Handle< CNode > parent(node->parent());
+      node->about_to_be_removed();
+      parent->remove_node(node->name().c_str());
+    }
+
+    //
+    // add the new nodes, if the children of their parent are known
+    //
+    XmlNode added( args.map("added").main_map.content.content->first_node() );
+    for( ; added.is_valid() ; added.content = added.content->next_sibling() )
+    {
+      Handle< CNode > parent(tree_root->access_component(URI(added.attribute_value("parent"), URI::Scheme::CPATH)));
+      if(is_null(parent) || !parent->children_listed())
+        continue;
+
+      boost::shared_ptr< CNode > node = CNode::create_from_xml(added);
+      if(is_null(node))
+        continue;
+
+      Handle< CNode > existing(parent->get_child(node->name()));
+      if(is_not_null(existing))
+      {
+        existing->about_to_be_removed();
+        parent->remove_node(existing->name().c_str());
+      }
+
+      parent->add_node(node);
+    }
+
+    //
+    // update the changed options
+    //
+    XmlNode changed( args.map("changed").main_map.content.content->first_node() );
+    for( ; changed.is_valid() ; changed.content = changed.content->next_sibling() )
+    {
+      Handle< CNode > node(tree_root->access_component(URI(changed.attribute_value("path"), URI::Scheme::CPATH)));
+      if(is_not_null(node))
+        node->set_properties(SignalFrame(changed));
+    }
+
+    if(whole_tree)
+      m_tree_version = version;
+
+    // child count may have changed, ask the root TreeNode to update its internal data
+    m_root_node->update_child_list();
+
+    // retrieve the previous index, if it still exists
+    if(!currentIndexPath.path().empty())
+      m_current_index = this->index_from_path(currentIndexPath);
+  }
+  catch(XmlError & xe)
+  {
+    NLog::global()->add_exception(xe.what());
+  }
+
+  // tell the view to update the whole thing
+  endResetModel();
+
+  emit end_update_tree();
+
+  emit current_index_changed(m_current_index, QModelIndex());
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 void NTree::clear_tree()
 {
   beginResetModel();
 
+  m_tree_version = 0;
+
   //QMutexLocker locker(m_mutex);
 
   Handle< NRoot > treeRoot = m_root_node->node()->castTo<NRoot>();
@@ -741,7 +954,11 @@ void NTree::content_listed(Handle< Component > node)
 
 void NTree::update_tree()
 {
-  SignalFrame frame("list_tree", CLIENT_TREE_PATH, SERVER_ROOT_PATH);
+  // only the changes since the last update are sent by the server
+  SignalOptions options;
+  options.add("version", m_tree_version);
+  options.add("depth", tree_listing_depth);
+  SignalFrame frame = options.create_frame("list_tree_since", CLIENT_TREE_PATH, SERVER_ROOT_PATH);
   NetworkQueue::global()->send( frame );
 }
 
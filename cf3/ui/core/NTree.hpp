@@ -225,6 +225,20 @@ namespace core {
     /// @return Returns the row count (number of children) of a given parent.
     virtual int rowCount(const QModelIndex & parent = QModelIndex()) const;
 
+    /// @brief Implementation of @c QAbstractItemModel::hasChildren().
+
+    /// Nodes of which the children were not received yet are considered as
+    /// having children, so that the view allows to expand them.
+    virtual bool hasChildren(const QModelIndex & parent = QModelIndex()) const;
+
+    /// @brief Implementation of @c QAbstractItemModel::canFetchMore().
+    /// @return Returns @c true if the children of the node were not received yet.
+    virtual bool canFetchMore(const QModelIndex & parent) const;
+
+    /// @brief Implementation of @c QAbstractItemModel::fetchMore().
+    /// Requests the children of the node from the server.
+    virtual void fetchMore(const QModelIndex & parent);
+
     /// @brief Implementation of @c QAbstractItemModel::columnCount().
     /// @return Always returns 1.
     virtual int columnCount(const QModelIndex & parent = QModelIndex()) const;
@@ -300,6 +314,14 @@ namespace core {
     /// @param node New tree
     void list_tree_reply(cf3::common::SignalArgs & node);
 
+    /// @brief Signal called when the server sends the changes to the tree
+
+    /// Removed nodes are removed, added nodes are added under their parent
+    /// if the children of the parent are known, and changed options are
+    /// updated.
+    /// @param node Changes since the tree version known by the client
+    void list_tree_since_reply(cf3::common::SignalArgs & node);
+
     /// @} END Signals
 
     void content_listed(Handle< Component > node);
@@ -361,6 +383,10 @@ namespace core {
     /// @brief Mutex to control concurrent access.
     QMutex * m_mutex;
 
+    /// @brief Version of the server tree the client tree corresponds to,
+    /// 0 if the tree was not received yet.
+    common::Uint m_tree_version;
+
     /// @brief Converts an index to a tree node
 
     /// @param index Node index to convert
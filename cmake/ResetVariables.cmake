@@ -3,6 +3,10 @@
 set( CF3_KERNEL_LIBS "" CACHE INTERNAL "" )
 set( CF3_PLUGIN_LIST "" CACHE INTERNAL "" )
 
+# reset the list of libraries written to the library manifest
+
+set( CF3_MANIFEST_LIBS "" CACHE INTERNAL "" )
+
 # reset the list of project n orphan files
 
 set( CF3_PROJECT_FILES "" CACHE INTERNAL "" )
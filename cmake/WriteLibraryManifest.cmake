@@ -0,0 +1,19 @@
+##############################################################################
+# write the manifest that maps each library name to its file, so libraries
+# can be autoloaded without searching all library paths
+##############################################################################
+
+set( CF3_LIBRARY_MANIFEST ${CF3_DSO_DIR}/coolfluid-libraries.manifest )
+
+set( _manifest_contents "# coolfluid library manifest: library name followed by the library file, relative to this file\n" )
+foreach( lib ${CF3_MANIFEST_LIBS} )
+  set( _manifest_contents "${_manifest_contents}${lib} ${CMAKE_SHARED_LIBRARY_PREFIX}${lib}${CMAKE_SHARED_LIBRARY_SUFFIX}\n" )
+endforeach()
+
+file( WRITE ${CF3_LIBRARY_MANIFEST} "${_manifest_contents}" )
+
+install( FILES ${CF3_LIBRARY_MANIFEST}
+         DESTINATION ${CF3_INSTALL_LIB_DIR}
+         COMPONENT libraries )
+
+coolfluid_log_file( "Library manifest: ${CF3_LIBRARY_MANIFEST}" )
@@ -187,6 +187,11 @@ macro( coolfluid3_add_library )
 
         if( NOT _PAR_TEST )
 
+            # list the library in the manifest used for autoloading
+            if( NOT _PAR_TYPE MATCHES "STATIC" )
+                set( CF3_MANIFEST_LIBS ${CF3_MANIFEST_LIBS} ${LIBNAME} CACHE INTERNAL "" )
+            endif()
+
             # add installation paths
             install( TARGETS ${LIBNAME}
               RUNTIME DESTINATION ${CF3_INSTALL_BIN_DIR} COMPONENT libraries
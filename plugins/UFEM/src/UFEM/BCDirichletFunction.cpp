@@ -101,6 +101,11 @@ void BCDirichletFunction::execute()
     }
   }
   
+  Handle<math::LSS::System> lss = options().value< Handle<math::LSS::System> >("lss");
+  if(is_null(lss))
+    throw common::SetupError(FromHere(), "No LSS set for " + uri().path());
+
+  math::LSS::DirichletBatch batch(*lss);
   cf3::solver::actions::Proto::ProtoAction::execute();
 }
 
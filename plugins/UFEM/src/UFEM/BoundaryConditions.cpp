@@ -225,6 +225,19 @@ BoundaryConditions::~BoundaryConditions()
 {
 }
 
+void BoundaryConditions::execute()
+{
+  Handle<LSS::System> lss = options().value< Handle<LSS::System> >("lss");
+  if(is_null(lss) || !lss->is_created())
+  {
+    ActionDirector::execute();
+    return;
+  }
+
+  LSS::DirichletBatch batch(*lss);
+  ActionDirector::execute();
+}
+
 Handle<common::Action> BoundaryConditions::add_constant_bc(const std::string& region_name, const std::string& variable_name)
 {
   const VariablesDescriptor& descriptor = find_component_with_tag<VariablesDescriptor>(m_implementation->physical_model().variable_manager(), m_implementation->m_solution_tag);
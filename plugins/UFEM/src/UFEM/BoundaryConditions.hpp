@@ -33,6 +33,9 @@ public: // functions
   /// Get the class name
   static std::string type_name () { return "BoundaryConditions"; }
 
+  /// Execute all boundary conditions, applying their Dirichlet conditions on the linear system in one batch
+  virtual void execute();
+
   /// Create constant dirichlet BC
   /// @param region_name Name of the boundary region. Must be unique in the problem region
   /// @param variable_name Name of the variable for which to set the BC
@@ -0,0 +1,205 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <set>
+
+#include <boost/bind.hpp>
+
+#include "common/Builder.hpp"
+#include "common/Foreach.hpp"
+#include "common/List.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/OptionT.hpp"
+#include "common/PropertyList.hpp"
+#include "common/Timer.hpp"
+#include "common/PE/Comm.hpp"
+
+#include "math/VariablesDescriptor.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Functions.hpp"
+#include "mesh/Region.hpp"
+
+#include "ConcurrentCoupling.hpp"
+
+namespace cf3 {
+namespace UFEM {
+
+using namespace common;
+
+ComponentBuilder < ConcurrentCoupling, common::ActionDirector, LibUFEM > ConcurrentCoupling_Builder;
+
+ConcurrentCoupling::ConcurrentCoupling(const std::string& name) :
+  solver::ActionDirector(name),
+  m_send_offset(0),
+  m_receive_offset(0),
+  m_compute_time(0.),
+  m_nb_iterations(0)
+{
+  options().add("partner_color", 1)
+    .pretty_name("Partner Color")
+    .description("Color of the group of processes running the solver on the other side of the interface")
+    .attach_trigger(boost::bind(&ConcurrentCoupling::trigger_reset, this))
+    .mark_basic();
+
+  options().add("coupling", std::string("Jacobi"))
+    .pretty_name("Coupling")
+    .description("Jacobi: both groups solve at the same time. Staggered: the group that is not the leader waits for the leader to finish its iteration.")
+    .mark_basic();
+  options().option("coupling").restricted_list().push_back(std::string("Jacobi"));
+  options().option("coupling").restricted_list().push_back(std::string("Staggered"));
+
+  options().add("leader", true)
+    .pretty_name("Leader")
+    .description("For staggered coupling, true if this group solves first. Exactly one of the groups must be the leader.");
+
+  options().add("send_field", m_send_field)
+    .pretty_name("Send Field")
+    .description("Field containing the values that are sent to the other group")
+    .attach_trigger(boost::bind(&ConcurrentCoupling::trigger_reset, this))
+    .link_to(&m_send_field);
+
+  options().add("send_variable", std::string())
+    .pretty_name("Send Variable")
+    .description("Name of the variable that is sent to the other group")
+    .attach_trigger(boost::bind(&ConcurrentCoupling::trigger_reset, this));
+
+  options().add("receive_field", m_receive_field)
+    .pretty_name("Receive Field")
+    .description("Field in which the values received from the other group are stored")
+    .attach_trigger(boost::bind(&ConcurrentCoupling::trigger_reset, this))
+    .link_to(&m_receive_field);
+
+  options().add("receive_variable", std::string())
+    .pretty_name("Receive Variable")
+    .description("Name of the variable in which the values received from the other group are stored")
+    .attach_trigger(boost::bind(&ConcurrentCoupling::trigger_reset, this));
+
+  options().add("nb_neighbours", 0u)
+    .pretty_name("Number of Neighbours")
+    .description("Number of nodes of the other group used to interpolate at each interface node. Defaults to the dimension of the mesh.")
+    .attach_trigger(boost::bind(&ConcurrentCoupling::trigger_reset, this));
+
+  options().add("tolerance", 1e-10)
+    .pretty_name("Tolerance")
+    .description("Distance below which nodes of both groups are considered to coincide")
+    .attach_trigger(boost::bind(&ConcurrentCoupling::trigger_reset, this));
+
+  properties().add("compute_time", 0.);
+  properties().add("wait_time", 0.);
+  properties().add("overlap_efficiency", 1.);
+}
+
+ConcurrentCoupling::~ConcurrentCoupling()
+{
+}
+
+void ConcurrentCoupling::trigger_reset()
+{
+  // Changing the setup requires both groups to build a new map together
+  m_map.clear();
+  m_compute_time = 0.;
+  m_nb_iterations = 0;
+}
+
+void ConcurrentCoupling::on_regions_set()
+{
+  trigger_reset();
+}
+
+void ConcurrentCoupling::setup()
+{
+  if(is_null(m_send_field) || is_null(m_receive_field))
+    throw SetupError(FromHere(), "Fields to send and receive are not set for " + uri().path());
+
+  const std::string send_variable = options().value<std::string>("send_variable");
+  const std::string receive_variable = options().value<std::string>("receive_variable");
+  const Uint var_length = m_send_field->descriptor().var_length(send_variable);
+  if(m_receive_field->descriptor().var_length(receive_variable) != var_length)
+    throw SetupError(FromHere(), "Variables " + send_variable + " and " + receive_variable + " have a different size in " + uri().path());
+  m_send_offset = m_send_field->var_offset(send_variable);
+  m_receive_offset = m_receive_field->var_offset(receive_variable);
+
+  // Nodes on the interface. Only owned nodes are sent, while ghosts are received directly so no synchronization is needed.
+  const mesh::Dictionary& send_dict = m_send_field->dict();
+  const mesh::Dictionary& receive_dict = m_receive_field->dict();
+  std::set<Uint> send_nodes, receive_nodes;
+  BOOST_FOREACH(const Handle<mesh::Region>& region, m_loop_regions)
+  {
+    const boost::shared_ptr< List<Uint> > region_send_nodes = mesh::build_used_nodes_list(*region, send_dict, true);
+    BOOST_FOREACH(const Uint node, region_send_nodes->array())
+    {
+      if(!send_dict.is_ghost(node))
+        send_nodes.insert(node);
+    }
+    const boost::shared_ptr< List<Uint> > region_receive_nodes = mesh::build_used_nodes_list(*region, receive_dict, true);
+    receive_nodes.insert(region_receive_nodes->array().begin(), region_receive_nodes->array().end());
+  }
+
+  const Uint dim = send_dict.coordinates().row_size();
+  const Uint nb_neighbours = options().value<Uint>("nb_neighbours");
+  m_map.build(options().value<int>("partner_color"),
+              send_dict.coordinates().array(), std::vector<Uint>(send_nodes.begin(), send_nodes.end()),
+              receive_dict.coordinates().array(), std::vector<Uint>(receive_nodes.begin(), receive_nodes.end()),
+              var_length, nb_neighbours == 0 ? dim : nb_neighbours, options().value<Real>("tolerance"));
+
+  CFdebug << "ConcurrentCoupling " << uri().path() << ": sending " << send_nodes.size() << " and receiving " << receive_nodes.size()
+          << " interface nodes, " << m_map.nb_matched() << " coinciding" << CFendl;
+}
+
+void ConcurrentCoupling::solve()
+{
+  Timer timer;
+  solver::ActionDirector::execute();
+  m_compute_time += timer.elapsed();
+}
+
+void ConcurrentCoupling::execute()
+{
+  if(!m_map.is_built())
+    setup();
+
+  const bool staggered = options().value<std::string>("coupling") == "Staggered";
+  if(staggered && !options().value<bool>("leader"))
+  {
+    // Wait for the leader's result of this iteration
+    m_map.receive(m_receive_field->array(), m_receive_offset);
+    solve();
+    m_map.send(m_send_field->array(), m_send_offset);
+  }
+  else
+  {
+    solve();
+    m_map.send(m_send_field->array(), m_send_offset);
+    m_map.receive(m_receive_field->array(), m_receive_offset);
+  }
+
+  ++m_nb_iterations;
+  update_statistics();
+}
+
+void ConcurrentCoupling::update_statistics()
+{
+  Real local_times[2] = { m_compute_time, m_map.wait_time() };
+  Real group_times[2] = { local_times[0], local_times[1] };
+  PE::Comm& comm = PE::Comm::instance();
+  if(comm.is_active())
+    comm.all_reduce(PE::plus(), local_times, 2, group_times);
+
+  const Real total = group_times[0] + group_times[1];
+  const Real efficiency = total > 0. ? group_times[0] / total : 1.;
+  properties()["compute_time"] = m_compute_time;
+  properties()["wait_time"] = m_map.wait_time();
+  properties()["overlap_efficiency"] = efficiency;
+
+  CFdebug << "ConcurrentCoupling " << uri().path() << " iteration " << m_nb_iterations << ": group compute time " << group_times[0]
+          << " s, wait time " << group_times[1] << " s, overlap efficiency " << efficiency << CFendl;
+}
+
+} // UFEM
+} // cf3
@@ -0,0 +1,78 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_UFEM_ConcurrentCoupling_hpp
+#define cf3_UFEM_ConcurrentCoupling_hpp
+
+#include "solver/ActionDirector.hpp"
+
+#include "InterfaceMap.hpp"
+#include "LibUFEM.hpp"
+
+namespace cf3 {
+  namespace mesh { class Field; }
+namespace UFEM {
+
+/// Runs one coupling iteration of a solver that is coupled to a solver running concurrently on a different
+/// group of processes, e.g. the fluid and the solid of a conjugate heat transfer problem.
+/// The processes are split into groups using Core.split(color) in python, before any mesh is loaded,
+/// so each group loads and partitions its own mesh and runs its own model.
+/// The children of this component are the actions solving one iteration for this group. Before or after them,
+/// the values of "send_variable" on the nodes of the interface "regions" are sent to the group with color
+/// "partner_color", and the values received from that group are interpolated into "receive_variable".
+/// With "Jacobi" coupling, both groups solve at the same time using the interface data of the previous iteration.
+/// With "Staggered" coupling, the group that is not the "leader" waits for the leader's result of the same iteration.
+/// For conjugate heat transfer, the solid mesh can include a copy of the fluid cells along the interface. The fluid temperature
+/// is then received on these cells, so HeatCouplingFlux computes the heat flux from it as in a single mesh.
+/// The properties compute_time, wait_time and overlap_efficiency report how much time the processes of this group
+/// spent solving compared to waiting for the other group.
+class UFEM_API ConcurrentCoupling : public solver::ActionDirector
+{
+public:
+
+  /// Contructor
+  /// @param name of the component
+  ConcurrentCoupling ( const std::string& name );
+
+  virtual ~ConcurrentCoupling();
+
+  /// Get the class name
+  static std::string type_name () { return "ConcurrentCoupling"; }
+
+  virtual void execute();
+
+private:
+  /// Build the interface map. Collective over both groups.
+  void setup();
+
+  /// Invalidate the interface map when the configuration changes
+  void trigger_reset();
+
+  virtual void on_regions_set();
+
+  /// Execute the child actions and update the compute time
+  void solve();
+
+  /// Update the timing properties
+  void update_statistics();
+
+  InterfaceMap m_map;
+
+  Handle<mesh::Field> m_send_field;
+  Handle<mesh::Field> m_receive_field;
+
+  Uint m_send_offset;
+  Uint m_receive_offset;
+
+  Real m_compute_time;
+  Uint m_nb_iterations;
+};
+
+} // UFEM
+} // cf3
+
+
+#endif // cf3_UFEM_ConcurrentCoupling_hpp
@@ -0,0 +1,618 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "common/BasicExceptions.hpp"
+#include "common/Timer.hpp"
+#include "common/PE/Comm.hpp"
+
+#include "InterfaceMap.hpp"
+
+namespace cf3 {
+namespace UFEM {
+
+namespace detail
+{
+
+// Message tags, only used on the private communicator of the map
+const int coordinates_tag = 1;
+const int request_tag = 2;
+const int values_tag = 3;
+const int box_tag = 4;
+const int needed_tag = 5;
+
+template<typename T>
+T* data_ptr(std::vector<T>& v)
+{
+  return v.empty() ? nullptr : &v[0];
+}
+
+/// Receive a message with an unknown number of values from source
+template<typename T>
+void receive_vector(const int source, const int tag, MPI_Comm comm, std::vector<T>& result)
+{
+  MPI_Datatype datatype = common::PE::get_mpi_datatype<T>();
+  MPI_Status status;
+  MPI_CHECK_RESULT(MPI_Probe, (source, tag, comm, &status));
+  int count = 0;
+  MPI_CHECK_RESULT(MPI_Get_count, (&status, datatype, &count));
+  result.resize(count);
+  MPI_CHECK_RESULT(MPI_Recv, (data_ptr(result), count, datatype, source, tag, comm, MPI_STATUS_IGNORE));
+}
+
+/// Post the same message to all destinations
+template<typename T>
+void send_to_all(std::vector<T>& message, const std::vector<int>& destinations, const int tag, MPI_Comm comm, std::vector<MPI_Request>& requests)
+{
+  MPI_Datatype datatype = common::PE::get_mpi_datatype<T>();
+  requests.resize(destinations.size());
+  for(Uint p = 0; p != destinations.size(); ++p)
+    MPI_CHECK_RESULT(MPI_Isend, (data_ptr(message), static_cast<int>(message.size()), datatype, destinations[p], tag, comm, &requests[p]));
+}
+
+void wait_all(std::vector<MPI_Request>& requests)
+{
+  if(!requests.empty())
+    MPI_CHECK_RESULT(MPI_Waitall, (static_cast<int>(requests.size()), &requests[0], MPI_STATUSES_IGNORE));
+}
+
+/// Bounding box of the given rows of coordinates, as the minimum followed by the maximum of each coordinate.
+/// For an empty set of rows, the minimum is larger than the maximum.
+std::vector<Real> bounding_box(const InterfaceMap::ArrayT& coordinates, const std::vector<Uint>& rows, const Uint dim)
+{
+  std::vector<Real> box(2*dim);
+  std::fill(box.begin(), box.begin()+dim, std::numeric_limits<Real>::max());
+  std::fill(box.begin()+dim, box.end(), -std::numeric_limits<Real>::max());
+  for(Uint i = 0; i != rows.size(); ++i)
+  {
+    for(Uint d = 0; d != dim; ++d)
+    {
+      box[d] = std::min(box[d], coordinates[rows[i]][d]);
+      box[dim+d] = std::max(box[dim+d], coordinates[rows[i]][d]);
+    }
+  }
+  return box;
+}
+
+/// Squared distance between the closest points of two boxes
+Real squared_min_distance(const Real* a, const Real* b, const Uint dim)
+{
+  Real result = 0.;
+  for(Uint d = 0; d != dim; ++d)
+  {
+    const Real delta = std::max(0., std::max(a[d] - b[dim+d], b[d] - a[dim+d]));
+    result += delta*delta;
+  }
+  return result;
+}
+
+/// Squared distance between the farthest points of two boxes
+Real squared_max_distance(const Real* a, const Real* b, const Uint dim)
+{
+  Real result = 0.;
+  for(Uint d = 0; d != dim; ++d)
+  {
+    const Real delta = std::max(std::abs(a[dim+d] - b[d]), std::abs(b[dim+d] - a[d]));
+    result += delta*delta;
+  }
+  return result;
+}
+
+/// Uniform grid of cubic bins over a set of points, with the points sorted by bin, to find the nearest points without visiting all of them
+class PointBins
+{
+public:
+  /// coordinates holds the dim coordinates of each point, one point after the other. It must outlive the bins.
+  PointBins(const std::vector<Real>& coordinates, const Uint dim) :
+    m_coordinates(coordinates),
+    m_dim(dim)
+  {
+    cf3_assert(dim > 0 && dim <= 3);
+    const Uint nb_points = coordinates.size() / dim;
+    Real extents[3] = {0., 0., 0.};
+    Real max_extent = 0.;
+    for(Uint d = 0; d != 3; ++d)
+    {
+      m_origin[d] = 0.;
+      m_nb_cells[d] = 1;
+      if(d >= dim || nb_points == 0)
+        continue;
+      Real max_coord = coordinates[d];
+      m_origin[d] = coordinates[d];
+      for(Uint i = 1; i < nb_points; ++i)
+      {
+        m_origin[d] = std::min(m_origin[d], coordinates[i*dim + d]);
+        max_coord = std::max(max_coord, coordinates[i*dim + d]);
+      }
+      extents[d] = max_coord - m_origin[d];
+      max_extent = std::max(max_extent, extents[d]);
+    }
+
+    // Aim for about two points per bin. Interfaces are lines or surfaces, so directions in which the points hardly spread are left out
+    m_cell_size = 1.;
+    if(max_extent > 0.)
+    {
+      Real spread_volume = 1.;
+      Uint nb_spread_dims = 0;
+      for(Uint d = 0; d != dim; ++d)
+      {
+        if(extents[d] > 1e-3*max_extent)
+        {
+          spread_volume *= extents[d];
+          ++nb_spread_dims;
+        }
+      }
+      const Real target_nb_cells = std::max(1., 0.5*static_cast<Real>(nb_points));
+      m_cell_size = std::max(std::pow(spread_volume / target_nb_cells, 1. / static_cast<Real>(nb_spread_dims)), max_extent / target_nb_cells);
+      while(true)
+      {
+        Real total_nb_cells = 1.;
+        for(Uint d = 0; d != dim; ++d)
+          total_nb_cells *= std::floor(extents[d] / m_cell_size) + 1.;
+        if(total_nb_cells <= 4.*target_nb_cells + 8.)
+          break;
+        m_cell_size *= 2.;
+      }
+      for(Uint d = 0; d != dim; ++d)
+        m_nb_cells[d] = static_cast<int>(std::floor(extents[d] / m_cell_size)) + 1;
+    }
+
+    // Counting sort of the points by bin
+    const Uint nb_cells = m_nb_cells[0]*m_nb_cells[1]*m_nb_cells[2];
+    std::vector<Uint> point_cells(nb_points);
+    m_cell_starts.assign(nb_cells+1, 0);
+    for(Uint i = 0; i != nb_points; ++i)
+    {
+      int c[3];
+      cell(&coordinates[i*dim], c);
+      point_cells[i] = cell_index(c);
+      ++m_cell_starts[point_cells[i]+1];
+    }
+    for(Uint c = 0; c != nb_cells; ++c)
+      m_cell_starts[c+1] += m_cell_starts[c];
+    m_points.resize(nb_points);
+    std::vector<Uint> fill_positions(m_cell_starts.begin(), m_cell_starts.end()-1);
+    for(Uint i = 0; i != nb_points; ++i)
+      m_points[fill_positions[point_cells[i]]++] = i;
+  }
+
+  /// Store the nb_neighbours points closest to x in result, as (squared distance, point index) pairs sorted by distance.
+  /// Ties are broken by the point index.
+  void nearest(const Real* x, const Uint nb_neighbours, std::vector< std::pair<Real, Uint> >& result) const
+  {
+    result.clear();
+    if(nb_neighbours == 0)
+      return;
+
+    int c[3];
+    cell(x, c);
+    // Visit the bins ring by ring, where ring r holds the bins at a distance of r bins in the direction where they are farthest
+    for(int r = 0; ; ++r)
+    {
+      const int first2 = std::max(c[2]-r, 0), last2 = std::min(c[2]+r, m_nb_cells[2]-1);
+      const int first1 = std::max(c[1]-r, 0), last1 = std::min(c[1]+r, m_nb_cells[1]-1);
+      for(int i2 = first2; i2 <= last2; ++i2)
+      {
+        for(int i1 = first1; i1 <= last1; ++i1)
+        {
+          // Inside the ring, only the bins at both ends in the first direction are new
+          const bool on_ring = std::abs(i2-c[2]) == r || std::abs(i1-c[1]) == r;
+          const int step0 = on_ring || r == 0 ? 1 : 2*r;
+          for(int i0 = c[0]-r; i0 <= c[0]+r; i0 += step0)
+          {
+            if(i0 < 0 || i0 >= m_nb_cells[0])
+              continue;
+            const int bin[3] = {i0, i1, i2};
+            const Uint bin_idx = cell_index(bin);
+            for(Uint j = m_cell_starts[bin_idx]; j != m_cell_starts[bin_idx+1]; ++j)
+              add_candidate(x, m_points[j], nb_neighbours, result);
+          }
+        }
+      }
+
+      // Points outside the visited rings are at least as far as the nearest face of the visited block of bins
+      bool all_visited = true;
+      Real lower_bound = std::numeric_limits<Real>::max();
+      for(Uint d = 0; d != m_dim; ++d)
+      {
+        if(c[d]-r > 0)
+        {
+          all_visited = false;
+          lower_bound = std::min(lower_bound, x[d] - (m_origin[d] + static_cast<Real>(c[d]-r)*m_cell_size));
+        }
+        if(c[d]+r+1 < m_nb_cells[d])
+        {
+          all_visited = false;
+          lower_bound = std::min(lower_bound, m_origin[d] + static_cast<Real>(c[d]+r+1)*m_cell_size - x[d]);
+        }
+      }
+      if(all_visited || (result.size() == nb_neighbours && result.front().first < lower_bound*lower_bound))
+        break;
+    }
+    std::sort_heap(result.begin(), result.end());
+  }
+
+private:
+  /// Bin of a point, clamped to the grid
+  void cell(const Real* x, int* c) const
+  {
+    for(Uint d = 0; d != 3; ++d)
+    {
+      c[d] = 0;
+      if(d < m_dim)
+        c[d] = std::min(std::max(static_cast<int>(std::floor((x[d] - m_origin[d]) / m_cell_size)), 0), m_nb_cells[d]-1);
+    }
+  }
+
+  Uint cell_index(const int* c) const
+  {
+    return (c[2]*m_nb_cells[1] + c[1])*m_nb_cells[0] + c[0];
+  }
+
+  /// Keep the nb_neighbours closest points in result, which is a heap with the farthest point on top
+  void add_candidate(const Real* x, const Uint point, const Uint nb_neighbours, std::vector< std::pair<Real, Uint> >& result) const
+  {
+    Real squared_distance = 0.;
+    for(Uint d = 0; d != m_dim; ++d)
+    {
+      const Real delta = m_coordinates[point*m_dim + d] - x[d];
+      squared_distance += delta*delta;
+    }
+    const std::pair<Real, Uint> candidate(squared_distance, point);
+    if(result.size() < nb_neighbours)
+    {
+      result.push_back(candidate);
+      std::push_heap(result.begin(), result.end());
+    }
+    else if(candidate < result.front())
+    {
+      std::pop_heap(result.begin(), result.end());
+      result.back() = candidate;
+      std::push_heap(result.begin(), result.end());
+    }
+  }
+
+  const std::vector<Real>& m_coordinates;
+  const Uint m_dim;
+  Real m_origin[3];
+  Real m_cell_size;
+  int m_nb_cells[3];
+  /// Points sorted by bin, with the start of each bin in m_points
+  std::vector<Uint> m_cell_starts;
+  std::vector<Uint> m_points;
+};
+
+}
+
+InterfaceMap::InterfaceMap() :
+  m_is_built(false),
+  m_var_length(0),
+  m_comm(MPI_COMM_NULL),
+  m_nb_matched(0),
+  m_wait_time(0.)
+{
+}
+
+InterfaceMap::~InterfaceMap()
+{
+  if(common::PE::Comm::instance().is_active())
+    clear();
+}
+
+void InterfaceMap::build(const int partner_color,
+                         const ArrayT& source_coordinates, const std::vector<Uint>& source_nodes,
+                         const ArrayT& target_coordinates, const std::vector<Uint>& target_nodes,
+                         const Uint var_length, const Uint nb_neighbours, const Real tolerance)
+{
+  common::PE::Comm& comm = common::PE::Comm::instance();
+  if(!comm.is_active())
+    throw common::SetupError(FromHere(), "InterfaceMap requires an initialized parallel environment");
+  if(partner_color == comm.color())
+    throw common::BadValue(FromHere(), "InterfaceMap partner color " + common::to_str(partner_color) + " is the color of this process");
+  if(nb_neighbours == 0)
+    throw common::BadValue(FromHere(), "InterfaceMap needs at least one neighbour for the interpolation");
+
+  const Uint dim = source_coordinates.shape()[1];
+  if(target_coordinates.shape()[1] != dim)
+    throw common::BadValue(FromHere(), "Source and target coordinates for InterfaceMap have a different dimension");
+
+  clear();
+
+  // The duplicate is collective over the world communicator, so the other processes must all be in the partner group
+  m_partner_ranks = comm.group_world_ranks(partner_color);
+  int world_size = 0;
+  MPI_CHECK_RESULT(MPI_Comm_size, (comm.world_communicator(), &world_size));
+  if(comm.size() + m_partner_ranks.size() != static_cast<Uint>(world_size))
+    throw common::SetupError(FromHere(), "InterfaceMap requires the groups with colors " + common::to_str(comm.color()) + " and " + common::to_str(partner_color) + " to contain all processes");
+  MPI_CHECK_RESULT(MPI_Comm_dup, (comm.world_communicator(), &m_comm));
+  m_var_length = var_length;
+  const Uint nb_partners = m_partner_ranks.size();
+
+  // Send the dimension, the number of values per node, the number of source nodes and their bounding box to all partner processes
+  const std::vector<Real> source_box = detail::bounding_box(source_coordinates, source_nodes, dim);
+  std::vector<Real> header;
+  header.reserve(3 + 2*dim);
+  header.push_back(static_cast<Real>(dim));
+  header.push_back(static_cast<Real>(var_length));
+  header.push_back(static_cast<Real>(source_nodes.size()));
+  header.insert(header.end(), source_box.begin(), source_box.end());
+  std::vector<MPI_Request> requests;
+  detail::send_to_all(header, m_partner_ranks, detail::box_tag, m_comm, requests);
+
+  std::vector<Real> partner_boxes(nb_partners*2*dim);
+  std::vector<Uint> partner_counts(nb_partners);
+  std::vector<Real> message;
+  for(Uint p = 0; p != nb_partners; ++p)
+  {
+    detail::receive_vector(m_partner_ranks[p], detail::box_tag, m_comm, message);
+    if(message.size() != 3 + 2*dim || static_cast<Uint>(message[0]) != dim || static_cast<Uint>(message[1]) != var_length)
+      throw common::SetupError(FromHere(), "Dimension or number of values per node for InterfaceMap differ from those on process " + common::to_str(m_partner_ranks[p]));
+    partner_counts[p] = static_cast<Uint>(message[2]);
+    std::copy(message.begin()+3, message.end(), partner_boxes.begin() + p*2*dim);
+  }
+  detail::wait_all(requests);
+
+  Uint nb_partner_sources = 0;
+  for(Uint p = 0; p != nb_partners; ++p)
+    nb_partner_sources += partner_counts[p];
+  const Uint nb_targets = target_nodes.size();
+  if(nb_targets != 0 && nb_partner_sources == 0)
+    throw common::SetupError(FromHere(), "InterfaceMap found no source nodes in the group with color " + common::to_str(partner_color));
+  const Uint nb_used_neighbours = std::min(nb_neighbours, nb_partner_sources);
+
+  // The nearest sources of any target node lie within the distance from the target box to the far side of the closest partner boxes
+  // that hold enough sources together, so only the partners with a box within that distance can contribute to a stencil
+  std::vector<int> is_needed(nb_partners, 0);
+  if(nb_targets != 0)
+  {
+    const std::vector<Real> target_box = detail::bounding_box(target_coordinates, target_nodes, dim);
+    std::vector< std::pair<Real, Uint> > far_distances;
+    for(Uint p = 0; p != nb_partners; ++p)
+    {
+      if(partner_counts[p] != 0)
+        far_distances.push_back(std::make_pair(detail::squared_max_distance(&target_box[0], &partner_boxes[p*2*dim], dim), p));
+    }
+    std::sort(far_distances.begin(), far_distances.end());
+    Real squared_radius = 0.;
+    Uint nb_enclosed = 0;
+    for(Uint i = 0; i != far_distances.size() && nb_enclosed < nb_used_neighbours; ++i)
+    {
+      squared_radius = far_distances[i].first;
+      nb_enclosed += partner_counts[far_distances[i].second];
+    }
+    for(Uint p = 0; p != nb_partners; ++p)
+      is_needed[p] = partner_counts[p] != 0 && detail::squared_min_distance(&target_box[0], &partner_boxes[p*2*dim], dim) <= squared_radius;
+  }
+
+  // Tell each partner if its source coordinates are needed, and send ours to the partners that need them
+  requests.resize(nb_partners);
+  for(Uint p = 0; p != nb_partners; ++p)
+    MPI_CHECK_RESULT(MPI_Isend, (&is_needed[p], 1, MPI_INT, m_partner_ranks[p], detail::needed_tag, m_comm, &requests[p]));
+  std::vector<int> coordinate_destinations;
+  for(Uint p = 0; p != nb_partners; ++p)
+  {
+    int is_needed_by_partner = 0;
+    MPI_CHECK_RESULT(MPI_Recv, (&is_needed_by_partner, 1, MPI_INT, m_partner_ranks[p], detail::needed_tag, m_comm, MPI_STATUS_IGNORE));
+    if(is_needed_by_partner)
+      coordinate_destinations.push_back(m_partner_ranks[p]);
+  }
+  detail::wait_all(requests);
+
+  std::vector<Real> source_message;
+  source_message.reserve(source_nodes.size()*dim);
+  for(Uint i = 0; i != source_nodes.size(); ++i)
+  {
+    for(Uint d = 0; d != dim; ++d)
+      source_message.push_back(source_coordinates[source_nodes[i]][d]);
+  }
+  detail::send_to_all(source_message, coordinate_destinations, detail::coordinates_tag, m_comm, requests);
+
+  // Coordinates of the source nodes of the needed partner processes, concatenated
+  std::vector<Real> partner_coordinates;
+  std::vector<Uint> partner_starts(nb_partners+1, 0);
+  for(Uint p = 0; p != nb_partners; ++p)
+  {
+    partner_starts[p+1] = partner_starts[p];
+    if(!is_needed[p])
+      continue;
+    detail::receive_vector(m_partner_ranks[p], detail::coordinates_tag, m_comm, message);
+    if(message.size() != partner_counts[p]*dim)
+      throw common::SetupError(FromHere(), "InterfaceMap received a wrong number of source coordinates from process " + common::to_str(m_partner_ranks[p]));
+    partner_coordinates.insert(partner_coordinates.end(), message.begin(), message.end());
+    partner_starts[p+1] += partner_counts[p];
+  }
+  detail::wait_all(requests);
+
+  const Uint nb_sources = partner_starts.back();
+
+  // Stencils, referring to the concatenated partner sources
+  const detail::PointBins bins(partner_coordinates, dim);
+  const Real squared_tolerance = tolerance*tolerance;
+  std::vector< std::pair<Real, Uint> > distances;
+  std::vector<Real> target_coords(dim);
+  m_target_nodes = target_nodes;
+  m_stencil_starts.assign(1, 0);
+  m_stencil_indices.clear();
+  m_stencil_weights.clear();
+  for(Uint t = 0; t != nb_targets; ++t)
+  {
+    for(Uint d = 0; d != dim; ++d)
+      target_coords[d] = target_coordinates[target_nodes[t]][d];
+    bins.nearest(&target_coords[0], nb_used_neighbours, distances);
+
+    if(distances.front().first <= squared_tolerance)
+    {
+      m_stencil_indices.push_back(distances.front().second);
+      m_stencil_weights.push_back(1.);
+      ++m_nb_matched;
+    }
+    else
+    {
+      Real weight_sum = 0.;
+      for(Uint i = 0; i != nb_used_neighbours; ++i)
+        weight_sum += 1. / std::sqrt(distances[i].first);
+      for(Uint i = 0; i != nb_used_neighbours; ++i)
+      {
+        m_stencil_indices.push_back(distances[i].second);
+        m_stencil_weights.push_back(1. / (std::sqrt(distances[i].first) * weight_sum));
+      }
+    }
+    m_stencil_starts.push_back(m_stencil_indices.size());
+  }
+
+  // Only the source nodes used in a stencil are requested. Their position in the receive buffer follows the order of the partners.
+  std::vector<bool> is_used(nb_sources, false);
+  for(Uint i = 0; i != m_stencil_indices.size(); ++i)
+    is_used[m_stencil_indices[i]] = true;
+
+  const Uint invalid_position = std::numeric_limits<Uint>::max();
+  std::vector<Uint> receive_positions(nb_sources, invalid_position);
+  std::vector< std::vector<Uint> > partner_requests(nb_partners);
+  m_receive_offsets.assign(1, 0);
+  Uint nb_received = 0;
+  for(Uint p = 0; p != nb_partners; ++p)
+  {
+    for(Uint s = partner_starts[p]; s != partner_starts[p+1]; ++s)
+    {
+      if(is_used[s])
+      {
+        receive_positions[s] = nb_received++;
+        partner_requests[p].push_back(s - partner_starts[p]);
+      }
+    }
+    m_receive_offsets.push_back(nb_received);
+  }
+  for(Uint i = 0; i != m_stencil_indices.size(); ++i)
+  {
+    cf3_assert(receive_positions[m_stencil_indices[i]] != invalid_position);
+    m_stencil_indices[i] = receive_positions[m_stencil_indices[i]];
+  }
+
+  // Tell each partner which of its nodes are needed, and find out which of our nodes each partner needs
+  requests.resize(nb_partners);
+  MPI_Datatype uint_type = common::PE::get_mpi_datatype<Uint>();
+  for(Uint p = 0; p != nb_partners; ++p)
+    MPI_CHECK_RESULT(MPI_Isend, (detail::data_ptr(partner_requests[p]), static_cast<int>(partner_requests[p].size()), uint_type, m_partner_ranks[p], detail::request_tag, m_comm, &requests[p]));
+
+  m_send_nodes.resize(nb_partners);
+  m_send_buffers.resize(nb_partners);
+  std::vector<Uint> requested;
+  for(Uint p = 0; p != nb_partners; ++p)
+  {
+    detail::receive_vector(m_partner_ranks[p], detail::request_tag, m_comm, requested);
+    m_send_nodes[p].resize(requested.size());
+    for(Uint i = 0; i != requested.size(); ++i)
+    {
+      if(requested[i] >= source_nodes.size())
+        throw common::SetupError(FromHere(), "Process " + common::to_str(m_partner_ranks[p]) + " requested an invalid interface node");
+      m_send_nodes[p][i] = source_nodes[requested[i]];
+    }
+    m_send_buffers[p].resize(requested.size()*var_length);
+  }
+  detail::wait_all(requests);
+
+  m_receive_buffer.resize(nb_received*var_length);
+  m_send_requests.assign(nb_partners, MPI_REQUEST_NULL);
+  m_receive_requests.assign(nb_partners, MPI_REQUEST_NULL);
+  m_is_built = true;
+}
+
+void InterfaceMap::clear()
+{
+  if(m_is_built)
+    wait_sends();
+  if(m_comm != MPI_COMM_NULL)
+    MPI_CHECK_RESULT(MPI_Comm_free, (&m_comm));
+
+  m_is_built = false;
+  m_var_length = 0;
+  m_partner_ranks.clear();
+  m_send_nodes.clear();
+  m_send_buffers.clear();
+  m_send_requests.clear();
+  m_receive_offsets.clear();
+  m_receive_buffer.clear();
+  m_receive_requests.clear();
+  m_target_nodes.clear();
+  m_stencil_starts.clear();
+  m_stencil_indices.clear();
+  m_stencil_weights.clear();
+  m_nb_matched = 0;
+  m_wait_time = 0.;
+}
+
+void InterfaceMap::send(const ArrayT& values, const Uint offset)
+{
+  if(!m_is_built)
+    throw common::SetupError(FromHere(), "InterfaceMap::send called before build");
+  cf3_assert(offset + m_var_length <= values.shape()[1]);
+
+  // The buffers are reused, so the previous messages must have been delivered
+  wait_sends();
+
+  MPI_Datatype real_type = common::PE::get_mpi_datatype<Real>();
+  const Uint nb_partners = m_partner_ranks.size();
+  for(Uint p = 0; p != nb_partners; ++p)
+  {
+    const std::vector<Uint>& nodes = m_send_nodes[p];
+    if(nodes.empty())
+      continue;
+
+    std::vector<Real>& buffer = m_send_buffers[p];
+    for(Uint i = 0; i != nodes.size(); ++i)
+    {
+      for(Uint j = 0; j != m_var_length; ++j)
+        buffer[i*m_var_length + j] = values[nodes[i]][offset + j];
+    }
+    MPI_CHECK_RESULT(MPI_Isend, (&buffer[0], static_cast<int>(buffer.size()), real_type, m_partner_ranks[p], detail::values_tag, m_comm, &m_send_requests[p]));
+  }
+}
+
+void InterfaceMap::receive(ArrayT& values, const Uint offset)
+{
+  if(!m_is_built)
+    throw common::SetupError(FromHere(), "InterfaceMap::receive called before build");
+  cf3_assert(offset + m_var_length <= values.shape()[1]);
+
+  MPI_Datatype real_type = common::PE::get_mpi_datatype<Real>();
+  const Uint nb_partners = m_partner_ranks.size();
+  for(Uint p = 0; p != nb_partners; ++p)
+  {
+    const Uint nb_nodes = m_receive_offsets[p+1] - m_receive_offsets[p];
+    if(nb_nodes == 0)
+      continue;
+    MPI_CHECK_RESULT(MPI_Irecv, (&m_receive_buffer[m_receive_offsets[p]*m_var_length], static_cast<int>(nb_nodes*m_var_length), real_type, m_partner_ranks[p], detail::values_tag, m_comm, &m_receive_requests[p]));
+  }
+
+  common::Timer timer;
+  detail::wait_all(m_receive_requests);
+  m_wait_time += timer.elapsed();
+
+  const Uint nb_targets = m_target_nodes.size();
+  for(Uint t = 0; t != nb_targets; ++t)
+  {
+    for(Uint j = 0; j != m_var_length; ++j)
+    {
+      Real value = 0.;
+      for(Uint i = m_stencil_starts[t]; i != m_stencil_starts[t+1]; ++i)
+        value += m_stencil_weights[i] * m_receive_buffer[m_stencil_indices[i]*m_var_length + j];
+      values[m_target_nodes[t]][offset + j] = value;
+    }
+  }
+}
+
+void InterfaceMap::wait_sends()
+{
+  common::Timer timer;
+  detail::wait_all(m_send_requests);
+  m_wait_time += timer.elapsed();
+}
+
+} // UFEM
+} // cf3
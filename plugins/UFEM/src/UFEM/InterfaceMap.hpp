@@ -0,0 +1,111 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_UFEM_InterfaceMap_hpp
+#define cf3_UFEM_InterfaceMap_hpp
+
+#include <vector>
+
+#include <mpi.h>
+
+#include "common/Table.hpp"
+
+#include "LibUFEM.hpp"
+
+namespace cf3 {
+namespace UFEM {
+
+/// Transfers nodal values across an interface between two groups of processes, created using common::PE::Comm::split.
+/// Each process sends the values of its own interface nodes (the sources) and receives interpolated values for
+/// the interface nodes of its own mesh (the targets). The interpolation stencils and the communication pattern are
+/// computed once by build, after which send and receive only use nonblocking point-to-point messages over a private
+/// duplicate of the world communicator, so a group never waits for the other group unless it really needs its data,
+/// and the messages can not be mixed up with other communication between the groups.
+/// Each target value is the inverse distance weighted average of the nearest source values, which is exact
+/// for linear variations along a line interface when 2 neighbours are used. Coinciding nodes are copied directly.
+/// Source coordinates are only sent to partners whose target bounding box is close enough to hold some of their
+/// nearest neighbours, and the nearest sources are found using a uniform grid of bins.
+class UFEM_API InterfaceMap
+{
+public:
+  typedef common::Table<Real>::ArrayT ArrayT;
+
+  InterfaceMap();
+  ~InterfaceMap();
+
+  /// Compute the interpolation stencils and the communication pattern. Collective over the processes of both groups,
+  /// which must make up the whole world communicator.
+  /// @param partner_color Color of the group of processes on the other side of the interface
+  /// @param source_coordinates Coordinates array for the source nodes
+  /// @param source_nodes Rows in source_coordinates of the nodes whose values are sent. Should not include ghost nodes.
+  /// @param target_coordinates Coordinates array for the target nodes
+  /// @param target_nodes Rows in target_coordinates of the nodes whose values are received
+  /// @param var_length Number of values per node. Must be the same in both groups
+  /// @param nb_neighbours Number of source nodes used to interpolate at each target node
+  /// @param tolerance Distance below which nodes are considered to coincide
+  void build(const int partner_color,
+             const ArrayT& source_coordinates, const std::vector<Uint>& source_nodes,
+             const ArrayT& target_coordinates, const std::vector<Uint>& target_nodes,
+             const Uint var_length, const Uint nb_neighbours, const Real tolerance);
+
+  /// Release the map and its communicator, waiting for pending messages first
+  void clear();
+
+  /// True if build was called
+  bool is_built() const { return m_is_built; }
+
+  /// Start sending columns [offset, offset+var_length) of the source rows of values to the partner group.
+  /// Returns without waiting for the messages to arrive.
+  void send(const ArrayT& values, const Uint offset);
+
+  /// Receive the values from the partner group and store the interpolated values in
+  /// columns [offset, offset+var_length) of the target rows of values.
+  void receive(ArrayT& values, const Uint offset);
+
+  /// Wait until the messages posted by the last send have been delivered
+  void wait_sends();
+
+  /// Total time spent waiting for messages, in seconds
+  Real wait_time() const { return m_wait_time; }
+
+  /// Number of target nodes that were matched to a coinciding source node
+  Uint nb_matched() const { return m_nb_matched; }
+
+private:
+  bool m_is_built;
+  Uint m_var_length;
+
+  /// Duplicate of the world communicator, used for all messages of the map
+  MPI_Comm m_comm;
+
+  /// World ranks of the partner processes
+  std::vector<int> m_partner_ranks;
+
+  /// For each partner process, the local source nodes it needs, in the order they are sent
+  std::vector< std::vector<Uint> > m_send_nodes;
+  std::vector< std::vector<Real> > m_send_buffers;
+  std::vector<MPI_Request> m_send_requests;
+
+  /// For each partner process, the offset of its values in m_receive_buffer (size is nb_partners+1)
+  std::vector<Uint> m_receive_offsets;
+  std::vector<Real> m_receive_buffer;
+  std::vector<MPI_Request> m_receive_requests;
+
+  /// Interpolation stencils in compressed row storage: for each target node, the positions in the receive buffer and the weights
+  std::vector<Uint> m_target_nodes;
+  std::vector<Uint> m_stencil_starts;
+  std::vector<Uint> m_stencil_indices;
+  std::vector<Real> m_stencil_weights;
+
+  Uint m_nb_matched;
+  Real m_wait_time;
+};
+
+} // UFEM
+} // cf3
+
+
+#endif // cf3_UFEM_InterfaceMap_hpp
@@ -11,6 +11,10 @@
 #include "common/Log.hpp"
 #include "common/Option.hpp"
 #include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+
+#include "math/LSS/SolutionStrategy.hpp"
+#include "math/LSS/System.hpp"
 
 #include "mesh/Dictionary.hpp"
 #include "mesh/Field.hpp"
@@ -35,6 +39,12 @@ LSSActionUnsteady::LSSActionUnsteady(const std::string& name) :
     .description("Component that keeps track of time for this simulation")
     .attach_trigger(boost::bind(&LSSActionUnsteady::trigger_time, this))
     .link_to(&m_time);
+
+  options().add("history", m_history)
+    .pretty_name("History")
+    .description("History component used to log the iteration count of the linear solver. "
+                 "Entries are only saved by this action if the History is one of its children")
+    .link_to(&m_history);
 }
 
 LSSActionUnsteady::~LSSActionUnsteady()
@@ -56,6 +66,30 @@ const solver::Time& LSSActionUnsteady::time() const
   return *m_time;
 }
 
+void LSSActionUnsteady::execute()
+{
+  LSSAction::execute();
+
+  if(is_null(m_history))
+    return;
+
+  Handle<math::LSS::System> lss = options().value< Handle<math::LSS::System> >("lss");
+  if(is_null(lss) || is_null(lss->solution_strategy()))
+    return;
+
+  const PropertyList& strategy_properties = lss->solution_strategy()->properties();
+  if(!strategy_properties.check("iterations"))
+    return;
+
+  m_history->set(name() + "_iterations", static_cast<Real>(strategy_properties.value<int>("iterations")));
+  if(strategy_properties.check("iterations_saved"))
+    m_history->set(name() + "_iterations_saved", strategy_properties.value<Real>("iterations_saved"));
+
+  // A shared History is saved by its owner, saving here as well would record each step twice
+  if(m_history->parent() == handle<Component>())
+    m_history->save_entry();
+}
+
 void LSSActionUnsteady::trigger_time()
 {
   if(is_null(m_time))
@@ -7,6 +7,7 @@
 #ifndef cf3_UFEM_LSSActionUnsteady_hpp
 #define cf3_UFEM_LSSActionUnsteady_hpp
 
+#include "solver/History.hpp"
 #include "solver/Time.hpp"
 
 #include "LibUFEM.hpp"
@@ -21,6 +22,9 @@ namespace UFEM {
 /// * Physical model
 /// * Mesh used
 /// * Region to loop over
+/// If a History component is set, the iteration count of the linear solver is set in it after each execution.
+/// The entry is only saved here if the History is a child of this action. Otherwise it is saved by its owner,
+/// e.g. the time loop, so each step is recorded once.
 class UFEM_API LSSActionUnsteady : public LSSAction
 {
 public: // functions
@@ -42,12 +46,15 @@ public: // functions
 
   const solver::Time& time() const;
 
+  virtual void execute();
+
 private:
 
   void trigger_time();
   void trigger_timestep();
 
   Handle<solver::Time> m_time;
+  Handle<solver::History> m_history;
   Real m_dt, m_invdt;
 };
 
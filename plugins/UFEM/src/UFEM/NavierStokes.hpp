@@ -68,10 +68,10 @@ private:
 
   /// Helper functions to split the compilation over multiple units, to save memory. Each one is in a different cpp file.
   void set_triag_assembly(const bool use_specialization);
-  void set_quad_assembly();
+  void set_quad_assembly(const bool use_specialization);
   void set_tetra_assembly(const bool use_specialization);
-  void set_hexa_assembly();
-  void set_prism_assembly();
+  void set_hexa_assembly(const bool use_specialization);
+  void set_prism_assembly(const bool use_specialization);
   
 
   /// The velocity solution field
@@ -66,6 +66,7 @@ void NavierStokes::set_assembly_expression(const std::string& action_name)
           )
         ),
         for_specialized_elements(supg_specialized(p, u, u_adv, nu_eff, lit(dt()), rho, _A, _T)),
+        for_specialized_elements(supg_specialized_body_force(u, u_adv, nu_eff, lit(dt()), g, _a)),
         system_rhs += -_A * _x + _a,
         _A(p) = _A(p) / theta,
         system_matrix += invdt() * _T + theta * _A
@@ -11,6 +11,10 @@
 
 #include "mesh/LagrangeP1/Triag2D.hpp"
 #include "mesh/LagrangeP1/Tetra3D.hpp"
+#include "mesh/LagrangeP1/Quad2D.hpp"
+#include "mesh/LagrangeP1/Hexa3D.hpp"
+#include "mesh/LagrangeP1/Prism3D.hpp"
+#include "mesh/Integrators/Gauss.hpp"
 
 #include "solver/actions/Proto/ElementOperations.hpp"
 
@@ -21,8 +25,46 @@ namespace cf3 {
 
 namespace UFEM {
 
+namespace detail
+{
+
+/// Shape function values, local gradients and weights at the Gauss points, computed once for each element type.
+/// The integration order is the same as the one used by element_quadrature for P1 elements.
+template<typename ElementT>
+struct SUPGQuadratureTable
+{
+  typedef mesh::Integrators::GaussMappedCoords<2, ElementT::shape> GaussT;
+  static const Uint nb_points = GaussT::nb_points;
+
+  static const SUPGQuadratureTable& instance()
+  {
+    static const SUPGQuadratureTable table;
+    return table;
+  }
+
+  typename ElementT::SF::ValueT values[nb_points];
+  typename ElementT::SF::GradientT gradients[nb_points];
+  Real weights[nb_points];
+
+private:
+  SUPGQuadratureTable()
+  {
+    for(Uint q = 0; q != nb_points; ++q)
+    {
+      const typename ElementT::MappedCoordsT mapped_coords = GaussT::instance().coords.col(q);
+      ElementT::SF::compute_value(mapped_coords, values[q]);
+      ElementT::SF::compute_gradient(mapped_coords, gradients[q]);
+      weights[q] = GaussT::instance().weights[q];
+    }
+  }
+};
+
+}
+
 /// Construct element matrix efficiently for 2D P1 triangles and 3D P1 Tetrahedra
 /// Code from CF2 by Tamás Bányai
+/// Quadrilaterals, hexahedra and prisms use Gauss quadrature with precomputed shape function tables, resulting in the same
+/// element matrices as the generic assembly
 struct SUPGSpecialized
 {
   typedef void result_type;
@@ -146,6 +188,107 @@ struct SUPGSpecialized
     }
   }
 
+  /// Specialization for quadrilaterals
+  template<typename PT, typename UT, typename UADVT, typename NUT, typename MatrixT>
+  void apply(const mesh::LagrangeP1::Quad2D&, const PT& p, const UT& u, const UADVT& u_adv, const NUT& nu_eff, const Real& dt, const Real& rho, MatrixT& A, MatrixT& T) const
+  {
+    apply_quadrature<mesh::LagrangeP1::Quad2D>(p, u, u_adv, nu_eff, dt, rho, A, T);
+  }
+
+  /// Specialization for hexahedra
+  template<typename PT, typename UT, typename UADVT, typename NUT, typename MatrixT>
+  void apply(const mesh::LagrangeP1::Hexa3D&, const PT& p, const UT& u, const UADVT& u_adv, const NUT& nu_eff, const Real& dt, const Real& rho, MatrixT& A, MatrixT& T) const
+  {
+    apply_quadrature<mesh::LagrangeP1::Hexa3D>(p, u, u_adv, nu_eff, dt, rho, A, T);
+  }
+
+  /// Specialization for prisms
+  template<typename PT, typename UT, typename UADVT, typename NUT, typename MatrixT>
+  void apply(const mesh::LagrangeP1::Prism3D&, const PT& p, const UT& u, const UADVT& u_adv, const NUT& nu_eff, const Real& dt, const Real& rho, MatrixT& A, MatrixT& T) const
+  {
+    apply_quadrature<mesh::LagrangeP1::Prism3D>(p, u, u_adv, nu_eff, dt, rho, A, T);
+  }
+
+  /// Quadrature-based element matrix for elements with a non-constant Jacobian. The terms are the same as in the generic
+  /// expression in NavierStokesAssembly.hpp, but are accumulated in fixed-size blocks that are added to the element matrices at the end.
+  template<typename ElementT, typename PT, typename UT, typename UADVT, typename NUT, typename MatrixT>
+  void apply_quadrature(const PT& p, const UT& u, const UADVT& u_adv, const NUT& nu_eff, const Real& dt, const Real& rho, MatrixT& A, MatrixT& T) const
+  {
+    static const Uint nb_nodes = ElementT::nb_nodes;
+    static const Uint dim = ElementT::dimension;
+    typedef Eigen::Matrix<Real, 1, nb_nodes> RowT;
+    typedef Eigen::Matrix<Real, 1, dim> VelocityT;
+    typedef Eigen::Matrix<Real, dim, nb_nodes> GradientT;
+    typedef Eigen::Matrix<Real, dim, dim> JacobianT;
+    typedef Eigen::Matrix<Real, nb_nodes, nb_nodes> BlockT;
+
+    const detail::SUPGQuadratureTable<ElementT>& table = detail::SUPGQuadratureTable<ElementT>::instance();
+    const typename ElementT::NodesT& nodes = u.support().nodes();
+    const typename ElementT::NodesT u_nodes = u_adv.value();
+    const Eigen::Matrix<Real, nb_nodes, 1> nu_nodes = nu_eff.value();
+
+    Real tau_ps, tau_su, tau_bulk;
+    ComputeTauImpl compute_tau;
+    compute_tau.compute_coefficients(u_adv, fabs(nu_nodes.mean()), dt, tau_ps, tau_su, tau_bulk);
+
+    BlockT A_pp = BlockT::Zero();
+    BlockT A_uu = BlockT::Zero(); // Diffusion and advection, same for each velocity component
+    BlockT T_uu = BlockT::Zero();
+    BlockT A_pu[dim];
+    BlockT A_up[dim];
+    BlockT T_pu[dim];
+    BlockT A_uv[dim][dim]; // Bulk viscosity and skew symmetric advection, coupling the velocity components
+    for(Uint i = 0; i != dim; ++i)
+    {
+      A_pu[i].setZero();
+      A_up[i].setZero();
+      T_pu[i].setZero();
+      for(Uint j = 0; j != dim; ++j)
+        A_uv[i][j].setZero();
+    }
+
+    for(Uint q = 0; q != table.nb_points; ++q)
+    {
+      const RowT& sf = table.values[q];
+      const JacobianT jacobian = table.gradients[q] * nodes;
+      const Real w = table.weights[q] * jacobian.determinant();
+      const GradientT nabla = jacobian.inverse() * table.gradients[q];
+
+      const VelocityT u_q = sf * u_nodes;
+      const Real nu_q = sf.dot(nu_nodes.transpose());
+      const RowT advection = u_q * nabla;
+      const RowT supg_weight = sf + tau_su*advection;
+      const RowT pspg_weight = sf + 0.5*tau_ps*advection;
+
+      A_pp.noalias() += (w*tau_ps/rho) * nabla.transpose() * nabla;
+      A_uu.noalias() += w * (nu_q * nabla.transpose() * nabla + supg_weight.transpose() * advection);
+      T_uu.noalias() += w * supg_weight.transpose() * sf;
+      for(Uint i = 0; i != dim; ++i)
+      {
+        A_pu[i].noalias() += w * (pspg_weight.transpose() * nabla.row(i) + tau_ps * nabla.row(i).transpose() * advection);
+        A_up[i].noalias() += (w/rho) * supg_weight.transpose() * nabla.row(i);
+        T_pu[i].noalias() += (w*tau_ps) * nabla.row(i).transpose() * sf;
+        const RowT coupling_weight = tau_bulk*nabla.row(i) + 0.5*u_q[i]*supg_weight;
+        for(Uint j = 0; j != dim; ++j)
+          A_uv[i][j].noalias() += w * coupling_weight.transpose() * nabla.row(j);
+      }
+    }
+
+    const Uint P = nb_nodes*p.offset;
+    A.template block<nb_nodes, nb_nodes>(P, P) += A_pp;
+    for(Uint i = 0; i != dim; ++i)
+    {
+      const Uint Ui = nb_nodes*(u.offset + i);
+      A.template block<nb_nodes, nb_nodes>(P, Ui) += A_pu[i];
+      A.template block<nb_nodes, nb_nodes>(Ui, P) += A_up[i];
+      A.template block<nb_nodes, nb_nodes>(Ui, Ui) += A_uu;
+      T.template block<nb_nodes, nb_nodes>(P, Ui) += T_pu[i];
+      T.template block<nb_nodes, nb_nodes>(Ui, Ui) += T_uu;
+      for(Uint j = 0; j != dim; ++j)
+        A.template block<nb_nodes, nb_nodes>(Ui, nb_nodes*(u.offset + j)) += A_uv[i][j];
+    }
+  }
+
   /// Specialization for tetrahedra
   template<typename PT, typename UT, typename UADVT, typename NUT, typename MatrixT>
   void apply(const mesh::LagrangeP1::Tetra3D&, const PT& p, const UT& u, const UADVT& u_adv, const NUT& nu_eff, const Real& dt, const Real& rho, MatrixT& A, MatrixT& T) const
@@ -302,8 +445,52 @@ struct SUPGSpecialized
   }
 };
 
+/// Body force term transpose(N(u) + tau_su*u_adv*nabla(u)) * g[_i] of the generic assembly, for the specialized element types.
+/// This is separate from SUPGSpecialized to stay within the maximum number of arguments of a custom op.
+struct SUPGSpecializedBodyForce
+{
+  typedef void result_type;
+
+  template<typename UT, typename UADVT, typename NUT, typename GT, typename VectorT>
+  void operator()(const UT& u, const UADVT& u_adv, const NUT& nu_eff, const Real& dt, const GT& g, VectorT& a) const
+  {
+    typedef typename UT::EtypeT ElementT;
+    static const Uint nb_nodes = ElementT::nb_nodes;
+    static const Uint dim = ElementT::dimension;
+    typedef Eigen::Matrix<Real, 1, nb_nodes> RowT;
+    typedef Eigen::Matrix<Real, 1, dim> VelocityT;
+    typedef Eigen::Matrix<Real, dim, nb_nodes> GradientT;
+    typedef Eigen::Matrix<Real, dim, dim> JacobianT;
+
+    const typename ElementT::NodesT g_nodes = g.value();
+    if((g_nodes.array() == 0.).all())
+      return;
+
+    const detail::SUPGQuadratureTable<ElementT>& table = detail::SUPGQuadratureTable<ElementT>::instance();
+    const typename ElementT::NodesT& nodes = u.support().nodes();
+    const typename ElementT::NodesT u_nodes = u_adv.value();
+
+    Real tau_ps, tau_su, tau_bulk;
+    ComputeTauImpl compute_tau;
+    compute_tau.compute_coefficients(u_adv, fabs(nu_eff.value().mean()), dt, tau_ps, tau_su, tau_bulk);
+
+    for(Uint q = 0; q != table.nb_points; ++q)
+    {
+      const RowT& sf = table.values[q];
+      const JacobianT jacobian = table.gradients[q] * nodes;
+      const Real w = table.weights[q] * jacobian.determinant();
+      const GradientT nabla = jacobian.inverse() * table.gradients[q];
+      const RowT supg_weight = sf + tau_su * (sf * u_nodes) * nabla;
+      const VelocityT g_q = sf * g_nodes;
+      for(Uint i = 0; i != dim; ++i)
+        a.template segment<nb_nodes>(nb_nodes*(u.offset + i)) += (w*g_q[i]) * supg_weight.transpose();
+    }
+  }
+};
+
 /// Placeholder for the specialized ops, to be used as function inside proto expressions
 static solver::actions::Proto::MakeSFOp<SUPGSpecialized>::type const supg_specialized = {};
+static solver::actions::Proto::MakeSFOp<SUPGSpecializedBodyForce>::type const supg_specialized_body_force = {};
 
 } // UFEM
 } // cf3
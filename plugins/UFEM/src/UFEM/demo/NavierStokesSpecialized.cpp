@@ -40,7 +40,7 @@ struct NavierStokesSpecializedAssembly
   typedef void result_type;
 
   template<typename PT, typename UT, typename NUT, typename LSST>
-  void operator()(const PT& p, const UT& u, const NUT& nu_eff, const Real& rho, const Real& theta, const Real& invdt, LSST& lss, math::LSS::BlockAccumulator& acc) const
+  void operator()(const PT& p, const UT& u, const NUT& nu_eff, const Real& rho, const Real& theta, const Real& invdt, LSST& lss, math::LSS::BlockAccumulatorT<3, 3>& acc) const
   {
     typedef mesh::LagrangeP1::Triag2D ElementT;
     const RealVector2 u_avg = u.value().colwise().mean();
@@ -179,9 +179,6 @@ NavierStokesSpecialized::NavierStokesSpecialized ( const std::string& name ) : L
     .description("Theta coefficient for the theta-method.")
     .link_to(&theta);
 
-  // Size of the block accumulator
-  m_block_accumulator.resize(3, 3);
-
   // This determines the name of the field that will be used to store the solution
   set_solution_tag("navier_stokes_solution");
 
@@ -34,7 +34,7 @@ public: // functions
   virtual void on_initial_conditions_set(InitialConditions& initial_conditions);
 
   Real theta;
-  math::LSS::BlockAccumulator m_block_accumulator;
+  math::LSS::BlockAccumulatorT<3, 3> m_block_accumulator;
 };
 
 } // demo
@@ -61,8 +61,7 @@ public:
         const mesh::Connectivity& connectivity = elements.geometry_space().connectivity();
         const mesh::Field& coordinates = elements.geometry_fields().coordinates();
         Eigen::Matrix<Real, 3, 2> nodes, normals;
-        math::LSS::BlockAccumulator acc;
-        acc.resize(3, 1);
+        math::LSS::BlockAccumulatorT<3, 1> acc;
 
         Eigen::Matrix<Real, 3, 1> f;
         
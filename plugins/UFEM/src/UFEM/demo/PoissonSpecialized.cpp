@@ -41,7 +41,7 @@ struct PoissonTriagAssembly
 
   // Functor that takes: source term f, Linear system lss, element matrix and vector acc
   template<typename FT, typename LSST>
-  void operator()(const FT& f, LSST& lss, math::LSS::BlockAccumulator& acc) const
+  void operator()(const FT& f, LSST& lss, math::LSS::BlockAccumulatorT<3, 1>& acc) const
   {
     typedef mesh::LagrangeP1::Triag2D ElementT;
     // Get the coordinates of the element nodes
@@ -83,9 +83,6 @@ static solver::actions::Proto::MakeSFOp<PoissonTriagAssembly>::type const assemb
 
 PoissonSpecialized::PoissonSpecialized ( const std::string& name ) : LSSAction ( name )
 {
-  // Setup of private variables
-  m_block_accumulator.resize(3, 1);
-  
   // This determines the name of the field that will be used to store the solution
   set_solution_tag("poisson_solution");
 
@@ -31,7 +31,7 @@ public: // functions
   static std::string type_name () { return "PoissonSpecialized"; }
   
 private:
-  math::LSS::BlockAccumulator m_block_accumulator;
+  math::LSS::BlockAccumulatorT<3, 1> m_block_accumulator;
 };
 
 } // demo
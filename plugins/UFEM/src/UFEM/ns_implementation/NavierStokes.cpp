@@ -142,9 +142,9 @@ void NavierStokes::trigger_assembly()
     const bool use_specializations = options().value<bool>("use_specializations");
     set_triag_assembly(use_specializations);
     set_tetra_assembly(use_specializations);
-    set_quad_assembly();
-    set_hexa_assembly();
-    set_prism_assembly();
+    set_quad_assembly(use_specializations);
+    set_hexa_assembly(use_specializations);
+    set_prism_assembly(use_specializations);
   }
 
   if(is_not_null(m_initial_conditions))
@@ -17,10 +17,17 @@ using namespace solver;
 using namespace solver::actions;
 using namespace solver::actions::Proto;
 
-void NavierStokes::set_hexa_assembly()
+void NavierStokes::set_hexa_assembly(const bool use_specialization)
 {
 #ifdef CF3_UFEM_ENABLE_HEXAS
-  set_assembly_expression< boost::mpl::vector1<mesh::LagrangeP1::Hexa3D>, boost::mpl::vector0<> >("AssemblyHexas");
+  if(use_specialization)
+  {
+    set_assembly_expression< boost::mpl::vector0<>, boost::mpl::vector1<mesh::LagrangeP1::Hexa3D> >("AssemblyHexas");
+  }
+  else
+  {
+    set_assembly_expression< boost::mpl::vector1<mesh::LagrangeP1::Hexa3D>, boost::mpl::vector0<> >("AssemblyHexas");
+  }
 #endif
 }
 
@@ -17,10 +17,17 @@ using namespace solver;
 using namespace solver::actions;
 using namespace solver::actions::Proto;
 
-void NavierStokes::set_prism_assembly()
+void NavierStokes::set_prism_assembly(const bool use_specialization)
 {
 #ifdef CF3_UFEM_ENABLE_PRISMS
-  set_assembly_expression< boost::mpl::vector1<mesh::LagrangeP1::Prism3D>, boost::mpl::vector0<> >("AssemblyPrisms");
+  if(use_specialization)
+  {
+    set_assembly_expression< boost::mpl::vector0<>, boost::mpl::vector1<mesh::LagrangeP1::Prism3D> >("AssemblyPrisms");
+  }
+  else
+  {
+    set_assembly_expression< boost::mpl::vector1<mesh::LagrangeP1::Prism3D>, boost::mpl::vector0<> >("AssemblyPrisms");
+  }
 #endif
 }
 
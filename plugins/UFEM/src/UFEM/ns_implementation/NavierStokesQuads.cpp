@@ -17,10 +17,17 @@ using namespace solver;
 using namespace solver::actions;
 using namespace solver::actions::Proto;
 
-void NavierStokes::set_quad_assembly()
+void NavierStokes::set_quad_assembly(const bool use_specialization)
 {
 #ifdef CF3_UFEM_ENABLE_QUADS
-  set_assembly_expression< boost::mpl::vector1<mesh::LagrangeP1::Quad2D>, boost::mpl::vector0<> >("AssemblyQuads");
+  if(use_specialization)
+  {
+    set_assembly_expression< boost::mpl::vector0<>, boost::mpl::vector1<mesh::LagrangeP1::Quad2D> >("AssemblyQuads");
+  }
+  else
+  {
+    set_assembly_expression< boost::mpl::vector1<mesh::LagrangeP1::Quad2D>, boost::mpl::vector0<> >("AssemblyQuads");
+  }
 #endif
 }
 
@@ -62,8 +62,8 @@ struct ScalarLSSVector
   const StorageT& operator()(StorageT& result, const DataT& data) const
   {
     index_converter(data);
-    acc.resize(DataT::SupportShapeFunction::nb_nodes, 1);
-    acc.indices = data.block_accumulator.indices;
+    math::LSS::BlockAccumulatorT<DataT::SupportShapeFunction::nb_nodes, 1> acc;
+    acc.neighbour_indices(data.block_accumulator.indices);
     vector->get_sol_values(acc);
     result = acc.sol;
     return result;
@@ -78,7 +78,6 @@ struct ScalarLSSVector
 
   Handle<math::LSS::Vector> vector;
   LSSIndexConverter index_converter;
-  mutable math::LSS::BlockAccumulator acc;
 };
 
 /// Custom proto op to access element values in an LSS vector for a vector variable
@@ -98,8 +97,8 @@ struct VectorLSSVector
   const StorageT& operator()(StorageT& result, const DataT& data) const
   {
     index_converter(data);
-    acc.resize(DataT::SupportShapeFunction::nb_nodes, DataT::dimension);
-    acc.indices = data.block_accumulator.indices;
+    math::LSS::BlockAccumulatorT<DataT::SupportShapeFunction::nb_nodes, DataT::dimension> acc;
+    acc.neighbour_indices(data.block_accumulator.indices);
     vector->get_sol_values(acc);
     // We need to renumber to the blocked structure used in the element matrices
     for(Uint i = 0; i != DataT::SupportShapeFunction::nb_nodes; ++i)
@@ -122,7 +121,6 @@ struct VectorLSSVector
 
   Handle<math::LSS::Vector> vector;
   LSSIndexConverter index_converter;
-  mutable math::LSS::BlockAccumulator acc;
 };
   
 } // UFEM
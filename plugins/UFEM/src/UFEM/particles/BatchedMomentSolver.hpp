@@ -0,0 +1,375 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_UFEM_particles_BatchedMomentSolver_hpp
+#define cf3_UFEM_particles_BatchedMomentSolver_hpp
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <boost/math/special_functions/fpclassify.hpp>
+
+#include <Eigen/Dense>
+
+#include "common/Assertions.hpp"
+#include "common/CF.hpp"
+
+namespace cf3 {
+namespace UFEM {
+namespace particles {
+
+/// Computes the moment source terms of the polydisperse model for a batch of nodes at once.
+/// For each node, the 2*NbPhases moment equations form a small dense system
+///   sum_alpha (1-k) v_alpha^k S_alpha + k v_alpha^(k-1) Z_alpha = sum_alpha,gamma (0.5 (v_alpha+v_gamma)^k - v_alpha^k) c_alpha,gamma
+/// where v_alpha is the particle volume of phase alpha and c_alpha,gamma = beta n_alpha n_gamma the collision rate.
+/// All data is stored with the node (the "lane") as the fastest index, so every step of the assembly and of the
+/// LU decomposition is a loop over the lanes that the compiler can vectorize. Pivoting is done per lane.
+/// The solution is improved by one step of iterative refinement, after which the backward error
+/// |b - A x| / (|A| |x| + |b|) is checked. The matrix is a confluent Vandermonde matrix in the volumes, which is singular
+/// only if two volumes coincide. Lanes where two volumes are nearly equal, or where the backward error is too large, are
+/// flagged as ill-conditioned. The size of the pivots is not used, since the powers of the volumes make the matrix
+/// badly scaled even when the solution is accurate. Flagged lanes must be solved with solve_fallback, which uses the
+/// full pivoting LU and SVD of the original per-node implementation.
+template<Uint NbPhases, Uint BatchSize = 8>
+struct BatchedMomentSolver
+{
+  static const Uint nb_phases = NbPhases;
+  static const Uint nb_moments = 2*NbPhases;
+  static const Uint batch_size = BatchSize;
+
+  typedef Eigen::Matrix<Real, nb_moments, nb_moments> MatrixT;
+  typedef Eigen::Matrix<Real, nb_moments, 1> VectorT;
+
+  /// Input: volume for each phase, indexed as [phase][lane]
+  Real volumes[NbPhases][BatchSize];
+  /// Input: collision rate beta*n_alpha*n_gamma, indexed as [alpha][gamma][lane]
+  Real collisions[NbPhases][NbPhases][BatchSize];
+
+  /// Output: the solution, indexed as [moment][lane]
+  Real solution[nb_moments][BatchSize];
+  /// Output: true if the lane needs to be solved using solve_fallback
+  bool ill_conditioned[BatchSize];
+  /// Output: true if the right hand side contains a NaN or infinity
+  bool not_finite[BatchSize];
+
+  /// Assemble and solve the systems for the first nb_lanes lanes
+  void solve(const Uint nb_lanes)
+  {
+    cf3_assert(nb_lanes <= BatchSize);
+
+    // Unused lanes get a well-conditioned dummy system
+    for(Uint l = nb_lanes; l != BatchSize; ++l)
+    {
+      for(Uint alpha = 0; alpha != NbPhases; ++alpha)
+      {
+        volumes[alpha][l] = static_cast<Real>(alpha+1);
+        for(Uint gamma = 0; gamma != NbPhases; ++gamma)
+          collisions[alpha][gamma][l] = 0.;
+      }
+    }
+
+    assemble();
+
+    for(Uint l = 0; l != BatchSize; ++l)
+    {
+      not_finite[l] = false;
+      for(Uint k = 0; k != nb_moments; ++k)
+        not_finite[l] = not_finite[l] || !boost::math::isfinite(m_assembled_rhs[k][l]);
+    }
+
+    factorize_and_solve();
+  }
+
+  /// Solve the system for the given lane using a full pivoting LU decomposition, or an SVD if the matrix is singular.
+  /// Used for the lanes where ill_conditioned is true. Must be called after solve, as it uses the assembled system
+  void solve_fallback(const Uint lane, Real* x) const
+  {
+    MatrixT mat;
+    VectorT rhs;
+    assemble_lane(lane, mat, rhs);
+    Eigen::Map<VectorT> result(x);
+    Eigen::FullPivLU<MatrixT> lu(mat);
+    if(lu.isInvertible())
+    {
+      result = lu.solve(rhs);
+    }
+    else
+    {
+      Eigen::JacobiSVD<MatrixT> svd(mat, Eigen::ComputeFullU | Eigen::ComputeFullV);
+      result = svd.solve(rhs);
+    }
+  }
+
+  /// Copy the system of the given lane to a fixed size matrix and vector. The matrix is recomputed from the power table
+  void assemble_lane(const Uint lane, MatrixT& mat, VectorT& rhs) const
+  {
+    for(Uint alpha = 0; alpha != NbPhases; ++alpha)
+    {
+      for(Uint k = 0; k != nb_moments; ++k)
+      {
+        mat(k, alpha) = (1. - static_cast<Real>(k)) * m_powers[alpha][k][lane];
+        mat(k, alpha + NbPhases) = k == 0 ? 0. : static_cast<Real>(k) * m_powers[alpha][k-1][lane];
+      }
+    }
+    for(Uint k = 0; k != nb_moments; ++k)
+      rhs[k] = m_assembled_rhs[k][lane];
+  }
+
+private:
+  /// Fill the power table, the matrix and the right hand side
+  void assemble()
+  {
+    // Powers of the volumes: m_powers[alpha][k] = v_alpha^k
+    for(Uint alpha = 0; alpha != NbPhases; ++alpha)
+    {
+      for(Uint l = 0; l != BatchSize; ++l)
+        m_powers[alpha][0][l] = 1.;
+      for(Uint k = 1; k != nb_moments; ++k)
+      {
+        for(Uint l = 0; l != BatchSize; ++l)
+          m_powers[alpha][k][l] = m_powers[alpha][k-1][l] * volumes[alpha][l];
+      }
+    }
+
+    for(Uint k = 0; k != nb_moments; ++k)
+    {
+      const Real kr = static_cast<Real>(k);
+      for(Uint alpha = 0; alpha != NbPhases; ++alpha)
+      {
+        for(Uint l = 0; l != BatchSize; ++l)
+        {
+          m_mat[k][alpha][l] = (1. - kr) * m_powers[alpha][k][l];
+          m_mat[k][alpha + NbPhases][l] = k == 0 ? 0. : kr * m_powers[alpha][k-1][l];
+        }
+      }
+      for(Uint l = 0; l != BatchSize; ++l)
+        m_assembled_rhs[k][l] = 0.;
+    }
+
+    // Right hand side: sum over all phase pairs, with the powers of the combined volume computed incrementally
+    Real combined_power[BatchSize];
+    for(Uint alpha = 0; alpha != NbPhases; ++alpha)
+    {
+      for(Uint gamma = 0; gamma != NbPhases; ++gamma)
+      {
+        const Real* c = collisions[alpha][gamma];
+        for(Uint l = 0; l != BatchSize; ++l)
+          combined_power[l] = 1.;
+        for(Uint k = 0; k != nb_moments; ++k)
+        {
+          for(Uint l = 0; l != BatchSize; ++l)
+          {
+            m_assembled_rhs[k][l] += (0.5*combined_power[l] - m_powers[alpha][k][l]) * c[l];
+            combined_power[l] *= volumes[alpha][l] + volumes[gamma][l];
+          }
+        }
+      }
+    }
+  }
+
+  /// LU decomposition with partial pivoting per lane, followed by the solution and one refinement step
+  void factorize_and_solve()
+  {
+    const Real epsilon = std::numeric_limits<Real>::epsilon();
+    const Real separation_threshold = std::sqrt(epsilon);
+    const Real backward_error_threshold = 1e3 * static_cast<Real>(nb_moments) * epsilon;
+
+    // Relative distance between the closest pair of volumes
+    Real min_separation[BatchSize];
+    for(Uint l = 0; l != BatchSize; ++l)
+      min_separation[l] = 1.;
+    for(Uint alpha = 0; alpha != NbPhases; ++alpha)
+    {
+      for(Uint gamma = alpha+1; gamma != NbPhases; ++gamma)
+      {
+        for(Uint l = 0; l != BatchSize; ++l)
+        {
+          const Real largest = std::max(std::abs(volumes[alpha][l]), std::abs(volumes[gamma][l]));
+          const Real difference = std::abs(volumes[alpha][l] - volumes[gamma][l]);
+          min_separation[l] = std::min(min_separation[l], largest == 0. ? 0. : difference / largest);
+        }
+      }
+    }
+
+    bool zero_pivot[BatchSize];
+    for(Uint l = 0; l != BatchSize; ++l)
+      zero_pivot[l] = false;
+
+    for(Uint j = 0; j != nb_moments; ++j)
+    {
+      // Find and swap the pivot row for each lane
+      for(Uint l = 0; l != BatchSize; ++l)
+      {
+        Uint pivot_row = j;
+        Real pivot_abs = std::abs(m_mat[j][j][l]);
+        for(Uint r = j+1; r != nb_moments; ++r)
+        {
+          const Real candidate = std::abs(m_mat[r][j][l]);
+          if(candidate > pivot_abs)
+          {
+            pivot_abs = candidate;
+            pivot_row = r;
+          }
+        }
+        m_pivot_rows[j][l] = pivot_row;
+        if(pivot_row != j)
+        {
+          for(Uint c = 0; c != nb_moments; ++c)
+            std::swap(m_mat[j][c][l], m_mat[pivot_row][c][l]);
+        }
+        // Avoid dividing by zero, the lane is flagged below
+        if(pivot_abs == 0.)
+        {
+          zero_pivot[l] = true;
+          m_mat[j][j][l] = 1.;
+        }
+      }
+
+      // Eliminate the column below the pivot, keeping the multipliers in the lower part
+      for(Uint r = j+1; r != nb_moments; ++r)
+      {
+        for(Uint l = 0; l != BatchSize; ++l)
+          m_mat[r][j][l] /= m_mat[j][j][l];
+        for(Uint c = j+1; c != nb_moments; ++c)
+        {
+          for(Uint l = 0; l != BatchSize; ++l)
+            m_mat[r][c][l] -= m_mat[r][j][l] * m_mat[j][c][l];
+        }
+      }
+    }
+
+    for(Uint k = 0; k != nb_moments; ++k)
+    {
+      for(Uint l = 0; l != BatchSize; ++l)
+        m_rhs[k][l] = m_assembled_rhs[k][l];
+    }
+    substitute();
+    for(Uint k = 0; k != nb_moments; ++k)
+    {
+      for(Uint l = 0; l != BatchSize; ++l)
+        solution[k][l] = m_rhs[k][l];
+    }
+
+    // One step of iterative refinement: solve for the correction using the residual
+    Real backward_error[BatchSize];
+    compute_residual(backward_error);
+    substitute();
+    for(Uint k = 0; k != nb_moments; ++k)
+    {
+      for(Uint l = 0; l != BatchSize; ++l)
+        solution[k][l] += m_rhs[k][l];
+    }
+
+    compute_residual(backward_error);
+    for(Uint l = 0; l != BatchSize; ++l)
+      ill_conditioned[l] = zero_pivot[l] || !(min_separation[l] > separation_threshold) || !(backward_error[l] <= backward_error_threshold);
+  }
+
+  /// Store b - A x in m_rhs, and the normwise backward error |b - A x| / (|A| |x| + |b|) in backward_error,
+  /// using the maximum norm. The matrix A is recomputed from the power table
+  void compute_residual(Real* backward_error)
+  {
+    Real matrix_norm[BatchSize];
+    Real solution_norm[BatchSize];
+    Real rhs_norm[BatchSize];
+    Real residual_norm[BatchSize];
+    for(Uint l = 0; l != BatchSize; ++l)
+    {
+      matrix_norm[l] = 0.;
+      solution_norm[l] = 0.;
+      rhs_norm[l] = 0.;
+      residual_norm[l] = 0.;
+    }
+
+    for(Uint k = 0; k != nb_moments; ++k)
+    {
+      const Real kr = static_cast<Real>(k);
+      Real row_sum[BatchSize];
+      for(Uint l = 0; l != BatchSize; ++l)
+      {
+        m_rhs[k][l] = m_assembled_rhs[k][l];
+        row_sum[l] = 0.;
+      }
+      for(Uint alpha = 0; alpha != NbPhases; ++alpha)
+      {
+        for(Uint l = 0; l != BatchSize; ++l)
+        {
+          const Real a_s = (1. - kr) * m_powers[alpha][k][l];
+          const Real a_z = k == 0 ? 0. : kr * m_powers[alpha][k-1][l];
+          m_rhs[k][l] -= a_s * solution[alpha][l] + a_z * solution[alpha + NbPhases][l];
+          row_sum[l] += std::abs(a_s) + std::abs(a_z);
+        }
+      }
+      for(Uint l = 0; l != BatchSize; ++l)
+      {
+        matrix_norm[l] = std::max(matrix_norm[l], row_sum[l]);
+        solution_norm[l] = std::max(solution_norm[l], std::abs(solution[k][l]));
+        rhs_norm[l] = std::max(rhs_norm[l], std::abs(m_assembled_rhs[k][l]));
+        residual_norm[l] = std::max(residual_norm[l], std::abs(m_rhs[k][l]));
+      }
+    }
+
+    for(Uint l = 0; l != BatchSize; ++l)
+    {
+      const Real denominator = matrix_norm[l] * solution_norm[l] + rhs_norm[l];
+      backward_error[l] = denominator > 0. ? residual_norm[l] / denominator : 0.;
+    }
+  }
+
+  /// Solve in place for the right hand side in m_rhs, using the LU factors and row swaps stored by factorize_and_solve
+  void substitute()
+  {
+    // Forward substitution with the unit lower triangle, applying the row swaps in the order of the elimination
+    for(Uint j = 0; j != nb_moments; ++j)
+    {
+      for(Uint l = 0; l != BatchSize; ++l)
+        std::swap(m_rhs[j][l], m_rhs[m_pivot_rows[j][l]][l]);
+    }
+    for(Uint r = 1; r != nb_moments; ++r)
+    {
+      for(Uint c = 0; c != r; ++c)
+      {
+        for(Uint l = 0; l != BatchSize; ++l)
+          m_rhs[r][l] -= m_mat[r][c][l] * m_rhs[c][l];
+      }
+    }
+
+    // Backward substitution with the upper triangle
+    for(Uint ri = nb_moments; ri != 0; --ri)
+    {
+      const Uint r = ri - 1;
+      for(Uint c = r+1; c != nb_moments; ++c)
+      {
+        for(Uint l = 0; l != BatchSize; ++l)
+          m_rhs[r][l] -= m_mat[r][c][l] * m_rhs[c][l];
+      }
+      for(Uint l = 0; l != BatchSize; ++l)
+        m_rhs[r][l] /= m_mat[r][r][l];
+    }
+  }
+
+  /// Powers of the volumes, [phase][power][lane]
+  Real m_powers[NbPhases][nb_moments][BatchSize];
+  /// System matrix, [row][column][lane]. Overwritten by the LU factors
+  Real m_mat[nb_moments][nb_moments][BatchSize];
+  /// Row swapped with row j at step j of the elimination, [j][lane]
+  Uint m_pivot_rows[nb_moments][BatchSize];
+  /// Right hand side, [row][lane]
+  Real m_assembled_rhs[nb_moments][BatchSize];
+  /// Work vector for the substitutions, [row][lane]
+  Real m_rhs[nb_moments][BatchSize];
+};
+
+template<Uint NbPhases, Uint BatchSize> const Uint BatchedMomentSolver<NbPhases, BatchSize>::nb_phases;
+template<Uint NbPhases, Uint BatchSize> const Uint BatchedMomentSolver<NbPhases, BatchSize>::nb_moments;
+template<Uint NbPhases, Uint BatchSize> const Uint BatchedMomentSolver<NbPhases, BatchSize>::batch_size;
+
+} // particles
+} // UFEM
+} // cf3
+
+#endif // cf3_UFEM_particles_BatchedMomentSolver_hpp
@@ -0,0 +1,722 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#include <algorithm>
+#include <cmath>
+
+#include <boost/bind.hpp>
+
+#include "common/Builder.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Foreach.hpp"
+#include "common/List.hpp"
+#include "common/Log.hpp"
+#include "common/OptionComponent.hpp"
+#include "common/OptionList.hpp"
+#include "common/OptionT.hpp"
+#include "common/PropertyList.hpp"
+#include "common/Signal.hpp"
+#include "common/Table.hpp"
+#include "common/ThreadPool.hpp"
+#include "common/Timer.hpp"
+#include "common/PE/Comm.hpp"
+
+#include "common/XML/SignalOptions.hpp"
+
+#include "math/Consts.hpp"
+#include "math/VariablesDescriptor.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/ElementType.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/FaceCellConnectivity.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Octtree.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/ShapeFunction.hpp"
+#include "mesh/Space.hpp"
+
+#include "solver/Time.hpp"
+
+#include "ParticleTracker.hpp"
+
+namespace cf3 {
+namespace UFEM {
+namespace particles {
+
+using namespace common;
+
+common::ComponentBuilder < ParticleTracker, common::Action, LibUFEMParticles > ParticleTracker_builder;
+
+namespace detail
+{
+  /// Remove the entries for which remove is true, keeping the order of the others
+  template<typename T>
+  void compact_array(std::vector<T>& values, const std::vector<bool>& remove)
+  {
+    const Uint nb_values = values.size();
+    Uint nb_kept = 0;
+    for(Uint i = 0; i != nb_values; ++i)
+    {
+      if(!remove[i])
+        values[nb_kept++] = values[i];
+    }
+    values.resize(nb_kept);
+  }
+}
+
+struct ParticleTracker::InterpolationScratch
+{
+  RealMatrix nodes;
+  RealVector mapped_coord;
+  RealRowVector shape_values;
+};
+
+ParticleTracker::ParticleTracker(const std::string& name) :
+  solver::Action(name),
+  m_dim(0),
+  m_rank(0),
+  m_velocity_offset(0),
+  m_relaxation_time(0.),
+  m_max_walk_steps(1000),
+  m_max_nb_faces(0),
+  m_tolerance(0.),
+  m_nb_added(0),
+  m_nb_escaped(0),
+  m_nb_migrated(0),
+  m_nb_lost(0)
+{
+  options().add("time", m_time)
+    .pretty_name("Time")
+    .description("Time component for the simulation, providing the time step")
+    .link_to(&m_time)
+    .mark_basic();
+
+  options().add("velocity_field", m_velocity_field)
+    .pretty_name("Velocity Field")
+    .description("Field containing the fluid velocity. If not set, the field tagged navier_stokes_solution is used")
+    .link_to(&m_velocity_field)
+    .attach_trigger(boost::bind(&ParticleTracker::trigger_reset, this));
+
+  options().add("velocity_variable", std::string("Velocity"))
+    .pretty_name("Velocity Variable")
+    .description("Name of the fluid velocity variable")
+    .attach_trigger(boost::bind(&ParticleTracker::trigger_reset, this));
+
+  options().add("relaxation_time", m_relaxation_time)
+    .pretty_name("Relaxation Time")
+    .description("Particle relaxation time. With 0, the particles follow the flow exactly")
+    .link_to(&m_relaxation_time)
+    .mark_basic();
+
+  options().add("max_walk_steps", m_max_walk_steps)
+    .pretty_name("Maximum Walk Steps")
+    .description("Maximum number of cells visited in a single walk, before falling back to the octtree")
+    .link_to(&m_max_walk_steps);
+
+  properties().add("nb_particles", 0u);
+  properties().add("nb_escaped", 0u);
+  properties().add("nb_migrated", 0u);
+  properties().add("nb_lost", 0u);
+  properties().add("average_walk_steps", 0.);
+  properties().add("particles_per_second", 0.);
+
+  regist_signal( "add_particles" )
+    .connect( boost::bind( &ParticleTracker::signal_add_particles, this, _1 ) )
+    .description("Add particles at the given coordinates")
+    .pretty_name("Add Particles")
+    .signature( boost::bind(&ParticleTracker::signature_add_particles, this, _1) );
+
+  regist_signal( "export_particles" )
+    .connect( boost::bind( &ParticleTracker::signal_export_particles, this, _1 ) )
+    .description("Copy the particle ids, positions and velocities to the particles table")
+    .pretty_name("Export Particles");
+
+  m_particle_table = create_static_component< common::Table<Real> >("particles");
+}
+
+ParticleTracker::~ParticleTracker()
+{
+}
+
+void ParticleTracker::on_regions_set()
+{
+  trigger_reset();
+}
+
+void ParticleTracker::trigger_reset()
+{
+  if(!m_ids.empty())
+    CFwarn << "ParticleTracker " << uri().path() << ": removing " << m_ids.size() << " particles after a change of the setup" << CFendl;
+
+  m_ids.clear();
+  m_positions.clear();
+  m_velocities.clear();
+  m_hosts.clear();
+  m_status.clear();
+  m_walk_steps.clear();
+  m_cell_elements.clear();
+}
+
+void ParticleTracker::setup()
+{
+  if(m_loop_regions.empty())
+    throw SetupError(FromHere(), "No regions set for " + uri().path());
+
+  mesh::Mesh& mesh = find_parent_component<mesh::Mesh>(*m_loop_regions.front());
+  m_dim = mesh.dimension();
+
+  if(is_null(m_velocity_field))
+  {
+    m_velocity_field = find_component_ptr_recursively_with_tag<mesh::Field>(mesh, "navier_stokes_solution");
+    if(is_null(m_velocity_field))
+      throw SetupError(FromHere(), "No velocity field set for " + uri().path() + " and no field tagged navier_stokes_solution was found");
+  }
+  const std::string velocity_variable = options().value<std::string>("velocity_variable");
+  if(m_velocity_field->descriptor().var_length(velocity_variable) != m_dim)
+    throw SetupError(FromHere(), "Variable " + velocity_variable + " of field " + m_velocity_field->uri().path() + " is not a vector of dimension " + to_str(m_dim));
+  m_velocity_offset = m_velocity_field->descriptor().offset(velocity_variable);
+
+  // Number the cells consecutively over all volume elements of the loop regions, including ghosts
+  m_cell_elements.clear();
+  m_cell_elements_begin.clear();
+  m_elements_begin.clear();
+  if(is_not_null(m_face_cell_connectivity))
+    remove_component(*m_face_cell_connectivity);
+  m_face_cell_connectivity = create_component<mesh::FaceCellConnectivity>("FaceCellConnectivity");
+
+  Uint nb_cells = 0;
+  m_max_nb_faces = 0;
+  BOOST_FOREACH(const Handle<mesh::Region>& region, m_loop_regions)
+  {
+    BOOST_FOREACH(mesh::Elements& elements, find_components_recursively_with_filter<mesh::Elements>(*region, mesh::IsElementsVolume()))
+    {
+      if(m_elements_begin.count(&elements))
+        continue;
+      m_elements_begin[&elements] = nb_cells;
+      m_cell_elements.push_back(elements.handle<mesh::Elements>());
+      m_cell_elements_begin.push_back(nb_cells);
+      m_face_cell_connectivity->add_used(elements);
+      nb_cells += elements.size();
+      m_max_nb_faces = std::max(m_max_nb_faces, elements.element_type().nb_faces());
+    }
+  }
+  if(m_cell_elements.empty())
+    throw SetupError(FromHere(), "No volume elements found in the regions of " + uri().path());
+
+  m_face_cell_connectivity->build_connectivity();
+
+  m_rank = PE::Comm::instance().rank();
+  const Uint invalid = math::Consts::uint_max();
+  const Uint plane_size = m_dim + 1;
+  m_cell_elements_idx.resize(nb_cells);
+  m_cell_rank.resize(nb_cells);
+  m_neighbours.assign(nb_cells*m_max_nb_faces, invalid);
+  // Unused faces of cells with less than m_max_nb_faces faces never have the point outside
+  m_face_planes.assign(nb_cells*m_max_nb_faces*plane_size, 0.);
+  m_owned_cells.clear();
+
+  const common::Table<Real>& coordinates = mesh.geometry_fields().coordinates();
+  RealVector bbox_min = RealVector::Constant(m_dim, math::Consts::real_max());
+  RealVector bbox_max = RealVector::Constant(m_dim, -math::Consts::real_max());
+  RealVector centroid(m_dim), face_centroid(m_dim), normal(m_dim);
+  for(Uint elements_idx = 0; elements_idx != m_cell_elements.size(); ++elements_idx)
+  {
+    const mesh::Elements& elements = *m_cell_elements[elements_idx];
+    const mesh::ElementType& etype = elements.element_type();
+    const mesh::Connectivity& connectivity = elements.geometry_space().connectivity();
+    const Uint nb_elems = elements.size();
+    const Uint nb_faces = etype.nb_faces();
+    RealMatrix nodes(etype.nb_nodes(), m_dim);
+    for(Uint elem = 0; elem != nb_elems; ++elem)
+    {
+      const Uint cell = m_cell_elements_begin[elements_idx] + elem;
+      m_cell_elements_idx[cell] = elements_idx;
+      m_cell_rank[cell] = elements.rank()[elem];
+      if(m_cell_rank[cell] == m_rank)
+        m_owned_cells[elements.glb_idx()[elem]] = cell;
+
+      const mesh::Connectivity::ConstRow row = connectivity[elem];
+      for(Uint i = 0; i != nodes.rows(); ++i)
+      {
+        for(Uint d = 0; d != m_dim; ++d)
+        {
+          nodes(i, d) = coordinates[row[i]][d];
+          bbox_min[d] = std::min(bbox_min[d], nodes(i, d));
+          bbox_max[d] = std::max(bbox_max[d], nodes(i, d));
+        }
+      }
+      etype.compute_centroid(nodes, centroid);
+
+      for(Uint face = 0; face != nb_faces; ++face)
+      {
+        const mesh::ElementType& face_type = etype.face_type(face);
+        RealMatrix face_nodes(face_type.nb_nodes(), m_dim);
+        Uint i = 0;
+        BOOST_FOREACH(const Uint face_node, etype.faces().nodes_range(face))
+          face_nodes.row(i++) = nodes.row(face_node);
+        face_type.compute_centroid(face_nodes, face_centroid);
+        if(face_type.dimensionality() == 0)
+          normal = face_centroid - centroid;
+        else
+          face_type.compute_normal(face_nodes, normal);
+        // Make sure the normal points outward
+        if(normal.dot(face_centroid - centroid) < 0.)
+          normal = -normal;
+        normal.normalize();
+
+        Real* plane = &m_face_planes[(cell*m_max_nb_faces + face)*plane_size];
+        for(Uint d = 0; d != m_dim; ++d)
+          plane[d] = normal[d];
+        plane[m_dim] = normal.dot(face_centroid);
+      }
+    }
+  }
+  m_tolerance = 1e-10 * (bbox_max - bbox_min).norm();
+
+  // Neighbours across the inner faces
+  const mesh::ElementConnectivity& face_cells = m_face_cell_connectivity->connectivity();
+  const common::List<bool>& is_bdry_face = m_face_cell_connectivity->is_bdry_face();
+  const common::Table<Uint>& face_numbers = m_face_cell_connectivity->face_number();
+  const Uint nb_faces = face_cells.size();
+  for(Uint face = 0; face != nb_faces; ++face)
+  {
+    if(is_bdry_face[face])
+      continue;
+    const Uint left = m_elements_begin[face_cells[face][0].comp] + face_cells[face][0].idx;
+    const Uint right = m_elements_begin[face_cells[face][1].comp] + face_cells[face][1].idx;
+    m_neighbours[left*m_max_nb_faces + face_numbers[face][0]] = right;
+    m_neighbours[right*m_max_nb_faces + face_numbers[face][1]] = left;
+  }
+
+  // The octtree is shared with the other users in the mesh
+  if(Handle<Component> found = mesh.get_child("octtree"))
+  {
+    m_octtree = Handle<mesh::Octtree>(found);
+  }
+  else
+  {
+    m_octtree = mesh.create_component<mesh::Octtree>("octtree");
+    m_octtree->options().set("mesh", mesh.handle<mesh::Mesh>());
+  }
+
+  if(m_positions.size() != m_dim)
+  {
+    m_positions.resize(m_dim);
+    m_velocities.resize(m_dim);
+  }
+
+  CFdebug << "ParticleTracker " << uri().path() << ": tracking in " << nb_cells << " cells with " << nb_faces << " faces" << CFendl;
+}
+
+void ParticleTracker::interpolate_velocity(const Uint cell, const RealVector& position, Real* velocity, InterpolationScratch& scratch) const
+{
+  const Uint elements_idx = m_cell_elements_idx[cell];
+  const mesh::Elements& elements = *m_cell_elements[elements_idx];
+  const Uint elem = cell - m_cell_elements_begin[elements_idx];
+  const mesh::ElementType& etype = elements.element_type();
+  const common::Table<Real>& coordinates = elements.geometry_space().dict().coordinates();
+  const mesh::Connectivity::ConstRow geometry_row = elements.geometry_space().connectivity()[elem];
+
+  const Uint nb_nodes = etype.nb_nodes();
+  if(scratch.nodes.rows() != nb_nodes || scratch.nodes.cols() != m_dim)
+    scratch.nodes.resize(nb_nodes, m_dim);
+  for(Uint i = 0; i != nb_nodes; ++i)
+  {
+    for(Uint d = 0; d != m_dim; ++d)
+      scratch.nodes(i, d) = coordinates[geometry_row[i]][d];
+  }
+  scratch.mapped_coord.resize(etype.dimensionality());
+  etype.compute_mapped_coordinate(position, scratch.nodes, scratch.mapped_coord);
+
+  const mesh::Space& velocity_space = m_velocity_field->space(elements);
+  const mesh::ShapeFunction& sf = velocity_space.shape_function();
+  scratch.shape_values.resize(sf.nb_nodes());
+  sf.compute_value(scratch.mapped_coord, scratch.shape_values);
+
+  const mesh::Connectivity::ConstRow velocity_row = velocity_space.connectivity()[elem];
+  const mesh::Field& field = *m_velocity_field;
+  for(Uint d = 0; d != m_dim; ++d)
+    velocity[d] = 0.;
+  for(Uint i = 0; i != sf.nb_nodes(); ++i)
+  {
+    for(Uint d = 0; d != m_dim; ++d)
+      velocity[d] += scratch.shape_values[i] * field.value(velocity_row[i], m_velocity_offset + d);
+  }
+}
+
+void ParticleTracker::advance_particles(const Uint begin, const Uint end, const Uint)
+{
+  InterpolationScratch scratch;
+  RealVector position(m_dim);
+  Real fluid_velocity[3];
+
+  const Real dt = m_time->dt();
+  // Implicit relaxation, stable for any time step
+  const Real relaxation = m_relaxation_time > 0. ? dt / m_relaxation_time : 0.;
+
+  for(Uint p = begin; p != end; ++p)
+  {
+    for(Uint d = 0; d != m_dim; ++d)
+      position[d] = m_positions[d][p];
+    interpolate_velocity(m_hosts[p], position, fluid_velocity, scratch);
+    for(Uint d = 0; d != m_dim; ++d)
+    {
+      Real& v = m_velocities[d][p];
+      v = relaxation == 0. ? fluid_velocity[d] : (v + relaxation*fluid_velocity[d]) / (1. + relaxation);
+      m_positions[d][p] += dt*v;
+    }
+    m_status[p] = walk(p);
+  }
+}
+
+void ParticleTracker::walk_particles(const Uint begin, const Uint end, const Uint)
+{
+  for(Uint p = begin; p != end; ++p)
+    m_status[p] = walk(p);
+}
+
+ParticleTracker::WalkStatusT ParticleTracker::walk(const Uint particle)
+{
+  const Uint invalid = math::Consts::uint_max();
+  const Uint plane_size = m_dim + 1;
+
+  Uint cell = m_hosts[particle];
+  for(Uint step = 0; step != m_max_walk_steps; ++step)
+  {
+    // Exit through the face the point is farthest outside of
+    Real max_distance = m_tolerance;
+    Uint exit_face = invalid;
+    const Real* planes = &m_face_planes[cell*m_max_nb_faces*plane_size];
+    for(Uint face = 0; face != m_max_nb_faces; ++face)
+    {
+      const Real* plane = planes + face*plane_size;
+      Real distance = -plane[m_dim];
+      for(Uint d = 0; d != m_dim; ++d)
+        distance += plane[d]*m_positions[d][particle];
+      if(distance > max_distance)
+      {
+        max_distance = distance;
+        exit_face = face;
+      }
+    }
+
+    m_walk_steps[particle] = step;
+    if(exit_face == invalid)
+    {
+      m_hosts[particle] = cell;
+      return m_cell_rank[cell] == m_rank ? INSIDE : GHOST;
+    }
+
+    const Uint next_cell = m_neighbours[cell*m_max_nb_faces + exit_face];
+    if(next_cell == invalid)
+    {
+      m_hosts[particle] = cell;
+      // A boundary face of a ghost cell is the edge of the overlap, so the owner must continue the walk.
+      // Escaping through a boundary face of an owned cell is confirmed with the octtree in settle_particles
+      return m_cell_rank[cell] == m_rank ? ESCAPED : GHOST;
+    }
+    cell = next_cell;
+  }
+
+  return LOST;
+}
+
+Uint ParticleTracker::locate(const RealVector& coord)
+{
+  mesh::Entity element;
+  if(!m_octtree->find_element(coord, element))
+    return math::Consts::uint_max();
+
+  const std::map<const mesh::Entities*, Uint>::const_iterator begin_it = m_elements_begin.find(element.comp);
+  if(begin_it == m_elements_begin.end())
+    return math::Consts::uint_max();
+
+  return begin_it->second + element.idx;
+}
+
+void ParticleTracker::for_each_particle(const Uint begin, const Uint end, void (ParticleTracker::*f)(const Uint, const Uint, const Uint))
+{
+  const Uint grain_size = 256;
+  common::ThreadPool& pool = common::ThreadPool::instance();
+  if(pool.nb_threads() == 1 || end - begin <= grain_size)
+    (this->*f)(begin, end, 0);
+  else
+    pool.parallel_for(begin, end, grain_size, boost::bind(f, this, _1, _2, _3));
+}
+
+void ParticleTracker::push_particle(const Uint id, const Real* position, const Real* velocity, const Uint cell)
+{
+  m_ids.push_back(id);
+  for(Uint d = 0; d != m_dim; ++d)
+  {
+    m_positions[d].push_back(position[d]);
+    m_velocities[d].push_back(velocity[d]);
+  }
+  m_hosts.push_back(cell);
+  m_status.push_back(INSIDE);
+  m_walk_steps.push_back(0);
+}
+
+void ParticleTracker::compact(const std::vector<bool>& remove)
+{
+  detail::compact_array(m_ids, remove);
+  for(Uint d = 0; d != m_dim; ++d)
+  {
+    detail::compact_array(m_positions[d], remove);
+    detail::compact_array(m_velocities[d], remove);
+  }
+  detail::compact_array(m_hosts, remove);
+  detail::compact_array(m_status, remove);
+  detail::compact_array(m_walk_steps, remove);
+}
+
+void ParticleTracker::settle_particles()
+{
+  PE::Comm& comm = PE::Comm::instance();
+  const bool parallel = comm.is_active() && comm.size() > 1;
+  const Uint nb_procs = comm.size();
+  const Uint invalid = math::Consts::uint_max();
+  RealVector position(m_dim);
+
+  // Each round exchanges all particles in ghost cells at once. The receivers continue the walk, which may
+  // end in a ghost cell again if the particle crossed more than the overlap in a single step.
+  for(Uint round = 0; ; ++round)
+  {
+    const Uint nb_particles = m_ids.size();
+    std::vector<bool> remove(nb_particles, false);
+    std::vector< std::vector<Uint> > send_ids(nb_procs);
+    std::vector< std::vector<Real> > send_values(nb_procs);
+    Uint nb_sent = 0;
+    for(Uint p = 0; p != nb_particles; ++p)
+    {
+      // The walk only follows the faces of convex cells, so in a non-convex domain it can stop at a boundary face while
+      // the particle is still inside, e.g. behind a step. Only particles the octtree can't find are removed.
+      if(m_status[p] == LOST || m_status[p] == ESCAPED)
+      {
+        for(Uint d = 0; d != m_dim; ++d)
+          position[d] = m_positions[d][p];
+        const Uint cell = locate(position);
+        if(cell == invalid)
+        {
+          if(m_status[p] == LOST)
+            ++m_nb_lost;
+          else
+            ++m_nb_escaped;
+          remove[p] = true;
+          continue;
+        }
+        m_hosts[p] = cell;
+        m_status[p] = m_cell_rank[cell] == m_rank ? INSIDE : GHOST;
+      }
+
+      if(m_status[p] == GHOST)
+      {
+        const Uint host = m_hosts[p];
+        const Uint owner = m_cell_rank[host];
+        cf3_assert(owner < nb_procs);
+        const mesh::Elements& elements = *m_cell_elements[m_cell_elements_idx[host]];
+        send_ids[owner].push_back(m_ids[p]);
+        send_ids[owner].push_back(elements.glb_idx()[host - m_cell_elements_begin[m_cell_elements_idx[host]]]);
+        for(Uint d = 0; d != m_dim; ++d)
+          send_values[owner].push_back(m_positions[d][p]);
+        for(Uint d = 0; d != m_dim; ++d)
+          send_values[owner].push_back(m_velocities[d][p]);
+        remove[p] = true;
+        ++nb_sent;
+      }
+    }
+    compact(remove);
+    m_nb_migrated += nb_sent;
+
+    if(!parallel)
+      break;
+
+    Uint global_nb_sent = 0;
+    comm.all_reduce(PE::plus(), &nb_sent, 1, &global_nb_sent);
+    if(global_nb_sent == 0)
+      break;
+
+    if(round == m_max_walk_steps)
+      throw common::FailedToConverge(FromHere(), "Particles of " + uri().path() + " could not be settled after " + to_str(round) + " exchanges");
+
+    std::vector< std::vector<Uint> > recv_ids;
+    std::vector< std::vector<Real> > recv_values;
+    comm.all_to_all(send_ids, recv_ids);
+    comm.all_to_all(send_values, recv_values);
+
+    const Uint first_received = m_ids.size();
+    for(Uint other_rank = 0; other_rank != nb_procs; ++other_rank)
+    {
+      const Uint nb_received = recv_ids[other_rank].size() / 2;
+      for(Uint i = 0; i != nb_received; ++i)
+      {
+        const Real* values = &recv_values[other_rank][2*m_dim*i];
+        const std::map<Uint, Uint>::const_iterator cell_it = m_owned_cells.find(recv_ids[other_rank][2*i+1]);
+        Uint cell = invalid;
+        if(cell_it != m_owned_cells.end())
+        {
+          cell = cell_it->second;
+        }
+        else
+        {
+          for(Uint d = 0; d != m_dim; ++d)
+            position[d] = values[d];
+          cell = locate(position);
+        }
+        if(cell == invalid)
+        {
+          ++m_nb_lost;
+          continue;
+        }
+        push_particle(recv_ids[other_rank][2*i], values, values + m_dim, cell);
+      }
+    }
+
+    for_each_particle(first_received, m_ids.size(), &ParticleTracker::walk_particles);
+  }
+}
+
+void ParticleTracker::execute()
+{
+  if(is_null(m_time))
+    throw SetupError(FromHere(), "Time component not set for " + uri().path());
+
+  if(m_cell_elements.empty())
+    setup();
+
+  Timer timer;
+
+  const Uint nb_particles_before = m_ids.size();
+  for_each_particle(0, nb_particles_before, &ParticleTracker::advance_particles);
+
+  Uint total_walk_steps = 0;
+  for(Uint p = 0; p != nb_particles_before; ++p)
+    total_walk_steps += m_walk_steps[p];
+
+  settle_particles();
+
+  const Real elapsed = timer.elapsed();
+
+  // Statistics over all processes
+  Uint local_counts[6] = { nb_particles_before, static_cast<Uint>(m_ids.size()), m_nb_escaped, m_nb_migrated, m_nb_lost, total_walk_steps };
+  Uint global_counts[6];
+  std::copy(local_counts, local_counts + 6, global_counts);
+  Real max_elapsed = elapsed;
+  PE::Comm& comm = PE::Comm::instance();
+  if(comm.is_active())
+  {
+    comm.all_reduce(PE::plus(), local_counts, 6, global_counts);
+    comm.all_reduce(PE::max(), &elapsed, 1, &max_elapsed);
+  }
+
+  properties()["nb_particles"] = global_counts[1];
+  properties()["nb_escaped"] = global_counts[2];
+  properties()["nb_migrated"] = global_counts[3];
+  properties()["nb_lost"] = global_counts[4];
+  properties()["average_walk_steps"] = global_counts[0] == 0 ? 0. : static_cast<Real>(global_counts[5]) / static_cast<Real>(global_counts[0]);
+  properties()["particles_per_second"] = max_elapsed > 0. ? static_cast<Real>(global_counts[0]) / max_elapsed : 0.;
+}
+
+Uint ParticleTracker::add_particles(const std::vector<Real>& coordinates)
+{
+  if(m_cell_elements.empty())
+    setup();
+
+  if(coordinates.size() % m_dim != 0)
+    throw common::BadValue(FromHere(), "Number of coordinates " + to_str(coordinates.size()) + " is not a multiple of the dimension " + to_str(m_dim));
+
+  const Uint invalid = math::Consts::uint_max();
+  const Uint nb_points = coordinates.size() / m_dim;
+  PE::Comm& comm = PE::Comm::instance();
+
+  // A point on a face between ranks is found in an owned cell on both sides, so the lowest of these ranks gets it
+  RealVector position(m_dim);
+  std::vector<Uint> cells(nb_points);
+  std::vector<Uint> candidate_ranks(nb_points, invalid);
+  for(Uint i = 0; i != nb_points; ++i)
+  {
+    for(Uint d = 0; d != m_dim; ++d)
+      position[d] = coordinates[i*m_dim + d];
+    cells[i] = locate(position);
+    if(cells[i] != invalid && m_cell_rank[cells[i]] == m_rank)
+      candidate_ranks[i] = m_rank;
+  }
+
+  std::vector<Uint> owner_ranks = candidate_ranks;
+  if(comm.is_active() && nb_points != 0)
+    comm.all_reduce(PE::min(), candidate_ranks, owner_ranks);
+
+  InterpolationScratch scratch;
+  Real velocity[3];
+  Uint nb_located = 0;
+  for(Uint i = 0; i != nb_points; ++i)
+  {
+    if(owner_ranks[i] != m_rank)
+      continue;
+
+    // Particles start at the local fluid velocity
+    for(Uint d = 0; d != m_dim; ++d)
+      position[d] = coordinates[i*m_dim + d];
+    interpolate_velocity(cells[i], position, velocity, scratch);
+    push_particle(m_nb_added + i, &coordinates[i*m_dim], velocity, cells[i]);
+    ++nb_located;
+  }
+  m_nb_added += nb_points;
+
+  Uint global_nb_particles = m_ids.size();
+  if(comm.is_active())
+  {
+    const Uint local_nb_particles = m_ids.size();
+    comm.all_reduce(PE::plus(), &local_nb_particles, 1, &global_nb_particles);
+  }
+  properties()["nb_particles"] = global_nb_particles;
+
+  return nb_located;
+}
+
+void ParticleTracker::export_particles()
+{
+  common::Table<Real>& table = *m_particle_table;
+  const Uint nb_particles = m_ids.size();
+  table.set_row_size(1 + 2*m_dim);
+  table.resize(nb_particles);
+  for(Uint p = 0; p != nb_particles; ++p)
+  {
+    common::Table<Real>::Row row = table[p];
+    row[0] = static_cast<Real>(m_ids[p]);
+    for(Uint d = 0; d != m_dim; ++d)
+    {
+      row[1 + d] = m_positions[d][p];
+      row[1 + m_dim + d] = m_velocities[d][p];
+    }
+  }
+}
+
+void ParticleTracker::signal_add_particles(SignalArgs& args)
+{
+  XML::SignalOptions options(args);
+  add_particles(options.value< std::vector<Real> >("coordinates"));
+}
+
+void ParticleTracker::signature_add_particles(SignalArgs& args)
+{
+  XML::SignalOptions options(args);
+  options.add("coordinates", std::vector<Real>())
+    .pretty_name("Coordinates")
+    .description("Coordinates of the particles, stored one point after the other");
+}
+
+void ParticleTracker::signal_export_particles(SignalArgs& args)
+{
+  export_particles();
+}
+
+} // particles
+} // UFEM
+} // cf3
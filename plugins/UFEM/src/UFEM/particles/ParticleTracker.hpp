@@ -0,0 +1,159 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_UFEM_particles_ParticleTracker_hpp
+#define cf3_UFEM_particles_ParticleTracker_hpp
+
+#include <map>
+
+#include "common/Table_fwd.hpp"
+
+#include "solver/Action.hpp"
+
+#include "LibUFEMParticles.hpp"
+
+namespace cf3 {
+  namespace mesh { class Elements; class Entities; class FaceCellConnectivity; class Field; class Octtree; }
+  namespace solver { class Time; }
+namespace UFEM {
+namespace particles {
+
+/// Lagrangian tracking of point particles in the velocity field of a flow solver.
+/// Each process stores the particles located in the elements it owns, in one array per component (SoA).
+/// Every time step, the fluid velocity is interpolated at each particle using the shape functions of its host element,
+/// the particle velocity is relaxed towards it with the relaxation time and the particle is moved using a forward Euler step.
+/// The new host element is found by walking from the old one across the face through which the particle left, using a
+/// FaceCellConnectivity built over the cells of the loop regions. Particles that end up in a ghost element are sent to
+/// the process owning it, all in one exchange per walk round. Particles leaving the domain are removed. A walk that stops at
+/// a boundary face is checked with the octtree first, since the greedy walk can get stuck at the boundary of a non-convex domain.
+/// In parallel, the mesh must have an overlap of at least one layer of cells, as generated by default by BlockMesh and LoadBalance.
+/// The octtree is only used to locate new particles, and for particles where the walk failed or stopped at the boundary.
+class ParticleTracker : public solver::Action
+{
+public: // functions
+
+  /// Contructor
+  /// @param name of the component
+  ParticleTracker ( const std::string& name );
+
+  virtual ~ParticleTracker();
+
+  /// Get the class name
+  static std::string type_name () { return "ParticleTracker"; }
+
+  /// Advance all particles over one time step
+  virtual void execute();
+
+  /// Add particles at the given coordinates, stored one point after the other. Collective: all processes must
+  /// pass the same points, and each keeps the ones located in its own elements. A point on a face between
+  /// processes is kept by the lowest rank only.
+  /// @return the number of points that were located on this process
+  Uint add_particles(const std::vector<Real>& coordinates);
+
+  /// Copy the particles to the "particles" table, with on each row the particle id, the position and the velocity
+  void export_particles();
+
+  /// Number of particles stored on this process
+  Uint nb_particles() const { return m_ids.size(); }
+
+  void signal_add_particles(common::SignalArgs& args);
+  void signature_add_particles(common::SignalArgs& args);
+  void signal_export_particles(common::SignalArgs& args);
+
+private:
+  /// Status of a particle after the walk
+  enum WalkStatusT { INSIDE = 0, GHOST = 1, ESCAPED = 2, LOST = 3 };
+
+  virtual void on_regions_set();
+
+  /// Build the cell numbering, neighbour table and face planes for the loop regions
+  void setup();
+
+  /// Work arrays for the velocity interpolation, one per thread
+  struct InterpolationScratch;
+
+  /// Interpolate the fluid velocity at the given position, located in the given cell
+  void interpolate_velocity(const Uint cell, const RealVector& position, Real* velocity, InterpolationScratch& scratch) const;
+
+  /// Interpolate the fluid velocity, update and move the particles in [begin, end), and walk them to their new host
+  void advance_particles(const Uint begin, const Uint end, const Uint thread);
+
+  /// Walk the particles in [begin, end) to their new host cell
+  void walk_particles(const Uint begin, const Uint end, const Uint thread);
+
+  /// Walk a single particle, starting from its current host
+  WalkStatusT walk(const Uint particle);
+
+  /// Locate a point using the octtree. Returns the cell index, or an invalid index if not found in the loop regions
+  Uint locate(const RealVector& coord);
+
+  /// Deal with the particles that are not INSIDE after the walk: locate lost and escaped particles with the octtree, remove
+  /// the ones it can't find and exchange the particles in ghost cells with their owners, until every particle is located on its owner
+  void settle_particles();
+
+  /// Run f over [begin, end), in parallel if the thread pool has several threads
+  void for_each_particle(const Uint begin, const Uint end, void (ParticleTracker::*f)(const Uint, const Uint, const Uint));
+
+  /// Append a particle, located in the given cell
+  void push_particle(const Uint id, const Real* position, const Real* velocity, const Uint cell);
+
+  /// Remove the particles for which remove is true, keeping the order of the others
+  void compact(const std::vector<bool>& remove);
+
+  /// Trigger on a change of the regions or the fields
+  void trigger_reset();
+
+  Handle<solver::Time> m_time;
+  Handle<mesh::Field> m_velocity_field;
+  Handle<mesh::FaceCellConnectivity> m_face_cell_connectivity;
+  Handle<mesh::Octtree> m_octtree;
+  Handle< common::Table<Real> > m_particle_table;
+
+  Uint m_dim;
+  /// Rank of this process, stored so the walk can run in the worker threads
+  Uint m_rank;
+  Uint m_velocity_offset;
+  Real m_relaxation_time;
+  Uint m_max_walk_steps;
+
+  /// Particle data, one array per component
+  std::vector<Uint> m_ids;
+  std::vector< std::vector<Real> > m_positions;
+  std::vector< std::vector<Real> > m_velocities;
+  std::vector<Uint> m_hosts;
+  std::vector<Uint> m_status;
+  std::vector<Uint> m_walk_steps;
+
+  /// Cell data, with cells numbered consecutively over all Elements of the loop regions
+  std::vector< Handle<mesh::Elements> > m_cell_elements;
+  std::vector<Uint> m_cell_elements_begin;
+  std::map<const mesh::Entities*, Uint> m_elements_begin;
+  std::vector<Uint> m_cell_elements_idx;
+  std::vector<Uint> m_cell_rank;
+  /// Neighbour across each face of each cell, invalid for boundary faces. Indexed as cell*m_max_nb_faces + face
+  std::vector<Uint> m_neighbours;
+  /// Plane of each face, as outward unit normal followed by its offset, so the point x is outside if n.x > offset
+  std::vector<Real> m_face_planes;
+  Uint m_max_nb_faces;
+  /// Distance outside a face below which a point is still considered inside the cell
+  Real m_tolerance;
+  /// Local cell index for the global index of the cells owned by this process
+  std::map<Uint, Uint> m_owned_cells;
+
+  /// Total number of particles that were added, used to generate ids
+  Uint m_nb_added;
+  /// Counters for this process, accumulated over all executions
+  Uint m_nb_escaped;
+  Uint m_nb_migrated;
+  Uint m_nb_lost;
+};
+
+} // particles
+} // UFEM
+} // cf3
+
+
+#endif // cf3_UFEM_particles_ParticleTracker_hpp
@@ -19,10 +19,12 @@
 #include "common/OptionList.hpp"
 #include "common/OptionT.hpp"
 #include "common/PropertyList.hpp"
+#include "common/ThreadPool.hpp"
 
 #include "math/Consts.hpp"
 
 #include "mesh/Field.hpp"
+#include "mesh/Functions.hpp"
 
 #include "physics/PhysModel.hpp"
 
@@ -31,6 +33,8 @@
 
 #include "../Tags.hpp"
 
+#include "BatchedMomentSolver.hpp"
+
 namespace cf3 {
 namespace UFEM {
 namespace particles {
@@ -347,9 +351,131 @@ struct MomentSourceFunctor : FunctionBase
   mesh::Field* m_collision_rate_field;
 };
 
+/// Computes the moment source terms for a range of nodes, solving the systems in batches with a compile-time number of phases
+template<typename CollisionKernelT, Uint NbPhases>
+struct BatchedMomentSource
+{
+  typedef BatchedMomentSolver<NbPhases> SolverT;
+
+  BatchedMomentSource(const common::List<Uint>& nodes, mesh::Field& source_field, const std::vector<mesh::Field*>& concentration_fields, const std::vector<mesh::Field*>& weighted_volume_fields, CollisionKernelT& beta, mesh::Field* collision_rate_field) :
+    m_nodes(nodes),
+    m_source_field(source_field),
+    m_concentration_fields(concentration_fields),
+    m_weighted_volume_fields(weighted_volume_fields),
+    m_beta(beta),
+    m_collision_rate_field(collision_rate_field)
+  {
+  }
+
+  void operator()(const Uint begin, const Uint end, const Uint) const
+  {
+    const Uint batch_size = SolverT::batch_size;
+    SolverT solver;
+    Real concentrations[NbPhases][batch_size];
+    for(Uint batch_begin = begin; batch_begin < end; batch_begin += batch_size)
+    {
+      const Uint nb_lanes = std::min(batch_size, end - batch_begin);
+      for(Uint l = 0; l != nb_lanes; ++l)
+      {
+        const Uint node_idx = m_nodes[batch_begin + l];
+        for(Uint alpha = 0; alpha != NbPhases; ++alpha)
+        {
+          concentrations[alpha][l] = (*m_concentration_fields[alpha])[node_idx][0];
+          solver.volumes[alpha][l] = (*m_weighted_volume_fields[alpha])[node_idx][0] / concentrations[alpha][l];
+        }
+        for(Uint alpha = 0; alpha != NbPhases; ++alpha)
+        {
+          for(Uint gamma = 0; gamma != NbPhases; ++gamma)
+          {
+            const Real rate = concentrations[alpha][l]*concentrations[gamma][l]*m_beta.apply(node_idx, alpha, gamma);
+            solver.collisions[alpha][gamma][l] = rate;
+            if(is_not_null(m_collision_rate_field))
+              (*m_collision_rate_field)[node_idx][alpha*NbPhases + gamma] = rate;
+          }
+        }
+      }
+
+      solver.solve(nb_lanes);
+
+      for(Uint l = 0; l != nb_lanes; ++l)
+      {
+        Real* x = &m_source_field[m_nodes[batch_begin + l]][0];
+        if(solver.not_finite[l])
+        {
+          std::fill(x, x + SolverT::nb_moments, 0.);
+        }
+        else if(solver.ill_conditioned[l])
+        {
+          solver.solve_fallback(l, x);
+        }
+        else
+        {
+          for(Uint k = 0; k != SolverT::nb_moments; ++k)
+            x[k] = solver.solution[k][l];
+        }
+      }
+    }
+  }
+
+  const common::List<Uint>& m_nodes;
+  mesh::Field& m_source_field;
+  const std::vector<mesh::Field*>& m_concentration_fields;
+  const std::vector<mesh::Field*>& m_weighted_volume_fields;
+  CollisionKernelT& m_beta;
+  mesh::Field* m_collision_rate_field;
+};
+
+template<typename CollisionKernelT, Uint NbPhases>
+void batched_source_term_loop(mesh::Region& region, const std::vector<std::string>& concentration_tags, const std::vector<std::string>& weighted_volume_tags, const std::vector<std::string>& gradient_tags, const Real reference_volume, const physics::PhysModel& physical_model)
+{
+  mesh::Mesh& mesh = common::find_parent_component<mesh::Mesh>(region);
+  mesh::Dictionary& dict = mesh.geometry_fields();
+  mesh::Field& source_field = dict.field("moment_source_terms");
+
+  std::vector<mesh::Field*> concentration_fields, weighted_volume_fields, gradient_fields;
+  for(Uint i = 0; i != NbPhases; ++i)
+  {
+    concentration_fields.push_back(&(dict.field(concentration_tags[i])));
+    weighted_volume_fields.push_back(&(dict.field(weighted_volume_tags[i])));
+    gradient_fields.push_back(&(dict.field(gradient_tags[i])));
+  }
+  CollisionKernelT beta(dict.field("ufem_particle_velocity"), concentration_fields, weighted_volume_fields, gradient_fields, reference_volume, physical_model);
+  mesh::Field* collision_rate_field = Handle<mesh::Field>(dict.get_child("collision_rate")).get();
+  if(is_not_null(collision_rate_field) && collision_rate_field->row_size() < NbPhases*NbPhases)
+    throw common::SetupError(FromHere(), "Field collision_rate is too small for " + common::to_str(NbPhases) + " phases");
+
+  const boost::shared_ptr< common::List<Uint> > nodes = mesh::build_used_nodes_list(region, dict, true);
+  const Uint nb_nodes = nodes->size();
+  const BatchedMomentSource<CollisionKernelT, NbPhases> compute_source_terms(*nodes, source_field, concentration_fields, weighted_volume_fields, beta, collision_rate_field);
+
+  // Each range is a multiple of the batch size, so only the last batch is partially filled
+  const Uint grain_size = 64*BatchedMomentSolver<NbPhases>::batch_size;
+  common::ThreadPool& pool = common::ThreadPool::instance();
+  if(pool.nb_threads() == 1 || nb_nodes <= grain_size)
+    compute_source_terms(0, nb_nodes, 0);
+  else
+    pool.parallel_for(0, nb_nodes, grain_size, common::ThreadPool::RangeFunctionT(compute_source_terms));
+
+  source_field.synchronize();
+}
+
 template<typename CollisionKernelT>
 void source_term_loop(mesh::Region& region, const std::vector<std::string>& concentration_tags, const std::vector<std::string>& weighted_volume_tags, const std::vector<std::string>& gradient_tags, const Real reference_volume, const physics::PhysModel& physical_model)
 {
+  // Batched solvers for the common numbers of phases
+  switch(concentration_tags.size())
+  {
+    case 1: batched_source_term_loop<CollisionKernelT, 1>(region, concentration_tags, weighted_volume_tags, gradient_tags, reference_volume, physical_model); return;
+    case 2: batched_source_term_loop<CollisionKernelT, 2>(region, concentration_tags, weighted_volume_tags, gradient_tags, reference_volume, physical_model); return;
+    case 3: batched_source_term_loop<CollisionKernelT, 3>(region, concentration_tags, weighted_volume_tags, gradient_tags, reference_volume, physical_model); return;
+    case 4: batched_source_term_loop<CollisionKernelT, 4>(region, concentration_tags, weighted_volume_tags, gradient_tags, reference_volume, physical_model); return;
+    case 5: batched_source_term_loop<CollisionKernelT, 5>(region, concentration_tags, weighted_volume_tags, gradient_tags, reference_volume, physical_model); return;
+    case 6: batched_source_term_loop<CollisionKernelT, 6>(region, concentration_tags, weighted_volume_tags, gradient_tags, reference_volume, physical_model); return;
+    case 7: batched_source_term_loop<CollisionKernelT, 7>(region, concentration_tags, weighted_volume_tags, gradient_tags, reference_volume, physical_model); return;
+    case 8: batched_source_term_loop<CollisionKernelT, 8>(region, concentration_tags, weighted_volume_tags, gradient_tags, reference_volume, physical_model); return;
+    default: break;
+  }
+
   MomentSourceFunctor<CollisionKernelT> compute_source_terms(region, concentration_tags, weighted_volume_tags, gradient_tags, reference_volume, physical_model);
   for_each_node(region, lit(compute_source_terms)(node_index));
 }
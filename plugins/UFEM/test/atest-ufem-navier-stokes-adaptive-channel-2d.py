@@ -0,0 +1,132 @@
+import sys
+import coolfluid as cf
+
+# Compares uniform and adaptive h-refinement on the developing flow in a 2D channel. Each refinement step restarts
+# from the interpolated solution, and the error on the inlet pressure is measured against the finest uniform mesh.
+
+# Some shortcuts
+root = cf.Core.root()
+env = cf.Core.environment()
+
+# Global configuration
+env.assertion_throws = False
+env.assertion_backtrace = False
+env.exception_backtrace = False
+env.regist_signal_handlers = False
+env.log_level = 1
+
+u_in = [1., 0.]
+nb_levels = 3
+time_per_level = 5.
+
+# The centre of the inlet may be on any process, so a probe set gathers its pressure on rank 0. Other ranks return None
+def inlet_pressure(mesh):
+  probe = root.create_component('InletProbe', 'cf3.solver.actions.ProbeSet')
+  probe.dict = mesh.geometry
+  probe.fields = ['navier_stokes_solution']
+  probe.coordinates = [0., 0.5]
+  probe.execute()
+  pressure = None
+  if cf.Core.rank() == 0:
+    pressure = probe.get_child('values')[0][2]
+  probe.delete_component()
+  return pressure
+
+def create_solver(model, mesh, first):
+  solver = model.create_solver('cf3.UFEM.Solver')
+  ns_solver = solver.add_unsteady_solver('cf3.UFEM.NavierStokes')
+  ns_solver.regions = [mesh.topology.uri()]
+  ic_visc = solver.InitialConditions.create_initial_condition(builder_name = 'cf3.UFEM.InitialConditionFunction', field_tag = 'navier_stokes_viscosity')
+  ic_visc.variable_name = 'EffectiveViscosity'
+  gradient = solver.add_unsteady_solver('cf3.UFEM.VelocityGradient')
+  gradient.velocity_tag = 'navier_stokes_solution'
+  gradient.regions = [mesh.topology.uri()]
+  solver.create_fields()
+
+  if first:
+    solver.InitialConditions.navier_stokes_solution.Velocity = u_in
+  else:
+    # Refinement interpolated the previous solution, which serves as initial condition
+    solver.options().set('disabled_actions', ['InitialConditions'])
+
+  bc = ns_solver.BoundaryConditions
+  bc.add_constant_bc(region_name = 'left', variable_name = 'Velocity').value = u_in
+  bc.add_constant_bc(region_name = 'bottom', variable_name = 'Velocity').value = [0., 0.]
+  bc.add_constant_bc(region_name = 'top', variable_name = 'Velocity').value = [0., 0.]
+  bc.add_constant_bc(region_name = 'right', variable_name = 'Pressure').value = 0.
+  return solver
+
+def run(name, adaptive):
+  model = root.create_component(name, 'cf3.solver.ModelUnsteady')
+  domain = model.create_domain()
+  physics = model.create_physics('cf3.UFEM.NavierStokesPhysics')
+  physics.density = 1000.
+  physics.dynamic_viscosity = 10.
+
+  blocks = domain.create_component('blocks', 'cf3.mesh.BlockMesh.BlockArrays')
+  points = blocks.create_points(dimensions = 2, nb_points = 4)
+  points[0] = [0., 0.]
+  points[1] = [4., 0.]
+  points[2] = [0., 1.]
+  points[3] = [4., 1.]
+  blocks.create_blocks(1)[0] = [0, 1, 3, 2]
+  blocks.create_block_subdivisions()[0] = [16, 4]
+  blocks.create_block_gradings()[0] = [1., 1., 1., 1.]
+  blocks.create_patch_nb_faces(name = 'left', nb_faces = 1)[0] = [2, 0]
+  blocks.create_patch_nb_faces(name = 'right', nb_faces = 1)[0] = [1, 3]
+  blocks.create_patch_nb_faces(name = 'top', nb_faces = 1)[0] = [3, 2]
+  blocks.create_patch_nb_faces(name = 'bottom', nb_faces = 1)[0] = [0, 1]
+
+  blocks.partition_blocks(nb_partitions = cf.Core.nb_procs(), direction = 0)
+
+  mesh = domain.create_component('Mesh', 'cf3.mesh.Mesh')
+  blocks.create_mesh(mesh.uri())
+
+  refinement = domain.create_component('Refinement', 'cf3.mesh.actions.AdaptiveRefinement')
+  refinement.mesh = mesh
+  if not adaptive:
+    refine_all = mesh.geometry.create_field(name = 'refine_all', variables = 'RefineAll')
+    for i in range(len(refine_all)):
+      refine_all[i][0] = 1.
+
+  time = model.create_time()
+  time.time_step = 0.1
+  end_time = 0.
+
+  results = []
+  for level in range(nb_levels + 1):
+    if level > 0:
+      if adaptive:
+        # Refine where the velocity gradient exceeds a quarter of its maximum
+        refinement.indicator = mesh.geometry.velocity_gradient
+        refinement.threshold = 0.25
+      else:
+        # The constant indicator flags all cells, and is interpolated exactly on the refined mesh
+        refinement.indicator = refine_all
+      refinement.execute()
+      model.Solver.delete_component()
+
+    create_solver(model, mesh, level == 0)
+    end_time += time_per_level
+    time.end_time = end_time
+    model.simulate()
+    results.append([mesh.properties()['global_nb_cells'], inlet_pressure(mesh)])
+
+  model.delete_component()
+  return results
+
+uniform = run('Uniform', False)
+adaptive = run('Adaptive', True)
+
+if cf.Core.rank() == 0:
+  reference = uniform[-1][1]
+  for (name, results) in [('uniform', uniform), ('adaptive', adaptive)]:
+    for level in range(len(results)):
+      [nb_cells, pressure] = results[level]
+      print '<DartMeasurement name=\"' + name + ' level ' + str(level) + ' cells\" type=\"numeric/integer\">' + str(nb_cells) + '</DartMeasurement>'
+      print '<DartMeasurement name=\"' + name + ' level ' + str(level) + ' inlet pressure error\" type=\"numeric/double\">' + str(abs(pressure - reference)) + '</DartMeasurement>'
+
+# The adaptive meshes must stay smaller than the uniform ones they are compared with
+for level in range(1, nb_levels + 1):
+  if adaptive[level][0] >= uniform[level][0]:
+    raise Exception('Adaptive mesh at level ' + str(level) + ' has ' + str(adaptive[level][0]) + ' cells, uniform mesh ' + str(uniform[level][0]))
@@ -0,0 +1,83 @@
+import sys
+import math
+import coolfluid as cf
+
+# Measures the number of particles per second the ParticleTracker can advance, in a solid body rotation
+
+# Some shortcuts
+root = cf.Core.root()
+env = cf.Core.environment()
+
+# Global configuration
+env.assertion_throws = False
+env.assertion_backtrace = False
+env.exception_backtrace = False
+env.regist_signal_handlers = False
+env.log_level = 1
+
+segments = 200
+nb_seeds = 300
+dt = 0.01
+nb_steps = 20
+
+def run(name, triangles):
+  model = root.create_component(name, 'cf3.solver.ModelUnsteady')
+  domain = model.create_domain()
+
+  blocks = domain.create_component('blocks', 'cf3.mesh.BlockMesh.BlockArrays')
+  points = blocks.create_points(dimensions = 2, nb_points = 4)
+  points[0] = [0., 0.]
+  points[1] = [1., 0.]
+  points[2] = [0., 1.]
+  points[3] = [1., 1.]
+  blocks.create_blocks(1)[0] = [0, 1, 3, 2]
+  blocks.create_block_subdivisions()[0] = [segments, segments]
+  blocks.create_block_gradings()[0] = [1., 1., 1., 1.]
+  blocks.create_patch_nb_faces(name = 'left', nb_faces = 1)[0] = [2, 0]
+  blocks.create_patch_nb_faces(name = 'right', nb_faces = 1)[0] = [1, 3]
+  blocks.create_patch_nb_faces(name = 'top', nb_faces = 1)[0] = [3, 2]
+  blocks.create_patch_nb_faces(name = 'bottom', nb_faces = 1)[0] = [0, 1]
+  blocks.partition_blocks(nb_partitions = cf.Core.nb_procs(), direction = 0)
+
+  mesh = domain.create_component('Mesh', 'cf3.mesh.Mesh')
+  blocks.create_mesh(mesh.uri())
+
+  if triangles:
+    triangulator = domain.create_component('Triangulator', 'cf3.mesh.MeshTriangulator')
+    triangulator.mesh = mesh
+    triangulator.execute()
+
+  coords = mesh.geometry.coordinates
+  velocity = mesh.geometry.create_field(name = 'velocity', variables = 'Velocity[vector]')
+  for i in range(len(velocity)):
+    velocity[i][0] = -(coords[i][1] - 0.5)
+    velocity[i][1] = coords[i][0] - 0.5
+
+  time = model.create_time()
+  time.time_step = dt
+
+  tracker = model.create_component('Tracker', 'cf3.UFEM.particles.ParticleTracker')
+  tracker.time = time
+  tracker.velocity_field = velocity
+  tracker.regions = [mesh.topology.uri()]
+
+  coordinates = []
+  for i in range(nb_seeds):
+    for j in range(nb_seeds):
+      coordinates += [0.15 + 0.7*(i+0.5)/nb_seeds, 0.15 + 0.7*(j+0.5)/nb_seeds]
+  tracker.add_particles(coordinates = coordinates)
+
+  particles_per_second = 0.
+  for step in range(nb_steps):
+    tracker.execute()
+    particles_per_second += tracker.properties()['particles_per_second'] / nb_steps
+
+  if tracker.properties()['nb_particles'] != nb_seeds*nb_seeds:
+    raise Exception('Particles were lost in ' + name)
+
+  print '<DartMeasurement name=\"' + name + ' particles per second\" type=\"numeric/double\">' + str(particles_per_second) + '</DartMeasurement>'
+  print '<DartMeasurement name=\"' + name + ' average walk steps\" type=\"numeric/double\">' + str(tracker.properties()['average_walk_steps']) + '</DartMeasurement>'
+  model.delete_component()
+
+run('Quads', False)
+run('Triangles', True)
@@ -0,0 +1,240 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the batched polydisperse moment solver"
+
+#include <cmath>
+#include <limits>
+
+#include <boost/test/unit_test.hpp>
+
+#include "math/MatrixTypes.hpp"
+
+#include "UFEM/particles/BatchedMomentSolver.hpp"
+
+using namespace cf3;
+using namespace cf3::UFEM::particles;
+
+/// Matrix and right hand side of the moment equations for a single node
+void assemble_reference(const std::vector<Real>& volumes, const std::vector< std::vector<Real> >& collisions, RealMatrix& mat, RealVector& rhs)
+{
+  const Uint nb_phases = volumes.size();
+  const Uint nb_moments = 2*nb_phases;
+  mat.resize(nb_moments, nb_moments);
+  rhs.resize(nb_moments);
+  rhs.setZero();
+  for(Uint alpha = 0; alpha != nb_phases; ++alpha)
+  {
+    for(Uint k = 0; k != nb_moments; ++k)
+    {
+      mat(k, alpha) = (1. - static_cast<Real>(k)) * std::pow(volumes[alpha], static_cast<int>(k));
+      mat(k, alpha + nb_phases) = k == 0 ? 0. : static_cast<Real>(k) * std::pow(volumes[alpha], static_cast<int>(k-1));
+    }
+    for(Uint gamma = 0; gamma != nb_phases; ++gamma)
+    {
+      for(Uint k = 0; k != nb_moments; ++k)
+        rhs[k] += (0.5*std::pow(volumes[alpha] + volumes[gamma], static_cast<int>(k)) - std::pow(volumes[alpha], static_cast<int>(k))) * collisions[alpha][gamma];
+    }
+  }
+}
+
+/// Reference solution, computed the same way as the original per-node implementation
+void reference_solve(const std::vector<Real>& volumes, const std::vector< std::vector<Real> >& collisions, RealVector& x)
+{
+  RealMatrix mat;
+  RealVector rhs;
+  assemble_reference(volumes, collisions, mat, rhs);
+
+  Eigen::FullPivLU<RealMatrix> lu(mat);
+  if(!lu.isInvertible())
+  {
+    Eigen::JacobiSVD<RealMatrix> svd(mat, Eigen::ComputeThinU | Eigen::ComputeThinV);
+    x = svd.solve(rhs);
+  }
+  else
+  {
+    x = lu.solve(rhs);
+  }
+}
+
+/// Normwise backward error |b - A x| / (|A| |x| + |b|) of the given solution, in the maximum norm
+Real backward_error(const std::vector<Real>& volumes, const std::vector< std::vector<Real> >& collisions, const RealVector& x)
+{
+  RealMatrix mat;
+  RealVector rhs;
+  assemble_reference(volumes, collisions, mat, rhs);
+  const Real scale = mat.cwiseAbs().rowwise().sum().maxCoeff() * x.cwiseAbs().maxCoeff() + rhs.cwiseAbs().maxCoeff();
+  return (rhs - mat*x).cwiseAbs().maxCoeff() / scale;
+}
+
+/// Compare the batched solution with the reference. If tolerance is zero, the system is too badly conditioned to
+/// compare the solutions, and only the backward error is compared
+template<Uint NbPhases>
+void check_batch(const Uint nb_lanes, const Uint singular_lane, const Uint nan_lane, const Real tolerance = 1e-8)
+{
+  typedef BatchedMomentSolver<NbPhases> SolverT;
+  SolverT solver;
+
+  std::vector< std::vector<Real> > volumes(nb_lanes, std::vector<Real>(NbPhases));
+  std::vector< std::vector< std::vector<Real> > > collisions(nb_lanes, std::vector< std::vector<Real> >(NbPhases, std::vector<Real>(NbPhases)));
+  for(Uint l = 0; l != nb_lanes; ++l)
+  {
+    for(Uint alpha = 0; alpha != NbPhases; ++alpha)
+    {
+      // Distinct volumes of order 1, except for the singular lane where two phases have the same volume
+      volumes[l][alpha] = 0.5 + 0.4*static_cast<Real>(alpha) + 0.01*static_cast<Real>(l);
+      if(l == singular_lane && alpha == 1)
+        volumes[l][alpha] = volumes[l][0];
+      solver.volumes[alpha][l] = volumes[l][alpha];
+      for(Uint gamma = 0; gamma != NbPhases; ++gamma)
+      {
+        collisions[l][alpha][gamma] = 1e-3*(1. + static_cast<Real>(alpha) + 2.*static_cast<Real>(gamma) + 0.1*static_cast<Real>(l));
+        if(l == nan_lane)
+          collisions[l][alpha][gamma] = std::numeric_limits<Real>::quiet_NaN();
+        solver.collisions[alpha][gamma][l] = collisions[l][alpha][gamma];
+      }
+    }
+  }
+
+  solver.solve(nb_lanes);
+
+  for(Uint l = 0; l != nb_lanes; ++l)
+  {
+    BOOST_CHECK_EQUAL(solver.not_finite[l], l == nan_lane);
+    if(l == nan_lane)
+      continue;
+
+    BOOST_CHECK_EQUAL(solver.ill_conditioned[l], l == singular_lane);
+
+    RealVector reference(SolverT::nb_moments);
+    reference_solve(volumes[l], collisions[l], reference);
+
+    RealVector x(SolverT::nb_moments);
+    if(solver.ill_conditioned[l])
+    {
+      solver.solve_fallback(l, x.data());
+    }
+    else
+    {
+      for(Uint k = 0; k != SolverT::nb_moments; ++k)
+        x[k] = solver.solution[k][l];
+    }
+
+    if(tolerance > 0.)
+    {
+      const Real scale = std::max(reference.norm(), 1e-12);
+      BOOST_CHECK_SMALL((x - reference).norm() / scale, tolerance);
+    }
+    else
+    {
+      BOOST_CHECK_LE(backward_error(volumes[l], collisions[l], x), std::max(10.*backward_error(volumes[l], collisions[l], reference), 1e-14));
+    }
+  }
+}
+
+/// Volumes growing geometrically from phase to phase, as for a discretized size distribution, varying slightly
+/// from node to node. Returns the number of nodes that needed the fallback solver
+template<Uint NbPhases>
+Uint check_size_distribution(const Real volume_ratio, const Uint nb_nodes)
+{
+  typedef BatchedMomentSolver<NbPhases> SolverT;
+  SolverT solver;
+  Uint nb_fallbacks = 0;
+
+  for(Uint batch_begin = 0; batch_begin < nb_nodes; batch_begin += SolverT::batch_size)
+  {
+    const Uint nb_lanes = std::min(SolverT::batch_size, nb_nodes - batch_begin);
+    std::vector< std::vector<Real> > volumes(nb_lanes, std::vector<Real>(NbPhases));
+    std::vector< std::vector< std::vector<Real> > > collisions(nb_lanes, std::vector< std::vector<Real> >(NbPhases, std::vector<Real>(NbPhases)));
+    for(Uint l = 0; l != nb_lanes; ++l)
+    {
+      const Real node_factor = 1. + 0.3*static_cast<Real>((batch_begin + l) % 17) / 17.;
+      for(Uint alpha = 0; alpha != NbPhases; ++alpha)
+      {
+        volumes[l][alpha] = node_factor * std::pow(volume_ratio, static_cast<int>(alpha));
+        solver.volumes[alpha][l] = volumes[l][alpha];
+      }
+      for(Uint alpha = 0; alpha != NbPhases; ++alpha)
+      {
+        for(Uint gamma = 0; gamma != NbPhases; ++gamma)
+        {
+          // Brownian-like kernel, times the concentrations that decrease with the volume
+          const Real beta = (2. + std::pow(volumes[l][alpha] / volumes[l][gamma], 1./3.) + std::pow(volumes[l][gamma] / volumes[l][alpha], 1./3.));
+          collisions[l][alpha][gamma] = 1e-3 * beta / (volumes[l][alpha] * volumes[l][gamma]);
+          solver.collisions[alpha][gamma][l] = collisions[l][alpha][gamma];
+        }
+      }
+    }
+
+    solver.solve(nb_lanes);
+
+    for(Uint l = 0; l != nb_lanes; ++l)
+    {
+      BOOST_CHECK(!solver.not_finite[l]);
+      RealVector x(SolverT::nb_moments);
+      if(solver.ill_conditioned[l])
+      {
+        ++nb_fallbacks;
+        solver.solve_fallback(l, x.data());
+      }
+      else
+      {
+        for(Uint k = 0; k != SolverT::nb_moments; ++k)
+          x[k] = solver.solution[k][l];
+      }
+
+      // The result must solve the system as well as the original full pivoting LU does
+      RealVector reference(SolverT::nb_moments);
+      reference_solve(volumes[l], collisions[l], reference);
+      BOOST_CHECK_LE(backward_error(volumes[l], collisions[l], x), std::max(10.*backward_error(volumes[l], collisions[l], reference), 1e-14));
+    }
+  }
+
+  return nb_fallbacks;
+}
+
+BOOST_AUTO_TEST_SUITE( BatchedMomentSolverSuite )
+
+BOOST_AUTO_TEST_CASE( TwoPhases )
+{
+  check_batch<2>(8, 8, 8);
+}
+
+BOOST_AUTO_TEST_CASE( FourPhasesPartialBatch )
+{
+  check_batch<4>(5, 5, 5);
+}
+
+BOOST_AUTO_TEST_CASE( FourPhasesSingular )
+{
+  check_batch<4>(8, 3, 8);
+}
+
+// With 8 phases of similar volumes the system is so badly conditioned that the round-off in the powers of the
+// volumes dominates the solution, so the solutions of different algorithms can not be compared
+BOOST_AUTO_TEST_CASE( EightPhasesNaN )
+{
+  check_batch<8>(7, 7, 2, 0.);
+}
+
+// Typical size distributions must mostly be solved in the batched path
+BOOST_AUTO_TEST_CASE( SizeDistributions )
+{
+  const Uint nb_nodes = 100;
+  const Uint four_phases_ratio_2 = check_size_distribution<4>(2., nb_nodes);
+  const Uint four_phases_ratio_10 = check_size_distribution<4>(10., nb_nodes);
+  const Uint eight_phases_ratio_2 = check_size_distribution<8>(2., nb_nodes);
+  const Uint eight_phases_ratio_3 = check_size_distribution<8>(3., nb_nodes);
+  BOOST_TEST_MESSAGE("fallbacks for 4 phases: " << four_phases_ratio_2 << ", " << four_phases_ratio_10
+                     << ", for 8 phases: " << eight_phases_ratio_2 << ", " << eight_phases_ratio_3);
+  BOOST_CHECK_LE(four_phases_ratio_2, nb_nodes / 10);
+  BOOST_CHECK_LE(four_phases_ratio_10, nb_nodes / 10);
+  BOOST_CHECK_LE(eight_phases_ratio_2, nb_nodes / 10);
+  BOOST_CHECK_LE(eight_phases_ratio_3, nb_nodes / 10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
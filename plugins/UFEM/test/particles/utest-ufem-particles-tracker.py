@@ -0,0 +1,179 @@
+import sys
+import coolfluid as cf
+
+# Some shortcuts
+root = cf.Core.root()
+env = cf.Core.environment()
+
+# Global configuration
+env.assertion_throws = False
+env.assertion_backtrace = False
+env.exception_backtrace = False
+env.regist_signal_handlers = False
+env.log_level = 4
+
+# Uniform flow through a 4 x 1 channel, partitioned along the flow direction so particles cross all the partitions
+u = [1., 0.05]
+dt = 0.1
+nb_steps = 30
+
+model = root.create_component('Model', 'cf3.solver.ModelUnsteady')
+domain = model.create_domain()
+
+blocks = domain.create_component('blocks', 'cf3.mesh.BlockMesh.BlockArrays')
+points = blocks.create_points(dimensions = 2, nb_points = 4)
+points[0] = [0., 0.]
+points[1] = [4., 0.]
+points[2] = [0., 1.]
+points[3] = [4., 1.]
+blocks.create_blocks(1)[0] = [0, 1, 3, 2]
+blocks.create_block_subdivisions()[0] = [40, 10]
+blocks.create_block_gradings()[0] = [1., 1., 1., 1.]
+blocks.create_patch_nb_faces(name = 'left', nb_faces = 1)[0] = [2, 0]
+blocks.create_patch_nb_faces(name = 'right', nb_faces = 1)[0] = [1, 3]
+blocks.create_patch_nb_faces(name = 'top', nb_faces = 1)[0] = [3, 2]
+blocks.create_patch_nb_faces(name = 'bottom', nb_faces = 1)[0] = [0, 1]
+blocks.partition_blocks(nb_partitions = cf.Core.nb_procs(), direction = 0)
+
+mesh = domain.create_component('Mesh', 'cf3.mesh.Mesh')
+blocks.create_mesh(mesh.uri())
+
+velocity = mesh.geometry.create_field(name = 'velocity', variables = 'Velocity[vector]')
+for i in range(len(velocity)):
+  velocity[i][0] = u[0]
+  velocity[i][1] = u[1]
+
+time = model.create_time()
+time.time_step = dt
+
+tracker = model.create_component('Tracker', 'cf3.UFEM.particles.ParticleTracker')
+tracker.time = time
+tracker.velocity_field = velocity
+tracker.regions = [mesh.topology.uri()]
+
+# Seed particles on a grid. Those starting at x > 1 leave the domain through the right boundary
+seeds = []
+for i in range(20):
+  for j in range(8):
+    seeds.append([0.05 + 0.1*i, 0.1 + 0.1*j])
+coordinates = []
+for seed in seeds:
+  coordinates += seed
+tracker.add_particles(coordinates = coordinates)
+
+if tracker.properties()['nb_particles'] != len(seeds):
+  raise Exception('Located ' + str(tracker.properties()['nb_particles']) + ' particles, expected ' + str(len(seeds)))
+
+for step in range(nb_steps):
+  tracker.execute()
+
+nb_remaining = 10*8
+if tracker.properties()['nb_particles'] != nb_remaining:
+  raise Exception('Got ' + str(tracker.properties()['nb_particles']) + ' particles, expected ' + str(nb_remaining))
+if tracker.properties()['nb_escaped'] != len(seeds) - nb_remaining:
+  raise Exception('Got ' + str(tracker.properties()['nb_escaped']) + ' escaped particles, expected ' + str(len(seeds) - nb_remaining))
+if tracker.properties()['nb_lost'] != 0:
+  raise Exception('Lost ' + str(tracker.properties()['nb_lost']) + ' particles')
+if cf.Core.nb_procs() > 1 and tracker.properties()['nb_migrated'] == 0:
+  raise Exception('No particles were migrated')
+
+# The shape functions interpolate the uniform velocity exactly
+tracker.export_particles()
+particles = tracker.get_child('particles')
+for i in range(len(particles)):
+  seed = seeds[int(particles[i][0])]
+  for d in range(2):
+    expected = seed[d] + nb_steps*dt*u[d]
+    if abs(particles[i][1+d] - expected) > 1e-10:
+      raise Exception('Wrong position for particle ' + str(particles[i][0]) + ': ' + str(particles[i][1+d]) + ', expected ' + str(expected))
+    if abs(particles[i][3+d] - u[d]) > 1e-10:
+      raise Exception('Wrong velocity for particle ' + str(particles[i][0]) + ': ' + str(particles[i][3+d]) + ', expected ' + str(u[d]))
+
+# Seeds on the faces between cells, including those between partitions, must each give a single particle
+face_tracker = model.create_component('FaceTracker', 'cf3.UFEM.particles.ParticleTracker')
+face_tracker.time = time
+face_tracker.velocity_field = velocity
+face_tracker.regions = [mesh.topology.uri()]
+face_coordinates = []
+for i in range(1, 40):
+  face_coordinates += [0.1*i, 0.55]
+face_tracker.add_particles(coordinates = face_coordinates)
+if face_tracker.properties()['nb_particles'] != 39:
+  raise Exception('Got ' + str(face_tracker.properties()['nb_particles']) + ' particles seeded on cell faces, expected 39')
+
+# Backward facing step: the channel is 4 x 1, with the lower half of the first 0.5 missing
+step_model = root.create_component('StepModel', 'cf3.solver.ModelUnsteady')
+step_domain = step_model.create_domain()
+
+blocks = step_domain.create_component('blocks', 'cf3.mesh.BlockMesh.BlockArrays')
+points = blocks.create_points(dimensions = 2, nb_points = 8)
+points[0] = [0., 0.5]
+points[1] = [0.5, 0.5]
+points[2] = [0., 1.]
+points[3] = [0.5, 1.]
+points[4] = [0.5, 0.]
+points[5] = [4., 0.]
+points[6] = [4., 0.5]
+points[7] = [4., 1.]
+block_nodes = blocks.create_blocks(3)
+block_nodes[0] = [0, 1, 3, 2]
+block_nodes[1] = [1, 6, 7, 3]
+block_nodes[2] = [4, 5, 6, 1]
+block_subdivs = blocks.create_block_subdivisions()
+block_subdivs[0] = [10, 10]
+block_subdivs[1] = [70, 10]
+block_subdivs[2] = [70, 10]
+gradings = blocks.create_block_gradings()
+gradings[0] = [1., 1., 1., 1.]
+gradings[1] = [1., 1., 1., 1.]
+gradings[2] = [1., 1., 1., 1.]
+blocks.create_patch_nb_faces(name = 'left', nb_faces = 1)[0] = [2, 0]
+step = blocks.create_patch_nb_faces(name = 'step', nb_faces = 2)
+step[0] = [0, 1]
+step[1] = [1, 4]
+blocks.create_patch_nb_faces(name = 'bottom', nb_faces = 1)[0] = [4, 5]
+right = blocks.create_patch_nb_faces(name = 'right', nb_faces = 2)
+right[0] = [5, 6]
+right[1] = [6, 7]
+top = blocks.create_patch_nb_faces(name = 'top', nb_faces = 2)
+top[0] = [7, 3]
+top[1] = [3, 2]
+blocks.partition_blocks(nb_partitions = cf.Core.nb_procs(), direction = 0)
+
+step_mesh = step_domain.create_component('Mesh', 'cf3.mesh.Mesh')
+blocks.create_mesh(step_mesh.uri())
+
+# The particle starts in the cell above the step corner. It is farthest outside the face on the step wall, so the walk
+# stops there, but it ends up in the cell diagonally below, past the corner
+step_u = [0.35, -0.5]
+step_velocity = step_mesh.geometry.create_field(name = 'velocity', variables = 'Velocity[vector]')
+for i in range(len(step_velocity)):
+  step_velocity[i][0] = step_u[0]
+  step_velocity[i][1] = step_u[1]
+
+step_time = step_model.create_time()
+step_time.time_step = dt
+
+step_tracker = step_model.create_component('Tracker', 'cf3.UFEM.particles.ParticleTracker')
+step_tracker.time = step_time
+step_tracker.velocity_field = step_velocity
+step_tracker.regions = [step_mesh.topology.uri()]
+
+step_seed = [0.475, 0.525]
+step_tracker.add_particles(coordinates = step_seed)
+step_tracker.execute()
+
+if step_tracker.properties()['nb_particles'] != 1:
+  raise Exception('Got ' + str(step_tracker.properties()['nb_particles']) + ' particles past the step, expected 1')
+if step_tracker.properties()['nb_escaped'] != 0:
+  raise Exception('Particle inside the domain was removed as escaped at the step')
+
+step_tracker.export_particles()
+particles = step_tracker.get_child('particles')
+for i in range(len(particles)):
+  for d in range(2):
+    expected = step_seed[d] + dt*step_u[d]
+    if abs(particles[i][1+d] - expected) > 1e-10:
+      raise Exception('Wrong position for the particle past the step: ' + str(particles[i][1+d]) + ', expected ' + str(expected))
+
+cf.Core.barrier()
@@ -22,6 +22,9 @@
 #include "mesh/Domain.hpp"
 #include "mesh/LagrangeP1/Triag2D.hpp"
 #include "mesh/LagrangeP1/Tetra3D.hpp"
+#include "mesh/LagrangeP1/Quad2D.hpp"
+#include "mesh/LagrangeP1/Hexa3D.hpp"
+#include "mesh/LagrangeP1/Prism3D.hpp"
 
 #include "solver/Tags.hpp"
 
@@ -50,6 +53,29 @@ struct NavierStokesAssemblyFixture
 {
   template<Uint Dim, typename ExprT>
   void run_model(const boost::shared_ptr<Mesh>& mesh, const ExprT& initial_condition_expression, const Real eps = 1e-10)
+  {
+    RealMatrix generic_result, spec_result;
+    RealVector generic_rhs, spec_rhs;
+    assemble<Dim>(mesh, initial_condition_expression, RealVector::Zero(Dim), generic_result, spec_result, generic_rhs, spec_rhs);
+    check_close(generic_result, spec_result, eps);
+  }
+
+  /// Also compares the right hand side, with the given body force. The specialized and generic matrices may differ by roundoff
+  /// for entries that are zero, so these are compared with an absolute tolerance.
+  template<Uint Dim, typename ExprT>
+  void run_model_with_force(const boost::shared_ptr<Mesh>& mesh, const ExprT& initial_condition_expression, const RealVector& force, const Real eps = 1e-10)
+  {
+    RealMatrix generic_result, spec_result;
+    RealVector generic_rhs, spec_rhs;
+    assemble<Dim>(mesh, initial_condition_expression, force, generic_result, spec_result, generic_rhs, spec_rhs);
+    check_close_or_small(generic_result, spec_result, eps);
+    check_close_or_small(generic_rhs, spec_rhs, eps);
+  }
+
+  /// Assemble the system for the given mesh, using the specializations and using the generic expression
+  template<Uint Dim, typename ExprT>
+  void assemble(const boost::shared_ptr<Mesh>& mesh, const ExprT& initial_condition_expression, const RealVector& force,
+                RealMatrix& generic_result, RealMatrix& spec_result, RealVector& generic_rhs, RealVector& spec_rhs)
   {
     boost::shared_ptr<common::Group> root = allocate_component<Group>("Root");
     Handle<ModelUnsteady> model = root->create_component<ModelUnsteady>("NavierStokes");
@@ -81,25 +107,33 @@ struct NavierStokesAssemblyFixture
     time.options().set("end_time", 1.);
     solver->create_fields();
     for_each_node<Dim>(mesh->topology(), initial_condition_expression);
+    FieldVariable<1, VectorField> g("Force", "body_force");
+    for_each_node<Dim>(mesh->topology(), g = force);
     model->simulate();
 
     const Uint matsize = lss.matrix()->blockcol_size()*lss.matrix()->neq();
 
-    RealMatrix spec_result(matsize, matsize);
+    spec_result.resize(matsize, matsize);
+    spec_rhs.resize(matsize);
     for(Uint i = 0; i != matsize; ++i)
+    {
+      lss.rhs()->get_value(i, spec_rhs[i]);
       for(Uint j = 0; j != matsize; ++j)
         lss.matrix()->get_value(i, j, spec_result(i,j));
+    }
 
     lss_action->options().set("use_specializations", false);
     time.options().set("end_time", 2.);
     model->simulate();
 
-    RealMatrix generic_result(matsize, matsize);
+    generic_result.resize(matsize, matsize);
+    generic_rhs.resize(matsize);
     for(Uint i = 0; i != matsize; ++i)
+    {
+      lss.rhs()->get_value(i, generic_rhs[i]);
       for(Uint j = 0; j != matsize; ++j)
         lss.matrix()->get_value(i, j, generic_result(i,j));
-
-    check_close(generic_result, spec_result, eps);
+    }
   }
 
   boost::shared_ptr<Mesh> create_triangle(const RealVector2& a, const RealVector2& b, const RealVector2& c)
@@ -138,12 +172,51 @@ struct NavierStokesAssemblyFixture
     return mesh_ptr;
   }
 
+  /// Create a mesh consisting of a single element of the given type
+  template<typename NodesT>
+  boost::shared_ptr<Mesh> create_element(const std::string& element_type, const NodesT& nodes)
+  {
+    boost::shared_ptr<Mesh> mesh_ptr = allocate_component<Mesh>("mesh");
+    Mesh& mesh = *mesh_ptr;
+    const Uint nb_nodes = nodes.rows();
+    const Uint dim = nodes.cols();
+    mesh.initialize_nodes(nb_nodes, dim);
+    Dictionary& geometry_dict = mesh.geometry_fields();
+    Field& coords = geometry_dict.coordinates();
+    for(Uint i = 0; i != nb_nodes; ++i)
+      for(Uint j = 0; j != dim; ++j)
+        coords[i][j] = nodes(i, j);
+
+    Elements& cells = mesh.topology().create_region("cells").create_elements(element_type, geometry_dict);
+    cells.resize(1);
+    for(Uint i = 0; i != nb_nodes; ++i)
+      cells.geometry_space().connectivity()[0][i] = i;
+
+    return mesh_ptr;
+  }
+
   void check_close(const RealMatrix& a, const RealMatrix& b, const Real eps)
   {
     for(Uint i = 0; i != a.rows(); ++i)
       for(Uint j = 0; j != a.cols(); ++j)
         BOOST_CHECK_CLOSE(a(i,j), b(i,j), eps);
   }
+
+  /// Entries that are zero up to roundoff are compared with an absolute tolerance
+  void check_close_or_small(const RealMatrix& a, const RealMatrix& b, const Real eps)
+  {
+    const Real zero_threshold = 1e-12 * a.cwiseAbs().maxCoeff();
+    for(Uint i = 0; i != a.rows(); ++i)
+    {
+      for(Uint j = 0; j != a.cols(); ++j)
+      {
+        if(std::abs(a(i,j)) < zero_threshold)
+          BOOST_CHECK_SMALL(b(i,j), 10.*zero_threshold);
+        else
+          BOOST_CHECK_CLOSE(a(i,j), b(i,j), eps);
+      }
+    }
+  }
 };
 
 BOOST_FIXTURE_TEST_SUITE( NavierStokesAssemblySuite, NavierStokesAssemblyFixture )
@@ -202,4 +275,49 @@ BOOST_AUTO_TEST_CASE( GenericTetraVortex )
   //run_model<3>(create_tetra(RealVector3(100.2, 100.1, 99.9), RealVector3(100.75, 99.9, 100.05), RealVector3(100.33, 100.83, 100.23), RealVector3(100.1, 99.9, 100.67)), u = n_op*coordinates / (coordinates[0]*coordinates[0] + coordinates[1]*coordinates[1]), 5.);
 }
 
+BOOST_AUTO_TEST_CASE( GenericQuadVortex )
+{
+  RealMatrix2 n_op; n_op << 0., 1., -1., 0.;
+  FieldVariable<0, VectorField> u("Velocity", "navier_stokes_solution");
+  mesh::LagrangeP1::Quad2D::NodesT nodes;
+  nodes << 1.0, 0.1,
+           2.2, 0.0,
+           2.0, 1.1,
+           0.9, 0.8;
+  RealVector force(2); force << 0.5, -2.;
+  run_model_with_force<2>(create_element("cf3.mesh.LagrangeP1.Quad2D", nodes), u = n_op*coordinates / (coordinates[0]*coordinates[0] + coordinates[1]*coordinates[1]), force);
+}
+
+BOOST_AUTO_TEST_CASE( GenericHexaVortex )
+{
+  RealMatrix3 n_op; n_op << 0., 1., 0., -1., 0., 0., 0., 0., 0.;
+  FieldVariable<0, VectorField> u("Velocity", "navier_stokes_solution");
+  mesh::LagrangeP1::Hexa3D::NodesT nodes;
+  nodes << 1.0, 0.1, 0.0,
+           2.1, 0.0, 0.1,
+           2.0, 1.2, 0.0,
+           0.9, 1.0, 0.0,
+           1.0, 0.0, 1.0,
+           2.0, 0.1, 1.1,
+           2.1, 1.0, 1.0,
+           1.0, 0.9, 1.2;
+  RealVector force(3); force << 0.5, -2., 1.;
+  run_model_with_force<3>(create_element("cf3.mesh.LagrangeP1.Hexa3D", nodes), u = n_op*coordinates / (coordinates[0]*coordinates[0] + coordinates[1]*coordinates[1]), force);
+}
+
+BOOST_AUTO_TEST_CASE( GenericPrismVortex )
+{
+  RealMatrix3 n_op; n_op << 0., 1., 0., -1., 0., 0., 0., 0., 0.;
+  FieldVariable<0, VectorField> u("Velocity", "navier_stokes_solution");
+  mesh::LagrangeP1::Prism3D::NodesT nodes;
+  nodes << 1.0, 0.1, 0.0,
+           2.1, 0.0, 0.1,
+           1.1, 1.0, 0.0,
+           1.0, 0.0, 1.0,
+           2.0, 0.1, 1.1,
+           0.9, 1.1, 1.0;
+  RealVector force(3); force << 0.5, -2., 1.;
+  run_model_with_force<3>(create_element("cf3.mesh.LagrangeP1.Prism3D", nodes), u = n_op*coordinates / (coordinates[0]*coordinates[0] + coordinates[1]*coordinates[1]), force);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
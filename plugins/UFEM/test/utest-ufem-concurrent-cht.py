@@ -0,0 +1,147 @@
+import sys
+import coolfluid as cf
+
+# Some shortcuts
+root = cf.Core.root()
+env = cf.Core.environment()
+
+# Global configuration
+env.assertion_throws = False
+env.assertion_backtrace = False
+env.exception_backtrace = False
+env.regist_signal_handlers = False
+env.log_level = 4
+
+# Conjugate heat transfer between two slabs, each solved by its own group of processes:
+# - the first half of the processes solves the "fluid" for 0 < y < 1, with conductivity 1 and T = 0 at y = 0
+# - the second half solves the "solid" for 1 < y < 2, with conductivity 2 and T = 10 at y = 2
+# The fluid gets the interface temperature of the solid as a Dirichlet condition, and the solid gets the heat flux
+# computed by HeatCouplingFlux from the fluid temperature on a copy of the first row of fluid cells.
+nb_procs = cf.Core.world_nb_procs()
+if nb_procs < 2:
+  raise Exception('This test needs at least 2 processes')
+color = 0 if cf.Core.world_rank() < nb_procs/2 else 1
+cf.Core.split(color)
+
+k_solid = 2.
+T_bottom = 0.
+T_top = 10.
+# Exact solution: both slabs have unit thickness, so the heat flux is the temperature difference divided by the sum of the resistances
+flux = (T_top - T_bottom) / (1. + 1./k_solid)
+T_interface = T_bottom + flux
+
+def exact_temperature(y):
+  if y <= 1.:
+    return T_bottom + flux*y
+  return T_interface + flux/k_solid*(y - 1.)
+
+model = root.create_component('Model', 'cf3.solver.Model')
+domain = model.create_domain()
+physics = model.create_physics('cf3.UFEM.NavierStokesPhysics')
+solver = model.create_solver('cf3.UFEM.Solver')
+hc = solver.add_direct_solver('cf3.UFEM.HeatConductionSteady')
+
+# Both meshes have a row of cells for 0.75 < y < 1, which is the region where the fluid temperature is exchanged
+y_points = [0., 0.75, 1.] if color == 0 else [0.75, 1., 2.]
+blocks = domain.create_component('blocks', 'cf3.mesh.BlockMesh.BlockArrays')
+points = blocks.create_points(dimensions = 2, nb_points = 6)
+for i in range(3):
+  points[2*i] = [0., y_points[i]]
+  points[2*i+1] = [1., y_points[i]]
+block_nodes = blocks.create_blocks(2)
+block_nodes[0] = [0, 1, 3, 2]
+block_nodes[1] = [2, 3, 5, 4]
+block_subdivs = blocks.create_block_subdivisions()
+block_subdivs[0] = [4, 3 if color == 0 else 1]
+block_subdivs[1] = [4, 1 if color == 0 else 4]
+gradings = blocks.create_block_gradings()
+gradings[0] = [1., 1., 1., 1.]
+gradings[1] = [1., 1., 1., 1.]
+bottom_patch = blocks.create_patch_nb_faces(name = 'bottom', nb_faces = 1)
+bottom_patch[0] = [0, 1]
+top_patch = blocks.create_patch_nb_faces(name = 'top', nb_faces = 1)
+top_patch[0] = [5, 4]
+sides_patch = blocks.create_patch_nb_faces(name = 'sides', nb_faces = 4)
+sides_patch[0] = [2, 0]
+sides_patch[1] = [1, 3]
+sides_patch[2] = [4, 2]
+sides_patch[3] = [3, 5]
+blocks.options().set('block_regions', ['interior', 'layer'] if color == 0 else ['fluid', 'solid'])
+blocks.partition_blocks(nb_partitions = cf.Core.nb_procs(), direction = 0)
+
+mesh = domain.create_component('Mesh', 'cf3.mesh.Mesh')
+blocks.create_mesh(mesh.uri())
+
+bc = hc.BoundaryConditions
+bc.regions = [mesh.topology.uri()]
+if color == 0:
+  hc.regions = [mesh.access_component('topology/interior').uri(), mesh.access_component('topology/layer').uri()]
+  bc.add_constant_bc(region_name = 'bottom', variable_name = 'Temperature').value = T_bottom
+  interface_bc = bc.create_bc_action(region_name = 'top', builder_name = 'cf3.UFEM.BCHoldValue')
+  interface_bc.set_tags(from_field_tag = 'coupling', to_field_tag = 'heat_conduction_solution', from_variable = 'Treceive', to_variable = 'Temperature')
+else:
+  hc.regions = [mesh.access_component('topology/solid').uri()]
+  hc.children.Assembly.options.k = k_solid
+  bc.add_constant_bc(region_name = 'top', variable_name = 'Temperature').value = T_top
+  interface_bc = bc.create_bc_action(region_name = 'region_bnd_fluid_solid', builder_name = 'cf3.UFEM.HeatCouplingFlux')
+  interface_bc.options().set('gradient_region', mesh.access_component('topology/fluid'))
+  interface_bc.options().set('temperature_field_tag', 'fluid_temperature')
+
+solver.create_fields()
+
+coords = mesh.geometry.coordinates
+temperature = mesh.geometry.heat_conduction_solution
+
+# The fluid sends its temperature on the layer and receives the solid temperature there, the solid does the reverse
+coupling = model.create_component('Coupling', 'cf3.UFEM.ConcurrentCoupling')
+coupling.partner_color = 1 - color
+coupling.send_field = temperature
+coupling.send_variable = 'Temperature'
+if color == 0:
+  coupling.receive_field = mesh.geometry.coupling
+  coupling.receive_variable = 'Treceive'
+  coupling.regions = [mesh.access_component('topology/layer').uri()]
+else:
+  coupling.receive_field = mesh.geometry.fluid_temperature
+  coupling.receive_variable = 'Temperature'
+  coupling.regions = [mesh.access_component('topology/fluid').uri()]
+
+# Each coupling iteration solves the heat conduction of this group
+hc.move_component(path = coupling.uri())
+
+for iteration in range(60):
+  coupling.execute()
+
+# Temperature in the solved part of the domain, and the heat flux from the nodes next to the interface
+interface_values = {}
+inner_values = {}
+for i in range(len(coords)):
+  x = round(coords[i][0], 8)
+  y = coords[i][1]
+  if color == 1 and y < 1. - 1e-8:
+    continue
+  T = temperature[i][0]
+  if abs(T - exact_temperature(y)) > 1e-5:
+    raise Exception('Wrong temperature at ' + str(coords[i]) + ': ' + str(T) + ', expected ' + str(exact_temperature(y)))
+  if abs(y - 1.) < 1e-8:
+    interface_values[x] = T
+  elif abs(y - (0.75 if color == 0 else 1.25)) < 1e-8:
+    inner_values[x] = T
+
+if len(interface_values) == 0:
+  raise Exception('No interface nodes found')
+for x, T in interface_values.items():
+  if abs(T - T_interface) > 1e-5:
+    raise Exception('Wrong interface temperature at x = ' + str(x) + ': ' + str(T) + ', expected ' + str(T_interface))
+  if x in inner_values:
+    computed_flux = (T - inner_values[x]) / 0.25 if color == 0 else k_solid * (inner_values[x] - T) / 0.25
+    if abs(computed_flux - flux) > 1e-4:
+      raise Exception('Wrong interface heat flux at x = ' + str(x) + ': ' + str(computed_flux) + ', expected ' + str(flux))
+
+if coupling.properties()['compute_time'] <= 0.:
+  raise Exception('No compute time recorded for the heat conduction solve')
+efficiency = coupling.properties()['overlap_efficiency']
+if efficiency < 0. or efficiency > 1.:
+  raise Exception('Invalid overlap efficiency ' + str(efficiency))
+
+cf.Core.barrier()
@@ -0,0 +1,91 @@
+import sys
+import coolfluid as cf
+
+# Some shortcuts
+root = cf.Core.root()
+env = cf.Core.environment()
+
+# Global configuration
+env.assertion_throws = False
+env.assertion_backtrace = False
+env.exception_backtrace = False
+env.regist_signal_handlers = False
+env.log_level = 4
+
+# The first half of the processes runs the lower domain, the second half the upper domain
+nb_procs = cf.Core.world_nb_procs()
+if nb_procs < 2:
+  raise Exception('This test needs at least 2 processes')
+color = 0 if cf.Core.world_rank() < nb_procs/2 else 1
+cf.Core.split(color)
+
+model = root.create_component('Model', 'cf3.solver.ModelUnsteady')
+domain = model.create_domain()
+
+# Both domains share the line y = 1, but have a different number of nodes on it
+y0 = float(color)
+x_segs = 10 if color == 0 else 7
+blocks = domain.create_component('blocks', 'cf3.mesh.BlockMesh.BlockArrays')
+points = blocks.create_points(dimensions = 2, nb_points = 4)
+points[0] = [0., y0]
+points[1] = [1., y0]
+points[2] = [0., y0 + 1.]
+points[3] = [1., y0 + 1.]
+block_nodes = blocks.create_blocks(1)
+block_nodes[0] = [0, 1, 3, 2]
+block_subdivs = blocks.create_block_subdivisions()
+block_subdivs[0] = [x_segs, 4]
+gradings = blocks.create_block_gradings()
+gradings[0] = [1., 1., 1., 1.]
+bottom_patch = blocks.create_patch_nb_faces(name = 'bottom', nb_faces = 1)
+bottom_patch[0] = [0, 1]
+top_patch = blocks.create_patch_nb_faces(name = 'top', nb_faces = 1)
+top_patch[0] = [3, 2]
+sides_patch = blocks.create_patch_nb_faces(name = 'sides', nb_faces = 2)
+sides_patch[0] = [2, 0]
+sides_patch[1] = [1, 3]
+blocks.partition_blocks(nb_partitions = cf.Core.nb_procs(), direction = 0)
+
+mesh = domain.create_component('Mesh', 'cf3.mesh.Mesh')
+blocks.create_mesh(mesh.uri())
+
+# Each domain sends a linear function of x, offset by the color
+coords = mesh.geometry.coordinates
+coupling_field = mesh.geometry.create_field(name = 'coupling', variables = 'Tsend,Treceive')
+for i in range(len(coords)):
+  coupling_field[i][0] = 10.*color + 1. + 2.*coords[i][0]
+  coupling_field[i][1] = -1.
+
+coupling = model.create_component('Coupling', 'cf3.UFEM.ConcurrentCoupling')
+coupling.partner_color = 1 - color
+coupling.send_field = coupling_field
+coupling.send_variable = 'Tsend'
+coupling.receive_field = coupling_field
+coupling.receive_variable = 'Treceive'
+coupling.regions = [mesh.topology.access_component('top' if color == 0 else 'bottom').uri()]
+
+def check_received():
+  partner = 1 - color
+  for i in range(len(coords)):
+    if abs(coords[i][1] - 1.) < 1e-12:
+      expected = 10.*partner + 1. + 2.*coords[i][0]
+      if abs(coupling_field[i][1] - expected) > 1e-10:
+        raise Exception('Wrong interface value at x = ' + str(coords[i][0]) + ': ' + str(coupling_field[i][1]) + ', expected ' + str(expected))
+    elif coupling_field[i][1] != -1.:
+      raise Exception('Value changed for a node that is not on the interface')
+
+for iteration in range(2):
+  coupling.execute()
+  check_received()
+
+coupling.coupling = 'Staggered'
+coupling.leader = (color == 0)
+for iteration in range(2):
+  coupling.execute()
+  check_received()
+
+efficiency = coupling.properties()['overlap_efficiency']
+if efficiency < 0. or efficiency > 1.:
+  raise Exception('Invalid overlap efficiency ' + str(efficiency))
+
+cf.Core.barrier()
@@ -161,6 +161,16 @@ BOOST_AUTO_TEST_CASE( ReadBinaryData )
   BOOST_CHECK(read_real_table.array() == write_real_table->array());
   BOOST_CHECK(read_real_list.array() == write_real_list->array());
   BOOST_CHECK(read_int_list.array() == write_int_list->array());
+
+  // The stored checksums allow verifying data without reading it
+  BOOST_CHECK(reader.has_checksum(0));
+  BOOST_CHECK(reader.verify_table(*write_int_table, 0));
+  BOOST_CHECK(reader.verify_table(*write_real_table, 1));
+  BOOST_CHECK(reader.verify_list(*write_real_list, 2));
+  BOOST_CHECK(reader.verify_list(*write_int_list, 3));
+  BOOST_CHECK(!reader.verify_table(*write_real_table, 0));
+  read_real_table[0][0] += 1.;
+  BOOST_CHECK(!reader.verify_table(read_real_table, 1));
   
   common::List<Real>& empty_real_list = *read_group.create_component< common::List<Real> >("EmptyRealList");
   common::Table<Real>& empty_real_table = *read_group.create_component< common::Table<Real> >("EmptyRealTable");
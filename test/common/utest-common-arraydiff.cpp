@@ -8,6 +8,7 @@
 #define BOOST_TEST_MODULE "Test module for cf3::Component"
 
 #include <iostream>
+#include <limits>
 
 #include <boost/mpl/if.hpp>
 #include <boost/test/unit_test.hpp>
@@ -16,6 +17,7 @@
 #include <boost/random/uniform_real_distribution.hpp>
 
 #include "common/Action.hpp"
+#include "common/ArrayChecksum.hpp"
 #include "common/Core.hpp"
 #include "common/List.hpp"
 #include "common/OptionList.hpp"
@@ -189,6 +191,74 @@ BOOST_AUTO_TEST_CASE( CompareArrays )
   BOOST_CHECK(!array_differ->properties().value<bool>("arrays_equal"));
 }
 
+BOOST_AUTO_TEST_CASE( BlockChecksums )
+{
+  common::Component& group = *common::Core::instance().root().get_child("Group");
+  common::Table<Real>& table1 = *group.create_component< common::Table<Real> >("ChecksumTable1");
+  common::Table<Real>& table2 = *group.create_component< common::Table<Real> >("ChecksumTable2");
+  table1.set_row_size(real_table_cols);
+  table1.resize(real_table_size);
+  fill_table(table1);
+  table2.set_row_size(real_table_cols);
+  table2.resize(real_table_size);
+  table2.array() = table1.array();
+
+  const Uint block_rows = 1000;
+  std::vector<common::ChecksumT> checksums1, checksums2;
+  common::block_checksums(table1, checksums1, block_rows);
+  common::block_checksums(table2, checksums2, block_rows);
+  BOOST_CHECK_EQUAL(checksums1.size(), (real_table_size + block_rows - 1) / block_rows);
+  BOOST_CHECK(checksums1 == checksums2);
+
+  // A single changed value only changes the checksum of its block
+  table2[1500][3] = 2.;
+  common::block_checksums(table2, checksums2, block_rows);
+  Uint nb_different = 0;
+  for(Uint i = 0; i != checksums1.size(); ++i)
+  {
+    if(checksums1[i] != checksums2[i])
+    {
+      BOOST_CHECK_EQUAL(i, 1u);
+      ++nb_different;
+    }
+  }
+  BOOST_CHECK_EQUAL(nb_different, 1u);
+  BOOST_CHECK(common::combine_checksums(checksums1) != common::combine_checksums(checksums2));
+
+  // Values that are a few ulps apart may have the same checksum when a tolerance is given, but never when the difference is larger
+  table2.array() = table1.array();
+  table2[10][0] = table1[10][0] * (1. + 40.*std::numeric_limits<Real>::epsilon());
+  common::block_checksums(table1, checksums1, block_rows, 16);
+  common::block_checksums(table2, checksums2, block_rows, 16);
+  BOOST_CHECK(checksums1[0] != checksums2[0]);
+
+  table2[10][0] = -0.;
+  table1[10][0] = 0.;
+  common::block_checksums(table1, checksums1, block_rows);
+  common::block_checksums(table2, checksums2, block_rows);
+  BOOST_CHECK(checksums1 == checksums2);
+
+  const common::ChecksumT combined = common::combine_checksums(checksums1);
+  BOOST_CHECK_EQUAL(common::checksum_to_str(combined).size(), 16u);
+  BOOST_CHECK_EQUAL(common::checksum_from_str(common::checksum_to_str(combined)), combined);
+
+  // ArrayDiff only compares the values in the blocks with a different checksum
+  Handle<common::Action> array_differ(group.get_child("ArrayDiff"));
+  array_differ->options().set("checksum_block_rows", 100u);
+  array_differ->options().set("left", table1.handle());
+  array_differ->options().set("right", table2.handle());
+  array_differ->execute();
+  BOOST_CHECK(array_differ->properties().value<bool>("arrays_equal"));
+  table2[real_table_size-1][real_table_cols-1] += 1e-10;
+  array_differ->execute();
+  BOOST_CHECK(!array_differ->properties().value<bool>("arrays_equal"));
+
+  // Exhaustive comparison
+  array_differ->options().set("checksum_block_rows", 0u);
+  array_differ->execute();
+  BOOST_CHECK(!array_differ->properties().value<bool>("arrays_equal"));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 BOOST_AUTO_TEST_SUITE_END()
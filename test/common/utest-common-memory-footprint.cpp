@@ -0,0 +1,62 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::common::MemoryComponent"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/DynTable.hpp"
+#include "common/Group.hpp"
+#include "common/List.hpp"
+#include "common/MemoryComponent.hpp"
+#include "common/Table.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( MemoryFootprintSuite )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Footprints )
+{
+  Group& group = *Core::instance().root().create_component<Group>("Footprints");
+
+  Table<Real>& table = *group.create_component< Table<Real> >("table");
+  table.set_row_size(3);
+  table.resize(10);
+  BOOST_CHECK_EQUAL(table.memory_footprint(), 30*sizeof(Real));
+
+  List<Uint>& list = *group.create_component< List<Uint> >("list");
+  list.resize(7);
+  BOOST_CHECK_EQUAL(list.memory_footprint(), 7*sizeof(Uint));
+
+  DynTable<Uint>& dyntable = *group.create_component< DynTable<Uint> >("dyntable");
+  dyntable.resize(1);
+  dyntable.set_row(0, std::vector<Uint>(5, 1u));
+  BOOST_CHECK_GE(dyntable.memory_footprint(), 5*sizeof(Uint));
+
+  // Children are summed, components without data count as zero
+  Group& sub = *group.create_component<Group>("sub");
+  Table<Real>& sub_table = *sub.create_component< Table<Real> >("table");
+  sub_table.set_row_size(2);
+  sub_table.resize(4);
+
+  BOOST_CHECK_EQUAL(memory_footprint(sub), 8*sizeof(Real));
+  BOOST_CHECK_EQUAL(memory_footprint(group), table.memory_footprint() + list.memory_footprint() + dyntable.memory_footprint() + memory_footprint(sub));
+
+  print_memory_tree(group);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
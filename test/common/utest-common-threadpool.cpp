@@ -0,0 +1,91 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::common::ThreadPool"
+
+#include <stdexcept>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/ThreadPool.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct Increment
+{
+  Increment(std::vector<Uint>& a_values) : values(a_values) {}
+
+  void operator()(const Uint begin, const Uint end, const Uint thread) const
+  {
+    for(Uint i = begin; i != end; ++i)
+      ++values[i];
+  }
+
+  std::vector<Uint>& values;
+};
+
+struct ThrowAt
+{
+  ThrowAt(const Uint a_idx) : idx(a_idx) {}
+
+  void operator()(const Uint begin, const Uint end, const Uint thread) const
+  {
+    if(begin <= idx && idx < end)
+      throw std::runtime_error("error in loop body");
+  }
+
+  Uint idx;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE( ThreadPoolSuite )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( AllIndicesVisitedOnce )
+{
+  ThreadPool& pool = ThreadPool::instance();
+  std::vector<Uint> values(10007, 0);
+  Uint nb_loops = 0;
+  for(Uint nb_threads = 1; nb_threads <= 8; nb_threads *= 2)
+  {
+    pool.set_nb_threads(nb_threads);
+    BOOST_CHECK_EQUAL(pool.nb_threads(), nb_threads);
+    pool.parallel_for(0, values.size(), Increment(values));
+    pool.parallel_for(0, values.size(), 37, Increment(values));
+    nb_loops += 2;
+  }
+  pool.set_nb_threads(1);
+
+  for(Uint i = 0; i != values.size(); ++i)
+    BOOST_CHECK_EQUAL(values[i], nb_loops);
+}
+
+BOOST_AUTO_TEST_CASE( ExceptionsAreForwarded )
+{
+  ThreadPool& pool = ThreadPool::instance();
+  pool.set_nb_threads(4);
+  BOOST_CHECK_THROW(pool.parallel_for(0, 1000, 10, ThrowAt(505)), ParallelError);
+
+  // The pool must remain usable
+  std::vector<Uint> values(100, 0);
+  pool.parallel_for(0, values.size(), Increment(values));
+  for(Uint i = 0; i != values.size(); ++i)
+    BOOST_CHECK_EQUAL(values[i], 1u);
+  pool.set_nb_threads(1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,189 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for cf3::common::Tracer"
+
+#include <fstream>
+#include <iterator>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Group.hpp"
+#include "common/ThreadPool.hpp"
+#include "common/Tracer.hpp"
+#include "common/URI.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct TracerFixture
+{
+  TracerFixture()
+  {
+    Tracer::instance().clear();
+    Tracer::instance().set_enabled(true);
+  }
+
+  ~TracerFixture()
+  {
+    Tracer::instance().set_enabled(false);
+    Tracer::instance().clear();
+  }
+
+  /// Write the trace and return the file contents
+  std::string write_and_read(const std::string& filename)
+  {
+    Tracer::instance().write_chrome_trace(URI(filename));
+    std::ifstream file(filename.c_str());
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  /// Number of occurrences of a substring
+  Uint count(const std::string& str, const std::string& sub)
+  {
+    Uint result = 0;
+    for(std::string::size_type pos = str.find(sub); pos != std::string::npos; pos = str.find(sub, pos + sub.size()))
+      ++result;
+    return result;
+  }
+};
+
+/// Records one scope per index
+struct TraceIndices
+{
+  TraceIndices(const Uint a_name) : name(a_name) {}
+
+  void operator()(const Uint begin, const Uint end, const Uint thread) const
+  {
+    for(Uint i = begin; i != end; ++i)
+      TraceScope trace(name);
+  }
+
+  Uint name;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( TracerSuite, TracerFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( NestedScopes )
+{
+  Tracer& tracer = Tracer::instance();
+  const Uint outer = tracer.register_name("outer");
+  const Uint inner = tracer.register_name("inner \"quoted\"");
+  BOOST_CHECK_EQUAL(tracer.register_name("outer"), outer);
+
+  {
+    TraceScope outer_trace(outer);
+    for(Uint i = 0; i != 3; ++i)
+      TraceScope inner_trace(inner);
+  }
+  tracer.record(outer, Tracer::ASYNC_BEGIN, 42);
+  tracer.record(outer, Tracer::ASYNC_END, 42);
+
+  const std::string trace = write_and_read("utest-common-tracer-nested.json");
+  BOOST_CHECK_EQUAL(count(trace, "\"ph\":\"B\""), 4u);
+  BOOST_CHECK_EQUAL(count(trace, "\"ph\":\"E\""), 4u);
+  BOOST_CHECK_EQUAL(count(trace, "\"name\":\"inner \\\"quoted\\\"\""), 6u);
+  BOOST_CHECK_EQUAL(count(trace, "\"id\":42"), 2u);
+  BOOST_CHECK_EQUAL(tracer.nb_dropped(), 0u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Disabled )
+{
+  Tracer& tracer = Tracer::instance();
+  tracer.set_enabled(false);
+  {
+    TraceScope trace(tracer.register_name("disabled"));
+  }
+  const std::string trace = write_and_read("utest-common-tracer-disabled.json");
+  BOOST_CHECK_EQUAL(count(trace, "\"ph\":\"B\""), 0u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Threads )
+{
+  ThreadPool& pool = ThreadPool::instance();
+  pool.set_nb_threads(4);
+  pool.parallel_for(0, 1000, 10, TraceIndices(Tracer::instance().register_name("index")));
+  pool.set_nb_threads(1);
+
+  const std::string trace = write_and_read("utest-common-tracer-threads.json");
+  BOOST_CHECK_EQUAL(count(trace, "\"ph\":\"B\""), 1000u);
+  BOOST_CHECK_EQUAL(count(trace, "\"ph\":\"E\""), 1000u);
+  BOOST_CHECK_GE(count(trace, "\"thread_name\""), 1u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( ComponentName )
+{
+  Handle<Group> group = Core::instance().root().create_component<Group>("traced_group");
+  TraceName cached_name;
+  {
+    TraceScope trace(*group, cached_name);
+  }
+  BOOST_CHECK_EQUAL(cached_name.name, Tracer::instance().register_name(group->uri().path()) + 1);
+
+  // The cached name is used as long as the path does not change
+  const Uint first_name = cached_name.name;
+  {
+    TraceScope trace(*group, cached_name);
+  }
+  BOOST_CHECK_EQUAL(cached_name.name, first_name);
+
+  // After renaming, the new path is registered
+  group->rename("renamed_group");
+  {
+    TraceScope trace(*group, cached_name);
+  }
+  BOOST_CHECK_EQUAL(cached_name.name, Tracer::instance().register_name(group->uri().path()) + 1);
+
+  // Moving the component also changes its path
+  Handle<Group> parent = Core::instance().root().create_component<Group>("traced_parent");
+  group->move_to(*parent);
+  {
+    TraceScope trace(*group, cached_name);
+  }
+
+  const std::string trace = write_and_read("utest-common-tracer-component.json");
+  BOOST_CHECK_EQUAL(count(trace, "\"name\":\"/traced_group\",\"ph\":\"B\""), 2u);
+  BOOST_CHECK_EQUAL(count(trace, "\"name\":\"/renamed_group\",\"ph\":\"B\""), 1u);
+  BOOST_CHECK_EQUAL(count(trace, "\"name\":\"/traced_parent/renamed_group\",\"ph\":\"B\""), 1u);
+  Core::instance().root().remove_component(*parent);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Overflow )
+{
+  Tracer& tracer = Tracer::instance();
+  tracer.set_buffer_size(8);
+  const Uint name = tracer.register_name("overflow");
+  for(Uint i = 0; i != 10; ++i)
+    TraceScope trace(name);
+
+  BOOST_CHECK_EQUAL(tracer.nb_dropped(), 12u);
+  const std::string trace = write_and_read("utest-common-tracer-overflow.json");
+  BOOST_CHECK_EQUAL(count(trace, "\"name\":\"overflow\""), 8u);
+
+  tracer.set_buffer_size(65536);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -7,11 +7,18 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE "Test module for cf3::Component"
 
+#include <boost/bind.hpp>
 #include <boost/test/unit_test.hpp>
+#include <boost/weak_ptr.hpp>
 
 #include "common/Log.hpp"
 #include "common/Component.hpp"
+#include "common/FindComponents.hpp"
 #include "common/Group.hpp"
+#include "common/Link.hpp"
+#include "common/StringConversion.hpp"
+#include "common/ThreadPool.hpp"
+#include "common/Timer.hpp"
 
 #include "Tools/Testing/ProfiledTestFixture.hpp"
 #include "Tools/Testing/TimedTestFixture.hpp"
@@ -34,6 +41,163 @@ BOOST_AUTO_TEST_CASE( constructor )
     common::allocate_component<common::Group>("test");
 }
 
+/// Repeated recursive queries, as done by loop actions on each execution
+BOOST_AUTO_TEST_CASE( cached_queries )
+{
+  boost::shared_ptr<common::Group> root = common::allocate_component<common::Group>("root");
+  for(Uint i = 0; i != 100; ++i)
+  {
+    common::Group& level1 = *root->create_component<common::Group>("level1_" + common::to_str(i));
+    for(Uint j = 0; j != 20; ++j)
+    {
+      Handle<common::Component> leaf = level1.create_component<common::Link>("leaf_" + common::to_str(j));
+      if(j % 4 == 0)
+        leaf->add_tag("face_entity");
+    }
+  }
+
+  const Uint nb_queries = 1000;
+
+  // Collect the components in a vector and filter them by hand
+  common::Timer timer;
+  Uint nb_found_by_hand = 0;
+  for(Uint i = 0; i != nb_queries; ++i)
+  {
+    std::vector< boost::shared_ptr<common::Link> > links;
+    root->put_components<common::Link>(links, true);
+    const common::IsComponentTag is_face("face_entity");
+    BOOST_FOREACH(const boost::shared_ptr<common::Link>& link, links)
+    {
+      if(is_face(*link))
+        ++nb_found_by_hand;
+    }
+  }
+  const Real by_hand_time = timer.elapsed();
+
+  timer.restart();
+  Uint nb_found = 0;
+  for(Uint i = 0; i != nb_queries; ++i)
+  {
+    BOOST_FOREACH(const common::Link& link, common::find_components_recursively_with_tag<common::Link>(*root, "face_entity"))
+      ++nb_found;
+  }
+  const Real query_time = timer.elapsed();
+
+  BOOST_CHECK_EQUAL(nb_found, nb_queries*500);
+  BOOST_CHECK_EQUAL(nb_found, nb_found_by_hand);
+  CFinfo << "filtered by hand: " << by_hand_time << " s, tagged query: " << query_time << " s" << CFendl;
+
+  // Changes to the tree invalidate the cached lists of children
+  const Uint generation = root->structure_generation();
+  Handle<common::Component> level1(root->get_child("level1_0"));
+  Handle<common::Component> extra = level1->create_component<common::Link>("extra");
+  BOOST_CHECK(root->structure_generation() > generation);
+  BOOST_CHECK_EQUAL(common::count(common::find_components_recursively_with_tag<common::Link>(*root, "face_entity")), 500u);
+  extra->add_tag("face_entity");
+  BOOST_CHECK_EQUAL(common::count(common::find_components_recursively_with_tag<common::Link>(*root, "face_entity")), 501u);
+  level1->remove_component("leaf_0");
+  BOOST_CHECK_EQUAL(common::count(common::find_components_recursively_with_tag<common::Link>(*root, "face_entity")), 500u);
+  BOOST_CHECK_EQUAL(common::count(common::find_components_recursively<common::Link>(*root)), 2000u);
+  extra->remove_tag("face_entity");
+  BOOST_CHECK_EQUAL(common::count(common::find_components_recursively_with_tag<common::Link>(*root, "face_entity")), 499u);
+  root->remove_component("level1_1");
+  BOOST_CHECK_EQUAL(common::count(common::find_components_recursively<common::Link>(static_cast<const common::Component&>(*root))), 1980u);
+  BOOST_CHECK_EQUAL(common::count(common::find_components_recursively_with_tag(*root, "face_entity")), 494u);
+
+  // Removed components are not kept alive by the queries of their former parents
+  boost::weak_ptr<common::Component> removed = root->remove_component("level1_2");
+  BOOST_CHECK(removed.expired());
+}
+
+/// A repeated recursive query returns the stored list instead of walking the tree again
+BOOST_AUTO_TEST_CASE( recursive_query_storage )
+{
+  typedef std::vector< boost::shared_ptr<common::Link> > LinksT;
+  typedef std::vector< boost::shared_ptr<common::Link const> > ConstLinksT;
+
+  boost::shared_ptr<common::Group> root = common::allocate_component<common::Group>("root");
+  for(Uint i = 0; i != 10; ++i)
+  {
+    common::Group& level1 = *root->create_component<common::Group>("level1_" + common::to_str(i));
+    for(Uint j = 0; j != 10; ++j)
+      level1.create_component<common::Link>("leaf_" + common::to_str(j));
+  }
+  const common::Component& const_root = *root;
+  Handle<common::Component> level1_0(root->get_child("level1_0"));
+  Handle<common::Component> level1_1(root->get_child("level1_1"));
+
+  boost::shared_ptr<const LinksT> links = root->cached_components<common::Link>(true);
+  boost::shared_ptr<const ConstLinksT> const_links = const_root.cached_components<common::Link>(true);
+  boost::shared_ptr<const LinksT> level1_1_links = level1_1->cached_components<common::Link>(true);
+  boost::shared_ptr< const std::vector< boost::shared_ptr<common::Group> > > groups = root->cached_components<common::Group>(false);
+  BOOST_CHECK_EQUAL(links->size(), 100u);
+  BOOST_CHECK_EQUAL(const_links->size(), 100u);
+  BOOST_CHECK(root->cached_components<common::Link>(true) == links);
+  BOOST_CHECK(const_root.cached_components<common::Link>(true) == const_links);
+  BOOST_CHECK(root->cached_components<common::Link>(false) != links);
+  BOOST_CHECK(root->cached_components<common::Link>(false)->empty());
+
+  // A change below level1_0 invalidates the recursive lists of level1_0 and root, but not of its sibling
+  // or the direct children of root
+  Handle<common::Component> extra = level1_0->create_component<common::Link>("extra");
+  boost::shared_ptr<const LinksT> new_links = root->cached_components<common::Link>(true);
+  BOOST_CHECK(new_links != links);
+  BOOST_CHECK_EQUAL(new_links->size(), 101u);
+  BOOST_CHECK_EQUAL(links->size(), 100u);
+  BOOST_CHECK(const_root.cached_components<common::Link>(true) != const_links);
+  BOOST_CHECK(level1_1->cached_components<common::Link>(true) == level1_1_links);
+  BOOST_CHECK(root->cached_components<common::Group>(false) == groups);
+  BOOST_CHECK(root->cached_components<common::Link>(true) == new_links);
+
+  // Tags change the result of filtered queries, so they invalidate the lists too
+  extra->add_tag("face_entity");
+  BOOST_CHECK(root->cached_components<common::Link>(true) != new_links);
+  BOOST_CHECK_EQUAL(common::count(common::find_components_recursively_with_tag<common::Link>(*root, "face_entity")), 1u);
+
+  // The stored lists do not keep removed components alive
+  links.reset();
+  const_links.reset();
+  new_links.reset();
+  root->cached_components<common::Link>(true);
+  boost::weak_ptr<common::Component> removed = level1_0->remove_component("extra");
+  BOOST_CHECK(removed.expired());
+  BOOST_CHECK_EQUAL(root->cached_components<common::Link>(true)->size(), 100u);
+}
+
+/// Count the children of each level1 group in the given range
+void count_children(const common::Component& root, const Uint begin, const Uint end, std::vector<Uint>& counts)
+{
+  for(Uint i = begin; i != end; ++i)
+  {
+    const common::Component& level1 = *root.get_child("level1_" + common::to_str(i % 100));
+    counts[i] = common::count(common::find_components<common::Link>(level1));
+  }
+}
+
+/// Queries from threaded loops share the cached lists
+BOOST_AUTO_TEST_CASE( threaded_queries )
+{
+  boost::shared_ptr<common::Group> root = common::allocate_component<common::Group>("root");
+  for(Uint i = 0; i != 100; ++i)
+  {
+    common::Group& level1 = *root->create_component<common::Group>("level1_" + common::to_str(i));
+    for(Uint j = 0; j != 20; ++j)
+      level1.create_component<common::Link>("leaf_" + common::to_str(j));
+  }
+
+  common::ThreadPool& pool = common::ThreadPool::instance();
+  const Uint nb_threads = pool.nb_threads();
+  pool.set_nb_threads(4);
+
+  const Uint nb_queries = 10000;
+  std::vector<Uint> counts(nb_queries, 0);
+  pool.parallel_for(0, nb_queries, 10, boost::bind(&count_children, boost::cref(*root), _1, _2, boost::ref(counts)));
+  pool.set_nb_threads(nb_threads);
+
+  for(Uint i = 0; i != nb_queries; ++i)
+    BOOST_CHECK_EQUAL(counts[i], 20u);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -19,9 +19,11 @@
 #include "common/Link.hpp"
 #include "common/OptionList.hpp"
 #include "common/PropertyList.hpp"
+#include "common/StringConversion.hpp"
 
 #include "common/XML/Protocol.hpp"
 #include "common/XML/SignalFrame.hpp"
+#include "common/XML/SignalOptions.hpp"
 
 using namespace std;
 using namespace boost;
@@ -297,6 +299,130 @@ BOOST_AUTO_TEST_CASE( clear )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+/// Call list_tree_since on the given component and return the frame, which owns the reply
+SignalFrame call_list_tree_since( Component& comp, const Uint version, const Uint depth )
+{
+  SignalOptions options;
+  options.add( "version", version );
+  options.add( "depth", depth );
+  SignalFrame frame = options.create_frame( "list_tree_since", comp.uri(), comp.uri() );
+  comp.call_signal( "list_tree_since", frame );
+  return frame;
+}
+
+BOOST_AUTO_TEST_CASE( list_tree_since )
+{
+  boost::shared_ptr<Component> root = allocate_component<Group> ( "Simulator" );
+  Handle<Component> c1 = root->create_component<Group>("c1");
+  c1->create_component<Group>("c1_1");
+  root->create_component<Group>("c2");
+
+  // nothing changed
+  const Uint v0 = Component::tree_version();
+  SignalFrame frame = call_list_tree_since( *root, v0, 0 );
+  SignalFrame reply = frame.get_reply();
+  BOOST_CHECK_EQUAL( SignalOptions(reply).value<Uint>("version"), v0 );
+  BOOST_CHECK( SignalOptions(reply).value< std::vector<std::string> >("removed").empty() );
+  BOOST_CHECK( is_null( reply.map("added").main_map.content.content->first_node() ) );
+  BOOST_CHECK( is_null( reply.map("changed").main_map.content.content->first_node() ) );
+
+  // add a subtree, remove a component and add an option
+  Handle<Component> c3 = c1->create_component<Group>("c3");
+  c3->create_component<Group>("c3_1");
+  root->remove_component("c2");
+  c1->options().add("test_option", 1.);
+
+  const Uint v1 = Component::tree_version();
+  BOOST_CHECK_GT( v1, v0 );
+
+  frame = call_list_tree_since( *root, v0, 1 );
+  reply = frame.get_reply();
+  BOOST_CHECK_EQUAL( SignalOptions(reply).value<Uint>("version"), v1 );
+
+  const std::vector<std::string> removed = SignalOptions(reply).value< std::vector<std::string> >("removed");
+  BOOST_CHECK_EQUAL( removed.size(), 1u );
+  BOOST_CHECK_EQUAL( removed.front(), "/c2" );
+
+  // only the top of the new subtree is listed, with a depth of 1
+  XmlNode added( reply.map("added").main_map.content.content->first_node() );
+  BOOST_CHECK( added.is_valid() );
+  BOOST_CHECK_EQUAL( added.attribute_value("name"), "c3" );
+  BOOST_CHECK_EQUAL( added.attribute_value("parent"), "/c1" );
+  BOOST_CHECK_EQUAL( added.attribute_value("truncated"), "true" );
+  BOOST_CHECK( is_null( added.content->first_node() ) );
+  BOOST_CHECK( is_null( added.content->next_sibling() ) );
+
+  XmlNode changed( reply.map("changed").main_map.content.content->first_node() );
+  BOOST_CHECK( changed.is_valid() );
+  BOOST_CHECK_EQUAL( changed.attribute_value("path"), "/c1" );
+  BOOST_CHECK( SignalFrame(changed).map( Protocol::Tags::key_properties() ).main_map.check_entry("test_option") );
+  BOOST_CHECK( is_null( changed.content->next_sibling() ) );
+
+  // changing the option value and renaming
+  c1->options().set("test_option", 2.);
+  c3->rename("c4");
+
+  frame = call_list_tree_since( *root, v1, 0 );
+  reply = frame.get_reply();
+  BOOST_CHECK_EQUAL( SignalOptions(reply).value< std::vector<std::string> >("removed").front(), "/c1/c3" );
+  added = XmlNode( reply.map("added").main_map.content.content->first_node() );
+  BOOST_CHECK_EQUAL( added.attribute_value("name"), "c4" );
+  BOOST_CHECK( added.content->first_attribute("truncated") == nullptr );
+  BOOST_CHECK( is_not_null( added.content->first_node() ) );
+  changed = XmlNode( reply.map("changed").main_map.content.content->first_node() );
+  BOOST_CHECK_EQUAL( changed.attribute_value("path"), "/c1" );
+
+  // a component that is created again replaces the removed one
+  root->create_component<Group>("c2");
+  frame = call_list_tree_since( *root, v0, 0 );
+  reply = frame.get_reply();
+  const std::vector<std::string> removed_since_v0 = SignalOptions(reply).value< std::vector<std::string> >("removed");
+  BOOST_CHECK_EQUAL( removed_since_v0.size(), 1u );
+  BOOST_CHECK_EQUAL( removed_since_v0.front(), "/c1/c3" );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( list_tree_since_removal_log )
+{
+  boost::shared_ptr<Component> root = allocate_component<Group> ( "Simulator" );
+  Handle<Component> c1 = root->create_component<Group>("c1");
+  c1->create_component<Group>("kept");
+
+  // more removals than the log keeps
+  const Uint v0 = Component::tree_version();
+  for(Uint i = 0; i != 200; ++i)
+    c1->remove_component(c1->create_component<Group>("removed_" + to_str(i))->name());
+  const Uint v1 = Component::tree_version();
+  c1->remove_component(c1->create_component<Group>("last")->name());
+
+  // recent removals are still listed incrementally
+  SignalFrame frame = call_list_tree_since( *root, v1, 0 );
+  SignalFrame reply = frame.get_reply();
+  BOOST_CHECK( !SignalOptions(reply).value<bool>("reset") );
+  BOOST_CHECK_EQUAL( SignalOptions(reply).value< std::vector<std::string> >("removed").size(), 1u );
+  BOOST_CHECK( is_null( reply.map("added").main_map.content.content->first_node() ) );
+
+  // the parent lists c1 again completely
+  frame = call_list_tree_since( *root, v0, 0 );
+  reply = frame.get_reply();
+  BOOST_CHECK( !SignalOptions(reply).value<bool>("reset") );
+  XmlNode added( reply.map("added").main_map.content.content->first_node() );
+  BOOST_CHECK_EQUAL( added.attribute_value("name"), "c1" );
+  BOOST_CHECK_EQUAL( added.attribute_value("parent"), "/" );
+  BOOST_CHECK( is_not_null( added.content->first_node() ) );
+
+  // c1 itself asks the caller to replace all of its children
+  frame = call_list_tree_since( *c1, v0, 0 );
+  reply = frame.get_reply();
+  BOOST_CHECK( SignalOptions(reply).value<bool>("reset") );
+  added = XmlNode( reply.map("added").main_map.content.content->first_node() );
+  BOOST_CHECK_EQUAL( added.attribute_value("name"), "kept" );
+  BOOST_CHECK( is_null( added.content->next_sibling() ) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_SUITE_END()
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,149 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the library manifest"
+
+#include <cstdlib>
+#include <fstream>
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/Core.hpp"
+#include "common/LibLoader.hpp"
+#include "common/Libraries.hpp"
+#include "common/OSystem.hpp"
+#include "common/PropertyList.hpp"
+#include "common/URI.hpp"
+
+#include "common/PE/Comm.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct LibrariesManifestFixture
+{
+  LibrariesManifestFixture() :
+    m_argc(boost::unit_test::framework::master_test_suite().argc),
+    m_argv(boost::unit_test::framework::master_test_suite().argv)
+  {
+  }
+
+  /// Write a manifest with the given contents on rank 0 and return its full path on rank 0.
+  /// The other ranks get a file in a directory that does not exist, so they can only see the manifest and its directory through the broadcast
+  boost::filesystem::path write_manifest(const std::string& filename, const std::string& contents)
+  {
+    const boost::filesystem::path path = boost::filesystem::current_path() / filename;
+    if(PE::Comm::instance().rank() == 0)
+    {
+      std::ofstream output(path.string().c_str());
+      output << contents;
+    }
+    PE::Comm::instance().barrier();
+    if(PE::Comm::instance().rank() != 0)
+      return boost::filesystem::current_path() / ("missing-rank-" + boost::lexical_cast<std::string>(PE::Comm::instance().rank())) / filename;
+    return path;
+  }
+
+  int m_argc;
+  char** m_argv;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( LibrariesManifestSuite, LibrariesManifestFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( init_mpi )
+{
+  Core::instance().initiate(m_argc,m_argv);
+  PE::Comm::instance().init(m_argc,m_argv);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( parse )
+{
+  const boost::filesystem::path manifest = write_manifest("utest-libraries.manifest",
+    "# comment line\n"
+    "\n"
+    "utest_relative   libutest_relative.so  \n"
+    "   # indented comment\n"
+    "utest_absolute /opt/lib/libutest_absolute.so\n"
+    "utest_subdir plugins/libutest_subdir.so");
+
+  Libraries& libraries = Core::instance().libraries();
+  BOOST_CHECK(libraries.read_manifest(URI(manifest.string(), URI::Scheme::FILE)));
+
+  // Relative paths are resolved against the directory of the manifest read by rank 0
+  const boost::filesystem::path dir = boost::filesystem::current_path();
+  BOOST_CHECK_EQUAL(libraries.manifest_path("utest_relative"), (dir / "libutest_relative.so").string());
+  BOOST_CHECK_EQUAL(libraries.manifest_path("utest_absolute"), "/opt/lib/libutest_absolute.so");
+  BOOST_CHECK_EQUAL(libraries.manifest_path("utest_subdir"), (dir / "plugins" / "libutest_subdir.so").string());
+  BOOST_CHECK(libraries.manifest_path("utest_unknown").empty());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( empty_manifest )
+{
+  // An existing manifest without entries still counts as read
+  const boost::filesystem::path manifest = write_manifest("utest-libraries-empty.manifest", "");
+  BOOST_CHECK(Core::instance().libraries().read_manifest(URI(manifest.string(), URI::Scheme::FILE)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( missing_manifest )
+{
+  const boost::filesystem::path manifest = boost::filesystem::current_path() / "utest-libraries-missing.manifest";
+  BOOST_CHECK(!Core::instance().libraries().read_manifest(URI(manifest.string(), URI::Scheme::FILE)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( invalid_line )
+{
+  // All ranks parse the broadcast contents, so all of them fail
+  const boost::filesystem::path manifest = write_manifest("utest-libraries-invalid.manifest", "utest_valid libutest_valid.so\nutest_no_file\n");
+  BOOST_CHECK_THROW(Core::instance().libraries().read_manifest(URI(manifest.string(), URI::Scheme::FILE)), ParsingFailed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( default_manifest )
+{
+  // Without an explicit file, the manifest next to the loaded coolfluid_common library is used, in the build tree as well as in an installation
+  if(std::getenv("COOLFLUID_LIBRARY_MANIFEST") != NULL)
+    return;
+
+  const std::string common_library_dir = OSystem::instance().lib_loader()->common_library_dir();
+  BOOST_REQUIRE(!common_library_dir.empty());
+
+  Libraries& libraries = Core::instance().libraries();
+  BOOST_CHECK(libraries.read_manifest());
+  BOOST_CHECK_EQUAL(libraries.properties().value<std::string>("manifest"), (boost::filesystem::path(common_library_dir) / Libraries::manifest_filename()).string());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( finalize_mpi )
+{
+  PE::Comm::instance().finalize();
+  Core::instance().terminate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
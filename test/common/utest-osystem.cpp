@@ -63,6 +63,12 @@ BOOST_AUTO_TEST_CASE( layer )
   BOOST_CHECK( OSystem::instance().layer()->process_id() > 0 );
 
   BOOST_CHECK( OSystem::instance().layer()->memory_usage() > 0 );
+
+  const Real resident = OSystem::instance().layer()->resident_memory();
+  BOOST_CHECK( resident > 0 );
+  // Zero if the platform does not report the peak
+  const Real peak = OSystem::instance().layer()->peak_resident_memory();
+  BOOST_CHECK( peak == 0 || peak >= resident );
 }
 
 //////////////////////////////////////////////////////////////////////////////
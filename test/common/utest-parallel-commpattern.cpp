@@ -212,6 +212,80 @@ BOOST_AUTO_TEST_CASE( commpattern_mainstream )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( commpattern_fused_synchronization )
+{
+  const int nproc=PE::Comm::instance().size();
+  const int irank=PE::Comm::instance().rank();
+
+  // fused synchronization on one commpattern, and one synchronization per array on the other
+  boost::shared_ptr<CommPattern> fused_ptr = allocate_component<CommPattern>("FusedCommPattern");
+  boost::shared_ptr<CommPattern> single_ptr = allocate_component<CommPattern>("SingleCommPattern");
+  CommPattern& fused = *fused_ptr;
+  CommPattern& single = *single_ptr;
+
+  std::vector<Uint> fused_gid, single_gid;
+  std::vector<Uint> fused_rank, single_rank;
+  setupGidAndRank(fused_gid,fused_rank);
+  setupGidAndRank(single_gid,single_rank);
+  fused.insert("gid",fused_gid,1,false);
+  single.insert("gid",single_gid,1,false);
+
+  std::vector<int> fused_v1, single_v1;
+  for(int i=0;i<6*nproc;i++) fused_v1.push_back(-((irank+1)*1000+i+1));
+  single_v1=fused_v1;
+  std::vector<double> fused_v2, single_v2;
+  for(int i=0;i<18*nproc;i++) fused_v2.push_back((double)((irank+1)*1000+i+1));
+  single_v2=fused_v2;
+  fused.insert("v1",fused_v1,1,true);
+  fused.insert("v2",fused_v2,3,true);
+  single.insert("v1",single_v1,1,true);
+  single.insert("v2",single_v2,3,true);
+
+  fused.setup(Handle<CommWrapper>(fused.get_child("gid")),fused_rank);
+  single.setup(Handle<CommWrapper>(single.get_child("gid")),single_rank);
+
+  std::vector<std::string> names;
+  names.push_back("v1");
+  names.push_back("v2");
+  fused.synchronize(names);
+  single.synchronize("v1");
+  single.synchronize("v2");
+
+  BOOST_CHECK(fused_v1 == single_v1);
+  BOOST_CHECK(fused_v2 == single_v2);
+
+  // data registered after a synchronization must be picked up by synchronize_all
+  std::vector<Real> fused_v3, single_v3;
+  for(int i=0;i<12*nproc;i++) fused_v3.push_back((Real)(-(irank+1)*100-i));
+  single_v3=fused_v3;
+  fused.insert("v3",fused_v3,2,true);
+  single.insert("v3",single_v3,2,true);
+  fused.synchronize_all();
+  single.synchronize("v3");
+
+  BOOST_CHECK(fused_v1 == single_v1);
+  BOOST_CHECK(fused_v2 == single_v2);
+  BOOST_CHECK(fused_v3 == single_v3);
+
+  // wrappers moved in or removed through the generic component API must be picked up as well
+  std::vector<int> fused_v4, single_v4;
+  for(int i=0;i<6*nproc;i++) fused_v4.push_back((irank+1)*10000+i);
+  single_v4=fused_v4;
+  boost::shared_ptr<Group> holder = allocate_component<Group>("Holder");
+  Handle< CommWrapperVector<int> > v4_wrapper = holder->create_component< CommWrapperVector<int> >("v4");
+  v4_wrapper->setup(fused_v4,1,true);
+  v4_wrapper->move_to(fused);
+  single.insert("v4",single_v4,1,true);
+  fused.remove_component("v3");
+  fused.synchronize_all();
+  single.synchronize("v4");
+
+  BOOST_CHECK(is_null(fused.get_child("v3")));
+  BOOST_CHECK(fused_v4 == single_v4);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( commpattern_external_synchronization )
 {
 /*
@@ -81,6 +81,41 @@ BOOST_AUTO_TEST_CASE( rank_and_size )
   BOOST_CHECK_LT( PE::Comm::instance().rank() , PE::Comm::instance().size() );
 }
 
+BOOST_AUTO_TEST_CASE( split_and_merge )
+{
+  PE::Comm& comm = PE::Comm::instance();
+  const Uint world_rank = comm.rank();
+  const Uint world_size = comm.size();
+  BOOST_CHECK( !comm.is_split() );
+
+  // Even ranks form group 0, odd ranks group 1
+  const int color = world_rank % 2;
+  comm.split(color);
+  BOOST_CHECK( comm.is_split() || world_size == 1 );
+  BOOST_CHECK_EQUAL( comm.color(), color );
+  BOOST_CHECK_EQUAL( comm.world_rank(), world_rank );
+  BOOST_CHECK_EQUAL( comm.world_size(), world_size );
+  BOOST_CHECK_EQUAL( comm.size(), (world_size + 1 - color) / 2 );
+  BOOST_CHECK_EQUAL( comm.rank(), world_rank / 2 );
+
+  const std::vector<int> group = comm.group_world_ranks(color);
+  BOOST_CHECK_EQUAL( group.size(), comm.size() );
+  BOOST_CHECK_EQUAL( group[comm.rank()], static_cast<int>(world_rank) );
+
+  // Collectives only involve the group
+  const Uint group_size = comm.size();
+  const Uint one = 1;
+  Uint sum = 0;
+  comm.all_reduce(PE::plus(), &one, 1, &sum);
+  BOOST_CHECK_EQUAL( sum, group_size );
+
+  comm.merge();
+  BOOST_CHECK( !comm.is_split() );
+  BOOST_CHECK_EQUAL( comm.color(), 0 );
+  BOOST_CHECK_EQUAL( comm.rank(), world_rank );
+  BOOST_CHECK_EQUAL( comm.size(), world_size );
+}
+
 BOOST_AUTO_TEST_CASE( finalize )
 {
   PEProcessSortedExecute(-1,CFinfo << "Proccess " << PE::Comm::instance().rank() << "/" << PE::Comm::instance().size() << " says good bye." << CFendl;);
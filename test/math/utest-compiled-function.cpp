@@ -0,0 +1,202 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the compiled function evaluation"
+
+#include <cmath>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Log.hpp"
+#include "common/Timer.hpp"
+
+#include "math/CompiledFunction.hpp"
+#include "math/Consts.hpp"
+#include "math/VectorialFunction.hpp"
+
+using namespace cf3;
+using namespace cf3::math;
+using namespace cf3::common;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct CompiledFunctionFixture
+{
+  CompiledFunctionFixture()
+  {
+    variables.push_back("x");
+    variables.push_back("y");
+    variables.push_back("z");
+  }
+
+  /// Points with coordinates in ]-1, 1[
+  std::vector<Real> make_points(const Uint nb_points)
+  {
+    std::vector<Real> result(nb_points*3);
+    for(Uint i = 0; i != result.size(); ++i)
+      result[i] = 0.9*std::sin(1.3*static_cast<Real>(i) + 0.1);
+    return result;
+  }
+
+  /// Check the compiled result against the FunctionParser for the points where the FunctionParser reports no error
+  void check_function(const std::string& function)
+  {
+    FunctionParser parser;
+    parser.AddConstant("pi", Consts::pi());
+    BOOST_REQUIRE_EQUAL(parser.Parse(function, "x,y,z"), -1);
+
+    CompiledFunction compiled;
+    BOOST_REQUIRE(compiled.compile(std::vector<std::string>(1, function), variables));
+
+    const Uint nb_points = 200;
+    std::vector<Real> points = make_points(nb_points);
+    std::vector<Real> results(nb_points);
+    compiled.evaluate(&points[0], nb_points, &results[0]);
+    for(Uint i = 0; i != nb_points; ++i)
+    {
+      const Real expected = parser.Eval(&points[3*i]);
+      if(parser.EvalError() != 0)
+        continue;
+      BOOST_CHECK_SMALL(results[i] - expected, 1e-12*(1. + std::abs(expected)));
+    }
+  }
+
+  std::vector<std::string> variables;
+};
+
+BOOST_FIXTURE_TEST_SUITE( CompiledFunctionSuite, CompiledFunctionFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Syntax )
+{
+  check_function("x+y*z");
+  check_function("-x^2");
+  check_function("2^-1*x");
+  check_function("x^y^0.5");
+  check_function("x*-y");
+  check_function("(x+y)*(x-y)/(1+z*z)");
+  check_function("x^3 + x^2 + pi*x");
+  check_function("2e-3*x + .5*y");
+  check_function("x%0.3 + pow(x,2.5) + pow(y,2)");
+  check_function("if(x>0.2, y, z*2)");
+  check_function("x<y & y>=z | !x");
+  check_function("x = y | x != z | x <= y");
+  check_function("max(x,y)-min(y,z)+abs(x-z)");
+  check_function("int(x*10)+trunc(-y*10)+floor(z)+ceil(x)");
+  check_function("sin(x)*cos(y)+tan(z)+exp(-z*z)+sqrt(x*x+y*y)");
+  check_function("atan2(y,x)+hypot(x,y)+cbrt(x-0.5)");
+  check_function("tanh(y)+sinh(z)+cosh(x)+exp2(x)+cot(y+2)+sec(z)+csc(x+3)");
+  check_function("log(abs(x)+1) + log10(y*y+1) + log2(z*z+2)");
+  check_function("acosh(x*x+1)+asinh(y)+atanh(z*0.5)+acos(x*0.5)+asin(y*0.5)+atan(z)");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( ConstantFolding )
+{
+  CompiledFunction compiled;
+  BOOST_CHECK(compiled.compile(std::vector<std::string>(1, "1+2*3+sin(pi/2)"), variables));
+  BOOST_CHECK_EQUAL(compiled.nb_instructions(), 0u);
+
+  std::vector<Real> points = make_points(1);
+  Real result = 0.;
+  compiled.evaluate(&points[0], 1, &result);
+  BOOST_CHECK_CLOSE(result, 8., 1e-12);
+
+  BOOST_CHECK(compiled.compile(std::vector<std::string>(1, "x^2"), variables));
+  BOOST_CHECK_EQUAL(compiled.nb_instructions(), 1u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Conditional expressions that may raise floating point exceptions and unknown syntax are left to the FunctionParser
+BOOST_AUTO_TEST_CASE( Unsupported )
+{
+  CompiledFunction compiled;
+  BOOST_CHECK(!compiled.compile(std::vector<std::string>(1, "if(x>0, sqrt(x), 0)"), variables));
+  BOOST_CHECK(!compiled.compile(std::vector<std::string>(1, "x & log(y)"), variables));
+  BOOST_CHECK(!compiled.compile(std::vector<std::string>(1, "a := x*2; a+1"), variables));
+
+  VectorialFunction function("[if(x>0, sqrt(x), 0)][x+y]", "x,y,z");
+  BOOST_CHECK(!function.is_compiled());
+
+  const Uint nb_points = 100;
+  std::vector<Real> points = make_points(nb_points);
+  std::vector<Real> results(2*nb_points);
+  function.evaluate_points(&points[0], nb_points, &results[0]);
+  for(Uint i = 0; i != nb_points; ++i)
+  {
+    const Real x = points[3*i];
+    BOOST_CHECK_EQUAL(results[2*i], x > 0. ? std::sqrt(x) : 0.);
+    BOOST_CHECK_CLOSE(results[2*i+1], x + points[3*i+1], 1e-12);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( MultipleFunctions )
+{
+  VectorialFunction function("[x+y][x][3][x*y+z]", "x,y,z");
+  BOOST_CHECK(function.is_compiled());
+
+  // Not a multiple of the block size
+  const Uint nb_points = 3*CompiledFunction::block_size + 7;
+  std::vector<Real> points = make_points(nb_points);
+  std::vector<Real> results(4*nb_points);
+  function.evaluate_points(&points[0], nb_points, &results[0]);
+  for(Uint i = 0; i != nb_points; ++i)
+  {
+    const Real x = points[3*i];
+    const Real y = points[3*i+1];
+    const Real z = points[3*i+2];
+    BOOST_CHECK_EQUAL(results[4*i], x + y);
+    BOOST_CHECK_EQUAL(results[4*i+1], x);
+    BOOST_CHECK_EQUAL(results[4*i+2], 3.);
+    BOOST_CHECK_EQUAL(results[4*i+3], x*y + z);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Compare the throughput per point with the point-by-point FunctionParser evaluation
+BOOST_AUTO_TEST_CASE( Benchmark )
+{
+  const Uint nb_points = 1000000;
+  std::vector<Real> points = make_points(nb_points);
+  std::vector<Real> results(nb_points);
+
+  std::vector<std::string> functions;
+  functions.push_back("x+y*z");
+  functions.push_back("sin(x)*cos(y)+exp(-z*z)");
+  functions.push_back("(x+y)*(x-y)/(1+z*z) + 0.5*x^2 - 3*y*z + if(x>0.2, y, z)");
+
+  for(Uint f = 0; f != functions.size(); ++f)
+  {
+    FunctionParser parser;
+    parser.Parse(functions[f], "x,y,z");
+    Timer timer;
+    for(Uint i = 0; i != nb_points; ++i)
+      results[i] = parser.Eval(&points[3*i]);
+    const Real parser_time = timer.elapsed();
+
+    CompiledFunction compiled;
+    BOOST_CHECK(compiled.compile(std::vector<std::string>(1, functions[f]), variables));
+    timer.restart();
+    compiled.evaluate(&points[0], nb_points, &results[0]);
+    const Real compiled_time = timer.elapsed();
+
+    CFinfo << functions[f] << ": FunctionParser " << static_cast<Real>(nb_points) / parser_time * 1e-6 << " Mpoints/s, compiled "
+           << static_cast<Real>(nb_points) / compiled_time * 1e-6 << " Mpoints/s" << CFendl;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,340 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the AMG solution strategy on a matrix without Trilinos"
+
+#include <cmath>
+#include <map>
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/BasicExceptions.hpp"
+#include "common/Builder.hpp"
+#include "common/Core.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+
+#include "math/LSS/AMGStrategy.hpp"
+#include "math/LSS/LibLSS.hpp"
+#include "math/LSS/Matrix.hpp"
+#include "math/LSS/Vector.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::math;
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/// Serial vector with one equation, storing only what the AMG strategy needs
+class SerialVector : public LSS::Vector
+{
+public:
+  static std::string type_name () { return "SerialVector"; }
+  SerialVector(const std::string& name) : LSS::Vector(name) {}
+
+  void resize(const Uint n) { m_values.assign(n, 0.); }
+  Real operator[](const Uint i) const { return m_values[i]; }
+
+  const std::string solvertype() { return "Serial"; }
+  void create(common::PE::CommPattern&, Uint, const std::vector<Uint>&, const std::vector<bool>&) { not_implemented(); }
+  void create_blocked(common::PE::CommPattern&, const VariablesDescriptor&, const std::vector<Uint>&, const std::vector<bool>&) { not_implemented(); }
+  void destroy() { m_values.clear(); }
+  void set_value(const Uint irow, const Real value) { m_values[irow] = value; }
+  void add_value(const Uint irow, const Real value) { m_values[irow] += value; }
+  void get_value(const Uint irow, Real& value) { value = m_values[irow]; }
+  void set_value(const Uint iblockrow, const Uint, const Real value) { m_values[iblockrow] = value; }
+  void add_value(const Uint iblockrow, const Uint, const Real value) { m_values[iblockrow] += value; }
+  void get_value(const Uint iblockrow, const Uint, Real& value) { value = m_values[iblockrow]; }
+  void set_rhs_values(const LSS::BlockAccumulator&) { not_implemented(); }
+  void add_rhs_values(const LSS::BlockAccumulator&) { not_implemented(); }
+  void get_rhs_values(LSS::BlockAccumulator&) { not_implemented(); }
+  void set_sol_values(const LSS::BlockAccumulator&) { not_implemented(); }
+  void add_sol_values(const LSS::BlockAccumulator&) { not_implemented(); }
+  void get_sol_values(LSS::BlockAccumulator&) { not_implemented(); }
+  void reset(Real reset_to=0.) { std::fill(m_values.begin(), m_values.end(), reset_to); }
+  void get(boost::multi_array<Real, 2>&) { not_implemented(); }
+  void set(boost::multi_array<Real, 2>&) { not_implemented(); }
+  void print(common::LogStream&) { not_implemented(); }
+  void print(std::ostream&) { not_implemented(); }
+  void print_native(std::ostream&) { not_implemented(); }
+  void print(const std::string&, std::ios_base::openmode) { not_implemented(); }
+  const bool is_created() { return !m_values.empty(); }
+  const Uint neq() { return 1; }
+  const Uint blockrow_size() { return m_values.size(); }
+  void clone_to(LSS::Vector& other) { dynamic_cast<SerialVector&>(other).m_values = m_values; }
+  void assign(const LSS::Vector&) { not_implemented(); }
+  void update(const LSS::Vector&, const Real) { not_implemented(); }
+  void scale(const Real alpha) { for(Uint i = 0; i != m_values.size(); ++i) m_values[i] *= alpha; }
+  void sync() {}
+  void read_native(const common::URI&, const std::string) { not_implemented(); }
+  void debug_data(std::vector<Real>& values) { values = m_values; }
+
+private:
+  void not_implemented() { throw common::NotImplemented(FromHere(), "Not needed by the AMG strategy"); }
+  std::vector<Real> m_values;
+};
+
+/// The AMG strategy creates its work vectors with the builder of the solution
+common::ComponentBuilder<SerialVector, LSS::Vector, LSS::LibLSS> SerialVector_Builder;
+
+/// Serial sparse matrix with one equation, storing only what the AMG strategy needs.
+/// Ghost rows are left out of debug_data, as if they were owned by another rank
+class SerialMatrix : public LSS::Matrix
+{
+public:
+  static std::string type_name () { return "SerialMatrix"; }
+  SerialMatrix(const std::string& name) : LSS::Matrix(name), track_generation(true) {}
+
+  void resize(const Uint n) { changed(); m_rows.assign(n, RowT()); }
+  void add_ghost_row(const Uint i) { m_ghost_rows.insert(i); }
+
+  /// Count the modifications in the generation, as required by LSS::Matrix
+  bool track_generation;
+
+  const std::string solvertype() { return "Serial"; }
+  const bool is_swappable(const LSS::Vector&, const LSS::Vector&) { return false; }
+  void create(common::PE::CommPattern&, const Uint, const std::vector<Uint>&, const std::vector<Uint>&, LSS::Vector&, LSS::Vector&, const std::vector<Uint>&, const std::vector<bool>&) { not_implemented(); }
+  void create_blocked(common::PE::CommPattern&, const VariablesDescriptor&, const std::vector<Uint>&, const std::vector<Uint>&, LSS::Vector&, LSS::Vector&, const std::vector<Uint>&, const std::vector<bool>&) { not_implemented(); }
+  void destroy() { changed(); m_rows.clear(); }
+  void set_value(const Uint icol, const Uint irow, const Real value) { changed(); m_rows[irow][icol] = value; }
+  void add_value(const Uint icol, const Uint irow, const Real value) { changed(); m_rows[irow][icol] += value; }
+  void get_value(const Uint icol, const Uint irow, Real& value) { value = m_rows[irow][icol]; }
+  void set_values(const LSS::BlockAccumulator&) { not_implemented(); }
+  void add_values(const LSS::BlockAccumulator&) { not_implemented(); }
+  void get_values(LSS::BlockAccumulator&) { not_implemented(); }
+  void set_row(const Uint, const Uint, Real, Real) { not_implemented(); }
+  void get_column_and_replace_to_zero(const Uint, Uint, std::vector<Real>&) { not_implemented(); }
+  void symmetric_dirichlet(const Uint, const Uint, const Real, LSS::Vector&) { not_implemented(); }
+  void tie_blockrow_pairs (const Uint, const Uint) { not_implemented(); }
+  void set_diagonal(const std::vector<Real>&) { not_implemented(); }
+  void add_diagonal(const std::vector<Real>&) { not_implemented(); }
+  void get_diagonal(std::vector<Real>&) { not_implemented(); }
+  void reset(Real reset_to=0.)
+  {
+    changed();
+    for(Uint i = 0; i != m_rows.size(); ++i)
+      for(RowT::iterator it = m_rows[i].begin(); it != m_rows[i].end(); ++it)
+        it->second = reset_to;
+  }
+  void print(common::LogStream&) { not_implemented(); }
+  void print(std::ostream&) { not_implemented(); }
+  void print(const std::string&, std::ios_base::openmode) { not_implemented(); }
+  void print_native(std::ostream&) { not_implemented(); }
+  const bool is_created() { return !m_rows.empty(); }
+  const Uint neq() { return 1; }
+  const Uint blockrow_size() { return m_rows.size(); }
+  const Uint blockcol_size() { return m_rows.size(); }
+  void clone_to(LSS::Matrix&) { not_implemented(); }
+  void read_native(const common::URI&) { not_implemented(); }
+  void apply(const Handle<LSS::Vector>& y, const Handle<LSS::Vector const>& x, const Real alpha = 1., const Real beta = 0.)
+  {
+    std::vector<Real> x_values;
+    const_cast<LSS::Vector&>(*x).debug_data(x_values);
+    for(Uint i = 0; i != m_rows.size(); ++i)
+    {
+      Real ax = 0.;
+      for(RowT::const_iterator it = m_rows[i].begin(); it != m_rows[i].end(); ++it)
+        ax += it->second * x_values[it->first];
+      Real y_value;
+      y->get_value(i, y_value);
+      y->set_value(i, alpha*ax + beta*y_value);
+    }
+  }
+  void debug_data(std::vector<Uint>& row_indices, std::vector<Uint>& col_indices, std::vector<Real>& values)
+  {
+    row_indices.clear(); col_indices.clear(); values.clear();
+    for(Uint i = 0; i != m_rows.size(); ++i)
+    {
+      if(m_ghost_rows.count(i))
+        continue;
+      for(RowT::const_iterator it = m_rows[i].begin(); it != m_rows[i].end(); ++it)
+      {
+        row_indices.push_back(i);
+        col_indices.push_back(it->first);
+        values.push_back(it->second);
+      }
+    }
+  }
+
+private:
+  void not_implemented() { throw common::NotImplemented(FromHere(), "Not needed by the AMG strategy"); }
+  void changed() { if(track_generation) increment_generation(); }
+  typedef std::map<Uint, Real> RowT;
+  std::vector<RowT> m_rows;
+  std::set<Uint> m_ghost_rows;
+};
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct AMGSerialFixture
+{
+  ~AMGSerialFixture()
+  {
+    Component& root = Core::instance().root();
+    const char* names[] = { "Matrix", "RHS", "Solution", "AMG" };
+    for(Uint i = 0; i != 4; ++i)
+    {
+      if(is_not_null(root.get_child(names[i])))
+        root.remove_component(names[i]);
+    }
+  }
+
+  /// 5-point Laplacian on an n x n grid of nodes, with a Dirichlet condition on the boundary
+  void build_poisson(const Uint n, const bool track_generation = true)
+  {
+    Component& root = Core::instance().root();
+    matrix = root.create_component<SerialMatrix>("Matrix");
+    matrix->track_generation = track_generation;
+    rhs = root.create_component<SerialVector>("RHS");
+    solution = root.create_component<SerialVector>("Solution");
+    amg = root.create_component<LSS::AMGStrategy>("AMG");
+
+    const Uint nb_nodes = n*n;
+    matrix->resize(nb_nodes);
+    rhs->resize(nb_nodes);
+    solution->resize(nb_nodes);
+    for(Uint i = 0; i != n; ++i)
+    {
+      for(Uint j = 0; j != n; ++j)
+      {
+        const Uint node = i*n+j;
+        if(i == 0 || j == 0 || i == n-1 || j == n-1)
+        {
+          matrix->set_value(node, node, 1.);
+          continue;
+        }
+        matrix->set_value(node, node, 4.);
+        const Uint neighbours[4] = {node-n, node-1, node+1, node+n};
+        for(Uint k = 0; k != 4; ++k)
+        {
+          const Uint ni = neighbours[k] / n;
+          const Uint nj = neighbours[k] % n;
+          if(ni != 0 && nj != 0 && ni != n-1 && nj != n-1)
+            matrix->set_value(neighbours[k], node, -1.);
+        }
+        rhs->set_value(node, std::sin(0.37*static_cast<Real>(node)));
+      }
+    }
+
+    amg->set_matrix(matrix);
+    amg->set_rhs(rhs);
+    amg->set_solution(solution);
+  }
+
+  void solve()
+  {
+    solution->reset(0.);
+    amg->solve();
+    BOOST_CHECK_LT(amg->properties().value<Real>("residual"), 1e-8);
+  }
+
+  /// Norm of the true residual b - Ax
+  Real true_residual()
+  {
+    boost::shared_ptr<SerialVector> ax = allocate_component<SerialVector>("Ax");
+    ax->resize(rhs->blockrow_size());
+    matrix->apply(Handle<LSS::Vector>(ax), Handle<LSS::Vector const>(solution));
+    Real result = 0.;
+    for(Uint i = 0; i != rhs->blockrow_size(); ++i)
+      result += ((*rhs)[i] - (*ax)[i]) * ((*rhs)[i] - (*ax)[i]);
+    return std::sqrt(result);
+  }
+
+  Uint nb_setups() const
+  {
+    return amg->properties().value<Uint>("nb_setups");
+  }
+
+  Handle<SerialMatrix> matrix;
+  Handle<SerialVector> rhs;
+  Handle<SerialVector> solution;
+  Handle<LSS::AMGStrategy> amg;
+};
+
+BOOST_FIXTURE_TEST_SUITE( AMGSerialSuite, AMGSerialFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// The hierarchy follows the generation of the matrix, without comparing the entries
+BOOST_AUTO_TEST_CASE( SetupFollowsGeneration )
+{
+  build_poisson(40);
+
+  solve();
+  BOOST_CHECK_EQUAL(nb_setups(), 1u);
+
+  // Solving again, or with a different right hand side, keeps the hierarchy
+  const Uint generation = matrix->generation();
+  solve();
+  rhs->set_value(500, 1.);
+  solve();
+  BOOST_CHECK_EQUAL(matrix->generation(), generation);
+  BOOST_CHECK_EQUAL(nb_setups(), 1u);
+
+  // Any modification of the matrix triggers a new setup, and the new matrix is used
+  matrix->set_value(500, 500, 8.);
+  BOOST_CHECK_NE(matrix->generation(), generation);
+  solve();
+  BOOST_CHECK_EQUAL(nb_setups(), 2u);
+  BOOST_CHECK_LT(true_residual(), 1e-6);
+
+  // Without reuse, every solve sets up the hierarchy
+  amg->options().set("reuse_setup", false);
+  solve();
+  BOOST_CHECK_EQUAL(nb_setups(), 3u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// A matrix that does not count its modifications gets a new hierarchy for every solve
+BOOST_AUTO_TEST_CASE( SetupWithoutGeneration )
+{
+  build_poisson(40, false);
+  BOOST_CHECK_EQUAL(matrix->generation(), 0u);
+
+  solve();
+  BOOST_CHECK_EQUAL(nb_setups(), 1u);
+
+  // The changed values are used, even though the generation did not change
+  matrix->set_value(500, 500, 8.);
+  solve();
+  BOOST_CHECK_EQUAL(nb_setups(), 2u);
+  BOOST_CHECK_LT(true_residual(), 1e-6);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Computing the residual before solving shares the work vector with the solve, also when
+/// couplings to other ranks are left out of the hierarchy
+BOOST_AUTO_TEST_CASE( ResidualThenSolve )
+{
+  build_poisson(20);
+  matrix->add_ghost_row(210);
+
+  solution->reset(0.);
+  const Real initial_residual = amg->compute_residual();
+  BOOST_CHECK_GT(initial_residual, 0.);
+  BOOST_CHECK(is_not_null(amg->get_child("YWork")));
+
+  solve();
+  BOOST_CHECK(is_not_null(amg->get_child("XWork")));
+  BOOST_CHECK_LT(amg->compute_residual(), 1e-7*initial_residual);
+  BOOST_CHECK_EQUAL(nb_setups(), 1u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
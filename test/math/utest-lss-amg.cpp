@@ -0,0 +1,247 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the AMG solution strategy"
+
+#include <cmath>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+
+#include "common/PE/Comm.hpp"
+#include "common/PE/CommPattern.hpp"
+#include "common/PE/CommWrapper.hpp"
+
+#include "math/LSS/AMGStrategy.hpp"
+#include "math/LSS/SolveLSS.hpp"
+#include "math/LSS/System.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::common::PE;
+using namespace cf3::math;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct AMGFixture
+{
+  AMGFixture()
+  {
+    m_argc = boost::unit_test::framework::master_test_suite().argc;
+    m_argv = boost::unit_test::framework::master_test_suite().argv;
+  }
+
+  /// Build the 5-point Laplacian on an n x n grid of nodes, with a Dirichlet condition on the boundary
+  Handle<LSS::System> build_poisson(const std::string& name, const Uint n, const std::string& strategy = "cf3.math.LSS.AMGStrategy")
+  {
+    Component& root = Core::instance().root();
+    CommPattern& cp = *root.create_component<CommPattern>("commpattern_" + name);
+    const Uint nb_nodes = n*n;
+    std::vector<Uint> gid(nb_nodes), rnk(nb_nodes, 0);
+    for(Uint i = 0; i != nb_nodes; ++i)
+      gid[i] = i;
+    cp.insert("gid", gid, 1, false);
+    cp.setup(Handle<CommWrapper>(cp.get_child("gid")), rnk);
+
+    std::vector<Uint> conn, startidx(1, 0);
+    for(Uint i = 0; i != n; ++i)
+    {
+      for(Uint j = 0; j != n; ++j)
+      {
+        const Uint node = i*n+j;
+        if(i != 0) conn.push_back(node-n);
+        if(j != 0) conn.push_back(node-1);
+        conn.push_back(node);
+        if(j != n-1) conn.push_back(node+1);
+        if(i != n-1) conn.push_back(node+n);
+        startidx.push_back(conn.size());
+      }
+    }
+
+    Handle<LSS::System> lss = root.create_component<LSS::System>(name);
+    lss->options().set("matrix_builder", std::string("cf3.math.LSS.TrilinosCrsMatrix"));
+    lss->options().set("solution_strategy", strategy);
+    lss->create(cp, 1u, conn, startidx);
+    lss->reset();
+
+    LSS::Matrix& mat = *lss->matrix();
+    LSS::Vector& rhs = *lss->rhs();
+    for(Uint i = 0; i != n; ++i)
+    {
+      for(Uint j = 0; j != n; ++j)
+      {
+        const Uint node = i*n+j;
+        if(i == 0 || j == 0 || i == n-1 || j == n-1)
+        {
+          mat.set_value(node, node, 1.);
+          continue;
+        }
+        mat.set_value(node, node, 4.);
+        const Uint neighbours[4] = {node-n, node-1, node+1, node+n};
+        for(Uint k = 0; k != 4; ++k)
+        {
+          const Uint ni = neighbours[k] / n;
+          const Uint nj = neighbours[k] % n;
+          if(ni != 0 && nj != 0 && ni != n-1 && nj != n-1)
+            mat.set_value(neighbours[k], node, -1.);
+        }
+        rhs.set_value(node, std::sin(0.37*static_cast<Real>(node)));
+      }
+    }
+
+    return lss;
+  }
+
+  /// Solve and return the number of iterations
+  Uint solve(LSS::System& lss)
+  {
+    lss.solution()->reset(0.);
+    lss.solve();
+    const Uint iterations = lss.solution_strategy()->properties().value<Uint>("iterations");
+    CFinfo << lss.name() << ": " << lss.matrix()->blockrow_size() << " rows, "
+           << Handle<LSS::AMGStrategy>(lss.solution_strategy())->nb_levels() << " levels, "
+           << iterations << " iterations, setup time " << lss.solution_strategy()->properties().value<Real>("setup_time")
+           << " s, solve time " << lss.solution_strategy()->properties().value<Real>("solve_time") << " s" << CFendl;
+    return iterations;
+  }
+
+  int m_argc;
+  char** m_argv;
+};
+
+BOOST_FIXTURE_TEST_SUITE( AMGSuite, AMGFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( init_mpi )
+{
+  Comm::instance().init(m_argc, m_argv);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Convergence )
+{
+  Handle<LSS::System> lss = build_poisson("Convergence", 50);
+  solve(*lss);
+  const Real residual = lss->solution_strategy()->properties().value<Real>("residual");
+  BOOST_CHECK_LT(residual, 1e-8);
+
+  // Check the true residual
+  std::vector<Real> rhs;
+  lss->rhs()->debug_data(rhs);
+  Real rhs_norm = 0.;
+  for(Uint i = 0; i != rhs.size(); ++i)
+    rhs_norm += rhs[i]*rhs[i];
+  BOOST_CHECK_LT(lss->solution_strategy()->compute_residual() / std::sqrt(rhs_norm), 1e-7);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( SetupReuse )
+{
+  Handle<LSS::System> lss = build_poisson("SetupReuse", 50);
+  const Uint first_iterations = solve(*lss);
+  solve(*lss);
+  BOOST_CHECK_EQUAL(lss->solution_strategy()->properties().value<Uint>("nb_setups"), 1u);
+  BOOST_CHECK_EQUAL(lss->solution_strategy()->properties().value<Uint>("iterations"), first_iterations);
+
+  // Changing the matrix triggers a new setup
+  lss->matrix()->set_value(60, 60, 5.);
+  solve(*lss);
+  BOOST_CHECK_EQUAL(lss->solution_strategy()->properties().value<Uint>("nb_setups"), 2u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// The number of iterations must not grow with the problem size. The largest grid size can be passed
+/// on the command line, to check the scaling on larger problems
+BOOST_AUTO_TEST_CASE( Scaling )
+{
+  Uint max_size = 400;
+  if(m_argc > 1)
+    max_size = boost::lexical_cast<Uint>(m_argv[1]);
+
+  const Uint small_iterations = solve(*build_poisson("ScalingSmall", 50));
+  BOOST_CHECK_LT(small_iterations, 20u);
+
+  for(Uint n = 100; n <= max_size; n *= 2)
+  {
+    Handle<LSS::System> lss = build_poisson("Scaling" + boost::lexical_cast<std::string>(n), n);
+    const Uint iterations = solve(*lss);
+    BOOST_CHECK_LE(iterations, small_iterations + 5);
+    Core::instance().root().remove_component(*lss);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( JacobiSmoother )
+{
+  Handle<LSS::System> lss = build_poisson("JacobiSmoother", 100);
+  lss->solution_strategy()->options().set("smoother", std::string("Jacobi"));
+  BOOST_CHECK_LT(solve(*lss), 20u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Compare the accuracy and speed of the single precision hierarchy with the double precision one
+BOOST_AUTO_TEST_CASE( SinglePrecision )
+{
+  Handle<LSS::System> lss = build_poisson("SinglePrecision", 400);
+  Handle<LSS::AMGStrategy> amg(lss->solution_strategy());
+
+  const Uint double_iterations = solve(*lss);
+  const Real double_time = amg->properties().value<Real>("solve_time");
+  const std::size_t double_memory = amg->memory_footprint();
+
+  amg->options().set("single_precision_preconditioner", true);
+  const Uint single_iterations = solve(*lss);
+  const Real single_time = amg->properties().value<Real>("solve_time");
+  BOOST_CHECK_EQUAL(amg->properties().value<Uint>("nb_setups"), 2u);
+  BOOST_CHECK_LE(single_iterations, double_iterations + 2);
+  BOOST_CHECK_LT(amg->properties().value<Real>("residual"), 1e-8);
+
+  CFinfo << "Double precision hierarchy: " << double_iterations << " iterations in " << double_time << " s, "
+         << static_cast<Real>(double_memory) / 1048576. << " MB" << CFendl;
+  CFinfo << "Single precision hierarchy: " << single_iterations << " iterations in " << single_time << " s, "
+         << static_cast<Real>(amg->memory_footprint()) / 1048576. << " MB" << CFendl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( SelectFromSolveLSS )
+{
+  Handle<LSS::System> lss = build_poisson("SelectFromSolveLSS", 50, "cf3.math.LSS.TrilinosStratimikosStrategy");
+
+  Handle<LSS::SolveLSS> solve_action = Core::instance().root().create_component<LSS::SolveLSS>("SolveAction");
+  solve_action->options().set("lss", lss);
+  solve_action->options().set("solution_strategy", std::string("cf3.math.LSS.AMGStrategy"));
+  solve_action->execute();
+
+  BOOST_CHECK_EQUAL(lss->solution_strategy()->derived_type_name(), std::string("cf3.math.LSS.AMGStrategy"));
+  BOOST_CHECK_LT(lss->solution_strategy()->properties().value<Real>("residual"), 1e-8);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( finalize_mpi )
+{
+  Comm::instance().finalize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -275,6 +275,33 @@ BOOST_AUTO_TEST_CASE( test_matrix_only )
 
 
 
+  // performant access with a fixed-size blockaccumulator
+  mat->reset();
+  if (irank==1)
+  {
+    LSS::BlockAccumulatorT<3,2> fixed_ba;
+    fixed_ba.mat << 53., 54., 51., 52., 55., 56.,
+                    59., 60., 57., 58., 61., 62.,
+                    23., 24., 21., 22., 25., 26.,
+                    29., 30., 27., 28., 31., 32.,
+                    83., 84., 81., 82., 85., 86.,
+                    89., 90., 87., 88., 91., 92.;
+    fixed_ba.indices[0]=5;
+    fixed_ba.indices[1]=2;
+    fixed_ba.indices[2]=8;
+    mat->set_values(fixed_ba);
+    mat->add_values(fixed_ba);
+    LSS::BlockAccumulator ba;
+    ba.resize(3,neq);
+    ba.indices[0]=2;
+    ba.indices[1]=5;
+    ba.indices[2]=8;
+    mat->get_values(ba);
+    for (int i=1; i<7; i++) BOOST_CHECK_EQUAL(ba.mat(0,i-1),(double)((ba.indices[0]*10+i+0)*2));
+    for (int i=1; i<7; i++) BOOST_CHECK_EQUAL(ba.mat(3,i-1),(double)((ba.indices[1]*10+i+6)*2));
+    for (int i=1; i<7; i++) BOOST_CHECK_EQUAL(ba.mat(5,i-1),(double)((ba.indices[2]*10+i+6)*2));
+  }
+
   // performant access - out of range access does not fail
   mat->reset();
   if (irank==1)
@@ -474,6 +501,66 @@ BOOST_AUTO_TEST_CASE( test_matrix_only )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( test_default_builder_block_values )
+{
+  // the matrix_builder option is left at its default, which is what the solvers use
+  boost::shared_ptr<common::PE::CommPattern> cp_ptr = common::allocate_component<common::PE::CommPattern>("commpattern");
+  common::PE::CommPattern& cp = *cp_ptr;
+  build_commpattern(cp);
+  boost::shared_ptr<LSS::System> sys(common::allocate_component<LSS::System>("sys"));
+  BOOST_CHECK_EQUAL(sys->options().value<std::string>("matrix_builder"), "cf3.math.LSS.TrilinosFEVbrMatrix");
+  build_system(*sys,cp);
+  Handle<LSS::Matrix> mat=sys->matrix();
+  BOOST_CHECK_EQUAL(mat->derived_type_name(), "cf3.math.LSS.TrilinosFEVbrMatrix");
+
+  if (irank==1)
+  {
+    // non-symmetric values, so transposed blocks are detected
+    LSS::BlockAccumulatorT<3,2> fixed_ba;
+    for (int i=0; i<6; i++)
+      for (int j=0; j<6; j++)
+        fixed_ba.mat(i,j)=10.*i+j+1.;
+    fixed_ba.indices[0]=8;
+    fixed_ba.indices[1]=2;
+    fixed_ba.indices[2]=5;
+
+    LSS::BlockAccumulator ba;
+    ba.resize(3,neq);
+    ba.indices[0]=8;
+    ba.indices[1]=2;
+    ba.indices[2]=5;
+
+    // assembly through add_block_values
+    mat->reset();
+    mat->add_values(fixed_ba);
+    mat->add_values(fixed_ba);
+    mat->get_values(ba);
+    for (int i=0; i<6; i++)
+      for (int j=0; j<6; j++)
+        BOOST_CHECK_EQUAL(ba.mat(i,j),2.*fixed_ba.mat(i,j));
+
+    // same result as the dynamic accumulator
+    mat->reset();
+    ba.mat=fixed_ba.mat;
+    mat->add_values(ba);
+    mat->add_values(fixed_ba);
+    ba.mat.setZero();
+    mat->get_values(ba);
+    for (int i=0; i<6; i++)
+      for (int j=0; j<6; j++)
+        BOOST_CHECK_EQUAL(ba.mat(i,j),2.*fixed_ba.mat(i,j));
+
+    // set_block_values overwrites
+    mat->set_values(fixed_ba);
+    mat->get_values(ba);
+    for (int i=0; i<6; i++)
+      for (int j=0; j<6; j++)
+        BOOST_CHECK_EQUAL(ba.mat(i,j),fixed_ba.mat(i,j));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( test_vector_only )
 {
   // build a commpattern and the two vectors
@@ -594,6 +681,28 @@ BOOST_AUTO_TEST_CASE( test_vector_only )
   BOOST_CHECK_EQUAL(ba.sol[5],140.);
   BOOST_CHECK_EQUAL(ba.rhs.isConstant(0.,1.e-10),true);
 
+  // fixed-size blockaccumulator must give the same result
+  sol->reset();
+  LSS::BlockAccumulatorT<3,2> fixed_ba;
+  fixed_ba.reset();
+  fixed_ba.rhs << 8.,9.   ,  2.,3.   ,  6.,7.;
+  fixed_ba.neighbour_indices(ba.indices);
+  sol->set_rhs_values(fixed_ba);
+  sol->add_rhs_values(fixed_ba);
+  fixed_ba.reset();
+  sol->get_sol_values(fixed_ba);
+  for (int i=0; i<6; i++) BOOST_CHECK_EQUAL(fixed_ba.sol[i],(double)(fixed_ba.indices[i/2]*neq+i%2)*2.);
+  sol->debug_data(vals);
+  for (int i=0; i<vals.size(); i++)
+  {
+    if ((i/neq==ba.indices[0])||(i/neq==ba.indices[1])||(i/neq==ba.indices[2]))
+    {
+      BOOST_CHECK_EQUAL(vals[i],(double)(i*2));
+    } else {
+      BOOST_CHECK_EQUAL(vals[i],0.);
+    }
+  }
+
   // check destroy
   sol->destroy();
   BOOST_CHECK_EQUAL(sol->is_created(),false);
@@ -0,0 +1,97 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the initial guess of the Trilinos solution strategy"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "math/LSS/SolutionStrategy.hpp"
+#include "math/LSS/System.hpp"
+#include "math/LSS/Vector.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::common::PE;
+using namespace cf3::math;
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+const Uint nb_steps = 5;
+
+/// Solve a sequence of systems with right hand side (1+0.1n) b, using the given initial guess.
+/// Returns the iteration count of the last solve
+int solve_sequence(const std::string& initial_guess)
+{
+  Component& root = Core::instance().root();
+  Handle<LSS::System> lss = root.create_component<LSS::System>("LSS" + initial_guess);
+  lss->options().set("matrix_builder", std::string("cf3.math.LSS.TrilinosCrsMatrix"));
+  lss->read_native(URI(boost::unit_test::framework::master_test_suite().argv[1]));
+
+  Handle<LSS::SolutionStrategy> strategy = lss->solution_strategy();
+  strategy->options().set("initial_guess", initial_guess);
+  strategy->options().set("print_settings", false);
+
+  for(Uint n = 0; n != nb_steps; ++n)
+  {
+    if(n != 0)
+      lss->rhs()->scale((1. + 0.1*n) / (1. + 0.1*(n-1)));
+    lss->solve();
+    CFinfo << initial_guess << " guess, step " << n << ": " << strategy->properties().value<int>("iterations") << " iterations, "
+           << strategy->properties().value<Real>("iterations_saved") << " saved" << CFendl;
+  }
+
+  return strategy->properties().value<int>("iterations");
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( LSSInitialGuessSuite )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  Comm::instance().init(boost::unit_test::framework::master_test_suite().argc, boost::unit_test::framework::master_test_suite().argv);
+}
+
+BOOST_AUTO_TEST_CASE( ExtrapolationSavesIterations )
+{
+  const int zero_iterations = solve_sequence("Zero");
+  const int extrapolated_iterations = solve_sequence("Extrapolation");
+  BOOST_CHECK_LE(extrapolated_iterations, zero_iterations);
+
+  Handle<LSS::SolutionStrategy> strategy = Core::instance().root().access_component_checked("LSSExtrapolation/SolutionStrategy")->handle<LSS::SolutionStrategy>();
+  BOOST_CHECK_GT(strategy->properties().value<Real>("iterations_saved"), 0.);
+}
+
+BOOST_AUTO_TEST_CASE( ProjectionSavesIterations )
+{
+  const int zero_iterations = Core::instance().root().access_component_checked("LSSZero/SolutionStrategy")->properties().value<int>("iterations");
+  const int projected_iterations = solve_sequence("POD");
+  BOOST_CHECK_LE(projected_iterations, zero_iterations);
+}
+
+BOOST_AUTO_TEST_CASE( Finalize )
+{
+  Comm::instance().finalize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -209,6 +209,87 @@ BOOST_AUTO_TEST_CASE( test_complete_system )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( test_batched_system )
+{
+  boost::shared_ptr<common::PE::CommPattern> cp_ptr = common::allocate_component<common::PE::CommPattern>("commpattern");
+  common::PE::CommPattern& cp = *cp_ptr;
+  build_commpattern(cp);
+  boost::shared_ptr<LSS::System> sys(common::allocate_component<LSS::System>("sys"));
+  sys->options().option("matrix_builder").change_value(matrix_builder);
+  build_system(*sys,cp);
+
+  // Apply the same set of rows twice, the second time reusing the entries found the first time
+  const Real values[] = {10., 5.};
+  for(Uint step = 0; step != 2; ++step)
+  {
+    const Real value = values[step];
+    sys->reset();
+    sys->matrix()->set_row(0, 0, 2, 1);
+    sys->matrix()->set_row(1, 0, 2, 1);
+    sys->matrix()->set_row(2, 0, 2, 1);
+
+    {
+      // The batch is applied when it goes out of scope. Rows constrained twice keep the last value
+      LSS::DirichletBatch batch(*sys);
+      sys->dirichlet(irank == 0 ? 1 : 0, 0, 0., true);
+      sys->dirichlet(irank == 0 ? 1 : 0, 0, value, true);
+    }
+
+    Real val;
+    if(irank == 0)
+    {
+      sys->matrix()->get_value(0, 0, val);
+      BOOST_CHECK_EQUAL(val, 2.);
+      sys->matrix()->get_value(1, 0, val);
+      BOOST_CHECK_EQUAL(val, 0.);
+      sys->matrix()->get_value(0, 1, val);
+      BOOST_CHECK_EQUAL(val, 0.);
+      sys->matrix()->get_value(1, 1, val);
+      BOOST_CHECK_EQUAL(val, 1.);
+      sys->matrix()->get_value(2, 1, val);
+      BOOST_CHECK_EQUAL(val, 0.);
+
+      sys->rhs()->get_value(0, val);
+      BOOST_CHECK_EQUAL(val, -value);
+      sys->rhs()->get_value(1, val);
+      BOOST_CHECK_EQUAL(val, value);
+    }
+    else
+    {
+      sys->matrix()->get_value(0, 1, val);
+      BOOST_CHECK_EQUAL(val, 0.);
+      sys->matrix()->get_value(1, 1, val);
+      BOOST_CHECK_EQUAL(val, 2.);
+      sys->matrix()->get_value(2, 1, val);
+      BOOST_CHECK_EQUAL(val, 1.);
+
+      sys->rhs()->get_value(0, val);
+      BOOST_CHECK_EQUAL(val, value);
+      sys->rhs()->get_value(1, val);
+      BOOST_CHECK_EQUAL(val, -value);
+      sys->rhs()->get_value(2, val);
+      BOOST_CHECK_EQUAL(val, 0.);
+    }
+  }
+
+  // Applying the same rows to an unchanged matrix only modifies the RHS, so the matrix generation stays the same
+  const Uint generation = sys->matrix()->generation();
+  sys->rhs()->reset();
+  {
+    LSS::DirichletBatch batch(*sys);
+    sys->dirichlet(irank == 0 ? 1 : 0, 0, 5., true);
+  }
+  BOOST_CHECK_EQUAL(sys->matrix()->generation(), generation);
+
+  Real val;
+  sys->rhs()->get_value(irank == 0 ? 1 : 0, val);
+  BOOST_CHECK_EQUAL(val, 5.);
+  sys->rhs()->get_value(irank == 0 ? 0 : 1, val);
+  BOOST_CHECK_EQUAL(val, -5.);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( finalize_mpi )
 {
   CFinfo.setFilterRankZero(true);
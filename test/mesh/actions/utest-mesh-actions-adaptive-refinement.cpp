@@ -0,0 +1,419 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Tests mesh::actions::AdaptiveRefinement"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/FindComponents.hpp"
+#include "common/Foreach.hpp"
+#include "common/List.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+#include "common/Table.hpp"
+
+#include "common/PE/Comm.hpp"
+
+#include "mesh/actions/AdaptiveRefinement.hpp"
+#include "mesh/BlockMesh/BlockData.hpp"
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/ElementType.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/FaceCellConnectivity.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshTriangulator.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/Space.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::mesh::actions;
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+
+/// Coefficients of the linear function used to check the field transfer
+const Real linear_coeffs[3] = { 2., 3., -1. };
+
+Real linear_function(const Real* x, const Uint dim)
+{
+  Real result = 1.;
+  for(Uint d = 0; d != dim; ++d)
+    result += linear_coeffs[d]*x[d];
+  return result;
+}
+
+Real global_sum(const Real local)
+{
+  Real result = local;
+  if(PE::Comm::instance().is_active())
+    PE::Comm::instance().all_reduce(PE::plus(), &local, 1, &result);
+  return result;
+}
+
+Uint global_sum(const Uint local)
+{
+  Uint result = local;
+  if(PE::Comm::instance().is_active())
+    PE::Comm::instance().all_reduce(PE::plus(), &local, 1, &result);
+  return result;
+}
+
+/// Total volume of the owned cells, or total area of the owned faces
+Real owned_measure(Region& region, const bool cells)
+{
+  Real result = 0.;
+  boost_foreach(Elements& elements, find_components_recursively<Elements>(region))
+  {
+    const ElementType& etype = elements.element_type();
+    if((etype.dimensionality() == etype.dimension()) != cells)
+      continue;
+    for(Uint e = 0; e != elements.size(); ++e)
+    {
+      if(elements.is_ghost(e))
+        continue;
+      const RealMatrix nodes = elements.geometry_space().get_coordinates(e);
+      result += cells ? etype.volume(nodes) : etype.area(nodes);
+    }
+  }
+  return global_sum(result);
+}
+
+Uint owned_cells(const Mesh& mesh)
+{
+  Uint result = 0;
+  boost_foreach(const Handle<Entities>& entities, mesh.elements())
+  {
+    if(entities->element_type().dimensionality() != mesh.dimension())
+      continue;
+    for(Uint e = 0; e != entities->size(); ++e)
+      if(!entities->is_ghost(e))
+        ++result;
+  }
+  return global_sum(result);
+}
+
+/// Measure of the boundary faces found by a face to cell connectivity. For a conforming mesh, this is the boundary of the domain.
+Real boundary_measure(const FaceCellConnectivity& face_cell, const Field& coordinates)
+{
+  Real result = 0.;
+  for(Uint f = 0; f != face_cell.size(); ++f)
+  {
+    if(!face_cell.is_bdry_face()[f])
+      continue;
+    const std::vector<Uint> nodes = face_cell.face_nodes(f);
+    if(coordinates.row_size() == 2)
+    {
+      result += std::sqrt(std::pow(coordinates[nodes[1]][0] - coordinates[nodes[0]][0], 2) + std::pow(coordinates[nodes[1]][1] - coordinates[nodes[0]][1], 2));
+      continue;
+    }
+    // Fan of triangles over the face
+    for(Uint i = 1; i+1 < nodes.size(); ++i)
+    {
+      RealVector3 a, b;
+      for(Uint d = 0; d != 3; ++d)
+      {
+        a[d] = coordinates[nodes[i]][d] - coordinates[nodes[0]][d];
+        b[d] = coordinates[nodes[i+1]][d] - coordinates[nodes[0]][d];
+      }
+      result += 0.5*a.cross(b).norm();
+    }
+  }
+  return result;
+}
+
+/// Create the fields that are transferred: a linear function and the indicator on the nodes,
+/// and the linear function on the nodes of a discontinuous P1 space
+void create_fields(Mesh& mesh, const Real refine_below)
+{
+  Dictionary& geometry = mesh.geometry_fields();
+  const Field& coordinates = geometry.coordinates();
+  const Uint dim = coordinates.row_size();
+  Field& linear = geometry.create_field("linear");
+  Field& indicator = geometry.create_field("indicator");
+  for(Uint i = 0; i != geometry.size(); ++i)
+  {
+    linear[i][0] = linear_function(&coordinates[i][0], dim);
+    indicator[i][0] = coordinates[i][0] < refine_below ? 1. : 0.;
+  }
+
+  Dictionary& elems_P1 = mesh.create_discontinuous_space("elems_P1", "cf3.mesh.LagrangeP1");
+  Field& element_linear = elems_P1.create_field("element_linear");
+  boost_foreach(const Handle<Space>& space, elems_P1.spaces())
+  {
+    for(Uint e = 0; e != space->size(); ++e)
+    {
+      const RealMatrix nodes = space->compute_coordinates(e);
+      const Connectivity::ConstRow rows = space->connectivity()[e];
+      for(Uint n = 0; n != rows.size(); ++n)
+      {
+        const RealVector x = nodes.row(n).transpose();
+        element_linear[rows[n]][0] = linear_function(x.data(), dim);
+      }
+    }
+  }
+}
+
+/// Check that the fields created by create_fields still hold the linear function
+void check_fields(Mesh& mesh)
+{
+  const Dictionary& geometry = mesh.geometry_fields();
+  const Field& coordinates = geometry.coordinates();
+  const Uint dim = coordinates.row_size();
+  const Field& linear = *Handle<Field const>(geometry.get_child("linear"));
+  for(Uint i = 0; i != geometry.size(); ++i)
+    BOOST_CHECK_SMALL(linear[i][0] - linear_function(&coordinates[i][0], dim), 1e-10);
+
+  const Dictionary& elems_P1 = *Handle<Dictionary const>(mesh.get_child("elems_P1"));
+  const Field& element_linear = *Handle<Field const>(elems_P1.get_child("element_linear"));
+  BOOST_CHECK_EQUAL(elems_P1.spaces().size(), mesh.elements().size());
+  boost_foreach(const Handle<Space>& space, elems_P1.spaces())
+  {
+    for(Uint e = 0; e != space->size(); ++e)
+    {
+      const RealMatrix nodes = space->compute_coordinates(e);
+      const Connectivity::ConstRow rows = space->connectivity()[e];
+      for(Uint n = 0; n != rows.size(); ++n)
+      {
+        const RealVector x = nodes.row(n).transpose();
+        BOOST_CHECK_SMALL(element_linear[rows[n]][0] - linear_function(x.data(), dim), 1e-10);
+      }
+    }
+  }
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct AdaptiveRefinementFixture
+{
+  AdaptiveRefinementFixture() : root(Core::instance().root())
+  {
+    m_argc = boost::unit_test::framework::master_test_suite().argc;
+    m_argv = boost::unit_test::framework::master_test_suite().argv;
+  }
+
+  /// Channel of 4 x 1, with 16 x 4 quads
+  Mesh& channel_2d(const std::string& name)
+  {
+    BlockMesh::BlockArrays& blocks = *root.create_component<BlockMesh::BlockArrays>(name + "_blocks");
+    *blocks.create_points(2, 4) << 0. << 0.
+                                << 4. << 0.
+                                << 0. << 1.
+                                << 4. << 1.;
+    *blocks.create_blocks(1) << 0 << 1 << 3 << 2;
+    *blocks.create_block_subdivisions() << 16 << 4;
+    *blocks.create_block_gradings() << 1. << 1. << 1. << 1.;
+    *blocks.create_patch("left", 1) << 2 << 0;
+    *blocks.create_patch("right", 1) << 1 << 3;
+    *blocks.create_patch("top", 1) << 3 << 2;
+    *blocks.create_patch("bottom", 1) << 0 << 1;
+    blocks.partition_blocks(PE::Comm::instance().size(), XX);
+
+    Mesh& mesh = *root.create_component<Mesh>(name);
+    blocks.create_mesh(mesh);
+    return mesh;
+  }
+
+  /// Unit cube with 4 x 4 x 4 hexahedra
+  Mesh& box_3d(const std::string& name)
+  {
+    BlockMesh::BlockArrays& blocks = *root.create_component<BlockMesh::BlockArrays>(name + "_blocks");
+    *blocks.create_points(3, 8) << 0. << 0. << 0.
+                                << 1. << 0. << 0.
+                                << 0. << 1. << 0.
+                                << 1. << 1. << 0.
+                                << 0. << 0. << 1.
+                                << 1. << 0. << 1.
+                                << 0. << 1. << 1.
+                                << 1. << 1. << 1.;
+    *blocks.create_blocks(1) << 0 << 1 << 3 << 2 << 4 << 5 << 7 << 6;
+    *blocks.create_block_subdivisions() << 4 << 4 << 4;
+    *blocks.create_block_gradings() << 1. << 1. << 1. << 1. << 1. << 1. << 1. << 1. << 1. << 1. << 1. << 1.;
+    *blocks.create_patch("bottom", 1) << 0 << 2 << 3 << 1;
+    *blocks.create_patch("top", 1) << 4 << 5 << 7 << 6;
+    *blocks.create_patch("right", 1) << 1 << 3 << 7 << 5;
+    *blocks.create_patch("front", 1) << 0 << 1 << 5 << 4;
+    *blocks.create_patch("left", 1) << 0 << 4 << 6 << 2;
+    *blocks.create_patch("back", 1) << 2 << 6 << 7 << 3;
+    blocks.partition_blocks(PE::Comm::instance().size(), XX);
+
+    Mesh& mesh = *root.create_component<Mesh>(name);
+    blocks.create_mesh(mesh);
+    return mesh;
+  }
+
+  /// Unit cube with n x n x n cubes, each split in 6 tetrahedra around its diagonal
+  Mesh& tetra_box(const std::string& name, const Uint n)
+  {
+    Mesh& mesh = *root.create_component<Mesh>(name);
+    const Uint nb_nodes_1d = n+1;
+    mesh.initialize_nodes(nb_nodes_1d*nb_nodes_1d*nb_nodes_1d, 3);
+    Field& coordinates = mesh.geometry_fields().coordinates();
+    for(Uint k = 0; k != nb_nodes_1d; ++k)
+      for(Uint j = 0; j != nb_nodes_1d; ++j)
+        for(Uint i = 0; i != nb_nodes_1d; ++i)
+        {
+          const Uint node = (k*nb_nodes_1d + j)*nb_nodes_1d + i;
+          coordinates[node][XX] = static_cast<Real>(i) / n;
+          coordinates[node][YY] = static_cast<Real>(j) / n;
+          coordinates[node][ZZ] = static_cast<Real>(k) / n;
+        }
+
+    Elements& tetras = mesh.topology().create_region("box").create_elements("cf3.mesh.LagrangeP1.Tetra3D", mesh.geometry_fields());
+    tetras.resize(6*n*n*n);
+    Connectivity& connectivity = tetras.geometry_space().connectivity();
+    const Uint permutations[6][3] = { {0,1,2}, {0,2,1}, {1,0,2}, {1,2,0}, {2,0,1}, {2,1,0} };
+    Uint e = 0;
+    for(Uint k = 0; k != n; ++k)
+      for(Uint j = 0; j != n; ++j)
+        for(Uint i = 0; i != n; ++i)
+          for(Uint p = 0; p != 6; ++p, ++e)
+          {
+            // Walk from the lowest to the highest corner of the cube, one direction at a time
+            Uint corner[3] = {i, j, k};
+            connectivity[e][0] = (corner[2]*nb_nodes_1d + corner[1])*nb_nodes_1d + corner[0];
+            for(Uint step = 0; step != 3; ++step)
+            {
+              ++corner[permutations[p][step]];
+              connectivity[e][step+1] = (corner[2]*nb_nodes_1d + corner[1])*nb_nodes_1d + corner[0];
+            }
+            if(tetras.element_type().volume(tetras.geometry_space().get_coordinates(e)) < 0.)
+              std::swap(connectivity[e][0], connectivity[e][1]);
+            tetras.rank()[e] = PE::Comm::instance().rank();
+            tetras.glb_idx()[e] = e;
+          }
+
+    mesh.raise_mesh_loaded();
+    return mesh;
+  }
+
+  /// Refine where the indicator field is set, and check the conservation of volume and boundary.
+  /// The boundary area is also checked on the boundary patches, if the mesh has any
+  void refine(Mesh& mesh, const Real volume, const Real boundary, const bool has_patches)
+  {
+    const Uint nb_cells_before = owned_cells(mesh);
+
+    Handle<FaceCellConnectivity> face_cell;
+    if(PE::Comm::instance().size() == 1)
+    {
+      face_cell = mesh.create_component<FaceCellConnectivity>("face_cell");
+      face_cell->setup(mesh.topology());
+      BOOST_CHECK_CLOSE(boundary_measure(*face_cell, mesh.geometry_fields().coordinates()), boundary, 1e-8);
+    }
+
+    AdaptiveRefinement& refinement = *root.create_component<AdaptiveRefinement>("refinement_" + mesh.name());
+    refinement.options().set("indicator", Handle<Field const>(mesh.geometry_fields().get_child("indicator")));
+    refinement.transform(mesh);
+
+    BOOST_CHECK(refinement.properties().value<Uint>("nb_flagged") > 0);
+    BOOST_CHECK(refinement.properties().value<Uint>("nb_refined") > refinement.properties().value<Uint>("nb_flagged"));
+    BOOST_CHECK(owned_cells(mesh) > nb_cells_before);
+
+    BOOST_CHECK_CLOSE(owned_measure(mesh.topology(), true), volume, 1e-8);
+    if(has_patches)
+      BOOST_CHECK_CLOSE(owned_measure(mesh.topology(), false), boundary, 1e-8);
+
+    // Hanging nodes would show up as extra boundary faces
+    if(is_not_null(face_cell))
+      BOOST_CHECK_CLOSE(boundary_measure(*face_cell, mesh.geometry_fields().coordinates()), boundary, 1e-8);
+
+    check_fields(mesh);
+  }
+
+  Component& root;
+  int m_argc;
+  char** m_argv;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( AdaptiveRefinementSuite, AdaptiveRefinementFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Init )
+{
+  Core::instance().initiate(m_argc, m_argv);
+  PE::Comm::instance().init(m_argc, m_argv);
+  Core::instance().environment().options().set("log_level", 1u);
+}
+
+BOOST_AUTO_TEST_CASE( Quads )
+{
+  Mesh& mesh = channel_2d("quads");
+  create_fields(mesh, 0.9);
+  refine(mesh, 4., 10., true);
+
+  // The transition to the unrefined quads uses triangles
+  Uint nb_triangles = 0;
+  boost_foreach(const Elements& elements, find_components_recursively_with_filter<Elements>(mesh.topology(), IsElementsVolume()))
+    if(elements.element_type().shape() == GeoShape::TRIAG)
+      nb_triangles += elements.size();
+  BOOST_CHECK(global_sum(nb_triangles) > 0);
+
+  // Refine a second time, around the transition
+  Field& indicator = *Handle<Field>(mesh.geometry_fields().get_child("indicator"));
+  const Field& coordinates = mesh.geometry_fields().coordinates();
+  for(Uint i = 0; i != indicator.size(); ++i)
+    indicator[i][0] = std::abs(coordinates[i][XX] - 1.) < 0.3 ? 1. : 0.;
+  AdaptiveRefinement& refinement = *Handle<AdaptiveRefinement>(root.get_child("refinement_quads"));
+  refinement.transform(mesh);
+  BOOST_CHECK_CLOSE(owned_measure(mesh.topology(), true), 4., 1e-8);
+  BOOST_CHECK_CLOSE(owned_measure(mesh.topology(), false), 10., 1e-8);
+  check_fields(mesh);
+}
+
+BOOST_AUTO_TEST_CASE( Triangles )
+{
+  // The triangulator marks all elements as owned, so it only works in serial
+  if(PE::Comm::instance().size() != 1)
+    return;
+
+  Mesh& mesh = channel_2d("triangles");
+  MeshTriangulator& triangulator = *root.create_component<MeshTriangulator>("triangulator");
+  triangulator.transform(mesh);
+  create_fields(mesh, 0.9);
+  refine(mesh, 4., 10., true);
+}
+
+BOOST_AUTO_TEST_CASE( Hexahedra )
+{
+  Mesh& mesh = box_3d("hexas");
+  create_fields(mesh, 0.2);
+  refine(mesh, 1., 6., true);
+}
+
+BOOST_AUTO_TEST_CASE( Tetrahedra )
+{
+  if(PE::Comm::instance().size() != 1)
+    return;
+
+  Mesh& mesh = tetra_box("tetras", 3);
+  create_fields(mesh, 0.3);
+  refine(mesh, 1., 6., false);
+}
+
+BOOST_AUTO_TEST_CASE( Terminate )
+{
+  PE::Comm::instance().finalize();
+  Core::instance().terminate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -16,9 +16,18 @@
 
 #include "mesh/Quadrature.hpp"
 #include "mesh/gausslegendre/Line.hpp"
+#include "mesh/gausslegendre/Quad.hpp"
+#include "mesh/gausslegendre/Hexa.hpp"
+#include "mesh/gausslegendre/TensorProduct.hpp"
 #include "mesh/LagrangeP1/Line1D.hpp"
 #include "mesh/LagrangeP2/Line1D.hpp"
 #include "mesh/LagrangeP1/Line2D.hpp"
+#include "mesh/LagrangeP1/Line.hpp"
+#include "mesh/LagrangeP1/Hexa.hpp"
+#include "mesh/LagrangeP2/Line.hpp"
+#include "mesh/LagrangeP2/Quad.hpp"
+#include "mesh/LagrangeP3/Line.hpp"
+#include "mesh/LagrangeP3/Quad.hpp"
 #include "mesh/ElementType.hpp"
 #include "mesh/ShapeFunction.hpp"
 
@@ -54,6 +63,53 @@ struct Fixture
   	return c1 * sum;
   }
  
+  /// Compare the sum factorisation results with the dense shape function matrices, for an element with the given nodes
+  template <typename SF, typename LineSF, Uint Q, typename QDR>
+  void check_tensor_product(const typename gausslegendre::TensorProduct<SF, LineSF, Q>::NodesT& nodes)
+  {
+    typedef gausslegendre::TensorProduct<SF, LineSF, Q> TensorProductT;
+    const TensorProductT& tp = TensorProductT::instance();
+
+    typename TensorProductT::NodalValuesT x;
+    for(Uint i = 0; i != SF::nb_nodes; ++i)
+      x[i] = std::sin(1.7*static_cast<Real>(i) + 0.3);
+
+    typename TensorProductT::PointValuesT values;
+    typename TensorProductT::PointGradientsT gradients;
+    tp.interpolate(x, values);
+    tp.gradient(x, gradients);
+
+    typename TensorProductT::Geometry geometry;
+    tp.compute_geometry(nodes, geometry);
+
+    // Dense element matrices
+    RealMatrix mass = RealMatrix::Zero(SF::nb_nodes, SF::nb_nodes);
+    RealMatrix laplacian = RealMatrix::Zero(SF::nb_nodes, SF::nb_nodes);
+    for(Uint q = 0; q != QDR::nb_nodes; ++q)
+    {
+      const typename SF::MappedCoordsT mapped_coord = QDR::local_coordinates().row(q).transpose();
+      const typename SF::ValueT sf = SF::value(mapped_coord);
+      const typename SF::GradientT mapped_grad = SF::gradient(mapped_coord);
+      BOOST_CHECK_CLOSE(tp.weights()[q], QDR::weights()[q], 1e-10);
+      BOOST_CHECK_SMALL(values[q] - sf*x, 1e-12);
+      BOOST_CHECK_SMALL((gradients.col(q) - mapped_grad*x).norm(), 1e-12);
+
+      const RealMatrix jacobian = mapped_grad * nodes;
+      const RealMatrix grad = jacobian.inverse() * mapped_grad;
+      const Real w = QDR::weights()[q] * jacobian.determinant();
+      mass += w * sf.transpose() * sf;
+      laplacian += w * grad.transpose() * grad;
+    }
+
+    typename TensorProductT::NodalValuesT y = TensorProductT::NodalValuesT::Zero();
+    tp.apply_mass(geometry, x, y);
+    BOOST_CHECK_SMALL((y - mass*x).norm(), 1e-12);
+
+    y.setZero();
+    tp.apply_laplacian(geometry, x, y);
+    BOOST_CHECK_SMALL((y - laplacian*x).norm(), 1e-12);
+  }
+
   /// common values accessed by all tests goes here
   int    m_argc;
   char** m_argv;
@@ -186,6 +242,52 @@ BOOST_AUTO_TEST_CASE( LagrangeP2_Line_integral_dynamic )
   BOOST_CHECK_CLOSE(integral, std::pow(b,3.)/3.,1e-10);  // integral(x^2) = x^3/3
 }
 
+BOOST_AUTO_TEST_CASE( TensorProduct_LagrangeP2_Quad )
+{
+  gausslegendre::TensorProduct<LagrangeP2::Quad, LagrangeP2::Line, 3>::NodesT nodes;
+  nodes <<
+    0.0, 0.0,
+    2.0, 0.2,
+    2.2, 1.8,
+    -0.1, 1.5,
+    1.0, 0.1,
+    2.1, 1.0,
+    1.0, 1.7,
+    0.0, 0.8,
+    1.0, 0.9;
+  check_tensor_product< LagrangeP2::Quad, LagrangeP2::Line, 3, gausslegendre::Quad<3> >(nodes);
+}
+
+BOOST_AUTO_TEST_CASE( TensorProduct_LagrangeP3_Quad )
+{
+  typedef gausslegendre::TensorProduct<LagrangeP3::Quad, LagrangeP3::Line, 4> TensorProductT;
+  // Map the reference element to a curved element
+  TensorProductT::NodesT nodes;
+  for(Uint i = 0; i != LagrangeP3::Quad::nb_nodes; ++i)
+  {
+    const Real ksi = LagrangeP3::Quad::local_coordinates()(i, KSI);
+    const Real eta = LagrangeP3::Quad::local_coordinates()(i, ETA);
+    nodes(i, XX) = 2.*ksi + 0.1*eta*eta;
+    nodes(i, YY) = eta + 0.2*ksi*eta + 0.05*ksi*ksi*ksi;
+  }
+  check_tensor_product< LagrangeP3::Quad, LagrangeP3::Line, 4, gausslegendre::Quad<4> >(nodes);
+}
+
+BOOST_AUTO_TEST_CASE( TensorProduct_LagrangeP1_Hexa )
+{
+  gausslegendre::TensorProduct<LagrangeP1::Hexa, LagrangeP1::Line, 2>::NodesT nodes;
+  nodes <<
+    0.0, 0.0, 0.0,
+    1.0, 0.1, 0.0,
+    1.1, 1.0, 0.1,
+    0.0, 0.9, 0.0,
+    0.1, 0.0, 1.0,
+    1.0, 0.0, 1.2,
+    1.0, 1.1, 1.0,
+    0.0, 1.0, 0.9;
+  check_tensor_product< LagrangeP1::Hexa, LagrangeP1::Line, 2, gausslegendre::Hexa<2> >(nodes);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 BOOST_AUTO_TEST_SUITE_END()
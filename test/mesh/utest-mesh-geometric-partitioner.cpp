@@ -0,0 +1,277 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for the geometric mesh partitioner"
+
+#include <algorithm>
+#include <limits>
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/PropertyList.hpp"
+#include "common/Core.hpp"
+#include "common/Foreach.hpp"
+
+#include "common/PE/Comm.hpp"
+#include "common/PE/operations.hpp"
+
+#include "mesh/GeometricPartitioner.hpp"
+
+#include "test/mesh/utest-mesh-partitioning-cost.hpp"
+
+using namespace boost;
+using namespace cf3;
+using namespace cf3::mesh;
+using namespace cf3::common;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct GeometricPartitionerTests_Fixture
+{
+  GeometricPartitionerTests_Fixture()
+  {
+    m_argc = boost::unit_test::framework::master_test_suite().argc;
+    m_argv = boost::unit_test::framework::master_test_suite().argv;
+  }
+
+  /// Partition the mesh with the given method and return the imbalance of the given cost
+  template<typename CostT>
+  Real partition(Mesh& mesh, const std::string& method, const std::string& object_weights, const CostT& cost)
+  {
+    Handle<GeometricPartitioner> partitioner = Core::instance().root().create_component<GeometricPartitioner>("partitioner_"+mesh.name());
+    partitioner->options().set("method", method);
+    partitioner->options().set("object_weights", object_weights);
+    partitioner->transform(mesh);
+    return partitioning_cost::imbalance(mesh, cost, m_total_cost);
+  }
+
+  /// Bounding box [xmin, ymin, xmax, ymax] of the centroids of the owned elements of each rank
+  std::vector<Real> centroid_boxes(const Mesh& mesh)
+  {
+    std::vector<Real> box(4);
+    box[0] = box[1] = std::numeric_limits<Real>::max();
+    box[2] = box[3] = -std::numeric_limits<Real>::max();
+    boost_foreach(const Handle<Entities>& entities, mesh.elements())
+    {
+      for (Uint e=0; e<entities->size(); ++e)
+      {
+        if(entities->is_ghost(e))
+          continue;
+        const RealVector c = partitioning_cost::centroid(mesh, *Handle<Elements>(entities), e);
+        box[0] = std::min(box[0], c[XX]); box[1] = std::min(box[1], c[YY]);
+        box[2] = std::max(box[2], c[XX]); box[3] = std::max(box[3], c[YY]);
+      }
+    }
+    std::vector<Real> boxes;
+    PE::Comm::instance().all_gather(box, boxes);
+    return boxes;
+  }
+
+  /// Check that every element and node is owned by exactly one rank, that the global indices are unique on each rank,
+  /// and that the ghost elements form a single layer around the owned elements
+  void check_ownership(const Mesh& mesh, const Uint nb_elems, const Uint nb_nodes)
+  {
+    const Dictionary& nodes = mesh.geometry_fields();
+
+    // Global indices are unique on each rank
+    std::set<Uint> elem_glb_idx;
+    Uint nb_local_elems = 0;
+    Uint max_glb_idx = 0;
+    boost_foreach(const Handle<Entities>& entities, mesh.elements())
+    {
+      nb_local_elems += entities->size();
+      elem_glb_idx.insert(entities->glb_idx().array().begin(), entities->glb_idx().array().end());
+      if(entities->size())
+        max_glb_idx = std::max(max_glb_idx, *std::max_element(entities->glb_idx().array().begin(), entities->glb_idx().array().end()));
+    }
+    BOOST_CHECK_EQUAL(elem_glb_idx.size(), nb_local_elems);
+    const std::set<Uint> node_glb_idx(nodes.glb_idx().array().begin(), nodes.glb_idx().array().end());
+    BOOST_CHECK_EQUAL(node_glb_idx.size(), nodes.size());
+    if(nodes.size())
+      max_glb_idx = std::max(max_glb_idx, *node_glb_idx.rbegin());
+
+    // Count the owners of every global index
+    Uint glb_size;
+    PE::Comm::instance().all_reduce(PE::max(), &max_glb_idx, 1, &glb_size);
+    ++glb_size;
+    std::vector<Uint> local_elem_owners(glb_size, 0), local_node_owners(glb_size, 0);
+    std::set<Uint> owned_elem_nodes;
+    boost_foreach(const Handle<Entities>& entities, mesh.elements())
+    {
+      const Connectivity& connectivity = Handle<Elements>(entities)->geometry_space().connectivity();
+      for (Uint e=0; e<entities->size(); ++e)
+      {
+        if(entities->is_ghost(e))
+          continue;
+        ++local_elem_owners[entities->glb_idx()[e]];
+        owned_elem_nodes.insert(connectivity[e].begin(), connectivity[e].end());
+      }
+    }
+    for (Uint n=0; n<nodes.size(); ++n)
+    {
+      if(!nodes.is_ghost(n))
+        ++local_node_owners[nodes.glb_idx()[n]];
+    }
+    std::vector<Uint> elem_owners(glb_size), node_owners(glb_size);
+    PE::Comm::instance().all_reduce(PE::plus(), local_elem_owners, elem_owners);
+    PE::Comm::instance().all_reduce(PE::plus(), local_node_owners, node_owners);
+    BOOST_CHECK_EQUAL(std::count(elem_owners.begin(), elem_owners.end(), 1u), nb_elems);
+    BOOST_CHECK_EQUAL(std::count(node_owners.begin(), node_owners.end(), 1u), nb_nodes);
+    BOOST_CHECK_EQUAL(*std::max_element(elem_owners.begin(), elem_owners.end()), 1u);
+    BOOST_CHECK_EQUAL(*std::max_element(node_owners.begin(), node_owners.end()), 1u);
+
+    // Ghosts are owned elsewhere, and every ghost element touches an owned element
+    Uint nb_ghost_elems = 0;
+    boost_foreach(const Handle<Entities>& entities, mesh.elements())
+    {
+      const Connectivity& connectivity = Handle<Elements>(entities)->geometry_space().connectivity();
+      for (Uint e=0; e<entities->size(); ++e)
+      {
+        if(!entities->is_ghost(e))
+          continue;
+        ++nb_ghost_elems;
+        BOOST_CHECK_EQUAL(elem_owners[entities->glb_idx()[e]], 1u);
+        bool touches_owned = false;
+        boost_foreach(const Uint node, connectivity[e])
+          touches_owned = touches_owned || owned_elem_nodes.count(node);
+        BOOST_CHECK(touches_owned);
+      }
+    }
+    for (Uint n=0; n<nodes.size(); ++n)
+    {
+      if(nodes.is_ghost(n))
+        BOOST_CHECK_EQUAL(node_owners[nodes.glb_idx()[n]], 1u);
+    }
+    if(PE::Comm::instance().size() > 1)
+      BOOST_CHECK_GT(nb_ghost_elems, 0u);
+  }
+
+  int m_argc;
+  char** m_argv;
+  Real m_total_cost;
+};
+
+/// Every element costs the same
+struct UnitCost
+{
+  Real operator()(const Mesh& mesh, const Elements& elements, const Uint elem) const { return 1.; }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( GeometricPartitionerTests_TestSuite, GeometricPartitionerTests_Fixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( init_mpi )
+{
+  Core::instance().initiate(m_argc,m_argv);
+  PE::Comm::instance().init(m_argc,m_argv);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( partition_hilbert )
+{
+  Mesh& mesh = partitioning_cost::generate_rectangle("hilbert", 40, 20);
+  const Real imbalance = partition(mesh, "Hilbert", "None", UnitCost());
+  CFinfo << "imbalance after Hilbert partitioning: " << imbalance << CFendl;
+  BOOST_CHECK_EQUAL(m_total_cost, 800.);
+  BOOST_CHECK_LT(imbalance, 1.02);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( partition_rcb )
+{
+  Mesh& mesh = partitioning_cost::generate_rectangle("rcb", 40, 20);
+  const Real imbalance = partition(mesh, "RCB", "None", UnitCost());
+  CFinfo << "imbalance after RCB partitioning: " << imbalance << CFendl;
+  BOOST_CHECK_EQUAL(m_total_cost, 800.);
+  BOOST_CHECK_LT(imbalance, 1.02);
+
+  // Bisection cuts along coordinate directions, so the parts are boxes that do not overlap.
+  // Elements centered on a cut may be divided over both sides, so boxes can touch along a cut
+  const std::vector<Real> boxes = centroid_boxes(mesh);
+  const Uint nb_parts = PE::Comm::instance().size();
+  for(Uint i = 0; i != nb_parts; ++i)
+  {
+    for(Uint j = i+1; j != nb_parts; ++j)
+    {
+      const Real* a = &boxes[4*i];
+      const Real* b = &boxes[4*j];
+      const bool separated = a[2] <= b[0] || b[2] <= a[0] || a[3] <= b[1] || b[3] <= a[1];
+      BOOST_CHECK_MESSAGE(separated, "parts " << i << " and " << j << " overlap");
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( partition_weighted )
+{
+  Mesh& mesh = partitioning_cost::generate_rectangle("weighted", 40, 20);
+
+  // The right quarter of the mesh is ten times as expensive
+  const partitioning_cost::StepCost cost(30.);
+  partitioning_cost::record_cost(mesh, cost);
+
+  const Real imbalance = partition(mesh, "RCB", "Measured", cost);
+  CFinfo << "imbalance of the measured cost after weighted RCB partitioning: " << imbalance << CFendl;
+  BOOST_CHECK_LT(imbalance, 1.1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( rebalance_overlapped_mesh )
+{
+  Mesh& mesh = partitioning_cost::generate_rectangle("rebalance", 40, 20);
+  const Uint nb_elems = 800;
+  const Uint nb_nodes = 41*21;
+
+  boost::shared_ptr<MeshTransformer> load_balance = build_component_abstract_type<MeshTransformer>("cf3.mesh.actions.LoadBalance","load_balance");
+  load_balance->options().set("partitioner", std::string("cf3.mesh.GeometricPartitioner"));
+  load_balance->transform(mesh);
+  check_ownership(mesh, nb_elems, nb_nodes);
+
+  // The first dynamic execution starts measuring
+  load_balance->options().set("mode", std::string("Dynamic"));
+  load_balance->transform(mesh);
+
+  // Rebalance the overlapped mesh twice, for a different cost each time
+  const Real steps[] = { 30., 10. };
+  for(Uint i = 0; i != 2; ++i)
+  {
+    const partitioning_cost::StepCost cost(steps[i]);
+    partitioning_cost::record_cost(mesh, cost);
+    load_balance->transform(mesh);
+    const Real measured_imbalance = load_balance->properties().value<Real>("imbalance");
+    const Real imbalance = partitioning_cost::imbalance(mesh, cost, m_total_cost);
+    CFinfo << "rebalancing " << i << ": imbalance " << measured_imbalance << " before and " << imbalance << " after" << CFendl;
+    BOOST_CHECK_GT(measured_imbalance, 1.1);
+    BOOST_CHECK_LT(imbalance, measured_imbalance);
+    check_ownership(mesh, nb_elems, nb_nodes);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( finalize_mpi )
+{
+  PE::Comm::instance().finalize();
+
+  Core::instance().terminate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,122 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#ifndef cf3_test_mesh_partitioning_cost_hpp
+#define cf3_test_mesh_partitioning_cost_hpp
+
+/**
+ @file utest-mesh-partitioning-cost.hpp Helpers shared by the partitioner tests: a structured test mesh,
+ a step-shaped element cost that is recorded as if it was measured, and the resulting load imbalance.
+**/
+
+#include "common/Builder.hpp"
+#include "common/Foreach.hpp"
+#include "common/List.hpp"
+#include "common/OptionList.hpp"
+#include "common/Table.hpp"
+
+#include "common/PE/Comm.hpp"
+#include "common/PE/operations.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/ElementCost.hpp"
+#include "mesh/Elements.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshGenerator.hpp"
+#include "mesh/MeshTransformer.hpp"
+#include "mesh/Space.hpp"
+
+#include "math/MatrixTypes.hpp"
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace partitioning_cost {
+
+/// Generate a rectangle of nx by ny unit cells with global numbering, stored as //name
+inline cf3::mesh::Mesh& generate_rectangle(const std::string& name, const cf3::Uint nx, const cf3::Uint ny)
+{
+  using namespace cf3;
+  boost::shared_ptr< mesh::MeshGenerator > meshgenerator = common::build_component_abstract_type<mesh::MeshGenerator>("cf3.mesh.SimpleMeshGenerator","generator_"+name);
+  meshgenerator->options().set("mesh",common::URI("//"+name));
+  std::vector<Uint> nb_cells(2);  nb_cells[0] = nx;   nb_cells[1] = ny;
+  std::vector<Real> lengths(2);   lengths[0]  = nx;   lengths[1]  = ny;
+  meshgenerator->options().set("nb_cells",nb_cells);
+  meshgenerator->options().set("lengths",lengths);
+  meshgenerator->options().set("bdry",false);
+  mesh::Mesh& mesh = meshgenerator->generate();
+  common::build_component_abstract_type<mesh::MeshTransformer>("cf3.mesh.actions.GlobalNumbering","glb_numbering")->transform(mesh);
+  return mesh;
+}
+
+/// Average of the node coordinates of an element
+inline cf3::RealVector centroid(const cf3::mesh::Mesh& mesh, const cf3::mesh::Elements& elements, const cf3::Uint elem)
+{
+  const cf3::mesh::Connectivity::ConstRow nodes = elements.geometry_space().connectivity()[elem];
+  const cf3::common::Table<cf3::Real>& coordinates = mesh.geometry_fields().coordinates();
+  cf3::RealVector result(cf3::RealVector::Zero(coordinates.row_size()));
+  boost_foreach(const cf3::Uint node, nodes)
+  {
+    for(cf3::Uint i = 0; i != coordinates.row_size(); ++i)
+      result[i] += coordinates[node][i];
+  }
+  return result / static_cast<cf3::Real>(nodes.size());
+}
+
+/// Elements with their centroid right of x_step are ten times as expensive
+struct StepCost
+{
+  StepCost(const cf3::Real a_x_step) : x_step(a_x_step) {}
+
+  cf3::Real operator()(const cf3::mesh::Mesh& mesh, const cf3::mesh::Elements& elements, const cf3::Uint elem) const
+  {
+    return centroid(mesh, elements, elem)[cf3::XX] > x_step ? 10. : 1.;
+  }
+
+  const cf3::Real x_step;
+};
+
+/// Store the cost of every element, as if it was measured
+template<typename CostT>
+void record_cost(cf3::mesh::Mesh& mesh, const CostT& cost)
+{
+  using namespace cf3;
+  mesh::reset_element_cost(mesh);
+  boost_foreach(const Handle<mesh::Entities>& entities, mesh.elements())
+  {
+    Handle< common::List<Real> > measured = mesh::element_cost(*entities);
+    cf3_always_assert(is_not_null(measured));
+    for (Uint e=0; e<entities->size(); ++e)
+      (*measured)[e] = cost(mesh, *Handle<mesh::Elements>(entities), e);
+  }
+}
+
+/// Ratio between the largest cost of the owned elements of a rank and the average over all ranks.
+/// The total cost is returned in total_cost
+template<typename CostT>
+cf3::Real imbalance(const cf3::mesh::Mesh& mesh, const CostT& cost, cf3::Real& total_cost)
+{
+  using namespace cf3;
+  Real local_cost = 0.;
+  boost_foreach(const Handle<mesh::Entities>& entities, mesh.elements())
+  {
+    for (Uint e=0; e<entities->size(); ++e)
+    {
+      if(!entities->is_ghost(e))
+        local_cost += cost(mesh, *Handle<mesh::Elements>(entities), e);
+    }
+  }
+  Real max_cost;
+  common::PE::Comm::instance().all_reduce(common::PE::max(), &local_cost, 1, &max_cost);
+  common::PE::Comm::instance().all_reduce(common::PE::plus(), &local_cost, 1, &total_cost);
+  return max_cost * common::PE::Comm::instance().size() / total_cost;
+}
+
+} // partitioning_cost
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+#endif // cf3_test_mesh_partitioning_cost_hpp
@@ -31,6 +31,8 @@
 #include "mesh/MeshPartitioner.hpp"
 #include "mesh/MeshTransformer.hpp"
 
+#include "test/mesh/utest-mesh-partitioning-cost.hpp"
+
 using namespace boost;
 using namespace cf3;
 using namespace cf3::mesh;
@@ -266,6 +268,34 @@ BOOST_AUTO_TEST_CASE( MeshPartitioner_test_quadtriag )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE( MeshPartitioner_test_measured_weights )
+{
+  Mesh& mesh = partitioning_cost::generate_rectangle("weighted", 20, 10);
+  build_component_abstract_type<MeshTransformer>("cf3.mesh.actions.GlobalConnectivity","glb_connectivity")->transform(mesh);
+
+  // The right half of the mesh is ten times as expensive
+  const partitioning_cost::StepCost cost(10.);
+  partitioning_cost::record_cost(mesh, cost);
+
+  boost::shared_ptr< MeshPartitioner > partitioner_ptr = boost::dynamic_pointer_cast<MeshPartitioner>(build_component_abstract_type<MeshTransformer>("cf3.mesh.zoltan.Partitioner","partitioner"));
+  MeshPartitioner& p = *partitioner_ptr;
+  p.options().set("graph_package", std::string("PHG"));
+  p.options().set("object_weights", std::string("Measured"));
+  p.options().set("node_weight", 0.);
+  p.initialize(mesh);
+  BOOST_CHECK(p.has_object_weights());
+  p.partition_graph();
+  p.migrate();
+
+  Real total_cost;
+  const Real imbalance = partitioning_cost::imbalance(mesh, cost, total_cost);
+  CFinfo << "imbalance of the measured cost after weighted partitioning: " << imbalance << CFendl;
+  BOOST_CHECK_EQUAL(total_cost, 1100.);
+  BOOST_CHECK_LT(imbalance, 1.25);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE( finalize_mpi )
 {
   PE::Comm::instance().finalize();
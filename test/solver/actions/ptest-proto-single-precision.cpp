@@ -0,0 +1,207 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Benchmark comparing proto loops over single and double precision fields"
+
+#include <boost/lexical_cast.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "solver/actions/Proto/ElementLooper.hpp"
+#include "solver/actions/Proto/Expression.hpp"
+#include "solver/actions/Proto/Functions.hpp"
+#include "solver/actions/Proto/NodeLooper.hpp"
+#include "solver/actions/Proto/Terminals.hpp"
+
+#include "common/Core.hpp"
+#include "common/Log.hpp"
+#include "common/Timer.hpp"
+
+#include "math/MatrixTypes.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/ElementTypes.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Region.hpp"
+
+#include "Tools/MeshGeneration/MeshGeneration.hpp"
+
+using namespace cf3;
+using namespace cf3::solver;
+using namespace cf3::solver::actions;
+using namespace cf3::solver::actions::Proto;
+using namespace cf3::mesh;
+using namespace cf3::common;
+
+using boost::proto::lit;
+
+////////////////////////////////////////////////////
+
+/// Relaxation factor of the explicit update
+const Real dt = 0.1;
+
+/// Exact solution of u += dt*(x - u) after nb_steps, starting from zero
+Real exact_update(const Real x, const Uint nb_steps)
+{
+  return x * (1. - std::pow(1. - dt, static_cast<int>(nb_steps)));
+}
+
+/// Largest difference between a component of the field and the exact update
+Real max_update_error(const Field& field, const Uint nb_steps)
+{
+  const Field& coords = field.coordinates();
+  Real result = 0.;
+  for(Uint i = 0; i != coords.size(); ++i)
+    for(Uint j = 0; j != coords.row_size(); ++j)
+      result = std::max(result, std::abs(field.value(i, j) - exact_update(coords[i][j], nb_steps)));
+  return result;
+}
+
+/// Largest difference between the components of two fields
+Real max_difference(const Field& a, const Field& b)
+{
+  Real result = 0.;
+  for(Uint i = 0; i != a.nb_rows(); ++i)
+    for(Uint j = 0; j != a.row_size(); ++j)
+      result = std::max(result, std::abs(a.value(i, j) - b.value(i, j)));
+  return result;
+}
+
+struct SinglePrecisionFixture
+{
+  SinglePrecisionFixture() : root(Core::instance().root())
+  {
+    int argc = boost::unit_test::framework::master_test_suite().argc;
+    char** argv = boost::unit_test::framework::master_test_suite().argv;
+
+    cf3_assert(argc == 3);
+    segments = boost::lexical_cast<Uint>(argv[1]);
+    nb_steps = boost::lexical_cast<Uint>(argv[2]);
+  }
+
+  Mesh& mesh()
+  {
+    return *Handle<Mesh>(root.get_child("mesh"));
+  }
+
+  Field& field(const std::string& name)
+  {
+    return *Handle<Field>(mesh().geometry_fields().get_child(name));
+  }
+
+  Component& root;
+  Uint segments;
+  Uint nb_steps;
+
+  /// Wall clock times for the double and single precision runs, shared between test cases
+  static Real double_node_time;
+  static Real single_node_time;
+  static Real double_element_time;
+  static Real single_element_time;
+};
+
+Real SinglePrecisionFixture::double_node_time = 0.;
+Real SinglePrecisionFixture::single_node_time = 0.;
+Real SinglePrecisionFixture::double_element_time = 0.;
+Real SinglePrecisionFixture::single_element_time = 0.;
+
+BOOST_FIXTURE_TEST_SUITE( ProtoSinglePrecisionBenchmarkSuite, SinglePrecisionFixture )
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( CreateFields )
+{
+  Mesh& mesh = *root.create_component<Mesh>("mesh");
+  Tools::MeshGeneration::create_rectangle(mesh, 1., 1., segments, segments);
+
+  Dictionary& geometry = mesh.geometry_fields();
+  geometry.create_field("double_state", "u[vector]").add_tag("double_state");
+  geometry.create_field("single_state", "u_s[vector]", true).add_tag("single_state");
+
+  CFinfo << "Benchmarking " << nb_steps << " steps on " << geometry.size() << " nodes, using "
+         << field("double_state").memory_footprint() << " bytes in double precision and "
+         << field("single_state").memory_footprint() << " bytes in single precision" << CFendl;
+}
+
+BOOST_AUTO_TEST_CASE( NodeLoopDouble )
+{
+  FieldVariable<0, VectorField> u("u", "double_state");
+
+  for_each_node(mesh().topology(), u[_i] = 0.);
+  Timer timer;
+  for(Uint step = 0; step != nb_steps; ++step)
+    for_each_node(mesh().topology(), u += lit(dt)*(coordinates - u));
+  double_node_time = timer.elapsed();
+}
+
+BOOST_AUTO_TEST_CASE( NodeLoopSingle )
+{
+  FieldVariable<0, VectorField> u_s("u_s", "single_state");
+
+  for_each_node(mesh().topology(), u_s[_i] = 0.);
+  Timer timer;
+  for(Uint step = 0; step != nb_steps; ++step)
+    for_each_node(mesh().topology(), u_s += lit(dt)*(coordinates - u_s));
+  single_node_time = timer.elapsed();
+}
+
+BOOST_AUTO_TEST_CASE( ElementLoopDouble )
+{
+  FieldVariable<0, VectorField> u("u", "double_state");
+
+  Eigen::Matrix<Real, 8, 8> vals; vals.setConstant(0.125);
+  Timer timer;
+  for(Uint step = 0; step != nb_steps; ++step)
+    for_each_element< boost::mpl::vector1<LagrangeP1::Quad2D> >(mesh().topology(), u += diagonal(vals));
+  double_element_time = timer.elapsed();
+}
+
+BOOST_AUTO_TEST_CASE( ElementLoopSingle )
+{
+  FieldVariable<0, VectorField> u_s("u_s", "single_state");
+
+  Eigen::Matrix<Real, 8, 8> vals; vals.setConstant(0.125);
+  Timer timer;
+  for(Uint step = 0; step != nb_steps; ++step)
+    for_each_element< boost::mpl::vector1<LagrangeP1::Quad2D> >(mesh().topology(), u_s += diagonal(vals));
+  single_element_time = timer.elapsed();
+}
+
+BOOST_AUTO_TEST_CASE( Report )
+{
+  CFinfo << "Node loop: " << double_node_time << " s in double precision, " << single_node_time << " s in single precision, speedup "
+         << double_node_time / single_node_time << CFendl;
+  CFinfo << "Element loop: " << double_element_time << " s in double precision, " << single_element_time << " s in single precision, speedup "
+         << double_element_time / single_element_time << CFendl;
+
+  // Accuracy: the node loop alone is compared with the exact solution, the element loop against the double precision result
+  Dictionary& geometry = mesh().geometry_fields();
+  geometry.create_field("double_check", "u_d[vector]").add_tag("double_check");
+  geometry.create_field("single_check", "u_c[vector]", true).add_tag("single_check");
+  FieldVariable<0, VectorField> u_d("u_d", "double_check");
+  FieldVariable<1, VectorField> u_c("u_c", "single_check");
+  for_each_node(mesh().topology(), group(u_d[_i] = 0., u_c[_i] = 0.));
+  for(Uint step = 0; step != nb_steps; ++step)
+    for_each_node(mesh().topology(), group(u_d += lit(dt)*(coordinates - u_d), u_c += lit(dt)*(coordinates - u_c)));
+
+  const Real double_error = max_update_error(field("double_check"), nb_steps);
+  const Real single_error = max_update_error(field("single_check"), nb_steps);
+  const Real element_difference = max_difference(field("double_state"), field("single_state"));
+  CFinfo << "Maximum error of the explicit update: " << double_error << " in double precision, " << single_error << " in single precision" << CFendl;
+  CFinfo << "Maximum difference after the element loops: " << element_difference << CFendl;
+
+  BOOST_CHECK_SMALL(double_error, 1e-12);
+  BOOST_CHECK_SMALL(single_error, 1e-5);
+  BOOST_CHECK_SMALL(element_difference, 1e-5 * static_cast<Real>(nb_steps));
+
+  std::cout << "<DartMeasurement name=\"single precision node loop speedup\" type=\"numeric/double\">" << double_node_time / single_node_time << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"single precision element loop speedup\" type=\"numeric/double\">" << double_element_time / single_element_time << "</DartMeasurement>" << std::endl;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
@@ -348,6 +348,33 @@ BOOST_AUTO_TEST_CASE( ScalarTest )
   Thyra::norms(*rhs2, Teuchos::arrayViewFromVector(diff_norm));
   std::cout << "diff norm: " << diff_norm.front() << std::endl;
   BOOST_CHECK_SMALL(diff_norm.front(), 1e-10);
+
+  // Assemble the same RHS through the single-variable RHS accumulator only
+  Handle<ProtoAction> rhs_action = root.create_component<ProtoAction>("ScalarRHSAction");
+  rhs_action->set_expression(elements_expression(
+    group
+    (
+      _A = _0,
+      element_quadrature
+      (
+        _A(T,T) += transpose(nabla(T)) * nabla(T)
+      ),
+      sys_rhs(T) += _A * scalar_vector
+    )
+  ));
+  rhs_action->options().set("physical_model", physical_model);
+  rhs_action->options().set(solver::Tags::regions(), loop_regions);
+
+  Handle<math::LSS::Vector> rhs_copy(root.create_component("ScalarRHSCopy", "cf3.math.LSS.TrilinosVector"));
+  lss->rhs()->clone_to(*rhs_copy);
+  lss->rhs()->reset();
+  rhs_action->execute();
+
+  Handle<math::LSS::ThyraVector> thyra_rhs_copy(rhs_copy);
+  Thyra::update(-1., *rhs->thyra_vector(), thyra_rhs_copy->thyra_vector().ptr());
+  Thyra::norms(*thyra_rhs_copy->thyra_vector(), Teuchos::arrayViewFromVector(diff_norm));
+  std::cout << "rhs only diff norm: " << diff_norm.front() << std::endl;
+  BOOST_CHECK_SMALL(diff_norm.front(), 1e-10);
 }
 
 BOOST_AUTO_TEST_CASE( VectorTest )
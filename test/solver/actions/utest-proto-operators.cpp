@@ -42,6 +42,7 @@
 
 #include "mesh/Integrators/Gauss.hpp"
 #include "mesh/ElementTypes.hpp"
+#include "mesh/BlockMesh/BlockData.hpp"
 
 #include "physics/PhysModel.hpp"
 
@@ -396,6 +397,159 @@ BOOST_AUTO_TEST_CASE( ElementGaussQuadrature )
   check_close(result, 2.*exact, 1e-10);
 }
 
+/// Move the nodes of a regular grid, so the elements are no longer parallelograms
+void distort_nodes(Mesh& mesh)
+{
+  Field& coords = mesh.geometry_fields().coordinates();
+  const Uint dim = coords.row_size();
+  for(Uint i = 0; i != coords.size(); ++i)
+  {
+    const Real x = coords[i][XX];
+    const Real y = coords[i][YY];
+    coords[i][XX] += 0.1*y*y;
+    coords[i][YY] += 0.05*x*x + 0.02*x*y;
+    if(dim == 3)
+      coords[i][ZZ] += 0.05*x*coords[i][ZZ];
+  }
+}
+
+/// Compare the coordinates, jacobian, shape functions and values that sum factorisation computes at each Gauss point
+/// of the given order with a direct evaluation at the mapped coordinates of the point.
+/// The integrals of u*u and of the gradient of u, using the direct evaluation, are added to value_integral and gradient_integral.
+template<typename EtypeT, Uint Order>
+void check_tensor_product_points(Mesh& mesh, Real& value_integral, RealVector& gradient_integral)
+{
+  typedef GaussTensorProduct<EtypeT, Order> GaussTensorProductT;
+  typedef mesh::Integrators::GaussMappedCoords<Order, EtypeT::shape> GaussT;
+  typedef GeometricSupport<EtypeT> SupportT;
+  typedef EtypeTVariableData<EtypeT, EtypeT, 1, false> VariableDataT;
+  typedef typename EtypeT::SF::GradientT GradientT;
+
+  const GaussTensorProductT& gauss_tp = GaussTensorProductT::instance();
+  Uint nb_elements = 0;
+  BOOST_FOREACH(Elements& elements, find_components_recursively_with_filter<Elements>(mesh.topology(), IsElementType<EtypeT>()))
+  {
+    SupportT support(elements);
+    VariableDataT u_data(ScalarField("u", "solution"), elements, support);
+    for(Uint elem_idx = 0; elem_idx != elements.size(); ++elem_idx)
+    {
+      support.set_element(elem_idx);
+      u_data.set_element(elem_idx);
+      support.compute_tensor_product_geometry(gauss_tp);
+      u_data.compute_tensor_product_values(gauss_tp);
+      for(Uint i = 0; i != GaussT::nb_points; ++i)
+      {
+        // Copy the values for the point, since the direct evaluation below overwrites them
+        support.set_tensor_product_point(gauss_tp, i);
+        u_data.set_tensor_product_point(gauss_tp, i);
+        const typename EtypeT::CoordsT coords = support.coordinates();
+        const typename EtypeT::JacobianT jacobian = support.jacobian();
+        const Real jacobian_determinant = support.jacobian_determinant();
+        const typename EtypeT::SF::ValueT sf = u_data.shape_function();
+        const GradientT nabla = u_data.nabla();
+        const Real value = u_data.eval();
+
+        const typename EtypeT::MappedCoordsT mapped_coords = GaussT::instance().coords.col(i);
+        BOOST_CHECK_SMALL((coords - support.coordinates(mapped_coords)).norm(), 1e-12);
+        BOOST_CHECK_SMALL((jacobian - support.jacobian(mapped_coords)).norm(), 1e-12);
+        BOOST_CHECK_SMALL(jacobian_determinant - support.jacobian_determinant(mapped_coords), 1e-12);
+        BOOST_CHECK_SMALL((sf - u_data.shape_function(mapped_coords)).norm(), 1e-12);
+        BOOST_CHECK_SMALL((nabla - u_data.nabla(mapped_coords)).norm(), 1e-10);
+        BOOST_CHECK_SMALL(value - u_data.eval(mapped_coords), 1e-12);
+
+        const Real weight = GaussT::instance().weights[i] * support.jacobian_determinant(mapped_coords);
+        const Real direct_value = u_data.eval(mapped_coords);
+        value_integral += weight * direct_value * direct_value;
+        gradient_integral += weight * u_data.nabla(mapped_coords) * u_data.value();
+      }
+      ++nb_elements;
+    }
+  }
+  BOOST_CHECK_GT(nb_elements, 0);
+}
+
+BOOST_AUTO_TEST_CASE( TensorProductQuadrature )
+{
+  Handle<Mesh> mesh = Core::instance().root().create_component<Mesh>("TensorProductGrid");
+  Tools::MeshGeneration::create_rectangle(*mesh, 1., 1., 3, 2);
+  distort_nodes(*mesh);
+
+  mesh->geometry_fields().create_field( "solution", "u[scalar]" ).add_tag("solution");
+
+  FieldVariable<0, ScalarField > u("u", "solution");
+
+  // Not symmetric in x and y, so a permutation of the Gauss points or a transposed jacobian shows up
+  for_each_node(mesh->topology(), group(u = coordinates[0]*coordinates[0] + 3.*coordinates[0]*coordinates[1]));
+
+  Real reference1 = 0.;
+  RealVector reference2(2);
+  reference2.setZero();
+  check_tensor_product_points<LagrangeP1::Quad2D, 2>(*mesh, reference1, reference2);
+
+  Real higher_order1 = 0.;
+  RealVector higher_order2(2);
+  higher_order2.setZero();
+  check_tensor_product_points<LagrangeP1::Quad2D, 4>(*mesh, higher_order1, higher_order2);
+
+  Real result1 = 0.;
+  RealVector2 result2;
+  result2.setZero();
+
+  // Values and gradients at the Gauss points of the Quad2D elements are computed using sum factorisation
+  for_each_element< boost::mpl::vector1<LagrangeP1::Quad2D> >
+  (
+    mesh->topology(),
+    element_quadrature
+    (
+      lit(result1) += u*u,
+      lit(result2) += gradient(u)
+    )
+  );
+
+  BOOST_CHECK_CLOSE(result1, reference1, 1e-10);
+  BOOST_CHECK_CLOSE(result2[0], reference2[0], 1e-10);
+  BOOST_CHECK_CLOSE(result2[1], reference2[1], 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE( TensorProductQuadratureHexa )
+{
+  Handle<Mesh> mesh = Core::instance().root().create_component<Mesh>("TensorProductHexas");
+  BlockMesh::BlockArrays& blocks = *Core::instance().root().create_component<BlockMesh::BlockArrays>("TensorProductBlocks");
+  Tools::MeshGeneration::create_channel_3d(blocks, 2., 0.5, 1., 2, 2, 2, 0.5);
+  blocks.create_mesh(*mesh);
+  distort_nodes(*mesh);
+
+  mesh->geometry_fields().create_field( "solution", "u[scalar]" ).add_tag("solution");
+
+  FieldVariable<0, ScalarField > u("u", "solution");
+
+  for_each_node(mesh->topology(), group(u = coordinates[0]*coordinates[0] + 3.*coordinates[0]*coordinates[1] + coordinates[0]*coordinates[2]));
+
+  Real reference1 = 0.;
+  RealVector reference2(3);
+  reference2.setZero();
+  check_tensor_product_points<LagrangeP1::Hexa3D, 2>(*mesh, reference1, reference2);
+
+  Real result1 = 0.;
+  RealVector3 result2;
+  result2.setZero();
+
+  for_each_element< boost::mpl::vector1<LagrangeP1::Hexa3D> >
+  (
+    mesh->topology(),
+    element_quadrature
+    (
+      lit(result1) += u*u,
+      lit(result2) += gradient(u)
+    )
+  );
+
+  BOOST_CHECK_CLOSE(result1, reference1, 1e-10);
+  BOOST_CHECK_CLOSE(result2[0], reference2[0], 1e-10);
+  BOOST_CHECK_CLOSE(result2[1], reference2[1], 1e-10);
+  BOOST_CHECK_CLOSE(result2[2], reference2[2], 1e-10);
+}
+
 
 BOOST_AUTO_TEST_CASE(GroupArity)
 {
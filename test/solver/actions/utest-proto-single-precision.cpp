@@ -0,0 +1,264 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for proto access to single precision fields"
+
+#include <boost/test/unit_test.hpp>
+
+#include "solver/actions/FieldTimeAverage.hpp"
+
+#include "solver/actions/Proto/ElementLooper.hpp"
+#include "solver/actions/Proto/Expression.hpp"
+#include "solver/actions/Proto/Functions.hpp"
+#include "solver/actions/Proto/NodeLooper.hpp"
+#include "solver/actions/Proto/Terminals.hpp"
+
+#include "common/Core.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+
+#include "math/MatrixTypes.hpp"
+
+#include "mesh/Dictionary.hpp"
+#include "mesh/ElementTypes.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/Region.hpp"
+
+#include "Tools/MeshGeneration/MeshGeneration.hpp"
+#include "Tools/Testing/TimedTestFixture.hpp"
+
+using namespace cf3;
+using namespace cf3::solver;
+using namespace cf3::solver::actions;
+using namespace cf3::solver::actions::Proto;
+using namespace cf3::mesh;
+using namespace cf3::common;
+
+using boost::proto::lit;
+
+////////////////////////////////////////////////////
+
+/// Relaxation factor and number of steps of the explicit update
+const Real dt = 0.1;
+const Uint nb_steps = 10;
+
+/// Exact solution of u += dt*(x - u) after nb_steps, starting from zero
+Real exact_update(const Real x)
+{
+  return x * (1. - std::pow(1. - dt, static_cast<int>(nb_steps)));
+}
+
+/// Largest difference between a component of the field and the exact update
+Real max_update_error(const Field& field)
+{
+  const Field& coords = field.coordinates();
+  Real result = 0.;
+  for(Uint i = 0; i != coords.size(); ++i)
+    for(Uint j = 0; j != coords.row_size(); ++j)
+      result = std::max(result, std::abs(field.value(i, j) - exact_update(coords[i][j])));
+  return result;
+}
+
+BOOST_FIXTURE_TEST_SUITE( ProtoSinglePrecisionSuite, Tools::Testing::TimedTestFixture )
+
+//////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( CreateFields )
+{
+  Mesh& mesh = *Core::instance().root().create_component<Mesh>("mesh");
+  Tools::MeshGeneration::create_rectangle(mesh, 1., 1., 20, 20);
+
+  Dictionary& geometry = mesh.geometry_fields();
+  geometry.create_field("double_state", "u[vector]").add_tag("double_state");
+  geometry.create_field("single_state", "u_s[vector]", true).add_tag("single_state");
+
+  const Field& double_field = *Handle<Field>(geometry.get_child("double_state"));
+  const Field& single_field = *Handle<Field>(geometry.get_child("single_state"));
+
+  BOOST_CHECK(!double_field.single_precision());
+  BOOST_CHECK(single_field.single_precision());
+
+  // The values only live in the float array, which takes half the memory
+  const common::Table<Real>& table = single_field;
+  BOOST_CHECK_EQUAL(single_field.nb_rows(), geometry.size());
+  BOOST_CHECK_EQUAL(single_field.row_size(), 2);
+  BOOST_CHECK_EQUAL(single_field.single_array().size(), geometry.size());
+  BOOST_CHECK_EQUAL(table.size(), 0);
+  BOOST_CHECK_EQUAL(single_field.array().size(), 0);
+  BOOST_CHECK_EQUAL(2*single_field.memory_footprint(), double_field.memory_footprint());
+  BOOST_CHECK(geometry.check_sanity());
+}
+
+BOOST_AUTO_TEST_CASE( ExplicitUpdateDouble )
+{
+  Mesh& mesh = *Handle<Mesh>(Core::instance().root().get_child("mesh"));
+  FieldVariable<0, VectorField> u("u", "double_state");
+
+  for_each_node(mesh.topology(), u[_i] = 0.);
+  for(Uint step = 0; step != nb_steps; ++step)
+    for_each_node(mesh.topology(), u += lit(dt)*(coordinates - u));
+}
+
+BOOST_AUTO_TEST_CASE( ExplicitUpdateSingle )
+{
+  Mesh& mesh = *Handle<Mesh>(Core::instance().root().get_child("mesh"));
+  FieldVariable<0, VectorField> u_s("u_s", "single_state");
+
+  for_each_node(mesh.topology(), u_s[_i] = 0.);
+  for(Uint step = 0; step != nb_steps; ++step)
+    for_each_node(mesh.topology(), u_s += lit(dt)*(coordinates - u_s));
+}
+
+BOOST_AUTO_TEST_CASE( CheckUpdateAccuracy )
+{
+  Dictionary& geometry = Handle<Mesh>(Core::instance().root().get_child("mesh"))->geometry_fields();
+  const Real double_error = max_update_error(*Handle<Field>(geometry.get_child("double_state")));
+  const Real single_error = max_update_error(*Handle<Field>(geometry.get_child("single_state")));
+  CFinfo << "Maximum error of the explicit update: " << double_error << " in double precision, " << single_error << " in single precision" << CFendl;
+
+  BOOST_CHECK_SMALL(double_error, 1e-14);
+  BOOST_CHECK_SMALL(single_error, 1e-6);
+
+  // The loops work on the float array directly, without expanding the field to double precision
+  const Field& single_field = *Handle<Field>(geometry.get_child("single_state"));
+  BOOST_CHECK(single_field.single_precision());
+  BOOST_CHECK_EQUAL(single_field.single_array().size(), geometry.size());
+  const common::Table<Real>& table = single_field;
+  BOOST_CHECK_EQUAL(table.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE( ElementAccess )
+{
+  Mesh& mesh = *Handle<Mesh>(Core::instance().root().get_child("mesh"));
+  FieldVariable<0, VectorField> u("u", "double_state");
+  FieldVariable<1, VectorField> u_s("u_s", "single_state");
+
+  // Reading the nodal values
+  Real double_norm = 0.;
+  Real single_norm = 0.;
+  for_each_element< boost::mpl::vector1<LagrangeP1::Quad2D> >
+  (
+    mesh.topology(),
+    element_quadrature
+    (
+      lit(double_norm) += _norm(u),
+      lit(single_norm) += _norm(u_s)
+    )
+  );
+  BOOST_CHECK_CLOSE(single_norm, double_norm, 1e-4);
+
+  // Writing the nodal values
+  Eigen::Matrix<Real, 8, 8> vals; vals.setConstant(0.125);
+  for_each_element< boost::mpl::vector1<LagrangeP1::Quad2D> >
+  (
+    mesh.topology(),
+    group
+    (
+      u += diagonal(vals),
+      u_s += diagonal(vals)
+    )
+  );
+
+  const Field& double_field = *Handle<Field>(mesh.geometry_fields().get_child("double_state"));
+  const Field& single_field = *Handle<Field>(mesh.geometry_fields().get_child("single_state"));
+  for(Uint i = 0; i != double_field.size(); ++i)
+    for(Uint j = 0; j != 2; ++j)
+      BOOST_CHECK_SMALL(single_field.value(i, j) - double_field[i][j], 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE( TimeAverage )
+{
+  Mesh& mesh = *Handle<Mesh>(Core::instance().root().get_child("mesh"));
+  Dictionary& geometry = mesh.geometry_fields();
+  Handle<Field> double_field(geometry.get_child("double_state"));
+  Handle<Field> single_field(geometry.get_child("single_state"));
+
+  FieldVariable<0, VectorField> u("u", "double_state");
+  FieldVariable<1, VectorField> u_s("u_s", "single_state");
+
+  // Average the double field in single precision and the single field in double precision
+  Handle<FieldTimeAverage> double_average = Core::instance().root().create_component<FieldTimeAverage>("DoubleAverage");
+  double_average->options().set("single_precision", true);
+  double_average->options().set("field", double_field);
+  Handle<FieldTimeAverage> single_average = Core::instance().root().create_component<FieldTimeAverage>("SingleAverage");
+  single_average->options().set("field", single_field);
+
+  for(Uint step = 0; step != 4; ++step)
+  {
+    for_each_node(mesh.topology(), group(u = coordinates*lit(static_cast<Real>(step)), u_s = coordinates*lit(static_cast<Real>(step))));
+    double_average->execute();
+    single_average->execute();
+  }
+
+  const Field& average_double = *Handle<Field>(geometry.get_child("average_double_state"));
+  const Field& average_single = *Handle<Field>(geometry.get_child("average_single_state"));
+  BOOST_CHECK(average_double.single_precision());
+  BOOST_CHECK(!average_single.single_precision());
+
+  const Field& coords = geometry.coordinates();
+  for(Uint i = 0; i != coords.size(); ++i)
+  {
+    for(Uint j = 0; j != 2; ++j)
+    {
+      BOOST_CHECK_SMALL(average_double.value(i, j) - 1.5*coords[i][j], 1e-6);
+      BOOST_CHECK_SMALL(average_single.value(i, j) - 1.5*coords[i][j], 1e-6);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( SwitchPrecision )
+{
+  Field& single_field = *Handle<Field>(Handle<Mesh>(Core::instance().root().get_child("mesh"))->geometry_fields().get_child("single_state"));
+  const Uint nb_rows = single_field.single_array().size();
+  const Field::SingleArrayT single_values = single_field.single_array();
+
+  // Switching to double precision restores the Table<Real> interface, with the exact float values
+  single_field.options().set("single_precision", false);
+  BOOST_CHECK_EQUAL(single_field.size(), nb_rows);
+  BOOST_CHECK_EQUAL(single_field.nb_rows(), nb_rows);
+  BOOST_CHECK_EQUAL(single_field.array().size(), nb_rows);
+  BOOST_CHECK_EQUAL(single_field.single_array().size(), 0);
+  for(Uint i = 0; i != nb_rows; ++i)
+    for(Uint j = 0; j != 2; ++j)
+      BOOST_CHECK_EQUAL(single_field[i][j], static_cast<Real>(single_values[i][j]));
+
+  // And back, without loss
+  single_field.options().set("single_precision", true);
+  BOOST_CHECK_EQUAL(single_field.nb_rows(), nb_rows);
+  BOOST_CHECK_EQUAL(single_field.size(), 0);
+  BOOST_CHECK(single_field.single_array() == single_values);
+}
+
+BOOST_AUTO_TEST_CASE( DoublePrecisionScopes )
+{
+  Field& single_field = *Handle<Field>(Handle<Mesh>(Core::instance().root().get_child("mesh"))->geometry_fields().get_child("single_state"));
+  const Field::SingleArrayT single_values = single_field.single_array();
+
+  // A read-only scope exposes the double values, but drops any change when it closes
+  {
+    DoublePrecisionScope scope(single_field, false);
+    BOOST_CHECK(!single_field.single_precision());
+    BOOST_CHECK_EQUAL(single_field.size(), single_values.size());
+    single_field[0][0] = 1000.;
+  }
+  BOOST_CHECK(single_field.single_precision());
+  BOOST_CHECK(single_field.single_array() == single_values);
+
+  // A writable scope stores the changes back in single precision
+  {
+    DoublePrecisionScope scope(single_field, true);
+    single_field[0][0] = 1000.;
+  }
+  BOOST_CHECK(single_field.single_precision());
+  BOOST_CHECK_EQUAL(single_field.single_array()[0][0], 1000.f);
+  BOOST_CHECK_EQUAL(single_field.single_array()[0][1], single_values[0][1]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
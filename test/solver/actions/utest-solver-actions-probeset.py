@@ -0,0 +1,110 @@
+import coolfluid as cf
+import os
+import struct
+
+env = cf.Core.environment()
+env.log_level = 3
+
+root = cf.Core.root()
+domain = root.create_component('Domain', 'cf3.mesh.Domain')
+mesh = domain.create_component('OriginalMesh','cf3.mesh.Mesh')
+
+blocks = root.create_component('model', 'cf3.mesh.BlockMesh.BlockArrays')
+points = blocks.create_points(dimensions = 2, nb_points = 4)
+points[0]  = [0., 0.]
+points[1]  = [4., 0.]
+points[2]  = [4., 1.]
+points[3]  = [0., 1.]
+block_nodes = blocks.create_blocks(1)
+block_nodes[0] = [0, 1, 2, 3]
+block_subdivs = blocks.create_block_subdivisions()
+block_subdivs[0] = [16,4]
+gradings = blocks.create_block_gradings()
+gradings[0] = [1., 1., 1., 1.]
+blocks.create_patch_nb_faces(name = 'bottom', nb_faces = 1)[0] = [0, 1]
+blocks.create_patch_nb_faces(name = 'right', nb_faces = 1)[0] = [1, 2]
+blocks.create_patch_nb_faces(name = 'top', nb_faces = 1)[0] = [2, 3]
+blocks.create_patch_nb_faces(name = 'left', nb_faces = 1)[0] = [3, 0]
+blocks.partition_blocks(nb_partitions = cf.Core.nb_procs(), direction = 0)
+blocks.create_mesh(mesh.uri())
+
+# A linear field is interpolated exactly, wherever the points fall
+def linear(x, y, step):
+  return 2.*x + 3.*y + 1. + step
+
+coords = mesh.geometry.coordinates
+field = mesh.geometry.create_field(name = 'linear', variables = 'F')
+def update_field(step):
+  for i in range(len(coords)):
+    field[i][0] = linear(coords[i][0], coords[i][1], step)
+
+history = domain.create_component('History', 'cf3.solver.History')
+history.file = cf.URI('probeset.tsv')
+history.dimension = 2
+
+# The probe set appends to existing files
+if cf.Core.rank() == 0:
+  for filename in ['probeset.bin', 'probeset-moved.bin']:
+    if os.path.exists(filename):
+      os.remove(filename)
+
+probes = domain.create_component('Probes', 'cf3.solver.actions.ProbeSet')
+probes.dict = mesh.geometry
+probes.fields = ['linear']
+probes.history = history
+probes.file = cf.URI('probeset.bin')
+probes.flush_interval = 3
+# The diagonal crosses all partitions, the vertical line lies on the partition boundary for 2 and 4 processes
+probes.add_line(start = [0., 0.], end = [4., 1.], nb_points = 33)
+probes.add_line(start = [2., 0.], end = [2., 1.], nb_points = 9)
+
+def run_steps(first_step, nb_steps):
+  probe_coords = probes.coordinates
+  nb_probes = len(probe_coords) / 2
+  for step in range(first_step, first_step + nb_steps):
+    update_field(step)
+    probes.execute()
+    if cf.Core.rank() == 0:
+      values = probes.get_child('values')
+      for i in range(nb_probes):
+        expected = linear(probe_coords[2*i], probe_coords[2*i+1], step)
+        if abs(values[i][0] - expected) > 1e-10:
+          raise Exception('Probe ' + str(i) + ' at step ' + str(step) + ' has value ' + str(values[i][0]) + ', expected ' + str(expected))
+  return probe_coords
+
+# Read a header line and nb_steps records from an open file
+def check_block(binfile, probe_coords, first_step, nb_steps):
+  nb_probes = len(probe_coords) / 2
+  header = binfile.readline().split()
+  if len(header) != nb_probes + 2:
+    raise Exception('Bad header ' + str(header))
+  record_size = 8 * (nb_probes + 1)
+  for step in range(first_step, first_step + nb_steps):
+    record = struct.unpack('d' * (nb_probes + 1), binfile.read(record_size))
+    expected = linear(probe_coords[-2], probe_coords[-1], step)
+    if record[0] != step + 1 or abs(record[-1] - expected) > 1e-10:
+      raise Exception('Bad record ' + str(step) + ': ' + str(record[0]) + ', ' + str(record[-1]))
+
+coords_before = run_steps(0, 7)
+
+# Adding points relocates them, and starts a new block in the file.
+# The record of step 6 is still buffered and must be written with the old layout
+probes.add_line(start = [3., 0.25], end = [3.5, 0.75], nb_points = 5)
+coords_after = run_steps(7, 4)
+
+# Changing the file writes the remaining records to the old one
+probes.file = cf.URI('probeset-moved.bin')
+run_steps(11, 2)
+
+probes.flush()
+
+if cf.Core.rank() == 0:
+  binfile = open('probeset.bin', 'rb')
+  check_block(binfile, coords_before, 0, 7)
+  check_block(binfile, coords_after, 7, 4)
+  if len(binfile.read()) != 0:
+    raise Exception('Unexpected data at the end of probeset.bin')
+  binfile = open('probeset-moved.bin', 'rb')
+  check_block(binfile, coords_after, 11, 2)
+  if len(binfile.read()) != 0:
+    raise Exception('Unexpected data at the end of probeset-moved.bin')
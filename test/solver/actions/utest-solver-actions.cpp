@@ -19,8 +19,11 @@
 #include "common/Core.hpp"
 #include "common/Libraries.hpp"
 #include "common/Environment.hpp"
+#include "common/Foreach.hpp"
 #include "common/Group.hpp"
 #include "common/OptionList.hpp"
+#include "common/ThreadPool.hpp"
+#include "common/Timer.hpp"
 
 #include "mesh/Mesh.hpp"
 #include "mesh/MeshWriter.hpp"
@@ -50,6 +53,31 @@ using namespace cf3::mesh;
 using namespace cf3::solver;
 using namespace cf3::solver::actions;
 
+/// Counts the number of elements around each node, as an example of an operation that scatters to nodes
+class CountNodeElements : public LoopOperation
+{
+public:
+  CountNodeElements(const std::string& name) : LoopOperation(name) {}
+  static std::string type_name () { return "CountNodeElements"; }
+
+  virtual void execute() { execute_range(idx(), idx()+1); }
+
+  virtual void execute_range(const Uint begin, const Uint end)
+  {
+    const Connectivity& connectivity = elements().geometry_space().connectivity();
+    for(Uint elem = begin; elem != end; ++elem)
+    {
+      boost_foreach(const Uint node, connectivity[elem])
+        ++counts[node];
+    }
+  }
+
+  virtual bool thread_safe() const { return true; }
+  virtual bool scatters_to_nodes() const { return true; }
+
+  std::vector<Uint> counts;
+};
+
 /// @todo create a library for support of the utests
 /// @todo move this to a class that all utests global fixtures must inherit from
 struct CoreInit {
@@ -224,6 +252,51 @@ BOOST_AUTO_TEST_CASE ( test_CSetFieldValue )
 
 ////////////////////////////////////////////////////////////////////////////////
 
+BOOST_AUTO_TEST_CASE ( test_ThreadedLoop )
+{
+  Component& root = Core::instance().root();
+  Handle<Mesh> mesh(root.get_child("mesh2"));
+  Dictionary& cells_P0 = *Handle<Dictionary>(mesh->get_child("cells_P0"));
+  Field& serial_volumes = cells_P0.create_field("serial_volume");
+  Field& threaded_volumes = cells_P0.create_field("threaded_volume");
+
+  Handle<Loop> elem_loop = root.create_component< ForAllElements >("threaded_elem_loop");
+  elem_loop->options().set("regions",std::vector<URI>(1,mesh->topology().uri()));
+  elem_loop->options().set("chunk_size",16u);
+  LoopOperation& compute_volume = elem_loop->create_loop_operation("cf3.solver.actions.ComputeVolume");
+  Handle<CountNodeElements> count_elements = elem_loop->create_component<CountNodeElements>("CountNodeElements");
+  count_elements->counts.assign(mesh->geometry_fields().size(), 0);
+
+  ThreadPool& thread_pool = ThreadPool::instance();
+  thread_pool.set_nb_threads(1);
+  compute_volume.options().set("volume",serial_volumes.uri());
+  Timer timer;
+  elem_loop->execute();
+  const Real serial_time = timer.elapsed();
+  const std::vector<Uint> serial_counts = count_elements->counts;
+
+  thread_pool.set_nb_threads(4);
+  count_elements->counts.assign(mesh->geometry_fields().size(), 0);
+  compute_volume.options().set("volume",threaded_volumes.uri());
+  timer.restart();
+  elem_loop->execute();
+  const Real threaded_time = timer.elapsed();
+  thread_pool.set_nb_threads(1);
+
+  CFinfo << "element loop: serial " << serial_time << " s, 4 threads " << threaded_time << " s" << CFendl;
+
+  BOOST_CHECK(serial_volumes.array() == threaded_volumes.array());
+  BOOST_CHECK(serial_counts == count_elements->counts);
+  Uint total_count = 0;
+  boost_foreach(const Uint count, serial_counts)
+    total_count += count;
+  BOOST_CHECK(total_count > 0);
+
+  root.remove_component(*elem_loop);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 BOOST_AUTO_TEST_CASE ( test_ForAllElementsT )
 {
   Component& root = Core::instance().root();
@@ -0,0 +1,329 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Benchmark for the batched and threaded cf3::solver::TermComputer and cf3::solver::ComputeRHS"
+
+#include <boost/lexical_cast.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/Timer.hpp"
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/ElementType.hpp"
+#include "mesh/Entities.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/GeoShape.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/SimpleMeshGenerator.hpp"
+#include "mesh/Space.hpp"
+
+#include "solver/ComputeRHS.hpp"
+#include "solver/TermComputer.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Shared term definition: a node-weighted coordinate term with 2 equations
+struct QuadTerm
+{
+  void setup(const Handle<Entities const>& cells)
+  {
+    m_connectivity.reset();
+    m_coordinates.reset();
+    if(cells->element_type().shape() != GeoShape::QUAD || cells->element_type().nb_nodes() != 4)
+      return;
+    m_connectivity = cells->geometry_space().connectivity().handle<Connectivity>();
+    m_coordinates = cells->geometry_fields().coordinates().handle<Field>();
+  }
+
+  bool active() const { return is_not_null(m_connectivity); }
+
+  template<typename TermT, typename WaveSpeedT>
+  void compute(const Uint elem_idx, TermT& term, WaveSpeedT& wave_speed) const
+  {
+    const Connectivity::ConstRow nodes = (*m_connectivity)[elem_idx];
+    const Field& coords = *m_coordinates;
+    Real centroid_x = 0.;
+    Real centroid_y = 0.;
+    for(Uint s = 0; s != 4; ++s)
+    {
+      centroid_x += 0.25*coords[nodes[s]][XX];
+      centroid_y += 0.25*coords[nodes[s]][YY];
+    }
+    for(Uint s = 0; s != 4; ++s)
+    {
+      const Real dx = coords[nodes[s]][XX] - centroid_x;
+      const Real dy = coords[nodes[s]][YY] - centroid_y;
+      term(s, 0) = dx*dx + dy*dy;
+      term(s, 1) = dx*dy;
+      wave_speed[s] = std::abs(dx) + std::abs(dy);
+    }
+  }
+
+  Handle<Connectivity const> m_connectivity;
+  Handle<Field const> m_coordinates;
+};
+
+/// Term computer using the per-element virtual interface
+class LegacyTerm : public TermComputer
+{
+public:
+  LegacyTerm(const std::string& name) : TermComputer(name) {}
+  static std::string type_name() { return "LegacyTerm"; }
+
+  virtual bool loop_cells(const Handle<Entities const>& cells)
+  {
+    m_term.setup(cells);
+    return m_term.active();
+  }
+
+  virtual void compute_term(const Uint elem_idx, std::vector<RealVector>& term, std::vector<Real>& wave_speed)
+  {
+    term.resize(4, RealVector(2));
+    wave_speed.resize(4);
+    RealMatrix elem_term(4, 2);
+    m_term.compute(elem_idx, elem_term, wave_speed);
+    for(Uint s = 0; s != 4; ++s)
+      term[s] = elem_term.row(s).transpose();
+  }
+
+private:
+  QuadTerm m_term;
+};
+
+/// Term computer overriding the batched interface with a fixed-size, thread-safe kernel
+class FixedTerm : public TermComputer
+{
+public:
+  typedef Eigen::Matrix<Real, 4, 2, Eigen::RowMajor> TermMatrixT;
+  typedef Eigen::Matrix<Real, 4, 1> WaveSpeedVectorT;
+
+  FixedTerm(const std::string& name) : TermComputer(name) {}
+  static std::string type_name() { return "FixedTerm"; }
+
+  virtual bool loop_cells(const Handle<Entities const>& cells)
+  {
+    m_term.setup(cells);
+    return m_term.active();
+  }
+
+  virtual void compute_term(const Uint elem_idx, std::vector<RealVector>& term, std::vector<Real>& wave_speed)
+  {
+    TermMatrixT elem_term;
+    WaveSpeedVectorT elem_wave_speed;
+    m_term.compute(elem_idx, elem_term, elem_wave_speed);
+    term.resize(4);
+    wave_speed.resize(4);
+    for(Uint s = 0; s != 4; ++s)
+    {
+      term[s] = elem_term.row(s).transpose();
+      wave_speed[s] = elem_wave_speed[s];
+    }
+  }
+
+  virtual void compute_terms(const Uint* first, const Uint* last, TermBatch& batch)
+  {
+    Uint i = 0;
+    for(const Uint* elem = first; elem != last; ++elem, ++i)
+    {
+      Eigen::Map<TermMatrixT> term(batch.term(i));
+      Eigen::Map<WaveSpeedVectorT> wave_speed(batch.wave_speed(i));
+      m_term.compute(*elem, term, wave_speed);
+    }
+  }
+
+  virtual bool thread_safe() const { return true; }
+
+private:
+  QuadTerm m_term;
+};
+
+/// ComputeRHS that scales the rhs of each element, to check that the field loop uses the per-element override
+class ScaledComputeRHS : public ComputeRHS
+{
+public:
+  ScaledComputeRHS(const std::string& name) : ComputeRHS(name) {}
+  static std::string type_name() { return "ScaledComputeRHS"; }
+
+  virtual void compute_rhs(const Uint elem_idx, std::vector<RealVector>& rhs, std::vector<Real>& wave_speed)
+  {
+    ComputeRHS::compute_rhs(elem_idx, rhs, wave_speed);
+    for(Uint s = 0; s != rhs.size(); ++s)
+      rhs[s] *= 2.;
+  }
+
+  using ComputeRHS::compute_rhs;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct ComputeRHSFixture
+{
+  ComputeRHSFixture()
+  {
+    m_argc = boost::unit_test::framework::master_test_suite().argc;
+    m_argv = boost::unit_test::framework::master_test_suite().argv;
+  }
+
+  /// Run the action a few times and report the throughput in elements per second
+  Real time_action(Action& action, const std::string& label)
+  {
+    const Uint nb_runs = 5;
+    Timer timer;
+    for(Uint i = 0; i != nb_runs; ++i)
+      action.execute();
+    const Real elapsed = timer.elapsed();
+    const Real throughput = static_cast<Real>(nb_runs*nb_elems) / elapsed;
+    CFinfo << label << ": " << elapsed / static_cast<Real>(nb_runs) << " s per run, " << throughput << " elements/s" << CFendl;
+    return throughput;
+  }
+
+  Handle<Field> field(Dictionary& dict, const std::string& name)
+  {
+    return Handle<Field>(dict.get_child(name));
+  }
+
+  void check_equal(const Field& a, const Field& b)
+  {
+    BOOST_CHECK_EQUAL(a.size(), b.size());
+    for(Uint i = 0; i != a.size(); ++i)
+      for(Uint j = 0; j != a.row_size(); ++j)
+        BOOST_CHECK_SMALL(a[i][j] - b[i][j], 1e-12);
+  }
+
+  int m_argc;
+  char** m_argv;
+
+  static Uint nb_elems;
+  static Uint nb_threads;
+};
+
+Uint ComputeRHSFixture::nb_elems = 0;
+Uint ComputeRHSFixture::nb_threads = 4;
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( ComputeRHSSuite, ComputeRHSFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Initiate )
+{
+  Core::instance().initiate(m_argc,m_argv);
+  PE::Comm::instance().init(m_argc,m_argv);
+
+  const Uint nb_segments = m_argc > 1 ? boost::lexical_cast<Uint>(m_argv[1]) : 128u;
+  if(m_argc > 2)
+    nb_threads = boost::lexical_cast<Uint>(m_argv[2]);
+
+  Handle<MeshGenerator> mesh_generator = Core::instance().root().create_component<SimpleMeshGenerator>("generate_square");
+  mesh_generator->options().set("mesh",Core::instance().root().uri()/"mesh");
+  mesh_generator->options().set("lengths",std::vector<Real>(2,10.));
+  mesh_generator->options().set("nb_cells",std::vector<Uint>(2,nb_segments));
+  Mesh& mesh = mesh_generator->generate();
+  nb_elems = nb_segments*nb_segments;
+
+  Dictionary& geometry = mesh.geometry_fields();
+  geometry.create_field("legacy_term", "legacy_term[2]");
+  geometry.create_field("legacy_ws", "legacy_ws[1]");
+  geometry.create_field("fixed_term", "fixed_term[2]");
+  geometry.create_field("fixed_ws", "fixed_ws[1]");
+  geometry.create_field("threaded_term", "threaded_term[2]");
+  geometry.create_field("threaded_ws", "threaded_ws[1]");
+
+  Dictionary& elems_P1 = mesh.create_discontinuous_space("elems_P1","cf3.mesh.LagrangeP1");
+  elems_P1.create_field("serial_rhs", "serial_rhs[2]");
+  elems_P1.create_field("serial_ws", "serial_ws[1]");
+  elems_P1.create_field("scaled_rhs", "scaled_rhs[2]");
+  elems_P1.create_field("scaled_ws", "scaled_ws[1]");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( TermComputerThroughput )
+{
+  Component& root = Core::instance().root();
+  Dictionary& geometry = *root.access_component_checked("mesh/geometry")->handle<Dictionary>();
+
+  Handle<LegacyTerm> legacy = root.create_component<LegacyTerm>("legacy");
+  legacy->options().set("field", field(geometry, "legacy_term"));
+  legacy->options().set("term_wave_speed_field", field(geometry, "legacy_ws"));
+
+  Handle<FixedTerm> fixed = root.create_component<FixedTerm>("fixed");
+  fixed->options().set("field", field(geometry, "fixed_term"));
+  fixed->options().set("term_wave_speed_field", field(geometry, "fixed_ws"));
+
+  const Real legacy_throughput = time_action(*legacy, "TermComputer legacy");
+  const Real fixed_throughput = time_action(*fixed, "TermComputer fixed-size");
+  check_equal(*field(geometry, "legacy_term"), *field(geometry, "fixed_term"));
+  check_equal(*field(geometry, "legacy_ws"), *field(geometry, "fixed_ws"));
+
+  Core::instance().environment().options().set("nb_threads", nb_threads);
+  fixed->options().set("field", field(geometry, "threaded_term"));
+  fixed->options().set("term_wave_speed_field", field(geometry, "threaded_ws"));
+  const Real threaded_throughput = time_action(*fixed, "TermComputer fixed-size, " + boost::lexical_cast<std::string>(nb_threads) + " threads");
+  Core::instance().environment().options().set("nb_threads", 1u);
+
+  check_equal(*field(geometry, "legacy_term"), *field(geometry, "threaded_term"));
+  check_equal(*field(geometry, "legacy_ws"), *field(geometry, "threaded_ws"));
+
+  CFinfo << "TermComputer speedup: fixed-size " << fixed_throughput / legacy_throughput
+         << ", threaded " << threaded_throughput / legacy_throughput << CFendl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( ComputeRHSThroughput )
+{
+  Component& root = Core::instance().root();
+  Dictionary& elems_P1 = *root.access_component_checked("mesh/elems_P1")->handle<Dictionary>();
+
+  Handle<ComputeRHS> compute_rhs = root.create_component<ComputeRHS>("compute_rhs");
+  compute_rhs->create_component<FixedTerm>("term_1");
+  compute_rhs->create_component<LegacyTerm>("term_2");
+  compute_rhs->options().set("rhs", field(elems_P1, "serial_rhs"));
+  compute_rhs->options().set("wave_speed", field(elems_P1, "serial_ws"));
+  time_action(*compute_rhs, "ComputeRHS");
+
+  Handle<ScaledComputeRHS> scaled_rhs = root.create_component<ScaledComputeRHS>("scaled_rhs");
+  scaled_rhs->create_component<FixedTerm>("term_1");
+  scaled_rhs->create_component<LegacyTerm>("term_2");
+  scaled_rhs->options().set("rhs", field(elems_P1, "scaled_rhs"));
+  scaled_rhs->options().set("wave_speed", field(elems_P1, "scaled_ws"));
+  scaled_rhs->execute();
+
+  const Field& serial = *field(elems_P1, "serial_rhs");
+  const Field& scaled = *field(elems_P1, "scaled_rhs");
+  for(Uint i = 0; i != serial.size(); ++i)
+    for(Uint j = 0; j != serial.row_size(); ++j)
+      BOOST_CHECK_SMALL(scaled[i][j] - 2.*serial[i][j], 1e-12);
+  check_equal(*field(elems_P1, "serial_ws"), *field(elems_P1, "scaled_ws"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Terminate )
+{
+  PE::Comm::instance().finalize();
+  Core::instance().terminate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
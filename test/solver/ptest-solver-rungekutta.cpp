@@ -0,0 +1,236 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Convergence per wall-clock time of cf3::solver::LowStorageRungeKutta"
+
+#include <boost/lexical_cast.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/Log.hpp"
+#include "common/OptionList.hpp"
+#include "common/Timer.hpp"
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/ElementType.hpp"
+#include "mesh/Entities.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshReader.hpp"
+#include "mesh/Region.hpp"
+#include "mesh/Space.hpp"
+
+#include "solver/ComputeLNorm.hpp"
+#include "solver/ComputeRHS.hpp"
+#include "solver/LowStorageRungeKutta.hpp"
+#include "solver/PDE.hpp"
+#include "solver/TermComputer.hpp"
+#include "solver/Time.hpp"
+#include "solver/TimeStepComputer.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Scalar PDE in 2D, without any terms of its own
+class ScalarPDE : public PDE
+{
+public:
+  ScalarPDE(const std::string& name) : PDE(name)
+  {
+    m_nb_eqs = 1u;
+    m_nb_dim = 2u;
+    add_time();
+  }
+  static std::string type_name() { return "ScalarPDE"; }
+};
+
+/// Relaxation towards 1 with a rate that is much larger for x > 0: R = lambda(x) (1 - U)
+/// The rate plays the role of the wave speed, mimicking a mesh with a large cell size ratio
+class RelaxationTerm : public TermComputer
+{
+public:
+  RelaxationTerm(const std::string& name) : TermComputer(name)
+  {
+    options().add("solution",m_solution).link_to(&m_solution);
+  }
+  static std::string type_name() { return "RelaxationTerm"; }
+
+  virtual bool loop_cells(const Handle<Entities const>& cells)
+  {
+    if (cells->element_type().dimensionality() != DIM_2D)
+      return false;
+    m_connectivity = m_solution->space(*cells).connectivity().handle<Connectivity>();
+    return true;
+  }
+
+  virtual void compute_term(const Uint elem_idx, std::vector<RealVector>& term, std::vector<Real>& wave_speed)
+  {
+    const Connectivity::ConstRow nodes = (*m_connectivity)[elem_idx];
+    const Field& coords = m_solution->coordinates();
+    term.resize(nodes.size(), RealVector(1));
+    wave_speed.resize(nodes.size());
+    for (Uint s=0; s<nodes.size(); ++s)
+    {
+      const Real rate = coords[nodes[s]][XX] > 1e-8 ? stiffness : 1.;
+      term[s][0] = rate * ( 1. - (*m_solution)[nodes[s]][0] );
+      wave_speed[s] = rate;
+    }
+  }
+
+  static Real stiffness;
+
+private:
+  Handle<Field> m_solution;
+  Handle<Connectivity const> m_connectivity;
+};
+
+Real RelaxationTerm::stiffness = 100.;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct RungeKuttaFixture
+{
+  RungeKuttaFixture()
+  {
+    m_argc = boost::unit_test::framework::master_test_suite().argc;
+    m_argv = boost::unit_test::framework::master_test_suite().argv;
+  }
+
+  /// Create a solver for the pde, with given scheme and time stepping
+  Handle<LowStorageRungeKutta> create_solver(const std::string& name, const std::string& scheme, const bool time_accurate, const std::string& cfl)
+  {
+    Component& root = Core::instance().root();
+    Handle<ScalarPDE> pde(root.get_child("pde"));
+    Handle<LowStorageRungeKutta> solver = root.create_component<LowStorageRungeKutta>(name);
+    solver->options().set("pde",pde);
+    solver->options().set("scheme",scheme);
+    solver->options().set("print_iteration_summary",false);
+    solver->time_step_computer()->options().set("time_accurate",time_accurate);
+    solver->time_step_computer()->options().set("cfl",cfl);
+    return solver;
+  }
+
+  /// Iterate from the initial condition until the residual drops below the tolerance,
+  /// and report iterations and wall-clock time
+  Uint converge(LowStorageRungeKutta& solver, const std::string& label)
+  {
+    Component& root = Core::instance().root();
+    Handle<ScalarPDE> pde(root.get_child("pde"));
+    *pde->solution() = 0.;
+    pde->time()->current_time() = 0.;
+    pde->time()->iter() = 0;
+    pde->time()->options().set("end_time",1e10);
+
+    Timer timer;
+    solver.setup();
+    Real residual = 1.;
+    while (residual > tolerance && pde->time()->iter() < max_iterations)
+    {
+      solver.do_iteration();
+      residual = solver.norm_computer()->compute_norm(*pde->rhs())[0];
+    }
+    const Real elapsed = timer.elapsed();
+
+    CFinfo << label << ": " << pde->time()->iter() << " iterations, " << elapsed << " s, residual " << residual << CFendl;
+    BOOST_CHECK_LT(residual, tolerance);
+
+    const Field& solution = *pde->solution();
+    for (Uint n=0; n<solution.size(); ++n)
+      BOOST_CHECK_SMALL(solution[n][0] - 1., 1e-6);
+    return pde->time()->iter();
+  }
+
+  int m_argc;
+  char** m_argv;
+
+  static const Real tolerance;
+  static const Uint max_iterations;
+};
+
+const Real RungeKuttaFixture::tolerance = 1e-10;
+const Uint RungeKuttaFixture::max_iterations = 100000u;
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_FIXTURE_TEST_SUITE( RungeKuttaSuite, RungeKuttaFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Initiate )
+{
+  Core::instance().initiate(m_argc,m_argv);
+  PE::Comm::instance().init(m_argc,m_argv);
+
+  if (m_argc > 1)
+    RelaxationTerm::stiffness = boost::lexical_cast<Real>(m_argv[1]);
+
+  Component& root = Core::instance().root();
+  boost::shared_ptr< MeshReader > reader = build_component_abstract_type<MeshReader>("cf3.mesh.gmsh.Reader","reader");
+  Mesh& mesh = *root.create_component<Mesh>("mesh");
+  reader->read_mesh_into("../../resources/rectangle-mix-p1.msh",mesh);
+
+  Handle<ScalarPDE> pde = root.create_component<ScalarPDE>("pde");
+  pde->options().set("fields",mesh.geometry_fields().handle<Dictionary>());
+  pde->configure(pde->rhs_computer()->create_component<RelaxationTerm>("relaxation")->handle());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( GlobalVersusLocalTimeStepping )
+{
+  const Uint global_iterations = converge(*create_solver("global_euler","ForwardEuler",true,"0.9"), "ForwardEuler, global time step");
+  const Uint local_iterations = converge(*create_solver("local_euler","ForwardEuler",false,"0.9"), "ForwardEuler, local time step");
+  BOOST_CHECK_LT(local_iterations, global_iterations);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Schemes )
+{
+  converge(*create_solver("local_ssprk22","SSPRK22",false,"1."), "SSPRK22, local time step");
+  converge(*create_solver("local_ssprk33","SSPRK33",false,"1.2"), "SSPRK33, local time step");
+  converge(*create_solver("local_rk3","RK3Williamson",false,"1.2"), "RK3Williamson, local time step");
+  converge(*create_solver("local_rk4","RK4CarpenterKennedy",false,"2."), "RK4CarpenterKennedy, local time step");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( MultiRate )
+{
+  Component& root = Core::instance().root();
+
+  const Uint single_rate_iterations = converge(*create_solver("single_rate","SSPRK33",true,"0.9"), "SSPRK33, global time step");
+
+  const Uint nb_subcycles = std::max(1u, static_cast<Uint>(RelaxationTerm::stiffness));
+  Handle<LowStorageRungeKutta> solver = create_solver("multi_rate","SSPRK33",true,"0.9");
+  solver->options().set("subcycle_regions",std::vector< Handle<Component> >(1, root.access_component_checked("mesh/topology/right")));
+  solver->options().set("nb_subcycles",nb_subcycles);
+  const Uint multi_rate_iterations = converge(*solver, "SSPRK33, global time step, "+boost::lexical_cast<std::string>(nb_subcycles)+" subcycles in region right");
+
+  BOOST_CHECK_LT(multi_rate_iterations, single_rate_iterations);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Terminate )
+{
+  PE::Comm::instance().finalize();
+  Core::instance().terminate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////
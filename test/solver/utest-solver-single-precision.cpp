@@ -0,0 +1,256 @@
+// Copyright (C) 2010-2013 von Karman Institute for Fluid Dynamics, Belgium
+//
+// This software is distributed under the terms of the
+// GNU Lesser General Public License version 3 (LGPLv3).
+// See doc/lgpl.txt and doc/gpl.txt for the license text.
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE "Test module for solvers, writers and restart files on single precision fields"
+
+#include <boost/test/unit_test.hpp>
+
+#include "common/Core.hpp"
+#include "common/Environment.hpp"
+#include "common/OptionList.hpp"
+#include "common/PE/Comm.hpp"
+
+#include "mesh/Connectivity.hpp"
+#include "mesh/Dictionary.hpp"
+#include "mesh/ElementType.hpp"
+#include "mesh/Entities.hpp"
+#include "mesh/Field.hpp"
+#include "mesh/Mesh.hpp"
+#include "mesh/MeshReader.hpp"
+#include "mesh/MeshWriter.hpp"
+#include "mesh/Space.hpp"
+
+#include "solver/ComputeRHS.hpp"
+#include "solver/LowStorageRungeKutta.hpp"
+#include "solver/PDE.hpp"
+#include "solver/Tags.hpp"
+#include "solver/TermComputer.hpp"
+#include "solver/Time.hpp"
+#include "solver/TimeStepComputer.hpp"
+#include "solver/actions/ReadRestartFile.hpp"
+#include "solver/actions/WriteRestartFile.hpp"
+
+#include "Tools/MeshGeneration/MeshGeneration.hpp"
+
+using namespace cf3;
+using namespace cf3::common;
+using namespace cf3::mesh;
+using namespace cf3::solver;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/// Scalar PDE in 2D, without any terms of its own
+class ScalarPDE : public PDE
+{
+public:
+  ScalarPDE(const std::string& name) : PDE(name)
+  {
+    m_nb_eqs = 1u;
+    m_nb_dim = 2u;
+    add_time();
+  }
+  static std::string type_name() { return "ScalarPDE"; }
+};
+
+/// Relaxation towards x: R = x - U. The term reads the solution through the raw field accessors
+class RelaxationTerm : public TermComputer
+{
+public:
+  RelaxationTerm(const std::string& name) : TermComputer(name)
+  {
+    options().add("solution",m_solution).link_to(&m_solution);
+  }
+  static std::string type_name() { return "RelaxationTerm"; }
+
+  virtual bool loop_cells(const Handle<Entities const>& cells)
+  {
+    if (cells->element_type().dimensionality() != DIM_2D)
+      return false;
+    m_connectivity = m_solution->space(*cells).connectivity().handle<Connectivity>();
+    return true;
+  }
+
+  virtual void compute_term(const Uint elem_idx, std::vector<RealVector>& term, std::vector<Real>& wave_speed)
+  {
+    const Connectivity::ConstRow nodes = (*m_connectivity)[elem_idx];
+    const Field& coords = m_solution->coordinates();
+    term.resize(nodes.size(), RealVector(1));
+    wave_speed.resize(nodes.size());
+    for (Uint s=0; s<nodes.size(); ++s)
+    {
+      term[s][0] = coords[nodes[s]][XX] - (*m_solution)[nodes[s]][0];
+      wave_speed[s] = 1.;
+    }
+  }
+
+private:
+  Handle<Field> m_solution;
+  Handle<Connectivity const> m_connectivity;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct SinglePrecisionFixture
+{
+  SinglePrecisionFixture() :
+    m_argc(boost::unit_test::framework::master_test_suite().argc),
+    m_argv(boost::unit_test::framework::master_test_suite().argv)
+  {
+  }
+
+  /// Create a mesh with a relaxation PDE and a forward Euler solver for it
+  Handle<LowStorageRungeKutta> create_problem(const std::string& prefix)
+  {
+    Component& root = Core::instance().root();
+    Mesh& mesh = *root.create_component<Mesh>(prefix+"_mesh");
+    Tools::MeshGeneration::create_rectangle(mesh, 2., 1., 20, 10);
+
+    Handle<ScalarPDE> pde = root.create_component<ScalarPDE>(prefix+"_pde");
+    pde->options().set("fields",mesh.geometry_fields().handle<Dictionary>());
+    pde->configure(pde->rhs_computer()->create_component<RelaxationTerm>("relaxation")->handle());
+    pde->time()->options().set("end_time",1e10);
+
+    Handle<LowStorageRungeKutta> solver = root.create_component<LowStorageRungeKutta>(prefix+"_solver");
+    solver->options().set("pde",pde->handle<PDE>());
+    solver->options().set("scheme",std::string("ForwardEuler"));
+    solver->options().set("print_iteration_summary",false);
+    solver->time_step_computer()->options().set("time_accurate",true);
+    solver->time_step_computer()->options().set("cfl",std::string("0.5"));
+    return solver;
+  }
+
+  Field& solution(const std::string& prefix)
+  {
+    return *Handle<ScalarPDE>(Core::instance().root().get_child(prefix+"_pde"))->solution();
+  }
+
+  int m_argc;
+  char** m_argv;
+};
+
+BOOST_FIXTURE_TEST_SUITE( SinglePrecisionSuite, SinglePrecisionFixture )
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Initiate )
+{
+  Core::instance().initiate(m_argc,m_argv);
+  PE::Comm::instance().init(m_argc,m_argv);
+
+  create_problem("double");
+  create_problem("single");
+
+  Field& single_solution = solution("single");
+  single_solution.options().set("single_precision",true);
+  BOOST_CHECK(single_solution.single_precision());
+  BOOST_CHECK_EQUAL(single_solution.nb_rows(), single_solution.dict().size());
+  BOOST_CHECK_EQUAL(single_solution.single_array().size(), single_solution.dict().size());
+
+  // The double precision array is released, the plain Table interface only keeps the row size
+  const Table<Real>& table = single_solution;
+  BOOST_CHECK_EQUAL(table.size(), 0u);
+  BOOST_CHECK_EQUAL(table.array().size(), 0u);
+  BOOST_CHECK_EQUAL(table.row_size(), 1u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( SolverStep )
+{
+  Component& root = Core::instance().root();
+  Handle<LowStorageRungeKutta> double_solver(root.get_child("double_solver"));
+  Handle<LowStorageRungeKutta> single_solver(root.get_child("single_solver"));
+  Field& single_solution = solution("single");
+
+  // The solver works on the Table<Real> interface, so iterate in double precision and store the result in single precision afterwards
+  single_solution.options().set("single_precision",false);
+  double_solver->setup();
+  single_solver->setup();
+  for(Uint i = 0; i != 10; ++i)
+  {
+    double_solver->do_iteration();
+    single_solver->do_iteration();
+  }
+  single_solution.options().set("single_precision",true);
+
+  const Field& double_solution = solution("double");
+  BOOST_CHECK(!single_solution.dict().coordinates().single_precision());
+  Real max_value = 0.;
+  for(Uint i = 0; i != double_solution.size(); ++i)
+  {
+    BOOST_CHECK_SMALL(single_solution.value(i, 0) - double_solution[i][0], 1e-6);
+    max_value = std::max(max_value, double_solution[i][0]);
+  }
+  BOOST_CHECK_GT(max_value, 0.5);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Writer )
+{
+  Component& root = Core::instance().root();
+  Mesh& mesh = *Handle<Mesh>(root.get_child("single_mesh"));
+  const Field& single_solution = solution("single");
+  const URI file("utest-solver-single-precision.cf3mesh");
+
+  boost::shared_ptr<MeshWriter> writer = build_component_abstract_type<MeshWriter>("cf3.mesh.cf3mesh.Writer", "writer");
+  writer->write_from_to(mesh, file);
+  BOOST_CHECK(single_solution.single_precision());
+
+  // The file holds the rounded values
+  Mesh& read_mesh = *root.create_component<Mesh>("read_mesh");
+  boost::shared_ptr<MeshReader> reader = build_component_abstract_type<MeshReader>("cf3.mesh.cf3mesh.Reader", "reader");
+  reader->read_mesh_into(file, read_mesh);
+  const Field& read_solution = *Handle<Field>(read_mesh.geometry_fields().get_child("solution"));
+  BOOST_REQUIRE_EQUAL(read_solution.size(), single_solution.nb_rows());
+  for(Uint i = 0; i != read_solution.size(); ++i)
+    BOOST_CHECK_EQUAL(read_solution[i][0], single_solution.value(i, 0));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Restart )
+{
+  Component& root = Core::instance().root();
+  Handle<ScalarPDE> pde(root.get_child("single_pde"));
+  Field& single_solution = solution("single");
+  const URI file("utest-solver-single-precision.cf3restart");
+
+  Handle<actions::WriteRestartFile> restart_writer = root.create_component<actions::WriteRestartFile>("restart_writer");
+  restart_writer->options().set("fields", std::vector< Handle<Field> >(1, single_solution.handle<Field>()));
+  restart_writer->options().set("file", file);
+  restart_writer->options().set(solver::Tags::time(), pde->time());
+  restart_writer->execute();
+  BOOST_CHECK(single_solution.single_precision());
+
+  const Field::SingleArrayT written_values = single_solution.single_array();
+  for(Uint i = 0; i != single_solution.nb_rows(); ++i)
+    single_solution.set_value(i, 0, -1.);
+
+  Handle<actions::ReadRestartFile> restart_reader = root.create_component<actions::ReadRestartFile>("restart_reader");
+  restart_reader->options().set("mesh", root.get_child("single_mesh")->handle<Mesh>());
+  restart_reader->options().set("file", file);
+  restart_reader->options().set(solver::Tags::time(), pde->time());
+  restart_reader->execute();
+
+  BOOST_CHECK(single_solution.single_precision());
+  BOOST_CHECK(single_solution.single_array() == written_values);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE( Terminate )
+{
+  PE::Comm::instance().finalize();
+  Core::instance().terminate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_SUITE_END()
+
+////////////////////////////////////////////////////////////////////////////////